@@ -0,0 +1,390 @@
+/*
+Cheat Sheet: Bitsets and Compressed Bitmaps in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+A bitset stores a set of small integers as one bit per possible member. The flag
+examples in Chapter2OperatorsAndExpressions/BitwiseOperators.c (bitmask_usage,
+bitfield_operations) are bitsets that fit in one unsigned int; this chapter grows
+the same idea to millions of members.
+
+Key points:
+- Membership, insertion and removal are a shift and a mask on one word.
+- Set algebra is word-wide: one AND instruction intersects 64 members (512 with AVX-512).
+- A dense bitset costs universe/8 bytes regardless of how many members it holds,
+  so sparse sets over a large universe waste memory. Compressed formats such as
+  Roaring switch representation per 64K-value chunk to fix that.
+
+Historical context:
+- Bit vectors appear in the earliest compilers for data-flow analysis (live
+  variables, reaching definitions).
+- Bitmap indexes were popularised by Model 204 in the 1980s and are standard in
+  column stores today.
+- Roaring bitmaps (Chambi, Lemire, Kaser, Godin, 2014) combine sorted arrays and
+  bitmaps and are used by Lucene, Druid, Spark and ClickHouse.
+
+The implementation lives in bitset.h next to this file; bulk counting uses the
+SIMD kernels in Chapter2OperatorsAndExpressions/popcount_simd.h.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "bitset.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// Function prototypes
+void basic_bitset_usage();
+void rank_select_example();
+void set_algebra_example();
+void roaring_example();
+void performance_comparison();
+
+int main() {
+    printf("Bitsets and Compressed Bitmaps Cheat Sheet\n");
+    printf("==========================================\n\n");
+
+    basic_bitset_usage();
+    rank_select_example();
+    set_algebra_example();
+    roaring_example();
+    performance_comparison();
+
+    return 0;
+}
+
+void basic_bitset_usage() {
+    printf("2.1 Basic Bitset Usage\n");
+    printf("-----------------------\n");
+
+    Bitset flags;
+    if (bitset_init(&flags, 200) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+
+    // The same operations as FLAG_A/FLAG_B/FLAG_C in bitmask_usage(), past 32 bits
+    bitset_set(&flags, 0);
+    bitset_set(&flags, 2);
+    bitset_set(&flags, 100);
+    bitset_set(&flags, 199);
+    printf("Is bit 1 set? %s\n", bitset_test(&flags, 1) ? "Yes" : "No");
+    printf("Is bit 100 set? %s\n", bitset_test(&flags, 100) ? "Yes" : "No");
+    bitset_clear(&flags, 2);
+
+    // bitset_add() grows the set on demand
+    if (bitset_add(&flags, 5000) != 0) fprintf(stderr, "Memory allocation failed\n");
+    printf("Bits: %zu, set: %zu\n", flags.nbits, bitset_count(&flags));
+
+    size_t i;
+    printf("Set bits:");
+    BITSET_FOREACH(&flags, i) {
+        printf(" %zu", i);
+    }
+    printf("\n\n");
+    bitset_destroy(&flags);
+}
+
+void rank_select_example() {
+    printf("2.2 Rank and Select\n");
+    printf("--------------------\n");
+
+    // Rank turns a sparse position into a dense slot number, e.g. to index a
+    // packed array that only stores values for present keys.
+    Bitset present;
+    if (bitset_init(&present, 1024) != 0) return;
+    for (size_t i = 0; i < 1024; i += 7) bitset_set(&present, i);
+
+    printf("Slots before key 700: %zu\n", bitset_rank(&present, 700));
+    printf("Key stored in slot 100: %zu\n", bitset_select(&present, 100));
+    printf("First key at or after 500: %zu\n", bitset_next_set(&present, 500));
+    printf("rank(select(42)) = %zu\n\n", bitset_rank(&present, bitset_select(&present, 42)));
+    bitset_destroy(&present);
+}
+
+void set_algebra_example() {
+    printf("2.3 In-Place Set Algebra\n");
+    printf("-------------------------\n");
+
+    Bitset even, multiples_of_3;
+    if (bitset_init(&even, 100) != 0) return;
+    if (bitset_init(&multiples_of_3, 100) != 0) {
+        bitset_destroy(&even);
+        return;
+    }
+    for (size_t i = 0; i < 100; i += 2) bitset_set(&even, i);
+    for (size_t i = 0; i < 100; i += 3) bitset_set(&multiples_of_3, i);
+
+    printf("|even AND mult3| without a temporary: %zu\n", bitset_and_count(&even, &multiples_of_3));
+
+    bitset_and(&even, &multiples_of_3);  // even now holds the multiples of 6
+    uint32_t out[8];
+    size_t n = bitset_to_indices(&even, 0, out, 8);
+    printf("First multiples of 6:");
+    for (size_t i = 0; i < n; i++) printf(" %u", out[i]);
+    printf("\n");
+
+    bitset_not(&even);
+    printf("Complement within 100 bits: %zu members\n\n", bitset_count(&even));
+    bitset_destroy(&even);
+    bitset_destroy(&multiples_of_3);
+}
+
+void roaring_example() {
+    printf("2.4 Roaring-Style Compressed Bitmaps\n");
+    printf("-------------------------------------\n");
+
+    RoaringBitmap sparse, dense;
+    roaring_init(&sparse);
+    roaring_init(&dense);
+
+    // 1000 user ids spread over the whole 32-bit range: one array container each
+    for (uint32_t i = 0; i < 1000; i++) roaring_add(&sparse, i * 4294967u);
+    // 20000 consecutive ids: one chunk that switches to a bitmap container
+    for (uint32_t i = 0; i < 20000; i++) roaring_add(&dense, 1000000u + i);
+
+    printf("Sparse: %zu values in %zu containers, %zu bytes (dense bitset: 512 MB)\n",
+           roaring_cardinality(&sparse), sparse.count, roaring_memory_bytes(&sparse));
+    printf("Dense: %zu values, container type %s, %zu bytes\n", roaring_cardinality(&dense),
+           dense.count && dense.containers[0].type == ROARING_BITMAP ? "bitmap" : "array",
+           roaring_memory_bytes(&dense));
+
+    printf("Contains 4294967? %s\n", roaring_contains(&sparse, 4294967u) ? "Yes" : "No");
+    if (roaring_or(&sparse, &dense) != 0) fprintf(stderr, "Memory allocation failed\n");
+    printf("After OR: %zu values\n", roaring_cardinality(&sparse));
+
+    RoaringIter it;
+    uint32_t v;
+    int shown = 0;
+    roaring_iter_init(&it, &sparse);
+    printf("First values:");
+    while (shown < 5 && roaring_iter_next(&it, &v)) {
+        printf(" %u", v);
+        shown++;
+    }
+    printf("\n\n");
+
+    roaring_destroy(&sparse);
+    roaring_destroy(&dense);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Size a dense bitset for the real universe up front; bitset_add() is for the
+   occasional outlier, not for building a set one growth step at a time.
+2. Combine filters in place (bitset_and/or/andnot) instead of allocating a result
+   per operation.
+3. Use bitset_and_count() when only the size of an intersection is needed.
+4. Prefer Roaring when the set holds well under 1/16 of its universe.
+
+Common Pitfalls:
+1. bitset_set()/clear()/flip() do not check bounds; use bitset_add() or resize first.
+2. 'break' inside BITSET_FOREACH only leaves the current word.
+3. Modifying a bitset while iterating over it.
+4. Shifting 1 instead of 1ULL: 1 << 40 is undefined behaviour on 32-bit int.
+
+Advanced Tips:
+1. Batch-decode with bitset_to_indices() so the consumer loop is a plain array walk.
+2. A rank directory (cumulative counts per 512 bits) makes rank O(1) for static sets.
+3. Convert a Roaring bitmap to a dense Bitset once when one filter will be evaluated
+   against it many times.
+
+4. Integration and Real-World Applications
+==========================================
+- Bitmap indexes: one set of row ids per distinct column value; AND/OR answer
+  WHERE clauses without touching the rows.
+- Search engines: posting lists stored as Roaring bitmaps.
+- Schedulers and allocators: free-block maps searched with find-first-set.
+- Bloom filters and graph algorithms (visited sets in BFS).
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Run containers (Roaring's third type) store long runs as (start, length) pairs.
+- AVX-512 VPOPCNTDQ and VPCOMPRESS decode and count 512 bits per instruction.
+- Succinct data structures (rank/select dictionaries, wavelet trees) build on the
+  rank and select primitives shown above.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why do count and rank get faster on newer CPUs without recompiling?
+A: They call the bulk kernels in popcount_simd.h, which pick the widest supported
+   instruction set at startup.
+
+Q: Why does my Roaring bitmap use 8 KB for a few thousand values?
+A: A chunk switches to a bitmap container above 4096 values; at that point the
+   bitmap is the smaller representation.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- CRoaring (https://github.com/RoaringBitmap/CRoaring)
+- "Better bitmap performance with Roaring bitmaps" (Chambi et al., 2016)
+- "Faster Population Counts Using AVX2 Instructions" (Mula, Kurz, Lemire, 2018)
+- Hacker's Delight (Warren), chapters 2 and 5
+
+8. Performance Analysis and Optimization
+========================================
+The benchmarks below evaluate a filter "a AND b" over 8M rows and then visit the
+matching rows, the way a bitmap index answers a query. A bool per row is the
+baseline; the bitset does the AND 64 rows at a time and visits matches with ctz.
+A second comparison shows the memory used per stored flag for a sparse set.
+*/
+
+#define FILTER_ROWS (8 * 1024 * 1024)
+
+typedef struct {
+    const bool* a_bool;
+    const bool* b_bool;
+    bool* result_bool;
+    const Bitset* a;
+    const Bitset* b;
+    Bitset* result;
+    uint32_t* indices;
+} FilterBench;
+
+void filter_bool_run(void* ctx) {
+    FilterBench* f = (FilterBench*)ctx;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < FILTER_ROWS; i++) f->result_bool[i] = f->a_bool[i] && f->b_bool[i];
+    for (size_t i = 0; i < FILTER_ROWS; i++) {
+        if (f->result_bool[i]) sum += i;
+    }
+    BENCH_DO_NOT_OPTIMIZE(sum);
+}
+
+void filter_bitset_foreach_run(void* ctx) {
+    FilterBench* f = (FilterBench*)ctx;
+    uint64_t sum = 0;
+    size_t i;
+    memcpy(f->result->words, f->a->words, f->a->nwords * sizeof(uint64_t));
+    bitset_and(f->result, f->b);
+    BITSET_FOREACH(f->result, i) {
+        sum += i;
+    }
+    BENCH_DO_NOT_OPTIMIZE(sum);
+}
+
+void filter_bitset_batch_run(void* ctx) {
+    FilterBench* f = (FilterBench*)ctx;
+    uint64_t sum = 0;
+    size_t from = 0, n;
+    memcpy(f->result->words, f->a->words, f->a->nwords * sizeof(uint64_t));
+    bitset_and(f->result, f->b);
+    while ((n = bitset_to_indices(f->result, from, f->indices, 4096)) > 0) {
+        for (size_t k = 0; k < n; k++) sum += f->indices[k];
+        from = (size_t)f->indices[n - 1] + 1;
+    }
+    BENCH_DO_NOT_OPTIMIZE(sum);
+}
+
+void memory_per_flag_comparison() {
+    // 1M ids drawn from a 64M-id space (~1.5% density), typical of one value's
+    // posting list in a bitmap index
+    RoaringBitmap r;
+    roaring_init(&r);
+    uint32_t x = 2463534242u;
+    for (int i = 0; i < 1000000; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        roaring_add(&r, x & ((1u << 26) - 1));
+    }
+    size_t members = roaring_cardinality(&r);
+    size_t roaring_bytes = roaring_memory_bytes(&r);
+    double dense_bytes = (double)(1u << 26) / 8;
+    printf("Set of %zu ids from a 2^26 id space:\n", members);
+    printf("  uint32_t array   %10zu bytes  %5.2f bytes/member\n", members * 4, 4.0);
+    printf("  dense bitset     %10.0f bytes  %5.2f bytes/member\n", dense_bytes, dense_bytes / (double)members);
+    printf("  roaring          %10zu bytes  %5.2f bytes/member\n\n", roaring_bytes,
+           (double)roaring_bytes / (double)members);
+    roaring_destroy(&r);
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    bool* a_bool = (bool*)malloc(FILTER_ROWS);
+    bool* b_bool = (bool*)malloc(FILTER_ROWS);
+    bool* result_bool = (bool*)malloc(FILTER_ROWS);
+    uint32_t* indices = (uint32_t*)malloc(4096 * sizeof(uint32_t));
+    Bitset a = {0}, b = {0}, result = {0};
+    int ok = a_bool && b_bool && result_bool && indices;
+    ok = ok && bitset_init(&a, FILTER_ROWS) == 0;
+    ok = ok && bitset_init(&b, FILTER_ROWS) == 0;
+    ok = ok && bitset_init(&result, FILTER_ROWS) == 0;
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed\n");
+        goto cleanup;
+    }
+
+    // a matches ~50% of rows, b ~6%: a selective query
+    uint32_t x = 88675123u;
+    for (size_t i = 0; i < FILTER_ROWS; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        a_bool[i] = x & 1;
+        b_bool[i] = ((x >> 8) & 15) == 0;
+        if (a_bool[i]) bitset_set(&a, i);
+        if (b_bool[i]) bitset_set(&b, i);
+    }
+
+    FilterBench f = {a_bool, b_bool, result_bool, &a, &b, &result, indices};
+    BenchSuite suite;
+    bench_suite_init(&suite, "Filter a AND b over 8M rows, then visit matches");
+    bench_suite_run(&suite, "bool per row", filter_bool_run, &f, FILTER_ROWS);
+    bench_suite_run(&suite, "bitset + ctz iteration", filter_bitset_foreach_run, &f, FILTER_ROWS);
+    bench_suite_run(&suite, "bitset + batch decode", filter_bitset_batch_run, &f, FILTER_ROWS);
+    bench_suite_report(&suite);
+    printf("Matches: %zu of %d rows; filter memory %d MB as bool vs %zu MB as bitset\n\n",
+           bitset_and_count(&a, &b), FILTER_ROWS, FILTER_ROWS / (1024 * 1024),
+           a.nwords * sizeof(uint64_t) / (1024 * 1024));
+
+    memory_per_flag_comparison();
+
+cleanup:
+    free(a_bool);
+    free(b_bool);
+    free(result_bool);
+    free(indices);
+    bitset_destroy(&a);
+    bitset_destroy(&b);
+    bitset_destroy(&result);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o bitsets Bitsets.c -O2
+
+Then execute the resulting binary:
+    ./bitsets
+*/
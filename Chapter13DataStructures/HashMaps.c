@@ -0,0 +1,517 @@
+/*
+Cheat Sheet: Open-Addressing Hash Maps in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+Chapter8StructuresAndUnions defines records such as struct Person, and
+Chapter5ArraysAndStrings looks its config_items up by scanning the array. A hash
+map finds a record by key in expected O(1) time. The textbook version chains
+colliding keys in a malloc'd linked list per bucket. Each lookup then follows
+one or more pointers to nodes scattered across the heap, and each node costs an
+allocation.
+
+Open addressing stores the elements in one array and resolves collisions by
+probing other slots of the same array. The Swiss-table layout used here adds a
+byte of metadata per slot. A probe scans 16 of those bytes with one SIMD
+compare, so it rarely touches a key that does not match.
+
+Key points:
+- Chained tables: simple, stable element addresses, a pointer chase per lookup.
+- Open addressing: one allocation, a sequential probe, and no per-element
+  overhead. Element addresses change when the table grows.
+- Metadata probing (one control byte per slot) keeps probes short even at 7/8
+  load.
+
+Historical context:
+- Open addressing with linear probing was described by Peterson (1957) and
+  analysed by Knuth (1963).
+- Robin Hood hashing (Celis, 1986) bounds probe-length variance by displacing
+  "richer" elements.
+- Google's SwissTable (Abseil, 2017) and Meta's F14 brought SIMD group probing
+  to production. Rust's standard HashMap (hashbrown) uses the same design.
+
+The implementation lives in hashmap.h next to this file. Like generic.h, it is
+instantiated per key and value type with a macro.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hashmap.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// The record from Chapter8StructuresAndUnions/StructuresUsingAndDefining.c, keyed by id
+typedef struct {
+    char name[24];
+    int age;
+    float height;
+    uint64_t id;
+} Person;
+
+typedef const char* cstring;
+
+static inline uint64_t id_hash(uint64_t id) {
+    return hashmap_hash_u64(id);
+}
+
+DEFINE_HASHMAP(person_map, uint64_t, Person, id_hash, HASHMAP_EQ)
+DEFINE_HASHMAP(age_map, cstring, int, hashmap_hash_str, HASHMAP_STR_EQ)
+
+// Function prototypes
+void record_map_example();
+void string_key_example();
+void bulk_insert_example();
+void tombstone_example();
+void performance_comparison();
+
+int main() {
+    printf("Open-Addressing Hash Maps Cheat Sheet\n");
+    printf("=====================================\n\n");
+
+    record_map_example();
+    string_key_example();
+    bulk_insert_example();
+    tombstone_example();
+    performance_comparison();
+
+    return 0;
+}
+
+static Person make_person(uint64_t id, const char* name, int age, float height) {
+    Person p;
+    memset(&p, 0, sizeof(p));
+    strncpy(p.name, name, sizeof(p.name) - 1);
+    p.age = age;
+    p.height = height;
+    p.id = id;
+    return p;
+}
+
+void record_map_example() {
+    printf("2.1 Key -> Record Lookup\n");
+    printf("------------------------\n");
+
+    HashMap_person_map people;
+    person_map_init(&people);
+    if (person_map_insert(&people, 1001, make_person(1001, "John Doe", 30, 1.75f)) < 0 ||
+        person_map_insert(&people, 1002, make_person(1002, "Alice", 25, 1.68f)) < 0 ||
+        person_map_insert(&people, 1003, make_person(1003, "Bob", 41, 1.82f)) < 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        person_map_destroy(&people);
+        return;
+    }
+
+    Person* alice = person_map_find(&people, 1002);
+    if (alice != NULL) {
+        alice->age++;  // The pointer refers to the stored record: update in place
+        printf("Found %llu: %s, age %d, height %.2f\n", (unsigned long long)alice->id, alice->name,
+               alice->age, alice->height);
+    }
+    printf("Replacing 1003 returns %d (0 = replaced, 1 = added)\n",
+           person_map_insert(&people, 1003, make_person(1003, "Robert", 41, 1.82f)));
+    int erased = person_map_erase(&people, 1001);
+    printf("Erasing 1001 returns %d; 1001 present afterwards: %d\n", erased, person_map_contains(&people, 1001));
+    printf("Size %zu, capacity %zu\n\n", people.size, people.capacity);
+
+    person_map_destroy(&people);
+}
+
+void string_key_example() {
+    printf("2.2 String Keys\n");
+    printf("---------------\n");
+
+    // The map stores the pointers, not the characters: the strings must outlive it
+    static const char* const names[] = {"alice", "bob", "carol", "dave", "erin"};
+    static const int ages[] = {25, 41, 33, 29, 52};
+    HashMap_age_map map;
+    age_map_init(&map);
+    for (int i = 0; i < 5; i++) {
+        if (age_map_insert(&map, names[i], ages[i]) < 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            age_map_destroy(&map);
+            return;
+        }
+    }
+    char query[16];
+    strcpy(query, "carol");  // A different pointer with the same contents
+    int* age = age_map_find(&map, query);
+    printf("carol -> %d, mallory present: %d\n\n", age ? *age : -1, age_map_contains(&map, "mallory"));
+    age_map_destroy(&map);
+}
+
+void bulk_insert_example() {
+    printf("2.3 Bulk Insert and Iteration\n");
+    printf("-----------------------------\n");
+
+    enum { N = 1000 };
+    uint64_t ids[N];
+    Person* records = (Person*)malloc(N * sizeof(Person));
+    if (records == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    for (int i = 0; i < N; i++) {
+        ids[i] = 5000 + (uint64_t)i * 3;
+        records[i] = make_person(ids[i], "user", 20 + i % 50, 1.5f + (float)(i % 50) / 100.0f);
+    }
+
+    HashMap_person_map people;
+    person_map_init(&people);
+    if (person_map_insert_bulk(&people, ids, records, N) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(records);
+        return;
+    }
+    long total_age = 0;
+    size_t visited = 0;
+    for (size_t i = person_map_next(&people, 0); i < people.capacity; i = person_map_next(&people, i + 1)) {
+        total_age += people.values[i].age;
+        visited++;
+    }
+    printf("Inserted %zu records in one resize (capacity %zu, load %.2f)\n", people.size, people.capacity,
+           (double)people.size / (double)people.capacity);
+    printf("Visited %zu, mean age %.1f\n\n", visited, (double)total_age / (double)visited);
+
+    person_map_destroy(&people);
+    free(records);
+}
+
+void tombstone_example() {
+    printf("2.4 Tombstones and Rehash in Place\n");
+    printf("----------------------------------\n");
+
+    HashMap_person_map people;
+    person_map_init(&people);
+    if (person_map_reserve(&people, 10000) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    Person p = make_person(0, "temp", 30, 1.7f);
+    size_t capacity = people.capacity;
+    // A sliding window of live keys: every insert is matched by an erase
+    for (uint64_t id = 0; id < 200000; id++) {
+        person_map_insert(&people, id, p);
+        if (id >= 1000) person_map_erase(&people, id - 1000);
+    }
+    printf("After 200000 inserts and 199000 erases: size %zu, capacity %zu (was %zu)\n", people.size,
+           people.capacity, capacity);
+    printf("Erased slots were reclaimed, by marking them EMPTY or by rehashing in place, without growing\n");
+    person_map_rehash(&people);
+    printf("After an explicit rehash: %zu slots may be filled before the next one\n\n", people.growth_left);
+
+    person_map_destroy(&people);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Reserve (or bulk insert) when the element count is known. One resize is much
+   cheaper than the dozen a growing table goes through.
+2. Use a real mixing hash (hashmap_hash_u64, hashmap_hash_bytes). The table uses
+   the low 7 bits and the high bits separately.
+3. Keep values compact, or store an index into a record array, when the map is
+   rebuilt often. Every resize copies the values.
+4. Look a key up with find() and update through the returned pointer rather
+   than calling insert() to overwrite.
+
+Common Pitfalls:
+1. Holding a pointer from find() across an insert: the table may have moved.
+2. String keys are stored as pointers. The characters must stay alive and
+   unchanged for as long as the key is in the map.
+3. Identity hashes (return x;) on sequential ids put every key in the same
+   control-byte bucket and make probes long.
+4. Erasing while iterating with name_next() is fine. Inserting while iterating
+   is not: it may rehash.
+
+Advanced Tips:
+1. In the load-factor sweep below, hits stay flat up to 7/8 full while chained
+   hits slow down with every extra node. Misses get expensive near 7/8, because
+   few groups still hold an EMPTY slot to stop the probe. If most lookups miss,
+   reserve for about 3/4 load.
+2. For read-mostly maps, prefetch the control group of the next key while
+   processing the current one, as insert_bulk() does.
+3. A table plus a separate dense record array (index as the value) gives both
+   fast lookup and stable, iterable storage.
+
+4. Integration and Real-World Applications
+==========================================
+- Symbol tables in compilers and interpreters (identifier -> declaration).
+- Caches keyed by id: sessions, connections, routing entries, config keys.
+- Database hash joins and aggregation (GROUP BY) build a table on one input
+  and probe it with the other.
+- Deduplication and set operations on large id streams.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Robin Hood hashing with backward-shift deletion avoids tombstones entirely.
+- F14 (Meta) uses 14-slot chunks with overflow counts, and Boost's
+  unordered_flat_map (2022) uses 15-slot groups with overflow bits. Both cut
+  probe lengths further.
+- Concurrent variants use per-group locks (or none, for read-mostly tables).
+- Perfect hashing (Chapter3Control Structures/dispatch.h) is the static
+  alternative when the key set is known up front.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why does the map not shrink after erasing most elements?
+A: Capacity is only ever increased. Copy the live elements into a new map
+   reserved for the smaller size to give the memory back.
+
+Q: Why do lookups slow down after many erases?
+A: Tombstones (DELETED slots) make probes continue. The table reclaims them on
+   its own when they fill the table, and name_rehash() does it immediately.
+
+Q: Can I use a struct as the key?
+A: Yes. Write an EQ that compares the fields and a HASH over those fields.
+   Hashing the raw bytes with hashmap_hash_bytes() is only correct if the
+   struct has no padding.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- Abseil's SwissTable design notes (abseil.io/about/design/swisstables)
+- "Designing a Fast, Efficient, Cache-friendly Hash Table, Step by Step"
+  (Matt Kulukundis, CppCon 2017)
+- klib khash.h and the Verstable/STC containers for C
+- Knuth, TAOCP Volume 3, section 6.4
+
+8. Performance Analysis and Optimization
+========================================
+The benchmarks compare a chained table, with one malloc'd node per element, to
+hashmap.h. Both hold the Person records above under 64-bit ids:
+- A load-factor sweep with 2^17 buckets or slots for both tables, filled to
+  1/4, 1/2, 3/4 and 7/8. It times 1M random lookups that hit and 1M that miss.
+- Inserting 100K records into an empty table: chained, hashmap_insert one at a
+  time (the table grows as it goes), and hashmap_insert_bulk.
+*/
+
+#define MAP_SLOTS (1u << 17)
+#define MAP_LOOKUPS (1u << 20)
+#define MAP_INSERTS 100000
+
+typedef struct ChainNode {
+    uint64_t key;
+    Person value;
+    struct ChainNode* next;
+} ChainNode;
+
+typedef struct {
+    ChainNode** buckets;
+    size_t mask;
+} ChainedMap;
+
+static int chained_init(ChainedMap* m, size_t buckets) {
+    m->buckets = (ChainNode**)calloc(buckets, sizeof(ChainNode*));
+    m->mask = buckets - 1;
+    return m->buckets ? 0 : -1;
+}
+
+static void chained_destroy(ChainedMap* m) {
+    for (size_t b = 0; m->buckets && b <= m->mask; b++) {
+        for (ChainNode* n = m->buckets[b]; n != NULL;) {
+            ChainNode* next = n->next;
+            free(n);
+            n = next;
+        }
+    }
+    free(m->buckets);
+    m->buckets = NULL;
+}
+
+static int chained_insert(ChainedMap* m, uint64_t key, const Person* value) {
+    ChainNode** head = &m->buckets[id_hash(key) & m->mask];
+    for (ChainNode* n = *head; n != NULL; n = n->next) {
+        if (n->key == key) {
+            n->value = *value;
+            return 0;
+        }
+    }
+    ChainNode* node = (ChainNode*)malloc(sizeof(ChainNode));
+    if (node == NULL) return -1;
+    node->key = key;
+    node->value = *value;
+    node->next = *head;
+    *head = node;
+    return 1;
+}
+
+static Person* chained_find(const ChainedMap* m, uint64_t key) {
+    for (ChainNode* n = m->buckets[id_hash(key) & m->mask]; n != NULL; n = n->next) {
+        if (n->key == key) return &n->value;
+    }
+    return NULL;
+}
+
+typedef enum { MAP_CHAINED, MAP_OPEN, MAP_OPEN_BULK } MapKind;
+
+typedef struct {
+    MapKind kind;
+    ChainedMap* chained;
+    HashMap_person_map* open;
+    const uint64_t* keys;      // Lookup keys, or the ids to insert
+    const Person* records;     // Records to insert
+    size_t count;
+} MapBench;
+
+void map_lookup_run(void* ctx) {
+    MapBench* b = (MapBench*)ctx;
+    long sum = 0;
+    for (size_t i = 0; i < b->count; i++) {
+        Person* p = b->kind == MAP_CHAINED ? chained_find(b->chained, b->keys[i])
+                                           : person_map_find(b->open, b->keys[i]);
+        if (p != NULL) sum += p->age;
+    }
+    BENCH_DO_NOT_OPTIMIZE(sum);
+}
+
+void map_insert_run(void* ctx) {
+    MapBench* b = (MapBench*)ctx;
+    if (b->kind == MAP_CHAINED) {
+        ChainedMap m;
+        if (chained_init(&m, MAP_SLOTS) != 0) return;
+        for (size_t i = 0; i < b->count; i++) chained_insert(&m, b->keys[i], &b->records[i]);
+        BENCH_CLOBBER();
+        chained_destroy(&m);
+        return;
+    }
+    HashMap_person_map m;
+    person_map_init(&m);
+    if (b->kind == MAP_OPEN_BULK) {
+        person_map_insert_bulk(&m, b->keys, b->records, b->count);
+    } else {
+        for (size_t i = 0; i < b->count; i++) person_map_insert(&m, b->keys[i], b->records[i]);
+    }
+    BENCH_CLOBBER();
+    person_map_destroy(&m);
+}
+
+static uint64_t map_rng_(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void load_factor_sweep(uint64_t* ids, Person* records, uint64_t* hits, uint64_t* misses) {
+    static const int eighths[] = {2, 4, 6, 7};
+    static const char* const titles[] = {"Load 0.25: 1M lookups among 32768 records",
+                                         "Load 0.50: 1M lookups among 65536 records",
+                                         "Load 0.75: 1M lookups among 98304 records",
+                                         "Load 0.875: 1M lookups among 114688 records"};
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    for (int l = 0; l < 4; l++) {
+        size_t n = (size_t)MAP_SLOTS / 8 * (size_t)eighths[l];
+        ChainedMap chained;
+        HashMap_person_map open;
+        person_map_init(&open);
+        if (chained_init(&chained, MAP_SLOTS) != 0 || person_map_reserve(&open, HASHMAP_MAX_LOAD(MAP_SLOTS)) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            chained_destroy(&chained);
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            chained_insert(&chained, ids[i], &records[i]);
+            person_map_insert(&open, ids[i], records[i]);
+        }
+        for (size_t i = 0; i < MAP_LOOKUPS; i++) {
+            hits[i] = ids[map_rng_(&state) % n];
+            misses[i] = map_rng_(&state) | 1;  // The ids are even
+        }
+
+        MapBench cases[4] = {
+            {MAP_CHAINED, &chained, &open, hits, NULL, MAP_LOOKUPS},
+            {MAP_OPEN, &chained, &open, hits, NULL, MAP_LOOKUPS},
+            {MAP_CHAINED, &chained, &open, misses, NULL, MAP_LOOKUPS},
+            {MAP_OPEN, &chained, &open, misses, NULL, MAP_LOOKUPS},
+        };
+        BenchSuite suite;
+        bench_suite_init(&suite, titles[l]);
+        bench_suite_run(&suite, "chained, hit", map_lookup_run, &cases[0], MAP_LOOKUPS);
+        bench_suite_run(&suite, "hashmap.h, hit", map_lookup_run, &cases[1], MAP_LOOKUPS);
+        bench_suite_run(&suite, "chained, miss", map_lookup_run, &cases[2], MAP_LOOKUPS);
+        bench_suite_run(&suite, "hashmap.h, miss", map_lookup_run, &cases[3], MAP_LOOKUPS);
+        bench_suite_report(&suite);
+        printf("  capacity %zu, load %.3f\n\n", open.capacity, (double)open.size / (double)open.capacity);
+
+        chained_destroy(&chained);
+        person_map_destroy(&open);
+    }
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    uint64_t* ids = (uint64_t*)malloc(MAP_SLOTS * sizeof(uint64_t));
+    Person* records = (Person*)malloc(MAP_SLOTS * sizeof(Person));
+    uint64_t* hits = (uint64_t*)malloc(MAP_LOOKUPS * sizeof(uint64_t));
+    uint64_t* misses = (uint64_t*)malloc(MAP_LOOKUPS * sizeof(uint64_t));
+    if (ids == NULL || records == NULL || hits == NULL || misses == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(ids);
+        free(records);
+        free(hits);
+        free(misses);
+        return;
+    }
+    // Random even ids, so an odd id is a guaranteed miss
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = 0; i < MAP_SLOTS; i++) {
+        ids[i] = map_rng_(&state) & ~1ull;
+        records[i] = make_person(ids[i], "record", (int)(i % 80), 1.6f);
+    }
+
+    load_factor_sweep(ids, records, hits, misses);
+
+    MapBench chained = {MAP_CHAINED, NULL, NULL, ids, records, MAP_INSERTS};
+    MapBench single = {MAP_OPEN, NULL, NULL, ids, records, MAP_INSERTS};
+    MapBench bulk = {MAP_OPEN_BULK, NULL, NULL, ids, records, MAP_INSERTS};
+    BenchSuite suite;
+    bench_suite_init(&suite, "Insert 100K records into an empty table");
+    bench_suite_run(&suite, "chained + malloc", map_insert_run, &chained, MAP_INSERTS);
+    bench_suite_run(&suite, "hashmap.h insert", map_insert_run, &single, MAP_INSERTS);
+    bench_suite_run(&suite, "hashmap.h bulk", map_insert_run, &bulk, MAP_INSERTS);
+    bench_suite_report(&suite);
+    printf("Memory per record: chained %zu bytes + malloc overhead; "
+           "hashmap.h %zu bytes per slot at up to 7/8 load\n\n",
+           sizeof(ChainNode) + sizeof(ChainNode*), sizeof(uint64_t) + sizeof(Person) + 1);
+
+    free(ids);
+    free(records);
+    free(hits);
+    free(misses);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o hash_maps HashMaps.c -O2
+
+Then execute the resulting binary:
+    ./hash_maps
+*/
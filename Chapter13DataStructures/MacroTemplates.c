@@ -0,0 +1,456 @@
+/*
+Cheat Sheet: Type-Specialised Containers and Algorithms with Macro Templates
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+C has two ways to write code once for many types. Chapter6Pointers/PointersToFunctions.c
+shows the first, void* plus callbacks: qsort(numbers, n, sizeof(int), compare_int)
+and BinaryOperation function pointers. It is compact, but every comparison is an
+indirect call the compiler cannot inline, and elements are moved as anonymous bytes.
+
+The second writes the code as a macro and expands it once per type, which is
+what a C++ template does. The element type and the comparison are then known at
+compile time. The comparison becomes one instruction, elements are moved as
+values, and simple loops vectorise.
+
+Key points:
+- Function-pointer generics: one copy of the code, an indirect call per element.
+- Macro templates: one copy per type, with everything inlined.
+- The cost is a larger binary and error messages that point into macro bodies.
+
+Historical context:
+- The BSD <sys/queue.h> and <sys/tree.h> macros (1990s) generate linked lists
+  and red-black trees per type and are still used in the BSD kernels.
+- klib's khash/ksort (Heng Li, 2008) and the stb libraries popularised
+  macro-generated containers for performance-critical C.
+- C11 _Generic selects among functions by type, but it does not generate code.
+
+The implementation lives in generic.h next to this file. Its sort is the
+introsort from Chapter14Algorithms/sort.h.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generic.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+typedef struct {
+    int key;
+    int payload[3];
+} Record;
+
+#define RECORD_LESS(a, b) ((a).key < (b).key)
+
+static inline int by_abs_less(int a, int b) {
+    return abs(a) < abs(b);
+}
+
+#define SQUARE(x) ((x) * (x))
+
+// One instantiation of each template per type
+DEFINE_VECTOR(int)
+DEFINE_VECTOR(Record)
+DEFINE_SORT(int, GENERIC_LESS)
+DEFINE_SORT_NAMED(int_abs, int, by_abs_less)
+DEFINE_SORT_NAMED(record, Record, RECORD_LESS)
+DEFINE_FOLD(int_sum, int, GENERIC_ADD)
+DEFINE_FOLD(int_max, int, GENERIC_MAX)
+DEFINE_TRANSFORM(int_square, int, SQUARE)
+
+// Function prototypes
+void vector_example();
+void sort_and_search_example();
+void custom_ordering_example();
+void fold_and_transform_example();
+void performance_comparison();
+
+int main() {
+    printf("Macro Templates Cheat Sheet\n");
+    printf("===========================\n\n");
+
+    vector_example();
+    sort_and_search_example();
+    custom_ordering_example();
+    fold_and_transform_example();
+    performance_comparison();
+
+    return 0;
+}
+
+static void print_ints(const char* label, const int* a, size_t n) {
+    printf("%s", label);
+    for (size_t i = 0; i < n; i++) printf(" %d", a[i]);
+    printf("\n");
+}
+
+void vector_example() {
+    printf("2.1 DEFINE_VECTOR: a Growable Array per Type\n");
+    printf("---------------------------------------------\n");
+
+    Vector_int v;
+    vector_int_init(&v);
+    for (int i = 1; i <= 10; i++) {
+        if (vector_int_push(&v, i * i) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            vector_int_destroy(&v);
+            return;
+        }
+    }
+    printf("size %zu, capacity %zu, last %d\n", v.size, v.capacity, v.data[v.size - 1]);
+    int popped = vector_int_pop(&v);
+    print_ints("After pop:", v.data, v.size);
+    printf("Popped %d\n", popped);
+
+    // Structs are stored by value: no per-element allocation, no void* casts
+    Vector_Record records;
+    vector_Record_init(&records);
+    Record r = {7, {1, 2, 3}};
+    if (vector_Record_push(&records, r) == 0) {
+        printf("Record vector holds %zu record(s), first key %d\n", records.size, records.data[0].key);
+    }
+    vector_Record_destroy(&records);
+    vector_int_destroy(&v);
+    printf("\n");
+}
+
+void sort_and_search_example() {
+    printf("2.2 DEFINE_SORT: Inlined Sort and Binary Search\n");
+    printf("------------------------------------------------\n");
+
+    int numbers[] = {64, 34, 25, 12, 22, 11, 90, 25};  // The array from PointersToFunctions.c, plus a duplicate
+    size_t n = sizeof(numbers) / sizeof(numbers[0]);
+    int_sort(numbers, n);  // Instead of qsort(numbers, n, sizeof(int), compare_int)
+    print_ints("Sorted:", numbers, n);
+    printf("int_is_sorted: %d\n", int_is_sorted(numbers, n));
+    printf("25 spans [%zu, %zu), binary_search(90) = %zu, binary_search(50) = %s\n",
+           int_lower_bound(numbers, n, 25), int_upper_bound(numbers, n, 25), int_binary_search(numbers, n, 90),
+           int_binary_search(numbers, n, 50) == GENERIC_NPOS ? "GENERIC_NPOS" : "found");
+    printf("\n");
+}
+
+void custom_ordering_example() {
+    printf("2.3 Custom Orderings and Struct Keys\n");
+    printf("-------------------------------------\n");
+
+    // DEFINE_SORT_NAMED gives one type a second ordering under a new prefix
+    int values[] = {-9, 4, -1, 7, 0, -3};
+    int_abs_sort(values, 6);
+    print_ints("By absolute value:", values, 6);
+
+    Record records[] = {{3, {0}}, {1, {0}}, {2, {0}}};
+    record_sort(records, 3);
+    printf("Records by key: %d %d %d\n", records[0].key, records[1].key, records[2].key);
+    Record probe = {2, {0}};
+    printf("record_binary_search(key 2) = %zu\n\n", record_binary_search(records, 3, probe));
+}
+
+void fold_and_transform_example() {
+    printf("2.4 DEFINE_FOLD and DEFINE_TRANSFORM\n");
+    printf("-------------------------------------\n");
+
+    int values[] = {3, 1, 4, 1, 5, 9, 2, 6};
+    int squares[8];
+    // The BinaryOperation of PointersToFunctions.c becomes a compile-time argument
+    printf("Sum: %d, max: %d\n", int_sum(values, 8, 0), int_max(values, 8, values[0]));
+    int_square(values, squares, 8);
+    print_ints("Squares:", squares, 8);
+    printf("\n");
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Instantiate templates in one place per translation unit, next to the type.
+2. Pass comparisons as macros or static inline functions, never as function
+   pointer variables, or the indirection comes back.
+3. Keep macro bodies small and forward to ordinary static inline helpers, so
+   debuggers and error messages stay readable.
+
+Common Pitfalls:
+1. Multi-word types (unsigned long, struct foo, char*) cannot be pasted into
+   names: typedef them first.
+2. Macro arguments are evaluated as written: LESS(a[i++], b) increments twice.
+3. Instantiating the same template twice in one file redefines the functions.
+   Instantiate it once and share it.
+4. Using <= as LESS breaks the sort's invariants.
+
+Advanced Tips:
+1. Compare the assembly: the typed sort's inner loop has cmp/cmov where qsort
+   has call *%rax.
+2. C11 _Generic can put one name (e.g. sort()) in front of several instantiations.
+3. Check binary size when instantiating for many types; share one instantiation
+   for types with the same representation.
+
+4. Integration and Real-World Applications
+==========================================
+- Operating-system kernels: BSD queue.h/tree.h and Linux's rbtree and list helpers.
+- Bioinformatics tools (samtools, minimap2) use klib's macro-generated hash
+  tables and sorts.
+- Game engines and embedded code, where C++ is not available but zero-overhead
+  containers are needed.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- "Include templates": define T and the name prefix, then #include a header body
+  several times. STC and the Linux kernel's generic headers use this style.
+- C23 typeof makes type-generic macros easier to write safely.
+- Link-time optimisation can sometimes inline a callback in qsort-style code,
+  but only when the callee and the target are both visible to the optimiser.
+
+6. FAQs and Troubleshooting
+===========================
+Q: The compiler error points into a 60-line macro. How do I debug it?
+A: Run gcc -E on the file and read the expanded code, or compile the preprocessed
+   output to get line numbers in the real code.
+
+Q: Is the function-pointer version ever the right choice?
+A: Yes, when the type is only known at run time (plugins, generic tools over
+   serialized records) or code size matters more than speed.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- klib (khash.h, ksort.h, kvec.h) by Heng Li
+- STC, the Smart Template Containers for C
+- BSD sys/queue.h and sys/tree.h
+- Chapter14Algorithms/sort.h for the sort algorithm itself
+
+8. Performance Analysis and Optimization
+========================================
+Each benchmark pits the void* / function-pointer version against the generated
+one:
+- Sorting 1M ints: qsort with compare_int against int_sort.
+- Sorting 1M 16-byte records: qsort with a record comparator against record_sort.
+- 1M lookups in 64K sorted ints: bsearch against int_binary_search.
+- Folding 16M ints: a BinaryOperation pointer against int_sum.
+- Pushing 1M ints into a vector that is reused between runs: a void* vector
+  that memcpy's elem_size bytes against Vector_int.
+*/
+
+#define TPL_SORT_N (1u << 20)
+#define TPL_TABLE_N (1u << 16)
+#define TPL_LOOKUPS (1u << 20)
+#define TPL_FOLD_N (1u << 24)
+#define TPL_PUSH_N (1u << 20)
+
+// The comparator from Chapter6Pointers/PointersToFunctions.c. Values stay below
+// 2^30, so the subtraction cannot overflow here.
+int compare_int(const void* a, const void* b) {
+    return (*(int*)a - *(int*)b);
+}
+
+int compare_record(const void* a, const void* b) {
+    int x = ((const Record*)a)->key, y = ((const Record*)b)->key;
+    return (x > y) - (x < y);
+}
+
+typedef int (*BinaryOperation)(int, int);
+
+int add(int a, int b) {
+    return a + b;
+}
+
+// A void* vector as written without templates: sizes known only at run time
+typedef struct {
+    unsigned char* data;
+    size_t elem_size, size, capacity;
+} VoidVector;
+
+static int void_vector_push(VoidVector* v, const void* elem) {
+    if (v->size == v->capacity) {
+        size_t capacity = v->capacity ? v->capacity * 2 : 8;
+        unsigned char* data = (unsigned char*)realloc(v->data, capacity * v->elem_size);
+        if (data == NULL) return -1;
+        v->data = data;
+        v->capacity = capacity;
+    }
+    memcpy(v->data + v->size * v->elem_size, elem, v->elem_size);
+    v->size++;
+    return 0;
+}
+
+typedef struct {
+    const int* input;
+    int* work;
+    const Record* records_in;
+    Record* records;
+    const int* keys;
+    Vector_int* vector;
+    VoidVector* void_vector;
+    int use_template;
+} TemplateBench;
+
+void sort_ints_run(void* ctx) {
+    TemplateBench* b = (TemplateBench*)ctx;
+    memcpy(b->work, b->input, TPL_SORT_N * sizeof(int));
+    if (b->use_template) {
+        int_sort(b->work, TPL_SORT_N);
+    } else {
+        qsort(b->work, TPL_SORT_N, sizeof(int), compare_int);
+    }
+    BENCH_CLOBBER();
+}
+
+void sort_records_run(void* ctx) {
+    TemplateBench* b = (TemplateBench*)ctx;
+    memcpy(b->records, b->records_in, TPL_SORT_N * sizeof(Record));
+    if (b->use_template) {
+        record_sort(b->records, TPL_SORT_N);
+    } else {
+        qsort(b->records, TPL_SORT_N, sizeof(Record), compare_record);
+    }
+    BENCH_CLOBBER();
+}
+
+void lookup_run(void* ctx) {
+    TemplateBench* b = (TemplateBench*)ctx;
+    size_t hits = 0;
+    for (size_t j = 0; j < TPL_LOOKUPS; j++) {
+        if (b->use_template) {
+            hits += int_binary_search(b->input, TPL_TABLE_N, b->keys[j]) != GENERIC_NPOS;
+        } else {
+            hits += bsearch(&b->keys[j], b->input, TPL_TABLE_N, sizeof(int), compare_int) != NULL;
+        }
+    }
+    BENCH_DO_NOT_OPTIMIZE(hits);
+}
+
+void fold_run(void* ctx) {
+    TemplateBench* b = (TemplateBench*)ctx;
+    int total;
+    if (b->use_template) {
+        total = int_sum(b->input, TPL_FOLD_N, 0);
+    } else {
+        BinaryOperation op = add;
+        BENCH_HIDE_VALUE(op);  // As if chosen at run time, e.g. by get_operation('+')
+        total = 0;
+        for (size_t i = 0; i < TPL_FOLD_N; i++) total = op(total, b->input[i]);
+    }
+    BENCH_DO_NOT_OPTIMIZE(total);
+}
+
+// Refills a vector that keeps its capacity between runs, so only the first
+// (warmup) run pays for growth and the timed runs measure push itself
+void push_run(void* ctx) {
+    TemplateBench* b = (TemplateBench*)ctx;
+    if (b->use_template) {
+        Vector_int* v = b->vector;
+        vector_int_clear(v);
+        for (int i = 0; i < (int)TPL_PUSH_N; i++) {
+            if (vector_int_push(v, i) != 0) break;
+        }
+        BENCH_DO_NOT_OPTIMIZE(v->data[v->size - 1]);
+    } else {
+        VoidVector* v = b->void_vector;
+        v->size = 0;
+        for (int i = 0; i < (int)TPL_PUSH_N; i++) {
+            if (void_vector_push(v, &i) != 0) break;
+        }
+        BENCH_DO_NOT_OPTIMIZE(v->data[v->size - 1]);
+    }
+}
+
+static void run_pair(const char* title, BenchFn fn, TemplateBench* b, const char* baseline, size_t ops) {
+    BenchSuite suite;
+    bench_suite_init(&suite, title);
+    b->use_template = 0;
+    bench_suite_run(&suite, baseline, fn, b, ops);
+    TemplateBench templated = *b;
+    templated.use_template = 1;
+    bench_suite_run(&suite, "macro template", fn, &templated, ops);
+    bench_suite_report(&suite);
+    printf("\n");
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    int* input = (int*)malloc(TPL_FOLD_N * sizeof(int));
+    int* work = (int*)malloc(TPL_SORT_N * sizeof(int));
+    Record* records_in = (Record*)malloc(TPL_SORT_N * sizeof(Record));
+    Record* records = (Record*)malloc(TPL_SORT_N * sizeof(Record));
+    int* keys = (int*)malloc(TPL_LOOKUPS * sizeof(int));
+    if (input == NULL || work == NULL || records_in == NULL || records == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(input);
+        free(work);
+        free(records_in);
+        free(records);
+        free(keys);
+        return;
+    }
+    unsigned int x = 12345;
+    for (size_t i = 0; i < TPL_FOLD_N; i++) {
+        x = x * 1103515245u + 12345u;
+        input[i] = (int)((x >> 2) & ((1u << 30) - 1));
+    }
+    for (size_t i = 0; i < TPL_SORT_N; i++) {
+        records_in[i].key = input[i];
+        records_in[i].payload[0] = (int)i;
+    }
+    Vector_int vector;
+    vector_int_init(&vector);
+    VoidVector void_vector = {NULL, sizeof(int), 0, 0};
+    BENCH_HIDE_VALUE(void_vector.elem_size);  // Known only at run time, as in a real void* container
+    TemplateBench bench = {input, work, records_in, records, keys, &vector, &void_vector, 0};
+    run_pair("Sort 1M ints", sort_ints_run, &bench, "qsort + compare_int", TPL_SORT_N);
+    run_pair("Sort 1M 16-byte records by key", sort_records_run, &bench, "qsort + compare_record", TPL_SORT_N);
+
+    // Lookup table: the first 64K values, sorted; half the keys are present
+    int_sort(input, TPL_TABLE_N);
+    for (size_t j = 0; j < TPL_LOOKUPS; j++) {
+        x = x * 1103515245u + 12345u;
+        keys[j] = (j & 1) ? input[(x >> 8) % TPL_TABLE_N] : (int)((x >> 2) & ((1u << 30) - 1));
+    }
+    run_pair("1M lookups in 64K sorted ints", lookup_run, &bench, "bsearch + compare_int", TPL_LOOKUPS);
+
+    // Small values so the 16M-element sum cannot overflow
+    for (size_t i = 0; i < TPL_FOLD_N; i++) input[i] &= 63;
+    run_pair("Fold (sum) 16M ints", fold_run, &bench, "BinaryOperation pointer", TPL_FOLD_N);
+    run_pair("Push 1M ints", push_run, &bench, "void* vector + memcpy", TPL_PUSH_N);
+
+    vector_int_destroy(&vector);
+    free(void_vector.data);
+
+    free(input);
+    free(work);
+    free(records_in);
+    free(records);
+    free(keys);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o macro_templates MacroTemplates.c -O2
+
+Then execute the resulting binary:
+    ./macro_templates
+*/
@@ -0,0 +1,772 @@
+/*
+bitset.h - Dynamic Bitsets and Roaring-Style Compressed Bitmaps
+================================================
+
+A header-only bitmap library that takes the single-integer flag tricks from
+bitmask_usage() and bitfield_operations() in
+Chapter2OperatorsAndExpressions/BitwiseOperators.c to an arbitrary number of bits.
+
+Two representations are provided:
+
+Bitset (dense)
+- One bit per possible element in a growable array of 64-bit words, so memory is
+  fixed at universe/8 bytes no matter how many bits are set.
+- set/clear/test/flip are a shift and a mask. rank (set bits below i), count and
+  the boolean operations run over whole words with the SIMD kernels from
+  Chapter2OperatorsAndExpressions/popcount_simd.h.
+- Iteration visits only set bits: each non-zero word is consumed with
+  ctz + "w &= w - 1", so empty regions cost one load per 64 bits.
+
+RoaringBitmap (compressed, 32-bit values)
+- Values are split into a 16-bit key (high half) and a 16-bit offset (low half).
+  Every key that has at least one value gets a container for its 65536 offsets:
+    array container   sorted uint16_t offsets, used while cardinality <= 4096
+    bitmap container  1024 words (8 KB), used above 4096
+  The threshold is where the two cost the same (4096 * 2 bytes = 8 KB), so a
+  container never uses more than 8 KB, and a sparse set costs about 2 bytes per
+  value instead of 512 MB for a dense 2^32-bit bitset.
+- Containers are kept sorted by key; lookups binary-search the key and then the
+  array, or test the bitmap directly.
+
+Usage:
+    Bitset active;
+    bitset_init(&active, 1000000);
+    bitset_set(&active, 42);
+    bitset_and(&active, &in_stock);                   // In place
+    size_t i;
+    BITSET_FOREACH(&active, i) { handle(i); }
+    bitset_destroy(&active);
+
+    RoaringBitmap users;
+    roaring_init(&users);
+    roaring_add(&users, 3000000000u);
+    if (roaring_contains(&users, 3000000000u)) ...
+    roaring_destroy(&users);
+
+Functions that allocate return 0 on success and -1 with errno set (ENOMEM) on
+failure; the set is left unchanged in that case.
+*/
+
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "../Chapter2OperatorsAndExpressions/popcount_simd.h"
+
+#define BITSET_NPOS ((size_t)-1)
+#define BITSET_WORD_BITS 64
+
+// ---------------------------------------------------------------------------
+// Dense bitset
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t* words;
+    size_t nbits;              // Logical size: valid indices are [0, nbits)
+    size_t nwords;             // Words in use, (nbits + 63) / 64
+    size_t capacity;           // Words allocated
+} Bitset;
+
+static inline size_t bitset_words_for_(size_t nbits) {
+    return (nbits + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+}
+
+// Bits at or above nbits in the last word are kept zero so counts and boolean
+// operations never need a special case for the tail.
+static inline void bitset_trim_(Bitset* bs) {
+    size_t tail = bs->nbits % BITSET_WORD_BITS;
+    if (tail) bs->words[bs->nwords - 1] &= (1ULL << tail) - 1;
+}
+
+static inline int bitset_init(Bitset* bs, size_t nbits) {
+    memset(bs, 0, sizeof(*bs));
+    size_t nwords = bitset_words_for_(nbits);
+    if (nwords > 0) {
+        bs->words = (uint64_t*)calloc(nwords, sizeof(uint64_t));
+        if (bs->words == NULL) return -1;
+    }
+    bs->nbits = nbits;
+    bs->nwords = nwords;
+    bs->capacity = nwords;
+    return 0;
+}
+
+static inline void bitset_destroy(Bitset* bs) {
+    free(bs->words);
+    memset(bs, 0, sizeof(*bs));
+}
+
+// Grow or shrink to nbits. New bits are zero; capacity grows geometrically so
+// repeated bitset_resize() calls are amortised O(1) per word.
+static inline int bitset_resize(Bitset* bs, size_t nbits) {
+    size_t nwords = bitset_words_for_(nbits);
+    if (nwords > bs->capacity) {
+        size_t capacity = bs->capacity ? bs->capacity * 2 : 8;
+        if (capacity < nwords) capacity = nwords;
+        uint64_t* words = (uint64_t*)realloc(bs->words, capacity * sizeof(uint64_t));
+        if (words == NULL) return -1;
+        bs->words = words;
+        bs->capacity = capacity;
+    }
+    if (nwords > bs->nwords) {
+        memset(bs->words + bs->nwords, 0, (nwords - bs->nwords) * sizeof(uint64_t));
+    }
+    bs->nbits = nbits;
+    bs->nwords = nwords;
+    if (nwords) bitset_trim_(bs);
+    return 0;
+}
+
+static inline void bitset_clear_all(Bitset* bs) {
+    if (bs->nwords) memset(bs->words, 0, bs->nwords * sizeof(uint64_t));
+}
+
+static inline void bitset_set_all(Bitset* bs) {
+    if (bs->nwords == 0) return;
+    memset(bs->words, 0xFF, bs->nwords * sizeof(uint64_t));
+    bitset_trim_(bs);
+}
+
+// Single-bit operations. Indices must be below nbits, except bitset_test(), which
+// reports 0 for anything out of range.
+static inline void bitset_set(Bitset* bs, size_t i) {
+    bs->words[i / BITSET_WORD_BITS] |= 1ULL << (i % BITSET_WORD_BITS);
+}
+
+static inline void bitset_clear(Bitset* bs, size_t i) {
+    bs->words[i / BITSET_WORD_BITS] &= ~(1ULL << (i % BITSET_WORD_BITS));
+}
+
+static inline void bitset_flip(Bitset* bs, size_t i) {
+    bs->words[i / BITSET_WORD_BITS] ^= 1ULL << (i % BITSET_WORD_BITS);
+}
+
+static inline int bitset_test(const Bitset* bs, size_t i) {
+    if (i >= bs->nbits) return 0;
+    return (int)((bs->words[i / BITSET_WORD_BITS] >> (i % BITSET_WORD_BITS)) & 1);
+}
+
+// Set bit i, growing the bitset first if needed.
+static inline int bitset_add(Bitset* bs, size_t i) {
+    if (i >= bs->nbits && bitset_resize(bs, i + 1) != 0) return -1;
+    bitset_set(bs, i);
+    return 0;
+}
+
+static inline size_t bitset_count(const Bitset* bs) {
+    return (size_t)popcount_array(bs->words, bs->nwords);
+}
+
+// Number of set bits in [0, i).
+static inline size_t bitset_rank(const Bitset* bs, size_t i) {
+    if (i > bs->nbits) i = bs->nbits;
+    size_t full = i / BITSET_WORD_BITS;
+    size_t rank = (size_t)popcount_array(bs->words, full);
+    size_t rest = i % BITSET_WORD_BITS;
+    if (rest) rank += (size_t)__builtin_popcountll(bs->words[full] & ((1ULL << rest) - 1));
+    return rank;
+}
+
+// Position of the k-th set bit (k counts from 0) within one word; k < popcount(w).
+static inline unsigned bitset_select_word_(uint64_t w, unsigned k) {
+    // Every byte's popcount in parallel, then skip whole bytes, then bits
+    uint64_t bytes = w - ((w >> 1) & 0x5555555555555555ULL);
+    bytes = (bytes & 0x3333333333333333ULL) + ((bytes >> 2) & 0x3333333333333333ULL);
+    bytes = (bytes + (bytes >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    unsigned shift = 0;
+    for (;;) {
+        unsigned in_byte = (unsigned)((bytes >> shift) & 0xFF);
+        if (k < in_byte) break;
+        k -= in_byte;
+        shift += 8;
+    }
+    uint64_t rest = w >> shift;
+    while (k--) rest &= rest - 1;
+    return shift + (unsigned)__builtin_ctzll(rest);
+}
+
+// Index of the k-th set bit (k counts from 0), or BITSET_NPOS if fewer are set.
+// The inverse of rank: bitset_rank(bs, bitset_select(bs, k)) == k.
+static inline size_t bitset_select(const Bitset* bs, size_t k) {
+    for (size_t w = 0; w < bs->nwords; w++) {
+        size_t bits = (size_t)__builtin_popcountll(bs->words[w]);
+        if (k < bits) return w * BITSET_WORD_BITS + bitset_select_word_(bs->words[w], (unsigned)k);
+        k -= bits;
+    }
+    return BITSET_NPOS;
+}
+
+// Lowest set bit at or after 'from', or BITSET_NPOS.
+static inline size_t bitset_next_set(const Bitset* bs, size_t from) {
+    if (from >= bs->nbits) return BITSET_NPOS;
+    size_t w = from / BITSET_WORD_BITS;
+    uint64_t word = bs->words[w] & (~0ULL << (from % BITSET_WORD_BITS));
+    if (word) return w * BITSET_WORD_BITS + (size_t)__builtin_ctzll(word);
+    size_t found = find_first_set_array(bs->words + w + 1, bs->nwords - w - 1);
+    return found == POPCOUNT_NOT_FOUND ? BITSET_NPOS : (w + 1) * BITSET_WORD_BITS + found;
+}
+
+// Iterate over every set bit in increasing order:
+//     size_t i;
+//     BITSET_FOREACH(&bs, i) { ... }
+// The body runs inside two loops, so 'break' only leaves the current word; use
+// goto or a flag to stop early. The bitset must not be modified during the loop.
+#define BITSET_FOREACH(bs, index)                                                    \
+    for (size_t bitset_w_ = 0; bitset_w_ < (bs)->nwords; bitset_w_++)                \
+        for (uint64_t bitset_bits_ = (bs)->words[bitset_w_]; bitset_bits_ != 0;      \
+             bitset_bits_ &= bitset_bits_ - 1)                                       \
+            if (((index) = bitset_w_ * BITSET_WORD_BITS +                            \
+                           (size_t)__builtin_ctzll(bitset_bits_)), 1)
+
+// Decode up to 'max' set bits at or after 'from' into 'out'; returns how many were
+// written. Batch decoding keeps the consumer's loop free of bit manipulation, and
+// calling it again with from = out[n - 1] + 1 continues where it stopped.
+static inline size_t bitset_to_indices(const Bitset* bs, size_t from, uint32_t* out, size_t max) {
+    size_t n = 0;
+    if (from >= bs->nbits || max == 0) return 0;
+    size_t w = from / BITSET_WORD_BITS;
+    uint64_t word = bs->words[w] & (~0ULL << (from % BITSET_WORD_BITS));
+    for (;;) {
+        while (word != 0) {
+            out[n++] = (uint32_t)(w * BITSET_WORD_BITS + (size_t)__builtin_ctzll(word));
+            if (n == max) return n;
+            word &= word - 1;
+        }
+        if (++w >= bs->nwords) return n;
+        word = bs->words[w];
+    }
+}
+
+// In-place boolean operations: dst = dst OP src. A shorter src is treated as
+// zero-extended; for OR and XOR dst grows to src's size first, which can fail.
+static inline void bitset_and(Bitset* dst, const Bitset* src) {
+    size_t common = dst->nwords < src->nwords ? dst->nwords : src->nwords;
+    for (size_t i = 0; i < common; i++) dst->words[i] &= src->words[i];
+    if (dst->nwords > common) memset(dst->words + common, 0, (dst->nwords - common) * sizeof(uint64_t));
+}
+
+static inline void bitset_andnot(Bitset* dst, const Bitset* src) {
+    size_t common = dst->nwords < src->nwords ? dst->nwords : src->nwords;
+    for (size_t i = 0; i < common; i++) dst->words[i] &= ~src->words[i];
+}
+
+static inline int bitset_or(Bitset* dst, const Bitset* src) {
+    if (src->nbits > dst->nbits && bitset_resize(dst, src->nbits) != 0) return -1;
+    for (size_t i = 0; i < src->nwords; i++) dst->words[i] |= src->words[i];
+    return 0;
+}
+
+static inline int bitset_xor(Bitset* dst, const Bitset* src) {
+    if (src->nbits > dst->nbits && bitset_resize(dst, src->nbits) != 0) return -1;
+    for (size_t i = 0; i < src->nwords; i++) dst->words[i] ^= src->words[i];
+    return 0;
+}
+
+// dst = ~dst within [0, nbits)
+static inline void bitset_not(Bitset* bs) {
+    for (size_t i = 0; i < bs->nwords; i++) bs->words[i] = ~bs->words[i];
+    if (bs->nwords) bitset_trim_(bs);
+}
+
+// |a AND b| without materialising the intersection.
+static inline size_t bitset_and_count(const Bitset* a, const Bitset* b) {
+    size_t common = a->nwords < b->nwords ? a->nwords : b->nwords;
+    return (size_t)popcount_and_array(a->words, b->words, common);
+}
+
+static inline size_t bitset_memory_bytes(const Bitset* bs) {
+    return sizeof(*bs) + bs->capacity * sizeof(uint64_t);
+}
+
+// ---------------------------------------------------------------------------
+// Roaring-style compressed bitmap
+// ---------------------------------------------------------------------------
+
+#define ROARING_ARRAY_MAX 4096                  // Above this an array costs more than a bitmap
+#define ROARING_BITMAP_WORDS (65536 / BITSET_WORD_BITS)
+
+enum { ROARING_ARRAY, ROARING_BITMAP };
+
+typedef struct {
+    uint16_t key;              // High 16 bits of every value in the container
+    uint16_t type;             // ROARING_ARRAY or ROARING_BITMAP
+    uint32_t cardinality;      // 1 .. 65536; empty containers are removed
+    uint32_t capacity;         // Array slots allocated (array containers only)
+    union {
+        uint16_t* array;       // Sorted, no duplicates
+        uint64_t* bitmap;      // ROARING_BITMAP_WORDS words
+    } data;
+} RoaringContainer;
+
+typedef struct {
+    RoaringContainer* containers;  // Sorted by key
+    size_t count;
+    size_t capacity;
+} RoaringBitmap;
+
+static inline void roaring_init(RoaringBitmap* r) {
+    memset(r, 0, sizeof(*r));
+}
+
+static inline void roaring_container_free_(RoaringContainer* c) {
+    if (c->type == ROARING_ARRAY) free(c->data.array);
+    else free(c->data.bitmap);
+}
+
+static inline void roaring_destroy(RoaringBitmap* r) {
+    for (size_t i = 0; i < r->count; i++) roaring_container_free_(&r->containers[i]);
+    free(r->containers);
+    memset(r, 0, sizeof(*r));
+}
+
+static inline void roaring_clear(RoaringBitmap* r) {
+    for (size_t i = 0; i < r->count; i++) roaring_container_free_(&r->containers[i]);
+    r->count = 0;
+}
+
+// Index of the container for 'key', or -(insertion point) - 1 if there is none.
+static inline ptrdiff_t roaring_find_key_(const RoaringBitmap* r, uint16_t key) {
+    size_t lo = 0, hi = r->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint16_t k = r->containers[mid].key;
+        if (k == key) return (ptrdiff_t)mid;
+        if (k < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return -(ptrdiff_t)lo - 1;
+}
+
+// Lower bound of 'value' in a sorted uint16_t array.
+static inline uint32_t roaring_array_search_(const uint16_t* a, uint32_t n, uint16_t value) {
+    uint32_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (a[mid] < value) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static inline int roaring_array_to_bitmap_(RoaringContainer* c) {
+    uint64_t* bitmap = (uint64_t*)calloc(ROARING_BITMAP_WORDS, sizeof(uint64_t));
+    if (bitmap == NULL) return -1;
+    for (uint32_t i = 0; i < c->cardinality; i++) {
+        uint16_t v = c->data.array[i];
+        bitmap[v / BITSET_WORD_BITS] |= 1ULL << (v % BITSET_WORD_BITS);
+    }
+    free(c->data.array);
+    c->type = ROARING_BITMAP;
+    c->capacity = 0;
+    c->data.bitmap = bitmap;
+    return 0;
+}
+
+static inline int roaring_bitmap_to_array_(RoaringContainer* c) {
+    uint32_t capacity = c->cardinality ? c->cardinality : 1;
+    uint16_t* array = (uint16_t*)malloc(capacity * sizeof(uint16_t));
+    if (array == NULL) return -1;
+    uint32_t n = 0;
+    for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) {
+        for (uint64_t bits = c->data.bitmap[w]; bits; bits &= bits - 1) {
+            array[n++] = (uint16_t)(w * BITSET_WORD_BITS + (uint32_t)__builtin_ctzll(bits));
+        }
+    }
+    free(c->data.bitmap);
+    c->type = ROARING_ARRAY;
+    c->capacity = capacity;
+    c->data.array = array;
+    return 0;
+}
+
+// Demote a bitmap that has become sparse. Staying a bitmap is always correct, so
+// an allocation failure here is not an error.
+static inline void roaring_shrink_(RoaringContainer* c) {
+    if (c->type == ROARING_BITMAP && c->cardinality <= ROARING_ARRAY_MAX) roaring_bitmap_to_array_(c);
+}
+
+static inline void roaring_remove_container_(RoaringBitmap* r, size_t idx) {
+    roaring_container_free_(&r->containers[idx]);
+    memmove(&r->containers[idx], &r->containers[idx + 1],
+            (r->count - idx - 1) * sizeof(RoaringContainer));
+    r->count--;
+}
+
+static inline int roaring_reserve_(RoaringBitmap* r, size_t count) {
+    if (count <= r->capacity) return 0;
+    size_t capacity = r->capacity ? r->capacity * 2 : 4;
+    if (capacity < count) capacity = count;
+    RoaringContainer* c = (RoaringContainer*)realloc(r->containers, capacity * sizeof(RoaringContainer));
+    if (c == NULL) return -1;
+    r->containers = c;
+    r->capacity = capacity;
+    return 0;
+}
+
+static inline int roaring_contains(const RoaringBitmap* r, uint32_t value) {
+    ptrdiff_t idx = roaring_find_key_(r, (uint16_t)(value >> 16));
+    if (idx < 0) return 0;
+    const RoaringContainer* c = &r->containers[idx];
+    uint16_t low = (uint16_t)value;
+    if (c->type == ROARING_BITMAP) return (int)((c->data.bitmap[low / BITSET_WORD_BITS] >> (low % BITSET_WORD_BITS)) & 1);
+    uint32_t pos = roaring_array_search_(c->data.array, c->cardinality, low);
+    return pos < c->cardinality && c->data.array[pos] == low;
+}
+
+// Add a value; adding one that is already present is a no-op.
+static inline int roaring_add(RoaringBitmap* r, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    uint16_t low = (uint16_t)value;
+    ptrdiff_t idx = roaring_find_key_(r, key);
+
+    if (idx < 0) {
+        size_t at = (size_t)(-idx - 1);
+        uint16_t* array = (uint16_t*)malloc(4 * sizeof(uint16_t));
+        if (array == NULL || roaring_reserve_(r, r->count + 1) != 0) {
+            free(array);
+            return -1;
+        }
+        memmove(&r->containers[at + 1], &r->containers[at], (r->count - at) * sizeof(RoaringContainer));
+        RoaringContainer* c = &r->containers[at];
+        c->key = key;
+        c->type = ROARING_ARRAY;
+        c->cardinality = 1;
+        c->capacity = 4;
+        c->data.array = array;
+        array[0] = low;
+        r->count++;
+        return 0;
+    }
+
+    RoaringContainer* c = &r->containers[idx];
+    if (c->type == ROARING_ARRAY) {
+        uint32_t pos = roaring_array_search_(c->data.array, c->cardinality, low);
+        if (pos < c->cardinality && c->data.array[pos] == low) return 0;
+        if (c->cardinality == ROARING_ARRAY_MAX) {
+            if (roaring_array_to_bitmap_(c) != 0) return -1;
+        } else {
+            if (c->cardinality == c->capacity) {
+                uint32_t capacity = c->capacity * 2 > ROARING_ARRAY_MAX ? ROARING_ARRAY_MAX : c->capacity * 2;
+                uint16_t* array = (uint16_t*)realloc(c->data.array, capacity * sizeof(uint16_t));
+                if (array == NULL) return -1;
+                c->data.array = array;
+                c->capacity = capacity;
+            }
+            memmove(&c->data.array[pos + 1], &c->data.array[pos], (c->cardinality - pos) * sizeof(uint16_t));
+            c->data.array[pos] = low;
+            c->cardinality++;
+            return 0;
+        }
+    }
+
+    uint64_t* word = &c->data.bitmap[low / BITSET_WORD_BITS];
+    uint64_t bit = 1ULL << (low % BITSET_WORD_BITS);
+    if (!(*word & bit)) {
+        *word |= bit;
+        c->cardinality++;
+    }
+    return 0;
+}
+
+// Remove a value; returns 1 if it was present, 0 otherwise.
+static inline int roaring_remove(RoaringBitmap* r, uint32_t value) {
+    ptrdiff_t idx = roaring_find_key_(r, (uint16_t)(value >> 16));
+    if (idx < 0) return 0;
+    RoaringContainer* c = &r->containers[idx];
+    uint16_t low = (uint16_t)value;
+
+    if (c->type == ROARING_ARRAY) {
+        uint32_t pos = roaring_array_search_(c->data.array, c->cardinality, low);
+        if (pos >= c->cardinality || c->data.array[pos] != low) return 0;
+        memmove(&c->data.array[pos], &c->data.array[pos + 1], (c->cardinality - pos - 1) * sizeof(uint16_t));
+        c->cardinality--;
+    } else {
+        uint64_t* word = &c->data.bitmap[low / BITSET_WORD_BITS];
+        uint64_t bit = 1ULL << (low % BITSET_WORD_BITS);
+        if (!(*word & bit)) return 0;
+        *word &= ~bit;
+        c->cardinality--;
+        roaring_shrink_(c);
+    }
+    if (c->cardinality == 0) roaring_remove_container_(r, (size_t)idx);
+    return 1;
+}
+
+static inline size_t roaring_cardinality(const RoaringBitmap* r) {
+    size_t total = 0;
+    for (size_t i = 0; i < r->count; i++) total += r->containers[i].cardinality;
+    return total;
+}
+
+static inline size_t roaring_memory_bytes(const RoaringBitmap* r) {
+    size_t bytes = sizeof(*r) + r->capacity * sizeof(RoaringContainer);
+    for (size_t i = 0; i < r->count; i++) {
+        const RoaringContainer* c = &r->containers[i];
+        bytes += c->type == ROARING_ARRAY ? c->capacity * sizeof(uint16_t)
+                                          : ROARING_BITMAP_WORDS * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+// dst &= src for one pair of containers with the same key. The result may be empty;
+// the caller drops it in that case.
+static inline void roaring_container_and_(RoaringContainer* dst, const RoaringContainer* src) {
+    if (dst->type == ROARING_ARRAY) {
+        uint32_t n = 0;
+        if (src->type == ROARING_ARRAY) {
+            // Linear merge, written over dst's own array (the output never overtakes the input)
+            uint32_t i = 0, j = 0;
+            while (i < dst->cardinality && j < src->cardinality) {
+                uint16_t a = dst->data.array[i], b = src->data.array[j];
+                if (a == b) { dst->data.array[n++] = a; i++; j++; }
+                else if (a < b) i++;
+                else j++;
+            }
+        } else {
+            for (uint32_t i = 0; i < dst->cardinality; i++) {
+                uint16_t v = dst->data.array[i];
+                dst->data.array[n] = v;
+                n += (uint32_t)((src->data.bitmap[v / BITSET_WORD_BITS] >> (v % BITSET_WORD_BITS)) & 1);
+            }
+        }
+        dst->cardinality = n;
+        return;
+    }
+
+    if (src->type == ROARING_ARRAY) {
+        // bitmap & array: keep the array's values that are in the bitmap, in place
+        // in the bitmap's words, then shrink (the result has at most 4096 values)
+        uint64_t* bitmap = dst->data.bitmap;
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < src->cardinality; i++) {
+            uint16_t v = src->data.array[i];
+            n += (uint32_t)((bitmap[v / BITSET_WORD_BITS] >> (v % BITSET_WORD_BITS)) & 1);
+        }
+        for (uint32_t w = 0, i = 0; w < ROARING_BITMAP_WORDS; w++) {
+            uint64_t keep = 0;
+            while (i < src->cardinality && src->data.array[i] / BITSET_WORD_BITS == w) {
+                keep |= 1ULL << (src->data.array[i] % BITSET_WORD_BITS);
+                i++;
+            }
+            bitmap[w] &= keep;
+        }
+        dst->cardinality = n;
+    } else {
+        for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) dst->data.bitmap[w] &= src->data.bitmap[w];
+        dst->cardinality = (uint32_t)popcount_array(dst->data.bitmap, ROARING_BITMAP_WORDS);
+    }
+    if (dst->cardinality) roaring_shrink_(dst);
+}
+
+// dst &= src
+static inline void roaring_and(RoaringBitmap* dst, const RoaringBitmap* src) {
+    size_t out = 0, j = 0;
+    for (size_t i = 0; i < dst->count; i++) {
+        RoaringContainer* c = &dst->containers[i];
+        while (j < src->count && src->containers[j].key < c->key) j++;
+        if (j < src->count && src->containers[j].key == c->key) {
+            roaring_container_and_(c, &src->containers[j]);
+        } else {
+            c->cardinality = 0;
+        }
+        if (c->cardinality == 0) {
+            roaring_container_free_(c);
+        } else {
+            dst->containers[out++] = *c;
+        }
+    }
+    dst->count = out;
+}
+
+static inline int roaring_container_copy_(RoaringContainer* dst, const RoaringContainer* src) {
+    *dst = *src;
+    if (src->type == ROARING_ARRAY) {
+        dst->capacity = src->cardinality;
+        dst->data.array = (uint16_t*)malloc(src->cardinality * sizeof(uint16_t));
+        if (dst->data.array == NULL) return -1;
+        memcpy(dst->data.array, src->data.array, src->cardinality * sizeof(uint16_t));
+    } else {
+        dst->data.bitmap = (uint64_t*)malloc(ROARING_BITMAP_WORDS * sizeof(uint64_t));
+        if (dst->data.bitmap == NULL) return -1;
+        memcpy(dst->data.bitmap, src->data.bitmap, ROARING_BITMAP_WORDS * sizeof(uint64_t));
+    }
+    return 0;
+}
+
+// out = a | b for one pair of containers with the same key; a and b are untouched.
+static inline int roaring_container_or_(RoaringContainer* out, const RoaringContainer* a,
+                                        const RoaringContainer* b) {
+    if (a->type == ROARING_ARRAY && b->type == ROARING_ARRAY &&
+        a->cardinality + b->cardinality <= ROARING_ARRAY_MAX) {
+        uint32_t capacity = a->cardinality + b->cardinality;
+        uint16_t* array = (uint16_t*)malloc(capacity * sizeof(uint16_t));
+        if (array == NULL) return -1;
+        uint32_t i = 0, j = 0, n = 0;
+        while (i < a->cardinality && j < b->cardinality) {
+            uint16_t x = a->data.array[i], y = b->data.array[j];
+            array[n++] = x <= y ? x : y;
+            i += x <= y;
+            j += y <= x;
+        }
+        while (i < a->cardinality) array[n++] = a->data.array[i++];
+        while (j < b->cardinality) array[n++] = b->data.array[j++];
+        out->key = a->key;
+        out->type = ROARING_ARRAY;
+        out->cardinality = n;
+        out->capacity = capacity;
+        out->data.array = array;
+        return 0;
+    }
+
+    // Otherwise the result goes into a bitmap
+    uint64_t* bitmap = (uint64_t*)calloc(ROARING_BITMAP_WORDS, sizeof(uint64_t));
+    if (bitmap == NULL) return -1;
+    const RoaringContainer* parts[2] = {a, b};
+    for (int p = 0; p < 2; p++) {
+        const RoaringContainer* c = parts[p];
+        if (c->type == ROARING_BITMAP) {
+            for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) bitmap[w] |= c->data.bitmap[w];
+        } else {
+            for (uint32_t i = 0; i < c->cardinality; i++) {
+                uint16_t v = c->data.array[i];
+                bitmap[v / BITSET_WORD_BITS] |= 1ULL << (v % BITSET_WORD_BITS);
+            }
+        }
+    }
+    out->key = a->key;
+    out->type = ROARING_BITMAP;
+    out->cardinality = (uint32_t)popcount_array(bitmap, ROARING_BITMAP_WORDS);
+    out->capacity = 0;
+    out->data.bitmap = bitmap;
+    roaring_shrink_(out);  // Two overlapping arrays can still fit in one
+    return 0;
+}
+
+// dst |= src. The result is built in a new container list and swapped in, so dst
+// is unchanged if an allocation fails.
+static inline int roaring_or(RoaringBitmap* dst, const RoaringBitmap* src) {
+    size_t max = dst->count + src->count;
+    if (max == 0) return 0;
+    RoaringContainer* merged = (RoaringContainer*)malloc(max * sizeof(RoaringContainer));
+    unsigned char* fresh = (unsigned char*)malloc(max);  // 1: allocated here, 0: moved from dst
+    if (merged == NULL || fresh == NULL) {
+        free(merged);
+        free(fresh);
+        return -1;
+    }
+
+    size_t i = 0, j = 0, n = 0;
+    int failed = 0;
+    while (!failed && (i < dst->count || j < src->count)) {
+        if (j >= src->count || (i < dst->count && dst->containers[i].key < src->containers[j].key)) {
+            merged[n] = dst->containers[i++];
+            fresh[n] = 0;
+        } else if (i >= dst->count || src->containers[j].key < dst->containers[i].key) {
+            failed = roaring_container_copy_(&merged[n], &src->containers[j++]) != 0;
+            fresh[n] = 1;
+        } else {
+            failed = roaring_container_or_(&merged[n], &dst->containers[i++], &src->containers[j++]) != 0;
+            fresh[n] = 1;
+        }
+        if (!failed) n++;
+    }
+
+    if (failed) {
+        for (size_t k = 0; k < n; k++) {
+            if (fresh[k]) roaring_container_free_(&merged[k]);
+        }
+        free(merged);
+        free(fresh);
+        return -1;
+    }
+
+    // Free the dst containers that were replaced by a merged copy. Every dst key is
+    // in 'merged', in the same order.
+    for (size_t d = 0, k = 0; d < dst->count; d++, k++) {
+        while (merged[k].key != dst->containers[d].key) k++;
+        if (fresh[k]) roaring_container_free_(&dst->containers[d]);
+    }
+    free(fresh);
+    free(dst->containers);
+    dst->containers = merged;
+    dst->count = n;
+    dst->capacity = max;
+    return 0;
+}
+
+// Iteration in increasing order:
+//     RoaringIter it;
+//     uint32_t v;
+//     roaring_iter_init(&it, &r);
+//     while (roaring_iter_next(&it, &v)) { ... }
+typedef struct {
+    const RoaringBitmap* bitmap;
+    size_t container;
+    uint32_t pos;              // Array index, or bitmap word
+    uint64_t bits;             // Remaining bits of the current bitmap word
+} RoaringIter;
+
+static inline void roaring_iter_init(RoaringIter* it, const RoaringBitmap* r) {
+    it->bitmap = r;
+    it->container = 0;
+    it->pos = 0;
+    it->bits = (r->count && r->containers[0].type == ROARING_BITMAP) ? r->containers[0].data.bitmap[0] : 0;
+}
+
+static inline int roaring_iter_next(RoaringIter* it, uint32_t* value) {
+    const RoaringBitmap* r = it->bitmap;
+    while (it->container < r->count) {
+        const RoaringContainer* c = &r->containers[it->container];
+        uint32_t high = (uint32_t)c->key << 16;
+        if (c->type == ROARING_ARRAY) {
+            if (it->pos < c->cardinality) {
+                *value = high | c->data.array[it->pos++];
+                return 1;
+            }
+        } else {
+            while (it->bits == 0 && ++it->pos < ROARING_BITMAP_WORDS) it->bits = c->data.bitmap[it->pos];
+            if (it->bits != 0) {
+                *value = high | (it->pos * BITSET_WORD_BITS + (uint32_t)__builtin_ctzll(it->bits));
+                it->bits &= it->bits - 1;
+                return 1;
+            }
+        }
+        // Next container
+        it->container++;
+        it->pos = 0;
+        it->bits = 0;
+        if (it->container < r->count && r->containers[it->container].type == ROARING_BITMAP) {
+            it->bits = r->containers[it->container].data.bitmap[0];
+        }
+    }
+    return 0;
+}
+
+// Expand into a dense bitset (grown to cover the largest value), e.g. to evaluate
+// a filter with word-wide boolean operations.
+static inline int roaring_to_bitset(const RoaringBitmap* r, Bitset* bs) {
+    bitset_clear_all(bs);
+    if (r->count == 0) return 0;
+    const RoaringContainer* last = &r->containers[r->count - 1];
+    size_t top = ((size_t)last->key << 16) + 65536;
+    if (top > bs->nbits && bitset_resize(bs, top) != 0) return -1;
+    for (size_t i = 0; i < r->count; i++) {
+        const RoaringContainer* c = &r->containers[i];
+        uint64_t* words = bs->words + ((size_t)c->key << 16) / BITSET_WORD_BITS;
+        if (c->type == ROARING_BITMAP) {
+            memcpy(words, c->data.bitmap, ROARING_BITMAP_WORDS * sizeof(uint64_t));
+        } else {
+            for (uint32_t k = 0; k < c->cardinality; k++) {
+                uint16_t v = c->data.array[k];
+                words[v / BITSET_WORD_BITS] |= 1ULL << (v % BITSET_WORD_BITS);
+            }
+        }
+    }
+    return 0;
+}
+
+#endif // BITSET_H
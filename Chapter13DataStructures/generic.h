@@ -0,0 +1,222 @@
+/*
+generic.h - Type-Specialised Containers and Algorithms via Macro Templates
+================================================
+
+qsort(), bsearch() and the void* containers built on them call back through a
+function pointer for every comparison or element operation, and that call cannot
+be inlined. The macros here generate a separate copy of the code for each
+element type, the way a C++ template instantiation does. The comparison or
+operation is then an ordinary expression the compiler inlines and vectorises.
+
+    DEFINE_VECTOR(int)                   // Vector_int, vector_int_push(), ...
+    DEFINE_SORT(int, GENERIC_LESS)       // int_sort(), int_lower_bound(), int_binary_search()
+    DEFINE_FOLD(int_sum, int, GENERIC_ADD)
+
+    Vector_int v;
+    vector_int_init(&v);
+    if (vector_int_push(&v, 42) != 0) ...   // -1 with errno = ENOMEM
+    int_sort(v.data, v.size);
+    size_t i = int_binary_search(v.data, v.size, 42);   // GENERIC_NPOS if absent
+    int total = int_sum(v.data, v.size, 0);
+    vector_int_destroy(&v);
+
+Design:
+- T must be a single identifier because it is pasted into the generated names.
+  Typedef pointer or multi-word types first (typedef unsigned long ulong;).
+  DEFINE_SORT_NAMED(name, T, LESS) picks another prefix, which is needed to give
+  one type several orderings.
+- LESS(a, b) and OP(a, b) receive two values of type T. They can be macros or
+  static inline functions; either way they are inlined into the generated loop.
+  LESS must be a strict weak ordering, written with < rather than <=.
+- The sort is the introsort from Chapter14Algorithms/sort.h (SORT_DEFINE). The
+  lower bound is its branchless form from search.h, generalised to any T.
+- A vector stores T by value in one contiguous array and doubles its capacity
+  when it fills, so push is amortised O(1). data and size are public and meant
+  to be read directly; data moves when the vector grows. The growth factor,
+  the allocator and mremap growth for huge buffers are configured through
+  vector_T_init_with() with the types from vector.h, whose counters
+  (v.control.stats) record every resize and the bytes it copied.
+- Instantiate each macro once per type and translation unit: everything is
+  static inline, like the rest of the headers in this repository.
+*/
+
+#ifndef GENERIC_H
+#define GENERIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "../Chapter14Algorithms/sort.h"
+#include "vector.h"
+
+#define GENERIC_NPOS ((size_t)-1)
+
+#define GENERIC_LESS(a, b) ((a) < (b))
+#define GENERIC_GREATER(a, b) ((a) > (b))
+#define GENERIC_ADD(a, b) ((a) + (b))
+#define GENERIC_MIN(a, b) ((b) < (a) ? (b) : (a))
+#define GENERIC_MAX(a, b) ((a) < (b) ? (b) : (a))
+
+// ---------------------------------------------------------------------------
+// Vector
+// ---------------------------------------------------------------------------
+
+#define DEFINE_VECTOR(T)                                                                   \
+    typedef struct {                                                                       \
+        T* data;                                                                           \
+        size_t size;                                                                       \
+        size_t capacity;                                                                   \
+        VectorControl control;                                                             \
+    } Vector_##T;                                                                          \
+                                                                                           \
+    /* policy and allocator may be NULL for the defaults (see vector.h) */                 \
+    static inline void vector_##T##_init_with(Vector_##T* v, const VectorPolicy* policy,   \
+                                              const VectorAllocator* allocator) {          \
+        v->data = NULL;                                                                    \
+        v->size = 0;                                                                       \
+        v->capacity = 0;                                                                   \
+        vector_control_init(&v->control, policy, allocator);                               \
+    }                                                                                      \
+                                                                                           \
+    static inline void vector_##T##_init(Vector_##T* v) {                                  \
+        vector_##T##_init_with(v, NULL, NULL);                                             \
+    }                                                                                      \
+                                                                                           \
+    /* Frees the buffer. The policy, allocator and stats are kept for reuse */             \
+    static inline void vector_##T##_destroy(Vector_##T* v) {                               \
+        vector_control_release(&v->control, v->data, v->capacity * sizeof(T));             \
+        v->data = NULL;                                                                    \
+        v->size = 0;                                                                       \
+        v->capacity = 0;                                                                   \
+    }                                                                                      \
+                                                                                           \
+    static inline int vector_##T##_resize_(Vector_##T* v, size_t capacity) {               \
+        void* data = v->data;                                                              \
+        if (vector_control_resize(&v->control, &data, &v->capacity, v->size, sizeof(T),    \
+                                  capacity) != 0) {                                        \
+            return -1;                                                                     \
+        }                                                                                  \
+        v->data = (T*)data;                                                                \
+        return 0;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    /* Grows capacity to at least 'capacity'. -1 with errno = ENOMEM on failure */         \
+    static inline int vector_##T##_reserve(Vector_##T* v, size_t capacity) {               \
+        if (capacity <= v->capacity) return 0;                                             \
+        return vector_##T##_resize_(v, capacity);                                          \
+    }                                                                                      \
+                                                                                           \
+    /* Gives back the capacity beyond size (huge buffers keep whole pages) */              \
+    static inline int vector_##T##_shrink_to_fit(Vector_##T* v) {                          \
+        if (v->size == v->capacity) return 0;                                              \
+        return vector_##T##_resize_(v, v->size);                                           \
+    }                                                                                      \
+                                                                                           \
+    static inline int vector_##T##_grow_(Vector_##T* v, size_t extra) {                    \
+        if (extra > SIZE_MAX - v->size) {                                                  \
+            errno = ENOMEM;                                                                \
+            return -1;                                                                     \
+        }                                                                                  \
+        size_t need = v->size + extra;                                                     \
+        size_t capacity = vector_control_next_capacity(&v->control, v->capacity, need);    \
+        return vector_##T##_reserve(v, capacity);                                          \
+    }                                                                                      \
+                                                                                           \
+    static inline int vector_##T##_push(Vector_##T* v, T value) {                          \
+        if (v->size == v->capacity && vector_##T##_grow_(v, 1) != 0) return -1;            \
+        v->data[v->size++] = value;                                                        \
+        return 0;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    /* Bulk push: at most one resize for all n items */                                    \
+    static inline int vector_##T##_append(Vector_##T* v, const T* items, size_t n) {       \
+        if (v->capacity - v->size < n && vector_##T##_grow_(v, n) != 0) return -1;         \
+        for (size_t i = 0; i < n; i++) v->data[v->size + i] = items[i];                    \
+        v->size += n;                                                                      \
+        return 0;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    /* Adds n uninitialised elements and returns the first, or NULL (ENOMEM) */            \
+    static inline T* vector_##T##_extend(Vector_##T* v, size_t n) {                        \
+        if (v->capacity - v->size < n && vector_##T##_grow_(v, n) != 0) return NULL;       \
+        v->size += n;                                                                      \
+        return v->data + (v->size - n);                                                    \
+    }                                                                                      \
+                                                                                           \
+    /* The vector must not be empty */                                                     \
+    static inline T vector_##T##_pop(Vector_##T* v) {                                      \
+        return v->data[--v->size];                                                         \
+    }                                                                                      \
+                                                                                           \
+    static inline void vector_##T##_clear(Vector_##T* v) {                                 \
+        v->size = 0;                                                                       \
+    }
+
+// ---------------------------------------------------------------------------
+// Sorting and searching
+// ---------------------------------------------------------------------------
+
+// Generates name##_sort, name##_is_sorted, name##_lower_bound, name##_upper_bound
+// and name##_binary_search for arrays of T ordered by LESS.
+#define DEFINE_SORT_NAMED(name, T, LESS)                                                   \
+    SORT_DEFINE(name##_sort, T, LESS)                                                      \
+                                                                                           \
+    static inline int name##_is_sorted(const T* a, size_t n) {                             \
+        for (size_t i = 1; i < n; i++) {                                                   \
+            if (LESS(a[i], a[i - 1])) return 0;                                            \
+        }                                                                                  \
+        return 1;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    /* First index whose element is not LESS than key, or n */                            \
+    static inline size_t name##_lower_bound(const T* a, size_t n, T key) {                 \
+        if (n == 0) return 0;                                                              \
+        const T* base = a;                                                                 \
+        while (n > 1) {                                                                    \
+            size_t half = n / 2;                                                           \
+            base += (size_t)(LESS(base[half], key) != 0) * half;                           \
+            n -= half;                                                                     \
+        }                                                                                  \
+        return (size_t)(base - a) + (LESS(*base, key) != 0);                               \
+    }                                                                                      \
+                                                                                           \
+    /* First index whose element key is LESS than, or n */                                \
+    static inline size_t name##_upper_bound(const T* a, size_t n, T key) {                 \
+        if (n == 0) return 0;                                                              \
+        const T* base = a;                                                                 \
+        while (n > 1) {                                                                    \
+            size_t half = n / 2;                                                           \
+            base += (size_t)(LESS(key, base[half]) == 0) * half;                           \
+            n -= half;                                                                     \
+        }                                                                                  \
+        return (size_t)(base - a) + (LESS(key, *base) == 0);                               \
+    }                                                                                      \
+                                                                                           \
+    /* Index of an element equivalent to key, or GENERIC_NPOS */                           \
+    static inline size_t name##_binary_search(const T* a, size_t n, T key) {               \
+        size_t i = name##_lower_bound(a, n, key);                                          \
+        return i < n && !LESS(key, a[i]) ? i : GENERIC_NPOS;                               \
+    }
+
+#define DEFINE_SORT(T, LESS) DEFINE_SORT_NAMED(T, T, LESS)
+
+// ---------------------------------------------------------------------------
+// Element-wise algorithms
+// ---------------------------------------------------------------------------
+
+// T name(const T* a, size_t n, T init): init OP a[0] OP a[1] ... from the left.
+#define DEFINE_FOLD(name, T, OP)                                                           \
+    static inline T name(const T* a, size_t n, T init) {                                   \
+        T acc = init;                                                                      \
+        for (size_t i = 0; i < n; i++) acc = OP(acc, a[i]);                                \
+        return acc;                                                                        \
+    }
+
+// void name(const T* in, T* out, size_t n): out[i] = FN(in[i]). in may equal out.
+#define DEFINE_TRANSFORM(name, T, FN)                                                      \
+    static inline void name(const T* in, T* out, size_t n) {                               \
+        for (size_t i = 0; i < n; i++) out[i] = FN(in[i]);                                 \
+    }
+
+#endif // GENERIC_H
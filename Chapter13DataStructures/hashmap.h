@@ -0,0 +1,382 @@
+/*
+hashmap.h - Open-Addressing Hash Maps with SIMD Group Probing
+================================================
+
+A Swiss-table style hash map, instantiated per key and value type like the
+containers in generic.h. There is no void* and no callback: HASH and EQ are
+inlined into the probe loop.
+
+    static inline uint64_t id_hash(uint64_t id) { return hashmap_hash_u64(id); }
+    DEFINE_HASHMAP(person_map, uint64_t, Person, id_hash, HASHMAP_EQ)
+
+    HashMap_person_map people;
+    person_map_init(&people);
+    if (person_map_insert(&people, 42, alice) < 0) ...     // 1 added, 0 replaced, -1 ENOMEM
+    Person* p = person_map_find(&people, 42);               // NULL if absent
+    person_map_insert_bulk(&people, ids, records, n);       // One resize, prefetched
+    person_map_erase(&people, 42);
+    for (size_t i = person_map_next(&people, 0); i < people.capacity; i = person_map_next(&people, i + 1))
+        visit(people.keys[i], &people.values[i]);
+    person_map_destroy(&people);
+
+Design:
+- Structure of arrays: one control byte per slot, then all keys, then all
+  values, in a single allocation. A probe reads control bytes and compares only
+  keys whose byte matches, so large records are touched once, on the hit.
+- A control byte is EMPTY (0x80), DELETED (0xFE), or the low 7 bits of the key
+  hash for a full slot. A probe loads 16 control bytes and compares all of them
+  against those 7 bits with SSE2 (pcmpeqb + pmovmskb). Only about 1 in 128
+  non-matching keys reaches EQ. Without SSE2 the same masks are built with a
+  plain loop.
+- The remaining hash bits pick the starting slot. Probing moves by 16, 32,
+  48... slots (triangular over groups), which visits every group of a power of
+  two table. The first HASHMAP_GROUP control bytes are mirrored after the end,
+  so a group can start at any slot without wrapping.
+- The table is at most 7/8 full. Erase writes DELETED only when a probe could
+  have passed the slot; otherwise the slot becomes EMPTY again. When
+  tombstones use up the free slots but the table is at most half full, the
+  next insert calls name_rehash(), which re-places the elements without
+  allocating. Otherwise the table doubles.
+- HASH must mix all bits of the key: the low 7 bits and the high bits are used
+  separately. hashmap_hash_u64() and hashmap_hash_bytes() are suitable. Plain
+  identity hashing of small integers is not.
+- K and V are copied by value and need no destructor. Pointers returned by
+  name_find() and indices from name_next() are valid until the next insert.
+*/
+
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HASHMAP_GROUP 16
+#define HASHMAP_BATCH 16                         // Hashes computed ahead in insert_bulk
+#define HASHMAP_NPOS ((size_t)-1)
+#define HASHMAP_EMPTY ((int8_t)-128)
+#define HASHMAP_DELETED ((int8_t)-2)
+#define HASHMAP_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+#define HASHMAP_EQ(a, b) ((a) == (b))
+#define HASHMAP_STR_EQ(a, b) (strcmp((a), (b)) == 0)
+
+static inline uint64_t hashmap_hash_u64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+}
+
+static inline uint64_t hashmap_hash_bytes(const void* data, size_t n) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ ((uint64_t)n * 0xFF51AFD7ED558CCDull);
+    while (n >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+        p += 8;
+        n -= 8;
+    }
+    uint64_t w = 0;
+    memcpy(&w, p, n);
+    return hashmap_hash_u64(h ^ w);
+}
+
+static inline uint64_t hashmap_hash_str(const char* s) {
+    return hashmap_hash_bytes(s, strlen(s));
+}
+
+static inline size_t hashmap_round_up_(size_t n) {
+    return (n + 63) & ~(size_t)63;
+}
+
+// Bit i of each mask refers to ctrl[i], for the 16 control bytes at 'ctrl'.
+#if defined(__SSE2__)
+static inline unsigned hashmap_match_(const int8_t* ctrl, int8_t h2) {
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+}
+
+static inline unsigned hashmap_match_empty_(const int8_t* ctrl) {
+    return hashmap_match_(ctrl, HASHMAP_EMPTY);
+}
+
+// EMPTY or DELETED: the control bytes below -1
+static inline unsigned hashmap_match_free_(const int8_t* ctrl) {
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+}
+#else
+static inline unsigned hashmap_match_(const int8_t* ctrl, int8_t h2) {
+    unsigned mask = 0;
+    for (int i = 0; i < HASHMAP_GROUP; i++) mask |= (unsigned)(ctrl[i] == h2) << i;
+    return mask;
+}
+
+static inline unsigned hashmap_match_empty_(const int8_t* ctrl) {
+    return hashmap_match_(ctrl, HASHMAP_EMPTY);
+}
+
+static inline unsigned hashmap_match_free_(const int8_t* ctrl) {
+    unsigned mask = 0;
+    for (int i = 0; i < HASHMAP_GROUP; i++) mask |= (unsigned)(ctrl[i] < -1) << i;
+    return mask;
+}
+#endif
+
+// Generates HashMap_##name mapping K to V, and name##_init, _destroy, _reserve,
+// _insert, _insert_bulk, _find, _contains, _erase, _rehash, _clear and _next.
+// HASH(K) returns uint64_t; EQ(K, K) returns nonzero for equal keys.
+#define DEFINE_HASHMAP(name, K, V, HASH, EQ)                                                              \
+    typedef struct {                                                                                      \
+        int8_t* ctrl;        /* capacity + HASHMAP_GROUP bytes; the tail mirrors the head */              \
+        K* keys;                                                                                          \
+        V* values;                                                                                        \
+        size_t capacity;     /* 0 or a power of two >= HASHMAP_GROUP */                                   \
+        size_t size;                                                                                      \
+        size_t growth_left;  /* EMPTY slots that may still be filled before rehashing */                  \
+    } HashMap_##name;                                                                                     \
+                                                                                                          \
+    static inline void name##_init(HashMap_##name* m) {                                                   \
+        m->ctrl = NULL;                                                                                   \
+        m->keys = NULL;                                                                                   \
+        m->values = NULL;                                                                                 \
+        m->capacity = 0;                                                                                  \
+        m->size = 0;                                                                                      \
+        m->growth_left = 0;                                                                               \
+    }                                                                                                     \
+                                                                                                          \
+    static inline void name##_destroy(HashMap_##name* m) {                                                \
+        free(m->ctrl);                                                                                    \
+        name##_init(m);                                                                                   \
+    }                                                                                                     \
+                                                                                                          \
+    static inline void name##_set_ctrl_(HashMap_##name* m, size_t i, int8_t c) {                          \
+        m->ctrl[i] = c;                                                                                   \
+        if (i < HASHMAP_GROUP) m->ctrl[m->capacity + i] = c;                                              \
+    }                                                                                                     \
+                                                                                                          \
+    /* Slot of 'key', or HASHMAP_NPOS */                                                                  \
+    static inline size_t name##_find_index_(const HashMap_##name* m, K key, uint64_t hash) {              \
+        if (m->capacity == 0) return HASHMAP_NPOS;                                                        \
+        size_t mask = m->capacity - 1;                                                                    \
+        size_t pos = (size_t)(hash >> 7) & mask;                                                          \
+        int8_t h2 = (int8_t)(hash & 0x7F);                                                                \
+        for (size_t step = HASHMAP_GROUP;; step += HASHMAP_GROUP) {                                       \
+            unsigned candidates = hashmap_match_(m->ctrl + pos, h2);                                      \
+            while (candidates != 0) {                                                                     \
+                size_t i = (pos + (size_t)__builtin_ctz(candidates)) & mask;                              \
+                if (EQ(m->keys[i], key)) return i;                                                        \
+                candidates &= candidates - 1;                                                             \
+            }                                                                                             \
+            if (hashmap_match_empty_(m->ctrl + pos) != 0) return HASHMAP_NPOS;                            \
+            pos = (pos + step) & mask;                                                                    \
+        }                                                                                                 \
+    }                                                                                                     \
+                                                                                                          \
+    /* First EMPTY or DELETED slot on the probe sequence of 'hash' */                                     \
+    static inline size_t name##_find_free_(const HashMap_##name* m, uint64_t hash) {                      \
+        size_t mask = m->capacity - 1;                                                                    \
+        size_t pos = (size_t)(hash >> 7) & mask;                                                          \
+        for (size_t step = HASHMAP_GROUP;; step += HASHMAP_GROUP) {                                       \
+            unsigned free_slots = hashmap_match_free_(m->ctrl + pos);                                     \
+            if (free_slots != 0) return (pos + (size_t)__builtin_ctz(free_slots)) & mask;                 \
+            pos = (pos + step) & mask;                                                                    \
+        }                                                                                                 \
+    }                                                                                                     \
+                                                                                                          \
+    static inline int name##_allocate_(HashMap_##name* m, size_t capacity) {                              \
+        size_t keys_at = hashmap_round_up_(capacity + HASHMAP_GROUP);                                     \
+        size_t values_at = keys_at + hashmap_round_up_(capacity * sizeof(K));                             \
+        char* block = (char*)malloc(values_at + capacity * sizeof(V));                                    \
+        if (block == NULL) {                                                                              \
+            errno = ENOMEM;                                                                               \
+            return -1;                                                                                    \
+        }                                                                                                 \
+        m->ctrl = (int8_t*)block;                                                                         \
+        m->keys = (K*)(block + keys_at);                                                                  \
+        m->values = (V*)(block + values_at);                                                              \
+        m->capacity = capacity;                                                                           \
+        m->growth_left = HASHMAP_MAX_LOAD(capacity);                                                      \
+        memset(m->ctrl, HASHMAP_EMPTY, capacity + HASHMAP_GROUP);                                         \
+        return 0;                                                                                         \
+    }                                                                                                     \
+                                                                                                          \
+    /* Moves every element into a table of 'capacity' slots */                                            \
+    static inline int name##_resize_(HashMap_##name* m, size_t capacity) {                                \
+        HashMap_##name old = *m;                                                                          \
+        if (name##_allocate_(m, capacity) != 0) {                                                         \
+            *m = old;                                                                                     \
+            return -1;                                                                                    \
+        }                                                                                                 \
+        for (size_t i = 0; i < old.capacity; i++) {                                                       \
+            if (old.ctrl[i] < 0) continue;                                                                \
+            uint64_t hash = HASH(old.keys[i]);                                                            \
+            size_t slot = name##_find_free_(m, hash);                                                     \
+            name##_set_ctrl_(m, slot, (int8_t)(hash & 0x7F));                                             \
+            m->keys[slot] = old.keys[i];                                                                  \
+            m->values[slot] = old.values[i];                                                              \
+        }                                                                                                 \
+        m->growth_left -= old.size;                                                                       \
+        free(old.ctrl);                                                                                   \
+        return 0;                                                                                         \
+    }                                                                                                     \
+                                                                                                          \
+    /* Drops every DELETED slot without allocating: live elements are re-placed   */                      \
+    /* within the table, swapping with not-yet-placed ones when needed.           */                      \
+    static inline void name##_rehash(HashMap_##name* m) {                                                 \
+        if (m->capacity == 0) return;                                                                     \
+        size_t mask = m->capacity - 1;                                                                    \
+        for (size_t i = 0; i < m->capacity; i++) {                                                        \
+            m->ctrl[i] = m->ctrl[i] < 0 ? HASHMAP_EMPTY : HASHMAP_DELETED;                                \
+        }                                                                                                 \
+        memcpy(m->ctrl + m->capacity, m->ctrl, HASHMAP_GROUP);                                            \
+        for (size_t i = 0; i < m->capacity; i++) {                                                        \
+            if (m->ctrl[i] != HASHMAP_DELETED) continue;                                                  \
+            uint64_t hash = HASH(m->keys[i]);                                                             \
+            size_t home = (size_t)(hash >> 7) & mask;                                                     \
+            size_t slot = name##_find_free_(m, hash);                                                     \
+            size_t group_now = ((i - home) & mask) / HASHMAP_GROUP;                                       \
+            size_t group_free = ((slot - home) & mask) / HASHMAP_GROUP;                                   \
+            if (group_now == group_free) {                                                                \
+                name##_set_ctrl_(m, i, (int8_t)(hash & 0x7F)); /* Already in the right group */           \
+            } else if (m->ctrl[slot] == HASHMAP_EMPTY) {                                                  \
+                name##_set_ctrl_(m, slot, (int8_t)(hash & 0x7F));                                         \
+                m->keys[slot] = m->keys[i];                                                               \
+                m->values[slot] = m->values[i];                                                           \
+                name##_set_ctrl_(m, i, HASHMAP_EMPTY);                                                    \
+            } else {                                                                                      \
+                K key = m->keys[slot];                                                                    \
+                V value = m->values[slot];                                                                \
+                name##_set_ctrl_(m, slot, (int8_t)(hash & 0x7F));                                         \
+                m->keys[slot] = m->keys[i];                                                               \
+                m->values[slot] = m->values[i];                                                           \
+                m->keys[i] = key;                                                                         \
+                m->values[i] = value;                                                                     \
+                i--;  /* Place the displaced element next */                                              \
+            }                                                                                             \
+        }                                                                                                 \
+        m->growth_left = HASHMAP_MAX_LOAD(m->capacity) - m->size;                                         \
+    }                                                                                                     \
+                                                                                                          \
+    /* Makes room for 'count' elements in total without another rehash */                                 \
+    static inline int name##_reserve(HashMap_##name* m, size_t count) {                                   \
+        if (count <= m->size + m->growth_left) return 0;                                                  \
+        if (count > (SIZE_MAX / 2) / (sizeof(K) + sizeof(V) + 1)) {                                       \
+            errno = ENOMEM;                                                                               \
+            return -1;                                                                                    \
+        }                                                                                                 \
+        size_t capacity = HASHMAP_GROUP;                                                                  \
+        while (HASHMAP_MAX_LOAD(capacity) < count) capacity *= 2;                                         \
+        return name##_resize_(m, capacity);                                                               \
+    }                                                                                                     \
+                                                                                                          \
+    /* Called when no EMPTY slot may be filled: reclaim tombstones, or grow */                            \
+    static inline int name##_grow_(HashMap_##name* m) {                                                   \
+        if (m->capacity != 0 && m->size <= HASHMAP_MAX_LOAD(m->capacity) / 2) {                           \
+            name##_rehash(m);                                                                             \
+            return 0;                                                                                     \
+        }                                                                                                 \
+        return name##_resize_(m, m->capacity ? m->capacity * 2 : HASHMAP_GROUP);                          \
+    }                                                                                                     \
+                                                                                                          \
+    static inline int name##_insert_hashed_(HashMap_##name* m, K key, V value, uint64_t hash) {           \
+        size_t i = name##_find_index_(m, key, hash);                                                      \
+        if (i != HASHMAP_NPOS) {                                                                          \
+            m->values[i] = value;                                                                         \
+            return 0;                                                                                     \
+        }                                                                                                 \
+        size_t slot = m->capacity ? name##_find_free_(m, hash) : 0;                                       \
+        if (m->capacity == 0 || (m->growth_left == 0 && m->ctrl[slot] == HASHMAP_EMPTY)) {                \
+            if (name##_grow_(m) != 0) return -1;                                                          \
+            slot = name##_find_free_(m, hash);                                                            \
+        }                                                                                                 \
+        if (m->ctrl[slot] == HASHMAP_EMPTY) m->growth_left--;                                             \
+        name##_set_ctrl_(m, slot, (int8_t)(hash & 0x7F));                                                 \
+        m->keys[slot] = key;                                                                              \
+        m->values[slot] = value;                                                                          \
+        m->size++;                                                                                        \
+        return 1;                                                                                         \
+    }                                                                                                     \
+                                                                                                          \
+    /* 1 if the key was added, 0 if its value was replaced, -1 (ENOMEM) on failure */                     \
+    static inline int name##_insert(HashMap_##name* m, K key, V value) {                                  \
+        return name##_insert_hashed_(m, key, value, HASH(key));                                           \
+    }                                                                                                     \
+                                                                                                          \
+    /* Inserts keys[i] -> values[i] for i < n. The table is sized once, and the  */                       \
+    /* hashes of each batch are computed and their groups prefetched before any  */                       \
+    /* of the batch is inserted. Returns 0, or -1 (ENOMEM) with a prefix inserted */                      \
+    static inline int name##_insert_bulk(HashMap_##name* m, const K* keys, const V* values, size_t n) {   \
+        if (n > SIZE_MAX - m->size || name##_reserve(m, m->size + n) != 0) {                              \
+            errno = ENOMEM;                                                                               \
+            return -1;                                                                                    \
+        }                                                                                                 \
+        uint64_t hashes[HASHMAP_BATCH];                                                                   \
+        for (size_t base = 0; base < n; base += HASHMAP_BATCH) {                                          \
+            size_t count = n - base < HASHMAP_BATCH ? n - base : HASHMAP_BATCH;                           \
+            for (size_t j = 0; j < count; j++) {                                                          \
+                hashes[j] = HASH(keys[base + j]);                                                         \
+                __builtin_prefetch(m->ctrl + ((size_t)(hashes[j] >> 7) & (m->capacity - 1)));             \
+            }                                                                                             \
+            for (size_t j = 0; j < count; j++) {                                                          \
+                if (name##_insert_hashed_(m, keys[base + j], values[base + j], hashes[j]) < 0) {          \
+                    return -1;                                                                            \
+                }                                                                                         \
+            }                                                                                             \
+        }                                                                                                 \
+        return 0;                                                                                         \
+    }                                                                                                     \
+                                                                                                          \
+    /* Pointer to the value stored for 'key', or NULL. Valid until the next insert */                     \
+    static inline V* name##_find(const HashMap_##name* m, K key) {                                        \
+        size_t i = name##_find_index_(m, key, HASH(key));                                                 \
+        return i == HASHMAP_NPOS ? NULL : &m->values[i];                                                  \
+    }                                                                                                     \
+                                                                                                          \
+    static inline int name##_contains(const HashMap_##name* m, K key) {                                   \
+        return name##_find_index_(m, key, HASH(key)) != HASHMAP_NPOS;                                     \
+    }                                                                                                     \
+                                                                                                          \
+    /* 1 if the key was removed, 0 if it was not present */                                               \
+    static inline int name##_erase(HashMap_##name* m, K key) {                                            \
+        size_t i = name##_find_index_(m, key, HASH(key));                                                 \
+        if (i == HASHMAP_NPOS) return 0;                                                                  \
+        /* A probe stops at the first group holding an EMPTY slot. If every 16-slot   */                  \
+        /* window that covers i already has one, no probe can pass i and it may turn  */                  \
+        /* EMPTY again; otherwise it must stay a DELETED tombstone.                   */                  \
+        size_t before = (i - HASHMAP_GROUP) & (m->capacity - 1);                                          \
+        unsigned empty_after = hashmap_match_empty_(m->ctrl + i);                                         \
+        unsigned empty_before = hashmap_match_empty_(m->ctrl + before);                                   \
+        int never_full = empty_after != 0 && empty_before != 0 &&                                         \
+                         __builtin_ctz(empty_after) + (__builtin_clz(empty_before) - 16) < HASHMAP_GROUP; \
+        name##_set_ctrl_(m, i, never_full ? HASHMAP_EMPTY : HASHMAP_DELETED);                             \
+        m->growth_left += (size_t)never_full;                                                             \
+        m->size--;                                                                                        \
+        return 1;                                                                                         \
+    }                                                                                                     \
+                                                                                                          \
+    /* Keeps the capacity */                                                                              \
+    static inline void name##_clear(HashMap_##name* m) {                                                  \
+        if (m->capacity == 0) return;                                                                     \
+        memset(m->ctrl, HASHMAP_EMPTY, m->capacity + HASHMAP_GROUP);                                      \
+        m->size = 0;                                                                                      \
+        m->growth_left = HASHMAP_MAX_LOAD(m->capacity);                                                   \
+    }                                                                                                     \
+                                                                                                          \
+    /* First occupied slot at or after i, or capacity. Iterate with               */                      \
+    /* for (i = name_next(m, 0); i < m->capacity; i = name_next(m, i + 1))        */                      \
+    static inline size_t name##_next(const HashMap_##name* m, size_t i) {                                 \
+        while (i < m->capacity && m->ctrl[i] < 0) i++;                                                    \
+        return i;                                                                                         \
+    }
+
+#endif // HASHMAP_H
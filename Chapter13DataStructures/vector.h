@@ -0,0 +1,344 @@
+/*
+vector.h - Growth Policies, Allocators and Move Accounting for DEFINE_VECTOR
+================================================
+
+The typed vectors from generic.h keep their elements in one buffer that is
+resized as they grow. This header holds the part of a vector that does not
+depend on the element type: the growth policy, where the buffer comes from,
+and counters for what each resize cost.
+
+    VectorPolicy policy = vector_policy_default();
+    policy.growth_num = 3;                     // Grow by 1.5x instead of 2x
+    policy.growth_den = 2;
+
+    Vector_int v;
+    vector_int_init_with(&v, &policy, NULL);   // NULL: malloc/realloc/free
+    vector_int_reserve(&v, 1000);
+    int* slots = vector_int_extend(&v, n);     // n writable slots, one resize at most
+    vector_int_shrink_to_fit(&v);
+    printf("%llu copies, %llu bytes copied\n",
+           (unsigned long long)v.control.stats.moves,
+           (unsigned long long)v.control.stats.bytes_copied);
+
+    Arena arena;                               // Or a SizeClassPool, or your own
+    VectorAllocator from_arena;
+    vector_arena_allocator(&from_arena, &arena);
+
+Design:
+- Capacity grows by growth_num / growth_den (2/1 by default), starting at
+  min_capacity elements. Any factor above 1 keeps push amortised O(1); a
+  smaller factor wastes less memory and copies more often.
+- Buffers of at least huge_bytes (1 MB by default) get their own anonymous
+  mapping. Growing them uses mremap(MREMAP_MAYMOVE): the kernel moves page
+  table entries instead of bytes, so a multi-GB vector grows in microseconds.
+  The first crossing of the threshold copies the (at most huge_bytes) heap
+  buffer once. Mapped capacity is rounded up to whole pages. mremap is Linux
+  only; elsewhere huge_bytes is ignored. It is called through syscall(), so
+  _GNU_SOURCE is not needed.
+- realloc may move a heap buffer at any size. glibc itself serves large
+  blocks with mmap and grows them with mremap, but its threshold adapts
+  upward (to 32 MB on 64-bit) after the first large free, after which buffers
+  of tens of MB are memcpy'd again.
+- A VectorAllocator resizes and releases blocks for one vector; it is told
+  the used byte count so it copies only live elements.
+  vector_arena_allocator() extends the arena's newest allocation in place
+  and otherwise copies into fresh arena memory (old blocks are reclaimed
+  when the arena is reset). vector_pool_allocator() takes small buffers
+  from a SizeClassPool and is defined when pool_alloc.h is included first.
+  Huge mappings bypass the allocator.
+- VectorStats counts every capacity change: moves (the buffer was copied,
+  and how many bytes) and remaps (mremap, nothing copied). A realloc that
+  returns the same address counts as neither; one that returns a new address
+  counts as a copy of the old block, even if glibc remapped it.
+- Functions that allocate return 0, or -1 with errno = ENOMEM.
+*/
+
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../Chapter15AdvancedMemoryManagement/arena.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(SYS_mremap)
+#define VECTOR_HAVE_MREMAP 1
+#endif
+#endif
+
+#define VECTOR_DEFAULT_MIN_CAPACITY 8
+#define VECTOR_DEFAULT_HUGE_BYTES ((size_t)1 << 20)
+#define VECTOR_MREMAP_MAYMOVE_ 1           // MREMAP_MAYMOVE from <linux/mman.h>
+
+typedef struct {
+    unsigned growth_num;       // New capacity = old * growth_num / growth_den (> 1)
+    unsigned growth_den;
+    size_t min_capacity;       // Elements in the first allocation
+    size_t huge_bytes;         // Buffers this large live in their own mapping; 0 = never
+} VectorPolicy;
+
+typedef struct {
+    uint64_t resizes;          // Capacity changes of any kind
+    uint64_t moves;            // Resizes that copied the buffer to a new address
+    uint64_t bytes_copied;     // Bytes those copies moved
+    uint64_t remaps;           // Resizes done with mremap
+    uint64_t bytes_remapped;   // Live bytes the remaps moved without copying
+} VectorStats;
+
+typedef struct {
+    const char* name;
+    // Return a block of new_bytes (> 0) holding the first used_bytes of ptr, or
+    // NULL with ptr untouched. ptr may be NULL with old_bytes == 0. *copied gets
+    // the number of bytes memcpy'd, 0 if the block was resized in place.
+    void* (*resize)(void* ctx, void* ptr, size_t old_bytes, size_t used_bytes, size_t new_bytes, size_t* copied);
+    void (*release)(void* ctx, void* ptr, size_t bytes);
+    void* ctx;
+} VectorAllocator;
+
+typedef struct {
+    VectorPolicy policy;
+    const VectorAllocator* allocator;   // NULL: malloc/realloc/free
+    VectorStats stats;
+    int mapped;                          // The buffer is a huge mapping
+    size_t mapped_bytes;                 // Its length as mapped; capacity * elem_size may be less
+} VectorControl;
+
+static inline VectorPolicy vector_policy_default(void) {
+    VectorPolicy policy = {2, 1, VECTOR_DEFAULT_MIN_CAPACITY, VECTOR_DEFAULT_HUGE_BYTES};
+    return policy;
+}
+
+// policy and allocator may be NULL for the defaults; allocator must outlive the vector.
+static inline void vector_control_init(VectorControl* c, const VectorPolicy* policy, const VectorAllocator* allocator) {
+    memset(c, 0, sizeof(*c));
+    c->policy = policy ? *policy : vector_policy_default();
+    if (c->policy.growth_den == 0 || c->policy.growth_num <= c->policy.growth_den) {
+        c->policy.growth_num = 2;
+        c->policy.growth_den = 1;
+    }
+    if (c->policy.min_capacity == 0) c->policy.min_capacity = 1;
+    c->allocator = allocator;
+}
+
+// Smallest capacity on the growth sequence from 'capacity' that holds 'need'.
+static inline size_t vector_control_next_capacity(const VectorControl* c, size_t capacity, size_t need) {
+    const size_t num = c->policy.growth_num, den = c->policy.growth_den;
+    size_t next = capacity ? capacity : c->policy.min_capacity;
+    while (next < need) {
+        if (next > (SIZE_MAX - den) / num) return need;
+        size_t grown = (next * num + den - 1) / den;
+        next = grown > next ? grown : next + 1;
+    }
+    return next;
+}
+
+// ----- Heap -----
+
+static inline void* vector_heap_resize_(void* ctx, void* ptr, size_t old_bytes, size_t used_bytes, size_t new_bytes,
+                                        size_t* copied) {
+    (void)ctx;
+    (void)used_bytes;
+    void* p = realloc(ptr, new_bytes);
+    // realloc copies the whole old block when it moves
+    *copied = (p != NULL && ptr != NULL && p != ptr) ? (old_bytes < new_bytes ? old_bytes : new_bytes) : 0;
+    return p;
+}
+
+static inline void vector_heap_release_(void* ctx, void* ptr, size_t bytes) {
+    (void)ctx;
+    (void)bytes;
+    free(ptr);
+}
+
+static const VectorAllocator vector_heap_allocator_ = {"heap", vector_heap_resize_, vector_heap_release_, NULL};
+
+// ----- Huge mappings -----
+
+#ifdef VECTOR_HAVE_MREMAP
+
+static inline size_t vector_page_round_(size_t bytes) {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return bytes > SIZE_MAX - page ? 0 : (bytes + page - 1) / page * page;
+}
+
+// Resize a huge buffer to at least new_bytes; returns the mapped size, 0 on failure.
+static inline size_t vector_map_resize_(VectorControl* c, void** data, size_t old_bytes, size_t used_bytes,
+                                        size_t new_bytes) {
+    const size_t mapped = vector_page_round_(new_bytes);
+    if (mapped == 0) return 0;
+    if (c->mapped && mapped == c->mapped_bytes) return mapped;  // Same pages
+    if (c->mapped) {
+        long p = syscall(SYS_mremap, *data, c->mapped_bytes, mapped, VECTOR_MREMAP_MAYMOVE_);
+        if (p == -1) return 0;
+        c->stats.remaps++;
+        c->stats.bytes_remapped += used_bytes;
+        c->mapped_bytes = mapped;
+        *data = (void*)p;
+        return mapped;
+    }
+    void* p = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return 0;
+    if (used_bytes) memcpy(p, *data, used_bytes);
+    if (*data != NULL) {
+        const VectorAllocator* a = c->allocator ? c->allocator : &vector_heap_allocator_;
+        a->release(a->ctx, *data, old_bytes);
+        c->stats.moves++;
+        c->stats.bytes_copied += used_bytes;
+    }
+    c->mapped = 1;
+    c->mapped_bytes = mapped;
+    *data = p;
+    return mapped;
+}
+
+#endif // VECTOR_HAVE_MREMAP
+
+// ----- Resizing -----
+
+static inline void vector_control_release(VectorControl* c, void* data, size_t bytes) {
+    if (data == NULL) return;
+#ifdef VECTOR_HAVE_MREMAP
+    if (c->mapped) {
+        munmap(data, c->mapped_bytes);   // Not 'bytes': capacity rounds the mapping down
+        c->mapped = 0;
+        c->mapped_bytes = 0;
+        return;
+    }
+#endif
+    const VectorAllocator* a = c->allocator ? c->allocator : &vector_heap_allocator_;
+    a->release(a->ctx, data, bytes);
+}
+
+// Change the capacity of *data from *capacity to about 'want' elements of
+// elem_size bytes (want >= size; 0 frees the buffer). The first size elements
+// are kept. Mapped buffers may end up with more capacity than asked for.
+static inline int vector_control_resize(VectorControl* c, void** data, size_t* capacity, size_t size,
+                                        size_t elem_size, size_t want) {
+    if (want == *capacity) return 0;
+    if (want > SIZE_MAX / elem_size) {
+        errno = ENOMEM;
+        return -1;
+    }
+    const size_t old_bytes = *capacity * elem_size, used = size * elem_size, new_bytes = want * elem_size;
+    if (want == 0) {
+        vector_control_release(c, *data, old_bytes);
+        *data = NULL;
+        *capacity = 0;
+        c->stats.resizes++;
+        return 0;
+    }
+#ifdef VECTOR_HAVE_MREMAP
+    if (c->mapped || (c->policy.huge_bytes && new_bytes >= c->policy.huge_bytes)) {
+        size_t mapped = vector_map_resize_(c, data, old_bytes, used, new_bytes);
+        if (mapped == 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if (mapped / elem_size != *capacity) c->stats.resizes++;
+        *capacity = mapped / elem_size;
+        return 0;
+    }
+#endif
+    const VectorAllocator* a = c->allocator ? c->allocator : &vector_heap_allocator_;
+    size_t copied = 0;
+    void* p = a->resize(a->ctx, *data, old_bytes, used, new_bytes, &copied);
+    if (p == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    c->stats.resizes++;
+    if (copied) {
+        c->stats.moves++;
+        c->stats.bytes_copied += copied;
+    }
+    *data = p;
+    *capacity = want;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Allocator adapters
+// ---------------------------------------------------------------------------
+
+// The block ends where the arena's current chunk is filled to
+static inline int vector_arena_is_last_(Arena* arena, void* ptr, size_t bytes) {
+    ArenaChunk* chunk = arena->current;
+    return chunk != NULL && (char*)ptr + bytes == arena_chunk_data_(chunk) + chunk->used;
+}
+
+static inline void* vector_arena_resize_(void* ctx, void* ptr, size_t old_bytes, size_t used_bytes, size_t new_bytes,
+                                         size_t* copied) {
+    Arena* arena = (Arena*)ctx;
+    *copied = 0;
+    if (ptr != NULL && vector_arena_is_last_(arena, ptr, old_bytes)) {
+        size_t offset = (size_t)((char*)ptr - arena_chunk_data_(arena->current));
+        if (arena->current->capacity - offset >= new_bytes) {
+            arena->current->used = offset + new_bytes;  // Grow or shrink in place
+            return ptr;
+        }
+    }
+    void* p = arena_alloc(arena, new_bytes);
+    if (p == NULL) return NULL;
+    if (used_bytes) memcpy(p, ptr, used_bytes);
+    *copied = used_bytes;
+    return p;
+}
+
+// Only the newest allocation can be given back; the rest waits for arena_reset()
+static inline void vector_arena_release_(void* ctx, void* ptr, size_t bytes) {
+    Arena* arena = (Arena*)ctx;
+    if (vector_arena_is_last_(arena, ptr, bytes)) arena->current->used -= bytes;
+}
+
+static inline void vector_arena_allocator(VectorAllocator* a, Arena* arena) {
+    a->name = "arena";
+    a->resize = vector_arena_resize_;
+    a->release = vector_arena_release_;
+    a->ctx = arena;
+}
+
+#ifdef POOL_ALLOC_H
+
+static inline int vector_pool_same_class_(const SizeClassPool* sp, size_t a, size_t b) {
+    if (a > POOL_MAX_CLASS_SIZE || b > POOL_MAX_CLASS_SIZE) return 0;
+    return sp->class_of[(a + 15) / 16] == sp->class_of[(b + 15) / 16];
+}
+
+static inline void* vector_pool_resize_(void* ctx, void* ptr, size_t old_bytes, size_t used_bytes, size_t new_bytes,
+                                        size_t* copied) {
+    SizeClassPool* sp = (SizeClassPool*)ctx;
+    *copied = 0;
+    if (ptr != NULL && vector_pool_same_class_(sp, old_bytes, new_bytes)) return ptr;
+    if (ptr != NULL && old_bytes > POOL_MAX_CLASS_SIZE && new_bytes > POOL_MAX_CLASS_SIZE) {
+        return vector_heap_resize_(NULL, ptr, old_bytes, used_bytes, new_bytes, copied);  // Both from malloc
+    }
+    void* p = size_class_pool_alloc(sp, new_bytes);
+    if (p == NULL) return NULL;
+    if (ptr != NULL) {
+        if (used_bytes) memcpy(p, ptr, used_bytes);
+        *copied = used_bytes;
+        size_class_pool_free(sp, ptr, old_bytes);
+    }
+    return p;
+}
+
+static inline void vector_pool_release_(void* ctx, void* ptr, size_t bytes) {
+    size_class_pool_free((SizeClassPool*)ctx, ptr, bytes);
+}
+
+static inline void vector_pool_allocator(VectorAllocator* a, SizeClassPool* pool) {
+    a->name = "pool";
+    a->resize = vector_pool_resize_;
+    a->release = vector_pool_release_;
+    a->ctx = pool;
+}
+
+#endif // POOL_ALLOC_H
+
+#endif // VECTOR_H
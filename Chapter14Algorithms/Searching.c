@@ -0,0 +1,457 @@
+/*
+Cheat Sheet: Fast Searching in Sorted Arrays
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+Binary search does O(log n) comparisons. On modern CPUs the comparison count
+usually isn't what limits it. Two other costs are:
+
+- Branch mispredictions. Whether the search goes left or right is a coin flip,
+  so a branchy search mispredicts about every second level. Each misprediction
+  throws away 15-20 cycles of work.
+- Cache misses. Once the array outgrows the cache, every level below the top
+  few is a miss to RAM (~80 ns), and each step must wait for the previous
+  load, because the next address depends on it.
+
+The variants in search.h attack these costs in turn. The branchless search
+removes the mispredictions. Prefetching both candidate midpoints starts the next
+load early. The Eytzinger (BFS-order) layout keeps the hot top of the tree in a
+few cache lines and makes four levels of descendants share one line. A SIMD
+linear count beats all of them on tiny arrays. Batching many independent
+searches lets their cache misses overlap.
+
+Historical context:
+- Binary search was described by John Mauchly in 1946. Knuth notes it took until
+  1962 for a bug-free version to be published.
+- In 1590 Michaël Eytzinger used the BFS numbering for genealogy tables; it is
+  the layout of the binary heap (Williams, 1964).
+- Khuong and Morin's "Array Layouts for Comparison-Based Searching" (2017)
+  measured branchless and Eytzinger search on modern hardware.
+
+The implementation lives in search.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "search.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// Function prototypes
+void lower_bound_example();
+void eytzinger_layout_example();
+void simd_small_array_example();
+void batch_search_example();
+void performance_comparison();
+
+int main() {
+    printf("Fast Searching Cheat Sheet\n");
+    printf("==========================\n\n");
+
+    lower_bound_example();
+    eytzinger_layout_example();
+    simd_small_array_example();
+    batch_search_example();
+    performance_comparison();
+
+    return 0;
+}
+
+// Chapter4Functions/recursion.c, unchanged: exact match, -1 when absent
+int binary_search(int arr[], int left, int right, int x) {
+    if (right >= left) {
+        int mid = left + (right - left) / 2;
+        if (arr[mid] == x)
+            return mid;
+        if (arr[mid] > x)
+            return binary_search(arr, left, mid - 1, x);
+        return binary_search(arr, mid + 1, right, x);
+    }
+    return -1;
+}
+
+void lower_bound_example() {
+    printf("2.1 Lower Bound, Branchy and Branchless\n");
+    printf("----------------------------------------\n");
+
+    int32_t a[] = {2, 3, 3, 3, 10, 40, 41, 90};
+    size_t n = sizeof(a) / sizeof(a[0]);
+    int32_t keys[] = {1, 3, 4, 40, 90, 100};
+    // The lower bound is where the key would be inserted: the first a[i] >= key.
+    // Unlike an exact-match search it is well defined for duplicates and misses.
+    for (int i = 0; i < 6; i++) {
+        size_t lb = search_lower_bound(a, n, keys[i]);
+        size_t lb2 = search_lower_bound_branchless(a, n, keys[i]);
+        int found = lb < n && a[lb] == keys[i];
+        printf("key %3d -> index %zu (%s)%s\n", keys[i], lb, found ? "found" : "insert here",
+               lb == lb2 ? "" : "  MISMATCH");
+    }
+    printf("\n");
+}
+
+void eytzinger_layout_example() {
+    printf("2.2 Eytzinger (BFS-Order) Layout\n");
+    printf("---------------------------------\n");
+
+    int32_t a[15];
+    for (int i = 0; i < 15; i++) a[i] = (i + 1) * 10;
+    SearchIndex idx;
+    if (search_index_init(&idx, a, 15, SEARCH_EYTZINGER) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    printf("Sorted:    ");
+    for (int i = 0; i < 15; i++) printf(" %d", a[i]);
+    printf("\nEytzinger: ");
+    for (int k = 1; k <= 15; k++) printf(" %d", idx.eytz[k]);
+    printf("\n");
+    // The root (80) is the median, then the quartiles (40, 120), and so on: the
+    // first levels every search visits are packed at the front.
+    printf("Searching 75: lower bound index %zu, value %d\n\n", search_index_lower_bound(&idx, 75),
+           a[search_index_lower_bound(&idx, 75)]);
+    search_index_destroy(&idx);
+}
+
+void simd_small_array_example() {
+    printf("2.3 SIMD Lower Bound for Small Arrays\n");
+    printf("--------------------------------------\n");
+
+    int32_t a[32];
+    for (int i = 0; i < 32; i++) a[i] = i * i;
+    // No branches at all: compare every element with the key and count the hits
+    printf("First square >= 200 is at index %zu (%d)\n", search_lower_bound_simd(a, 32, 200),
+           a[search_lower_bound_simd(a, 32, 200)]);
+
+    SearchIndex idx;
+    search_index_init(&idx, a, 32, SEARCH_AUTO);  // Small: picks the linear SIMD scan
+    printf("SEARCH_AUTO on 32 elements uses layout %d (SEARCH_LINEAR_SIMD = %d)\n\n", idx.layout,
+           SEARCH_LINEAR_SIMD);
+    search_index_destroy(&idx);
+}
+
+void batch_search_example() {
+    printf("2.4 Batched Lookups Through SearchIndex\n");
+    printf("----------------------------------------\n");
+
+    size_t n = 1u << 20;
+    int32_t* a = (int32_t*)malloc(n * sizeof(int32_t));
+    if (a == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    for (size_t i = 0; i < n; i++) a[i] = (int32_t)(3 * i);
+
+    SearchIndex idx;
+    if (search_index_init(&idx, a, n, SEARCH_AUTO) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(a);
+        return;
+    }
+    int32_t keys[] = {0, 7, 3000, 3145725, 3145726, -5};
+    size_t out[6];
+    search_index_lower_bound_batch(&idx, keys, 6, out);  // All six searches interleaved
+    printf("Layout chosen for %zu keys: %s\n", n, idx.layout == SEARCH_EYTZINGER ? "Eytzinger" : "other");
+    for (int i = 0; i < 6; i++) printf("  lower bound of %7d = %zu\n", keys[i], out[i]);
+    printf("\n");
+    search_index_destroy(&idx);
+    free(a);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Return the lower bound, not "found or -1". Membership, insertion points and
+   range queries all fall out of it.
+2. Batch independent lookups. With SEARCH_BATCH_LANES in flight, the memory
+   system works on up to 16 misses at once instead of one.
+3. Build the Eytzinger copy once for a read-mostly array, and rebuild it after
+   updates.
+
+Common Pitfalls:
+1. mid = (lo + hi) / 2 overflows for large arrays. Use lo + (hi - lo) / 2, as
+   recursion.c does, or the base/len form of the branchless search.
+2. Recursion is unnecessary: the search is tail recursive, and an iterative
+   search needs no stack at all.
+3. Checking a[mid] == key first adds a third, usually mispredicted, outcome per
+   level.
+
+Advanced Tips:
+1. Look at the assembly (gcc -O2 -S): the branchless loop should contain a
+   cmov or setcc, not a conditional jump on the comparison.
+2. perf stat -e branch-misses,cache-misses shows which cost dominates at each
+   array size.
+3. For arrays of a few hundred keys, the linear SIMD count beats every
+   logarithmic search.
+
+4. Integration and Real-World Applications
+==========================================
+- Databases and key-value stores: searching sorted runs (SSTables) and B-tree nodes.
+- Networking: longest-prefix match and sorted range tables.
+- Time series: finding the first sample after a timestamp.
+- Compilers and debuggers: address -> symbol lookup via sorted tables.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- B-tree layouts (S-trees) with SIMD node search: one cache line per level.
+- Learned indexes predict a key's position with a small model, then search a
+  narrow window around the guess.
+- Interpolation search on uniformly distributed keys: O(log log n) steps.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why is the branchless version slower on my machine for mid-size arrays?
+A: When the array fits in L1/L2, a branchy search can speculate past a load it is
+   waiting for. Measure both at your sizes.
+
+Q: Why does the Eytzinger index need more memory?
+A: It copies the keys in BFS order and keeps a 4-byte slot -> rank table so it
+   can return positions in the sorted array.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- "Array Layouts for Comparison-Based Searching" (Khuong & Morin, 2017)
+- Knuth, "The Art of Computer Programming", Vol. 3, section 6.2.1
+- Algorithmica, "Eytzinger Binary Search" and "Static B-Trees" (Slotin)
+- perf and Intel VTune for branch-miss and cache-miss counts
+
+8. Performance Analysis and Optimization
+========================================
+The benchmark runs 512K random lookups against sorted int arrays from 1K
+elements up to 2^27 (512 MB), and reports ns per lookup. 2^27 is the default cap
+because the largest Eytzinger index needs three copies of the array. Set
+SEARCH_BENCH_MAX_LOG2 up to 30 (1G elements, 12 GB) on machines with the RAM.
+The L1/L2 sizes show up as steps in the columns.
+
+A first suite covers 16 to 512 elements, where the SEARCH_AUTO thresholds in
+search.h come from.
+*/
+
+#define SEARCH_BENCH_QUERIES (1u << 19)
+
+typedef enum {
+    BENCH_RECURSIVE,
+    BENCH_BRANCHY,
+    BENCH_BRANCHLESS,
+    BENCH_SIMD,
+    BENCH_EYTZINGER,
+    BENCH_BRANCHLESS_BATCH,
+    BENCH_EYTZINGER_BATCH
+} SearchBenchKind;
+
+typedef struct {
+    const int32_t* a;
+    size_t n;
+    const SearchIndex* branchless;
+    const SearchIndex* eytzinger;
+    const int32_t* keys;
+    size_t* out;
+    SearchBenchKind kind;
+} SearchBench;
+
+void search_bench_run(void* ctx) {
+    SearchBench* b = (SearchBench*)ctx;
+    size_t sum = 0;
+    switch (b->kind) {
+        case BENCH_RECURSIVE:
+            for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) {
+                sum += (size_t)binary_search((int*)b->a, 0, (int)b->n - 1, b->keys[j]);
+            }
+            break;
+        case BENCH_BRANCHY:
+            for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) sum += search_lower_bound(b->a, b->n, b->keys[j]);
+            break;
+        case BENCH_BRANCHLESS:
+            for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) {
+                sum += search_lower_bound_branchless(b->a, b->n, b->keys[j]);
+            }
+            break;
+        case BENCH_SIMD:
+            for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) {
+                sum += b->branchless->count_less(b->a, b->n, b->keys[j]);
+            }
+            break;
+        case BENCH_EYTZINGER:
+            for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) {
+                sum += search_index_lower_bound(b->eytzinger, b->keys[j]);
+            }
+            break;
+        case BENCH_BRANCHLESS_BATCH:
+        case BENCH_EYTZINGER_BATCH: {
+            const SearchIndex* idx = b->kind == BENCH_EYTZINGER_BATCH ? b->eytzinger : b->branchless;
+            search_index_lower_bound_batch(idx, b->keys, SEARCH_BENCH_QUERIES, b->out);
+            for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j += 4096) sum += b->out[j];
+            break;
+        }
+    }
+    BENCH_DO_NOT_OPTIMIZE(sum);
+}
+
+static int search_bench_max_log2(void) {
+    const char* s = getenv("SEARCH_BENCH_MAX_LOG2");
+    int v = s != NULL ? atoi(s) : 27;
+    if (v < 10 || v > 30) {
+        fprintf(stderr, "ignoring SEARCH_BENCH_MAX_LOG2=%s (10..30)\n", s);
+        v = 27;
+    }
+    return v;
+}
+
+// One cell of the summary table; a negative median marks a skipped case
+static void print_ns(double median_ns) {
+    if (median_ns < 0) {
+        printf("%12s", "-");
+    } else {
+        printf("%12.1f", median_ns / SEARCH_BENCH_QUERIES);
+    }
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    static const int sizes_log2[] = {10, 13, 16, 20, 24, 27, 28, 29, 30};
+    int max_log2 = search_bench_max_log2();
+    int32_t* keys = (int32_t*)malloc(SEARCH_BENCH_QUERIES * sizeof(int32_t));
+    size_t* out = (size_t*)malloc(SEARCH_BENCH_QUERIES * sizeof(size_t));
+    if (keys == NULL || out == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(keys);
+        free(out);
+        return;
+    }
+
+    static const char* names[] = {"recursive binary_search", "branchy lower bound", "branchless + prefetch",
+                                  "linear SIMD count",       "Eytzinger + prefetch", "branchless, batched",
+                                  "Eytzinger, batched"};
+
+    // Small arrays: the linear SIMD count against the logarithmic searches
+    static const size_t small_sizes[] = {16, 32, 64, 128, 256, 512};
+    static char small_names[6][3][40];
+    BenchSuite small;
+    bench_suite_init(&small, "512K lookups, arrays of 16..512 keys");
+    int32_t small_array[512];
+    for (int i = 0; i < 512; i++) small_array[i] = i * 8;
+    for (size_t s = 0; s < 6; s++) {
+        size_t n = small_sizes[s];
+        SearchIndex branchless, eytzinger;
+        if (search_index_init(&branchless, small_array, n, SEARCH_BRANCHLESS) != 0 ||
+            search_index_init(&eytzinger, small_array, n, SEARCH_EYTZINGER) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            break;
+        }
+        uint32_t x = 88675123u;
+        for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            keys[j] = (int32_t)(x % (8 * n + 8));
+        }
+        SearchBenchKind kinds[3] = {BENCH_BRANCHLESS, BENCH_SIMD, BENCH_EYTZINGER};
+        for (int c = 0; c < 3; c++) {
+            snprintf(small_names[s][c], sizeof(small_names[s][c]), "n=%zu %s", n, names[kinds[c]]);
+            SearchBench bench = {small_array, n, &branchless, &eytzinger, keys, out, kinds[c]};
+            bench_suite_run(&small, small_names[s][c], search_bench_run, &bench, SEARCH_BENCH_QUERIES);
+        }
+        search_index_destroy(&branchless);
+        search_index_destroy(&eytzinger);
+    }
+    bench_suite_report(&small);
+    printf("\n");
+
+    static char titles[9][64];
+    double table[9][7];
+    int rows = 0;
+    for (size_t s = 0; s < sizeof(sizes_log2) / sizeof(sizes_log2[0]) && sizes_log2[s] <= max_log2; s++) {
+        size_t n = (size_t)1 << sizes_log2[s];
+        int32_t* a = (int32_t*)malloc(n * sizeof(int32_t));
+        SearchIndex branchless, eytzinger;
+        if (a == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            break;
+        }
+        // Evenly spaced keys over the whole int32 range; random queries hit about
+        // 1 in (2^32 / n) elements exactly
+        uint64_t stride = ((uint64_t)1 << 32) / n;
+        for (size_t i = 0; i < n; i++) a[i] = (int32_t)(INT32_MIN + (int64_t)(i * stride));
+        uint32_t x = 2463534242u;
+        for (size_t j = 0; j < SEARCH_BENCH_QUERIES; j++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            // Every fourth query is a hit, the rest fall between elements
+            keys[j] = (j & 3) == 0 ? a[x & (n - 1)] : (int32_t)x;
+        }
+        if (search_index_init(&branchless, a, n, SEARCH_BRANCHLESS) != 0 ||
+            search_index_init(&eytzinger, a, n, SEARCH_EYTZINGER) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            free(a);
+            break;
+        }
+
+        snprintf(titles[s], sizeof(titles[s]), "512K lookups, n = 2^%d", sizes_log2[s]);
+        BenchSuite suite;
+        bench_suite_init(&suite, titles[s]);
+        const BenchResult* results[7] = {NULL};
+        for (int kind = 0; kind < 7; kind++) {
+            if (kind == BENCH_SIMD && n > 4096) continue;  // O(n) per lookup
+            SearchBench bench = {a, n, &branchless, &eytzinger, keys, out, (SearchBenchKind)kind};
+            results[kind] = bench_suite_run(&suite, names[kind], search_bench_run, &bench, SEARCH_BENCH_QUERIES);
+        }
+        bench_suite_report(&suite);
+        printf("\n");
+        for (int kind = 0; kind < 7; kind++) table[rows][kind] = results[kind] ? results[kind]->median_ns : -1;
+        rows++;
+
+        search_index_destroy(&branchless);
+        search_index_destroy(&eytzinger);
+        free(a);
+    }
+
+    printf("Summary: ns per lookup\n");
+    printf("%-8s%12s%12s%12s%12s%12s%12s%12s\n", "n", "recursive", "branchy", "branchless", "simd",
+           "eytzinger", "bl batch", "eytz batch");
+    for (int r = 0; r < rows; r++) {
+        printf("2^%-6d", sizes_log2[r]);
+        for (int kind = 0; kind < 7; kind++) print_ns(table[r][kind]);
+        printf("\n");
+    }
+    printf("\n");
+    free(keys);
+    free(out);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o searching Searching.c -O2
+
+Then execute the resulting binary:
+    ./searching
+*/
@@ -0,0 +1,485 @@
+/*
+Cheat Sheet: Production-Grade Sorting in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+The textbook quicksort in Chapter4Functions/recursion.c takes the last element as
+the pivot. That is fine on random data but takes O(n^2) time and O(n) stack on
+input that is already sorted, reversed or full of duplicates, which is common in
+real data. Library sorts fix this with a few well-known techniques:
+
+- A better pivot: the median of three samples, or Tukey's "ninther" (the median
+  of three medians) for large ranges.
+- An insertion-sort cutoff: below about 24 elements insertion sort is faster
+  than more partitioning.
+- Three-way partitioning: elements equal to the pivot are grouped in the middle
+  and never touched again, so inputs with few distinct keys sort in O(n log k).
+- Introsort: if the recursion gets too deep, switch to heapsort, so the worst
+  case is O(n log n) whatever the input.
+- A merge sort across threads for large arrays.
+
+Historical context:
+- Hoare published quicksort in 1961. Sedgewick's thesis (1975) analysed the
+  pivot and cutoff choices.
+- Bentley and McIlroy's "Engineering a Sort Function" (1993) added the ninther
+  and fat (three-way) partitioning to the BSD qsort.
+- Musser's introsort (1997) became std::sort in the C++ standard libraries.
+  pdqsort (Peters, 2016) is the current state of the art.
+
+The implementation lives in sort.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../Chapter16MultithreadingAndConcurrency/thread_pool.h"
+#include "sort.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+SORT_DEFINE_PARALLEL(sort_int, int, SORT_LESS)
+
+// Function prototypes
+void typed_sort_example();
+void qsort_compatible_example();
+void duplicate_keys_example();
+void comparator_overflow_example();
+void parallel_sort_example();
+void performance_comparison();
+
+int main() {
+    printf("Production-Grade Sorting Cheat Sheet\n");
+    printf("====================================\n\n");
+
+    typed_sort_example();
+    qsort_compatible_example();
+    duplicate_keys_example();
+    comparator_overflow_example();
+    parallel_sort_example();
+    performance_comparison();
+
+    return 0;
+}
+
+typedef struct {
+    char name[16];
+    int score;
+} Player;
+
+// Highest score first, then by name
+#define PLAYER_LESS(a, b) \
+    ((a).score != (b).score ? (a).score > (b).score : strcmp((a).name, (b).name) < 0)
+
+SORT_DEFINE(sort_players, Player, PLAYER_LESS)
+
+// The comparator from Chapter6Pointers/PointersToFunctions.c. The subtraction
+// overflows when the values are far apart (see 2.4), so the benchmarks keep the
+// values in [0, 2^30), where it is exact.
+int compare_int(const void* a, const void* b) {
+    return (*(int*)a - *(int*)b);
+}
+
+// The overflow-free form: each comparison yields 0 or 1
+int compare_int_safe(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int compare_player(const void* a, const void* b) {
+    const Player* x = (const Player*)a;
+    const Player* y = (const Player*)b;
+    if (x->score != y->score) return x->score > y->score ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+static int is_sorted_int(const int* a, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        if (a[i - 1] > a[i]) return 0;
+    }
+    return 1;
+}
+
+static void print_ints(const char* label, const int* a, size_t n) {
+    printf("%s", label);
+    for (size_t i = 0; i < n; i++) printf(" %d", a[i]);
+    printf("\n");
+}
+
+void typed_sort_example() {
+    printf("2.1 Type-Specialised Introsort\n");
+    printf("-------------------------------\n");
+
+    int values[] = {42, -7, 19, 0, 3, 3, 88, -120, 5, 64, 11, 2};
+    size_t n = sizeof(values) / sizeof(values[0]);
+    print_ints("Before:", values, n);
+    sort_int(values, n);  // Predefined in sort.h, '<' is inlined
+    print_ints("After: ", values, n);
+
+    // SORT_DEFINE generates a sort for any type and ordering
+    Player players[] = {{"ada", 310}, {"linus", 275}, {"grace", 310}, {"ken", 190}, {"dmr", 275}};
+    sort_players(players, 5);
+    printf("Leaderboard:");
+    for (int i = 0; i < 5; i++) printf(" %s(%d)", players[i].name, players[i].score);
+    printf("\n\n");
+}
+
+void qsort_compatible_example() {
+    printf("2.2 A qsort-Compatible Drop-In\n");
+    printf("-------------------------------\n");
+
+    // Same arguments as qsort(): base, count, element size, comparator
+    Player players[] = {{"ada", 310}, {"linus", 275}, {"grace", 310}, {"ken", 190}, {"dmr", 275}};
+    sort_qsort(players, 5, sizeof(Player), compare_player);
+    printf("sort_qsort:  ");
+    for (int i = 0; i < 5; i++) printf(" %s(%d)", players[i].name, players[i].score);
+    printf("\n");
+
+    int values[] = {9, 1, 8, 2, 7, 3, 6, 4, 5};
+    sort_qsort(values, 9, sizeof(int), compare_int_safe);
+    print_ints("Integers:    ", values, 9);
+    printf("The comparator is an indirect call per comparison, which the typed version avoids.\n\n");
+}
+
+// Counting comparator: shows how much work each sort does
+static size_t comparisons;
+
+int compare_int_counted(const void* a, const void* b) {
+    comparisons++;
+    return compare_int_safe(a, b);
+}
+
+void duplicate_keys_example() {
+    printf("2.3 Few Distinct Keys and Three-Way Partitioning\n");
+    printf("-------------------------------------------------\n");
+
+    size_t n = 100000;
+    int* a = (int*)malloc(n * sizeof(int));
+    int* b = (int*)malloc(n * sizeof(int));
+    if (a == NULL || b == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(a);
+        free(b);
+        return;
+    }
+    unsigned int x = 2024;
+    for (size_t i = 0; i < n; i++) {
+        x = x * 1103515245u + 12345u;
+        a[i] = b[i] = (int)((x >> 16) % 4);  // Only 4 distinct values
+    }
+
+    comparisons = 0;
+    qsort(a, n, sizeof(int), compare_int_counted);
+    size_t libc = comparisons;
+    comparisons = 0;
+    sort_qsort(b, n, sizeof(int), compare_int_counted);
+    printf("%zu elements, 4 distinct keys\n", n);
+    printf("  libc qsort comparisons: %zu (%.1f per element)\n", libc, (double)libc / n);
+    printf("  sort_qsort comparisons: %zu (%.1f per element)\n", comparisons, (double)comparisons / n);
+    printf("Once a block of equal keys is split off, it is never compared again.\n\n");
+    free(a);
+    free(b);
+}
+
+void comparator_overflow_example() {
+    printf("2.4 Pitfall: Subtraction in Comparators\n");
+    printf("----------------------------------------\n");
+
+    int big = INT_MAX, small = -10;
+    // *a - *b overflows: INT_MAX - (-10) is undefined behaviour and in practice
+    // wraps negative, claiming INT_MAX < -10
+    long long wrapped = (long long)(unsigned int)big - (unsigned int)small;
+    printf("INT_MAX vs -10: compare_int would return %d (wraps), compare_int_safe returns %d\n",
+           (int)(unsigned int)wrapped, compare_int_safe(&big, &small));
+
+    int values[] = {INT_MAX, -10, INT_MIN, 7, 0};
+    sort_qsort(values, 5, sizeof(int), compare_int_safe);
+    print_ints("Sorted with compare_int_safe:", values, 5);
+    printf("\n");
+}
+
+void parallel_sort_example() {
+    printf("2.5 Parallel Merge Sort on the Thread Pool\n");
+    printf("-------------------------------------------\n");
+
+    ThreadPool pool;
+    if (thread_pool_init(&pool, 0) != 0) {
+        fprintf(stderr, "Thread pool creation failed\n");
+        return;
+    }
+    size_t n = 1u << 20;
+    int* a = (int*)malloc(n * sizeof(int));
+    if (a == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        thread_pool_destroy(&pool);
+        return;
+    }
+    unsigned int x = 7;
+    for (size_t i = 0; i < n; i++) {
+        x = x * 1103515245u + 12345u;
+        a[i] = (int)(x >> 2);
+    }
+    // Each worker introsorts chunks, then runs are merged pairwise; every merge is
+    // cut into pieces at binary-searched split points so all threads stay busy.
+    sort_int_parallel(&pool, a, n);
+    printf("%zu ints on %u thread(s): %s\n", n, thread_pool_size(&pool),
+           is_sorted_int(a, n) ? "sorted" : "NOT sorted");
+    if (thread_pool_size(&pool) == 1) {
+        printf("(One thread: the call falls back to the serial introsort.)\n");
+    }
+
+    // Sizes just above a multiple of the chunk count. With many threads the rounded-up
+    // chunk width covers n in fewer chunks than requested; the rest must be skipped.
+    size_t chunks = 1;
+    while (chunks < 4 * (size_t)thread_pool_size(&pool)) chunks *= 2;
+    size_t edge_sizes[] = {SORT_PARALLEL_MIN + 1, SORT_PARALLEL_MIN + chunks + 1,
+                           (SORT_PARALLEL_MIN / chunks + 1) * chunks + 1, 3 * (size_t)SORT_PARALLEL_MIN + 1};
+    int edge_ok = 1;
+    for (int k = 0; k < 4; k++) {
+        size_t m = edge_sizes[k];
+        for (size_t i = 0; i < m; i++) {
+            x = x * 1103515245u + 12345u;
+            a[i] = (int)(x >> 2);
+        }
+        sort_int_parallel(&pool, a, m);
+        if (!is_sorted_int(a, m)) {
+            printf("n = %zu: NOT sorted\n", m);
+            edge_ok = 0;
+        }
+    }
+    printf("Sizes just above a multiple of %zu chunks: %s\n", chunks, edge_ok ? "sorted" : "FAILED");
+    printf("\n");
+    free(a);
+    thread_pool_destroy(&pool);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Use the typed sort (SORT_DEFINE) on hot paths: the comparison is inlined and
+   elements are moved as values instead of byte by byte.
+2. Write comparators as (x > y) - (x < y), never x - y.
+3. Sort keys, or (key, index) pairs, instead of large records, then permute once.
+4. Only reach for the parallel sort above ~64K elements; below that thread
+   hand-off costs more than it saves.
+
+Common Pitfalls:
+1. Comparators that are not a strict weak ordering (e.g. using <= or comparing
+   floats containing NaN) can make any quicksort read out of bounds.
+2. None of these sorts are stable. Add the original index as a tie-breaker, or
+   use a merge sort, when equal elements must keep their order.
+3. A last-element pivot (recursion.c) recurses n deep on sorted input and can
+   overflow the stack for large n.
+
+Advanced Tips:
+1. The comparison count (2.3) is a good, machine-independent way to compare sorts.
+2. For integer keys consider radix sort: O(n) passes with no comparisons.
+3. Sorting networks for 4-16 elements beat insertion sort when branches mispredict.
+
+4. Integration and Real-World Applications
+==========================================
+- Databases: ORDER BY, sort-merge joins and index builds.
+- Search engines: ranking the top hits and merging posting lists.
+- Compilers and linkers: sorting symbols and relocations.
+- Data processing: group-by, deduplication and percentile calculations.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- pdqsort detects patterns (already sorted runs) and uses branchless partitioning.
+- Vectorised quicksort (e.g. vqsort, x86-simd-sort) partitions with AVX-512.
+- Samplesort and parallel radix sort scale better than merge sort on many cores.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why is libc qsort slower than sort_int even with the same algorithm?
+A: qsort calls the comparator through a function pointer for every comparison
+   and cannot inline it. glibc's qsort also allocates a merge-sort buffer.
+
+Q: Why does the parallel sort not speed up on my machine?
+A: It falls back to the serial sort on a single CPU, and merging is memory-bound,
+   so speedup flattens once memory bandwidth is saturated.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- "Engineering a Sort Function" (Bentley & McIlroy, 1993)
+- "Introspective Sorting and Selection Algorithms" (Musser, 1997)
+- "Pattern-defeating Quicksort" (Peters, 2021)
+- Sedgewick & Wayne, "Algorithms", chapter 2.3 (three-way quicksort)
+
+8. Performance Analysis and Optimization
+========================================
+The benchmark sorts 1M ints with libc qsort and compare_int (the version from
+Chapter6Pointers/PointersToFunctions.c), the qsort-compatible introsort with the
+same comparator, the typed introsort and the parallel merge sort, on four inputs:
+random, sorted, reversed and few-unique. Every run copies the unsorted input first;
+the copy takes well under 1% of the sort time. A second suite shows the textbook
+quicksort from recursion.c degrading to O(n^2) on 20K elements.
+*/
+
+#define SORT_BENCH_N (1u << 20)
+#define NAIVE_BENCH_N 20000
+
+typedef enum { SORT_QSORT_LIBC, SORT_QSORT_INTRO, SORT_TYPED, SORT_PARALLEL, SORT_TEXTBOOK } SortKind;
+
+typedef struct {
+    const int* input;
+    int* work;
+    size_t n;
+    SortKind kind;
+    ThreadPool* pool;
+} SortBench;
+
+// Chapter4Functions/recursion.c, unchanged: last element as the pivot
+static int textbook_partition(int arr[], int low, int high) {
+    int pivot = arr[high];
+    int i = (low - 1);
+    for (int j = low; j <= high - 1; j++) {
+        if (arr[j] < pivot) {
+            i++;
+            int temp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = temp;
+        }
+    }
+    int temp = arr[i + 1];
+    arr[i + 1] = arr[high];
+    arr[high] = temp;
+    return (i + 1);
+}
+
+static void textbook_quicksort(int arr[], int low, int high) {
+    if (low < high) {
+        int pi = textbook_partition(arr, low, high);
+        textbook_quicksort(arr, low, pi - 1);
+        textbook_quicksort(arr, pi + 1, high);
+    }
+}
+
+void sort_bench_run(void* ctx) {
+    SortBench* b = (SortBench*)ctx;
+    memcpy(b->work, b->input, b->n * sizeof(int));
+    switch (b->kind) {
+        case SORT_QSORT_LIBC: qsort(b->work, b->n, sizeof(int), compare_int); break;
+        case SORT_QSORT_INTRO: sort_qsort(b->work, b->n, sizeof(int), compare_int); break;
+        case SORT_TYPED: sort_int(b->work, b->n); break;
+        case SORT_PARALLEL: sort_int_parallel(b->pool, b->work, b->n); break;
+        case SORT_TEXTBOOK: textbook_quicksort(b->work, 0, (int)b->n - 1); break;
+    }
+    BENCH_CLOBBER();
+}
+
+static const char* distribution_names[] = {"random", "sorted", "reversed", "few-unique"};
+
+static void fill_distribution(int* a, size_t n, int dist) {
+    unsigned int x = 12345;
+    for (size_t i = 0; i < n; i++) {
+        x = x * 1103515245u + 12345u;
+        switch (dist) {
+            case 0: a[i] = (int)((x >> 1) & ((1u << 30) - 1)); break;
+            case 1: a[i] = (int)i; break;
+            case 2: a[i] = (int)(n - i); break;
+            default: a[i] = (int)((x >> 16) % 10); break;
+        }
+    }
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    ThreadPool pool;
+    if (thread_pool_init(&pool, 0) != 0) {
+        fprintf(stderr, "Thread pool creation failed\n");
+        return;
+    }
+    size_t n = SORT_BENCH_N;
+    int* input = (int*)malloc(n * sizeof(int));
+    int* work = (int*)malloc(n * sizeof(int));
+    if (input == NULL || work == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(input);
+        free(work);
+        thread_pool_destroy(&pool);
+        return;
+    }
+
+    static char titles[4][64];
+    static char parallel_name[48];
+    snprintf(parallel_name, sizeof(parallel_name), "sort_int_parallel (%u threads)", thread_pool_size(&pool));
+    for (int dist = 0; dist < 4; dist++) {
+        fill_distribution(input, n, dist);
+        SortBench libc = {input, work, n, SORT_QSORT_LIBC, &pool};
+        SortBench intro = {input, work, n, SORT_QSORT_INTRO, &pool};
+        SortBench typed = {input, work, n, SORT_TYPED, &pool};
+        SortBench parallel = {input, work, n, SORT_PARALLEL, &pool};
+
+        snprintf(titles[dist], sizeof(titles[dist]), "Sort 1M ints, %s input", distribution_names[dist]);
+        BenchSuite suite;
+        bench_suite_init(&suite, titles[dist]);
+        bench_suite_run(&suite, "libc qsort + compare_int", sort_bench_run, &libc, n);
+        bench_suite_run(&suite, "sort_qsort + compare_int", sort_bench_run, &intro, n);
+        bench_suite_run(&suite, "sort_int (typed)", sort_bench_run, &typed, n);
+        bench_suite_run(&suite, parallel_name, sort_bench_run, &parallel, n);
+        bench_suite_report(&suite);
+        if (!is_sorted_int(work, n)) printf("  (result check FAILED)\n");
+        printf("\n");
+    }
+
+    // The textbook version on a smaller array: sorted input costs n^2/2 comparisons.
+    // Each distribution gets its own slice of 'input'.
+    static char naive_names[8][48];
+    SortBench naive_cases[8];
+    BenchSuite naive;
+    bench_suite_init(&naive, "Textbook quicksort (recursion.c) vs introsort, 20K ints");
+    for (int dist = 0; dist < 4; dist++) {
+        int* src = input + (size_t)dist * NAIVE_BENCH_N;
+        fill_distribution(src, NAIVE_BENCH_N, dist);
+        naive_cases[2 * dist] = (SortBench){src, work, NAIVE_BENCH_N, SORT_TEXTBOOK, &pool};
+        naive_cases[2 * dist + 1] = (SortBench){src, work, NAIVE_BENCH_N, SORT_TYPED, &pool};
+        snprintf(naive_names[2 * dist], sizeof(naive_names[0]), "textbook, %s", distribution_names[dist]);
+        snprintf(naive_names[2 * dist + 1], sizeof(naive_names[0]), "sort_int, %s", distribution_names[dist]);
+    }
+    for (int i = 0; i < 8; i++) {
+        bench_suite_run(&naive, naive_names[i], sort_bench_run, &naive_cases[i], NAIVE_BENCH_N);
+    }
+    bench_suite_report(&naive);
+
+    free(input);
+    free(work);
+    thread_pool_destroy(&pool);
+    printf("\n");
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o sorting Sorting.c -O2 -pthread
+
+Then execute the resulting binary:
+    ./sorting
+*/
@@ -0,0 +1,466 @@
+/*
+sort.h - Introsort (Typed and qsort-Compatible) and Parallel Merge Sort
+================================================
+
+Typed sorts are generated per element type, so the comparison is inlined:
+
+    SORT_DEFINE(sort_points, Point, POINT_LESS)   // POINT_LESS(a, b): a < b
+    sort_points(points, n);
+
+    sort_int(values, n);                           // Predefined for common types
+
+    sort_qsort(base, n, size, compare_fn);         // Drop-in for qsort()
+
+    #include "../Chapter16MultithreadingAndConcurrency/thread_pool.h"
+    SORT_DEFINE_PARALLEL(sort_int, int, SORT_LESS)
+    sort_int_parallel(&pool, values, n);           // Merge sort over the pool
+
+Design:
+- Introsort (Musser, 1997): quicksort that switches to heapsort once the depth
+  exceeds 2*log2(n), so the worst case is O(n log n) and recursion depth is
+  O(log n). The loop always recurses into the smaller side and iterates on the
+  larger one, so the call stack stays O(log n) as well.
+- The pivot is the median of three elements (first, middle, last) for small
+  ranges and Tukey's ninther, the median of three medians, above
+  SORT_NINTHER_THRESHOLD. The samples are sorted in place, which moves reversed
+  input towards sorted order. Sorted and reversed input then split evenly instead
+  of degrading to O(n^2) as a last-element pivot does. After a partition that
+  leaves less than 1/8 on one side, a few elements on each side are swapped
+  (pdqsort's pattern breaking), so organ-pipe inputs don't reach the depth limit.
+- Partitions smaller than SORT_INSERTION_CUTOFF are finished with insertion sort.
+- Duplicates: when two pivot samples compare equal, or the pivot equals the
+  element just left of the range (which bounds the range from below), the range
+  is split three ways (Dijkstra) into < pivot, == pivot and > pivot, and the
+  equal block is never looked at again. Inputs with few distinct keys then take
+  O(n log k) instead of O(n log n). Otherwise a Hoare partition is used, which
+  does fewer swaps on distinct keys.
+- None of the sorts are stable. The parallel sort is a merge sort: the pool
+  sorts chunks with introsort, then merges them pairwise. Each merge is split
+  into independent pieces at split points found by binary search (co-ranking),
+  so the last passes still use every thread. It needs an n-element scratch
+  buffer and falls back to the serial sort if that cannot be allocated.
+
+Tracing: with -DTRACE_ENABLE, every top-level sort call is a "sort" zone named
+after the generated function, the parallel sort adds a zone per merge pass, and
+sort.elements counts the elements sorted (Chapter18DebuggingAndProfiling/trace.h).
+*/
+
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Chapter18DebuggingAndProfiling/trace.h"
+
+#define SORT_INSERTION_CUTOFF 24
+#define SORT_NINTHER_THRESHOLD 128
+#define SORT_PARALLEL_MIN (1u << 16)   // Below this the parallel sort runs serially
+
+#define SORT_LESS(a, b) ((a) < (b))
+
+// 2 * floor(log2(n)), the introsort depth limit
+static inline int sort_depth_limit_(size_t n) {
+    int depth = 0;
+    while (n > 1) {
+        n >>= 1;
+        depth += 2;
+    }
+    return depth;
+}
+
+// Generates void name(T* a, size_t n). LESS(x, y) gets two values of type T.
+#define SORT_DEFINE(name, T, LESS)                                                        \
+    static inline void name##_swap_(T* x, T* y) {                                         \
+        T t = *x;                                                                         \
+        *x = *y;                                                                          \
+        *y = t;                                                                           \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_insertion_(T* a, size_t n) {                                \
+        for (size_t i = 1; i < n; i++) {                                                  \
+            T v = a[i];                                                                   \
+            size_t j = i;                                                                 \
+            while (j > 0 && LESS(v, a[j - 1])) {                                          \
+                a[j] = a[j - 1];                                                          \
+                j--;                                                                      \
+            }                                                                             \
+            a[j] = v;                                                                     \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_sift_(T* a, size_t root, size_t n) {                        \
+        T v = a[root];                                                                    \
+        for (;;) {                                                                        \
+            size_t child = 2 * root + 1;                                                  \
+            if (child >= n) break;                                                        \
+            if (child + 1 < n && LESS(a[child], a[child + 1])) child++;                   \
+            if (!LESS(v, a[child])) break;                                                \
+            a[root] = a[child];                                                           \
+            root = child;                                                                 \
+        }                                                                                 \
+        a[root] = v;                                                                      \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_heapsort_(T* a, size_t n) {                                 \
+        if (n < 2) return;                                                                \
+        for (size_t i = n / 2; i-- > 0;) name##_sift_(a, i, n);                           \
+        for (size_t end = n - 1; end > 0; end--) {                                        \
+            name##_swap_(&a[0], &a[end]);                                                 \
+            name##_sift_(a, 0, end);                                                      \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    /* Orders a[i] <= a[j] <= a[k] in place; sets *dup if two compare equal */            \
+    static inline void name##_sort3_(T* a, size_t i, size_t j, size_t k, int* dup) {      \
+        if (LESS(a[j], a[i])) name##_swap_(&a[i], &a[j]);                                 \
+        if (LESS(a[k], a[j])) {                                                           \
+            name##_swap_(&a[j], &a[k]);                                                   \
+            if (LESS(a[j], a[i])) name##_swap_(&a[i], &a[j]);                             \
+        }                                                                                 \
+        if (!LESS(a[i], a[j]) || !LESS(a[j], a[k])) *dup = 1;                             \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_break_pattern_(T* a, size_t n) {                            \
+        if (n > SORT_INSERTION_CUTOFF) {                                                  \
+            name##_swap_(&a[0], &a[n / 4]);                                               \
+            name##_swap_(&a[n - 1], &a[n - n / 4]);                                       \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_loop_(T* a, size_t n, int depth, int leftmost) {            \
+        while (n > SORT_INSERTION_CUTOFF) {                                               \
+            if (depth-- == 0) {                                                           \
+                name##_heapsort_(a, n);                                                   \
+                return;                                                                   \
+            }                                                                             \
+            int dup = 0;                                                                  \
+            size_t mid = n / 2;                                                           \
+            if (n > SORT_NINTHER_THRESHOLD) {                                             \
+                size_t s = n / 8;                                                         \
+                name##_sort3_(a, 0, s, 2 * s, &dup);                                      \
+                name##_sort3_(a, mid - s, mid, mid + s, &dup);                            \
+                name##_sort3_(a, n - 1 - 2 * s, n - 1 - s, n - 1, &dup);                  \
+                name##_sort3_(a, s, mid, n - 1 - s, &dup);                                \
+            } else {                                                                      \
+                name##_sort3_(a, 0, mid, n - 1, &dup);                                    \
+            }                                                                             \
+            name##_swap_(&a[0], &a[mid]);                                                 \
+            /* a[-1] <= every element here, so equal means the range starts with a run */ \
+            if (!leftmost && !LESS(a[-1], a[0])) dup = 1;                                 \
+                                                                                          \
+            size_t lo, hi; /* Left part [0, lo), right part [hi, n) */                    \
+            if (dup) {                                                                    \
+                /* Three-way: [0, lt) < p, [lt, i) == p, [gt, n) > p. a[lt] == p */      \
+                size_t lt = 0, i = 1, gt = n;                                             \
+                while (i < gt) {                                                          \
+                    if (LESS(a[i], a[lt])) {                                              \
+                        name##_swap_(&a[lt++], &a[i++]);                                  \
+                    } else if (LESS(a[lt], a[i])) {                                       \
+                        name##_swap_(&a[i], &a[--gt]);                                    \
+                    } else {                                                              \
+                        i++;                                                              \
+                    }                                                                     \
+                }                                                                         \
+                lo = lt;                                                                  \
+                hi = gt;                                                                  \
+            } else {                                                                      \
+                /* Hoare: the pivot stays at a[0] until the final swap */                 \
+                T p = a[0];                                                               \
+                size_t i = 0, j = n;                                                      \
+                for (;;) {                                                                \
+                    do i++; while (i < n && LESS(a[i], p));                               \
+                    do j--; while (LESS(p, a[j]));                                        \
+                    if (i >= j) break;                                                    \
+                    name##_swap_(&a[i], &a[j]);                                           \
+                }                                                                         \
+                name##_swap_(&a[0], &a[j]);                                               \
+                lo = j;                                                                   \
+                hi = j + 1;                                                               \
+            }                                                                             \
+                                                                                          \
+            size_t nleft = lo, nright = n - hi;                                           \
+            if (!dup && (nleft < n / 8 || nright < n / 8)) {                              \
+                /* Unbalanced: swap a few elements to break up the input pattern */       \
+                name##_break_pattern_(a, nleft);                                          \
+                name##_break_pattern_(a + hi, nright);                                    \
+            }                                                                             \
+            if (nleft < nright) {                                                         \
+                name##_loop_(a, nleft, depth, leftmost);                                  \
+                a += hi;                                                                  \
+                n = nright;                                                               \
+                leftmost = 0;                                                             \
+            } else {                                                                      \
+                name##_loop_(a + hi, nright, depth, 0);                                   \
+                n = nleft;                                                                \
+            }                                                                             \
+        }                                                                                 \
+        name##_insertion_(a, n);                                                          \
+    }                                                                                     \
+                                                                                          \
+    static inline void name(T* a, size_t n) {                                             \
+        if (n < 2) return;                                                                \
+        TRACE_ZONE_BEGIN(zone, "sort", #name);                                            \
+        TRACE_COUNTER_ADD("sort.elements", n);                                            \
+        name##_loop_(a, n, sort_depth_limit_(n), 1);                                      \
+        TRACE_ZONE_END(zone);                                                             \
+    }
+
+// Generates void name##_parallel(ThreadPool* pool, T* a, size_t n) for a sort
+// already generated by SORT_DEFINE(name, T, LESS). Include thread_pool.h first.
+#define SORT_DEFINE_PARALLEL(name, T, LESS)                                               \
+    typedef struct {                                                                      \
+        T* src;                                                                           \
+        T* dst;                                                                           \
+        size_t n, width, pieces;                                                          \
+    } name##_MergePass_;                                                                  \
+                                                                                          \
+    static inline void name##_sort_chunks_(void* ctx, size_t begin, size_t end,           \
+                                           unsigned worker) {                             \
+        (void)worker;                                                                     \
+        name##_MergePass_* p = (name##_MergePass_*)ctx;                                   \
+        for (size_t c = begin; c < end; c++) {                                            \
+            size_t lo = c * p->width;                                                     \
+            size_t hi = lo + p->width < p->n ? lo + p->width : p->n;                      \
+            name(p->src + lo, hi - lo);                                                   \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    /* Elements of x among the first k outputs of a stable merge of x and y */            \
+    static inline size_t name##_corank_(size_t k, const T* x, size_t nx, const T* y,      \
+                                        size_t ny) {                                      \
+        size_t lo = k > ny ? k - ny : 0, hi = k < nx ? k : nx;                            \
+        while (lo < hi) {                                                                 \
+            size_t i = lo + (hi - lo) / 2;                                                \
+            if (!LESS(y[k - i - 1], x[i])) {                                              \
+                lo = i + 1;                                                               \
+            } else {                                                                      \
+                hi = i;                                                                   \
+            }                                                                             \
+        }                                                                                 \
+        return lo;                                                                        \
+    }                                                                                     \
+                                                                                          \
+    /* Task t merges piece (t % pieces) of the run pair (t / pieces) */                   \
+    static inline void name##_merge_pieces_(void* ctx, size_t begin, size_t end,          \
+                                            unsigned worker) {                            \
+        (void)worker;                                                                     \
+        name##_MergePass_* p = (name##_MergePass_*)ctx;                                   \
+        for (size_t t = begin; t < end; t++) {                                            \
+            size_t pair = t / p->pieces, piece = t % p->pieces;                           \
+            size_t start = pair * 2 * p->width;                                           \
+            size_t mid = start + p->width < p->n ? start + p->width : p->n;               \
+            size_t stop = mid + p->width < p->n ? mid + p->width : p->n;                  \
+            const T* x = p->src + start;                                                  \
+            const T* y = p->src + mid;                                                    \
+            size_t nx = mid - start, ny = stop - mid, len = nx + ny;                      \
+            size_t k0 = len * piece / p->pieces, k1 = len * (piece + 1) / p->pieces;      \
+            size_t i = name##_corank_(k0, x, nx, y, ny), i1 = name##_corank_(k1, x, nx, y, ny); \
+            size_t j = k0 - i, j1 = k1 - i1;                                              \
+            T* out = p->dst + start + k0;                                                 \
+            while (i < i1 && j < j1) *out++ = LESS(y[j], x[i]) ? y[j++] : x[i++];         \
+            while (i < i1) *out++ = x[i++];                                               \
+            while (j < j1) *out++ = y[j++];                                               \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_parallel(ThreadPool* pool, T* a, size_t n) {                \
+        unsigned threads = thread_pool_size(pool);                                        \
+        T* tmp = threads > 1 && n >= SORT_PARALLEL_MIN ? (T*)malloc(n * sizeof(T)) : NULL; \
+        if (tmp == NULL) {                                                                \
+            name(a, n);                                                                   \
+            return;                                                                       \
+        }                                                                                 \
+        size_t chunks = 1;                                                                \
+        while (chunks < 4 * (size_t)threads) chunks *= 2;                                 \
+        name##_MergePass_ pass = {a, tmp, n, (n + chunks - 1) / chunks, 1};               \
+        /* Rounding the width up can leave trailing chunks past the end; drop them */     \
+        chunks = (n + pass.width - 1) / pass.width;                                       \
+        parallel_for(pool, 0, chunks, 1, name##_sort_chunks_, &pass);                     \
+                                                                                          \
+        size_t tasks = 4 * (size_t)threads;                                               \
+        while (pass.width < n) {                                                          \
+            TRACE_ZONE_BEGIN(zone, "sort", #name " merge pass");                          \
+            size_t pairs = (n + 2 * pass.width - 1) / (2 * pass.width);                   \
+            pass.pieces = pairs >= tasks ? 1 : (tasks + pairs - 1) / pairs;               \
+            parallel_for(pool, 0, pairs * pass.pieces, 1, name##_merge_pieces_, &pass);   \
+            TRACE_ZONE_END(zone);                                                         \
+            T* swap = pass.src;                                                           \
+            pass.src = pass.dst;                                                          \
+            pass.dst = swap;                                                              \
+            pass.width *= 2;                                                              \
+        }                                                                                 \
+        if (pass.src != a) memcpy(a, pass.src, n * sizeof(T));                            \
+        free(tmp);                                                                        \
+    }
+
+SORT_DEFINE(sort_int, int, SORT_LESS)
+SORT_DEFINE(sort_uint32, uint32_t, SORT_LESS)
+SORT_DEFINE(sort_int64, int64_t, SORT_LESS)
+SORT_DEFINE(sort_uint64, uint64_t, SORT_LESS)
+SORT_DEFINE(sort_double, double, SORT_LESS)
+
+// ---------------------------------------------------------------------------
+// qsort-compatible introsort
+// ---------------------------------------------------------------------------
+
+typedef int (*SortCompareFn)(const void* a, const void* b);
+
+static inline void sort_swap_bytes_(unsigned char* x, unsigned char* y, size_t size) {
+    if (size == sizeof(uint32_t)) {
+        uint32_t t;
+        memcpy(&t, x, sizeof(t));
+        memcpy(x, y, sizeof(t));
+        memcpy(y, &t, sizeof(t));
+        return;
+    }
+    while (size >= sizeof(uint64_t)) {
+        uint64_t t;
+        memcpy(&t, x, sizeof(t));
+        memcpy(x, y, sizeof(t));
+        memcpy(y, &t, sizeof(t));
+        x += sizeof(t);
+        y += sizeof(t);
+        size -= sizeof(t);
+    }
+    while (size--) {
+        unsigned char t = *x;
+        *x++ = *y;
+        *y++ = t;
+    }
+}
+
+#define SORT_AT_(i) (base + (i) * size)
+
+static inline void sort_qsort_insertion_(unsigned char* base, size_t n, size_t size, SortCompareFn cmp) {
+    for (size_t i = 1; i < n; i++) {
+        for (size_t j = i; j > 0 && cmp(SORT_AT_(j), SORT_AT_(j - 1)) < 0; j--) {
+            sort_swap_bytes_(SORT_AT_(j), SORT_AT_(j - 1), size);
+        }
+    }
+}
+
+static inline void sort_qsort_sift_(unsigned char* base, size_t root, size_t n, size_t size,
+                                    SortCompareFn cmp) {
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= n) return;
+        if (child + 1 < n && cmp(SORT_AT_(child), SORT_AT_(child + 1)) < 0) child++;
+        if (cmp(SORT_AT_(root), SORT_AT_(child)) >= 0) return;
+        sort_swap_bytes_(SORT_AT_(root), SORT_AT_(child), size);
+        root = child;
+    }
+}
+
+static inline void sort_qsort_heapsort_(unsigned char* base, size_t n, size_t size, SortCompareFn cmp) {
+    if (n < 2) return;
+    for (size_t i = n / 2; i-- > 0;) sort_qsort_sift_(base, i, n, size, cmp);
+    for (size_t end = n - 1; end > 0; end--) {
+        sort_swap_bytes_(SORT_AT_(0), SORT_AT_(end), size);
+        sort_qsort_sift_(base, 0, end, size, cmp);
+    }
+}
+
+static inline void sort_qsort_sort3_(unsigned char* base, size_t size, SortCompareFn cmp,
+                                     size_t i, size_t j, size_t k, int* dup) {
+    if (cmp(SORT_AT_(j), SORT_AT_(i)) < 0) sort_swap_bytes_(SORT_AT_(i), SORT_AT_(j), size);
+    if (cmp(SORT_AT_(k), SORT_AT_(j)) < 0) {
+        sort_swap_bytes_(SORT_AT_(j), SORT_AT_(k), size);
+        if (cmp(SORT_AT_(j), SORT_AT_(i)) < 0) sort_swap_bytes_(SORT_AT_(i), SORT_AT_(j), size);
+    }
+    if (cmp(SORT_AT_(i), SORT_AT_(j)) == 0 || cmp(SORT_AT_(j), SORT_AT_(k)) == 0) *dup = 1;
+}
+
+static inline void sort_qsort_break_pattern_(unsigned char* base, size_t n, size_t size) {
+    if (n > SORT_INSERTION_CUTOFF) {
+        sort_swap_bytes_(SORT_AT_(0), SORT_AT_(n / 4), size);
+        sort_swap_bytes_(SORT_AT_(n - 1), SORT_AT_(n - n / 4), size);
+    }
+}
+
+// Same algorithm as SORT_DEFINE. The pivot is compared in place (there is no
+// temporary of the element type): at a[0] during a Hoare partition, and at a[lt],
+// the first element of the equal block, during a three-way partition.
+static inline void sort_qsort_loop_(unsigned char* base, size_t n, size_t size, SortCompareFn cmp,
+                                    int depth, int leftmost) {
+    while (n > SORT_INSERTION_CUTOFF) {
+        if (depth-- == 0) {
+            sort_qsort_heapsort_(base, n, size, cmp);
+            return;
+        }
+        int dup = 0;
+        size_t mid = n / 2;
+        if (n > SORT_NINTHER_THRESHOLD) {
+            size_t s = n / 8;
+            sort_qsort_sort3_(base, size, cmp, 0, s, 2 * s, &dup);
+            sort_qsort_sort3_(base, size, cmp, mid - s, mid, mid + s, &dup);
+            sort_qsort_sort3_(base, size, cmp, n - 1 - 2 * s, n - 1 - s, n - 1, &dup);
+            sort_qsort_sort3_(base, size, cmp, s, mid, n - 1 - s, &dup);
+        } else {
+            sort_qsort_sort3_(base, size, cmp, 0, mid, n - 1, &dup);
+        }
+        sort_swap_bytes_(SORT_AT_(0), SORT_AT_(mid), size);
+        if (!leftmost && cmp(base - size, base) >= 0) dup = 1;
+
+        size_t lo, hi;
+        if (dup) {
+            size_t lt = 0, i = 1, gt = n;
+            while (i < gt) {
+                int c = cmp(SORT_AT_(i), SORT_AT_(lt));
+                if (c < 0) {
+                    sort_swap_bytes_(SORT_AT_(lt), SORT_AT_(i), size);
+                    lt++;
+                    i++;
+                } else if (c > 0) {
+                    gt--;
+                    sort_swap_bytes_(SORT_AT_(i), SORT_AT_(gt), size);
+                } else {
+                    i++;
+                }
+            }
+            lo = lt;
+            hi = gt;
+        } else {
+            size_t i = 0, j = n;
+            for (;;) {
+                do i++; while (i < n && cmp(SORT_AT_(i), base) < 0);
+                do j--; while (cmp(base, SORT_AT_(j)) < 0);
+                if (i >= j) break;
+                sort_swap_bytes_(SORT_AT_(i), SORT_AT_(j), size);
+            }
+            if (j != 0) sort_swap_bytes_(base, SORT_AT_(j), size);
+            lo = j;
+            hi = j + 1;
+        }
+
+        size_t nleft = lo, nright = n - hi;
+        if (!dup && (nleft < n / 8 || nright < n / 8)) {
+            sort_qsort_break_pattern_(base, nleft, size);
+            sort_qsort_break_pattern_(SORT_AT_(hi), nright, size);
+        }
+        if (nleft < nright) {
+            sort_qsort_loop_(base, nleft, size, cmp, depth, leftmost);
+            base = SORT_AT_(hi);
+            n = nright;
+            leftmost = 0;
+        } else {
+            sort_qsort_loop_(SORT_AT_(hi), nright, size, cmp, depth, 0);
+            n = nleft;
+        }
+    }
+    sort_qsort_insertion_(base, n, size, cmp);
+}
+
+#undef SORT_AT_
+
+// Same signature and contract as qsort(), with an O(n log n) worst case.
+static inline void sort_qsort(void* base, size_t n, size_t size, SortCompareFn cmp) {
+    if (n < 2 || size == 0) return;
+    TRACE_ZONE_BEGIN(zone, "sort", "sort_qsort");
+    TRACE_COUNTER_ADD("sort.elements", n);
+    sort_qsort_loop_((unsigned char*)base, n, size, cmp, sort_depth_limit_(n), 1);
+    TRACE_ZONE_END(zone);
+}
+
+#endif // SORT_H
@@ -0,0 +1,284 @@
+/*
+Cheat Sheet: Arena (Region) Allocators in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+An arena (also called a region or linear allocator) serves allocations by bumping a
+pointer through a large block of memory. Individual objects are never freed; the whole
+arena is released or reset at once when the work it belongs to is finished.
+
+Key points:
+- Allocation costs an add and a compare, and there is no per-object header.
+- Freeing N objects costs O(1) instead of N calls to free().
+- Objects allocated together sit next to each other in memory, which helps caches.
+- Fragmentation cannot build up: the arena is reused from the start after a reset.
+- Checkpoints (mark/rollback) give stack-like scratch memory for temporary work.
+
+Historical context:
+- Regions appear in early compilers and in Hanson's "Fast Allocation and Deallocation
+  of Memory Based on Object Lifetimes" (1990).
+- Apache's APR pools and PostgreSQL's memory contexts are arenas tied to a request.
+- Game engines use per-frame arenas that are reset once per frame.
+
+The implementation lives in arena.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "arena.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// Function prototypes
+void basic_arena_usage();
+void alignment_example();
+void growth_example();
+void checkpoint_example();
+void performance_comparison();
+
+int main() {
+    printf("Arena Allocator Cheat Sheet\n");
+    printf("===========================\n\n");
+
+    basic_arena_usage();
+    alignment_example();
+    growth_example();
+    checkpoint_example();
+    performance_comparison();
+
+    return 0;
+}
+
+typedef struct {
+    int id;
+    double score;
+    char* name;
+} Record;
+
+void basic_arena_usage() {
+    printf("2.1 Basic Arena Usage\n");
+    printf("----------------------\n");
+
+    Arena arena;
+    arena_init(&arena, 0);
+
+    Record* r = (Record*)arena_alloc(&arena, sizeof(Record));
+    r->id = 1;
+    r->score = 98.5;
+    r->name = arena_strdup(&arena, "Alice");
+    printf("Record %d: %s (%.1f)\n", r->id, r->name, r->score);
+    printf("Arena in use: %zu bytes, reserved: %zu bytes\n", arena_bytes_used(&arena), arena.reserved);
+
+    arena_reset(&arena);  // r and r->name are released together
+    printf("After reset: %zu bytes in use\n\n", arena_bytes_used(&arena));
+    arena_destroy(&arena);
+}
+
+void alignment_example() {
+    printf("2.2 Alignment\n");
+    printf("--------------\n");
+
+    Arena arena;
+    arena_init(&arena, 0);
+
+    char* c = arena_strndup(&arena, "x", 1);  // Strings are packed byte-aligned
+    double* d = (double*)arena_alloc(&arena, sizeof(double));
+    void* line = arena_alloc_aligned(&arena, 64, 64);
+
+    printf("max_align_t alignment: %zu\n", (size_t)ARENA_ALIGN);
+    printf("char at %p, double at %p (aligned: %s)\n", (void*)c, (void*)d,
+           ((uintptr_t)d % ARENA_ALIGN) == 0 ? "yes" : "no");
+    printf("64-byte aligned block: %s\n\n", ((uintptr_t)line % 64) == 0 ? "yes" : "no");
+    arena_destroy(&arena);
+}
+
+void growth_example() {
+    printf("2.3 Growth Through Chained Chunks\n");
+    printf("----------------------------------\n");
+
+    Arena arena;
+    arena_init(&arena, 1024);
+
+    for (int i = 0; i < 100; i++) arena_alloc(&arena, 100);
+    printf("100 x 100 bytes with 1 KB chunks: %zu chunks\n", arena.chunk_count);
+
+    void* big = arena_alloc(&arena, 10000);  // Larger than a chunk: dedicated chunk
+    printf("10 KB request served: %s, chunks now: %zu\n", big ? "yes" : "no", arena.chunk_count);
+
+    arena_reset(&arena);
+    for (int i = 0; i < 100; i++) arena_alloc(&arena, 100);
+    printf("Same work after reset reuses chunks: %zu chunks\n", arena.chunk_count);
+
+    arena_reset(&arena);
+    arena_trim(&arena);
+    printf("After trim: %zu chunks, %zu bytes reserved\n\n", arena.chunk_count, arena.reserved);
+    arena_destroy(&arena);
+}
+
+void checkpoint_example() {
+    printf("2.4 Checkpoints and Scoped Scratch Memory\n");
+    printf("------------------------------------------\n");
+
+    Arena arena;
+    arena_init(&arena, 0);
+
+    char* keep = arena_strdup(&arena, "long-lived");
+    ArenaMark mark = arena_mark(&arena);
+    for (int i = 0; i < 10; i++) arena_alloc(&arena, 256);
+    printf("Before rollback: %zu bytes\n", arena_bytes_used(&arena));
+    arena_rollback(&arena, mark);
+    printf("After rollback:  %zu bytes, kept string: %s\n", arena_bytes_used(&arena), keep);
+
+    ARENA_SCOPE(&arena) {
+        char* tmp = arena_strdup(&arena, "scoped temporary");
+        printf("Inside scope:    %zu bytes (%s)\n", arena_bytes_used(&arena), tmp);
+    }
+    printf("After scope:     %zu bytes\n\n", arena_bytes_used(&arena));
+    arena_destroy(&arena);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Tie each arena to a clear lifetime: one request, one frame, one parse.
+2. Pick a chunk size that covers a typical request so most requests use one chunk.
+3. Reset and reuse an arena instead of destroying and re-creating it.
+4. Keep long-lived data out of short-lived arenas (copy it out before the reset).
+
+Common Pitfalls:
+1. Holding a pointer into an arena after arena_reset() or arena_rollback().
+2. Leaving an ARENA_SCOPE block with 'break' or 'return', which skips the rollback.
+3. Putting objects with their own resources (files, sockets) in an arena and never
+   closing them, because no per-object destructor runs.
+4. Unbounded growth when a loop allocates but never resets.
+
+Advanced Tips:
+1. Nest marks for recursive algorithms: mark on entry, roll back on exit.
+2. Use a per-thread scratch arena for temporary buffers instead of malloc.
+3. Call arena_trim() after an unusually large request to give memory back.
+
+4. Integration and Real-World Applications
+==========================================
+- Web servers and RPC frameworks: per-request arenas (Apache APR pools, nginx pools).
+- Compilers: AST nodes and symbol tables allocated in one region per translation unit.
+- Parsers: Chapter5ArraysAndStrings/CharacterArraysAndStrings.c parses config lines
+  into an arena and drops each reload with one arena_reset().
+- Games: per-frame allocators reset at the start of every frame.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Virtual-memory arenas reserve a huge address range up front and commit pages as
+  needed, so the arena never moves and never chains.
+- Region-based memory management in languages (Cyclone, Rust's bumpalo crate) checks
+  lifetimes statically.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Can I free one object from an arena?
+A: No. If individual objects need freeing, use a pool (pool_alloc.h) instead.
+
+Q: Why does arena_bytes_used() exceed the sum of my requests?
+A: It includes alignment padding and the unused tail of chunks that were skipped.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- David R. Hanson, "C Interfaces and Implementations", chapter on arenas.
+- Apache Portable Runtime memory pools.
+- PostgreSQL src/backend/utils/mmgr (memory contexts).
+
+8. Performance Analysis and Optimization
+========================================
+The benchmark simulates request handling: each request builds 64 small records with a
+name string. The malloc version frees every object at the end of the request; the
+arena version resets once.
+*/
+
+#define REQUESTS 2000
+#define RECORDS_PER_REQUEST 64
+
+void requests_malloc_run(void* ctx) {
+    (void)ctx;
+    Record* records[RECORDS_PER_REQUEST];
+    for (int r = 0; r < REQUESTS; r++) {
+        for (int i = 0; i < RECORDS_PER_REQUEST; i++) {
+            records[i] = (Record*)malloc(sizeof(Record));
+            records[i]->id = i;
+            records[i]->name = strdup("request-scoped name");
+        }
+        BENCH_DO_NOT_OPTIMIZE(records[RECORDS_PER_REQUEST - 1]);
+        for (int i = 0; i < RECORDS_PER_REQUEST; i++) {
+            free(records[i]->name);
+            free(records[i]);
+        }
+    }
+}
+
+void requests_arena_run(void* ctx) {
+    Arena* arena = (Arena*)ctx;
+    Record* records[RECORDS_PER_REQUEST];
+    for (int r = 0; r < REQUESTS; r++) {
+        for (int i = 0; i < RECORDS_PER_REQUEST; i++) {
+            records[i] = (Record*)arena_alloc(arena, sizeof(Record));
+            records[i]->id = i;
+            records[i]->name = arena_strdup(arena, "request-scoped name");
+        }
+        BENCH_DO_NOT_OPTIMIZE(records[RECORDS_PER_REQUEST - 1]);
+        arena_reset(arena);
+    }
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    Arena arena;
+    arena_init(&arena, 0);
+    BenchSuite suite;
+
+    bench_suite_init(&suite, "Per-request allocation (64 records + strings)");
+    bench_suite_run(&suite, "malloc + free each object", requests_malloc_run, NULL,
+                    REQUESTS * RECORDS_PER_REQUEST * 2);
+    bench_suite_run(&suite, "arena + one reset", requests_arena_run, &arena,
+                    REQUESTS * RECORDS_PER_REQUEST * 2);
+    bench_suite_report(&suite);
+
+    printf("Arena chunks: %zu, reserved bytes: %zu\n\n", arena.chunk_count, arena.reserved);
+    arena_destroy(&arena);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o arena_allocator ArenaAllocator.c -O2
+
+Then execute the resulting binary:
+    ./arena_allocator
+*/
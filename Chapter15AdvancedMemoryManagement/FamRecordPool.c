@@ -0,0 +1,471 @@
+/*
+Cheat Sheet: Pooling Flexible-Array-Member Records in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+A flexible array member (C99) puts a variable-length tail at the end of a struct:
+
+    typedef struct { uint32_t id; uint16_t length; uint8_t payload[]; } Message;
+    Message* m = malloc(sizeof(Message) + n);
+
+Chapter8StructuresAndUnions/NestedStructures.c allocates records this way, one
+malloc per record. That is fine for a few records. For tens of millions of small
+ones, every record pays for a malloc header and rounding to 16 bytes. The
+program also keeps an 8-byte pointer to each record, and churn leaves holes the
+heap cannot return to the system.
+
+Key points:
+- Round the record size to a size class and pack records of one class back to
+  back in slabs (pool_alloc.h does the same for fixed-size objects).
+- Refer to records by 32-bit handles. A handle table maps each handle to its
+  slot, so records can move.
+- Moving records (compaction) turns holes left by churn back into whole free
+  slabs, which can be released.
+
+Historical context:
+- Handle-based memory managers let the classic Mac OS (1984) and Windows 3.x
+  move heap blocks around while applications held handles.
+- Compacting and copying garbage collectors (Cheney, 1970) apply compaction to
+  whole heaps.
+- Redis, memcached's slab classes and Linux's zsmalloc size-class small records
+  to limit fragmentation.
+
+The implementation lives in fam_pool.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "fam_pool.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+typedef struct {
+    uint32_t id;
+    uint16_t length;
+    uint16_t kind;
+    uint8_t payload[];
+} Message;
+
+// Function prototypes
+void basic_fam_pool_usage();
+void size_class_rounding();
+void compaction_example();
+void batch_create_example();
+void performance_comparison();
+
+int main() {
+    printf("Flexible-Array-Member Record Pool Cheat Sheet\n");
+    printf("=============================================\n\n");
+
+    basic_fam_pool_usage();
+    size_class_rounding();
+    compaction_example();
+    batch_create_example();
+    performance_comparison();
+
+    return 0;
+}
+
+static void message_fill(Message* m, uint32_t id, uint16_t length) {
+    m->id = id;
+    m->length = length;
+    m->kind = (uint16_t)(id % 7);
+    for (uint16_t i = 0; i < length; i++) m->payload[i] = (uint8_t)(id + i);
+}
+
+void basic_fam_pool_usage() {
+    printf("2.1 Creating Records Behind Handles\n");
+    printf("-----------------------------------\n");
+
+    FamPool pool;
+    if (FAM_POOL_INIT(&pool, Message, payload) != 0) {
+        fprintf(stderr, "Pool initialization failed\n");
+        return;
+    }
+    FamHandle h = fam_pool_create(&pool, 11);
+    if (h == 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        fam_pool_destroy(&pool);
+        return;
+    }
+    Message* m = (Message*)fam_pool_get(&pool, h);
+    message_fill(m, 42, 11);
+    memcpy(m->payload, "hello world", 11);
+    printf("Handle %u -> message %u: %.*s\n", h, m->id, (int)m->length, (const char*)m->payload);
+    printf("The record takes %zu bytes; malloc would take sizeof(Message) + 11 = %zu plus its header\n\n",
+           fam_pool_record_size(&pool, h), sizeof(Message) + 11);
+    fam_pool_free(&pool, h);
+    fam_pool_destroy(&pool);
+}
+
+void size_class_rounding() {
+    printf("2.2 Size Classes and Spare Tail Capacity\n");
+    printf("----------------------------------------\n");
+
+    FamPool pool;
+    if (FAM_POOL_INIT(&pool, Message, payload) != 0) return;
+    size_t lengths[] = {0, 1, 8, 25, 120, 300, 2000};
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        FamHandle h = fam_pool_create(&pool, lengths[i]);
+        if (h == 0) continue;
+        if (fam_pool_record_size(&pool, h) > 0) {
+            printf("payload %4zu -> class %4zu bytes, room for %zu payload bytes\n", lengths[i],
+                   fam_pool_record_size(&pool, h), fam_pool_capacity(&pool, h));
+        } else {
+            printf("payload %4zu -> malloc fallback\n", lengths[i]);
+        }
+        fam_pool_free(&pool, h);
+    }
+    fam_pool_destroy(&pool);
+    printf("\n");
+}
+
+void compaction_example() {
+    printf("2.3 Compaction Keeps Handles Valid\n");
+    printf("----------------------------------\n");
+
+    enum { N = 20000 };
+    static FamHandle handles[N];
+    FamPool pool;
+    if (FAM_POOL_INIT(&pool, Message, payload) != 0) return;
+    for (int i = 0; i < N; i++) {
+        handles[i] = fam_pool_create(&pool, 20);
+        if (handles[i] == 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            fam_pool_destroy(&pool);
+            return;
+        }
+        message_fill((Message*)fam_pool_get(&pool, handles[i]), (uint32_t)i, 20);
+    }
+    // Free three records out of four: every slab keeps a few live records
+    for (int i = 0; i < N; i++) {
+        if (i % 4 != 0) {
+            fam_pool_free(&pool, handles[i]);
+            handles[i] = 0;
+        }
+    }
+    size_t before = fam_pool_reserved_bytes(&pool);
+    long moved = fam_pool_compact(&pool);
+    size_t after = fam_pool_reserved_bytes(&pool);
+
+    int intact = 1;
+    for (int i = 0; i < N; i += 4) {
+        const Message* m = (const Message*)fam_pool_get(&pool, handles[i]);
+        if (m->id != (uint32_t)i || m->payload[19] != (uint8_t)(i + 19)) intact = 0;
+    }
+    printf("%zu live records, %ld moved, pool memory %zu KB -> %zu KB\n", pool.live, moved, before / 1024,
+           after / 1024);
+    printf("Records intact after compaction: %s\n\n", intact ? "Yes" : "No");
+    fam_pool_destroy(&pool);
+}
+
+void batch_create_example() {
+    printf("2.4 Batch Creation\n");
+    printf("------------------\n");
+
+    size_t lengths[6] = {3, 17, 17, 64, 5, 900};
+    FamHandle handles[6];
+    FamPool pool;
+    if (FAM_POOL_INIT(&pool, Message, payload) != 0) return;
+    if (fam_pool_create_batch(&pool, lengths, 6, handles) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        fam_pool_destroy(&pool);
+        return;
+    }
+    for (int i = 0; i < 6; i++) message_fill((Message*)fam_pool_get(&pool, handles[i]), (uint32_t)i, (uint16_t)lengths[i]);
+    printf("Created %zu records in one call; handle table capacity %zu\n", pool.live, pool.entry_capacity);
+    printf("Record 5 has payload length %u\n\n", ((Message*)fam_pool_get(&pool, handles[5]))->length);
+    fam_pool_destroy(&pool);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Store handles, not pointers, in long-lived structures. Call fam_pool_get()
+   when the record is used.
+2. Compact at quiet points (after a large delete, between batches), not after
+   every free: it walks the whole handle table.
+3. Use fam_pool_create_batch() when loading many records at once.
+4. Use fam_pool_capacity() to append to a record in place before recreating it.
+
+Common Pitfalls:
+1. Keeping a pointer from fam_pool_get() across fam_pool_compact().
+2. Using a handle after fam_pool_free(): the entry is reused by the next create.
+3. Reading past the length the record was created with: the class may have
+   spare bytes, but their contents are undefined.
+4. Records that need 16-byte alignment (long double, SSE vectors) are rejected.
+
+Advanced Tips:
+1. A generation counter in the upper bits of the handle catches use after free.
+2. Per-thread pools avoid locking. Hand records between threads by copying.
+3. Compacting one class at a time bounds the pause.
+
+4. Integration and Real-World Applications
+==========================================
+- Message brokers and queues holding millions of small payloads.
+- In-memory key-value stores (values, small strings).
+- Network flow tables with variable-length metadata.
+- Document and JSON stores with many short fields.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Mesh (Powers et al., 2019) merges sparsely used pages without handles by
+  remapping virtual memory.
+- Compressed pools (Linux zsmalloc for zram) store records in fewer bytes than
+  their class.
+- Memory tagging (ARM MTE) detects stale pointers in hardware.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why does memory not drop after freeing records?
+A: Freed slots are reused but the slabs stay. Call fam_pool_compact() to move
+   records down and release the empty slabs.
+
+Q: Why use 8-byte steps for small classes?
+A: Small messages dominate the counts. 8-byte steps waste at most 7 bytes per
+   record, where 16-byte steps waste up to 15.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- /proc/self/statm and /proc/self/smaps: resident memory on Linux
+- malloc_stats() and malloc_info() (glibc): heap fragmentation
+- "Mesh: Compacting Memory Management for C/C++ Applications" (Powers et al., 2019)
+- memcached slab allocator documentation
+
+8. Performance Analysis and Optimization
+========================================
+Two measurements with messages of 0-59 payload bytes (16-75 byte records):
+- Allocation rate: create and then free 1M messages with malloc/free, one
+  fam_pool_create per record and one fam_pool_create_batch call.
+- Resident memory: 4M live messages, each in its own process so the runs do
+  not share heap pages. Memory is measured after loading, after churning half
+  of the messages with new lengths, and (for the pool) after compacting. The
+  pointer or handle array is included.
+
+Typical results (gcc -O2, x86-64, glibc):
+- Create + free: malloc/free 49 ns per message, FamPool 15-16 ns (3x). The
+  batch call is no faster once the slabs exist; it saves the growth steps on
+  a cold pool and makes the batch all-or-nothing.
+- Loaded: malloc 60 bytes per message, FamPool 47 (21% less).
+- Every other message freed: malloc stays at 239 MB, because every page
+  still holds live messages. FamPool frees the same pages after compaction:
+  190 MB -> 108 MB, 54 bytes per live message against malloc's 120.
+*/
+
+#define RATE_RECORDS 1000000
+#define RSS_RECORDS 4000000
+#define FAM_PAYLOAD_MAX 60
+
+typedef struct {
+    FamPool* pool;
+    int batch;
+    size_t* lengths;
+    Message** pointers;
+    FamHandle* handles;
+} FamRateBench;
+
+void fam_rate_run(void* ctx) {
+    FamRateBench* b = (FamRateBench*)ctx;
+    if (b->pool == NULL) {
+        for (size_t i = 0; i < RATE_RECORDS; i++) {
+            b->pointers[i] = (Message*)malloc(sizeof(Message) + b->lengths[i]);
+            b->pointers[i]->length = (uint16_t)b->lengths[i];
+        }
+        for (size_t i = 0; i < RATE_RECORDS; i++) free(b->pointers[i]);
+        return;
+    }
+    if (b->batch) {
+        if (fam_pool_create_batch(b->pool, b->lengths, RATE_RECORDS, b->handles) != 0) return;
+    } else {
+        for (size_t i = 0; i < RATE_RECORDS; i++) {
+            b->handles[i] = fam_pool_create(b->pool, b->lengths[i]);
+            if (b->handles[i] == 0) {
+                while (i > 0) fam_pool_free(b->pool, b->handles[--i]);
+                return;
+            }
+        }
+    }
+    for (size_t i = 0; i < RATE_RECORDS; i++) {
+        ((Message*)fam_pool_get(b->pool, b->handles[i]))->length = (uint16_t)b->lengths[i];
+    }
+    for (size_t i = 0; i < RATE_RECORDS; i++) fam_pool_free(b->pool, b->handles[i]);
+}
+
+// Resident set size in bytes from /proc/self/statm, or 0 where that is unavailable.
+static size_t resident_bytes(void) {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f == NULL) return 0;
+    unsigned long size = 0, resident = 0;
+    int fields = fscanf(f, "%lu %lu", &size, &resident);
+    fclose(f);
+    return fields == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+static void print_rss(const char* label, const char* phase, size_t base, size_t records) {
+    size_t now = resident_bytes();
+    if (now == 0) {
+        printf("  %-8s %-16s n/a\n", label, phase);
+        return;
+    }
+    printf("  %-8s %-16s %7.1f MB  %5.1f bytes/record\n", label, phase, (double)(now - base) / 1e6,
+           (double)(now - base) / (double)records);
+}
+
+// Asks malloc to hand free pages back to the system, where the C library allows it.
+static void release_free_pages(void) {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+static uint32_t rss_next_length(uint32_t* x) {
+    *x = *x * 1103515245u + 12345u;
+    return (*x >> 8) % FAM_PAYLOAD_MAX;
+}
+
+static void rss_malloc_child(void) {
+    size_t base = resident_bytes();
+    Message** messages = (Message**)malloc(RSS_RECORDS * sizeof(Message*));
+    if (messages == NULL) return;
+    uint32_t x = 7;
+    for (size_t i = 0; i < RSS_RECORDS; i++) {
+        uint32_t n = rss_next_length(&x);
+        messages[i] = (Message*)malloc(sizeof(Message) + n);
+        if (messages[i] == NULL) return;
+        message_fill(messages[i], (uint32_t)i, (uint16_t)n);
+    }
+    print_rss("malloc", "loaded", base, RSS_RECORDS);
+    // Churn: replace every other message with one of a new length
+    for (size_t i = 0; i < RSS_RECORDS; i += 2) free(messages[i]);
+    for (size_t i = 0; i < RSS_RECORDS; i += 2) {
+        uint32_t n = rss_next_length(&x);
+        messages[i] = (Message*)malloc(sizeof(Message) + n);
+        if (messages[i] == NULL) return;
+        message_fill(messages[i], (uint32_t)i, (uint16_t)n);
+    }
+    print_rss("malloc", "after churn", base, RSS_RECORDS);
+    // Free every other message: each page keeps some live records
+    for (size_t i = 0; i < RSS_RECORDS; i += 2) free(messages[i]);
+    release_free_pages();
+    print_rss("malloc", "half freed", base, RSS_RECORDS / 2);
+}
+
+static void rss_pool_child(void) {
+    size_t base = resident_bytes();
+    FamPool pool;
+    FamHandle* handles = (FamHandle*)malloc(RSS_RECORDS * sizeof(FamHandle));
+    if (handles == NULL || FAM_POOL_INIT(&pool, Message, payload) != 0) return;
+    uint32_t x = 7;
+    for (size_t i = 0; i < RSS_RECORDS; i++) {
+        uint32_t n = rss_next_length(&x);
+        handles[i] = fam_pool_create(&pool, n);
+        if (handles[i] == 0) return;
+        message_fill((Message*)fam_pool_get(&pool, handles[i]), (uint32_t)i, (uint16_t)n);
+    }
+    print_rss("FamPool", "loaded", base, RSS_RECORDS);
+    for (size_t i = 0; i < RSS_RECORDS; i += 2) fam_pool_free(&pool, handles[i]);
+    for (size_t i = 0; i < RSS_RECORDS; i += 2) {
+        uint32_t n = rss_next_length(&x);
+        handles[i] = fam_pool_create(&pool, n);
+        if (handles[i] == 0) return;
+        message_fill((Message*)fam_pool_get(&pool, handles[i]), (uint32_t)i, (uint16_t)n);
+    }
+    print_rss("FamPool", "after churn", base, RSS_RECORDS);
+    for (size_t i = 0; i < RSS_RECORDS; i += 2) fam_pool_free(&pool, handles[i]);
+    release_free_pages();
+    print_rss("FamPool", "half freed", base, RSS_RECORDS / 2);
+    if (fam_pool_compact(&pool) < 0) return;
+    release_free_pages();
+    print_rss("FamPool", "compacted", base, RSS_RECORDS / 2);
+}
+
+static void run_in_child(void (*fn)(void)) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        fflush(stdout);
+        _exit(0);
+    }
+    if (pid > 0) waitpid(pid, NULL, 0);
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    size_t* lengths = (size_t*)malloc(RATE_RECORDS * sizeof(size_t));
+    Message** pointers = (Message**)malloc(RATE_RECORDS * sizeof(Message*));
+    FamHandle* handles = (FamHandle*)malloc(RATE_RECORDS * sizeof(FamHandle));
+    FamPool pool;
+    if (lengths == NULL || pointers == NULL || handles == NULL || FAM_POOL_INIT(&pool, Message, payload) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(lengths);
+        free(pointers);
+        free(handles);
+        return;
+    }
+    uint32_t x = 3;
+    for (size_t i = 0; i < RATE_RECORDS; i++) lengths[i] = rss_next_length(&x);
+
+    FamRateBench with_malloc = {NULL, 0, lengths, pointers, handles};
+    FamRateBench with_pool = {&pool, 0, lengths, pointers, handles};
+    FamRateBench with_batch = {&pool, 1, lengths, pointers, handles};
+    BenchSuite suite;
+    bench_suite_init(&suite, "Create + free 1M messages (0-59 byte payloads)");
+    bench_suite_run(&suite, "malloc/free", fam_rate_run, &with_malloc, RATE_RECORDS);
+    bench_suite_run(&suite, "fam_pool_create", fam_rate_run, &with_pool, RATE_RECORDS);
+    bench_suite_run(&suite, "fam_pool_create_batch", fam_rate_run, &with_batch, RATE_RECORDS);
+    bench_suite_report(&suite);
+    fam_pool_destroy(&pool);
+    free(lengths);
+    free(pointers);
+    free(handles);
+
+    printf("\nResident memory for 4M live messages (average payload 29.5 bytes):\n");
+    run_in_child(rss_malloc_child);
+    run_in_child(rss_pool_child);
+    printf("\n");
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o fam_record_pool FamRecordPool.c -O2
+
+Then execute the resulting binary:
+    ./fam_record_pool
+*/
@@ -0,0 +1,331 @@
+/*
+Cheat Sheet: Pool (Slab) Allocators in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+A pool allocator hands out objects of one fixed size from large pre-allocated blocks
+("slabs"). Because every object is the same size, a freed object can be reused for the
+next allocation without searching, splitting or coalescing, and no per-object header
+is needed.
+
+Key points:
+- Free objects are linked through their own storage (an intrusive free list), so
+  alloc and free are a single pointer pop and push.
+- Size classes extend the idea to variable sizes: round the request up to the next
+  class and use that class's pool.
+- Per-thread caches remove lock contention: each thread allocates from its own free
+  list and only touches shared state to exchange whole batches of objects.
+
+Historical context:
+- Jeff Bonwick's slab allocator (SunOS 5.4, 1994) introduced object caches to the kernel.
+- Magazines and depots (Bonwick & Adams, 2001) added per-CPU caches with batch exchange.
+- tcmalloc, jemalloc and mimalloc all use size classes with thread-local free lists.
+
+The implementation lives in pool_alloc.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "pool_alloc.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// Function prototypes
+void basic_pool_usage();
+void object_reuse_example();
+void size_class_example();
+void multithreaded_example();
+void performance_comparison();
+
+int main() {
+    printf("Pool (Slab) Allocator Cheat Sheet\n");
+    printf("=================================\n\n");
+
+    basic_pool_usage();
+    object_reuse_example();
+    size_class_example();
+    multithreaded_example();
+    performance_comparison();
+
+    return 0;
+}
+
+typedef struct Particle {
+    float x, y, z;
+    float vx, vy, vz;
+    int id;
+} Particle;
+
+void basic_pool_usage() {
+    printf("2.1 Basic Pool Usage\n");
+    printf("---------------------\n");
+
+    SlabPool pool;
+    if (slab_pool_init(&pool, sizeof(Particle)) != 0) {
+        fprintf(stderr, "Pool initialization failed\n");
+        return;
+    }
+
+    Particle* p = (Particle*)slab_pool_alloc(&pool);
+    if (p) {
+        p->id = 7;
+        p->x = p->y = p->z = 0.0f;
+        printf("Allocated particle %d, object size in pool: %zu bytes\n", p->id, pool.object_size);
+        slab_pool_free(&pool, p);
+    }
+
+    slab_pool_destroy(&pool);
+    printf("\n");
+}
+
+void object_reuse_example() {
+    printf("2.2 O(1) Reuse Through the Intrusive Free List\n");
+    printf("-----------------------------------------------\n");
+
+    SlabPool pool;
+    if (slab_pool_init(&pool, sizeof(Particle)) != 0) return;
+
+    void* first = slab_pool_alloc(&pool);
+    slab_pool_free(&pool, first);
+    void* second = slab_pool_alloc(&pool);
+    printf("Freed object reused immediately: %s\n", first == second ? "Yes" : "No");
+    slab_pool_free(&pool, second);
+
+    slab_pool_destroy(&pool);
+    printf("\n");
+}
+
+void size_class_example() {
+    printf("2.3 Size Classes\n");
+    printf("-----------------\n");
+
+    SizeClassPool sp;
+    if (size_class_pool_init(&sp) != 0) return;
+
+    size_t sizes[] = {1, 16, 17, 100, 700, 1024, 4096};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        void* p = size_class_pool_alloc(&sp, sizes[i]);
+        if (sizes[i] <= POOL_MAX_CLASS_SIZE) {
+            printf("request %4zu bytes -> class %4zu\n", sizes[i],
+                   sp.classes[sp.class_of[(sizes[i] + 15) / 16]].object_size);
+        } else {
+            printf("request %4zu bytes -> malloc fallback\n", sizes[i]);
+        }
+        size_class_pool_free(&sp, p, sizes[i]);
+    }
+
+    size_class_pool_destroy(&sp);
+    printf("\n");
+}
+
+// Each worker allocates and frees objects it owns, and half of them are freed by a
+// different thread, exercising the depot hand-off between caches.
+#define WORKERS 4
+#define WORKER_OBJECTS 20000
+
+typedef struct {
+    SlabPool* pool;
+    Particle** objects;
+    int id;
+    int errors;
+} WorkerArgs;
+
+void* pool_worker(void* arg) {
+    WorkerArgs* w = (WorkerArgs*)arg;
+    for (int i = 0; i < WORKER_OBJECTS; i++) {
+        Particle* p = (Particle*)slab_pool_alloc(w->pool);
+        if (p == NULL) {
+            w->errors++;
+            continue;
+        }
+        p->id = w->id * WORKER_OBJECTS + i;
+        w->objects[i] = p;
+    }
+    // Verify nobody else was handed the same object
+    for (int i = 0; i < WORKER_OBJECTS; i++) {
+        if (w->objects[i] && w->objects[i]->id != w->id * WORKER_OBJECTS + i) w->errors++;
+    }
+    // Free the first half here; the main thread frees the rest
+    for (int i = 0; i < WORKER_OBJECTS / 2; i++) {
+        slab_pool_free(w->pool, w->objects[i]);
+        w->objects[i] = NULL;
+    }
+    return NULL;
+}
+
+void multithreaded_example() {
+    printf("2.4 Thread Caches and the Shared Depot\n");
+    printf("---------------------------------------\n");
+
+    SlabPool pool;
+    if (slab_pool_init(&pool, sizeof(Particle)) != 0) return;
+
+    pthread_t threads[WORKERS];
+    WorkerArgs args[WORKERS];
+    for (int t = 0; t < WORKERS; t++) {
+        args[t].pool = &pool;
+        args[t].objects = (Particle**)calloc(WORKER_OBJECTS, sizeof(Particle*));
+        args[t].id = t;
+        args[t].errors = 0;
+        pthread_create(&threads[t], NULL, pool_worker, &args[t]);
+    }
+
+    int errors = 0;
+    for (int t = 0; t < WORKERS; t++) {
+        pthread_join(threads[t], NULL);
+        errors += args[t].errors;
+        for (int i = 0; i < WORKER_OBJECTS; i++) {
+            if (args[t].objects[i]) slab_pool_free(&pool, args[t].objects[i]);
+        }
+        free(args[t].objects);
+    }
+
+    printf("%d threads x %d objects, errors: %d\n", WORKERS, WORKER_OBJECTS, errors);
+    printf("Slabs: %zu, batches waiting in depot: %zu\n\n", pool.slab_count, pool.depot_batches);
+    slab_pool_destroy(&pool);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Create one pool per hot object type; the object size is then known at init time.
+2. Return objects to the pool they came from.
+3. Destroy a pool in one step at shutdown instead of freeing objects one by one.
+4. Tune POOL_BATCH_SIZE: larger batches mean fewer lock acquisitions but more memory
+   parked in idle thread caches.
+
+Common Pitfalls:
+1. Freeing a pool object with free(), or a malloc'd object with slab_pool_free().
+2. Use-after-free is harder to detect: freed memory stays mapped and is reused fast.
+3. Destroying a pool while other threads still hold cached objects.
+4. Memory never returns to the OS until the pool is destroyed.
+
+Advanced Tips:
+1. Run tests under AddressSanitizer with malloc instead of the pool to catch misuse.
+2. Align object_size to 64 bytes for objects written by different threads to avoid
+   false sharing.
+3. Pre-warm a pool (allocate and free N objects) before latency-sensitive phases.
+
+4. Integration and Real-World Applications
+==========================================
+- Network servers: connection and request objects.
+- Game engines: particles, entities and components.
+- Databases: buffer descriptors, lock records, B-tree nodes.
+- Kernels: inode, dentry and socket caches (Linux SLUB).
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Lock-free depots (Treiber stacks with tagged pointers) remove the last mutex.
+- Remote-free queues let objects freed by another thread return to their owner.
+- Huge-page-backed slabs reduce TLB misses for very large pools.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why is the minimum object size two pointers?
+A: A free object stores the free-list link and, while parked in the depot, the link
+   to the next batch.
+
+Q: Memory usage keeps growing even though I free objects. Why?
+A: Pools keep freed memory for reuse. Check for leaks with a malloc-backed build.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- "The Slab Allocator: An Object-Caching Kernel Memory Allocator" (Bonwick, 1994)
+- "Magazines and Vmem" (Bonwick & Adams, 2001)
+- mimalloc technical report (Leijen et al., 2019)
+- jemalloc and tcmalloc source code
+
+8. Performance Analysis and Optimization
+========================================
+The benchmark below compares malloc/free with the slab pool for the particle type in
+an allocation-heavy simulation step: every step frees a random particle and creates
+a new one. Chapter7MemoryManagement/DynamicMemoryAllocation.c runs the same comparison
+for pairs, bulk and churn mixes.
+*/
+
+#define CHURN_LIVE 8192
+#define CHURN_STEPS 1000000
+
+typedef struct {
+    SlabPool* pool;
+    Particle** live;
+} ChurnBench;
+
+void particle_churn_run(void* ctx) {
+    ChurnBench* bench = (ChurnBench*)ctx;
+    unsigned int x = 12345;
+    for (int i = 0; i < CHURN_STEPS; i++) {
+        x = x * 1103515245u + 12345u;
+        int victim = (x >> 8) % CHURN_LIVE;
+        if (bench->pool) {
+            slab_pool_free(bench->pool, bench->live[victim]);
+            bench->live[victim] = (Particle*)slab_pool_alloc(bench->pool);
+        } else {
+            free(bench->live[victim]);
+            bench->live[victim] = (Particle*)malloc(sizeof(Particle));
+        }
+        bench->live[victim]->id = i;
+    }
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    static Particle* live_malloc[CHURN_LIVE];
+    static Particle* live_pool[CHURN_LIVE];
+    SlabPool pool;
+    if (slab_pool_init(&pool, sizeof(Particle)) != 0) return;
+    for (int i = 0; i < CHURN_LIVE; i++) {
+        live_malloc[i] = (Particle*)malloc(sizeof(Particle));
+        live_pool[i] = (Particle*)slab_pool_alloc(&pool);
+    }
+
+    ChurnBench with_malloc = {NULL, live_malloc};
+    ChurnBench with_pool = {&pool, live_pool};
+    BenchSuite suite;
+    bench_suite_init(&suite, "Particle churn (8K live objects)");
+    bench_suite_run(&suite, "malloc/free", particle_churn_run, &with_malloc, CHURN_STEPS);
+    bench_suite_run(&suite, "slab pool", particle_churn_run, &with_pool, CHURN_STEPS);
+    bench_suite_report(&suite);
+
+    for (int i = 0; i < CHURN_LIVE; i++) free(live_malloc[i]);
+    slab_pool_destroy(&pool);  // Releases every live_pool object at once
+    printf("\n");
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o pool_allocator PoolAllocator.c -O2 -pthread
+
+Then execute the resulting binary:
+    ./pool_allocator
+*/
@@ -0,0 +1,231 @@
+/*
+arena.h - Growable Arena (Region) Allocator
+================================================
+
+A header-only arena for data that shares one lifetime, such as everything allocated
+while handling a single request or parsing a single file. Allocation is a pointer bump;
+there is no per-object free. Instead the whole arena is reset in O(1), or rolled back to
+a checkpoint taken earlier with arena_mark().
+
+Design:
+- Memory comes from a chain of malloc'd chunks (ARENA_DEFAULT_CHUNK bytes by default).
+  When the current chunk is full the arena moves to the next chunk in the chain, or
+  links in a new one. Requests larger than a chunk get a dedicated, larger chunk.
+- Every allocation is aligned to _Alignof(max_align_t) unless an explicit alignment is
+  requested with arena_alloc_aligned().
+- Reset and rollback never free chunks; they rewind the "current" position so the same
+  memory is reused by the next request without returning to malloc. Call arena_trim()
+  to release chunks beyond the current position, and arena_destroy() to free everything.
+
+Usage:
+    Arena arena;
+    arena_init(&arena, 0);                 // 0 selects ARENA_DEFAULT_CHUNK
+    for (each request) {
+        char* line = arena_strdup(&arena, input);
+        ...
+        arena_reset(&arena);               // frees the whole request in O(1)
+    }
+    arena_destroy(&arena);
+
+Checkpoints:
+    ArenaMark mark = arena_mark(&arena);
+    ... temporary allocations ...
+    arena_rollback(&arena, mark);          // everything after the mark is released
+
+    ARENA_SCOPE(&arena) { ... }            // same, as a block; do not 'break' or
+                                           // 'return' out of it or the rollback is skipped
+
+Tracing: with -DTRACE_ENABLE, new chunks are timed as "arena" zones and counted in
+the arena.chunks and arena.reserved_bytes counters (Chapter18DebuggingAndProfiling/trace.h).
+The bump path is not instrumented.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Chapter18DebuggingAndProfiling/trace.h"
+
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t capacity;           // Usable bytes after the header
+    size_t used;
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk* first;
+    ArenaChunk* current;
+    size_t chunk_size;
+    size_t chunk_count;
+    size_t reserved;           // Bytes obtained from malloc (headers included)
+} Arena;
+
+typedef struct {
+    ArenaChunk* chunk;
+    size_t used;
+    int active_;               // Loop flag for ARENA_SCOPE
+} ArenaMark;
+
+#define ARENA_ALIGN _Alignof(max_align_t)
+#define ARENA_HEADER_SIZE ((sizeof(ArenaChunk) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static inline char* arena_chunk_data_(ArenaChunk* chunk) {
+    return (char*)chunk + ARENA_HEADER_SIZE;
+}
+
+static inline void arena_init(Arena* arena, size_t chunk_size) {
+    memset(arena, 0, sizeof(*arena));
+    arena->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK;
+}
+
+static inline void arena_destroy(Arena* arena) {
+    ArenaChunk* chunk = arena->first;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    memset(arena, 0, sizeof(*arena));
+}
+
+static inline ArenaChunk* arena_new_chunk_(Arena* arena, size_t min_capacity) {
+    size_t capacity = arena->chunk_size > min_capacity ? arena->chunk_size : min_capacity;
+    if (capacity > SIZE_MAX - ARENA_HEADER_SIZE) return NULL;
+    TRACE_ZONE_BEGIN(zone, "arena", "arena new chunk");
+    ArenaChunk* chunk = (ArenaChunk*)malloc(ARENA_HEADER_SIZE + capacity);
+    TRACE_ZONE_END(zone);
+    if (chunk == NULL) return NULL;
+    TRACE_COUNTER_ADD("arena.chunks", 1);
+    TRACE_COUNTER_ADD("arena.reserved_bytes", ARENA_HEADER_SIZE + capacity);
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    arena->chunk_count++;
+    arena->reserved += ARENA_HEADER_SIZE + capacity;
+    return chunk;
+}
+
+// Offset within 'chunk' at which an object with 'align' would start, or SIZE_MAX.
+static inline size_t arena_fit_(ArenaChunk* chunk, size_t size, size_t align) {
+    uintptr_t base = (uintptr_t)arena_chunk_data_(chunk);
+    uintptr_t p = (base + chunk->used + align - 1) & ~(uintptr_t)(align - 1);
+    size_t offset = (size_t)(p - base);
+    if (offset > chunk->capacity || chunk->capacity - offset < size) return SIZE_MAX;
+    return offset;
+}
+
+// 'align' must be a power of two. Returns NULL when out of memory.
+static inline void* arena_alloc_aligned(Arena* arena, size_t size, size_t align) {
+    if (align < 1) align = 1;
+    if (arena->current) {
+        size_t offset = arena_fit_(arena->current, size, align);
+        if (offset != SIZE_MAX) {
+            arena->current->used = offset + size;
+            return arena_chunk_data_(arena->current) + offset;
+        }
+    }
+
+    // Reuse a chunk retained by an earlier reset/rollback when it is large enough
+    ArenaChunk* next = arena->current ? arena->current->next : arena->first;
+    if (next && next->capacity >= size + align) {
+        next->used = 0;
+    } else {
+        if (size > SIZE_MAX - align) return NULL;
+        ArenaChunk* chunk = arena_new_chunk_(arena, size + align);
+        if (chunk == NULL) return NULL;
+        chunk->next = next;
+        if (arena->current) arena->current->next = chunk;
+        else arena->first = chunk;
+        next = chunk;
+    }
+    arena->current = next;
+
+    size_t offset = arena_fit_(next, size, align);
+    next->used = offset + size;
+    return arena_chunk_data_(next) + offset;
+}
+
+static inline void* arena_alloc(Arena* arena, size_t size) {
+    return arena_alloc_aligned(arena, size, ARENA_ALIGN);
+}
+
+static inline void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void* p = arena_alloc(arena, count * size);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
+
+// Copy 'len' bytes of 's' and NUL-terminate. Strings need no alignment.
+static inline char* arena_strndup(Arena* arena, const char* s, size_t len) {
+    char* p = (char*)arena_alloc_aligned(arena, len + 1, 1);
+    if (p) {
+        memcpy(p, s, len);
+        p[len] = '\0';
+    }
+    return p;
+}
+
+static inline char* arena_strdup(Arena* arena, const char* s) {
+    return arena_strndup(arena, s, strlen(s));
+}
+
+static inline ArenaMark arena_mark(const Arena* arena) {
+    ArenaMark mark;
+    mark.chunk = arena->current;
+    mark.used = arena->current ? arena->current->used : 0;
+    mark.active_ = 1;
+    return mark;
+}
+
+// Release everything allocated after 'mark'. Chunks stay linked for reuse.
+static inline void arena_rollback(Arena* arena, ArenaMark mark) {
+    if (mark.chunk == NULL) {
+        arena->current = NULL;
+        return;
+    }
+    arena->current = mark.chunk;
+    arena->current->used = mark.used;
+}
+
+// Release every allocation in O(1); the chunks are kept for the next round.
+static inline void arena_reset(Arena* arena) {
+    arena->current = NULL;
+}
+
+// Free the chunks after the current position (all chunks after a reset).
+static inline void arena_trim(Arena* arena) {
+    ArenaChunk* chunk = arena->current ? arena->current->next : arena->first;
+    if (arena->current) arena->current->next = NULL;
+    else arena->first = NULL;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        arena->chunk_count--;
+        arena->reserved -= ARENA_HEADER_SIZE + chunk->capacity;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+// Bytes handed out since the last reset (alignment padding included).
+static inline size_t arena_bytes_used(const Arena* arena) {
+    if (arena->current == NULL) return 0;
+    size_t total = 0;
+    for (ArenaChunk* c = arena->first; c; c = c->next) {
+        total += c->used;
+        if (c == arena->current) break;
+    }
+    return total;
+}
+
+#define ARENA_SCOPE(arena)                                            \
+    for (ArenaMark arena_scope_mark_ = arena_mark(arena);             \
+         arena_scope_mark_.active_;                                   \
+         arena_rollback((arena), arena_scope_mark_), arena_scope_mark_.active_ = 0)
+
+#endif // ARENA_H
@@ -0,0 +1,430 @@
+/*
+fam_pool.h - Size-Class Pool for Flexible-Array-Member Records
+================================================
+
+Allocating each variable-length record with its own
+malloc(sizeof(struct) + n * sizeof(elem)) costs a malloc header (8-16 bytes)
+and rounding per record. After churn it also leaves holes that a heap cannot
+give back. With tens of millions of small records that overhead can approach
+the size of the data. FamPool packs records of similar size into shared slabs
+and hands out 4-byte handles instead of pointers, so it can move records
+together again later.
+
+    typedef struct { uint32_t id; uint16_t length; uint8_t payload[]; } Message;
+
+    FamPool pool;
+    FAM_POOL_INIT(&pool, Message, payload);           // 0, or -1 with errno
+    FamHandle h = fam_pool_create(&pool, 40);          // Room for 40 payload bytes, 0 on failure
+    Message* m = (Message*)fam_pool_get(&pool, h);     // Valid until the next compaction
+    fam_pool_free(&pool, h);
+    fam_pool_compact(&pool);                           // Close the holes, release empty slabs
+    fam_pool_destroy(&pool);
+
+Design:
+- The record size (tail offset + n * element size) is rounded up to one of
+  FAM_POOL_NUM_CLASSES size classes: multiples of 8 up to 128 bytes, then four
+  classes per doubling up to 1 KB. Waste is at most 7 bytes for small records
+  and under 25% above that. fam_pool_capacity() reports how many tail elements
+  the rounded size holds, so a record can grow in place up to that length.
+- Each class stores its records back to back in slabs of FAM_POOL_SLAB_SLOTS
+  records. There is no per-record header. A free slot holds the index of the
+  next free slot, as in pool_alloc.h.
+- A handle indexes a table of 32-bit entries holding the class (5 bits) and
+  the slot within the class (27 bits). fam_pool_get() turns that into a slab
+  and an offset with a shift and a mask. Handles cost 4 bytes in the table and
+  4 in the caller's structures, where a pointer costs 8.
+- fam_pool_compact() moves the highest records of each class into the holes
+  below them, rewrites their handle entries and frees the empty slabs at the
+  end. Handles stay valid; pointers from fam_pool_get() do not. The slabs go
+  back to malloc; on glibc, malloc_trim(0) then returns their pages to the
+  system.
+- fam_pool_create_batch() sizes the slabs and the handle table once for the
+  whole batch and creates every record or none.
+- Records over FAM_POOL_MAX_CLASS_SIZE bytes fall back to malloc, still behind
+  a handle. Compaction leaves them alone.
+- Records are 8-byte aligned, enough for any type up to double, int64_t and
+  pointers. FAM_POOL_INIT rejects types that need more with EINVAL.
+- Functions that allocate return 0 (or a non-zero handle), or -1 (or 0) with
+  errno = ENOMEM. Single-threaded: guard a shared pool with a mutex.
+*/
+
+#ifndef FAM_POOL_H
+#define FAM_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define FAM_POOL_NUM_CLASSES 28
+#define FAM_POOL_MAX_CLASS_SIZE 1024
+#define FAM_POOL_ALIGN 8
+#define FAM_POOL_SLAB_SHIFT 10
+#define FAM_POOL_SLAB_SLOTS (1u << FAM_POOL_SLAB_SHIFT)
+#define FAM_POOL_SLOT_BITS 27
+#define FAM_POOL_SLOT_MASK ((1u << FAM_POOL_SLOT_BITS) - 1)
+#define FAM_POOL_LARGE 30                       // Class field of a malloc'd record
+#define FAM_POOL_FREE_HANDLE 31                 // Class field of an unused handle entry
+#define FAM_POOL_FREE_END UINT32_MAX           // End of a class free list
+
+typedef uint32_t FamHandle;                     // 0 is never a valid handle
+
+typedef struct {
+    size_t size;                                // Bytes per record in this class
+    uint32_t count;                             // Slots carved so far (live or free)
+    uint32_t live;
+    uint32_t free_head;                         // Free slot list, FAM_POOL_FREE_END if empty
+    char** slabs;                               // Slot s is slabs[s >> SHIFT] + (s & (SLOTS - 1)) * size
+    size_t slab_count;
+    size_t slab_capacity;
+} FamPoolClass;
+
+typedef struct {
+    size_t record_size;                         // sizeof(type), the minimum record size
+    size_t tail_offset;                         // offsetof(type, member)
+    size_t element_size;                        // sizeof(member[0])
+    FamPoolClass classes[FAM_POOL_NUM_CLASSES];
+    uint8_t class_of[FAM_POOL_MAX_CLASS_SIZE / 8 + 1];  // (size + 7) / 8 -> class index
+
+    uint32_t* entries;                          // Handle h is entries[h - 1]
+    size_t entry_count;
+    size_t entry_capacity;
+    uint32_t free_handle;                       // Unused entry list (a handle value), 0 if empty
+    size_t free_handles;
+
+    char** large;                               // Records over FAM_POOL_MAX_CLASS_SIZE
+    size_t large_count;
+    size_t large_capacity;
+    uint32_t* large_free;                       // Stack of unused large[] slots
+    size_t large_free_count;
+    size_t large_free_capacity;                 // Always >= large_count
+
+    size_t live;
+} FamPool;
+
+static const uint16_t fam_pool_class_sizes[FAM_POOL_NUM_CLASSES] = {
+    8, 16, 24, 32, 40, 48, 56, 64, 72, 80, 88, 96, 104, 112, 120, 128,
+    160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024
+};
+
+#define FAM_POOL_INIT(pool, type, member) \
+    fam_pool_init((pool), sizeof(type), offsetof(type, member), sizeof(((type*)0)->member[0]), _Alignof(type))
+
+// Returns 0, or -1 with errno = EINVAL if the record type needs more than 8-byte alignment.
+static inline int fam_pool_init(FamPool* pool, size_t record_size, size_t tail_offset, size_t element_size,
+                                size_t align) {
+    memset(pool, 0, sizeof(*pool));
+    if (align > FAM_POOL_ALIGN || element_size == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    pool->record_size = record_size;
+    pool->tail_offset = tail_offset;
+    pool->element_size = element_size;
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) {
+        pool->classes[c].size = fam_pool_class_sizes[c];
+        pool->classes[c].free_head = FAM_POOL_FREE_END;
+    }
+    int c = 0;
+    for (size_t slot = 0; slot <= FAM_POOL_MAX_CLASS_SIZE / 8; slot++) {
+        while (fam_pool_class_sizes[c] < slot * 8) c++;
+        pool->class_of[slot] = (uint8_t)c;
+    }
+    return 0;
+}
+
+static inline void fam_pool_destroy(FamPool* pool) {
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) {
+        FamPoolClass* k = &pool->classes[c];
+        for (size_t s = 0; s < k->slab_count; s++) free(k->slabs[s]);
+        free(k->slabs);
+    }
+    for (size_t i = 0; i < pool->entry_count; i++) {
+        if (pool->entries[i] >> FAM_POOL_SLOT_BITS == FAM_POOL_LARGE) {
+            free(pool->large[pool->entries[i] & FAM_POOL_SLOT_MASK]);
+        }
+    }
+    free(pool->entries);
+    free(pool->large);
+    free(pool->large_free);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// Bytes for a record with n tail elements, or 0 if that overflows.
+static inline size_t fam_pool_record_bytes_(const FamPool* pool, size_t n) {
+    if (n > (SIZE_MAX / 2 - pool->tail_offset) / pool->element_size) return 0;
+    size_t bytes = pool->tail_offset + n * pool->element_size;
+    return bytes < pool->record_size ? pool->record_size : bytes;
+}
+
+static inline unsigned fam_pool_class_(const FamPool* pool, size_t bytes) {
+    return bytes <= FAM_POOL_MAX_CLASS_SIZE ? pool->class_of[(bytes + 7) / 8] : FAM_POOL_LARGE;
+}
+
+static inline char* fam_pool_slot_(const FamPoolClass* k, uint32_t slot) {
+    return k->slabs[slot >> FAM_POOL_SLAB_SHIFT] + (size_t)(slot & (FAM_POOL_SLAB_SLOTS - 1)) * k->size;
+}
+
+static inline void* fam_pool_get(const FamPool* pool, FamHandle h) {
+    uint32_t e = pool->entries[h - 1];
+    unsigned c = e >> FAM_POOL_SLOT_BITS;
+    if (c == FAM_POOL_LARGE) return pool->large[e & FAM_POOL_SLOT_MASK];
+    return fam_pool_slot_(&pool->classes[c], e & FAM_POOL_SLOT_MASK);
+}
+
+// Bytes reserved for h: its size class, or 0 for a large record.
+static inline size_t fam_pool_record_size(const FamPool* pool, FamHandle h) {
+    unsigned c = pool->entries[h - 1] >> FAM_POOL_SLOT_BITS;
+    return c == FAM_POOL_LARGE ? 0 : pool->classes[c].size;
+}
+
+// Tail elements that fit in the space reserved for h: at least the length it was
+// created with. Returns 0 for large records, whose size the pool does not keep.
+static inline size_t fam_pool_capacity(const FamPool* pool, FamHandle h) {
+    unsigned c = pool->entries[h - 1] >> FAM_POOL_SLOT_BITS;
+    if (c == FAM_POOL_LARGE) return 0;
+    return (pool->classes[c].size - pool->tail_offset) / pool->element_size;
+}
+
+static inline int fam_pool_grow_(void** array, size_t* capacity, size_t needed, size_t elem_size) {
+    if (needed <= *capacity) return 0;
+    size_t grown = *capacity ? *capacity * 2 : 16;
+    if (grown < needed) grown = needed;
+    void* p = realloc(*array, grown * elem_size);
+    if (p == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    *array = p;
+    *capacity = grown;
+    return 0;
+}
+
+// Makes sure slots [0, slots) of class k are backed by slabs.
+static inline int fam_pool_class_reserve_(FamPoolClass* k, size_t slots) {
+    if (slots > (size_t)FAM_POOL_SLOT_MASK + 1) {
+        errno = ENOMEM;
+        return -1;
+    }
+    size_t slabs = (slots + FAM_POOL_SLAB_SLOTS - 1) >> FAM_POOL_SLAB_SHIFT;
+    if (fam_pool_grow_((void**)&k->slabs, &k->slab_capacity, slabs, sizeof(char*)) != 0) return -1;
+    while (k->slab_count < slabs) {
+        char* slab = (char*)malloc(k->size * FAM_POOL_SLAB_SLOTS);
+        if (slab == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        k->slabs[k->slab_count++] = slab;
+    }
+    return 0;
+}
+
+// Returns an unused handle entry, or 0 with errno = ENOMEM.
+static inline FamHandle fam_pool_new_handle_(FamPool* pool) {
+    if (pool->free_handle != 0) {
+        FamHandle h = pool->free_handle;
+        pool->free_handle = pool->entries[h - 1] & FAM_POOL_SLOT_MASK;
+        pool->free_handles--;
+        return h;
+    }
+    if (pool->entry_count >= FAM_POOL_SLOT_MASK) {
+        errno = ENOMEM;
+        return 0;
+    }
+    if (fam_pool_grow_((void**)&pool->entries, &pool->entry_capacity, pool->entry_count + 1, sizeof(uint32_t)) != 0) {
+        return 0;
+    }
+    return (FamHandle)++pool->entry_count;
+}
+
+static inline void fam_pool_release_handle_(FamPool* pool, FamHandle h) {
+    pool->entries[h - 1] = (uint32_t)FAM_POOL_FREE_HANDLE << FAM_POOL_SLOT_BITS | pool->free_handle;
+    pool->free_handle = h;
+    pool->free_handles++;
+}
+
+// large_free always has room for every large[] slot, so freeing never allocates. Each
+// array grows against its own capacity, and large_count only moves once both have room.
+static inline int fam_pool_create_large_(FamPool* pool, FamHandle h, size_t bytes) {
+    uint32_t slot;
+    if (pool->large_free_count > 0) {
+        slot = pool->large_free[--pool->large_free_count];
+    } else {
+        if (pool->large_count >= FAM_POOL_SLOT_MASK ||
+            fam_pool_grow_((void**)&pool->large, &pool->large_capacity, pool->large_count + 1, sizeof(char*)) != 0 ||
+            fam_pool_grow_((void**)&pool->large_free, &pool->large_free_capacity, pool->large_count + 1,
+                           sizeof(uint32_t)) != 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        slot = (uint32_t)pool->large_count++;
+    }
+    char* record = (char*)malloc(bytes);
+    if (record == NULL) {
+        pool->large_free[pool->large_free_count++] = slot;
+        errno = ENOMEM;
+        return -1;
+    }
+    pool->large[slot] = record;
+    pool->entries[h - 1] = (uint32_t)FAM_POOL_LARGE << FAM_POOL_SLOT_BITS | slot;
+    return 0;
+}
+
+// Creates a record with room for n tail elements. The contents are uninitialised.
+// Returns its handle, or 0 with errno = ENOMEM.
+static inline FamHandle fam_pool_create(FamPool* pool, size_t n) {
+    size_t bytes = fam_pool_record_bytes_(pool, n);
+    if (bytes == 0) {
+        errno = ENOMEM;
+        return 0;
+    }
+    FamHandle h = fam_pool_new_handle_(pool);
+    if (h == 0) return 0;
+    unsigned c = fam_pool_class_(pool, bytes);
+    if (c == FAM_POOL_LARGE) {
+        if (fam_pool_create_large_(pool, h, bytes) != 0) {
+            fam_pool_release_handle_(pool, h);
+            return 0;
+        }
+        pool->live++;
+        return h;
+    }
+
+    FamPoolClass* k = &pool->classes[c];
+    uint32_t slot = k->free_head;
+    if (slot != FAM_POOL_FREE_END) {
+        memcpy(&k->free_head, fam_pool_slot_(k, slot), sizeof(uint32_t));
+    } else {
+        if (fam_pool_class_reserve_(k, (size_t)k->count + 1) != 0) {
+            fam_pool_release_handle_(pool, h);
+            return 0;
+        }
+        slot = k->count++;
+    }
+    k->live++;
+    pool->live++;
+    pool->entries[h - 1] = (uint32_t)c << FAM_POOL_SLOT_BITS | slot;
+    return h;
+}
+
+static inline void fam_pool_free(FamPool* pool, FamHandle h) {
+    if (h == 0) return;
+    uint32_t e = pool->entries[h - 1];
+    unsigned c = e >> FAM_POOL_SLOT_BITS;
+    uint32_t slot = e & FAM_POOL_SLOT_MASK;
+    if (c == FAM_POOL_LARGE) {
+        free(pool->large[slot]);
+        pool->large[slot] = NULL;
+        pool->large_free[pool->large_free_count++] = slot;
+    } else {
+        FamPoolClass* k = &pool->classes[c];
+        memcpy(fam_pool_slot_(k, slot), &k->free_head, sizeof(uint32_t));
+        k->free_head = slot;
+        k->live--;
+    }
+    pool->live--;
+    fam_pool_release_handle_(pool, h);
+}
+
+// Creates one record per entry of lengths[] and stores the handles in out[].
+// Slabs and the handle table grow once for the whole batch. Returns 0, or -1
+// with errno = ENOMEM and no records created.
+static inline int fam_pool_create_batch(FamPool* pool, const size_t* lengths, size_t count, FamHandle* out) {
+    size_t needed[FAM_POOL_NUM_CLASSES] = {0};
+    for (size_t i = 0; i < count; i++) {
+        size_t bytes = fam_pool_record_bytes_(pool, lengths[i]);
+        if (bytes == 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        unsigned c = fam_pool_class_(pool, bytes);
+        if (c != FAM_POOL_LARGE) needed[c]++;
+    }
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) {
+        FamPoolClass* k = &pool->classes[c];
+        size_t holes = k->count - k->live;
+        if (needed[c] > holes && fam_pool_class_reserve_(k, (size_t)k->count + needed[c] - holes) != 0) return -1;
+    }
+    if (count > pool->free_handles) {
+        size_t entries = pool->entry_count + count - pool->free_handles;
+        if (entries > FAM_POOL_SLOT_MASK) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if (fam_pool_grow_((void**)&pool->entries, &pool->entry_capacity, entries, sizeof(uint32_t)) != 0) return -1;
+    }
+    // Only large records can still fail
+    for (size_t i = 0; i < count; i++) {
+        out[i] = fam_pool_create(pool, lengths[i]);
+        if (out[i] == 0) {
+            while (i > 0) fam_pool_free(pool, out[--i]);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Moves the records of each class into the lowest slots and frees the slabs left
+// empty. Handles stay valid; pointers returned by fam_pool_get() before the call
+// do not. Returns the number of records moved, or -1 with errno = ENOMEM (the
+// pool is unchanged).
+static inline long fam_pool_compact(FamPool* pool) {
+    size_t total_holes = 0;
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) total_holes += pool->classes[c].count - pool->classes[c].live;
+    uint32_t* holes = (uint32_t*)malloc((total_holes ? total_holes : 1) * sizeof(uint32_t));
+    if (holes == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // The free slots below 'live' in each class are exactly as many as the live records at or above it
+    size_t next[FAM_POOL_NUM_CLASSES];
+    size_t filled = 0;
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) {
+        FamPoolClass* k = &pool->classes[c];
+        next[c] = filled;
+        for (uint32_t slot = k->free_head; slot != FAM_POOL_FREE_END;) {
+            if (slot < k->live) holes[filled++] = slot;
+            memcpy(&slot, fam_pool_slot_(k, slot), sizeof(uint32_t));
+        }
+    }
+
+    long moved = 0;
+    for (size_t i = 0; i < pool->entry_count; i++) {
+        uint32_t e = pool->entries[i];
+        unsigned c = e >> FAM_POOL_SLOT_BITS;
+        if (c >= FAM_POOL_NUM_CLASSES) continue;
+        FamPoolClass* k = &pool->classes[c];
+        uint32_t slot = e & FAM_POOL_SLOT_MASK;
+        if (slot < k->live) continue;
+        uint32_t target = holes[next[c]++];
+        memcpy(fam_pool_slot_(k, target), fam_pool_slot_(k, slot), k->size);
+        pool->entries[i] = (uint32_t)c << FAM_POOL_SLOT_BITS | target;
+        moved++;
+    }
+    free(holes);
+
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) {
+        FamPoolClass* k = &pool->classes[c];
+        k->count = k->live;
+        k->free_head = FAM_POOL_FREE_END;
+        size_t keep = ((size_t)k->live + FAM_POOL_SLAB_SLOTS - 1) >> FAM_POOL_SLAB_SHIFT;
+        while (k->slab_count > keep) free(k->slabs[--k->slab_count]);
+    }
+    return moved;
+}
+
+// Bytes held in slabs and tables, excluding large records.
+static inline size_t fam_pool_reserved_bytes(const FamPool* pool) {
+    size_t bytes = pool->entry_capacity * sizeof(uint32_t) +
+                   pool->large_capacity * sizeof(char*) + pool->large_free_capacity * sizeof(uint32_t);
+    for (int c = 0; c < FAM_POOL_NUM_CLASSES; c++) {
+        const FamPoolClass* k = &pool->classes[c];
+        bytes += k->slab_count * FAM_POOL_SLAB_SLOTS * k->size + k->slab_capacity * sizeof(char*);
+    }
+    return bytes;
+}
+
+#endif // FAM_POOL_H
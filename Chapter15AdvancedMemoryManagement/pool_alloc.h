@@ -0,0 +1,328 @@
+/*
+pool_alloc.h - Thread-Safe Fixed-Size Pool (Slab) Allocator
+================================================
+
+A header-only slab allocator for programs that churn through large numbers of small,
+fixed-size objects. It grows out of the bump-pointer MemoryPool demo in
+Chapter7MemoryManagement/DynamicMemoryAllocation.c, which could not free individual
+objects.
+
+Design:
+- SlabPool serves one object size. Memory is obtained from malloc in large slabs
+  (64 KB by default) and carved into objects on demand.
+- Free objects are kept on an intrusive singly-linked free list: the "next" pointer is
+  stored inside the free object itself, so there is no per-object header and both
+  allocation and deallocation are O(1) pointer pushes/pops.
+- Each thread has its own cache (found through a pthread key), so the common path
+  takes no lock. When a cache runs dry it pulls a whole batch from the shared depot;
+  when it holds too many objects it returns a batch. Batches are moved as chains, so
+  one mutex acquisition moves POOL_BATCH_SIZE objects.
+- SizeClassPool groups SlabPools for a fixed set of size classes (16 B .. 1 KB) and
+  falls back to malloc for larger requests. Callers pass the size back on free, the
+  same contract as C23 free_sized().
+
+Usage:
+    SlabPool pool;
+    slab_pool_init(&pool, sizeof(struct Node));
+    struct Node* n = slab_pool_alloc(&pool);
+    slab_pool_free(&pool, n);
+    slab_pool_destroy(&pool);
+
+Rules:
+- Objects must be returned to the pool they came from.
+- A thread's cache is flushed to the depot when the thread exits. Destroy a pool
+  only after every other thread that used it has exited.
+
+Tracing: with -DTRACE_ENABLE, the slow paths (depot refills, batch releases, new
+slabs) are timed as "pool" zones and counted in pool.refills, pool.releases and
+pool.slabs (Chapter18DebuggingAndProfiling/trace.h). The cached alloc/free path is
+not instrumented.
+
+Compile with -pthread.
+*/
+
+#ifndef POOL_ALLOC_H
+#define POOL_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../Chapter18DebuggingAndProfiling/trace.h"
+
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_BATCH_SIZE 32
+#define POOL_NUM_CLASSES 12
+#define POOL_MAX_CLASS_SIZE 1024
+
+// Overlaid on every free object. 'next_batch' is only used by the first object of a
+// batch while it sits in the depot, which is why the minimum object size is two pointers.
+typedef struct PoolFreeNode {
+    struct PoolFreeNode* next;
+    struct PoolFreeNode* next_batch;
+} PoolFreeNode;
+
+typedef struct PoolSlab {
+    struct PoolSlab* next;
+} PoolSlab;
+
+struct SlabPool;
+
+typedef struct {
+    struct SlabPool* pool;     // Owner, needed by the thread-exit destructor
+    PoolFreeNode* head;
+    size_t count;
+} PoolThreadCache;
+
+typedef struct SlabPool {
+    size_t object_size;        // Rounded up to alignment and at least sizeof(PoolFreeNode)
+    size_t slab_size;
+    pthread_key_t cache_key;
+
+    pthread_mutex_t lock;      // Protects everything below
+    PoolFreeNode* depot;       // Stack of full batches linked through next_batch
+    size_t depot_batches;
+    PoolSlab* slabs;
+    char* carve_ptr;           // Unused tail of the newest slab
+    char* carve_end;
+    size_t slab_count;
+} SlabPool;
+
+typedef struct {
+    SlabPool classes[POOL_NUM_CLASSES];
+    uint8_t class_of[POOL_MAX_CLASS_SIZE / 16 + 1];  // (size + 15) / 16 -> class index
+} SizeClassPool;
+
+static const size_t pool_class_sizes[POOL_NUM_CLASSES] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+static inline size_t pool_align_up_(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+static inline void slab_pool_flush_cache_(SlabPool* pool, PoolThreadCache* cache);
+
+static inline void slab_pool_cache_destructor_(void* arg) {
+    PoolThreadCache* cache = (PoolThreadCache*)arg;
+    slab_pool_flush_cache_(cache->pool, cache);
+    free(cache);
+}
+
+// Returns 0 on success, -1 if the pthread key or mutex could not be created.
+static inline int slab_pool_init_with_slab_size(SlabPool* pool, size_t object_size, size_t slab_size) {
+    memset(pool, 0, sizeof(*pool));
+    size_t align = _Alignof(max_align_t);
+    if (object_size < sizeof(PoolFreeNode)) object_size = sizeof(PoolFreeNode);
+    pool->object_size = pool_align_up_(object_size, align);
+    size_t header = pool_align_up_(sizeof(PoolSlab), align);
+    if (slab_size < header + pool->object_size * POOL_BATCH_SIZE) {
+        slab_size = header + pool->object_size * POOL_BATCH_SIZE;
+    }
+    pool->slab_size = slab_size;
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) return -1;
+    if (pthread_key_create(&pool->cache_key, slab_pool_cache_destructor_) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        return -1;
+    }
+    return 0;
+}
+
+static inline int slab_pool_init(SlabPool* pool, size_t object_size) {
+    return slab_pool_init_with_slab_size(pool, object_size, POOL_SLAB_SIZE);
+}
+
+// Frees every slab. Objects still in use become invalid.
+static inline void slab_pool_destroy(SlabPool* pool) {
+    void* mine = pthread_getspecific(pool->cache_key);  // Other threads' caches are gone already
+    if (mine) {
+        pthread_setspecific(pool->cache_key, NULL);
+        free(mine);
+    }
+    pthread_key_delete(pool->cache_key);
+    PoolSlab* slab = pool->slabs;
+    while (slab) {
+        PoolSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pthread_mutex_destroy(&pool->lock);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static inline PoolThreadCache* slab_pool_cache_(SlabPool* pool) {
+    PoolThreadCache* cache = (PoolThreadCache*)pthread_getspecific(pool->cache_key);
+    if (cache == NULL) {
+        cache = (PoolThreadCache*)calloc(1, sizeof(PoolThreadCache));
+        if (cache == NULL) return NULL;
+        cache->pool = pool;
+        if (pthread_setspecific(pool->cache_key, cache) != 0) {
+            free(cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+// Build a chain of up to POOL_BATCH_SIZE fresh objects. Called with the lock held.
+static inline PoolFreeNode* slab_pool_carve_locked_(SlabPool* pool, size_t* out_count) {
+    if (pool->carve_ptr == pool->carve_end) {
+        PoolSlab* slab = (PoolSlab*)malloc(pool->slab_size);
+        if (slab == NULL) return NULL;
+        TRACE_COUNTER_ADD("pool.slabs", 1);
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->slab_count++;
+        size_t header = pool_align_up_(sizeof(PoolSlab), _Alignof(max_align_t));
+        size_t objects = (pool->slab_size - header) / pool->object_size;
+        pool->carve_ptr = (char*)slab + header;
+        pool->carve_end = pool->carve_ptr + objects * pool->object_size;
+    }
+
+    PoolFreeNode* head = NULL;
+    size_t count = 0;
+    while (count < POOL_BATCH_SIZE && pool->carve_ptr < pool->carve_end) {
+        PoolFreeNode* node = (PoolFreeNode*)pool->carve_ptr;
+        pool->carve_ptr += pool->object_size;
+        node->next = head;
+        head = node;
+        count++;
+    }
+    *out_count = count;
+    return head;
+}
+
+static inline int slab_pool_refill_(SlabPool* pool, PoolThreadCache* cache) {
+    TRACE_ZONE_BEGIN(zone, "pool", "pool refill");
+    TRACE_COUNTER_ADD("pool.refills", 1);
+    pthread_mutex_lock(&pool->lock);
+    PoolFreeNode* batch = pool->depot;
+    size_t count = 0;
+    if (batch) {
+        pool->depot = batch->next_batch;
+        pool->depot_batches--;
+    } else {
+        batch = slab_pool_carve_locked_(pool, &count);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (batch == NULL) {
+        TRACE_ZONE_END(zone);
+        return -1;
+    }
+    if (count == 0) {
+        // Depot batches may be partial (flushed caches), so count outside the lock.
+        for (PoolFreeNode* n = batch; n; n = n->next) count++;
+    }
+    cache->head = batch;
+    cache->count = count;
+    TRACE_ZONE_END(zone);
+    return 0;
+}
+
+// Detach one full batch from the cache and push it to the depot.
+static inline void slab_pool_release_batch_(SlabPool* pool, PoolThreadCache* cache) {
+    TRACE_ZONE_BEGIN(zone, "pool", "pool release batch");
+    TRACE_COUNTER_ADD("pool.releases", 1);
+    PoolFreeNode* first = cache->head;
+    PoolFreeNode* last = first;
+    for (size_t i = 1; i < POOL_BATCH_SIZE; i++) last = last->next;
+    cache->head = last->next;
+    cache->count -= POOL_BATCH_SIZE;
+    last->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    first->next_batch = pool->depot;
+    pool->depot = first;
+    pool->depot_batches++;
+    pthread_mutex_unlock(&pool->lock);
+    TRACE_ZONE_END(zone);
+}
+
+static inline void slab_pool_flush_cache_(SlabPool* pool, PoolThreadCache* cache) {
+    while (cache->count >= POOL_BATCH_SIZE) slab_pool_release_batch_(pool, cache);
+    if (cache->count == 0) return;
+    // A partial batch still goes to the depot; refills accept any non-empty chain.
+    PoolFreeNode* first = cache->head;
+    cache->head = NULL;
+    cache->count = 0;
+    pthread_mutex_lock(&pool->lock);
+    first->next_batch = pool->depot;
+    pool->depot = first;
+    pool->depot_batches++;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static inline void* slab_pool_alloc(SlabPool* pool) {
+    PoolThreadCache* cache = slab_pool_cache_(pool);
+    if (cache == NULL) return NULL;
+    if (cache->head == NULL && slab_pool_refill_(pool, cache) != 0) return NULL;
+    PoolFreeNode* node = cache->head;
+    cache->head = node->next;
+    cache->count--;
+    return node;
+}
+
+static inline void slab_pool_free(SlabPool* pool, void* ptr) {
+    if (ptr == NULL) return;
+    PoolThreadCache* cache = slab_pool_cache_(pool);
+    if (cache == NULL) {
+        // No cache could be created: hand the object straight to the depot.
+        PoolFreeNode* node = (PoolFreeNode*)ptr;
+        node->next = NULL;
+        pthread_mutex_lock(&pool->lock);
+        node->next_batch = pool->depot;
+        pool->depot = node;
+        pool->depot_batches++;
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+    PoolFreeNode* node = (PoolFreeNode*)ptr;
+    node->next = cache->head;
+    cache->head = node;
+    // Keep one batch in hand after releasing so alloc/free ping-pong does not thrash.
+    if (++cache->count >= 2 * POOL_BATCH_SIZE) slab_pool_release_batch_(pool, cache);
+}
+
+// Return the calling thread's cached objects to the depot (e.g. before a long idle period).
+static inline void slab_pool_flush(SlabPool* pool) {
+    PoolThreadCache* cache = (PoolThreadCache*)pthread_getspecific(pool->cache_key);
+    if (cache) slab_pool_flush_cache_(pool, cache);
+}
+
+// Returns 0 on success, -1 on failure (already-initialised classes are destroyed).
+static inline int size_class_pool_init(SizeClassPool* sp) {
+    for (int i = 0; i < POOL_NUM_CLASSES; i++) {
+        if (slab_pool_init(&sp->classes[i], pool_class_sizes[i]) != 0) {
+            while (--i >= 0) slab_pool_destroy(&sp->classes[i]);
+            return -1;
+        }
+    }
+    int c = 0;
+    for (size_t slot = 0; slot <= POOL_MAX_CLASS_SIZE / 16; slot++) {
+        while (pool_class_sizes[c] < slot * 16) c++;
+        sp->class_of[slot] = (uint8_t)c;
+    }
+    return 0;
+}
+
+static inline void size_class_pool_destroy(SizeClassPool* sp) {
+    for (int i = 0; i < POOL_NUM_CLASSES; i++) slab_pool_destroy(&sp->classes[i]);
+}
+
+static inline void* size_class_pool_alloc(SizeClassPool* sp, size_t size) {
+    if (size > POOL_MAX_CLASS_SIZE) return malloc(size);
+    return slab_pool_alloc(&sp->classes[sp->class_of[(size + 15) / 16]]);
+}
+
+// 'size' must be the size passed to size_class_pool_alloc.
+static inline void size_class_pool_free(SizeClassPool* sp, void* ptr, size_t size) {
+    if (size > POOL_MAX_CLASS_SIZE) {
+        free(ptr);
+        return;
+    }
+    slab_pool_free(&sp->classes[sp->class_of[(size + 15) / 16]], ptr);
+}
+
+#endif // POOL_ALLOC_H
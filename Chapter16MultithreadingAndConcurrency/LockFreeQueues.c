@@ -0,0 +1,635 @@
+/*
+Cheat Sheet: Lock-Free Queues (SPSC Ring Buffer and MPMC Queue) in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+A queue between pipeline stages is usually a ring buffer guarded by a mutex and two
+condition variables. Every push and pop then takes the lock, and a waiting thread is
+woken through the kernel, so at a few million messages per second the queue itself
+becomes the bottleneck.
+
+A lock-free queue replaces the lock with atomic loads, stores and compare-and-swap:
+- SPSC ring buffer: with exactly one producer and one consumer, each index has a
+  single writer, so a push or pop is one plain store plus one release store. No
+  read-modify-write instruction is needed at all.
+- MPMC queue: several producers (or consumers) must agree who gets which slot; one
+  CAS on a shared position counter does that, and a per-cell sequence number tells
+  each side when its cell is ready.
+
+Key points:
+- "Lock-free" means some thread always makes progress; it does not mean "never
+  waits". A full or empty queue still has to be handled by the caller.
+- Correctness depends on the C11 memory orderings: release when publishing,
+  acquire when observing.
+- Indices written by different threads must live on different cache lines, or the
+  cores keep stealing the line from each other (false sharing).
+
+Historical context:
+- Leslie Lamport proved the wait-free single-producer/single-consumer ring correct
+  in 1983.
+- Michael and Scott's unbounded lock-free queue (1996) is the basis of
+  java.util.concurrent.ConcurrentLinkedQueue.
+- Dmitry Vyukov's bounded MPMC queue (2010) is used in many C++ and Rust runtimes.
+- C11 (<stdatomic.h>) made portable lock-free code possible without inline assembly.
+
+The implementation lives in lockfree_queue.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "lockfree_queue.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// Function prototypes
+void spsc_ring_example();
+void mpmc_queue_example();
+void pipeline_example();
+void performance_comparison();
+
+int main() {
+    printf("Lock-Free Queues Cheat Sheet\n");
+    printf("============================\n\n");
+
+    spsc_ring_example();
+    mpmc_queue_example();
+    pipeline_example();
+    performance_comparison();
+
+    return 0;
+}
+
+// A full or empty queue is the caller's problem. Spin briefly (the other side is
+// probably running on another core), then give the CPU away.
+static inline void queue_backoff(unsigned* spins) {
+    if (++*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+void spsc_ring_example() {
+    printf("2.1 SPSC Ring Buffer\n");
+    printf("--------------------\n");
+
+    SpscRing ring;
+    if (spsc_ring_init(&ring, 5) != 0) {  // Rounded up to 8
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    printf("Capacity: %zu\n", spsc_ring_capacity(&ring));
+
+    static int values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int pushed = 0;
+    while (pushed < 10 && spsc_ring_push(&ring, &values[pushed])) pushed++;
+    printf("Pushed %d of 10 before the ring was full\n", pushed);
+
+    void* item;
+    printf("Popped:");
+    while (spsc_ring_pop(&ring, &item)) printf(" %d", *(int*)item);
+    printf("\n\n");
+
+    spsc_ring_destroy(&ring);
+}
+
+#define EXAMPLE_PRODUCERS 3
+#define EXAMPLE_CONSUMERS 2
+#define EXAMPLE_ITEMS 100000
+
+typedef struct {
+    MpmcQueue* queue;
+    int id;
+    _Atomic long* remaining;   // Items not yet consumed, shared by consumers
+    long sum;
+} ExampleWorker;
+
+void* example_producer(void* arg) {
+    ExampleWorker* w = (ExampleWorker*)arg;
+    for (long i = 1; i <= EXAMPLE_ITEMS; i++) {
+        unsigned spins = 0;
+        while (!mpmc_queue_push(w->queue, (void*)(uintptr_t)i)) queue_backoff(&spins);
+    }
+    return NULL;
+}
+
+void* example_consumer(void* arg) {
+    ExampleWorker* w = (ExampleWorker*)arg;
+    unsigned spins = 0;
+    while (atomic_load(w->remaining) > 0) {
+        void* item;
+        if (mpmc_queue_pop(w->queue, &item)) {
+            w->sum += (long)(uintptr_t)item;
+            atomic_fetch_sub(w->remaining, 1);
+            spins = 0;
+        } else {
+            queue_backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+void mpmc_queue_example() {
+    printf("2.2 MPMC Queue with %d Producers and %d Consumers\n", EXAMPLE_PRODUCERS, EXAMPLE_CONSUMERS);
+    printf("-------------------------------------------------\n");
+
+    MpmcQueue queue;
+    if (mpmc_queue_init(&queue, 256) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+
+    _Atomic long remaining = (long)EXAMPLE_PRODUCERS * EXAMPLE_ITEMS;
+    ExampleWorker workers[EXAMPLE_PRODUCERS + EXAMPLE_CONSUMERS];
+    pthread_t threads[EXAMPLE_PRODUCERS + EXAMPLE_CONSUMERS];
+    for (int i = 0; i < EXAMPLE_PRODUCERS + EXAMPLE_CONSUMERS; i++) {
+        workers[i] = (ExampleWorker){&queue, i, &remaining, 0};
+        pthread_create(&threads[i], NULL, i < EXAMPLE_PRODUCERS ? example_producer : example_consumer,
+                       &workers[i]);
+    }
+
+    long total = 0;
+    for (int i = 0; i < EXAMPLE_PRODUCERS + EXAMPLE_CONSUMERS; i++) {
+        pthread_join(threads[i], NULL);
+        if (i >= EXAMPLE_PRODUCERS) {
+            printf("Consumer %d: sum %ld\n", i - EXAMPLE_PRODUCERS, workers[i].sum);
+            total += workers[i].sum;
+        }
+    }
+    long expected = (long)EXAMPLE_PRODUCERS * EXAMPLE_ITEMS * (EXAMPLE_ITEMS + 1) / 2;
+    printf("Total %ld, expected %ld: %s\n\n", total, expected, total == expected ? "OK" : "MISMATCH");
+
+    mpmc_queue_destroy(&queue);
+}
+
+// Two-stage pipeline: a parser thread hands records to a writer thread through an
+// SPSC ring. The writer drains in batches with spsc_ring_pop_many().
+typedef struct {
+    int id;
+    double value;
+} Record;
+
+typedef struct {
+    SpscRing* ring;
+    Record* records;
+    int count;
+    double total;
+    int batches;
+} PipelineStage;
+
+void* pipeline_parser(void* arg) {
+    PipelineStage* s = (PipelineStage*)arg;
+    for (int i = 0; i < s->count; i++) {
+        s->records[i].id = i;
+        s->records[i].value = i * 0.5;
+        unsigned spins = 0;
+        while (!spsc_ring_push(s->ring, &s->records[i])) queue_backoff(&spins);
+    }
+    return NULL;
+}
+
+void* pipeline_writer(void* arg) {
+    PipelineStage* s = (PipelineStage*)arg;
+    void* batch[32];
+    int seen = 0;
+    unsigned spins = 0;
+    while (seen < s->count) {
+        size_t n = spsc_ring_pop_many(s->ring, batch, 32);
+        if (n == 0) {
+            queue_backoff(&spins);
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) s->total += ((Record*)batch[i])->value;
+        seen += (int)n;
+        s->batches++;
+    }
+    return NULL;
+}
+
+void pipeline_example() {
+    printf("2.3 Pipeline Hand-off with Batched Pops\n");
+    printf("---------------------------------------\n");
+
+    enum { RECORDS = 50000 };
+    SpscRing ring;
+    Record* records = malloc(RECORDS * sizeof(Record));
+    if (records == NULL || spsc_ring_init(&ring, 1024) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(records);
+        return;
+    }
+
+    PipelineStage stage = {&ring, records, RECORDS, 0.0, 0};
+    pthread_t parser, writer;
+    pthread_create(&writer, NULL, pipeline_writer, &stage);
+    pthread_create(&parser, NULL, pipeline_parser, &stage);
+    pthread_join(parser, NULL);
+    pthread_join(writer, NULL);
+
+    printf("Records: %d, total value: %.1f, pop batches: %d (%.1f records each)\n\n",
+           RECORDS, stage.total, stage.batches, (double)RECORDS / stage.batches);
+
+    spsc_ring_destroy(&ring);
+    free(records);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Use the SPSC ring whenever a stage has exactly one producer and one consumer; it
+   needs no CAS and is the fastest hand-off there is.
+2. Size the queue so it absorbs bursts, but keep it small enough to stay in cache
+   (a few thousand entries); a huge queue only hides a slow consumer.
+3. Pass pointers to messages, not large messages by value.
+4. Decide up front what happens when the queue is full: spin, yield, drop or park.
+
+Common Pitfalls:
+1. Calling spsc_ring_push() from two threads. The SPSC ring has no protection against
+   it and silently loses messages; use the MPMC queue instead.
+2. Using memory_order_relaxed for the publishing store: the consumer can then see the
+   new index before the item it guards.
+3. Busy-spinning without sched_yield() when producers and consumers share a core: the
+   spinning thread burns its whole time slice while the other side cannot run.
+4. Allocating a queue struct with plain malloc(): the struct is 64-byte aligned and
+   malloc only guarantees 16. Use aligned_alloc() or embed it statically.
+
+Advanced Tips:
+1. Batch on the consumer side with spsc_ring_pop_many(): one index update per batch.
+2. Keep the other side's index cached (head_cache/tail_cache) so the hot path touches
+   only lines the current core owns.
+3. Run the tests under ThreadSanitizer (-fsanitize=thread) and on a weakly ordered
+   CPU (ARM) before trusting new memory orderings; x86 hides many mistakes.
+
+4. Integration and Real-World Applications
+==========================================
+- Pipelines: parse -> transform -> write stages with an SPSC ring between each pair.
+- Logging: many threads push records to an MPMC queue drained by one writer thread.
+- Networking: NIC receive rings (DPDK rte_ring) are bounded lock-free rings.
+- Audio: real-time threads must never block on a mutex; SPSC rings connect them to
+  the rest of the program.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Wait-free queues (e.g., Yang and Mellor-Crummey, 2016) bound every operation, not
+  just system-wide progress.
+- Futex-based parking (Linux futex, C++20 atomic::wait) lets an empty queue sleep
+  without a mutex on the fast path.
+- Chapter7MemoryManagement mentions lock-free allocation: the depots in
+  Chapter15AdvancedMemoryManagement/pool_alloc.h could exchange batches through an
+  MPMC queue like this one.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why are capacities rounded up to a power of two?
+A: So "index % capacity" becomes "index & mask", and indices can grow without bound
+   and wrap naturally at SIZE_MAX.
+
+Q: My lock-free queue is slower than the mutex queue. Why?
+A: Usually false sharing (check the alignment of the struct), spinning without
+   yielding on an oversubscribed machine, or a queue so full that the benchmark
+   measures the consumer, not the queue.
+
+Q: Is mpmc_queue_push() wait-free?
+A: No. A producer can retry its CAS while others succeed; it is lock-free.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- Dmitry Vyukov, "Bounded MPMC queue" (1024cores.net)
+- Lamport, "Specifying Concurrent Program Modules" (TOPLAS 1983)
+- liblfds, Concurrency Kit (ck_ring), DPDK rte_ring, Boost.Lockfree
+- ThreadSanitizer and the herd7 memory-model simulator
+
+8. Performance Analysis and Optimization
+========================================
+Each benchmark run starts P producer and C consumer threads that move a fixed number
+of messages through one queue. Ops/sec counts messages handed off per second. Every
+64th message carries its push timestamp, and the consumer records how long it spent
+in the queue; the p50/p99/p99.9 of those samples are printed after each suite.
+The baseline is a bounded ring protected by one mutex and two condition variables,
+as pipeline code is typically written.
+*/
+
+// ---------------------------------------------------------------------------
+// Mutex + condition variable baseline
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    void** slots;
+    size_t capacity, head, count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+} LockedQueue;
+
+int locked_queue_init(LockedQueue* q, size_t capacity) {
+    q->slots = malloc(capacity * sizeof(void*));
+    if (q->slots == NULL) return -1;
+    q->capacity = capacity;
+    q->head = q->count = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return 0;
+}
+
+void locked_queue_destroy(LockedQueue* q) {
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->lock);
+    free(q->slots);
+}
+
+// Blocking push and pop: they always succeed, so they fit the same interface
+int locked_queue_push(void* queue, void* item) {
+    LockedQueue* q = (LockedQueue*)queue;
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->capacity) pthread_cond_wait(&q->not_full, &q->lock);
+    q->slots[(q->head + q->count) % q->capacity] = item;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return 1;
+}
+
+int locked_queue_pop(void* queue, void** item) {
+    LockedQueue* q = (LockedQueue*)queue;
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) pthread_cond_wait(&q->not_empty, &q->lock);
+    *item = q->slots[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return 1;
+}
+
+int spsc_push_op(void* queue, void* item) { return spsc_ring_push((SpscRing*)queue, item); }
+int spsc_pop_op(void* queue, void** item) { return spsc_ring_pop((SpscRing*)queue, item); }
+int mpmc_push_op(void* queue, void* item) { return mpmc_queue_push((MpmcQueue*)queue, item); }
+int mpmc_pop_op(void* queue, void** item) { return mpmc_queue_pop((MpmcQueue*)queue, item); }
+
+// ---------------------------------------------------------------------------
+// Producer/consumer benchmark
+// ---------------------------------------------------------------------------
+
+#define QUEUE_CAPACITY 1024
+#define MAX_PIPE_THREADS 8
+#define LATENCY_SHIFT 6                         // Sample every 64th message
+#define MSG_PRODUCER_SHIFT 40                   // Message = producer << 40 | (seq + 1)
+
+// Messages travel through the queues as void*, so the producer id and sequence
+// number must fit in a pointer
+_Static_assert(sizeof(uintptr_t) >= 8, "MSG_PRODUCER_SHIFT needs a 64-bit uintptr_t");
+
+typedef struct {
+    int (*push)(void* queue, void* item);
+    int (*pop)(void* queue, void** item);
+    void* queue;
+    int producers, consumers;
+    size_t per_producer;
+    uint64_t* push_ns[MAX_PIPE_THREADS];        // Per producer: timestamp of each sampled message
+    uint64_t* latency_ns[MAX_PIPE_THREADS];     // Per consumer: sampled queueing delays
+    size_t latency_count[MAX_PIPE_THREADS];
+    size_t received[MAX_PIPE_THREADS];
+    int out_of_order[MAX_PIPE_THREADS];         // Per consumer, summed into errors after the join
+    int errors;
+} PipeBench;
+
+typedef struct {
+    PipeBench* bench;
+    int id;
+} PipeThread;
+
+void* pipe_producer(void* arg) {
+    PipeThread* t = (PipeThread*)arg;
+    PipeBench* b = t->bench;
+    uint64_t* stamps = b->push_ns[t->id];
+    for (size_t seq = 0; seq < b->per_producer; seq++) {
+        uintptr_t msg = ((uintptr_t)t->id << MSG_PRODUCER_SHIFT) | (seq + 1);
+        if ((seq & ((1u << LATENCY_SHIFT) - 1)) == 0) stamps[seq >> LATENCY_SHIFT] = bench_now_ns();
+        unsigned spins = 0;
+        while (!b->push(b->queue, (void*)msg)) queue_backoff(&spins);
+    }
+    return NULL;
+}
+
+// Runs until it pops a NULL sentinel. Checks that each producer's messages arrive
+// in order, which both queues guarantee per consumer.
+void* pipe_consumer(void* arg) {
+    PipeThread* t = (PipeThread*)arg;
+    PipeBench* b = t->bench;
+    size_t last[MAX_PIPE_THREADS] = {0};
+    size_t received = 0, samples = 0;
+    int out_of_order = 0;
+    unsigned spins = 0;
+    for (;;) {
+        void* item;
+        if (!b->pop(b->queue, &item)) {
+            queue_backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        if (item == NULL) break;
+        uintptr_t msg = (uintptr_t)item;
+        int producer = (int)(msg >> MSG_PRODUCER_SHIFT);
+        size_t seq = (size_t)(msg & (((uintptr_t)1 << MSG_PRODUCER_SHIFT) - 1)) - 1;
+        if (seq + 1 <= last[producer]) out_of_order++;
+        last[producer] = seq + 1;
+        if ((seq & ((1u << LATENCY_SHIFT) - 1)) == 0) {
+            // The release/acquire pair in the queue orders the producer's store
+            b->latency_ns[t->id][samples++] = bench_now_ns() - b->push_ns[producer][seq >> LATENCY_SHIFT];
+        }
+        received++;
+    }
+    b->received[t->id] = received;
+    b->out_of_order[t->id] = out_of_order;
+    b->latency_count[t->id] = samples;
+    return NULL;
+}
+
+void pipe_run(void* ctx) {
+    PipeBench* b = (PipeBench*)ctx;
+    PipeThread args[2 * MAX_PIPE_THREADS];
+    pthread_t producers[MAX_PIPE_THREADS], consumers[MAX_PIPE_THREADS];
+
+    for (int i = 0; i < b->consumers; i++) {
+        args[MAX_PIPE_THREADS + i] = (PipeThread){b, i};
+        pthread_create(&consumers[i], NULL, pipe_consumer, &args[MAX_PIPE_THREADS + i]);
+    }
+    for (int i = 0; i < b->producers; i++) {
+        args[i] = (PipeThread){b, i};
+        pthread_create(&producers[i], NULL, pipe_producer, &args[i]);
+    }
+    for (int i = 0; i < b->producers; i++) pthread_join(producers[i], NULL);
+    for (int i = 0; i < b->consumers; i++) {
+        unsigned spins = 0;
+        while (!b->push(b->queue, NULL)) queue_backoff(&spins);  // One stop sentinel each
+    }
+    size_t total = 0;
+    for (int i = 0; i < b->consumers; i++) {
+        pthread_join(consumers[i], NULL);
+        total += b->received[i];
+        b->errors += b->out_of_order[i];
+    }
+    if (total != (size_t)b->producers * b->per_producer) b->errors++;
+}
+
+int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// p50 / p99 / p99.9 queueing delay of the last run, merged over all consumers
+void latency_percentiles(PipeBench* b, uint64_t* scratch, double us[3]) {
+    size_t n = 0;
+    for (int i = 0; i < b->consumers; i++) {
+        memcpy(scratch + n, b->latency_ns[i], b->latency_count[i] * sizeof(uint64_t));
+        n += b->latency_count[i];
+    }
+    us[0] = us[1] = us[2] = 0.0;
+    if (n == 0) return;
+    qsort(scratch, n, sizeof(uint64_t), compare_u64);
+    us[0] = scratch[n / 2] / 1e3;
+    us[1] = scratch[n * 99 / 100] / 1e3;
+    us[2] = scratch[n * 999 / 1000] / 1e3;
+}
+
+typedef struct {
+    const char* name;
+    int (*push)(void* queue, void* item);
+    int (*pop)(void* queue, void** item);
+    void* queue;
+} QueueKind;
+
+void run_pipe_suite(const char* title, const QueueKind* kinds, int nkinds,
+                    int producers, int consumers, size_t per_producer) {
+    // Sampled messages per producer. One consumer may receive every sample, so
+    // each consumer buffer and the merge scratch hold producers * samples.
+    size_t samples = (per_producer >> LATENCY_SHIFT) + 1;
+    size_t all = (size_t)producers * samples;
+    uint64_t* memory = calloc(all * (size_t)(consumers + 2), sizeof(uint64_t));
+    if (memory == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+
+    PipeBench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.producers = producers;
+    bench.consumers = consumers;
+    bench.per_producer = per_producer;
+    for (int i = 0; i < producers; i++) bench.push_ns[i] = memory + (size_t)i * samples;
+    for (int i = 0; i < consumers; i++) bench.latency_ns[i] = memory + all * (size_t)(i + 1);
+    uint64_t* scratch = memory + all * (size_t)(consumers + 1);
+
+    uint64_t messages = (uint64_t)producers * per_producer;
+    double latency_us[8][3];
+    int errors[8];
+    if (nkinds > 8) nkinds = 8;
+    BenchSuite suite;
+    bench_suite_init(&suite, title);
+    for (int k = 0; k < nkinds; k++) {
+        bench.push = kinds[k].push;
+        bench.pop = kinds[k].pop;
+        bench.queue = kinds[k].queue;
+        bench.errors = 0;
+        bench_suite_run(&suite, kinds[k].name, pipe_run, &bench, messages);
+        latency_percentiles(&bench, scratch, latency_us[k]);
+        errors[k] = bench.errors;
+    }
+    bench_suite_report(&suite);
+
+    printf("%-20s %12s %12s %12s %12s\n", "queue", "M msgs/s", "p50 us", "p99 us", "p99.9 us");
+    for (int k = 0; k < suite.count; k++) {
+        printf("%-20s %12.2f %12.2f %12.2f %12.2f%s\n", kinds[k].name,
+               bench_throughput(&suite.results[k], (double)messages) / 1e6,
+               latency_us[k][0], latency_us[k][1], latency_us[k][2],
+               errors[k] ? "  ERRORS: lost or reordered messages" : "");
+    }
+    printf("\n");
+    free(memory);
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    SpscRing spsc;
+    MpmcQueue mpmc;
+    LockedQueue locked;
+    if (spsc_ring_init(&spsc, QUEUE_CAPACITY) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    if (mpmc_queue_init(&mpmc, QUEUE_CAPACITY) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        spsc_ring_destroy(&spsc);
+        return;
+    }
+    if (locked_queue_init(&locked, QUEUE_CAPACITY) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        mpmc_queue_destroy(&mpmc);
+        spsc_ring_destroy(&spsc);
+        return;
+    }
+
+    const QueueKind one_to_one[] = {
+        {"mutex + condvar", locked_queue_push, locked_queue_pop, &locked},
+        {"SPSC ring", spsc_push_op, spsc_pop_op, &spsc},
+        {"MPMC queue", mpmc_push_op, mpmc_pop_op, &mpmc},
+    };
+    const QueueKind many_to_many[] = {
+        {"mutex + condvar", locked_queue_push, locked_queue_pop, &locked},
+        {"MPMC queue", mpmc_push_op, mpmc_pop_op, &mpmc},
+    };
+
+    run_pipe_suite("1 producer -> 1 consumer, 1M messages", one_to_one, 3, 1, 1, 1000000);
+    run_pipe_suite("4 producers -> 4 consumers, 1M messages", many_to_many, 2, 4, 4, 250000);
+
+    locked_queue_destroy(&locked);
+    mpmc_queue_destroy(&mpmc);
+    spsc_ring_destroy(&spsc);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o lockfree_queues LockFreeQueues.c -O2 -pthread
+
+Then execute the resulting binary:
+    ./lockfree_queues
+
+Producers and consumers need their own cores for the lock-free numbers to mean much;
+on a machine with fewer cores than threads every queue is limited by the scheduler.
+*/
@@ -0,0 +1,253 @@
+/*
+lockfree_queue.h - Bounded Lock-Free SPSC Ring Buffer and MPMC Queue (C11 atomics)
+================================================
+
+Two queues of void* items for handing messages between threads:
+
+    SpscRing ring;                          // Exactly one producer, one consumer
+    spsc_ring_init(&ring, 1024);
+    spsc_ring_push(&ring, msg);             // 1 on success, 0 if full
+    spsc_ring_pop(&ring, &msg);             // 1 on success, 0 if empty
+
+    MpmcQueue q;                             // Any number of producers and consumers
+    mpmc_queue_init(&q, 1024);
+    mpmc_queue_push(&q, msg);
+    mpmc_queue_pop(&q, &msg);
+
+Neither call blocks; on 0 the caller decides whether to spin, sched_yield() or
+park. Capacities are rounded up to a power of two so an index maps to a slot with
+one AND.
+
+Design:
+- SpscRing: 'tail' is written only by the producer and 'head' only by the
+  consumer. Each side publishes its index with a release store and reads the
+  other's with an acquire load, which orders the slot write before the consumer
+  sees it. Each side also keeps a private copy of the other index
+  (head_cache / tail_cache) and reloads the shared one only when the cached copy
+  says full/empty, so in steady state a push or pop touches no cache line owned
+  by the other core.
+- MpmcQueue: Dmitry Vyukov's bounded MPMC queue. Every cell has a sequence
+  number: seq == pos means "free for the producer that claims pos", and
+  seq == pos + 1 means "full, for the consumer that claims pos". Producers and
+  consumers claim positions with one CAS on enqueue_pos / dequeue_pos, then
+  publish the cell with a release store of its new sequence. There is no ABA
+  problem because positions only grow and a cell is reused only after its
+  sequence has gone round: seq = pos + capacity.
+- The producer index, the consumer index and the read-only fields each sit on
+  their own LOCKFREE_CACHE_LINE-aligned line, so producers and consumers never
+  false-share. Both structs are over-aligned: put them on the stack, in static
+  storage or in aligned_alloc() memory, not plain malloc().
+- Memory for the slots comes from aligned_alloc(); init returns -1 with errno
+  set to EINVAL (capacity 0 or too large) or ENOMEM.
+
+Compile with -pthread when the queues are shared between pthreads.
+*/
+
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#define LOCKFREE_CACHE_LINE 64
+
+// Smallest power of two >= n (n >= 1), or 0 if that does not fit in size_t.
+static inline size_t lockfree_round_pow2_(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        if (p > SIZE_MAX / 2) return 0;
+        p <<= 1;
+    }
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// SPSC ring buffer
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    // Read-only after init
+    _Alignas(LOCKFREE_CACHE_LINE) void** slots;
+    size_t mask;
+
+    // Producer side
+    _Alignas(LOCKFREE_CACHE_LINE) atomic_size_t tail;   // Next slot to write
+    size_t head_cache;                                  // Producer's last view of head
+
+    // Consumer side
+    _Alignas(LOCKFREE_CACHE_LINE) atomic_size_t head;   // Next slot to read
+    size_t tail_cache;                                  // Consumer's last view of tail
+} SpscRing;
+
+static inline int spsc_ring_init(SpscRing* r, size_t capacity) {
+    size_t cap = capacity ? lockfree_round_pow2_(capacity) : 0;
+    if (cap == 0 || cap > SIZE_MAX / sizeof(void*)) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t bytes = cap * sizeof(void*);
+    bytes = (bytes + LOCKFREE_CACHE_LINE - 1) & ~(size_t)(LOCKFREE_CACHE_LINE - 1);
+    r->slots = (void**)aligned_alloc(LOCKFREE_CACHE_LINE, bytes);
+    if (r->slots == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    r->mask = cap - 1;
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->head, 0);
+    r->head_cache = 0;
+    r->tail_cache = 0;
+    return 0;
+}
+
+static inline void spsc_ring_destroy(SpscRing* r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+static inline size_t spsc_ring_capacity(const SpscRing* r) {
+    return r->mask + 1;
+}
+
+// Producer only.
+static inline int spsc_ring_push(SpscRing* r, void* item) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (tail - r->head_cache > r->mask) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tail - r->head_cache > r->mask) return 0;  // Full
+    }
+    r->slots[tail & r->mask] = item;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// Consumer only.
+static inline int spsc_ring_pop(SpscRing* r, void** item) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head == r->tail_cache) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head == r->tail_cache) return 0;  // Empty
+    }
+    *item = r->slots[head & r->mask];
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 1;
+}
+
+// Consumer only. Pops up to 'max' items with a single release store, which is
+// cheaper than 'max' calls to spsc_ring_pop() when the ring is busy.
+static inline size_t spsc_ring_pop_many(SpscRing* r, void** items, size_t max) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t avail = r->tail_cache - head;
+    if (avail < max) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        avail = r->tail_cache - head;
+    }
+    size_t n = avail < max ? avail : max;
+    for (size_t i = 0; i < n; i++) items[i] = r->slots[(head + i) & r->mask];
+    if (n) atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// MPMC queue (Vyukov)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    atomic_size_t seq;
+    void* data;
+} MpmcCell_;
+
+typedef struct {
+    // Read-only after init
+    _Alignas(LOCKFREE_CACHE_LINE) MpmcCell_* cells;
+    size_t mask;
+
+    _Alignas(LOCKFREE_CACHE_LINE) atomic_size_t enqueue_pos;  // Producers
+    _Alignas(LOCKFREE_CACHE_LINE) atomic_size_t dequeue_pos;  // Consumers
+} MpmcQueue;
+
+// Capacity is rounded up to a power of two, and at least 2.
+static inline int mpmc_queue_init(MpmcQueue* q, size_t capacity) {
+    size_t cap = capacity ? lockfree_round_pow2_(capacity < 2 ? 2 : capacity) : 0;
+    if (cap == 0 || cap > SIZE_MAX / sizeof(MpmcCell_)) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t bytes = cap * sizeof(MpmcCell_);
+    bytes = (bytes + LOCKFREE_CACHE_LINE - 1) & ~(size_t)(LOCKFREE_CACHE_LINE - 1);
+    q->cells = (MpmcCell_*)aligned_alloc(LOCKFREE_CACHE_LINE, bytes);
+    if (q->cells == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0; i < cap; i++) {
+        atomic_init(&q->cells[i].seq, i);
+        q->cells[i].data = NULL;
+    }
+    q->mask = cap - 1;
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    return 0;
+}
+
+static inline void mpmc_queue_destroy(MpmcQueue* q) {
+    free(q->cells);
+    q->cells = NULL;
+}
+
+static inline size_t mpmc_queue_capacity(const MpmcQueue* q) {
+    return q->mask + 1;
+}
+
+static inline int mpmc_queue_push(MpmcQueue* q, void* item) {
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    MpmcCell_* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // Free cell: claim it. On failure 'pos' is reloaded by the CAS.
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;  // The cell still holds an item from one lap ago: full
+        } else {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    cell->data = item;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+static inline int mpmc_queue_pop(MpmcQueue* q, void** item) {
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    MpmcCell_* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;  // Not yet written: empty
+        } else {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+    *item = cell->data;
+    // Free the cell for the producer one lap ahead
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return 1;
+}
+
+#endif // LOCKFREE_QUEUE_H
@@ -0,0 +1,489 @@
+/*
+thread_pool.h - Work-Stealing Thread Pool with parallel_for and parallel_reduce
+================================================
+
+A header-only pthread runtime for data-parallel loops:
+
+    ThreadPool pool;
+    thread_pool_init(&pool, 0);                         // 0: one thread per usable CPU
+    parallel_for(&pool, 0, n, 0, scale_chunk, &args);  // fn(ctx, begin, end, worker)
+    uint64_t total = parallel_sum_u64(&pool, 0, n, 0, count_chunk, &args);
+    thread_pool_destroy(&pool);
+
+Design:
+- The thread that calls parallel_for() takes part as worker 0, so a pool of N
+  threads starts N - 1 pthreads, and a pool of 1 runs loops inline.
+- Thread counts are capped to the CPUs in the process affinity mask
+  (sched_getaffinity), so a container or taskset limit is respected and the pool
+  never oversubscribes.
+- Every worker owns a Chase-Lev work-stealing deque of index ranges. The range
+  is split lazily: a worker that takes a range larger than 'grain' pushes the upper
+  half onto its own deque and keeps the lower half, until it is left with a chunk
+  of at most 'grain' iterations that it runs. Idle workers steal from the top of
+  other deques, where the largest ranges sit, so load balances itself and there is
+  no up-front partitioning to tune.
+- The deque follows Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient
+  Work-Stealing for Weak Memory Models" (PPoPP 2013). The owner pushes and takes at
+  the bottom without locks; thieves race for the top with one CAS. Because ranges
+  are split by halving, a deque never holds more than ~64 entries, so a fixed
+  ring buffer is enough.
+- parallel_reduce() gives each worker its own accumulator slot, padded to a
+  multiple of THREAD_POOL_CACHE_LINE bytes, so workers never write to the same
+  cache line (no false sharing); the slots are combined once at the end.
+- A parallel_for() issued from inside a loop body runs inline on the calling
+  worker. Calls from several outside threads on one pool are serialised.
+
+Compile with -pthread.
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#define THREAD_POOL_CACHE_LINE 64
+#define THREAD_POOL_MAX_THREADS 256
+#define THREAD_POOL_DEQUE_SIZE 128   // Power of two; halving keeps depth <= 64
+
+typedef void (*ParallelForFn)(void* ctx, size_t begin, size_t end, unsigned worker);
+typedef void (*ParallelReduceFn)(void* ctx, size_t begin, size_t end, void* acc);
+typedef void (*ParallelCombineFn)(void* into, const void* from);
+typedef uint64_t (*ParallelSumFn)(void* ctx, size_t begin, size_t end);
+
+// A deque slot. Fields are atomics so a thief may read a slot the owner is
+// rewriting; the thief's CAS on 'top' then fails and the value is discarded.
+typedef struct {
+    _Atomic size_t begin;
+    _Atomic size_t end;
+} ThreadPoolRange_;
+
+typedef struct {
+    _Alignas(THREAD_POOL_CACHE_LINE) atomic_long top;     // Thieves
+    _Alignas(THREAD_POOL_CACHE_LINE) atomic_long bottom;  // Owner
+    ThreadPoolRange_ slots[THREAD_POOL_DEQUE_SIZE];
+} ThreadPoolDeque_;
+
+typedef struct {
+    ParallelForFn fn;
+    void* ctx;
+    size_t grain;
+    _Alignas(THREAD_POOL_CACHE_LINE) atomic_size_t remaining;  // Iterations not yet run
+} ThreadPoolJob_;
+
+struct ThreadPool;
+
+typedef struct {
+    struct ThreadPool* pool;
+    unsigned index;
+    pthread_t thread;
+} ThreadPoolWorker_;
+
+typedef struct ThreadPool {
+    unsigned nthreads;                 // Including the calling thread
+    ThreadPoolDeque_* deques;          // One per worker, cache-line aligned
+    ThreadPoolWorker_* workers;        // nthreads - 1 started threads (index 1..)
+
+    pthread_mutex_t lock;              // Protects job, epoch, pending, stop
+    pthread_cond_t wake;               // Workers wait here for a new epoch
+    pthread_cond_t done;               // The caller waits here for pending == 0
+    ThreadPoolJob_* job;
+    unsigned long epoch;
+    unsigned pending;                  // Workers that have not finished the current job
+    int stop;
+
+    pthread_mutex_t submit_lock;       // Serialises outside callers
+
+    unsigned char* scratch;            // Padded reduction slots, grown on demand
+    size_t scratch_size;
+} ThreadPool;
+
+// Worker index of the current thread inside a pool loop, or -1 outside one.
+static _Thread_local int thread_pool_self_ = -1;
+
+// CPUs this process may run on (the affinity mask), at least 1.
+static inline unsigned thread_pool_cpu_count(void) {
+#if defined(__linux__) && defined(SYS_sched_getaffinity)
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    long bytes = syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask);
+    if (bytes > 0) {
+        unsigned count = 0;
+        for (size_t i = 0; i < (size_t)bytes / sizeof(unsigned long); i++) {
+            count += (unsigned)__builtin_popcountl(mask[i]);
+        }
+        if (count > 0) return count;
+    }
+#endif
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (unsigned)online : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Chase-Lev deque
+// ---------------------------------------------------------------------------
+
+// Owner only. Returns 0 if the deque is full (the caller then keeps the work).
+static inline int thread_pool_push_(ThreadPoolDeque_* d, size_t begin, size_t end) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - t >= THREAD_POOL_DEQUE_SIZE) return 0;
+    ThreadPoolRange_* slot = &d->slots[b & (THREAD_POOL_DEQUE_SIZE - 1)];
+    atomic_store_explicit(&slot->begin, begin, memory_order_relaxed);
+    atomic_store_explicit(&slot->end, end, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 1;
+}
+
+// Owner only: take the most recently pushed range.
+static inline int thread_pool_take_(ThreadPoolDeque_* d, size_t* begin, size_t* end) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return 0;
+    }
+    ThreadPoolRange_* slot = &d->slots[b & (THREAD_POOL_DEQUE_SIZE - 1)];
+    *begin = atomic_load_explicit(&slot->begin, memory_order_relaxed);
+    *end = atomic_load_explicit(&slot->end, memory_order_relaxed);
+    if (t == b) {
+        // Last entry: race the thieves for it
+        int won = atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                          memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+// Any thread: take the oldest (largest) range.
+static inline int thread_pool_steal_one_(ThreadPoolDeque_* d, size_t* begin, size_t* end) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return 0;
+    ThreadPoolRange_* slot = &d->slots[t & (THREAD_POOL_DEQUE_SIZE - 1)];
+    *begin = atomic_load_explicit(&slot->begin, memory_order_relaxed);
+    *end = atomic_load_explicit(&slot->end, memory_order_relaxed);
+    return atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                   memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Scheduling
+// ---------------------------------------------------------------------------
+
+static inline void thread_pool_execute_(ThreadPool* pool, ThreadPoolJob_* job, unsigned self,
+                                        size_t begin, size_t end) {
+    ThreadPoolDeque_* own = &pool->deques[self];
+    // Keep the lower half and publish the upper half until the chunk is small
+    while (end - begin > job->grain) {
+        size_t mid = begin + (end - begin) / 2;
+        if (!thread_pool_push_(own, mid, end)) break;
+        end = mid;
+    }
+    job->fn(job->ctx, begin, end, self);
+    atomic_fetch_sub_explicit(&job->remaining, end - begin, memory_order_acq_rel);
+}
+
+static inline void thread_pool_participate_(ThreadPool* pool, ThreadPoolJob_* job, unsigned self) {
+    uint32_t seed = 0x9E3779B9u * (self + 1);
+    unsigned idle = 0;
+    thread_pool_self_ = (int)self;
+    while (atomic_load_explicit(&job->remaining, memory_order_acquire) > 0) {
+        size_t begin, end;
+        if (thread_pool_take_(&pool->deques[self], &begin, &end)) {
+            thread_pool_execute_(pool, job, self, begin, end);
+            idle = 0;
+            continue;
+        }
+        // Own deque empty: try every other worker once, from a random start
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        int stolen = 0;
+        for (unsigned k = 0; k < pool->nthreads && !stolen; k++) {
+            unsigned victim = (seed + k) % pool->nthreads;
+            if (victim != self && thread_pool_steal_one_(&pool->deques[victim], &begin, &end)) {
+                thread_pool_execute_(pool, job, self, begin, end);
+                stolen = 1;
+            }
+        }
+        if (stolen) {
+            idle = 0;
+        } else if (++idle > 16) {
+            sched_yield();  // Nothing to steal: let the busy threads have the CPU
+        }
+    }
+    thread_pool_self_ = -1;
+}
+
+static void* thread_pool_worker_main_(void* arg) {
+    ThreadPoolWorker_* w = (ThreadPoolWorker_*)arg;
+    ThreadPool* pool = w->pool;
+    unsigned long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->epoch == seen && !pool->stop) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->epoch;
+        ThreadPoolJob_* job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
+
+        thread_pool_participate_(pool, job, w->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static inline void thread_pool_shutdown_(ThreadPool* pool, unsigned started) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned i = 0; i < started; i++) pthread_join(pool->workers[i].thread, NULL);
+}
+
+// Start a pool of 'nthreads' workers including the caller; 0 means one per CPU
+// in the affinity mask, and larger requests are capped to that count.
+static inline int thread_pool_init(ThreadPool* pool, unsigned nthreads) {
+    memset(pool, 0, sizeof(*pool));
+    unsigned cpus = thread_pool_cpu_count();
+    if (nthreads == 0 || nthreads > cpus) nthreads = cpus;
+    if (nthreads > THREAD_POOL_MAX_THREADS) nthreads = THREAD_POOL_MAX_THREADS;
+    pool->nthreads = nthreads;
+
+    if (posix_memalign((void**)&pool->deques, THREAD_POOL_CACHE_LINE,
+                       nthreads * sizeof(ThreadPoolDeque_)) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (unsigned i = 0; i < nthreads; i++) {
+        atomic_init(&pool->deques[i].top, 0);
+        atomic_init(&pool->deques[i].bottom, 0);
+    }
+    pool->workers = (ThreadPoolWorker_*)calloc(nthreads, sizeof(ThreadPoolWorker_));
+    if (pool->workers == NULL) {
+        free(pool->deques);
+        errno = ENOMEM;
+        return -1;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->submit_lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (unsigned i = 1; i < nthreads; i++) {
+        ThreadPoolWorker_* w = &pool->workers[i - 1];
+        w->pool = pool;
+        w->index = i;
+        int rc = pthread_create(&w->thread, NULL, thread_pool_worker_main_, w);
+        if (rc != 0) {
+            thread_pool_shutdown_(pool, i - 1);
+            pthread_cond_destroy(&pool->wake);
+            pthread_cond_destroy(&pool->done);
+            pthread_mutex_destroy(&pool->lock);
+            pthread_mutex_destroy(&pool->submit_lock);
+            free(pool->workers);
+            free(pool->deques);
+            errno = rc;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static inline void thread_pool_destroy(ThreadPool* pool) {
+    thread_pool_shutdown_(pool, pool->nthreads - 1);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit_lock);
+    free(pool->workers);
+    free(pool->deques);
+    free(pool->scratch);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static inline unsigned thread_pool_size(const ThreadPool* pool) {
+    return pool->nthreads;
+}
+
+// Thread counts for a strong-scaling sweep (same problem, more threads):
+// 1, 2, 4, ... below 'max', then 'max' itself. Writes at most 'cap' entries
+// to 'out' and returns how many were written.
+static inline unsigned thread_pool_scaling_steps(unsigned max, unsigned* out, unsigned cap) {
+    unsigned count = 0;
+    if (max == 0) max = 1;
+    for (unsigned t = 1; t < max && count + 1 < cap; t *= 2) out[count++] = t;
+    if (count < cap) out[count++] = max;
+    return count;
+}
+
+static inline size_t thread_pool_grain_(const ThreadPool* pool, size_t begin, size_t end, size_t grain) {
+    if (grain == 0) {
+        grain = (end - begin) / (8 * (size_t)pool->nthreads);
+        if (grain == 0) grain = 1;
+    }
+    return grain;
+}
+
+// Run one job. The caller holds submit_lock, or is already inside a pool task.
+static inline void thread_pool_run_(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                                    ParallelForFn fn, void* ctx) {
+    if (end <= begin) return;
+    grain = thread_pool_grain_(pool, begin, end, grain);
+
+    // Single thread, or a nested loop inside a pool task: run inline
+    if (pool->nthreads == 1 || thread_pool_self_ >= 0) {
+        int outer = thread_pool_self_;
+        unsigned self = outer >= 0 ? (unsigned)outer : 0;
+        thread_pool_self_ = (int)self;  // Loops nested inside fn also run inline
+        for (size_t b = begin; b < end; b += grain) fn(ctx, b, end - b > grain ? b + grain : end, self);
+        thread_pool_self_ = outer;
+        return;
+    }
+
+    ThreadPoolJob_ job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.grain = grain;
+    atomic_init(&job.remaining, end - begin);
+
+    // The whole range starts on the caller's deque; thieves split it from there
+    thread_pool_push_(&pool->deques[0], begin, end);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->pending = pool->nthreads - 1;
+    pool->epoch++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    thread_pool_participate_(pool, &job, 0);
+
+    // Every worker must be out of the job before 'job' goes out of scope
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Run fn(ctx, b, e, worker) over disjoint chunks covering [begin, end). Chunks have
+// at most 'grain' iterations (0 picks about 8 chunks per thread). 'worker' is in
+// [0, thread_pool_size()) and is stable for the duration of one chunk, so it can
+// index per-worker state. Returns when every chunk has run.
+static inline void parallel_for(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                                ParallelForFn fn, void* ctx) {
+    int outside = thread_pool_self_ < 0;
+    if (outside) pthread_mutex_lock(&pool->submit_lock);
+    thread_pool_run_(pool, begin, end, grain, fn, ctx);
+    if (outside) pthread_mutex_unlock(&pool->submit_lock);
+}
+
+// ---------------------------------------------------------------------------
+// Reductions
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    ParallelReduceFn fn;
+    void* ctx;
+    unsigned char* slots;
+    size_t slot_stride;        // acc_size rounded up to a whole number of cache lines
+} ThreadPoolReduce_;
+
+static inline void thread_pool_reduce_chunk_(void* arg, size_t begin, size_t end, unsigned worker) {
+    ThreadPoolReduce_* r = (ThreadPoolReduce_*)arg;
+    r->fn(r->ctx, begin, end, r->slots + (size_t)worker * r->slot_stride);
+}
+
+// Reduce [begin, end) into 'result' (acc_size bytes). Each worker starts from a
+// copy of 'identity' and folds its chunks in with fn(ctx, b, e, acc); the worker
+// accumulators are then merged with combine(into, from) in worker order.
+// Returns -1 with errno = ENOMEM if the accumulator slots cannot be allocated.
+static inline int parallel_reduce(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                                  ParallelReduceFn fn, ParallelCombineFn combine, void* ctx,
+                                  const void* identity, void* result, size_t acc_size) {
+    size_t stride = (acc_size + THREAD_POOL_CACHE_LINE - 1) / THREAD_POOL_CACHE_LINE * THREAD_POOL_CACHE_LINE;
+    if (stride == 0) stride = THREAD_POOL_CACHE_LINE;
+    size_t bytes = stride * pool->nthreads;
+    int outside = thread_pool_self_ < 0;
+    unsigned char* slots = NULL;
+
+    if (outside) {
+        // The pool's scratch buffer is reused across calls, guarded by submit_lock
+        pthread_mutex_lock(&pool->submit_lock);
+        if (pool->scratch_size < bytes) {
+            unsigned char* grown = NULL;
+            if (posix_memalign((void**)&grown, THREAD_POOL_CACHE_LINE, bytes) != 0) {
+                pthread_mutex_unlock(&pool->submit_lock);
+                errno = ENOMEM;
+                return -1;
+            }
+            free(pool->scratch);
+            pool->scratch = grown;
+            pool->scratch_size = bytes;
+        }
+        slots = pool->scratch;
+    } else if (posix_memalign((void**)&slots, THREAD_POOL_CACHE_LINE, bytes) != 0) {
+        // Nested: the scratch buffer belongs to the outer loop
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (unsigned i = 0; i < pool->nthreads; i++) memcpy(slots + i * stride, identity, acc_size);
+    ThreadPoolReduce_ r = {fn, ctx, slots, stride};
+    thread_pool_run_(pool, begin, end, grain, thread_pool_reduce_chunk_, &r);
+    for (unsigned i = 1; i < pool->nthreads; i++) combine(slots, slots + i * stride);
+    memcpy(result, slots, acc_size);
+
+    if (outside) pthread_mutex_unlock(&pool->submit_lock);
+    else free(slots);
+    return 0;
+}
+
+typedef struct {
+    ParallelSumFn fn;
+    void* ctx;
+} ThreadPoolSum_;
+
+static inline void thread_pool_sum_chunk_(void* arg, size_t begin, size_t end, void* acc) {
+    ThreadPoolSum_* s = (ThreadPoolSum_*)arg;
+    *(uint64_t*)acc += s->fn(s->ctx, begin, end);
+}
+
+static inline void thread_pool_sum_combine_(void* into, const void* from) {
+    *(uint64_t*)into += *(const uint64_t*)from;
+}
+
+// Sum of fn(ctx, b, e) over chunks covering [begin, end), the common case of
+// parallel_reduce() with one padded uint64_t accumulator per worker.
+static inline uint64_t parallel_sum_u64(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                                        ParallelSumFn fn, void* ctx) {
+    ThreadPoolSum_ s = {fn, ctx};
+    uint64_t zero = 0, total = 0;
+    if (parallel_reduce(pool, begin, end, grain, thread_pool_sum_chunk_, thread_pool_sum_combine_,
+                        &s, &zero, &total, sizeof(total)) != 0) {
+        return fn(ctx, begin, end);  // No memory for the slots: run serially
+    }
+    return total;
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,281 @@
+/*
+Benchmarking and Performance Measurement in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+A microbenchmark times a small piece of code in isolation. Done naively - one clock()
+call before, one after - the result mixes the code under test with timer resolution,
+page faults, frequency scaling, and whatever else the machine happened to be doing.
+Worse, an optimizing compiler may notice that the result is never used and delete the
+work entirely, producing impressively fast and completely meaningless numbers.
+
+Key points:
+- clock() measures processor time of the whole process, with coarse resolution
+  (CLOCKS_PER_SEC). clock_gettime(CLOCK_MONOTONIC) measures elapsed time in nanoseconds
+  and never jumps backwards when the wall clock is adjusted.
+- A single run is one sample from a noisy distribution. Repeat the run and report
+  robust statistics (median and high percentiles) instead of a single number.
+- The first runs of a benchmark are usually slower (cold caches, page faults, lazy
+  binding), so they are executed as warmup and discarded.
+
+Every chapter in this repository uses the shared harness in bench.h for its
+"Performance Analysis and Optimization" section. This file explains how it works.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "bench.h"
+
+// Function prototypes
+void monotonic_clock_example();
+void dead_code_elimination_example();
+void statistics_example();
+void suite_example();
+void machine_readable_output_example();
+
+int main() {
+    printf("Benchmarking and Performance Measurement Cheat Sheet\n");
+    printf("====================================================\n\n");
+
+    monotonic_clock_example();
+    dead_code_elimination_example();
+    statistics_example();
+    suite_example();
+    machine_readable_output_example();
+
+    return 0;
+}
+
+void monotonic_clock_example() {
+    printf("2.1 Monotonic Nanosecond Clock\n");
+    printf("-------------------------------\n");
+
+    // Smallest measurable interval: back-to-back reads of the clock
+    uint64_t smallest = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t a = bench_now_ns();
+        uint64_t b = bench_now_ns();
+        if (b - a < smallest) smallest = b - a;
+    }
+    printf("Back-to-back bench_now_ns() delta: %llu ns\n", (unsigned long long)smallest);
+    printf("clock() resolution: %.0f ns (CLOCKS_PER_SEC = %ld)\n\n",
+           1e9 / CLOCKS_PER_SEC, (long)CLOCKS_PER_SEC);
+}
+
+// Without a barrier, -O2 can fold this whole loop into a constant or delete it
+void sum_without_barrier(void* ctx) {
+    int n = *(const int*)ctx;
+    unsigned int sum = 0;
+    for (int i = 0; i < n; i++) sum += (unsigned int)i * i;
+    (void)sum;
+}
+
+void sum_with_barrier(void* ctx) {
+    int n = *(const int*)ctx;
+    BENCH_HIDE_VALUE(n);
+    unsigned int sum = 0;
+    for (int i = 0; i < n; i++) sum += (unsigned int)i * i;
+    BENCH_DO_NOT_OPTIMIZE(sum);
+}
+
+void dead_code_elimination_example() {
+    printf("2.2 Dead Code Elimination and the Do-Not-Optimize Barrier\n");
+    printf("---------------------------------------------------------\n");
+
+    int n = 1000000;
+    BenchConfig config = bench_default_config();
+    BenchResult without = bench_measure("no barrier", sum_without_barrier, &n, n, &config);
+    BenchResult with = bench_measure("with barrier", sum_with_barrier, &n, n, &config);
+
+    printf("Without barrier: %.3f ns/op\n", without.ns_per_op);
+    printf("With barrier:    %.3f ns/op\n", with.ns_per_op);
+    printf("(Compile with -O2 to see the unprotected loop disappear.)\n\n");
+}
+
+void statistics_example() {
+    printf("2.3 Robust Statistics\n");
+    printf("----------------------\n");
+
+    // One outlier (a context switch, say) drags the mean but not the median
+    double samples[] = {100, 101, 99, 100, 102, 98, 100, 5000, 101, 99};
+    int n = sizeof(samples) / sizeof(samples[0]);
+    BenchResult r = {0};
+    r.name = "synthetic";
+    r.ops = 1;
+    bench_compute_stats(&r, samples, n);
+
+    printf("mean = %.1f, median = %.1f, p99 = %.1f, stddev = %.1f\n\n",
+           r.mean_ns, r.median_ns, r.p99_ns, r.stddev_ns);
+}
+
+// Two ways to fill an array, compared in one suite
+typedef struct {
+    int* data;
+    int size;
+} FillBench;
+
+void fill_loop_run(void* ctx) {
+    FillBench* bench = (FillBench*)ctx;
+    for (int i = 0; i < bench->size; i++) bench->data[i] = 0;
+    BENCH_CLOBBER();
+}
+
+void fill_memset_run(void* ctx) {
+    FillBench* bench = (FillBench*)ctx;
+    memset(bench->data, 0, bench->size * sizeof(int));
+    BENCH_CLOBBER();
+}
+
+void suite_example() {
+    printf("2.4 Comparing Implementations with a Suite\n");
+    printf("-------------------------------------------\n");
+
+    FillBench bench = {malloc(1000000 * sizeof(int)), 1000000};
+    if (bench.data == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+
+    BenchSuite suite;
+    bench_suite_init(&suite, "Zero-fill 1M ints");
+    const BenchResult* loop = bench_suite_run(&suite, "for loop", fill_loop_run, &bench, bench.size);
+    bench_suite_run(&suite, "memset", fill_memset_run, &bench, bench.size);
+    bench_suite_report(&suite);
+
+    double bytes = (double)bench.size * sizeof(int);
+    printf("for loop bandwidth: %.2f GB/s\n\n", bench_throughput(loop, bytes) / 1e9);
+    free(bench.data);
+}
+
+void machine_readable_output_example() {
+    printf("2.5 JSON and CSV Output\n");
+    printf("------------------------\n");
+
+    int n = 100000;
+    BenchSuite suite;
+    bench_suite_init(&suite, "Output format demo");
+    bench_suite_run(&suite, "sum", sum_with_barrier, &n, n);
+
+    printf("JSON Lines record:\n");
+    bench_write_json(stdout, &suite);
+    printf("CSV rows:\n");
+    bench_write_csv_header(stdout);
+    bench_write_csv(stdout, &suite);
+    printf("\nSet BENCH_JSON=results.jsonl or BENCH_CSV=results.csv to append these from any chapter.\n\n");
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Time a batch of operations per run, and report ns/op; one operation is usually
+   far below timer resolution.
+2. Report the median and a high percentile, not the mean of one run.
+3. Feed every result into BENCH_DO_NOT_OPTIMIZE, and hide compile-time constant
+   inputs with BENCH_HIDE_VALUE.
+4. Touch buffers before timing so page faults are not part of the first sample.
+5. Record compiler and flags with each result (bench.h does this automatically).
+
+Common Pitfalls:
+1. Measuring with clock(), which counts CPU time of all threads and has coarse resolution.
+2. Benchmarking a debug (-O0) build and drawing conclusions about release performance.
+3. Letting the compiler delete or hoist the measured work.
+4. Comparing runs taken on a laptop with frequency scaling or thermal throttling active.
+5. Working sets that accidentally fit (or do not fit) in cache between variants.
+
+Advanced Tips:
+1. Pin the benchmark to one core (taskset -c 2 ./bench) to reduce migration noise.
+2. Set the CPU governor to "performance" while benchmarking.
+3. Use BENCH_RUNS=101 for stable p99 values on noisy machines.
+4. Inspect the generated assembly (objdump -d, Compiler Explorer) for the hot loop.
+
+4. Integration and Real-World Applications
+==========================================
+- Regression tracking: collect BENCH_CSV output in CI for each compiler and -O level,
+  then compare medians against the previous commit.
+- Capacity planning: ns/op figures translate directly into operations per core-second.
+- Code review: attach a before/after suite table to performance-related changes.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Hardware performance counters (perf_event_open) measure cycles, cache misses and
+  branch mispredictions directly rather than inferring them from time.
+  perf_counters.h opens them around a region of code; Chapter6Pointers/
+  PointerArithmetic.c reports them per access next to its timings.
+- In-process tracing records where time goes in a running program rather than in
+  a benchmark loop. trace.h and TracingAndProfiling.c cover zones, per-thread event
+  rings and counters sampled through shared memory.
+- Statistical comparison (Mann-Whitney U, bootstrap confidence intervals) decides
+  whether a difference between two runs is real.
+- Continuous benchmarking services track performance per commit like test results.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why is my optimized benchmark reporting 0.000 ns/op?
+A: The compiler removed the work. Pass the result to BENCH_DO_NOT_OPTIMIZE.
+
+Q: Why does stddev vary so much between invocations?
+A: Background load, turbo boost and thermal limits. Pin the process, increase
+   BENCH_RUNS, and compare medians rather than means.
+
+Q: Can I benchmark multi-threaded code with this harness?
+A: Yes. The clock is wall time, so one run covers the whole parallel region.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+Tools:
+- perf stat / perf record: Hardware counters and sampling profiles on Linux.
+- hyperfine: Whole-program command-line benchmarking.
+- Compiler Explorer (Godbolt): Check what the compiler generated for a hot loop.
+
+Libraries:
+- Google Benchmark: C++ microbenchmark framework (source of the DoNotOptimize idiom).
+- nanobench: Single-header C++ microbenchmarking.
+
+Resources:
+- "Systems Performance" by Brendan Gregg.
+- Agner Fog's optimization manuals and instruction tables.
+
+8. Performance Analysis and Optimization
+========================================
+The harness itself costs two clock_gettime() calls per run (around 20-50 ns through
+the vDSO on Linux), which is negligible against runs of a millisecond or more. Keep
+each run long enough - at least 1000x the back-to-back clock delta printed in 2.1.
+
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+Remember to always test your code examples and verify the accuracy of any added information.
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o benchmark_harness BenchmarkHarness.c -O2
+
+Then execute the resulting binary:
+    ./benchmark_harness
+    BENCH_RUNS=51 BENCH_CSV=results.csv ./benchmark_harness
+*/
@@ -0,0 +1,451 @@
+/*
+In-Process Tracing and Live Counters in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+gprof (1982) instruments every function entry and samples the program counter, then
+writes gmon.out when the process exits. strace stops the traced process at every
+system call. Both answer useful questions, but neither fits a service that must keep
+running: one only reports at exit, the other slows every syscall by an order of
+magnitude.
+
+Game engines and browsers took a different route. The code marks its own interesting
+regions ("zones"), each thread appends timestamped events to a private ring buffer,
+and a viewer draws the result as a timeline (Chrome's about:tracing, Tracy, Perfetto).
+Numbers that do not fit a timeline - bytes allocated, syscalls issued - are kept as
+counters in memory that a separate monitoring process can read at any time.
+
+trace.h brings that model to this repository:
+- TRACE_ZONE_BEGIN/TRACE_ZONE_END and TRACE_SCOPE time a region of code.
+- Each thread records into its own lock-free ring; the newest events win.
+- trace_export_chrome() writes JSON that chrome://tracing and ui.perfetto.dev load.
+- TRACE_COUNTER_ADD updates per-thread counter rows; trace_shm_publish() puts them in
+  POSIX shared memory for another process to sample.
+- Without -DTRACE_ENABLE every macro expands to nothing.
+
+The allocators (Chapter15: arena.h, pool_alloc.h), the file I/O helpers (Chapter9:
+log_writer.h, file_view.h) and the sorts (Chapter14: sort.h) are instrumented. Built
+with -DTRACE_ENABLE, this file runs each of them, samples their counters from a forked child
+process while they run, and exports the timeline.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "trace.h"
+#include "bench.h"
+#include "../Chapter16MultithreadingAndConcurrency/thread_pool.h"
+#include "../Chapter14Algorithms/sort.h"
+#include "../Chapter15AdvancedMemoryManagement/arena.h"
+#include "../Chapter15AdvancedMemoryManagement/pool_alloc.h"
+#include "../Chapter9FileHandling/log_writer.h"
+#include "../Chapter9FileHandling/file_view.h"
+
+#define TRACE_DEMO_FILE "tracing_demo.json"
+#define TRACE_DEMO_LOG "tracing_demo.log"
+#define SAMPLE_INTERVAL_MS 100
+
+SORT_DEFINE_PARALLEL(sort_int, int, SORT_LESS)
+
+// Function prototypes
+void zone_cost_example();
+void sort_example();
+void allocator_example();
+void io_example();
+void export_example();
+pid_t start_sampler(const char* shm_name, int* stop_fd);
+void stop_sampler(pid_t child, int stop_fd);
+int run_sampler(const char* shm_name, int stop_fd);
+
+int main(int argc, char** argv) {
+    // Standalone sampler: ./tracing_and_profiling --sample /itsc-trace-<pid>
+    if (argc == 3 && strcmp(argv[1], "--sample") == 0) return run_sampler(argv[2], -1);
+
+    printf("In-Process Tracing and Live Counters Cheat Sheet\n");
+    printf("================================================\n\n");
+#ifndef TRACE_ENABLE
+    printf("Built without -DTRACE_ENABLE: the zones and counters below compile to nothing.\n\n");
+#endif
+
+    if (trace_init() != 0) perror("trace_init");
+    trace_thread_name("main");
+    if (trace_shm_name()[0] == '\0' && trace_shm_publish(NULL) != 0) {
+        printf("Shared memory unavailable (%s); counters stay in-process.\n\n", strerror(errno));
+    }
+
+    // Fork the sampler before any other thread exists
+    int stop_fd = -1;
+    pid_t sampler = trace_shm_name()[0] ? start_sampler(trace_shm_name(), &stop_fd) : -1;
+
+    zone_cost_example();
+    sort_example();
+    allocator_example();
+    io_example();
+
+    stop_sampler(sampler, stop_fd);
+    export_example();
+    trace_shutdown();
+    return 0;
+}
+
+void zone_cost_example() {
+    printf("2.2 Zones and What They Cost\n");
+    printf("-----------------------------\n");
+
+    enum { N = 200000 };
+    TRACE_ZONE_BEGIN(outer, "demo", "zone cost");
+
+    // Switched off at run time: one relaxed load and a branch per zone
+    trace_set_enabled(0);
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < N; i++) {
+        TRACE_SCOPE("demo", "empty zone");
+    }
+    double off_ns = (double)(bench_now_ns() - start) / N;
+
+    trace_set_enabled(1);
+    start = bench_now_ns();
+    for (int i = 0; i < N; i++) {
+        TRACE_SCOPE("demo", "empty zone");
+    }
+    double on_ns = (double)(bench_now_ns() - start) / N;
+
+    start = bench_now_ns();
+    for (int i = 0; i < N; i++) TRACE_COUNTER_ADD("demo.counter", 1);
+    double counter_ns = (double)(bench_now_ns() - start) / N;
+
+    TRACE_ZONE_END(outer);
+    printf("Zone, tracing switched off: %6.2f ns\n", off_ns);
+    printf("Zone, recording:            %6.2f ns\n", on_ns);
+    printf("TRACE_COUNTER_ADD:          %6.2f ns\n", counter_ns);
+    printf("Compiled without -DTRACE_ENABLE, all three are 0: the macros vanish.\n");
+    printf("The ring keeps the newest %d events per thread, so the %d empty zones\n",
+           TRACE_RING_EVENTS, N);
+    printf("above have already overwritten most of themselves.\n\n");
+}
+
+void sort_example() {
+    printf("2.3 Instrumented Sorts\n");
+    printf("-----------------------\n");
+
+    size_t n = 1u << 20;
+    int* values = (int*)malloc(n * sizeof(int));
+    if (values == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    uint32_t x = 12345;
+    for (size_t i = 0; i < n; i++) values[i] = (int)(x = x * 1664525u + 1013904223u);
+    sort_int(values, n);
+
+    ThreadPool pool;
+    if (thread_pool_init(&pool, 0) == 0) {
+        for (size_t i = 0; i < n; i++) values[i] = (int)(x = x * 1664525u + 1013904223u);
+        sort_int_parallel(&pool, values, n);
+        thread_pool_destroy(&pool);
+    }
+
+    // Each top-level call is one "sort" zone; the parallel sort adds one per merge pass
+    // and its chunk sorts show up on the worker threads.
+    printf("Sorted %zu ints serially and in parallel; sort.elements = %llu\n\n", n,
+           (unsigned long long)trace_counter_total(trace_counter_id("sort.elements")));
+    free(values);
+}
+
+typedef struct {
+    SlabPool* pool;
+    int ops;
+} PoolWorker;
+
+void* pool_worker(void* arg) {
+    PoolWorker* w = (PoolWorker*)arg;
+    trace_thread_name("pool worker");
+    void* live[256] = {0};
+    for (int i = 0; i < w->ops; i++) {
+        int slot = (int)((unsigned)i * 2654435761u >> 24);
+        if (live[slot]) slab_pool_free(w->pool, live[slot]);
+        live[slot] = slab_pool_alloc(w->pool);
+        // Bursts of frees push whole batches back to the depot
+        if (i % 4096 == 4095) {
+            for (int k = 0; k < 256; k++) {
+                slab_pool_free(w->pool, live[k]);
+                live[k] = NULL;
+            }
+        }
+    }
+    for (int k = 0; k < 256; k++) slab_pool_free(w->pool, live[k]);
+    return NULL;
+}
+
+void allocator_example() {
+    printf("2.4 Instrumented Allocators\n");
+    printf("----------------------------\n");
+
+    // Arena: trimming after every tenth request forces new chunks
+    Arena arena;
+    arena_init(&arena, 16 * 1024);
+    for (int request = 0; request < 100; request++) {
+        for (int i = 0; i < 400; i++) arena_alloc(&arena, 256);
+        arena_reset(&arena);
+        if (request % 10 == 9) arena_trim(&arena);
+    }
+    arena_destroy(&arena);
+
+    // Slab pool: four threads churning objects, refilling from and releasing to the depot
+    SlabPool pool;
+    if (slab_pool_init(&pool, 64) != 0) {
+        fprintf(stderr, "slab_pool_init failed\n");
+        return;
+    }
+    pthread_t threads[4];
+    PoolWorker worker = {&pool, 200000};
+    for (int t = 0; t < 4; t++) pthread_create(&threads[t], NULL, pool_worker, &worker);
+    for (int t = 0; t < 4; t++) pthread_join(threads[t], NULL);
+    slab_pool_destroy(&pool);
+
+    const char* names[] = {"arena.chunks", "arena.reserved_bytes", "pool.refills", "pool.releases",
+                           "pool.slabs"};
+    for (int i = 0; i < 5; i++) {
+        printf("%-22s %llu\n", names[i], (unsigned long long)trace_counter_total(trace_counter_id(names[i])));
+    }
+    printf("\n");
+}
+
+void io_example() {
+    printf("2.5 Instrumented File I/O\n");
+    printf("--------------------------\n");
+
+    remove(TRACE_DEMO_LOG);
+    LogWriterConfig config = log_writer_default_config();
+    config.policy = LOG_FLUSH_BYTES;
+    config.flush_bytes = 64 * 1024;
+    config.sync = 0;
+    LogWriter writer;
+    if (log_writer_open(&writer, TRACE_DEMO_LOG, &config) != 0) {
+        perror("log_writer_open");
+        return;
+    }
+    char record[128];
+    memset(record, 'x', sizeof(record) - 1);
+    record[sizeof(record) - 1] = '\n';
+    for (int i = 0; i < 50000; i++) log_writer_append(&writer, record, sizeof(record));
+    log_writer_close(&writer);
+
+    // Read it back once mapped and once through the buffered fallback
+    FileView view;
+    FileSpan span;
+    uint64_t bytes = 0;
+    const int modes[] = {FILE_VIEW_SEQUENTIAL, FILE_VIEW_BUFFERED};
+    for (int m = 0; m < 2; m++) {
+        if (file_view_open(&view, TRACE_DEMO_LOG, modes[m]) != 0) continue;
+        while (file_view_next(&view, 0, &span) > 0) bytes += span.len;
+        file_view_close(&view);
+    }
+    remove(TRACE_DEMO_LOG);
+
+    const char* names[] = {"io.writev_calls", "io.write_bytes", "io.mapped_bytes", "io.read_calls",
+                           "io.read_bytes"};
+    for (int i = 0; i < 5; i++) {
+        printf("%-22s %llu\n", names[i], (unsigned long long)trace_counter_total(trace_counter_id(names[i])));
+    }
+    printf("(read back %llu bytes)\n\n", (unsigned long long)bytes);
+}
+
+void export_example() {
+    printf("2.6 Exporting the Timeline\n");
+    printf("---------------------------\n");
+
+    // Counter totals as one more event, so they appear as tracks next to the zones
+    trace_counters_sample();
+    long events = trace_export_chrome_file(TRACE_DEMO_FILE);
+    if (events < 0) {
+        perror("trace_export_chrome_file");
+        return;
+    }
+    printf("Wrote %ld events to %s.\n", events, TRACE_DEMO_FILE);
+    printf("Open it in ui.perfetto.dev or chrome://tracing.\n");
+    printf("Export can run while other threads are still recording.\n\n");
+}
+
+// Runs in a separate process: attach to the counters and print them every
+// SAMPLE_INTERVAL_MS until stop_fd reaches EOF (or forever when stop_fd is -1).
+int run_sampler(const char* shm_name, int stop_fd) {
+    TraceShmView view;
+    if (trace_shm_attach(&view, shm_name) != 0) {
+        fprintf(stderr, "[sampler] attach %s: %s\n", shm_name, strerror(errno));
+        return 1;
+    }
+    uint64_t totals[TRACE_MAX_COUNTERS];
+    for (;;) {
+        int n = trace_shm_sample(&view, totals);
+        printf("[sampler pid %d -> %d]", (int)getpid(), trace_shm_pid(&view));
+        for (int i = 0; i < n; i++) {
+            printf(" %s=%llu", trace_shm_counter_name(&view, i), (unsigned long long)totals[i]);
+        }
+        printf("\n");
+        fflush(stdout);
+
+        struct pollfd pfd = {stop_fd, POLLIN, 0};
+        if (stop_fd < 0) {
+            poll(NULL, 0, SAMPLE_INTERVAL_MS);
+        } else if (poll(&pfd, 1, SAMPLE_INTERVAL_MS) > 0) {
+            break;   // Parent closed the pipe
+        }
+    }
+    trace_shm_detach(&view);
+    return 0;
+}
+
+pid_t start_sampler(const char* shm_name, int* stop_fd) {
+    printf("2.1 Sampling Counters from Another Process\n");
+    printf("-------------------------------------------\n");
+    printf("Counters published at %s; a forked child samples them every %d ms.\n",
+           shm_name, SAMPLE_INTERVAL_MS);
+    printf("Any process can do the same: ./tracing_and_profiling --sample %s\n\n", shm_name);
+
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    fflush(stdout);   // Otherwise the child inherits and repeats buffered output
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (child == 0) {
+        close(fds[1]);
+        _exit(run_sampler(shm_name, fds[0]));
+    }
+    close(fds[0]);
+    *stop_fd = fds[1];
+    return child;
+}
+
+void stop_sampler(pid_t child, int stop_fd) {
+    if (child <= 0) return;
+    close(stop_fd);
+    waitpid(child, NULL, 0);
+    printf("\n");
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Put zones on operations that take microseconds or more: syscalls, lock waits,
+   refills, whole sorts. The cached pool alloc/free and the arena bump stay bare.
+2. Use string literals for zone and counter names; events store the pointer.
+3. Name threads with trace_thread_name() so the timeline is readable.
+4. Publish counters at startup, before worker threads run.
+5. Set TRACE_MIN_NS to drop short zones when a hot zone floods the ring.
+
+Common Pitfalls:
+1. Building the production binary without -DTRACE_ENABLE and wondering why the
+   exported trace is empty. Decide per build; switch per run with trace_set_enabled().
+2. A zone opened with TRACE_ZONE_BEGIN and left through an early return is never
+   recorded. Close it on every path, or use TRACE_SCOPE.
+3. Reading counters as a consistent snapshot. Each value is exact, but the sampler
+   reads them one at a time while the program keeps running.
+4. Calling trace_shutdown() while other threads still record: it frees their rings.
+
+Advanced Tips:
+1. Export on a signal or an admin endpoint: set a flag in the handler and call
+   trace_export_chrome_file() from a normal thread.
+2. Run the sampler under watch or a metrics agent to graph counters over time.
+3. Raise TRACE_RING_EVENTS (a power of two) for longer history per thread.
+
+4. Integration and Real-World Applications
+==========================================
+- Latency spikes: keep tracing on in production, export the rings when a request
+  exceeds its budget, and see which zone took the time on which thread.
+- Capacity dashboards: the shared-memory counters (bytes written, slabs allocated)
+  feed a monitoring agent without any RPC or log parsing.
+- Parallel scaling: the sort's per-thread chunk zones show idle workers directly.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Perfetto's protobuf format and the Linux ftrace/user_events interface let in-process
+  events appear on the same timeline as scheduler and syscall events.
+- Tracy and similar profilers stream events over a socket instead of exporting a
+  ring, and add sampling of call stacks.
+- eBPF uprobes can attach to unmodified binaries; USDT probes are zones the compiler
+  emits as nops until a tracer enables them.
+
+6. FAQs and Troubleshooting
+===========================
+Q: trace_shm_publish() fails with EACCES or ENOENT.
+A: /dev/shm is missing or not writable (some containers). Counters still work
+   in-process; read them with trace_counter_total().
+
+Q: The export reports "overwritten_events".
+A: The ring wrapped; only the newest TRACE_RING_EVENTS events per thread are kept.
+
+Q: Zones from another .c file are missing.
+A: Each translation unit has its own tracer state. Export from each, or keep the
+   instrumented code in one file.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+Tools:
+- ui.perfetto.dev and chrome://tracing: viewers for the exported JSON.
+- perf record / perf trace: sampling and syscall tracing without instrumentation.
+- strace -T and ltrace: per-call timing when the code cannot be changed.
+
+Libraries:
+- Perfetto SDK, Tracy, Intel ITT: production tracing libraries.
+- LTTng-UST: user-space tracepoints recorded by the kernel tracer.
+
+Resources:
+- "The Trace Event Format" document from the Chromium project.
+- "Systems Performance" by Brendan Gregg.
+
+8. Performance Analysis and Optimization
+========================================
+Section 2.2 measures the three costs on this machine. An active zone is dominated
+by two clock_gettime() calls; replacing them with rdtsc would cut it further at the
+cost of converting ticks to time at export. Counter rows are per thread, so even
+a counter bumped from every core never contends: the sampler pays for the sum.
+
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+Remember to always test your code examples and verify the accuracy of any added information.
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o tracing_and_profiling TracingAndProfiling.c -O2 -pthread -DTRACE_ENABLE
+
+Leave out -DTRACE_ENABLE to see the same program with tracing compiled out.
+
+Then execute the resulting binary:
+    ./tracing_and_profiling
+    TRACE_MIN_NS=1000 ./tracing_and_profiling
+*/
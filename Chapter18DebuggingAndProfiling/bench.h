@@ -0,0 +1,365 @@
+/*
+bench.h - Shared Microbenchmark Harness
+================================================
+
+A small header-only harness used by the "Performance Analysis and Optimization"
+sections of every chapter. It replaces the single-pass clock() timers with:
+
+- A monotonic nanosecond clock (clock_gettime(CLOCK_MONOTONIC)), so results measure
+  wall time rather than process CPU time rounded to CLOCKS_PER_SEC.
+- Untimed warmup runs followed by repeated timed runs.
+- Median, p99, min/max, mean and standard deviation per case, plus ns/op.
+- A do-not-optimize barrier so the compiler cannot drop the measured work.
+- JSON Lines and CSV output, tagged with compiler and build flags, so results can be
+  collected across compilers and -O levels and compared for regressions.
+
+Usage:
+    #include "../Chapter18DebuggingAndProfiling/bench.h"
+
+    void loop_run(void* ctx) {
+        int n = *(const int*)ctx;
+        unsigned int sum = 0;
+        for (int i = 0; i < n; i++) sum += i;
+        BENCH_DO_NOT_OPTIMIZE(sum);
+    }
+
+    BenchSuite suite;
+    int n = 1000000;
+    bench_suite_init(&suite, "Summation");
+    bench_suite_run(&suite, "loop", loop_run, &n, n);
+    bench_suite_report(&suite);
+
+Environment variables (read by bench_suite_init):
+    BENCH_RUNS=N      Timed runs per case (default 15, max BENCH_MAX_RUNS)
+    BENCH_WARMUP=N    Untimed warmup runs per case (default 3)
+    BENCH_JSON=path   Append one JSON object per suite to path (JSON Lines)
+    BENCH_CSV=path    Append one CSV row per case to path (header written once)
+
+Compile-time options:
+    -DBENCH_BUILD_TAG='"O2-lto"'   Free-form label stored with every result.
+                                   Defaults to the optimisation level the compiler
+                                   advertises (O0, Os or O1+).
+
+Everything is static inline so the header can be included from any single-file
+example without a separate library build step.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_CASES 32
+#define BENCH_MAX_RUNS 1000
+#define BENCH_DEFAULT_RUNS 15
+#define BENCH_DEFAULT_WARMUP 3
+
+#ifndef BENCH_BUILD_TAG
+#if defined(__OPTIMIZE_SIZE__)
+#define BENCH_BUILD_TAG "Os"
+#elif defined(__OPTIMIZE__)
+#define BENCH_BUILD_TAG "O1+"
+#else
+#define BENCH_BUILD_TAG "O0"
+#endif
+#endif
+
+#if defined(__clang__)
+#define BENCH_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+#define BENCH_COMPILER "gcc " __VERSION__
+#else
+#define BENCH_COMPILER "unknown"
+#endif
+
+// BENCH_DO_NOT_OPTIMIZE keeps 'value' alive: the compiler must assume it is read,
+// so the work that produced it cannot be removed. Pass an lvalue for portability.
+// BENCH_HIDE_VALUE makes the compiler forget what it knows about 'var' (e.g. a loop
+// bound), so work that depends on it cannot be constant-folded.
+// BENCH_CLOBBER forces pending stores to memory.
+#if defined(__GNUC__)
+#define BENCH_DO_NOT_OPTIMIZE(value) __asm__ __volatile__("" : : "r,m"(value) : "memory")
+#define BENCH_HIDE_VALUE(var) __asm__ __volatile__("" : "+r"(var) : : "memory")
+#define BENCH_CLOBBER() __asm__ __volatile__("" : : : "memory")
+#else
+static volatile const void* bench_escape_sink_;
+#define BENCH_DO_NOT_OPTIMIZE(value) (bench_escape_sink_ = (const void*)&(value))
+#define BENCH_HIDE_VALUE(var) (bench_escape_sink_ = (const void*)&(var))
+#define BENCH_CLOBBER() ((void)0)
+#endif
+
+// One timed run of a case. 'ctx' is passed through untouched.
+typedef void (*BenchFn)(void* ctx);
+
+typedef struct {
+    int warmup_runs;
+    int runs;
+} BenchConfig;
+
+typedef struct {
+    const char* name;
+    uint64_t ops;        // Operations performed by one run (for ns/op)
+    int runs;
+    double min_ns;
+    double max_ns;
+    double mean_ns;
+    double median_ns;
+    double p99_ns;
+    double stddev_ns;
+    double ns_per_op;    // median_ns / ops
+} BenchResult;
+
+typedef struct {
+    const char* title;
+    BenchConfig config;
+    BenchResult results[BENCH_MAX_CASES];
+    int count;
+} BenchSuite;
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline int bench_env_int_(const char* name, int fallback, int lo, int hi) {
+    const char* s = getenv(name);
+    if (s == NULL || *s == '\0') return fallback;
+    char* end;
+    long v = strtol(s, &end, 10);
+    if (*end != '\0' || v < lo || v > hi) {
+        fprintf(stderr, "bench: ignoring invalid %s=%s\n", name, s);
+        return fallback;
+    }
+    return (int)v;
+}
+
+static inline BenchConfig bench_default_config(void) {
+    BenchConfig config;
+    config.runs = bench_env_int_("BENCH_RUNS", BENCH_DEFAULT_RUNS, 1, BENCH_MAX_RUNS);
+    config.warmup_runs = bench_env_int_("BENCH_WARMUP", BENCH_DEFAULT_WARMUP, 0, BENCH_MAX_RUNS);
+    return config;
+}
+
+// Newton iteration, so callers do not need to link libm.
+static inline double bench_sqrt_(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 128; i++) {
+        double next = 0.5 * (r + x / r);
+        if (next >= r) break;
+        r = next;
+    }
+    return r;
+}
+
+static inline void bench_sort_(double* v, int n) {
+    for (int i = 1; i < n; i++) {
+        double key = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+}
+
+// Fill the statistics of 'r' from 'n' samples (sorted in place).
+static inline void bench_compute_stats(BenchResult* r, double* samples, int n) {
+    bench_sort_(samples, n);
+
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += samples[i];
+    r->mean_ns = sum / n;
+
+    double sq = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = samples[i] - r->mean_ns;
+        sq += d * d;
+    }
+    r->stddev_ns = n > 1 ? bench_sqrt_(sq / (n - 1)) : 0.0;
+
+    r->runs = n;
+    r->min_ns = samples[0];
+    r->max_ns = samples[n - 1];
+    r->median_ns = (n % 2) ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+
+    // Nearest-rank percentile: the smallest sample >= 99% of all samples.
+    int rank = (99 * n + 99) / 100;
+    r->p99_ns = samples[rank - 1];
+
+    r->ns_per_op = r->ops ? r->median_ns / (double)r->ops : r->median_ns;
+}
+
+// Time 'fn' without recording it in a suite.
+static inline BenchResult bench_measure(const char* name, BenchFn fn, void* ctx,
+                                        uint64_t ops, const BenchConfig* config) {
+    double samples[BENCH_MAX_RUNS];
+    BenchResult r;
+    memset(&r, 0, sizeof(r));
+    r.name = name;
+    r.ops = ops;
+
+    int runs = config->runs;
+    if (runs < 1) runs = 1;
+    if (runs > BENCH_MAX_RUNS) runs = BENCH_MAX_RUNS;
+
+    for (int i = 0; i < config->warmup_runs; i++) {
+        fn(ctx);
+        BENCH_CLOBBER();
+    }
+
+    for (int i = 0; i < runs; i++) {
+        uint64_t start = bench_now_ns();
+        fn(ctx);
+        BENCH_CLOBBER();
+        uint64_t end = bench_now_ns();
+        samples[i] = (double)(end - start);
+    }
+
+    bench_compute_stats(&r, samples, runs);
+    return r;
+}
+
+// Units processed per second at the median run time, e.g. pass a byte count to get B/s.
+static inline double bench_throughput(const BenchResult* r, double units_per_run) {
+    return r->median_ns > 0.0 ? units_per_run / (r->median_ns * 1e-9) : 0.0;
+}
+
+static inline void bench_suite_init(BenchSuite* suite, const char* title) {
+    memset(suite, 0, sizeof(*suite));
+    suite->title = title;
+    suite->config = bench_default_config();
+}
+
+// Measure one case and record it. Returns NULL if the suite is full.
+static inline const BenchResult* bench_suite_run(BenchSuite* suite, const char* name,
+                                                 BenchFn fn, void* ctx, uint64_t ops) {
+    if (suite->count >= BENCH_MAX_CASES) {
+        fprintf(stderr, "bench: suite '%s' is full, skipping '%s'\n", suite->title, name);
+        return NULL;
+    }
+    suite->results[suite->count] = bench_measure(name, fn, ctx, ops, &suite->config);
+    return &suite->results[suite->count++];
+}
+
+static inline void bench_fprint_json_string_(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static inline void bench_fprint_csv_string_(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+// One JSON object per suite, terminated by a newline (JSON Lines).
+static inline void bench_write_json(FILE* out, const BenchSuite* suite) {
+    fputs("{\"suite\":", out);
+    bench_fprint_json_string_(out, suite->title);
+    fputs(",\"compiler\":", out);
+    bench_fprint_json_string_(out, BENCH_COMPILER);
+    fputs(",\"build\":", out);
+    bench_fprint_json_string_(out, BENCH_BUILD_TAG);
+    fprintf(out, ",\"runs\":%d,\"warmup\":%d,\"cases\":[",
+            suite->config.runs, suite->config.warmup_runs);
+    for (int i = 0; i < suite->count; i++) {
+        const BenchResult* r = &suite->results[i];
+        if (i) fputc(',', out);
+        fputs("{\"name\":", out);
+        bench_fprint_json_string_(out, r->name);
+        fprintf(out, ",\"ops\":%llu,\"runs\":%d,\"min_ns\":%.1f,\"median_ns\":%.1f,"
+                     "\"mean_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f,\"stddev_ns\":%.1f,"
+                     "\"ns_per_op\":%.4f}",
+                (unsigned long long)r->ops, r->runs, r->min_ns, r->median_ns,
+                r->mean_ns, r->p99_ns, r->max_ns, r->stddev_ns, r->ns_per_op);
+    }
+    fputs("]}\n", out);
+}
+
+static inline void bench_write_csv_header(FILE* out) {
+    fputs("suite,case,compiler,build,ops,runs,min_ns,median_ns,mean_ns,p99_ns,max_ns,"
+          "stddev_ns,ns_per_op\n", out);
+}
+
+static inline void bench_write_csv(FILE* out, const BenchSuite* suite) {
+    for (int i = 0; i < suite->count; i++) {
+        const BenchResult* r = &suite->results[i];
+        bench_fprint_csv_string_(out, suite->title);
+        fputc(',', out);
+        bench_fprint_csv_string_(out, r->name);
+        fputc(',', out);
+        bench_fprint_csv_string_(out, BENCH_COMPILER);
+        fputc(',', out);
+        bench_fprint_csv_string_(out, BENCH_BUILD_TAG);
+        fprintf(out, ",%llu,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.4f\n",
+                (unsigned long long)r->ops, r->runs, r->min_ns, r->median_ns,
+                r->mean_ns, r->p99_ns, r->max_ns, r->stddev_ns, r->ns_per_op);
+    }
+}
+
+// Print a human-readable table; the first case is the baseline for the speedup column.
+static inline void bench_print(const BenchSuite* suite) {
+    printf("%s (%d runs, %d warmup, build %s)\n", suite->title,
+           suite->config.runs, suite->config.warmup_runs, BENCH_BUILD_TAG);
+    printf("%-32s %12s %12s %10s %12s %8s\n",
+           "case", "median ms", "p99 ms", "stddev %", "ns/op", "speedup");
+    for (int i = 0; i < suite->count; i++) {
+        const BenchResult* r = &suite->results[i];
+        double rel = r->median_ns > 0.0 ? 100.0 * r->stddev_ns / r->median_ns : 0.0;
+        double speedup = r->median_ns > 0.0 ? suite->results[0].median_ns / r->median_ns : 0.0;
+        printf("%-32s %12.3f %12.3f %10.1f %12.3f %7.2fx\n", r->name,
+               r->median_ns / 1e6, r->p99_ns / 1e6, rel, r->ns_per_op, speedup);
+    }
+}
+
+// Print the table and append machine-readable output if BENCH_JSON / BENCH_CSV are set.
+static inline void bench_suite_report(const BenchSuite* suite) {
+    bench_print(suite);
+
+    const char* json_path = getenv("BENCH_JSON");
+    if (json_path && *json_path) {
+        FILE* out = fopen(json_path, "a");
+        if (out) {
+            bench_write_json(out, suite);
+            fclose(out);
+        } else {
+            perror("bench: BENCH_JSON");
+        }
+    }
+
+    const char* csv_path = getenv("BENCH_CSV");
+    if (csv_path && *csv_path) {
+        FILE* out = fopen(csv_path, "a");
+        if (out) {
+            fseek(out, 0, SEEK_END);
+            if (ftell(out) == 0) bench_write_csv_header(out);
+            bench_write_csv(out, suite);
+            fclose(out);
+        } else {
+            perror("bench: BENCH_CSV");
+        }
+    }
+}
+
+#endif // BENCH_H
@@ -0,0 +1,205 @@
+/*
+perf_counters.h - Hardware Performance Counters via perf_event_open
+================================================
+
+Timing says how long a loop took; counters say why. This header opens a fixed
+set of per-thread hardware counters (cycles, instructions, L1D read misses,
+last-level-cache misses, dTLB read misses, branch misses) and reads them around
+a region of code:
+
+    #include "../Chapter18DebuggingAndProfiling/perf_counters.h"
+
+    PerfCounters pc;
+    if (perf_counters_open(&pc) != 0) {
+        printf("no counters: %s\n", strerror(errno));   // EACCES, ENOENT, ENOSYS ...
+    }
+    perf_counters_start(&pc);
+    work();
+    perf_counters_stop(&pc);
+    if (perf_counter_available(&pc, PERF_LLC_MISSES))
+        printf("%.2f LLC misses per op\n", perf_counter_value(&pc, PERF_LLC_MISSES) / ops);
+    perf_counters_close(&pc);
+
+Design:
+- Each counter is its own event, not a group. On machines with few counters, or
+  in VMs that expose only some events, every event that opens is still usable.
+  That costs one syscall per counter at start and stop. Keep the measured region
+  much longer than a few microseconds.
+- The kernel multiplexes events when there are more than the PMU has slots.
+  Values are scaled by time_enabled / time_running, as perf stat does. Both times
+  keep running across PERF_EVENT_IOC_RESET, so start reads all three and stop
+  scales the count's delta by the ratio of the time deltas.
+- Only user-space events of the calling thread are counted (exclude_kernel,
+  exclude_hv). That is what perf_event_paranoid <= 2, the usual default, allows
+  an unprivileged process.
+- perf_counters_open returns 0 when at least one counter opened. Otherwise it
+  returns -1 with errno from the first failure: EACCES or EPERM for paranoid
+  settings, ENOENT or EOPNOTSUPP when there is no PMU (common in containers and
+  VMs), and ENOSYS off Linux. The other calls are no-ops on counters that did not
+  open, so callers need no #ifdefs.
+- Building with -DPERF_COUNTERS_DISABLE compiles the syscalls out. syscall() needs
+  gcc's default gnu dialect, or _DEFAULT_SOURCE with -std=c11.
+*/
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__) && !defined(PERF_COUNTERS_DISABLE)
+#define PERF_HAVE_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+} PerfCounterId;
+
+typedef struct {
+    int fd[PERF_COUNTER_COUNT];          // -1 for counters that did not open
+    double value[PERF_COUNTER_COUNT];    // Scaled counts from the last start/stop
+    uint64_t start[PERF_COUNTER_COUNT][3];    // value, time_enabled, time_running at start
+} PerfCounters;
+
+static inline const char* perf_counter_name(PerfCounterId id) {
+    static const char* names[PERF_COUNTER_COUNT] = {"cycles",     "instructions", "L1D misses",
+                                                    "LLC misses", "dTLB misses",  "branch misses"};
+    return (unsigned)id < PERF_COUNTER_COUNT ? names[id] : "?";
+}
+
+#ifdef PERF_HAVE_EVENTS
+// type and config of each PerfCounterId
+static inline void perf_event_config_(PerfCounterId id, struct perf_event_attr* attr) {
+    const uint64_t read_miss = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (id) {
+    case PERF_CYCLES:
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_L1D_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+        break;
+    case PERF_LLC_MISSES:
+        attr->config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case PERF_DTLB_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+        break;
+    default:
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+#endif
+
+static inline int perf_counters_open(PerfCounters* pc) {
+    memset(pc, 0, sizeof(*pc));
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) pc->fd[i] = -1;
+#ifdef PERF_HAVE_EVENTS
+    int opened = 0, first_error = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        perf_event_config_((PerfCounterId)i, &attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd < 0) {
+            if (first_error == 0) first_error = errno;
+            continue;
+        }
+        pc->fd[i] = (int)fd;
+        opened++;
+    }
+    if (opened > 0) return 0;
+    errno = first_error;
+    return -1;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static inline int perf_counter_available(const PerfCounters* pc, PerfCounterId id) {
+    return (unsigned)id < PERF_COUNTER_COUNT && pc->fd[id] >= 0;
+}
+
+// Number of counters that opened
+static inline int perf_counters_count(const PerfCounters* pc) {
+    int n = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) n += pc->fd[i] >= 0;
+    return n;
+}
+
+static inline void perf_counters_start(PerfCounters* pc) {
+#ifdef PERF_HAVE_EVENTS
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fd[i] < 0) continue;
+        if (read(pc->fd[i], pc->start[i], sizeof(pc->start[i])) != (ssize_t)sizeof(pc->start[i])) {
+            memset(pc->start[i], 0, sizeof(pc->start[i]));
+        }
+        ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)pc;
+#endif
+}
+
+static inline void perf_counters_stop(PerfCounters* pc) {
+#ifdef PERF_HAVE_EVENTS
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fd[i] < 0) continue;
+        ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        pc->value[i] = 0;
+        if (pc->fd[i] < 0) continue;
+        uint64_t r[3];  // value, time_enabled, time_running
+        if (read(pc->fd[i], r, sizeof(r)) != (ssize_t)sizeof(r)) continue;
+        uint64_t count = r[0] - pc->start[i][0];
+        uint64_t enabled = r[1] - pc->start[i][1];
+        uint64_t running = r[2] - pc->start[i][2];
+        if (running == 0) continue;
+        pc->value[i] = (double)count * ((double)enabled / (double)running);
+    }
+#else
+    (void)pc;
+#endif
+}
+
+// Scaled count from the last start/stop, 0 if the counter is unavailable
+static inline double perf_counter_value(const PerfCounters* pc, PerfCounterId id) {
+    return perf_counter_available(pc, id) ? pc->value[id] : 0.0;
+}
+
+static inline void perf_counters_close(PerfCounters* pc) {
+#ifdef PERF_HAVE_EVENTS
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fd[i] >= 0) close(pc->fd[i]);
+        pc->fd[i] = -1;
+    }
+#else
+    (void)pc;
+#endif
+}
+
+#endif  // PERF_COUNTERS_H
@@ -0,0 +1,797 @@
+/*
+trace.h - In-Process Tracing Zones, Per-Thread Event Rings and Shared-Memory Counters
+================================================
+
+gprof and strace answer "where did the time go" after the fact, and both need the
+process restarted under the tool. This header is an always-available alternative for
+code that runs in production:
+
+- Timing zones mark a region of code. Each completed zone becomes one event in the
+  calling thread's ring buffer.
+- Every thread writes to its own ring, so recording takes no lock and no atomic
+  read-modify-write. A ring holds the most recent TRACE_RING_EVENTS events and
+  overwrites the oldest ones (a flight recorder).
+- trace_export_chrome() writes the rings as Chrome trace JSON, which
+  chrome://tracing and ui.perfetto.dev open directly. It can run at any time, from
+  any thread, while other threads keep recording.
+- Named counters (bytes allocated, syscalls issued, ...) live in a block that
+  trace_shm_publish() moves into POSIX shared memory. Another process maps it with
+  trace_shm_attach() and samples the totals while this one keeps running.
+
+Usage:
+    #define TRACE_ENABLE                  // or -DTRACE_ENABLE; without it every macro
+    #include "trace.h"                    // below expands to nothing
+
+    trace_init();                         // reads TRACE_FILE, TRACE_SHM, TRACE_MIN_NS
+    trace_thread_name("main");
+
+    TRACE_ZONE_BEGIN(zone, "io", "load config");
+    load_config();
+    TRACE_ZONE_END(zone);
+
+    void parse(void) {
+        TRACE_SCOPE("parse", "parse");    // Ends when the block exits (gcc/clang)
+        TRACE_COUNTER_ADD("parse.bytes", len);
+        ...
+    }
+
+    trace_export_chrome_file("trace.json");
+    trace_shutdown();                     // Also writes $TRACE_FILE if set
+
+Sampling from another process:
+    TraceShmView view;
+    trace_shm_attach(&view, "/itsc-trace-1234");    // name printed by the traced process
+    uint64_t totals[TRACE_MAX_COUNTERS];
+    int n = trace_shm_sample(&view, totals);
+    for (int i = 0; i < n; i++) printf("%s %llu\n", trace_shm_counter_name(&view, i), ...);
+    trace_shm_detach(&view);
+
+Cost:
+- Without TRACE_ENABLE the macros expand to nothing and the functions are empty
+  stubs (counters read 0, exports fail with ENOSYS), so the instrumented modules
+  compile to exactly what they were before. The sampler side (trace_shm_attach and
+  friends) is always available.
+- With TRACE_ENABLE but tracing switched off at run time (trace_set_enabled(0)), a
+  zone is one relaxed load and a branch.
+- An active zone is two clock_gettime(CLOCK_MONOTONIC) calls (vDSO, ~20 ns each) and
+  a 40-byte store into the ring. Zones shorter than TRACE_MIN_NS are not recorded.
+- A counter add is a thread-local lookup plus a load and a store to a row only the
+  calling thread writes, so hot counters never bounce cache lines between cores.
+  The sampler sums the rows. Counters keep counting when tracing is switched off.
+
+Rules and limits:
+- Names and categories must be string literals (or otherwise outlive the export):
+  events store the pointers, not copies.
+- The state is static, so zones in different translation units record into
+  different tracers. That suits the single-file programs in this repository.
+- Up to TRACE_MAX_THREADS live threads get a ring and a counter row. When a thread
+  exits, its slot goes back to a free list; the next thread continues in the same
+  ring (old events keep their tid) and adds to the same row (totals never go back).
+  While every slot is taken, events are counted in "dropped_events" and discarded,
+  and counter adds go to a shared overflow row with an atomic add, so none are lost.
+- The exporter copies a ring, then re-reads its head and discards every event the
+  writer may have overwritten during the copy. The ring fields are relaxed atomics
+  and the writer issues a release fence between reading the head and overwriting a
+  slot, so a copy that saw any part of an overwrite also sees the head that rules it
+  out (the seqlock pattern, correct on weakly ordered CPUs as well as x86).
+- The macros never change errno, so they can sit between a syscall and its
+  errno check (the first one on a thread allocates its ring).
+- trace_shutdown() frees the rings; call it after the other threads have stopped.
+- Compile with -pthread. shm_open needs -lrt on glibc older than 2.34.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef TRACE_MAX_THREADS
+#define TRACE_MAX_THREADS 64
+#endif
+#ifndef TRACE_RING_EVENTS
+#define TRACE_RING_EVENTS 8192           // Per thread; must be a power of two
+#endif
+#define TRACE_MAX_COUNTERS 64
+#define TRACE_COUNTER_NAME_MAX 48
+#define TRACE_THREAD_NAME_MAX 32
+
+#define TRACE_SHM_MAGIC 0x31435254u      // "TRC1"
+#define TRACE_SHM_VERSION 2
+#define TRACE_OVERFLOW_ROW TRACE_MAX_THREADS
+
+// Counter storage, laid out for sharing with another process. Each thread slot owns
+// one row of 'values' (64 counters x 8 bytes = 8 cache lines), and only the thread
+// holding the slot writes it. Threads without a slot share the last row and update it
+// with atomic adds. A counter's total is the sum of its column.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_threads;
+    uint32_t max_counters;
+    int32_t pid;
+    _Atomic uint32_t counter_count;    // Names [0, counter_count) are valid
+    char names[TRACE_MAX_COUNTERS][TRACE_COUNTER_NAME_MAX];
+    _Alignas(64) _Atomic uint64_t values[TRACE_MAX_THREADS + 1][TRACE_MAX_COUNTERS];
+} TraceCounterBlock;
+
+// A read-only mapping of another process's counter block.
+typedef struct {
+    const TraceCounterBlock* block;
+    size_t size;
+} TraceShmView;
+
+// Returns 0, or -1 with errno (ENOENT when no such object, EINVAL when the object is
+// not a counter block of this layout).
+static inline int trace_shm_attach(TraceShmView* view, const char* name) {
+    view->block = NULL;
+    view->size = 0;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return -1;
+    struct stat st;
+    int err = fstat(fd, &st) != 0 ? errno : (size_t)st.st_size < sizeof(TraceCounterBlock) ? EINVAL : 0;
+    if (err) {
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    void* p = mmap(NULL, sizeof(TraceCounterBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    const TraceCounterBlock* block = (const TraceCounterBlock*)p;
+    if (block->magic != TRACE_SHM_MAGIC || block->version != TRACE_SHM_VERSION ||
+        block->max_threads != TRACE_MAX_THREADS || block->max_counters != TRACE_MAX_COUNTERS) {
+        munmap(p, sizeof(TraceCounterBlock));
+        errno = EINVAL;
+        return -1;
+    }
+    view->block = block;
+    view->size = sizeof(TraceCounterBlock);
+    return 0;
+}
+
+// Sum every row, overflow included, into totals[TRACE_MAX_COUNTERS]. Returns the number of
+// registered counters. Each value is read atomically; the set is not a snapshot.
+static inline int trace_counter_block_sum_(const TraceCounterBlock* block, uint64_t* totals) {
+    uint32_t n = atomic_load_explicit((_Atomic uint32_t*)&block->counter_count, memory_order_acquire);
+    if (n > TRACE_MAX_COUNTERS) n = TRACE_MAX_COUNTERS;
+    memset(totals, 0, sizeof(uint64_t) * TRACE_MAX_COUNTERS);
+    for (int t = 0; t <= TRACE_OVERFLOW_ROW; t++) {
+        for (uint32_t c = 0; c < n; c++) {
+            totals[c] += atomic_load_explicit((_Atomic uint64_t*)&block->values[t][c], memory_order_relaxed);
+        }
+    }
+    return (int)n;
+}
+
+static inline int trace_shm_sample(const TraceShmView* view, uint64_t* totals) {
+    return trace_counter_block_sum_(view->block, totals);
+}
+
+static inline const char* trace_shm_counter_name(const TraceShmView* view, int id) {
+    return (unsigned)id < TRACE_MAX_COUNTERS ? view->block->names[id] : "?";
+}
+
+static inline int trace_shm_pid(const TraceShmView* view) {
+    return view->block->pid;
+}
+
+static inline void trace_shm_detach(TraceShmView* view) {
+    if (view->block) munmap((void*)view->block, view->size);
+    view->block = NULL;
+    view->size = 0;
+}
+
+#ifdef TRACE_ENABLE
+
+#include <pthread.h>
+
+#define TRACE_CONCAT2_(a, b) a##b
+#define TRACE_CONCAT_(a, b) TRACE_CONCAT2_(a, b)
+
+// One ring slot. The writer may overwrite a slot while the exporter copies it, so
+// every field is a relaxed atomic: no torn reads, and no data race in the C11 sense.
+typedef struct {
+    _Atomic(const char*) cat;
+    _Atomic(const char*) name;
+    _Atomic uint64_t ts_ns;    // Since the tracer's epoch
+    _Atomic uint64_t arg;      // Duration for 'X', value for 'C'
+    _Atomic uint32_t tid;      // Recording thread; a recycled ring holds several
+    _Atomic char phase;        // Chrome trace phase: 'X' complete, 'i' instant, 'C' counter
+} TraceSlot;
+
+// The exporter's plain copy of a slot
+typedef struct {
+    const char* cat;
+    const char* name;
+    uint64_t ts_ns;
+    uint64_t arg;
+    uint32_t tid;
+    char phase;
+} TraceEvent;
+
+typedef struct {
+    _Atomic uint64_t head;     // Events ever written; the writer's release store publishes
+    uint32_t slot;
+    long tid;                  // Current owner; tid and name change under the lock
+    char name[TRACE_THREAD_NAME_MAX];
+    TraceSlot events[TRACE_RING_EVENTS];
+} TraceThread;
+
+typedef struct {
+    _Atomic int enabled;
+    uint64_t min_ns;
+    uint64_t epoch_ns;
+    _Atomic uint32_t thread_count;      // Slots ever handed out; rings [0, thread_count)
+    _Atomic(TraceThread*) threads[TRACE_MAX_THREADS];
+    uint32_t free_slots[TRACE_MAX_THREADS];    // Released by exited threads
+    uint32_t free_count;
+    pthread_key_t exit_key;             // Its destructor releases the slot
+    int exit_key_created;
+    _Atomic uint64_t dropped_events;    // From threads without a slot
+    atomic_flag lock;                   // Slots, thread names, counter registration, publishing
+    _Atomic(TraceCounterBlock*) counters;
+    TraceCounterBlock* shm_block;
+    char shm_name[64];
+    char export_path[256];
+} TraceState;
+
+static TraceState trace_state_ = {.lock = ATOMIC_FLAG_INIT};
+static TraceCounterBlock trace_local_counters_;
+
+// Per-thread ring, or NULL once the thread was refused a slot (see trace_thread_())
+static _Thread_local TraceThread* trace_tls_;
+static _Thread_local int trace_tls_refused_;
+
+static inline uint64_t trace_clock_ns_(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t trace_now_ns(void) {
+    return trace_clock_ns_() - trace_state_.epoch_ns;
+}
+
+static inline void trace_lock_(void) {
+    while (atomic_flag_test_and_set_explicit(&trace_state_.lock, memory_order_acquire)) {
+    }
+}
+
+static inline void trace_unlock_(void) {
+    atomic_flag_clear_explicit(&trace_state_.lock, memory_order_release);
+}
+
+static inline TraceCounterBlock* trace_counters_(void) {
+    TraceCounterBlock* block = atomic_load_explicit(&trace_state_.counters, memory_order_acquire);
+    if (block == NULL) {
+        // First use: set up the process-local block (trace_init() may not have run yet)
+        trace_lock_();
+        block = atomic_load_explicit(&trace_state_.counters, memory_order_relaxed);
+        if (block == NULL) {
+            block = &trace_local_counters_;
+            block->magic = TRACE_SHM_MAGIC;
+            block->version = TRACE_SHM_VERSION;
+            block->max_threads = TRACE_MAX_THREADS;
+            block->max_counters = TRACE_MAX_COUNTERS;
+            block->pid = (int32_t)getpid();
+            atomic_store_explicit(&trace_state_.counters, block, memory_order_release);
+        }
+        trace_unlock_();
+    }
+    return block;
+}
+
+// pthread key destructor: hand the exiting thread's slot to the next thread. The
+// ring and the counter row stay as they are. Anything the thread records after this
+// (from another destructor) is dropped or goes to the overflow row.
+static void trace_thread_exit_(void* arg) {
+    TraceThread* t = (TraceThread*)arg;
+    trace_tls_ = NULL;
+    trace_tls_refused_ = 1;
+    trace_lock_();
+    trace_state_.free_slots[trace_state_.free_count++] = t->slot;
+    trace_unlock_();
+}
+
+// Claim a ring for the calling thread: a slot released by an exited thread, else a
+// new one. NULL while all TRACE_MAX_THREADS slots are held by live threads or when
+// an allocation failed.
+static inline TraceThread* trace_thread_claim_(void) {
+    TraceThread* t = NULL;
+    trace_lock_();
+    if (!trace_state_.exit_key_created) {
+        trace_state_.exit_key_created = pthread_key_create(&trace_state_.exit_key, trace_thread_exit_) == 0;
+    }
+    uint32_t slot = TRACE_MAX_THREADS;
+    uint32_t count = atomic_load_explicit(&trace_state_.thread_count, memory_order_relaxed);
+    if (trace_state_.free_count > 0) slot = trace_state_.free_slots[--trace_state_.free_count];
+    else if (count < TRACE_MAX_THREADS) slot = count;
+    if (slot < TRACE_MAX_THREADS) {
+        t = atomic_load_explicit(&trace_state_.threads[slot], memory_order_relaxed);
+        if (t == NULL && (t = (TraceThread*)calloc(1, sizeof(TraceThread))) != NULL) {
+            t->slot = slot;
+            atomic_store_explicit(&trace_state_.threads[slot], t, memory_order_release);
+            atomic_store_explicit(&trace_state_.thread_count, count + 1, memory_order_relaxed);
+        }
+    }
+    if (t != NULL && (!trace_state_.exit_key_created || pthread_setspecific(trace_state_.exit_key, t) != 0)) {
+        // No way to hear about the exit: the slot would leak, so give it back now
+        trace_state_.free_slots[trace_state_.free_count++] = slot;
+        t = NULL;
+    }
+    if (t == NULL) {
+        trace_unlock_();
+        trace_tls_refused_ = 1;
+        return NULL;
+    }
+#ifdef __linux__
+    t->tid = (long)syscall(SYS_gettid);
+#else
+    t->tid = (long)t->slot + 1;
+#endif
+    snprintf(t->name, sizeof(t->name), "thread %u", t->slot);
+    trace_unlock_();
+    trace_tls_ = t;
+    return t;
+}
+
+// The calling thread's ring, claimed on first use (NULL if refused)
+static inline TraceThread* trace_thread_(void) {
+    TraceThread* t = trace_tls_;
+    if (t != NULL || trace_tls_refused_) return t;
+    // Hooks sit between a syscall and its errno check; the first one on a thread
+    // calls calloc() and pthread functions, which may overwrite errno
+    int saved_errno = errno;
+    t = trace_thread_claim_();
+    errno = saved_errno;
+    return t;
+}
+
+static inline void trace_emit_(const char* cat, const char* name, char phase, uint64_t ts_ns, uint64_t arg) {
+    TraceThread* t = trace_thread_();
+    if (t == NULL) {
+        atomic_fetch_add_explicit(&trace_state_.dropped_events, 1, memory_order_relaxed);
+        return;
+    }
+    uint64_t h = atomic_load_explicit(&t->head, memory_order_relaxed);
+    // Order the previous head store before the overwrite below: an exporter that sees
+    // any new field also sees head >= h, and so discards the slot's old event.
+    atomic_thread_fence(memory_order_release);
+    TraceSlot* e = &t->events[h & (TRACE_RING_EVENTS - 1)];
+    atomic_store_explicit(&e->cat, cat, memory_order_relaxed);
+    atomic_store_explicit(&e->name, name, memory_order_relaxed);
+    atomic_store_explicit(&e->ts_ns, ts_ns, memory_order_relaxed);
+    atomic_store_explicit(&e->arg, arg, memory_order_relaxed);
+    atomic_store_explicit(&e->tid, (uint32_t)t->tid, memory_order_relaxed);
+    atomic_store_explicit(&e->phase, phase, memory_order_relaxed);
+    atomic_store_explicit(&t->head, h + 1, memory_order_release);
+}
+
+static inline int trace_enabled(void) {
+    return atomic_load_explicit(&trace_state_.enabled, memory_order_relaxed);
+}
+
+// Start or stop recording events. Counters are unaffected.
+static inline void trace_set_enabled(int on) {
+    atomic_store_explicit(&trace_state_.enabled, on != 0, memory_order_relaxed);
+}
+
+// Label the calling thread in the exported trace (truncated to TRACE_THREAD_NAME_MAX - 1).
+static inline void trace_thread_name(const char* name) {
+    TraceThread* t = trace_thread_();
+    if (t == NULL) return;
+    trace_lock_();
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    trace_unlock_();
+}
+
+// ---------------------------------------------------------------------------
+// Zones and events
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* cat;
+    const char* name;
+    uint64_t start_ns;
+    int active;
+} TraceZone;
+
+static inline TraceZone trace_zone_begin_(const char* cat, const char* name) {
+    TraceZone zone = {cat, name, 0, 0};
+    if (trace_enabled()) {
+        zone.start_ns = trace_now_ns();
+        zone.active = 1;
+    }
+    return zone;
+}
+
+static inline void trace_zone_end_(TraceZone* zone) {
+    if (!zone->active) return;
+    uint64_t duration = trace_now_ns() - zone->start_ns;
+    if (duration >= trace_state_.min_ns) trace_emit_(zone->cat, zone->name, 'X', zone->start_ns, duration);
+    zone->active = 0;
+}
+
+static inline void trace_instant_(const char* cat, const char* name) {
+    if (trace_enabled()) trace_emit_(cat, name, 'i', trace_now_ns(), 0);
+}
+
+static inline void trace_value_(const char* cat, const char* name, uint64_t value) {
+    if (trace_enabled()) trace_emit_(cat, name, 'C', trace_now_ns(), value);
+}
+
+#define TRACE_ZONE_BEGIN(var, cat, name) TraceZone var = trace_zone_begin_((cat), (name))
+#define TRACE_ZONE_END(var) trace_zone_end_(&(var))
+#if defined(__GNUC__) || defined(__clang__)
+#define TRACE_SCOPE(cat, name)                                                              \
+    TraceZone TRACE_CONCAT_(trace_scope_, __LINE__) __attribute__((cleanup(trace_zone_end_))) = \
+        trace_zone_begin_((cat), (name))
+#else
+#define TRACE_SCOPE(cat, name) ((void)0)   // Needs the cleanup attribute; use BEGIN/END
+#endif
+#define TRACE_INSTANT(cat, name) trace_instant_((cat), (name))
+#define TRACE_VALUE(cat, name, value) trace_value_((cat), (name), (uint64_t)(value))
+
+// ---------------------------------------------------------------------------
+// Counters
+// ---------------------------------------------------------------------------
+
+// Id of the counter called 'name', registering it on first use. -1 when all
+// TRACE_MAX_COUNTERS are taken. Names longer than TRACE_COUNTER_NAME_MAX - 1 are truncated.
+static inline int trace_counter_id(const char* name) {
+    int saved_errno = errno;   // Runs inside TRACE_COUNTER_ADD, see trace_thread_()
+    TraceCounterBlock* block = trace_counters_();
+    trace_lock_();
+    uint32_t n = atomic_load_explicit(&block->counter_count, memory_order_relaxed);
+    int id = -1;
+    for (uint32_t i = 0; i < n; i++) {
+        if (strncmp(block->names[i], name, TRACE_COUNTER_NAME_MAX - 1) == 0) {
+            id = (int)i;
+            break;
+        }
+    }
+    if (id < 0 && n < TRACE_MAX_COUNTERS) {
+        snprintf(block->names[n], TRACE_COUNTER_NAME_MAX, "%s", name);
+        // The local table always holds every name: events point into it, and it
+        // outlives the shared block (trace_counters_sample(), trace_shutdown())
+        if (block != &trace_local_counters_) {
+            snprintf(trace_local_counters_.names[n], TRACE_COUNTER_NAME_MAX, "%s", name);
+        }
+        atomic_store_explicit(&block->counter_count, n + 1, memory_order_release);
+        id = (int)n;
+    }
+    trace_unlock_();
+    errno = saved_errno;
+    return id;
+}
+
+static inline void trace_counter_add(int id, uint64_t delta) {
+    if ((unsigned)id >= TRACE_MAX_COUNTERS) return;
+    TraceThread* t = trace_thread_();
+    if (t == NULL) {
+        // No slot: the overflow row is shared, so this one needs the atomic add
+        atomic_fetch_add_explicit(&trace_counters_()->values[TRACE_OVERFLOW_ROW][id], delta, memory_order_relaxed);
+        return;
+    }
+    _Atomic uint64_t* cell = &trace_counters_()->values[t->slot][id];
+    // Single writer per row: a plain load and store, no locked read-modify-write
+    atomic_store_explicit(cell, atomic_load_explicit(cell, memory_order_relaxed) + delta, memory_order_relaxed);
+}
+
+// Sum of every thread's contributions to counter 'id'
+static inline uint64_t trace_counter_total(int id) {
+    uint64_t totals[TRACE_MAX_COUNTERS];
+    int n = trace_counter_block_sum_(trace_counters_(), totals);
+    return id >= 0 && id < n ? totals[id] : 0;
+}
+
+// Record the current total of every counter as a 'C' event on the calling thread,
+// so counters show up as tracks on the timeline.
+static inline void trace_counters_sample(void) {
+    if (!trace_enabled()) return;
+    TraceCounterBlock* block = trace_counters_();
+    uint64_t totals[TRACE_MAX_COUNTERS];
+    int n = trace_counter_block_sum_(block, totals);
+    uint64_t now = trace_now_ns();
+    for (int i = 0; i < n; i++) trace_emit_("counters", trace_local_counters_.names[i], 'C', now, totals[i]);
+}
+
+// The id lookup happens once per call site; 'name' must be the same at every call.
+#define TRACE_COUNTER_ADD(name, delta)                                                      \
+    do {                                                                                    \
+        static _Atomic int trace_counter_id_ = -1;                                          \
+        int trace_id_ = atomic_load_explicit(&trace_counter_id_, memory_order_relaxed);     \
+        if (trace_id_ < 0) {                                                                \
+            trace_id_ = trace_counter_id(name);                                             \
+            atomic_store_explicit(&trace_counter_id_, trace_id_, memory_order_relaxed);     \
+        }                                                                                   \
+        trace_counter_add(trace_id_, (uint64_t)(delta));                                    \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+// Shared memory
+// ---------------------------------------------------------------------------
+
+// Move the counters into a new POSIX shared memory object 'name' ("/something"), or
+// "/itsc-trace-<pid>" when name is NULL. Returns 0, or -1 with errno (EEXIST when
+// 'name' already exists; a stale "/itsc-trace-<pid>" is replaced). Call it at
+// startup: an increment that races with the switch may land in the old block.
+static inline int trace_shm_publish(const char* name) {
+    TraceCounterBlock* local = trace_counters_();
+    trace_lock_();
+    if (trace_state_.shm_block != NULL) {
+        trace_unlock_();
+        return 0;
+    }
+    if (name) snprintf(trace_state_.shm_name, sizeof(trace_state_.shm_name), "%s", name);
+    else snprintf(trace_state_.shm_name, sizeof(trace_state_.shm_name), "/itsc-trace-%ld", (long)getpid());
+
+    // Never take over a live object: another process may be publishing into it
+    int fd = shm_open(trace_state_.shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST && name == NULL) {
+        // Our pid is in the name, so the owner is gone; its object was left behind
+        shm_unlink(trace_state_.shm_name);
+        fd = shm_open(trace_state_.shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (fd < 0) {
+        int err = errno;
+        trace_state_.shm_name[0] = '\0';
+        trace_unlock_();
+        errno = err;
+        return -1;
+    }
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, (off_t)sizeof(TraceCounterBlock)) == 0) {
+        p = mmap(NULL, sizeof(TraceCounterBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int err = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(trace_state_.shm_name);
+        trace_state_.shm_name[0] = '\0';
+        trace_unlock_();
+        errno = err;
+        return -1;
+    }
+
+    TraceCounterBlock* shared = (TraceCounterBlock*)p;
+    memcpy(shared, local, sizeof(TraceCounterBlock));
+    trace_state_.shm_block = shared;
+    atomic_store_explicit(&trace_state_.counters, shared, memory_order_release);
+    trace_unlock_();
+    return 0;
+}
+
+// Name of the published object, or "" before trace_shm_publish()
+static inline const char* trace_shm_name(void) {
+    return trace_state_.shm_name;
+}
+
+// ---------------------------------------------------------------------------
+// Chrome trace export
+// ---------------------------------------------------------------------------
+
+static inline void trace_json_string_(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+// Copy the valid part of one ring into 'copy'. Returns the number of events; they
+// start at copy[*offset] and the first one is event number *first of the thread.
+static inline uint64_t trace_snapshot_ring_(TraceThread* t, TraceEvent* copy, uint64_t* offset, uint64_t* first) {
+    uint64_t head = atomic_load_explicit(&t->head, memory_order_acquire);
+    uint64_t begin = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+    for (uint64_t i = begin; i < head; i++) {
+        TraceSlot* e = &t->events[i & (TRACE_RING_EVENTS - 1)];
+        TraceEvent* c = &copy[i - begin];
+        c->cat = atomic_load_explicit(&e->cat, memory_order_relaxed);
+        c->name = atomic_load_explicit(&e->name, memory_order_relaxed);
+        c->ts_ns = atomic_load_explicit(&e->ts_ns, memory_order_relaxed);
+        c->arg = atomic_load_explicit(&e->arg, memory_order_relaxed);
+        c->tid = atomic_load_explicit(&e->tid, memory_order_relaxed);
+        c->phase = atomic_load_explicit(&e->phase, memory_order_relaxed);
+    }
+    // Pairs with the writer's release fence: if a load above saw an overwrite, the
+    // head read below covers it
+    atomic_thread_fence(memory_order_acquire);
+    // While the head reads 'now', the writer may be filling the slot of event
+    // now - TRACE_RING_EVENTS, so everything up to and including it is suspect.
+    uint64_t now = atomic_load_explicit(&t->head, memory_order_relaxed);
+    uint64_t safe = now >= TRACE_RING_EVENTS ? now - TRACE_RING_EVENTS + 1 : 0;
+    *first = safe > begin ? safe : begin;
+    *offset = *first - begin;
+    return head > *first ? head - *first : 0;
+}
+
+// Write every thread's ring as Chrome trace JSON. Returns the number of events
+// written, or -1 with errno.
+static inline long trace_export_chrome(FILE* out) {
+    TraceEvent* copy = (TraceEvent*)malloc(sizeof(TraceEvent) * TRACE_RING_EVENTS);
+    if (copy == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    long pid = (long)getpid();
+    uint64_t overwritten = 0;
+    long written = 0;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%ld,\"tid\":0,\"args\":{\"name\":\"pid %ld\"}}",
+            pid, pid);
+    uint32_t threads = atomic_load_explicit(&trace_state_.thread_count, memory_order_relaxed);
+    if (threads > TRACE_MAX_THREADS) threads = TRACE_MAX_THREADS;
+    for (uint32_t s = 0; s < threads; s++) {
+        TraceThread* t = atomic_load_explicit(&trace_state_.threads[s], memory_order_acquire);
+        if (t == NULL) continue;   // Slot claimed, ring not published yet
+        char name[TRACE_THREAD_NAME_MAX];
+        trace_lock_();
+        long tid = t->tid;
+        memcpy(name, t->name, sizeof(name));
+        trace_unlock_();
+        fprintf(out, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":", pid,
+                tid);
+        trace_json_string_(out, name);
+        fprintf(out, "}}");
+
+        uint64_t offset, first;
+        uint64_t n = trace_snapshot_ring_(t, copy, &offset, &first);
+        overwritten += first;
+        for (uint64_t i = 0; i < n; i++) {
+            const TraceEvent* e = &copy[offset + i];
+            fprintf(out, ",\n{\"ph\":\"%c\",\"cat\":", e->phase);
+            trace_json_string_(out, e->cat);
+            fprintf(out, ",\"name\":");
+            trace_json_string_(out, e->name);
+            fprintf(out, ",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f", pid, (long)e->tid, e->ts_ns / 1000.0);
+            if (e->phase == 'X') fprintf(out, ",\"dur\":%.3f", e->arg / 1000.0);
+            else if (e->phase == 'C') fprintf(out, ",\"args\":{\"value\":%llu}", (unsigned long long)e->arg);
+            else fprintf(out, ",\"s\":\"t\"");
+            fprintf(out, "}");
+            written++;
+        }
+    }
+    uint64_t dropped = atomic_load_explicit(&trace_state_.dropped_events, memory_order_relaxed);
+    fprintf(out, "\n],\"otherData\":{\"overwritten_events\":%llu,\"dropped_events\":%llu}}\n",
+            (unsigned long long)overwritten, (unsigned long long)dropped);
+    free(copy);
+    if (ferror(out)) {
+        errno = EIO;
+        return -1;
+    }
+    return written;
+}
+
+static inline long trace_export_chrome_file(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) return -1;
+    long n = trace_export_chrome(out);
+    int err = errno;
+    if (fclose(out) != 0 && n >= 0) return -1;
+    errno = err;
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Lifetime
+// ---------------------------------------------------------------------------
+
+// Enable recording and apply the environment:
+//     TRACE_FILE=path    trace_shutdown() exports the rings to path
+//     TRACE_SHM=name     publish the counters (name "1" picks /itsc-trace-<pid>)
+//     TRACE_MIN_NS=n     drop zones shorter than n ns
+// Returns 0, or -1 with errno if publishing the counters failed (tracing still runs).
+static inline int trace_init(void) {
+    trace_counters_();
+    if (trace_state_.epoch_ns == 0) trace_state_.epoch_ns = trace_clock_ns_();
+    const char* env = getenv("TRACE_MIN_NS");
+    if (env) trace_state_.min_ns = strtoull(env, NULL, 10);
+    env = getenv("TRACE_FILE");
+    if (env) snprintf(trace_state_.export_path, sizeof(trace_state_.export_path), "%s", env);
+    trace_set_enabled(1);
+    env = getenv("TRACE_SHM");
+    if (env && *env) return trace_shm_publish(strcmp(env, "1") == 0 ? NULL : env);
+    return 0;
+}
+
+// Export to $TRACE_FILE if set, free the rings and unlink the shared memory object.
+// Other threads must have stopped recording.
+static inline void trace_shutdown(void) {
+    trace_set_enabled(0);
+    if (trace_state_.export_path[0]) trace_export_chrome_file(trace_state_.export_path);
+    uint32_t threads = atomic_load_explicit(&trace_state_.thread_count, memory_order_relaxed);
+    if (threads > TRACE_MAX_THREADS) threads = TRACE_MAX_THREADS;
+    for (uint32_t s = 0; s < threads; s++) {
+        free(atomic_load_explicit(&trace_state_.threads[s], memory_order_relaxed));
+        atomic_store_explicit(&trace_state_.threads[s], NULL, memory_order_relaxed);
+    }
+    atomic_store_explicit(&trace_state_.thread_count, 0, memory_order_relaxed);
+    trace_state_.free_count = 0;
+    if (trace_state_.exit_key_created) {
+        pthread_key_delete(trace_state_.exit_key);   // Runs no destructors
+        trace_state_.exit_key_created = 0;
+    }
+    trace_tls_ = NULL;
+    trace_tls_refused_ = 0;
+    if (trace_state_.shm_block) {
+        memcpy(&trace_local_counters_, trace_state_.shm_block, sizeof(TraceCounterBlock));
+        atomic_store_explicit(&trace_state_.counters, &trace_local_counters_, memory_order_release);
+        munmap(trace_state_.shm_block, sizeof(TraceCounterBlock));
+        shm_unlink(trace_state_.shm_name);
+        trace_state_.shm_block = NULL;
+        trace_state_.shm_name[0] = '\0';
+    }
+}
+
+#else // !TRACE_ENABLE
+
+// Tracing compiled out: the macros generate no code and the functions below do
+// nothing, so callers need no #ifdefs.
+#define TRACE_ZONE_BEGIN(var, cat, name) ((void)0)
+#define TRACE_ZONE_END(var) ((void)0)
+#define TRACE_SCOPE(cat, name) ((void)0)
+#define TRACE_INSTANT(cat, name) ((void)0)
+#define TRACE_VALUE(cat, name, value) ((void)0)
+#define TRACE_COUNTER_ADD(name, delta) ((void)0)
+
+static inline int trace_init(void) { return 0; }
+static inline void trace_shutdown(void) {}
+static inline int trace_enabled(void) { return 0; }
+static inline void trace_set_enabled(int on) { (void)on; }
+static inline void trace_thread_name(const char* name) { (void)name; }
+static inline void trace_counters_sample(void) {}
+static inline uint64_t trace_now_ns(void) { return 0; }
+static inline int trace_counter_id(const char* name) {
+    (void)name;
+    return -1;
+}
+static inline void trace_counter_add(int id, uint64_t delta) {
+    (void)id;
+    (void)delta;
+}
+static inline uint64_t trace_counter_total(int id) {
+    (void)id;
+    return 0;
+}
+static inline const char* trace_shm_name(void) { return ""; }
+
+static inline int trace_shm_publish(const char* name) {
+    (void)name;
+    errno = ENOSYS;
+    return -1;
+}
+
+static inline long trace_export_chrome(FILE* out) {
+    (void)out;
+    errno = ENOSYS;
+    return -1;
+}
+
+static inline long trace_export_chrome_file(const char* path) {
+    (void)path;
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif // TRACE_ENABLE
+
+#endif // TRACE_H
@@ -49,7 +49,9 @@ Comparison to other languages:
 #include <limits.h>
 #include <stdint.h>
 #include <inttypes.h>
-#include <time.h>
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+#include "../Chapter16MultithreadingAndConcurrency/thread_pool.h"
+#include "../Chapter2OperatorsAndExpressions/checked_arith.h"
 
 // Function prototypes
 void basic_type_modifiers();
@@ -122,7 +124,13 @@ void unsigned_overflow_behavior() {
 
     int i = -1;
     unsigned int ui2 = i;
-    printf("Casting -1 to unsigned int: %u\n\n", ui2);  // Becomes UINT_MAX
+    printf("Casting -1 to unsigned int: %u\n", ui2);  // Becomes UINT_MAX
+
+    // When wrapping would be a bug, check instead (see checked_arith.h)
+    uint32_t sum;
+    int wrapped = checked_add_u32(UINT32_MAX, 1, &sum);
+    printf("checked_add_u32(UINT32_MAX, 1): overflow %s, result %u\n", wrapped ? "reported" : "not reported", sum);
+    printf("sat_add_i32(INT32_MAX, 1): %d\n\n", (int)sat_add_i32(INT32_MAX, 1));
 }
 
 void long_long_and_size_t() {
@@ -187,23 +195,97 @@ unsigned long long sum_to_n(unsigned long long n) {
     return sum;
 }
 
-void performance_comparison() {
-    printf("2.7 Performance Comparison\n");
-    printf("---------------------------\n");
-
-    clock_t start, end;
-    double cpu_time_used;
+// The same sum over one chunk [begin, end) of the indices 0..n-1, for parallel_sum_u64()
+uint64_t sum_range_chunk(void* ctx, size_t begin, size_t end) {
+    (void)ctx;
+    BENCH_HIDE_VALUE(end);  // Keep the loop; see sum_to_n_run()
+    unsigned long long sum = 0;
+    for (unsigned long long i = begin + 1; i <= end; ++i) {
+        sum += i;
+    }
+    return sum;
+}
 
-    unsigned long long n = 1000000000ULL;
+typedef struct {
+    unsigned long long n;
+    unsigned long long result;
+    ThreadPool* pool;
+} SumBench;
 
-    start = clock();
+void sum_to_n_run(void* ctx) {
+    SumBench* bench = (SumBench*)ctx;
+    unsigned long long n = bench->n;
+    BENCH_HIDE_VALUE(n);  // Stop the compiler folding the loop into n*(n+1)/2
     unsigned long long result = sum_to_n(n);
-    end = clock();
+    BENCH_DO_NOT_OPTIMIZE(result);
+    bench->result = result;
+}
 
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+void sum_to_n_parallel_run(void* ctx) {
+    SumBench* bench = (SumBench*)ctx;
+    unsigned long long result = parallel_sum_u64(bench->pool, 0, bench->n, 0, sum_range_chunk, NULL);
+    BENCH_DO_NOT_OPTIMIZE(result);
+    bench->result = result;
+}
 
-    printf("Sum of numbers from 1 to %llu: %llu\n", n, result);
-    printf("Time taken: %f seconds\n\n", cpu_time_used);
+// Strong scaling: the same n summed by 1, 2, 4, ... threads. The speedup column
+// is relative to one thread; efficiency = speedup / threads.
+void sum_to_n_scaling(unsigned long long n) {
+    static char names[16][32];
+    unsigned steps[16];
+    unsigned count = thread_pool_scaling_steps(thread_pool_cpu_count(), steps, 16);
+    SumBench bench = {n, 0, NULL};
+    BenchSuite suite;
+
+    bench_suite_init(&suite, "sum_to_n strong scaling (parallel_sum_u64)");
+    for (unsigned s = 0; s < count; s++) {
+        ThreadPool pool;
+        if (thread_pool_init(&pool, steps[s]) != 0) {
+            fprintf(stderr, "Thread pool creation failed\n");
+            break;
+        }
+        snprintf(names[s], sizeof(names[s]), "%u thread%s", steps[s], steps[s] == 1 ? "" : "s");
+        bench.pool = &pool;
+        bench_suite_run(&suite, names[s], sum_to_n_parallel_run, &bench, n);
+        thread_pool_destroy(&pool);
+    }
+    bench_suite_report(&suite);
+
+    for (int i = 1; i < suite.count; i++) {
+        double speedup = suite.results[0].median_ns / suite.results[i].median_ns;
+        printf("  %-12s efficiency %5.1f%%\n", suite.results[i].name, 100.0 * speedup / steps[i]);
+    }
+    printf("\n");
+}
+
+void performance_comparison() {
+    printf("2.7 Performance Comparison\n");
+    printf("---------------------------\n");
+
+    ThreadPool pool;
+    if (thread_pool_init(&pool, 0) != 0) {
+        fprintf(stderr, "Thread pool creation failed\n");
+        return;
+    }
+    SumBench bench = {10000000ULL, 0, &pool};
+    BenchSuite suite;
+    static char parallel_name[48];
+    snprintf(parallel_name, sizeof(parallel_name), "parallel_sum_u64 (%u thread%s)",
+             thread_pool_size(&pool), thread_pool_size(&pool) == 1 ? "" : "s");
+
+    bench_suite_init(&suite, "unsigned long long summation");
+    bench_suite_run(&suite, "sum_to_n", sum_to_n_run, &bench, bench.n);
+    unsigned long long serial = bench.result;
+    bench_suite_run(&suite, parallel_name, sum_to_n_parallel_run, &bench, bench.n);
+    bench_suite_report(&suite);
+    thread_pool_destroy(&pool);
+
+    if (bench.result != serial) {
+        fprintf(stderr, "parallel sum mismatch: %llu vs %llu\n", bench.result, serial);
+    }
+    printf("Sum of numbers from 1 to %llu: %llu\n\n", bench.n, bench.result);
+
+    sum_to_n_scaling(bench.n);
 }
 
 /*
@@ -340,6 +422,15 @@ Performance Trade-offs:
 - Balance between using smaller types for memory efficiency and larger types for performance.
 - Consider the cost of overflow checking vs. the risk of uncaught overflows.
 
+Parallel Loops:
+- A loop like sum_to_n() only uses one core. parallel_sum_u64() from
+  Chapter16MultithreadingAndConcurrency/thread_pool.h splits the range over a
+  work-stealing pool and gives each thread its own cache-line-padded partial sum.
+- The strong-scaling table in 2.7 is capped to the CPUs this process may run on
+  (taskset/cgroup limits included); efficiency below ~80% usually means the
+  chunks are too small or the loop is memory-bound.
+- Build with -pthread: gcc -O2 -pthread TypeModifiers.c -o type_modifiers
+
 9. How to Contribute
 ====================
 To contribute to this cheat sheet:
@@ -0,0 +1,601 @@
+/*
+convert.h - Bulk Numeric Conversions with Rounding Modes and Saturation
+================================================
+
+A C cast from float to int truncates, and it is undefined behaviour when the
+value does not fit (on x86 it silently yields INT_MIN). Converting sensor
+samples one cast at a time also leaves the SIMD conversion instructions
+unused. This header converts whole arrays:
+
+    convert_f32_to_i32(src, dst, n, CONVERT_NEAREST)    float -> int32_t
+    convert_i32_to_f32(src, dst, n)                     int32_t -> float
+    convert_f64_to_f32(src, dst, n)                     double -> float
+    convert_f32_to_f64(src, dst, n)                     float -> double
+    convert_f64_to_i64(src, dst, n, CONVERT_FLOOR)      double -> int64_t
+    convert_i64_to_f64(src, dst, n)                     int64_t -> double
+    convert_f32_to_q16(src, dst, n, mode)               float -> Q16.16 (int32_t)
+    convert_q16_to_f32(src, dst, n)                     Q16.16 -> float
+    convert_f64_to_q32(src, dst, n, mode)               double -> Q32.32 (int64_t)
+    convert_q32_to_f64(src, dst, n)                     Q32.32 -> double
+    convert_i32_to_q16(src, dst, n)                     int32_t -> Q16.16
+    convert_q16_to_i32(src, dst, n, mode)               Q16.16 -> int32_t
+
+Single values use the same rules: convert_f32_to_i32_one(x, mode), ...
+
+Design:
+- Rounding modes: CONVERT_TRUNCATE (toward zero, like a cast),
+  CONVERT_NEAREST (ties to even), CONVERT_FLOOR and CONVERT_CEIL.
+- Every conversion to an integer or fixed-point type saturates: values above
+  the range give the maximum, values below give the minimum, NaN gives 0.
+  Conversions between floating types follow IEEE rules, as a cast does
+  (nearest, overflow to infinity, NaN preserved).
+- Q16.16 is value * 2^16 in an int32_t (range about +-32768, step 1/65536);
+  Q32.32 is value * 2^32 in an int64_t. Scaling by a power of two is exact,
+  so a float -> Q16.16 conversion rounds exactly once.
+- Kernels exist in three variants, chosen at startup as in string_simd.h
+  (CONVERT_SIMD_VARIANT=<name> forces one): scalar; sse2 (cvttps2dq,
+  cvtps2dq, packssdw; 4 floats per step); and avx2 (vroundps + vcvttps2dq,
+  8 floats per step). The SIMD loops finish with the scalar kernel.
+- cvttps2dq returns 0x80000000 for NaN and out-of-range lanes; three compare
+  masks turn that into the saturated results.
+- sse2 rounds CONVERT_NEAREST with cvtps2dq, which follows the MXCSR
+  rounding mode, nearest-even unless fesetround() changed it. The scalar and
+  avx2 kernels round to nearest-even explicitly.
+- x86 has no packed double <-> int64 instructions before AVX-512. avx2 converts
+  doubles to int64 by adding 1.5 * 2^52 to the rounded value and reading the
+  bits. That is exact when |value| < 2^51; a group of four outside that range
+  falls back to scalar. int64 -> double splits each value into 16-bit and
+  48-bit halves and rounds once. sse2 runs the 64-bit conversions in scalar.
+*/
+
+#ifndef CONVERT_H
+#define CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CONVERT_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef enum {
+    CONVERT_TRUNCATE,
+    CONVERT_NEAREST,
+    CONVERT_FLOOR,
+    CONVERT_CEIL,
+} ConvertRounding;
+
+typedef enum {
+    CONVERT_SCALAR,
+    CONVERT_SSE2,
+    CONVERT_AVX2,
+    CONVERT_VARIANT_COUNT
+} ConvertVariant;
+
+// 'scale' multiplies before (to integer) or after (from integer) the conversion:
+// 1 for plain values, 2^16 or 2^-16 for Q16.16, 2^32 or 2^-32 for Q32.32.
+typedef struct {
+    const char* name;
+    void (*f32_to_i32)(const float* src, int32_t* dst, size_t n, float scale, ConvertRounding mode);
+    void (*i32_to_f32)(const int32_t* src, float* dst, size_t n, float scale);
+    void (*f64_to_f32)(const double* src, float* dst, size_t n);
+    void (*f32_to_f64)(const float* src, double* dst, size_t n);
+    void (*f64_to_i64)(const double* src, int64_t* dst, size_t n, double scale, ConvertRounding mode);
+    void (*i64_to_f64)(const int64_t* src, double* dst, size_t n, double scale);
+    void (*i32_to_q16)(const int32_t* src, int32_t* dst, size_t n);
+    void (*q16_to_i32)(const int32_t* src, int32_t* dst, size_t n, ConvertRounding mode);
+} ConvertKernels;
+
+#define CONVERT_Q16_ONE 65536.0f
+#define CONVERT_Q32_ONE 4294967296.0
+
+// ---------------------------------------------------------------------------
+// Single values
+// ---------------------------------------------------------------------------
+
+static inline int32_t convert_f32_to_i32_one(float x, ConvertRounding mode) {
+    if (x != x) return 0;
+    if (x >= 2147483648.0f) return INT32_MAX;
+    if (x < -2147483648.0f) return INT32_MIN;
+    int32_t t = (int32_t)x;
+    float f = (float)t;  // Exact: below 2^24 t fits a float, above it x was an integer
+    switch (mode) {
+        case CONVERT_FLOOR: return t - (f > x);
+        case CONVERT_CEIL: return t + (f < x);
+        case CONVERT_NEAREST: {
+            // Exact (Sterbenz), in (-1, 1) with the sign of x. Branch-free, as
+            // the fraction of real data is random.
+            float frac = x - f;
+            int odd = t & 1;
+            return t + ((frac > 0.5f) | ((frac == 0.5f) & odd)) - ((frac < -0.5f) | ((frac == -0.5f) & odd));
+        }
+        default: return t;
+    }
+}
+
+static inline int64_t convert_f64_to_i64_one(double x, ConvertRounding mode) {
+    if (x != x) return 0;
+    if (x >= 9223372036854775808.0) return INT64_MAX;
+    if (x < -9223372036854775808.0) return INT64_MIN;
+    int64_t t = (int64_t)x;
+    double f = (double)t;
+    switch (mode) {
+        case CONVERT_FLOOR: return t - (f > x);
+        case CONVERT_CEIL: return t + (f < x);
+        case CONVERT_NEAREST: {
+            double frac = x - f;
+            int odd = (int)(t & 1);
+            return t + ((frac > 0.5) | ((frac == 0.5) & odd)) - ((frac < -0.5) | ((frac == -0.5) & odd));
+        }
+        default: return t;
+    }
+}
+
+static inline int32_t convert_i32_to_q16_one(int32_t x) {
+    if (x > INT16_MAX) return INT32_MAX & ~0xFFFF;
+    if (x < INT16_MIN) return INT32_MIN;
+    return (int32_t)((uint32_t)x << 16);
+}
+
+static inline int32_t convert_q16_to_i32_one(int32_t q, ConvertRounding mode) {
+    int32_t whole = q >> 16;  // Arithmetic shift: floor
+    int32_t frac = q & 0xFFFF;
+    switch (mode) {
+        case CONVERT_CEIL: return whole + (frac != 0);
+        case CONVERT_TRUNCATE: return whole + (q < 0 && frac != 0);
+        case CONVERT_NEAREST: return whole + (frac > 0x8000 || (frac == 0x8000 && (whole & 1)));
+        default: return whole;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels
+// ---------------------------------------------------------------------------
+
+// A constant mode per loop lets the compiler drop the switch from the loop body
+#define CONVERT_SCALAR_LOOP_(ONE, MODE) \
+    for (size_t i = 0; i < n; i++) dst[i] = ONE(src[i] * scale, MODE)
+
+#define CONVERT_SCALAR_MODES_(ONE)                                             \
+    switch (mode) {                                                            \
+        case CONVERT_NEAREST: CONVERT_SCALAR_LOOP_(ONE, CONVERT_NEAREST); break; \
+        case CONVERT_FLOOR: CONVERT_SCALAR_LOOP_(ONE, CONVERT_FLOOR); break;     \
+        case CONVERT_CEIL: CONVERT_SCALAR_LOOP_(ONE, CONVERT_CEIL); break;       \
+        default: CONVERT_SCALAR_LOOP_(ONE, CONVERT_TRUNCATE); break;             \
+    }
+
+static void convert_scalar_f32_to_i32_(const float* src, int32_t* dst, size_t n, float scale, ConvertRounding mode) {
+    CONVERT_SCALAR_MODES_(convert_f32_to_i32_one)
+}
+
+static void convert_scalar_i32_to_f32_(const int32_t* src, float* dst, size_t n, float scale) {
+    for (size_t i = 0; i < n; i++) dst[i] = (float)src[i] * scale;
+}
+
+static void convert_scalar_f64_to_f32_(const double* src, float* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (float)src[i];
+}
+
+static void convert_scalar_f32_to_f64_(const float* src, double* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (double)src[i];
+}
+
+static void convert_scalar_f64_to_i64_(const double* src, int64_t* dst, size_t n, double scale, ConvertRounding mode) {
+    CONVERT_SCALAR_MODES_(convert_f64_to_i64_one)
+}
+
+static void convert_scalar_i64_to_f64_(const int64_t* src, double* dst, size_t n, double scale) {
+    for (size_t i = 0; i < n; i++) dst[i] = (double)src[i] * scale;
+}
+
+static void convert_scalar_i32_to_q16_(const int32_t* src, int32_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = convert_i32_to_q16_one(src[i]);
+}
+
+static void convert_scalar_q16_to_i32_(const int32_t* src, int32_t* dst, size_t n, ConvertRounding mode) {
+    for (size_t i = 0; i < n; i++) dst[i] = convert_q16_to_i32_one(src[i], mode);
+}
+
+// ---------------------------------------------------------------------------
+// x86 variants
+// ---------------------------------------------------------------------------
+
+#ifdef CONVERT_HAVE_X86
+
+#define CONVERT_TARGET_SSE2_ __attribute__((target("sse2")))
+#define CONVERT_TARGET_AVX2_ __attribute__((target("avx2")))
+
+// ----- SSE2 -----
+
+// Replace the 0x80000000 that cvt(t)ps2dq gives for NaN and out-of-range lanes
+static inline CONVERT_TARGET_SSE2_ __m128i convert_sse2_saturate_(__m128 x, __m128i r) {
+    __m128 hi = _mm_cmpge_ps(x, _mm_set1_ps(2147483648.0f));
+    __m128 lo = _mm_cmplt_ps(x, _mm_set1_ps(-2147483648.0f));
+    __m128 special = _mm_or_ps(_mm_or_ps(hi, lo), _mm_cmpunord_ps(x, x));
+    r = _mm_andnot_si128(_mm_castps_si128(special), r);
+    r = _mm_or_si128(r, _mm_and_si128(_mm_castps_si128(hi), _mm_set1_epi32(INT32_MAX)));
+    return _mm_or_si128(r, _mm_and_si128(_mm_castps_si128(lo), _mm_set1_epi32(INT32_MIN)));
+}
+
+static inline CONVERT_TARGET_SSE2_ __m128i convert_sse2_round_(__m128 x, ConvertRounding mode) {
+    if (mode == CONVERT_NEAREST) return _mm_cvtps_epi32(x);
+    __m128i t = _mm_cvttps_epi32(x);
+    if (mode == CONVERT_TRUNCATE) return t;
+    __m128 f = _mm_cvtepi32_ps(t);
+    // A true compare is -1: adding it floors, subtracting it ceils
+    if (mode == CONVERT_FLOOR) return _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(f, x)));
+    return _mm_sub_epi32(t, _mm_castps_si128(_mm_cmplt_ps(f, x)));
+}
+
+static CONVERT_TARGET_SSE2_ void convert_sse2_f32_to_i32_(const float* src, int32_t* dst, size_t n, float scale,
+                                                          ConvertRounding mode) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), s);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), s);
+        _mm_storeu_si128((__m128i*)(dst + i), convert_sse2_saturate_(a, convert_sse2_round_(a, mode)));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), convert_sse2_saturate_(b, convert_sse2_round_(b, mode)));
+    }
+    convert_scalar_f32_to_i32_(src + i, dst + i, n - i, scale, mode);
+}
+
+static CONVERT_TARGET_SSE2_ void convert_sse2_i32_to_f32_(const int32_t* src, float* dst, size_t n, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 f = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(f, s));
+    }
+    convert_scalar_i32_to_f32_(src + i, dst + i, n - i, scale);
+}
+
+static CONVERT_TARGET_SSE2_ void convert_sse2_f64_to_f32_(const double* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+    convert_scalar_f64_to_f32_(src + i, dst + i, n - i);
+}
+
+static CONVERT_TARGET_SSE2_ void convert_sse2_f32_to_f64_(const float* src, double* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 f = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(f));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+    }
+    convert_scalar_f32_to_f64_(src + i, dst + i, n - i);
+}
+
+// packssdw clamps to int16; interleaving zeros below each value shifts it left by 16
+static CONVERT_TARGET_SSE2_ void convert_sse2_i32_to_q16_(const int32_t* src, int32_t* dst, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i p = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(src + i)),
+                                    _mm_loadu_si128((const __m128i*)(src + i + 4)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(zero, p));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(zero, p));
+    }
+    convert_scalar_i32_to_q16_(src + i, dst + i, n - i);
+}
+
+static inline CONVERT_TARGET_SSE2_ __m128i convert_sse2_q16_round_(__m128i q, ConvertRounding mode) {
+    __m128i whole = _mm_srai_epi32(q, 16);
+    __m128i frac = _mm_and_si128(q, _mm_set1_epi32(0xFFFF));
+    __m128i up;  // -1 in lanes that round up from the floor
+    switch (mode) {
+        case CONVERT_CEIL: up = _mm_cmpgt_epi32(frac, _mm_setzero_si128()); break;
+        case CONVERT_TRUNCATE:
+            up = _mm_and_si128(_mm_cmpgt_epi32(frac, _mm_setzero_si128()), _mm_cmplt_epi32(q, _mm_setzero_si128()));
+            break;
+        case CONVERT_NEAREST: {
+            __m128i half = _mm_set1_epi32(0x8000);
+            __m128i odd = _mm_slli_epi32(whole, 31);  // Sign bit set when odd
+            __m128i tie = _mm_and_si128(_mm_cmpeq_epi32(frac, half), _mm_srai_epi32(odd, 31));
+            up = _mm_or_si128(_mm_cmpgt_epi32(frac, half), tie);
+            break;
+        }
+        default: return whole;
+    }
+    return _mm_sub_epi32(whole, up);
+}
+
+static CONVERT_TARGET_SSE2_ void convert_sse2_q16_to_i32_(const int32_t* src, int32_t* dst, size_t n,
+                                                          ConvertRounding mode) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i q = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), convert_sse2_q16_round_(q, mode));
+    }
+    convert_scalar_q16_to_i32_(src + i, dst + i, n - i, mode);
+}
+
+// ----- AVX2 -----
+
+static inline CONVERT_TARGET_AVX2_ __m256i convert_avx2_saturate_(__m256 x, __m256i r) {
+    __m256 hi = _mm256_cmp_ps(x, _mm256_set1_ps(2147483648.0f), _CMP_GE_OQ);
+    __m256 lo = _mm256_cmp_ps(x, _mm256_set1_ps(-2147483648.0f), _CMP_LT_OQ);
+    __m256 special = _mm256_or_ps(_mm256_or_ps(hi, lo), _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    r = _mm256_andnot_si256(_mm256_castps_si256(special), r);
+    r = _mm256_or_si256(r, _mm256_and_si256(_mm256_castps_si256(hi), _mm256_set1_epi32(INT32_MAX)));
+    return _mm256_or_si256(r, _mm256_and_si256(_mm256_castps_si256(lo), _mm256_set1_epi32(INT32_MIN)));
+}
+
+// vroundps needs its mode as an immediate, so each mode gets its own loop
+#define CONVERT_AVX2_F32_LOOP_(ROUND)                                                                  \
+    for (; i + 16 <= n; i += 16) {                                                                     \
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), s);                                         \
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), s);                                     \
+        _mm256_storeu_si256((__m256i*)(dst + i), convert_avx2_saturate_(a, _mm256_cvttps_epi32(ROUND(a)))); \
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), convert_avx2_saturate_(b, _mm256_cvttps_epi32(ROUND(b)))); \
+    }
+
+#define CONVERT_AVX2_NEAREST_PS_(x) _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define CONVERT_AVX2_FLOOR_PS_(x) _mm256_round_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)
+#define CONVERT_AVX2_CEIL_PS_(x) _mm256_round_ps(x, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC)
+#define CONVERT_AVX2_TRUNC_PS_(x) (x)
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_f32_to_i32_(const float* src, int32_t* dst, size_t n, float scale,
+                                                          ConvertRounding mode) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    switch (mode) {
+        case CONVERT_NEAREST: CONVERT_AVX2_F32_LOOP_(CONVERT_AVX2_NEAREST_PS_) break;
+        case CONVERT_FLOOR: CONVERT_AVX2_F32_LOOP_(CONVERT_AVX2_FLOOR_PS_) break;
+        case CONVERT_CEIL: CONVERT_AVX2_F32_LOOP_(CONVERT_AVX2_CEIL_PS_) break;
+        default: CONVERT_AVX2_F32_LOOP_(CONVERT_AVX2_TRUNC_PS_) break;
+    }
+    convert_scalar_f32_to_i32_(src + i, dst + i, n - i, scale, mode);
+}
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_i32_to_f32_(const int32_t* src, float* dst, size_t n, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 f = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(f, s));
+    }
+    convert_scalar_i32_to_f32_(src + i, dst + i, n - i, scale);
+}
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_f64_to_f32_(const double* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+        _mm_storeu_ps(dst + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4)));
+    }
+    convert_scalar_f64_to_f32_(src + i, dst + i, n - i);
+}
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_f32_to_f64_(const float* src, double* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+        _mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+    }
+    convert_scalar_f32_to_f64_(src + i, dst + i, n - i);
+}
+
+#define CONVERT_MAGIC_F64_ 6755399441055744.0   // 1.5 * 2^52
+#define CONVERT_EXACT_F64_ 2251799813685248.0   // 2^51
+
+#define CONVERT_AVX2_F64_LOOP_(ROUND_MODE)                                                             \
+    for (; i + 4 <= n; i += 4) {                                                                       \
+        __m256d x = _mm256_mul_pd(_mm256_loadu_pd(src + i), s);                                        \
+        __m256d r = _mm256_round_pd(x, (ROUND_MODE) | _MM_FROUND_NO_EXC);                              \
+        __m256d in_range = _mm256_cmp_pd(_mm256_andnot_pd(sign, r), exact, _CMP_LT_OQ);                \
+        if (_mm256_movemask_pd(in_range) != 0xF) {                                                     \
+            convert_scalar_f64_to_i64_(src + i, dst + i, 4, scale, mode);                              \
+            continue;                                                                                  \
+        }                                                                                              \
+        __m256i bits = _mm256_castpd_si256(_mm256_add_pd(r, magic));                                   \
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_sub_epi64(bits, _mm256_castpd_si256(magic)));  \
+    }
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_f64_to_i64_(const double* src, int64_t* dst, size_t n, double scale,
+                                                          ConvertRounding mode) {
+    const __m256d s = _mm256_set1_pd(scale), magic = _mm256_set1_pd(CONVERT_MAGIC_F64_);
+    const __m256d exact = _mm256_set1_pd(CONVERT_EXACT_F64_), sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    switch (mode) {
+        case CONVERT_NEAREST: CONVERT_AVX2_F64_LOOP_(_MM_FROUND_TO_NEAREST_INT) break;
+        case CONVERT_FLOOR: CONVERT_AVX2_F64_LOOP_(_MM_FROUND_TO_NEG_INF) break;
+        case CONVERT_CEIL: CONVERT_AVX2_F64_LOOP_(_MM_FROUND_TO_POS_INF) break;
+        default: CONVERT_AVX2_F64_LOOP_(_MM_FROUND_TO_ZERO) break;
+    }
+    convert_scalar_f64_to_i64_(src + i, dst + i, n - i, scale, mode);
+}
+
+// Exact for every int64: the high 48 bits (times 2^16) and the low 16 bits are
+// each placed in a double's mantissa by bit tricks, then added with one rounding.
+static inline CONVERT_TARGET_AVX2_ __m256d convert_avx2_i64_to_pd_(__m256i x) {
+    __m256i hi = _mm256_srai_epi32(x, 16);
+    hi = _mm256_blend_epi16(hi, _mm256_setzero_si256(), 0x33);
+    hi = _mm256_add_epi64(hi, _mm256_castpd_si256(_mm256_set1_pd(442721857769029238784.0)));       // 3 * 2^67
+    __m256i lo = _mm256_blend_epi16(x, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)), 0x88); // 2^52
+    __m256d f = _mm256_sub_pd(_mm256_castsi256_pd(hi), _mm256_set1_pd(442726361368656609280.0));   // 3 * 2^67 + 2^52
+    return _mm256_add_pd(f, _mm256_castsi256_pd(lo));
+}
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_i64_to_f64_(const int64_t* src, double* dst, size_t n, double scale) {
+    const __m256d s = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = convert_avx2_i64_to_pd_(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(d, s));
+    }
+    convert_scalar_i64_to_f64_(src + i, dst + i, n - i, scale);
+}
+
+// Same packs trick as SSE2. Both steps work per 128-bit lane, which cancels out:
+// unpacklo gives elements 0-7 in order, unpackhi elements 8-15.
+static CONVERT_TARGET_AVX2_ void convert_avx2_i32_to_q16_(const int32_t* src, int32_t* dst, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i p = _mm256_packs_epi32(_mm256_loadu_si256((const __m256i*)(src + i)),
+                                       _mm256_loadu_si256((const __m256i*)(src + i + 8)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_unpacklo_epi16(zero, p));
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_unpackhi_epi16(zero, p));
+    }
+    convert_scalar_i32_to_q16_(src + i, dst + i, n - i);
+}
+
+static inline CONVERT_TARGET_AVX2_ __m256i convert_avx2_q16_round_(__m256i q, ConvertRounding mode) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i whole = _mm256_srai_epi32(q, 16);
+    __m256i frac = _mm256_and_si256(q, _mm256_set1_epi32(0xFFFF));
+    __m256i up;
+    switch (mode) {
+        case CONVERT_CEIL: up = _mm256_cmpgt_epi32(frac, zero); break;
+        case CONVERT_TRUNCATE: up = _mm256_and_si256(_mm256_cmpgt_epi32(frac, zero), _mm256_cmpgt_epi32(zero, q)); break;
+        case CONVERT_NEAREST: {
+            __m256i half = _mm256_set1_epi32(0x8000);
+            __m256i odd = _mm256_srai_epi32(_mm256_slli_epi32(whole, 31), 31);
+            up = _mm256_or_si256(_mm256_cmpgt_epi32(frac, half), _mm256_and_si256(_mm256_cmpeq_epi32(frac, half), odd));
+            break;
+        }
+        default: return whole;
+    }
+    return _mm256_sub_epi32(whole, up);
+}
+
+static CONVERT_TARGET_AVX2_ void convert_avx2_q16_to_i32_(const int32_t* src, int32_t* dst, size_t n,
+                                                          ConvertRounding mode) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i q = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), convert_avx2_q16_round_(q, mode));
+    }
+    convert_scalar_q16_to_i32_(src + i, dst + i, n - i, mode);
+}
+
+#endif // CONVERT_HAVE_X86
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+static const ConvertKernels convert_kernel_table_[CONVERT_VARIANT_COUNT] = {
+    [CONVERT_SCALAR] = {"scalar", convert_scalar_f32_to_i32_, convert_scalar_i32_to_f32_, convert_scalar_f64_to_f32_,
+                        convert_scalar_f32_to_f64_, convert_scalar_f64_to_i64_, convert_scalar_i64_to_f64_,
+                        convert_scalar_i32_to_q16_, convert_scalar_q16_to_i32_},
+#ifdef CONVERT_HAVE_X86
+    [CONVERT_SSE2] = {"sse2", convert_sse2_f32_to_i32_, convert_sse2_i32_to_f32_, convert_sse2_f64_to_f32_,
+                      convert_sse2_f32_to_f64_, convert_scalar_f64_to_i64_, convert_scalar_i64_to_f64_,
+                      convert_sse2_i32_to_q16_, convert_sse2_q16_to_i32_},
+    [CONVERT_AVX2] = {"avx2", convert_avx2_f32_to_i32_, convert_avx2_i32_to_f32_, convert_avx2_f64_to_f32_,
+                      convert_avx2_f32_to_f64_, convert_avx2_f64_to_i64_, convert_avx2_i64_to_f64_,
+                      convert_avx2_i32_to_q16_, convert_avx2_q16_to_i32_},
+#endif
+};
+
+// Returns 1 if the variant is compiled in and the running CPU supports it.
+static inline int convert_variant_supported(ConvertVariant v) {
+    if ((unsigned)v >= CONVERT_VARIANT_COUNT || convert_kernel_table_[v].name == NULL) return 0;
+#ifdef CONVERT_HAVE_X86
+    __builtin_cpu_init();
+    switch (v) {
+        case CONVERT_SSE2: return __builtin_cpu_supports("sse2") != 0;
+        case CONVERT_AVX2: return __builtin_cpu_supports("avx2") != 0;
+        default: break;
+    }
+#endif
+    return 1;
+}
+
+static inline const ConvertKernels* convert_kernels_for(ConvertVariant v) {
+    return convert_variant_supported(v) ? &convert_kernel_table_[v] : NULL;
+}
+
+static const ConvertKernels* convert_active_ = NULL;
+
+static inline const ConvertKernels* convert_select_(void) {
+    const char* forced = getenv("CONVERT_SIMD_VARIANT");
+    if (forced != NULL) {
+        for (int v = 0; v < CONVERT_VARIANT_COUNT; v++) {
+            if (convert_variant_supported((ConvertVariant)v) && strcmp(convert_kernel_table_[v].name, forced) == 0) {
+                return &convert_kernel_table_[v];
+            }
+        }
+    }
+    // Table order is slowest to fastest: take the last one the CPU can run
+    for (int v = CONVERT_VARIANT_COUNT - 1; v > CONVERT_SCALAR; v--) {
+        if (convert_variant_supported((ConvertVariant)v)) return &convert_kernel_table_[v];
+    }
+    return &convert_kernel_table_[CONVERT_SCALAR];
+}
+
+__attribute__((constructor)) static void convert_dispatch_init_(void) {
+    __atomic_store_n(&convert_active_, convert_select_(), __ATOMIC_RELEASE);
+}
+
+static inline const ConvertKernels* convert_kernels(void) {
+    const ConvertKernels* k = __atomic_load_n(&convert_active_, __ATOMIC_ACQUIRE);
+    if (k == NULL) {
+        k = convert_select_();
+        __atomic_store_n(&convert_active_, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+// ---------------------------------------------------------------------------
+// Array conversions
+// ---------------------------------------------------------------------------
+
+static inline void convert_f32_to_i32(const float* src, int32_t* dst, size_t n, ConvertRounding mode) {
+    convert_kernels()->f32_to_i32(src, dst, n, 1.0f, mode);
+}
+
+static inline void convert_i32_to_f32(const int32_t* src, float* dst, size_t n) {
+    convert_kernels()->i32_to_f32(src, dst, n, 1.0f);
+}
+
+static inline void convert_f64_to_f32(const double* src, float* dst, size_t n) {
+    convert_kernels()->f64_to_f32(src, dst, n);
+}
+
+static inline void convert_f32_to_f64(const float* src, double* dst, size_t n) {
+    convert_kernels()->f32_to_f64(src, dst, n);
+}
+
+static inline void convert_f64_to_i64(const double* src, int64_t* dst, size_t n, ConvertRounding mode) {
+    convert_kernels()->f64_to_i64(src, dst, n, 1.0, mode);
+}
+
+static inline void convert_i64_to_f64(const int64_t* src, double* dst, size_t n) {
+    convert_kernels()->i64_to_f64(src, dst, n, 1.0);
+}
+
+static inline void convert_f32_to_q16(const float* src, int32_t* dst, size_t n, ConvertRounding mode) {
+    convert_kernels()->f32_to_i32(src, dst, n, CONVERT_Q16_ONE, mode);
+}
+
+static inline void convert_q16_to_f32(const int32_t* src, float* dst, size_t n) {
+    convert_kernels()->i32_to_f32(src, dst, n, 1.0f / CONVERT_Q16_ONE);
+}
+
+static inline void convert_f64_to_q32(const double* src, int64_t* dst, size_t n, ConvertRounding mode) {
+    convert_kernels()->f64_to_i64(src, dst, n, CONVERT_Q32_ONE, mode);
+}
+
+static inline void convert_q32_to_f64(const int64_t* src, double* dst, size_t n) {
+    convert_kernels()->i64_to_f64(src, dst, n, 1.0 / CONVERT_Q32_ONE);
+}
+
+static inline void convert_i32_to_q16(const int32_t* src, int32_t* dst, size_t n) {
+    convert_kernels()->i32_to_q16(src, dst, n);
+}
+
+static inline void convert_q16_to_i32(const int32_t* src, int32_t* dst, size_t n, ConvertRounding mode) {
+    convert_kernels()->q16_to_i32(src, dst, n, mode);
+}
+
+#endif // CONVERT_H
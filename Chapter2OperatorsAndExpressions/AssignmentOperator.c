@@ -59,8 +59,9 @@ Comparison to other languages:
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <assert.h>
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+#include "../Chapter16MultithreadingAndConcurrency/thread_pool.h"
 
 // Function prototypes
 void basic_assignment();
@@ -205,28 +206,122 @@ void assign_values_compound(int* arr, int size, int value) {
     }
 }
 
+typedef struct {
+    int* arr;
+    int size;
+    ThreadPool* pool;
+} AssignBench;
+
+void assign_values_run(void* ctx) {
+    AssignBench* bench = (AssignBench*)ctx;
+    assign_values(bench->arr, bench->size, 1);
+    BENCH_DO_NOT_OPTIMIZE(bench->arr[bench->size - 1]);
+}
+
+void assign_values_compound_run(void* ctx) {
+    AssignBench* bench = (AssignBench*)ctx;
+    assign_values_compound(bench->arr, bench->size, 1);
+    BENCH_DO_NOT_OPTIMIZE(bench->arr[bench->size - 1]);
+}
+
+// Thread-pool versions: every chunk [begin, end) is a disjoint slice of the
+// array, so workers never write to the same element
+void assign_values_chunk(void* ctx, size_t begin, size_t end, unsigned worker) {
+    (void)worker;
+    AssignBench* bench = (AssignBench*)ctx;
+    assign_values(bench->arr + begin, (int)(end - begin), 1);
+}
+
+void assign_values_compound_chunk(void* ctx, size_t begin, size_t end, unsigned worker) {
+    (void)worker;
+    AssignBench* bench = (AssignBench*)ctx;
+    assign_values_compound(bench->arr + begin, (int)(end - begin), 1);
+}
+
+void assign_values_parallel_run(void* ctx) {
+    AssignBench* bench = (AssignBench*)ctx;
+    parallel_for(bench->pool, 0, (size_t)bench->size, 0, assign_values_chunk, bench);
+    BENCH_DO_NOT_OPTIMIZE(bench->arr[bench->size - 1]);
+}
+
+void assign_values_compound_parallel_run(void* ctx) {
+    AssignBench* bench = (AssignBench*)ctx;
+    parallel_for(bench->pool, 0, (size_t)bench->size, 0, assign_values_compound_chunk, bench);
+    BENCH_DO_NOT_OPTIMIZE(bench->arr[bench->size - 1]);
+}
+
+// Strong scaling over the same array. Both loops are limited by memory
+// bandwidth, so expect them to flatten out well before the core count.
+void assignment_scaling(AssignBench* bench) {
+    static char names[32][40];
+    unsigned steps[16];
+    unsigned count = thread_pool_scaling_steps(thread_pool_cpu_count(), steps, 16);
+    BenchSuite suite;
+
+    bench_suite_init(&suite, "Assignment strong scaling (parallel_for)");
+    for (unsigned s = 0; s < count; s++) {
+        ThreadPool pool;
+        if (thread_pool_init(&pool, steps[s]) != 0) {
+            fprintf(stderr, "Thread pool creation failed\n");
+            break;
+        }
+        const char* plural = steps[s] == 1 ? "" : "s";
+        snprintf(names[2 * s], sizeof(names[0]), "simple, %u thread%s", steps[s], plural);
+        snprintf(names[2 * s + 1], sizeof(names[0]), "compound, %u thread%s", steps[s], plural);
+        bench->pool = &pool;
+        bench_suite_run(&suite, names[2 * s], assign_values_parallel_run, bench, bench->size);
+        bench_suite_run(&suite, names[2 * s + 1], assign_values_compound_parallel_run, bench, bench->size);
+        thread_pool_destroy(&pool);
+    }
+    bench->pool = NULL;
+    bench_suite_report(&suite);
+
+    // One line per thread count: speedup of each loop over its own 1-thread run
+    for (int i = 2; i + 1 < suite.count; i += 2) {
+        unsigned threads = steps[i / 2];
+        printf("  %2u threads: simple %.2fx, compound %.2fx (%.2f GB/s written)\n", threads,
+               suite.results[0].median_ns / suite.results[i].median_ns,
+               suite.results[1].median_ns / suite.results[i + 1].median_ns,
+               bench_throughput(&suite.results[i], (double)bench->size * sizeof(int)) / 1e9);
+    }
+}
+
 void performance_comparison() {
     printf("2.8 Performance Comparison\n");
     printf("---------------------------\n");
 
     const int SIZE = 10000000;
     int* arr = malloc(SIZE * sizeof(int));
-    clock_t start, end;
-    double cpu_time_used;
-
-    // Simple assignment
-    start = clock();
-    assign_values(arr, SIZE, 1);
-    end = clock();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Time for simple assignment: %f seconds\n", cpu_time_used);
-
-    // Compound assignment
-    start = clock();
-    assign_values_compound(arr, SIZE, 1);
-    end = clock();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Time for compound assignment: %f seconds\n", cpu_time_used);
+    if (arr == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    ThreadPool pool;
+    if (thread_pool_init(&pool, 0) != 0) {
+        fprintf(stderr, "Thread pool creation failed\n");
+        free(arr);
+        return;
+    }
+    AssignBench bench = {arr, SIZE, &pool};
+    BenchSuite suite;
+    static char simple_name[48], compound_name[48];
+    unsigned threads = thread_pool_size(&pool);
+    snprintf(simple_name, sizeof(simple_name), "simple, %u thread%s", threads, threads == 1 ? "" : "s");
+    snprintf(compound_name, sizeof(compound_name), "compound, %u thread%s", threads, threads == 1 ? "" : "s");
+
+    // Touch every page once so the first timed run does not pay for page faults
+    memset(arr, 0, SIZE * sizeof(int));
+
+    bench_suite_init(&suite, "Simple vs compound assignment");
+    bench_suite_run(&suite, "simple (arr[i] = v)", assign_values_run, &bench, SIZE);
+    bench_suite_run(&suite, "compound (arr[i] += v)", assign_values_compound_run, &bench, SIZE);
+    bench_suite_run(&suite, simple_name, assign_values_parallel_run, &bench, SIZE);
+    bench_suite_run(&suite, compound_name, assign_values_compound_parallel_run, &bench, SIZE);
+    bench_suite_report(&suite);
+    thread_pool_destroy(&pool);
+    printf("\n");
+
+    assignment_scaling(&bench);
 
     free(arr);
     printf("\n");
@@ -362,6 +457,9 @@ Optimization Strategies:
 - Minimize unnecessary assignments, especially in tight loops.
 - Use compound assignments when possible for potential compiler optimizations.
 - Consider using SIMD instructions for bulk assignments in performance-critical code.
+- Split large fill/update loops over cores with parallel_for() from
+  Chapter16MultithreadingAndConcurrency/thread_pool.h; the gain stops once memory
+  bandwidth is saturated (see the strong-scaling table in 2.8).
 
 Performance Trade-offs:
 - Balance between code readability and performance when using complex assignment expressions.
@@ -396,7 +494,7 @@ valuable resource for C programmers at all skill levels. As the language and its
 evolve, contributions from the community will help keep this guide relevant and useful.
 
 To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
-    gcc -o assignment_cheatsheet assignment_cheatsheet.c -O2
+    gcc -o assignment_cheatsheet assignment_cheatsheet.c -O2 -pthread
 
 Then execute the resulting binary:
     ./assignment_cheatsheet
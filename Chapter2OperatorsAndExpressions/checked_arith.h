@@ -0,0 +1,511 @@
+/*
+checked_arith.h - Checked and Saturating Arithmetic, Binary GCD, Constant Division
+================================================
+
+Signed overflow in C is undefined behaviour, and unsigned overflow wraps silently.
+This header gives the alternatives:
+
+    int64_t r;
+    if (checked_add_i64(a, b, &r)) ...          // 1 on overflow (r holds the wrapped value)
+    if (checked_mul_u64(n, size, &bytes)) ...   // Same for sub/mul and i32/u32/i64/u64
+
+    checked_sum_i64(values, n, &total)          // Exact sum: 0, or -1 with errno = ERANGE
+    sat_add_i32(a, b)                           // Clamped to INT32_MIN..INT32_MAX
+    sat_add_i32_array(a, b, out, n)             // Same over arrays; i16, i32, i64; add, sub, mul
+
+    gcd_binary_u64(a, b)                        // Stein's algorithm: shifts, no division
+
+    DivConstU32 by;
+    divconst_u32_init(&by, 60);                 // 0, or -1 with errno = EINVAL for 0
+    uint32_t minutes = divconst_u32(&by, seconds);
+    divconst_u32_array(&by, src, dst, n);
+
+Design:
+- Checked operations wrap __builtin_add/sub/mul_overflow, which compile to the
+  operation and a jump on the overflow flag (jo or jc).
+- checked_sum_i64 has no overflow test in its loop. Each value is split into its
+  low 32 bits, its high 32 bits read unsigned, and its sign bit. Three uint64_t sums
+  of those pieces cannot overflow within 2^32 values, and they rebuild the exact
+  total as a 128-bit integer. The range is checked once at the end. The result
+  therefore does not depend on the order of the values, and the loop vectorizes.
+- Saturating operations are branch-free. A scalar one selects between the result
+  and the limit with the builtin's flag. The array kernels use the CPU's
+  saturating instructions for int16 (vpaddsw, vpsubsw, and vpmulhw + vpackssdw for
+  products). For int32 and int64 they test the sign of (a ^ s) & (b ^ s) and blend.
+  int32 products are formed in 64 bits (vpmuldq) and clamped.
+- Division by a runtime constant uses Granlund-Montgomery's round-up multiplier.
+  One multiply-high, a subtract, an add and two shifts are exact for every
+  dividend and every divisor, powers of two and 1 included. That replaces a
+  20-90 cycle div instruction. vpmuludq runs it on 8 lanes at once.
+- Array kernels exist in scalar and AVX2 variants. The AVX2 variant is chosen at
+  startup if the CPU supports it, as in popcount_simd.h;
+  ARITH_SIMD_VARIANT=scalar forces the portable loops. Output arrays may alias
+  the inputs.
+- 64-bit multiply-high and the exact sum use unsigned __int128 (GCC, Clang).
+*/
+
+#ifndef CHECKED_ARITH_H
+#define CHECKED_ARITH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ARITH_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Checked operations: return 1 on overflow, 0 otherwise
+// ---------------------------------------------------------------------------
+
+#define CHECKED_DEFINE_(SUFFIX, T)                                                                             \
+    static inline int checked_add_##SUFFIX(T a, T b, T* out) { return __builtin_add_overflow(a, b, out); }    \
+    static inline int checked_sub_##SUFFIX(T a, T b, T* out) { return __builtin_sub_overflow(a, b, out); }    \
+    static inline int checked_mul_##SUFFIX(T a, T b, T* out) { return __builtin_mul_overflow(a, b, out); }
+
+CHECKED_DEFINE_(i32, int32_t)
+CHECKED_DEFINE_(u32, uint32_t)
+CHECKED_DEFINE_(i64, int64_t)
+CHECKED_DEFINE_(u64, uint64_t)
+
+// ---------------------------------------------------------------------------
+// Saturating scalars
+// ---------------------------------------------------------------------------
+
+// On overflow the result saturates toward the sign of a (add, sub) or of a * b (mul).
+static inline int32_t sat_add_i32(int32_t a, int32_t b) {
+    int32_t r;
+    int32_t limit = (int32_t)((uint32_t)(a >> 31) ^ INT32_MAX);
+    return __builtin_add_overflow(a, b, &r) ? limit : r;
+}
+
+static inline int32_t sat_sub_i32(int32_t a, int32_t b) {
+    int32_t r;
+    int32_t limit = (int32_t)((uint32_t)(a >> 31) ^ INT32_MAX);
+    return __builtin_sub_overflow(a, b, &r) ? limit : r;
+}
+
+static inline int32_t sat_mul_i32(int32_t a, int32_t b) {
+    int32_t r;
+    int32_t limit = (int32_t)((uint32_t)((a ^ b) >> 31) ^ INT32_MAX);
+    return __builtin_mul_overflow(a, b, &r) ? limit : r;
+}
+
+static inline int64_t sat_add_i64(int64_t a, int64_t b) {
+    int64_t r;
+    int64_t limit = (int64_t)((uint64_t)(a >> 63) ^ INT64_MAX);
+    return __builtin_add_overflow(a, b, &r) ? limit : r;
+}
+
+static inline int64_t sat_sub_i64(int64_t a, int64_t b) {
+    int64_t r;
+    int64_t limit = (int64_t)((uint64_t)(a >> 63) ^ INT64_MAX);
+    return __builtin_sub_overflow(a, b, &r) ? limit : r;
+}
+
+static inline int64_t sat_mul_i64(int64_t a, int64_t b) {
+    int64_t r;
+    int64_t limit = (int64_t)((uint64_t)((a ^ b) >> 63) ^ INT64_MAX);
+    return __builtin_mul_overflow(a, b, &r) ? limit : r;
+}
+
+static inline int16_t sat_clamp_i16_(int32_t x) {
+    return (int16_t)(x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : x);
+}
+
+static inline int16_t sat_add_i16(int16_t a, int16_t b) { return sat_clamp_i16_((int32_t)a + b); }
+static inline int16_t sat_sub_i16(int16_t a, int16_t b) { return sat_clamp_i16_((int32_t)a - b); }
+static inline int16_t sat_mul_i16(int16_t a, int16_t b) { return sat_clamp_i16_((int32_t)a * b); }
+
+// ---------------------------------------------------------------------------
+// Binary GCD
+// ---------------------------------------------------------------------------
+
+// Stein: strip common factors of two once, then subtract the smaller odd value
+// from the larger and strip the new factors of two. The swap compiles to cmov.
+static inline uint64_t gcd_binary_u64(uint64_t a, uint64_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        uint64_t lo = a < b ? a : b;
+        b = (a < b ? b : a) - lo;
+        a = lo;
+    } while (b != 0);
+    return a << shift;
+}
+
+static inline uint32_t gcd_binary_u32(uint32_t a, uint32_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    int shift = __builtin_ctz(a | b);
+    a >>= __builtin_ctz(a);
+    do {
+        b >>= __builtin_ctz(b);
+        uint32_t lo = a < b ? a : b;
+        b = (a < b ? b : a) - lo;
+        a = lo;
+    } while (b != 0);
+    return a << shift;
+}
+
+// ---------------------------------------------------------------------------
+// Division by a runtime constant
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t magic;
+    uint8_t shift1;                             // 0 for divisor 1, else 1
+    uint8_t shift2;                             // ceil(log2(divisor)) - 1, or 0
+    uint32_t divisor;
+} DivConstU32;
+
+typedef struct {
+    uint64_t magic;
+    uint8_t shift1;
+    uint8_t shift2;
+    uint64_t divisor;
+} DivConstU64;
+
+static inline int divconst_u32_init(DivConstU32* d, uint32_t divisor) {
+    if (divisor == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    unsigned l = divisor == 1 ? 0 : 32 - (unsigned)__builtin_clz(divisor - 1);
+    // m = floor(2^32 * (2^l - d) / d) + 1, which is below 2^32 because 2^l < 2d
+    d->magic = (uint32_t)((((1ull << l) - divisor) << 32) / divisor + 1);
+    d->shift1 = l > 0;
+    d->shift2 = (uint8_t)(l > 0 ? l - 1 : 0);
+    d->divisor = divisor;
+    return 0;
+}
+
+static inline uint32_t divconst_u32(const DivConstU32* d, uint32_t x) {
+    uint32_t t = (uint32_t)(((uint64_t)x * d->magic) >> 32);
+    return (t + ((x - t) >> d->shift1)) >> d->shift2;
+}
+
+static inline uint32_t divconst_u32_mod(const DivConstU32* d, uint32_t x) {
+    return x - divconst_u32(d, x) * d->divisor;
+}
+
+static inline int divconst_u64_init(DivConstU64* d, uint64_t divisor) {
+    if (divisor == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    unsigned l = divisor == 1 ? 0 : 64 - (unsigned)__builtin_clzll(divisor - 1);
+    unsigned __int128 span = ((unsigned __int128)1 << l) - divisor;
+    d->magic = (uint64_t)((span << 64) / divisor + 1);
+    d->shift1 = l > 0;
+    d->shift2 = (uint8_t)(l > 0 ? l - 1 : 0);
+    d->divisor = divisor;
+    return 0;
+}
+
+static inline uint64_t divconst_u64(const DivConstU64* d, uint64_t x) {
+    uint64_t t = (uint64_t)(((unsigned __int128)x * d->magic) >> 64);
+    return (t + ((x - t) >> d->shift1)) >> d->shift2;
+}
+
+static inline uint64_t divconst_u64_mod(const DivConstU64* d, uint64_t x) {
+    return x - divconst_u64(d, x) * d->divisor;
+}
+
+// ---------------------------------------------------------------------------
+// Array kernels
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    ARITH_SCALAR,
+    ARITH_AVX2,
+    ARITH_VARIANT_COUNT
+} ArithVariant;
+
+typedef struct {
+    const char* name;
+    void (*sat_add_i16)(const int16_t* a, const int16_t* b, int16_t* out, size_t n);
+    void (*sat_sub_i16)(const int16_t* a, const int16_t* b, int16_t* out, size_t n);
+    void (*sat_mul_i16)(const int16_t* a, const int16_t* b, int16_t* out, size_t n);
+    void (*sat_add_i32)(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+    void (*sat_sub_i32)(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+    void (*sat_mul_i32)(const int32_t* a, const int32_t* b, int32_t* out, size_t n);
+    void (*sat_add_i64)(const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+    void (*sat_sub_i64)(const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+    // Adds the low halves, unsigned high halves and sign bits of up to 2^32 - 1 values into parts[3]
+    void (*sum_i64_parts)(const int64_t* v, size_t n, uint64_t parts[3]);
+    void (*div_u32)(const DivConstU32* d, const uint32_t* src, uint32_t* dst, size_t n);
+} ArithKernels;
+
+#define ARITH_SCALAR_ARRAY_(NAME, T, OP)                                                               \
+    static void arith_scalar_##NAME##_(const T* a, const T* b, T* out, size_t n) {                     \
+        for (size_t i = 0; i < n; i++) out[i] = OP(a[i], b[i]);                                        \
+    }
+
+ARITH_SCALAR_ARRAY_(sat_add_i16, int16_t, sat_add_i16)
+ARITH_SCALAR_ARRAY_(sat_sub_i16, int16_t, sat_sub_i16)
+ARITH_SCALAR_ARRAY_(sat_mul_i16, int16_t, sat_mul_i16)
+ARITH_SCALAR_ARRAY_(sat_add_i32, int32_t, sat_add_i32)
+ARITH_SCALAR_ARRAY_(sat_sub_i32, int32_t, sat_sub_i32)
+ARITH_SCALAR_ARRAY_(sat_mul_i32, int32_t, sat_mul_i32)
+ARITH_SCALAR_ARRAY_(sat_add_i64, int64_t, sat_add_i64)
+ARITH_SCALAR_ARRAY_(sat_sub_i64, int64_t, sat_sub_i64)
+
+static void arith_scalar_sum_i64_parts_(const int64_t* v, size_t n, uint64_t parts[3]) {
+    uint64_t lo = 0, hi = 0, neg = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t u = (uint64_t)v[i];
+        lo += u & 0xFFFFFFFFu;
+        hi += u >> 32;
+        neg += u >> 63;
+    }
+    parts[0] += lo;
+    parts[1] += hi;
+    parts[2] += neg;
+}
+
+static void arith_scalar_div_u32_(const DivConstU32* d, const uint32_t* src, uint32_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = divconst_u32(d, src[i]);
+}
+
+#ifdef ARITH_HAVE_X86
+
+#define ARITH_TARGET_AVX2_ __attribute__((target("avx2")))
+
+// One 256-bit step per iteration, the scalar kernel for the tail
+#define ARITH_AVX2_ARRAY_(NAME, T, PER_VECTOR, STEP)                                                   \
+    static ARITH_TARGET_AVX2_ void arith_avx2_##NAME##_(const T* a, const T* b, T* out, size_t n) {    \
+        size_t i = 0;                                                                                  \
+        for (; i + (PER_VECTOR) <= n; i += (PER_VECTOR)) {                                             \
+            __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));                                   \
+            __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));                                   \
+            _mm256_storeu_si256((__m256i*)(out + i), STEP(x, y));                                      \
+        }                                                                                              \
+        arith_scalar_##NAME##_(a + i, b + i, out + i, n - i);                                          \
+    }
+
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_mul_i16_(__m256i x, __m256i y) {
+    __m256i lo = _mm256_mullo_epi16(x, y), hi = _mm256_mulhi_epi16(x, y);
+    // Interleaving rebuilds the 32-bit products; packing them saturates. Both work
+    // per 128-bit lane, so the element order comes out unchanged.
+    return _mm256_packs_epi32(_mm256_unpacklo_epi16(lo, hi), _mm256_unpackhi_epi16(lo, hi));
+}
+
+// The limit for a lane that overflows: INT_MAX when x >= 0, INT_MIN when x < 0
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_limit_i32_(__m256i sign_source) {
+    return _mm256_xor_si256(_mm256_srai_epi32(sign_source, 31), _mm256_set1_epi32(INT32_MAX));
+}
+
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_add_i32_(__m256i x, __m256i y) {
+    __m256i s = _mm256_add_epi32(x, y);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(x, s), _mm256_xor_si256(y, s));
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s), _mm256_castsi256_ps(arith_avx2_limit_i32_(x)),
+                                                _mm256_castsi256_ps(overflow)));
+}
+
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_sub_i32_(__m256i x, __m256i y) {
+    __m256i s = _mm256_sub_epi32(x, y);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, s));
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s), _mm256_castsi256_ps(arith_avx2_limit_i32_(x)),
+                                                _mm256_castsi256_ps(overflow)));
+}
+
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_clamp_i64_to_i32_(__m256i p) {
+    const __m256i max = _mm256_set1_epi64x(INT32_MAX), min = _mm256_set1_epi64x(INT32_MIN);
+    p = _mm256_blendv_epi8(p, max, _mm256_cmpgt_epi64(p, max));
+    return _mm256_blendv_epi8(p, min, _mm256_cmpgt_epi64(min, p));
+}
+
+// vpmuldq multiplies the even 32-bit lanes into 64-bit products; the odd lanes
+// are shifted down for a second one. The clamped low halves are blended back.
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_mul_i32_(__m256i x, __m256i y) {
+    __m256i even = arith_avx2_clamp_i64_to_i32_(_mm256_mul_epi32(x, y));
+    __m256i odd = arith_avx2_clamp_i64_to_i32_(_mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32)));
+    return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+// No vpsraq before AVX-512: the sign mask comes from a compare with zero
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_limit_i64_(__m256i sign_source) {
+    __m256i negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), sign_source);
+    return _mm256_xor_si256(negative, _mm256_set1_epi64x(INT64_MAX));
+}
+
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_add_i64_(__m256i x, __m256i y) {
+    __m256i s = _mm256_add_epi64(x, y);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(x, s), _mm256_xor_si256(y, s));
+    return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(s), _mm256_castsi256_pd(arith_avx2_limit_i64_(x)),
+                                                _mm256_castsi256_pd(overflow)));
+}
+
+static inline ARITH_TARGET_AVX2_ __m256i arith_avx2_sub_i64_(__m256i x, __m256i y) {
+    __m256i s = _mm256_sub_epi64(x, y);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, s));
+    return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(s), _mm256_castsi256_pd(arith_avx2_limit_i64_(x)),
+                                                _mm256_castsi256_pd(overflow)));
+}
+
+#define ARITH_AVX2_ADDS_I16_(x, y) _mm256_adds_epi16(x, y)
+#define ARITH_AVX2_SUBS_I16_(x, y) _mm256_subs_epi16(x, y)
+
+ARITH_AVX2_ARRAY_(sat_add_i16, int16_t, 16, ARITH_AVX2_ADDS_I16_)
+ARITH_AVX2_ARRAY_(sat_sub_i16, int16_t, 16, ARITH_AVX2_SUBS_I16_)
+ARITH_AVX2_ARRAY_(sat_mul_i16, int16_t, 16, arith_avx2_mul_i16_)
+ARITH_AVX2_ARRAY_(sat_add_i32, int32_t, 8, arith_avx2_add_i32_)
+ARITH_AVX2_ARRAY_(sat_sub_i32, int32_t, 8, arith_avx2_sub_i32_)
+ARITH_AVX2_ARRAY_(sat_mul_i32, int32_t, 8, arith_avx2_mul_i32_)
+ARITH_AVX2_ARRAY_(sat_add_i64, int64_t, 4, arith_avx2_add_i64_)
+ARITH_AVX2_ARRAY_(sat_sub_i64, int64_t, 4, arith_avx2_sub_i64_)
+
+static ARITH_TARGET_AVX2_ void arith_avx2_sum_i64_parts_(const int64_t* v, size_t n, uint64_t parts[3]) {
+    const __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i lo = _mm256_setzero_si256(), hi = lo, neg = lo;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(v + i));
+        lo = _mm256_add_epi64(lo, _mm256_and_si256(x, low_mask));
+        hi = _mm256_add_epi64(hi, _mm256_srli_epi64(x, 32));
+        neg = _mm256_add_epi64(neg, _mm256_srli_epi64(x, 63));
+    }
+    uint64_t lanes[3][4];
+    _mm256_storeu_si256((__m256i*)lanes[0], lo);
+    _mm256_storeu_si256((__m256i*)lanes[1], hi);
+    _mm256_storeu_si256((__m256i*)lanes[2], neg);
+    for (int p = 0; p < 3; p++) parts[p] += lanes[p][0] + lanes[p][1] + lanes[p][2] + lanes[p][3];
+    arith_scalar_sum_i64_parts_(v + i, n - i, parts);
+}
+
+static ARITH_TARGET_AVX2_ void arith_avx2_div_u32_(const DivConstU32* d, const uint32_t* src, uint32_t* dst,
+                                                    size_t n) {
+    const __m256i magic = _mm256_set1_epi32((int)d->magic);
+    const __m128i shift1 = _mm_cvtsi32_si128(d->shift1), shift2 = _mm_cvtsi32_si128(d->shift2);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        // Multiply-high of the even lanes lands in the odd halves; blend with the odd lanes' products
+        __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 32);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic);
+        __m256i t = _mm256_blend_epi32(even, odd, 0xAA);
+        __m256i q = _mm256_add_epi32(t, _mm256_srl_epi32(_mm256_sub_epi32(x, t), shift1));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_srl_epi32(q, shift2));
+    }
+    arith_scalar_div_u32_(d, src + i, dst + i, n - i);
+}
+
+#endif // ARITH_HAVE_X86
+
+static const ArithKernels arith_kernel_table_[ARITH_VARIANT_COUNT] = {
+    [ARITH_SCALAR] = {"scalar", arith_scalar_sat_add_i16_, arith_scalar_sat_sub_i16_, arith_scalar_sat_mul_i16_,
+                      arith_scalar_sat_add_i32_, arith_scalar_sat_sub_i32_, arith_scalar_sat_mul_i32_,
+                      arith_scalar_sat_add_i64_, arith_scalar_sat_sub_i64_, arith_scalar_sum_i64_parts_,
+                      arith_scalar_div_u32_},
+#ifdef ARITH_HAVE_X86
+    [ARITH_AVX2] = {"avx2", arith_avx2_sat_add_i16_, arith_avx2_sat_sub_i16_, arith_avx2_sat_mul_i16_,
+                    arith_avx2_sat_add_i32_, arith_avx2_sat_sub_i32_, arith_avx2_sat_mul_i32_,
+                    arith_avx2_sat_add_i64_, arith_avx2_sat_sub_i64_, arith_avx2_sum_i64_parts_,
+                    arith_avx2_div_u32_},
+#endif
+};
+
+// Returns 1 if the variant is compiled in and the running CPU supports it.
+static inline int arith_variant_supported(ArithVariant v) {
+    if ((unsigned)v >= ARITH_VARIANT_COUNT || arith_kernel_table_[v].name == NULL) return 0;
+#ifdef ARITH_HAVE_X86
+    if (v == ARITH_AVX2) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }
+#endif
+    return 1;
+}
+
+static inline const ArithKernels* arith_kernels_for(ArithVariant v) {
+    return arith_variant_supported(v) ? &arith_kernel_table_[v] : NULL;
+}
+
+static const ArithKernels* arith_active_ = NULL;
+
+static inline const ArithKernels* arith_select_(void) {
+    const char* forced = getenv("ARITH_SIMD_VARIANT");
+    if (forced != NULL) {
+        for (int v = 0; v < ARITH_VARIANT_COUNT; v++) {
+            if (arith_variant_supported((ArithVariant)v) && strcmp(arith_kernel_table_[v].name, forced) == 0) {
+                return &arith_kernel_table_[v];
+            }
+        }
+    }
+    for (int v = ARITH_VARIANT_COUNT - 1; v > ARITH_SCALAR; v--) {
+        if (arith_variant_supported((ArithVariant)v)) return &arith_kernel_table_[v];
+    }
+    return &arith_kernel_table_[ARITH_SCALAR];
+}
+
+__attribute__((constructor)) static void arith_dispatch_init_(void) {
+    __atomic_store_n(&arith_active_, arith_select_(), __ATOMIC_RELEASE);
+}
+
+static inline const ArithKernels* arith_kernels(void) {
+    const ArithKernels* k = __atomic_load_n(&arith_active_, __ATOMIC_ACQUIRE);
+    if (k == NULL) {
+        k = arith_select_();
+        __atomic_store_n(&arith_active_, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+#define ARITH_ARRAY_API_(NAME, T)                                                                      \
+    static inline void NAME##_array(const T* a, const T* b, T* out, size_t n) {                        \
+        arith_kernels()->NAME(a, b, out, n);                                                           \
+    }
+
+ARITH_ARRAY_API_(sat_add_i16, int16_t)
+ARITH_ARRAY_API_(sat_sub_i16, int16_t)
+ARITH_ARRAY_API_(sat_mul_i16, int16_t)
+ARITH_ARRAY_API_(sat_add_i32, int32_t)
+ARITH_ARRAY_API_(sat_sub_i32, int32_t)
+ARITH_ARRAY_API_(sat_mul_i32, int32_t)
+ARITH_ARRAY_API_(sat_add_i64, int64_t)
+ARITH_ARRAY_API_(sat_sub_i64, int64_t)
+
+static inline void divconst_u32_array(const DivConstU32* d, const uint32_t* src, uint32_t* dst, size_t n) {
+    arith_kernels()->div_u32(d, src, dst, n);
+}
+
+// Rebuilds sum(v) from the three part sums: each value is its low half plus
+// 2^32 times its high half read unsigned, minus 2^64 if it is negative.
+static inline __int128 arith_sum_from_parts_(const uint64_t parts[3]) {
+    return (__int128)parts[0] + ((__int128)parts[1] << 32) - ((__int128)parts[2] << 64);
+}
+
+// Exact sum of v[0..n). Returns 0, or -1 with errno = ERANGE when the total does
+// not fit an int64_t; *out is then saturated to INT64_MAX or INT64_MIN.
+static inline int checked_sum_i64_with(const ArithKernels* k, const int64_t* v, size_t n, int64_t* out) {
+    const size_t chunk = 0xFFFFFFFFu;
+    __int128 total = 0;
+    for (size_t done = 0; done < n;) {
+        size_t len = n - done < chunk ? n - done : chunk;
+        uint64_t parts[3] = {0, 0, 0};
+        k->sum_i64_parts(v + done, len, parts);
+        total += arith_sum_from_parts_(parts);
+        done += len;
+    }
+    if (total > INT64_MAX || total < INT64_MIN) {
+        *out = total > 0 ? INT64_MAX : INT64_MIN;
+        errno = ERANGE;
+        return -1;
+    }
+    *out = (int64_t)total;
+    return 0;
+}
+
+static inline int checked_sum_i64(const int64_t* v, size_t n, int64_t* out) {
+    return checked_sum_i64_with(arith_kernels(), v, n, out);
+}
+
+#endif // CHECKED_ARITH_H
@@ -0,0 +1,221 @@
+/*
+const_tables.h - Lookup Tables Built by the Compiler
+================================================
+
+Byte popcount, byte bit-reverse, byte log2, CRC-32, factorial and binomial tables.
+All of them are ordinary static const arrays, filled in at compile time from the
+generator macros below. They sit in .rodata from the first instruction: no init
+function, no constructor, nothing to get wrong about ordering.
+
+    ctab_popcount8[b], ctab_reverse8[b], ctab_log2_8[b]   // b = 0..255, log2(0) = -1
+    ctab_popcount_u64(x), ctab_reverse_u32(x), ctab_log2_u32(x)
+
+    uint32_t crc = ctab_crc32(data, len);                 // zlib/PNG/Ethernet CRC-32
+    crc = ctab_crc32_update(crc, more, more_len);         // Streamed in pieces
+
+    uint64_t f, c;
+    ctab_factorial_u64(n, &f);                            // 0, or -1 with errno = ERANGE (n > 20)
+    ctab_binomial_u64(n, k, &c);                          // Table for n <= 20, exact loop above
+
+    enum { HEADER_BITS = CTAB_POPCOUNT8(0xA5) };          // The generators are constant expressions
+    switch (code) { case CTAB_CRC32_ENTRY(7): ... }
+
+Design:
+- CTAB_R256_(F) expands F(0) ... F(255); each table is one initializer over it.
+  The generator macros (CTAB_POPCOUNT8 and friends) use their argument many times,
+  so they are meant for constants, not for expressions with side effects.
+- A CRC-32 table entry is linear over GF(2) in its index: entry(i) is the XOR of
+  entry(1 << j) for the set bits j of i. The eight single-bit entries are written
+  out and _Static_assert checks each against eight shift-and-xor steps of the
+  polynomial, so the 256-entry table costs 8 XOR terms per entry to generate.
+- Factorials are a product of ((n) >= i ? i : 1) terms, and binomials are
+  n! / (k! (n - k)!) from those. The binomial table therefore stops at n = 20,
+  the last factorial that fits 64 bits. Above it, ctab_binomial_u64 runs the
+  exact multiplicative loop in 128 bits.
+- _Static_assert pins known values (CRC-32 of bit patterns, 20!, C(20, 10)), so a
+  broken generator fails the build instead of giving wrong answers.
+- A table lookup is one load when the table is in L1. The byte tables are 256
+  bytes, the CRC table 1 KiB, the binomials 3.4 KiB. Once other data evicts them,
+  each lookup can cost a cache miss, which is more than computing the value:
+  popcnt, lzcnt and a few shifts are cheaper than a miss. BitwiseOperators.c
+  measures both.
+- Requires C11 (_Static_assert); the binomial loop uses unsigned __int128 (GCC, Clang).
+*/
+
+#ifndef CONST_TABLES_H
+#define CONST_TABLES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+// ---------------------------------------------------------------------------
+// Generators
+// ---------------------------------------------------------------------------
+
+#define CTAB_R4_(F, n) F(n), F(n + 1), F(n + 2), F(n + 3)
+#define CTAB_R16_(F, n) CTAB_R4_(F, n), CTAB_R4_(F, n + 4), CTAB_R4_(F, n + 8), CTAB_R4_(F, n + 12)
+#define CTAB_R64_(F, n) CTAB_R16_(F, n), CTAB_R16_(F, n + 16), CTAB_R16_(F, n + 32), CTAB_R16_(F, n + 48)
+#define CTAB_R256_(F) CTAB_R64_(F, 0), CTAB_R64_(F, 64), CTAB_R64_(F, 128), CTAB_R64_(F, 192)
+
+#define CTAB_BIT_(x, j) (((x) >> (j)) & 1u)
+
+#define CTAB_POPCOUNT8(x)                                                                   \
+    (CTAB_BIT_(x, 0) + CTAB_BIT_(x, 1) + CTAB_BIT_(x, 2) + CTAB_BIT_(x, 3) + CTAB_BIT_(x, 4) + \
+     CTAB_BIT_(x, 5) + CTAB_BIT_(x, 6) + CTAB_BIT_(x, 7))
+
+#define CTAB_REVERSE8(x)                                                                    \
+    (CTAB_BIT_(x, 0) << 7 | CTAB_BIT_(x, 1) << 6 | CTAB_BIT_(x, 2) << 5 | CTAB_BIT_(x, 3) << 4 | \
+     CTAB_BIT_(x, 4) << 3 | CTAB_BIT_(x, 5) << 2 | CTAB_BIT_(x, 6) << 1 | CTAB_BIT_(x, 7))
+
+#define CTAB_LOG2_8(x)                                                                          \
+    ((x) >= 128 ? 7 : (x) >= 64 ? 6 : (x) >= 32 ? 5 : (x) >= 16 ? 4 : (x) >= 8 ? 3 : (x) >= 4 ? 2 \
+     : (x) >= 2 ? 1 : (x) >= 1 ? 0 : -1)
+
+// Reflected CRC-32, polynomial 0x04C11DB7 (0xEDB88320 bit-reversed)
+#define CTAB_CRC32_POLY 0xEDB88320u
+#define CTAB_CRC32_STEP_(c) (((c) >> 1) ^ (CTAB_CRC32_POLY & (0u - ((c) & 1u))))
+#define CTAB_CRC32_STEP8_(c)                                                                 \
+    CTAB_CRC32_STEP_(CTAB_CRC32_STEP_(CTAB_CRC32_STEP_(CTAB_CRC32_STEP_(                     \
+        CTAB_CRC32_STEP_(CTAB_CRC32_STEP_(CTAB_CRC32_STEP_(CTAB_CRC32_STEP_(c))))))))
+
+#define CTAB_CRC32_B0_ 0x77073096u  // entry(0x01)
+#define CTAB_CRC32_B1_ 0xEE0E612Cu
+#define CTAB_CRC32_B2_ 0x076DC419u
+#define CTAB_CRC32_B3_ 0x0EDB8832u
+#define CTAB_CRC32_B4_ 0x1DB71064u
+#define CTAB_CRC32_B5_ 0x3B6E20C8u
+#define CTAB_CRC32_B6_ 0x76DC4190u
+#define CTAB_CRC32_B7_ 0xEDB88320u  // entry(0x80)
+
+_Static_assert(CTAB_CRC32_B0_ == CTAB_CRC32_STEP8_(0x01u), "CRC-32 entry(0x01)");
+_Static_assert(CTAB_CRC32_B1_ == CTAB_CRC32_STEP8_(0x02u), "CRC-32 entry(0x02)");
+_Static_assert(CTAB_CRC32_B2_ == CTAB_CRC32_STEP8_(0x04u), "CRC-32 entry(0x04)");
+_Static_assert(CTAB_CRC32_B3_ == CTAB_CRC32_STEP8_(0x08u), "CRC-32 entry(0x08)");
+_Static_assert(CTAB_CRC32_B4_ == CTAB_CRC32_STEP8_(0x10u), "CRC-32 entry(0x10)");
+_Static_assert(CTAB_CRC32_B5_ == CTAB_CRC32_STEP8_(0x20u), "CRC-32 entry(0x20)");
+_Static_assert(CTAB_CRC32_B6_ == CTAB_CRC32_STEP8_(0x40u), "CRC-32 entry(0x40)");
+_Static_assert(CTAB_CRC32_B7_ == CTAB_CRC32_STEP8_(0x80u), "CRC-32 entry(0x80)");
+
+#define CTAB_CRC32_TERM_(x, j) ((0u - CTAB_BIT_(x, j)) & CTAB_CRC32_B##j##_)
+#define CTAB_CRC32_ENTRY(x)                                                                     \
+    (CTAB_CRC32_TERM_(x, 0) ^ CTAB_CRC32_TERM_(x, 1) ^ CTAB_CRC32_TERM_(x, 2) ^ CTAB_CRC32_TERM_(x, 3) ^ \
+     CTAB_CRC32_TERM_(x, 4) ^ CTAB_CRC32_TERM_(x, 5) ^ CTAB_CRC32_TERM_(x, 6) ^ CTAB_CRC32_TERM_(x, 7))
+
+_Static_assert(CTAB_CRC32_ENTRY(0xFFu) == CTAB_CRC32_STEP8_(0xFFu), "CRC-32 linearity");
+_Static_assert(CTAB_CRC32_ENTRY(0x5Au) == CTAB_CRC32_STEP8_(0x5Au), "CRC-32 linearity");
+
+#define CTAB_FACTORIAL_MAX 20   // 20! < 2^64 < 21!
+#define CTAB_BINOMIAL_MAX_N 20  // Table range; ctab_binomial_u64 computes the rest
+
+#define CTAB_F_(n, i) ((n) >= (i) ? (uint64_t)(i) : 1)
+#define CTAB_FACTORIAL(n)                                                                          \
+    (CTAB_F_(n, 2) * CTAB_F_(n, 3) * CTAB_F_(n, 4) * CTAB_F_(n, 5) * CTAB_F_(n, 6) * CTAB_F_(n, 7) *  \
+     CTAB_F_(n, 8) * CTAB_F_(n, 9) * CTAB_F_(n, 10) * CTAB_F_(n, 11) * CTAB_F_(n, 12) * CTAB_F_(n, 13) * \
+     CTAB_F_(n, 14) * CTAB_F_(n, 15) * CTAB_F_(n, 16) * CTAB_F_(n, 17) * CTAB_F_(n, 18) *            \
+     CTAB_F_(n, 19) * CTAB_F_(n, 20))
+
+// n!, k! and (n - k)! all fit 64 bits for n <= 20
+#define CTAB_BINOMIAL(n, k) ((k) > (n) ? (uint64_t)0 : CTAB_FACTORIAL(n) / (CTAB_FACTORIAL(k) * CTAB_FACTORIAL((n) - (k))))
+
+_Static_assert(CTAB_FACTORIAL(20) == 2432902008176640000ull, "20!");
+_Static_assert(CTAB_FACTORIAL(20) > UINT64_MAX / 21, "21! does not fit in 64 bits");
+_Static_assert(CTAB_BINOMIAL(20, 10) == 184756 && CTAB_BINOMIAL(20, 13) == 77520, "C(20, 10), C(20, 13)");
+_Static_assert(CTAB_BINOMIAL(10, 3) == 120 && CTAB_BINOMIAL(3, 10) == 0, "C(10, 3), C(3, 10)");
+
+// ---------------------------------------------------------------------------
+// Tables
+// ---------------------------------------------------------------------------
+
+#define CTAB_LOG2_ENTRY_(x) (int8_t)CTAB_LOG2_8(x)
+
+static const uint8_t ctab_popcount8[256] = {CTAB_R256_(CTAB_POPCOUNT8)};
+static const uint8_t ctab_reverse8[256] = {CTAB_R256_(CTAB_REVERSE8)};
+static const int8_t ctab_log2_8[256] = {CTAB_R256_(CTAB_LOG2_ENTRY_)};
+static const uint32_t ctab_crc32_table[256] = {CTAB_R256_(CTAB_CRC32_ENTRY)};
+
+static const uint64_t ctab_factorial_table[CTAB_FACTORIAL_MAX + 1] = {
+    CTAB_R16_(CTAB_FACTORIAL, 0), CTAB_R4_(CTAB_FACTORIAL, 16), CTAB_FACTORIAL(20)};
+
+#define CTAB_BINOMIAL_ROW_(n)                                                                          \
+    {CTAB_BINOMIAL(n, 0),  CTAB_BINOMIAL(n, 1),  CTAB_BINOMIAL(n, 2),  CTAB_BINOMIAL(n, 3),  CTAB_BINOMIAL(n, 4),  \
+     CTAB_BINOMIAL(n, 5),  CTAB_BINOMIAL(n, 6),  CTAB_BINOMIAL(n, 7),  CTAB_BINOMIAL(n, 8),  CTAB_BINOMIAL(n, 9),  \
+     CTAB_BINOMIAL(n, 10), CTAB_BINOMIAL(n, 11), CTAB_BINOMIAL(n, 12), CTAB_BINOMIAL(n, 13), CTAB_BINOMIAL(n, 14), \
+     CTAB_BINOMIAL(n, 15), CTAB_BINOMIAL(n, 16), CTAB_BINOMIAL(n, 17), CTAB_BINOMIAL(n, 18), CTAB_BINOMIAL(n, 19), \
+     CTAB_BINOMIAL(n, 20)}
+
+// ctab_binomial_table[n][k] = C(n, k), 0 for k > n
+static const uint64_t ctab_binomial_table[CTAB_BINOMIAL_MAX_N + 1][CTAB_BINOMIAL_MAX_N + 1] = {
+    CTAB_BINOMIAL_ROW_(0), CTAB_BINOMIAL_ROW_(1), CTAB_BINOMIAL_ROW_(2), CTAB_BINOMIAL_ROW_(3), CTAB_BINOMIAL_ROW_(4),
+    CTAB_BINOMIAL_ROW_(5), CTAB_BINOMIAL_ROW_(6), CTAB_BINOMIAL_ROW_(7), CTAB_BINOMIAL_ROW_(8), CTAB_BINOMIAL_ROW_(9),
+    CTAB_BINOMIAL_ROW_(10), CTAB_BINOMIAL_ROW_(11), CTAB_BINOMIAL_ROW_(12), CTAB_BINOMIAL_ROW_(13), CTAB_BINOMIAL_ROW_(14),
+    CTAB_BINOMIAL_ROW_(15), CTAB_BINOMIAL_ROW_(16), CTAB_BINOMIAL_ROW_(17), CTAB_BINOMIAL_ROW_(18), CTAB_BINOMIAL_ROW_(19),
+    CTAB_BINOMIAL_ROW_(20)};
+
+// ---------------------------------------------------------------------------
+// Lookups
+// ---------------------------------------------------------------------------
+
+static inline unsigned ctab_popcount_u32(uint32_t x) {
+    return ctab_popcount8[x & 0xFF] + ctab_popcount8[(x >> 8) & 0xFF] + ctab_popcount8[(x >> 16) & 0xFF] +
+           ctab_popcount8[x >> 24];
+}
+
+static inline unsigned ctab_popcount_u64(uint64_t x) {
+    return ctab_popcount_u32((uint32_t)x) + ctab_popcount_u32((uint32_t)(x >> 32));
+}
+
+static inline uint32_t ctab_reverse_u32(uint32_t x) {
+    return (uint32_t)ctab_reverse8[x & 0xFF] << 24 | (uint32_t)ctab_reverse8[(x >> 8) & 0xFF] << 16 |
+           (uint32_t)ctab_reverse8[(x >> 16) & 0xFF] << 8 | ctab_reverse8[x >> 24];
+}
+
+// floor(log2(x)), -1 for 0
+static inline int ctab_log2_u32(uint32_t x) {
+    if (x >> 16) return (x >> 24) ? 24 + ctab_log2_8[x >> 24] : 16 + ctab_log2_8[x >> 16];
+    return (x >> 8) ? 8 + ctab_log2_8[x >> 8] : ctab_log2_8[x];
+}
+
+// Sarwate's byte-at-a-time CRC; 'crc' is a previous result, or 0 to start
+static inline uint32_t ctab_crc32_update(uint32_t crc, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = ctab_crc32_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static inline uint32_t ctab_crc32(const void* data, size_t len) { return ctab_crc32_update(0, data, len); }
+
+static inline int ctab_factorial_u64(unsigned n, uint64_t* out) {
+    if (n > CTAB_FACTORIAL_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    *out = ctab_factorial_table[n];
+    return 0;
+}
+
+// C(n, k); above the table, r = C(n - k + i, i) is built for i = 1..k, each step exact
+static inline int ctab_binomial_u64(unsigned n, unsigned k, uint64_t* out) {
+    if (k > n) {
+        *out = 0;
+        return 0;
+    }
+    if (n <= CTAB_BINOMIAL_MAX_N) {
+        *out = ctab_binomial_table[n][k];
+        return 0;
+    }
+    if (k > n - k) k = n - k;
+    unsigned __int128 r = 1;
+    for (unsigned i = 1; i <= k; i++) {
+        r = r * (n - k + i) / i;
+        if (r > UINT64_MAX) {
+            errno = ERANGE;
+            return -1;
+        }
+    }
+    *out = (uint64_t)r;
+    return 0;
+}
+
+#endif  // CONST_TABLES_H
@@ -0,0 +1,522 @@
+/*
+popcount_simd.h - Bulk Popcount and Bitset Kernels with Runtime CPU Dispatch
+================================================
+
+Header-only kernels that work on whole arrays of 64-bit words instead of one
+integer at a time:
+
+    popcount_array(words, n)            set bits in words[0..n)
+    popcount_and_array(a, b, n)         popcount(a & b), no temporary bitset needed
+    popcount_or_array(a, b, n)          popcount(a | b)
+    popcount_xor_array(a, b, n)         popcount(a ^ b), i.e. the Hamming distance
+    find_first_set_array(words, n)      index of the lowest set bit, or POPCOUNT_NOT_FOUND
+
+Every kernel exists in several variants:
+
+    scalar      portable 64-bit SWAR, no special instructions
+    popcnt      hardware POPCNT (SSE4.2 era), four independent accumulators
+    avx2        Harley-Seal carry-save adders over 16 vectors, nibble LUT (vpshufb) per vector
+    avx512bw    nibble LUT on 512-bit vectors, masked loads for the tail
+    avx512      VPOPCNTDQ: one instruction per 8 words, masked loads for the tail
+    neon        vcnt + pairwise widening adds (AArch64)
+
+The x86 variants are compiled with __attribute__((target(...))), so the file
+builds with plain -O2 and no -m flags; the best variant the CPU (and OS, for the
+AVX state) supports is picked once at startup with CPUID via
+__builtin_cpu_supports() and called through a function-pointer table.
+
+Usage:
+    uint64_t hits = popcount_and_array(index_a, index_b, words);
+    printf("using %s kernels\n", popcount_kernels()->name);
+
+    // Benchmarks and tests can ask for a specific variant (NULL if unavailable):
+    const PopcountKernels* k = popcount_kernels_for(POPCOUNT_AVX2);
+
+Setting POPCOUNT_VARIANT=<name> in the environment overrides the automatic choice,
+which is handy for checking a slower path on a fast machine.
+
+Compile with: gcc -O2 file.c   (GCC 8+ or Clang 7+)
+*/
+
+#ifndef POPCOUNT_SIMD_H
+#define POPCOUNT_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define POPCOUNT_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define POPCOUNT_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define POPCOUNT_NOT_FOUND ((size_t)-1)
+
+typedef enum {
+    POPCOUNT_SCALAR,
+    POPCOUNT_POPCNT,
+    POPCOUNT_AVX2,
+    POPCOUNT_AVX512BW,
+    POPCOUNT_AVX512,
+    POPCOUNT_NEON,
+    POPCOUNT_VARIANT_COUNT
+} PopcountVariant;
+
+typedef struct {
+    const char* name;
+    uint64_t (*count)(const uint64_t* words, size_t n);
+    uint64_t (*and_count)(const uint64_t* a, const uint64_t* b, size_t n);
+    uint64_t (*or_count)(const uint64_t* a, const uint64_t* b, size_t n);
+    uint64_t (*xor_count)(const uint64_t* a, const uint64_t* b, size_t n);
+    size_t (*find_first_set)(const uint64_t* words, size_t n);
+} PopcountKernels;
+
+// How the two inputs are combined before counting. Every kernel is written once
+// against this and instantiated per operation; the switch folds away after inlining.
+enum { POPCOUNT_OP_NONE, POPCOUNT_OP_AND, POPCOUNT_OP_OR, POPCOUNT_OP_XOR };
+
+static inline uint64_t popcount_combine_(uint64_t a, uint64_t b, int op) {
+    switch (op) {
+        case POPCOUNT_OP_AND: return a & b;
+        case POPCOUNT_OP_OR: return a | b;
+        case POPCOUNT_OP_XOR: return a ^ b;
+        default: return a;
+    }
+}
+
+// Instantiate the four counting entry points of one variant from its generic
+// 'prefix##_op_(a, b, n, op)' implementation.
+#define POPCOUNT_DEFINE_OPS_(prefix, attr)                                                  \
+    static attr uint64_t prefix##_count_(const uint64_t* w, size_t n) {                     \
+        return prefix##_op_(w, w, n, POPCOUNT_OP_NONE);                                     \
+    }                                                                                       \
+    static attr uint64_t prefix##_and_(const uint64_t* a, const uint64_t* b, size_t n) {    \
+        return prefix##_op_(a, b, n, POPCOUNT_OP_AND);                                      \
+    }                                                                                       \
+    static attr uint64_t prefix##_or_(const uint64_t* a, const uint64_t* b, size_t n) {     \
+        return prefix##_op_(a, b, n, POPCOUNT_OP_OR);                                       \
+    }                                                                                       \
+    static attr uint64_t prefix##_xor_(const uint64_t* a, const uint64_t* b, size_t n) {    \
+        return prefix##_op_(a, b, n, POPCOUNT_OP_XOR);                                      \
+    }
+
+#define POPCOUNT_NO_ATTR_
+
+// ---------------------------------------------------------------------------
+// Scalar: 64-bit SWAR, the same trick as popcount_optimized() widened to a word
+// ---------------------------------------------------------------------------
+
+static inline uint64_t popcount_swar64_(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+static inline uint64_t popcount_scalar_op_(const uint64_t* a, const uint64_t* b, size_t n, int op) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += popcount_swar64_(popcount_combine_(a[i], b[i], op));
+    }
+    return total;
+}
+
+POPCOUNT_DEFINE_OPS_(popcount_scalar, POPCOUNT_NO_ATTR_)
+
+static size_t popcount_scalar_ffs_(const uint64_t* w, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (w[i]) return i * 64 + (size_t)__builtin_ctzll(w[i]);
+    }
+    return POPCOUNT_NOT_FOUND;
+}
+
+// ---------------------------------------------------------------------------
+// x86 variants
+// ---------------------------------------------------------------------------
+
+#ifdef POPCOUNT_HAVE_X86
+
+#define POPCOUNT_TARGET_POPCNT_ __attribute__((target("popcnt")))
+#define POPCOUNT_TARGET_AVX2_ __attribute__((target("avx2,popcnt")))
+#define POPCOUNT_TARGET_AVX512BW_ __attribute__((target("avx512f,avx512bw,popcnt")))
+#define POPCOUNT_TARGET_AVX512_ __attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+
+// POPCNT: four accumulators so consecutive popcnt instructions do not serialise
+// on one register (older Intel cores also carry a false dependency on the output).
+static inline POPCOUNT_TARGET_POPCNT_ uint64_t
+popcount_popcnt_op_(const uint64_t* a, const uint64_t* b, size_t n, int op) {
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += (uint64_t)__builtin_popcountll(popcount_combine_(a[i], b[i], op));
+        c1 += (uint64_t)__builtin_popcountll(popcount_combine_(a[i + 1], b[i + 1], op));
+        c2 += (uint64_t)__builtin_popcountll(popcount_combine_(a[i + 2], b[i + 2], op));
+        c3 += (uint64_t)__builtin_popcountll(popcount_combine_(a[i + 3], b[i + 3], op));
+    }
+    for (; i < n; i++) {
+        c0 += (uint64_t)__builtin_popcountll(popcount_combine_(a[i], b[i], op));
+    }
+    return c0 + c1 + c2 + c3;
+}
+
+POPCOUNT_DEFINE_OPS_(popcount_popcnt, POPCOUNT_TARGET_POPCNT_)
+
+// ----- AVX2 -----
+
+static inline POPCOUNT_TARGET_AVX2_ __m256i
+popcount_avx2_load_(const uint64_t* a, const uint64_t* b, size_t i, int op) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+    if (op == POPCOUNT_OP_NONE) return x;
+    __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+    if (op == POPCOUNT_OP_AND) return _mm256_and_si256(x, y);
+    if (op == POPCOUNT_OP_OR) return _mm256_or_si256(x, y);
+    return _mm256_xor_si256(x, y);
+}
+
+// Nibble lookup table (Mula): vpshufb counts each 4-bit half, vpsadbw sums the
+// bytes into four 64-bit lanes.
+static inline POPCOUNT_TARGET_AVX2_ __m256i popcount_avx2_vector_(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+// Carry-save adder: h:l = a + b + c, bit-sliced across the vector.
+#define POPCOUNT_CSA_(h, l, a, b, c)                      \
+    do {                                                  \
+        __m256i u_ = _mm256_xor_si256((a), (b));          \
+        (h) = _mm256_or_si256(_mm256_and_si256((a), (b)), \
+                              _mm256_and_si256(u_, (c))); \
+        (l) = _mm256_xor_si256(u_, (c));                  \
+    } while (0)
+
+// Harley-Seal: 16 input vectors are reduced through a tree of carry-save adders
+// so only one in sixteen needs a real population count.
+static inline POPCOUNT_TARGET_AVX2_ uint64_t
+popcount_avx2_op_(const uint64_t* a, const uint64_t* b, size_t n, int op) {
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256(), twos = ones, fours = ones, eights = ones, sixteens;
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+    size_t i = 0;
+
+    for (; i + 64 <= n; i += 64) {
+#define POPCOUNT_V_(k) popcount_avx2_load_(a, b, i + 4 * (k), op)
+        POPCOUNT_CSA_(twos_a, ones, ones, POPCOUNT_V_(0), POPCOUNT_V_(1));
+        POPCOUNT_CSA_(twos_b, ones, ones, POPCOUNT_V_(2), POPCOUNT_V_(3));
+        POPCOUNT_CSA_(fours_a, twos, twos, twos_a, twos_b);
+        POPCOUNT_CSA_(twos_a, ones, ones, POPCOUNT_V_(4), POPCOUNT_V_(5));
+        POPCOUNT_CSA_(twos_b, ones, ones, POPCOUNT_V_(6), POPCOUNT_V_(7));
+        POPCOUNT_CSA_(fours_b, twos, twos, twos_a, twos_b);
+        POPCOUNT_CSA_(eights_a, fours, fours, fours_a, fours_b);
+        POPCOUNT_CSA_(twos_a, ones, ones, POPCOUNT_V_(8), POPCOUNT_V_(9));
+        POPCOUNT_CSA_(twos_b, ones, ones, POPCOUNT_V_(10), POPCOUNT_V_(11));
+        POPCOUNT_CSA_(fours_a, twos, twos, twos_a, twos_b);
+        POPCOUNT_CSA_(twos_a, ones, ones, POPCOUNT_V_(12), POPCOUNT_V_(13));
+        POPCOUNT_CSA_(twos_b, ones, ones, POPCOUNT_V_(14), POPCOUNT_V_(15));
+        POPCOUNT_CSA_(fours_b, twos, twos, twos_a, twos_b);
+        POPCOUNT_CSA_(eights_b, fours, fours, fours_a, fours_b);
+        POPCOUNT_CSA_(sixteens, eights, eights, eights_a, eights_b);
+#undef POPCOUNT_V_
+        total = _mm256_add_epi64(total, popcount_avx2_vector_(sixteens));
+    }
+
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2_vector_(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2_vector_(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2_vector_(twos), 1));
+    total = _mm256_add_epi64(total, popcount_avx2_vector_(ones));
+
+    for (; i + 4 <= n; i += 4) {
+        total = _mm256_add_epi64(total, popcount_avx2_vector_(popcount_avx2_load_(a, b, i, op)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    uint64_t result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++) {
+        result += (uint64_t)__builtin_popcountll(popcount_combine_(a[i], b[i], op));
+    }
+    return result;
+}
+
+#undef POPCOUNT_CSA_
+
+POPCOUNT_DEFINE_OPS_(popcount_avx2, POPCOUNT_TARGET_AVX2_)
+
+// Skip zero words 16 at a time; vptest sets ZF without leaving the vector unit.
+static POPCOUNT_TARGET_AVX2_ size_t popcount_avx2_ffs_(const uint64_t* w, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_or_si256(
+            _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(w + i)),
+                            _mm256_loadu_si256((const __m256i*)(w + i + 4))),
+            _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(w + i + 8)),
+                            _mm256_loadu_si256((const __m256i*)(w + i + 12))));
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    size_t found = popcount_scalar_ffs_(w + i, n - i);
+    return found == POPCOUNT_NOT_FOUND ? found : found + i * 64;
+}
+
+// ----- AVX-512 (shared pieces) -----
+
+static inline POPCOUNT_TARGET_AVX512BW_ __m512i
+popcount_avx512_load_(const uint64_t* a, const uint64_t* b, size_t i, __mmask8 mask, int op) {
+    __m512i x = _mm512_maskz_loadu_epi64(mask, a + i);
+    if (op == POPCOUNT_OP_NONE) return x;
+    __m512i y = _mm512_maskz_loadu_epi64(mask, b + i);
+    if (op == POPCOUNT_OP_AND) return _mm512_and_si512(x, y);
+    if (op == POPCOUNT_OP_OR) return _mm512_or_si512(x, y);
+    return _mm512_xor_si512(x, y);
+}
+
+static inline POPCOUNT_TARGET_AVX512BW_ __m512i popcount_avx512bw_vector_(__m512i v) {
+    const __m512i lookup = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+    const __m512i low_mask = _mm512_set1_epi8(0x0F);
+    __m512i lo = _mm512_and_si512(v, low_mask);
+    __m512i hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), low_mask);
+    __m512i bytes = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, lo), _mm512_shuffle_epi8(lookup, hi));
+    return _mm512_sad_epu8(bytes, _mm512_setzero_si512());
+}
+
+// The tail is handled with a masked load, so there is no scalar clean-up loop.
+static inline POPCOUNT_TARGET_AVX512BW_ uint64_t
+popcount_avx512bw_op_(const uint64_t* a, const uint64_t* b, size_t n, int op) {
+    __m512i t0 = _mm512_setzero_si512(), t1 = t0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        t0 = _mm512_add_epi64(t0, popcount_avx512bw_vector_(popcount_avx512_load_(a, b, i, 0xFF, op)));
+        t1 = _mm512_add_epi64(t1, popcount_avx512bw_vector_(popcount_avx512_load_(a, b, i + 8, 0xFF, op)));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        t0 = _mm512_add_epi64(t0, popcount_avx512bw_vector_(popcount_avx512_load_(a, b, i, mask, op)));
+    }
+    return (uint64_t)_mm512_reduce_add_epi64(_mm512_add_epi64(t0, t1));
+}
+
+POPCOUNT_DEFINE_OPS_(popcount_avx512bw, POPCOUNT_TARGET_AVX512BW_)
+
+// Skip zero words 32 at a time, then vptestmq yields one mask bit per non-zero
+// word; its lowest set bit is the word.
+static POPCOUNT_TARGET_AVX512BW_ size_t popcount_avx512_ffs_(const uint64_t* w, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i v = _mm512_or_si512(
+            _mm512_or_si512(_mm512_loadu_si512((const void*)(w + i)),
+                            _mm512_loadu_si512((const void*)(w + i + 8))),
+            _mm512_or_si512(_mm512_loadu_si512((const void*)(w + i + 16)),
+                            _mm512_loadu_si512((const void*)(w + i + 24))));
+        if (_mm512_test_epi64_mask(v, v)) break;
+    }
+    for (; i < n; i += 8) {
+        __mmask8 load = n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi64(load, w + i);
+        __mmask8 nonzero = _mm512_test_epi64_mask(v, v);
+        if (nonzero) {
+            size_t word = i + (size_t)__builtin_ctz(nonzero);
+            return word * 64 + (size_t)__builtin_ctzll(w[word]);
+        }
+    }
+    return POPCOUNT_NOT_FOUND;
+}
+
+// ----- AVX-512 VPOPCNTDQ -----
+
+static inline POPCOUNT_TARGET_AVX512_ uint64_t
+popcount_avx512_op_(const uint64_t* a, const uint64_t* b, size_t n, int op) {
+    __m512i t0 = _mm512_setzero_si512(), t1 = t0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512((const void*)(a + i));
+        __m512i y = _mm512_loadu_si512((const void*)(a + i + 8));
+        if (op != POPCOUNT_OP_NONE) {
+            __m512i p = _mm512_loadu_si512((const void*)(b + i));
+            __m512i q = _mm512_loadu_si512((const void*)(b + i + 8));
+            if (op == POPCOUNT_OP_AND) { x = _mm512_and_si512(x, p); y = _mm512_and_si512(y, q); }
+            else if (op == POPCOUNT_OP_OR) { x = _mm512_or_si512(x, p); y = _mm512_or_si512(y, q); }
+            else { x = _mm512_xor_si512(x, p); y = _mm512_xor_si512(y, q); }
+        }
+        t0 = _mm512_add_epi64(t0, _mm512_popcnt_epi64(x));
+        t1 = _mm512_add_epi64(t1, _mm512_popcnt_epi64(y));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512i x = _mm512_maskz_loadu_epi64(mask, a + i);
+        if (op != POPCOUNT_OP_NONE) {
+            __m512i p = _mm512_maskz_loadu_epi64(mask, b + i);
+            if (op == POPCOUNT_OP_AND) x = _mm512_and_si512(x, p);
+            else if (op == POPCOUNT_OP_OR) x = _mm512_or_si512(x, p);
+            else x = _mm512_xor_si512(x, p);
+        }
+        t0 = _mm512_add_epi64(t0, _mm512_popcnt_epi64(x));
+    }
+    return (uint64_t)_mm512_reduce_add_epi64(_mm512_add_epi64(t0, t1));
+}
+
+POPCOUNT_DEFINE_OPS_(popcount_avx512, POPCOUNT_TARGET_AVX512_)
+
+#endif // POPCOUNT_HAVE_X86
+
+// ---------------------------------------------------------------------------
+// NEON (AArch64 and 32-bit ARMv7): vcnt counts bits per byte; the byte counts are accumulated for
+// up to 31 vectors (31 * 8 < 256) before being widened into 64-bit lanes.
+// ---------------------------------------------------------------------------
+
+#ifdef POPCOUNT_HAVE_NEON
+
+static inline uint8x16_t popcount_neon_load_(const uint64_t* a, const uint64_t* b, size_t i, int op) {
+    uint8x16_t x = vreinterpretq_u8_u64(vld1q_u64(a + i));
+    if (op == POPCOUNT_OP_NONE) return x;
+    uint8x16_t y = vreinterpretq_u8_u64(vld1q_u64(b + i));
+    if (op == POPCOUNT_OP_AND) return vandq_u8(x, y);
+    if (op == POPCOUNT_OP_OR) return vorrq_u8(x, y);
+    return veorq_u8(x, y);
+}
+
+static inline uint64_t popcount_neon_op_(const uint64_t* a, const uint64_t* b, size_t n, int op) {
+    uint64x2_t total = vdupq_n_u64(0);
+    size_t i = 0;
+    while (i + 2 <= n) {
+        uint8x16_t bytes = vdupq_n_u8(0);
+        for (int k = 0; k < 31 && i + 2 <= n; k++, i += 2) {
+            bytes = vaddq_u8(bytes, vcntq_u8(popcount_neon_load_(a, b, i, op)));
+        }
+        total = vpadalq_u32(total, vpaddlq_u16(vpaddlq_u8(bytes)));
+    }
+    uint64_t result = vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1);
+    for (; i < n; i++) {
+        result += popcount_swar64_(popcount_combine_(a[i], b[i], op));
+    }
+    return result;
+}
+
+POPCOUNT_DEFINE_OPS_(popcount_neon, POPCOUNT_NO_ATTR_)
+
+static size_t popcount_neon_ffs_(const uint64_t* w, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64x2_t v = vorrq_u64(vorrq_u64(vld1q_u64(w + i), vld1q_u64(w + i + 2)),
+                                 vorrq_u64(vld1q_u64(w + i + 4), vld1q_u64(w + i + 6)));
+        // OR the halves rather than vmaxvq_u32, which AArch64 has but ARMv7 does not
+        if (vget_lane_u64(vorr_u64(vget_low_u64(v), vget_high_u64(v)), 0) != 0) break;
+    }
+    size_t found = popcount_scalar_ffs_(w + i, n - i);
+    return found == POPCOUNT_NOT_FOUND ? found : found + i * 64;
+}
+
+#endif // POPCOUNT_HAVE_NEON
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+static const PopcountKernels popcount_kernel_table_[POPCOUNT_VARIANT_COUNT] = {
+    [POPCOUNT_SCALAR] = {"scalar", popcount_scalar_count_, popcount_scalar_and_, popcount_scalar_or_,
+                         popcount_scalar_xor_, popcount_scalar_ffs_},
+#ifdef POPCOUNT_HAVE_X86
+    [POPCOUNT_POPCNT] = {"popcnt", popcount_popcnt_count_, popcount_popcnt_and_, popcount_popcnt_or_,
+                         popcount_popcnt_xor_, popcount_scalar_ffs_},
+    [POPCOUNT_AVX2] = {"avx2", popcount_avx2_count_, popcount_avx2_and_, popcount_avx2_or_,
+                       popcount_avx2_xor_, popcount_avx2_ffs_},
+    [POPCOUNT_AVX512BW] = {"avx512bw", popcount_avx512bw_count_, popcount_avx512bw_and_,
+                           popcount_avx512bw_or_, popcount_avx512bw_xor_, popcount_avx512_ffs_},
+    [POPCOUNT_AVX512] = {"avx512", popcount_avx512_count_, popcount_avx512_and_, popcount_avx512_or_,
+                         popcount_avx512_xor_, popcount_avx512_ffs_},
+#endif
+#ifdef POPCOUNT_HAVE_NEON
+    [POPCOUNT_NEON] = {"neon", popcount_neon_count_, popcount_neon_and_, popcount_neon_or_,
+                       popcount_neon_xor_, popcount_neon_ffs_},
+#endif
+};
+
+// Returns 1 if the variant is compiled in and the running CPU supports it.
+static inline int popcount_variant_supported(PopcountVariant v) {
+    if ((unsigned)v >= POPCOUNT_VARIANT_COUNT || popcount_kernel_table_[v].name == NULL) return 0;
+#ifdef POPCOUNT_HAVE_X86
+    __builtin_cpu_init();
+    switch (v) {
+        case POPCOUNT_POPCNT: return __builtin_cpu_supports("popcnt") != 0;
+        case POPCOUNT_AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+        case POPCOUNT_AVX512BW: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        case POPCOUNT_AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+        default: break;
+    }
+#endif
+    return 1;
+}
+
+static inline const PopcountKernels* popcount_kernels_for(PopcountVariant v) {
+    return popcount_variant_supported(v) ? &popcount_kernel_table_[v] : NULL;
+}
+
+static const PopcountKernels* popcount_active_ = NULL;
+
+static inline const PopcountKernels* popcount_select_(void) {
+    const char* forced = getenv("POPCOUNT_VARIANT");
+    if (forced != NULL) {
+        for (int v = 0; v < POPCOUNT_VARIANT_COUNT; v++) {
+            if (popcount_variant_supported((PopcountVariant)v) &&
+                strcmp(popcount_kernel_table_[v].name, forced) == 0) {
+                return &popcount_kernel_table_[v];
+            }
+        }
+    }
+    // Table order is slowest to fastest: take the last one the CPU can run
+    for (int v = POPCOUNT_VARIANT_COUNT - 1; v > POPCOUNT_SCALAR; v--) {
+        if (popcount_variant_supported((PopcountVariant)v)) return &popcount_kernel_table_[v];
+    }
+    return &popcount_kernel_table_[POPCOUNT_SCALAR];
+}
+
+// Resolve the dispatch table before main() so the hot path is a plain indirect call
+__attribute__((constructor)) static void popcount_dispatch_init_(void) {
+    __atomic_store_n(&popcount_active_, popcount_select_(), __ATOMIC_RELEASE);
+}
+
+static inline const PopcountKernels* popcount_kernels(void) {
+    const PopcountKernels* k = __atomic_load_n(&popcount_active_, __ATOMIC_ACQUIRE);
+    if (k == NULL) {
+        // Only reachable from another constructor that runs before ours
+        k = popcount_select_();
+        __atomic_store_n(&popcount_active_, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+static inline uint64_t popcount_array(const uint64_t* words, size_t n) {
+    return popcount_kernels()->count(words, n);
+}
+
+static inline uint64_t popcount_and_array(const uint64_t* a, const uint64_t* b, size_t n) {
+    return popcount_kernels()->and_count(a, b, n);
+}
+
+static inline uint64_t popcount_or_array(const uint64_t* a, const uint64_t* b, size_t n) {
+    return popcount_kernels()->or_count(a, b, n);
+}
+
+static inline uint64_t popcount_xor_array(const uint64_t* a, const uint64_t* b, size_t n) {
+    return popcount_kernels()->xor_count(a, b, n);
+}
+
+// Bit index of the lowest set bit across the array, or POPCOUNT_NOT_FOUND.
+static inline size_t find_first_set_array(const uint64_t* words, size_t n) {
+    return popcount_kernels()->find_first_set(words, n);
+}
+
+#undef POPCOUNT_NO_ATTR_
+
+#endif // POPCOUNT_SIMD_H
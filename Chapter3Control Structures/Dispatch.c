@@ -0,0 +1,656 @@
+/*
+Cheat Sheet: Jump Tables, Perfect Hashing and Threaded Dispatch in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+switchCase.c ends with the advice to "consider using lookup tables for large sets
+of values". This file follows that advice for a protocol decoder or interpreter,
+where every message or instruction is dispatched on an opcode:
+
+- A dense jump table: an array of handler pointers indexed by the opcode,
+  generated at compile time from one X-macro list.
+- A minimal perfect hash: for sparse integer IDs or string command names, a
+  hash function built at startup that maps each known key to its own slot
+  0..n-1, with no collisions to resolve.
+- Threaded dispatch: computed goto ("labels as values"), so that every handler
+  ends in its own indirect jump to the next handler.
+
+A switch is compiled as one of three things. Dense case values become a jump
+table. Sparse values become a binary tree of compares (about log2(n) branches,
+each one hard to predict). Very small switches become a run of compares, like
+an if-else chain. The if-else chain itself tests each case in turn.
+
+Historical context:
+- FORTRAN's computed GOTO (1957) was the first indexed jump. James Bell
+  described threaded code in 1973, and Forth was built on it.
+- GCC added labels as values (&&label, goto *p) in the early 1990s. CPython's
+  eval loop has used it since 3.1, and so do Ruby's YARV and many bytecode VMs.
+- gperf (Schmidt, 1990) generates perfect hashes for keyword tables. "Hash,
+  displace and compress" (Belazzougui, Botelho and Dietzfelbinger, 2009) builds
+  minimal perfect hashes for millions of keys in linear time.
+
+The implementation lives in dispatch.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "dispatch.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// Function prototypes
+void jump_table_example();
+void sparse_integer_example();
+void string_command_example();
+void threaded_interpreter_example();
+void performance_comparison();
+
+int main() {
+    printf("Dispatch Techniques Cheat Sheet\n");
+    printf("===============================\n\n");
+
+    jump_table_example();
+    sparse_integer_example();
+    string_command_example();
+    threaded_interpreter_example();
+    performance_comparison();
+
+    return 0;
+}
+
+// 2.1 An X-macro list is the single source of truth: enum, table and names
+typedef struct {
+    int connected;
+    int value;
+} Session;
+
+typedef void (*CommandHandler)(Session*, int);
+
+#define COMMANDS(X)                          \
+    X(CMD_CONNECT, 0, cmd_connect, "CONNECT") \
+    X(CMD_SET, 1, cmd_set, "SET")             \
+    X(CMD_ADD, 2, cmd_add, "ADD")             \
+    X(CMD_PRINT, 3, cmd_print, "PRINT")       \
+    X(CMD_CLOSE, 5, cmd_close, "CLOSE")
+
+DISPATCH_DEFINE_ENUM(Command, COMMANDS)
+
+static void cmd_connect(Session* s, int arg) {
+    (void)arg;
+    s->connected = 1;
+}
+static void cmd_set(Session* s, int arg) { s->value = arg; }
+static void cmd_add(Session* s, int arg) { s->value += arg; }
+static void cmd_print(Session* s, int arg) {
+    (void)arg;
+    printf("  value = %d (connected: %s)\n", s->value, s->connected ? "yes" : "no");
+}
+static void cmd_close(Session* s, int arg) {
+    (void)arg;
+    s->connected = 0;
+}
+static void cmd_unknown(Session* s, int arg) {
+    (void)s;
+    printf("  unknown command (arg %d) ignored\n", arg);
+}
+
+// Opcode 4 is not in the list, so it gets cmd_unknown, like every code up to 15
+DISPATCH_DEFINE_TABLE(command_table, CommandHandler, 16, cmd_unknown, COMMANDS)
+
+#define COMMAND_NAME_ENTRY(name, code, handler, text) [(code)] = text,
+static const char* const command_names[16] = {COMMANDS(COMMAND_NAME_ENTRY)};
+
+void jump_table_example() {
+    printf("2.1 Dense Jump Table from an X-Macro List\n");
+    printf("-----------------------------------------\n");
+
+    const int message[][2] = {{CMD_CONNECT, 0}, {CMD_SET, 40}, {CMD_ADD, 2}, {4, 99}, {CMD_PRINT, 0}, {CMD_CLOSE, 0}};
+    Session session = {0, 0};
+    for (size_t i = 0; i < sizeof(message) / sizeof(message[0]); i++) {
+        int op = message[i][0];
+        const char* name = command_names[op] ? command_names[op] : "?";
+        printf("  op %d (%s)\n", op, name);
+        command_table[op](&session, message[i][1]);  // One indexed load and one call
+    }
+    printf("\n");
+}
+
+// 2.2 Sparse integer IDs: a perfect hash maps them onto 0..n-1
+void sparse_integer_example() {
+    printf("2.2 Perfect Hash over Sparse Integer IDs\n");
+    printf("----------------------------------------\n");
+
+    // Message type IDs from a protocol spec: far too sparse for a table
+    static const uint64_t type_ids[] = {0x0101, 0x0102, 0x2A00, 0x2A01, 0x7F000001, 0xCAFEBABE, 0xDEADBEEF, 42};
+    static const char* const type_names[] = {"HELLO", "HELLO_ACK", "DATA", "DATA_ACK",
+                                             "LOOPBACK", "CLASS", "DEBUG", "ANSWER"};
+    size_t n = sizeof(type_ids) / sizeof(type_ids[0]);
+
+    PerfectHash ph;
+    if (perfect_hash_build_int(&ph, type_ids, n) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    const uint64_t queries[] = {0x2A01, 42, 0xDEADBEEF, 0x0103};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        size_t index = perfect_hash_find_int(&ph, queries[i]);
+        if (index == DISPATCH_NOT_FOUND) {
+            printf("  0x%08llx -> not a known type\n", (unsigned long long)queries[i]);
+        } else {
+            printf("  0x%08llx -> %zu (%s)\n", (unsigned long long)queries[i], index, type_names[index]);
+        }
+    }
+
+    perfect_hash_destroy(&ph);
+
+    uint64_t duplicated[] = {1, 2, 1};
+    if (perfect_hash_build_int(&ph, duplicated, 3) != 0) {
+        printf("  Building from {1, 2, 1} fails: duplicate keys (errno EINVAL)\n");
+    }
+    printf("\n");
+}
+
+// 2.3 String commands, as in text protocols (Redis, SMTP, HTTP methods)
+static int command_count = 0;
+static void on_get(void) { command_count += 1; }
+static void on_set(void) { command_count += 10; }
+static void on_del(void) { command_count += 100; }
+
+void string_command_example() {
+    printf("2.3 Perfect Hash over String Commands\n");
+    printf("-------------------------------------\n");
+
+    static const char* const names[] = {"GET", "SET", "DEL"};
+    static void (*const handlers[])(void) = {on_get, on_set, on_del};  // Same order as names
+
+    PerfectHash ph;
+    if (perfect_hash_build_str(&ph, names, 3) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    // Tokens are found in place in the receive buffer, without copying or NUL-terminating
+    const char* buffer = "GET SET GET DEL FLUSH GET";
+    const char* p = buffer;
+    while (*p) {
+        const char* end = strchr(p, ' ');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        size_t index = perfect_hash_find_str(&ph, p, len);
+        if (index != DISPATCH_NOT_FOUND) {
+            handlers[index]();
+        } else {
+            printf("  unknown command '%.*s'\n", (int)len, p);
+        }
+        p += len + (end != NULL);
+    }
+    printf("  command_count = %d (3 GET, 1 SET, 1 DEL)\n\n", command_count);
+    perfect_hash_destroy(&ph);
+}
+
+// 2.4 A threaded interpreter: each handler jumps straight to the next one
+#define VM_OPCODES(X)           \
+    X(VM_LOAD, 0, "LOAD")       \
+    X(VM_SETN, 1, "SETN")       \
+    X(VM_MULN, 2, "MULN")       \
+    X(VM_DECN, 3, "DECN")       \
+    X(VM_JNZ, 4, "JNZ")         \
+    X(VM_PRINT, 5, "PRINT")     \
+    X(VM_HALT, 6, "HALT")
+
+DISPATCH_DEFINE_ENUM(VmOpcode, VM_OPCODES)
+
+static long long vm_run(const int* code) {
+    DISPATCH_THREADED_TABLE(labels, 8, VM_OPCODES);
+    const int* pc = code;
+    long long acc = 0, n = 0;
+
+    DISPATCH_START(labels, *pc++)
+    DISPATCH_TARGET(VM_LOAD) acc = *pc++;
+    DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_TARGET(VM_SETN) n = *pc++;
+    DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_TARGET(VM_MULN) acc *= n;
+    DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_TARGET(VM_DECN) n--;
+    DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_TARGET(VM_JNZ) pc = n != 0 ? code + *pc : pc + 1;
+    DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_TARGET(VM_PRINT) printf("  acc = %lld\n", acc);
+    DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_TARGET(VM_HALT) return acc;
+    DISPATCH_DEFAULT printf("  illegal opcode %d\n", pc[-1]);
+    return -1;
+    DISPATCH_END
+}
+
+void threaded_interpreter_example() {
+    printf("2.4 Threaded Interpreter\n");
+    printf("------------------------\n");
+
+    // 10!: LOAD 1; SETN 10; loop: MULN; DECN; JNZ loop; PRINT; HALT
+    const int program[] = {VM_LOAD, 1, VM_SETN, 10, VM_MULN, VM_DECN, VM_JNZ, 4, VM_PRINT, VM_HALT};
+    printf("  Dispatch: %s\n", DISPATCH_THREADED_NAME);
+    long long result = vm_run(program);
+    printf("  10! = %lld\n\n", result);
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Keep one X-macro list per opcode set. The enum, the handler table, the name
+   table and the interpreter labels are all generated from it, so they cannot
+   drift apart.
+2. Fill the gaps of a table with a default handler instead of NULL, so a corrupt
+   or hostile opcode costs a call instead of a crash.
+3. Bounds-check opcodes before indexing. A uint8_t opcode with a 256-entry
+   table needs no check at all.
+4. Compare the key after a perfect-hash lookup, as perfect_hash_find_* does. The
+   hash is only perfect for the keys it was built from; any other key lands on
+   some slot too.
+
+Common Pitfalls:
+1. Assuming a switch is always a jump table: sparse case values are compiled
+   into a compare tree, which mispredicts on random input.
+2. Using strcmp chains for commands. Every miss walks the whole chain, and
+   keywords that share a prefix are compared character by character.
+3. goto * is a GNU extension. Keep the switch fallback (DISPATCH_NO_COMPUTED_GOTO)
+   building, or MSVC users lose the interpreter.
+
+Advanced Tips:
+1. Check that a switch really became a jump table by reading the assembly
+   (gcc -S -O2): look for "jmp *" and a .rodata table.
+2. Put the hot handlers next to each other and keep them small. A threaded
+   interpreter is often limited by instruction-cache misses, not by branches.
+3. Rebuilding a perfect hash is cheap (microseconds for hundreds of keys), so it
+   can be done whenever a plugin registers new commands.
+
+4. Integration and Real-World Applications
+==========================================
+- Network protocol decoders: message types, TLV tags, DNS record types.
+- Bytecode virtual machines: CPython, Lua, the JVM interpreter, eBPF.
+- Command-line and text-protocol servers: Redis, memcached, SMTP verbs.
+- Compilers: keyword recognition with gperf-generated perfect hashes.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Tail-call dispatch (Clang's musttail attribute, as used in protobuf's parser and
+  CPython 3.14) gives each handler its own function and lets the optimiser treat
+  each one separately.
+- Superinstructions fuse frequent opcode pairs so the interpreter dispatches fewer
+  times per unit of work.
+- JIT compilers remove dispatch entirely for code that runs often.
+
+6. FAQs and Troubleshooting
+===========================
+Q: Why is the jump table not faster than the switch for dense opcodes?
+A: For dense values the compiler already turned the switch into a jump table.
+   The explicit table is useful because it can be swapped or patched at run
+   time.
+
+Q: perfect_hash_build_* returned -1 with errno EINVAL. Why?
+A: The key set contains duplicates (or is empty). No seed can separate two equal
+   keys.
+
+Q: Why does computed goto help more on some CPUs than others?
+A: Modern predictors (since Haswell) index indirect branches by their history,
+   so even a single switch jump is predicted reasonably well. The gap with
+   threaded code is largest on older or simpler cores.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- GNU gperf: perfect hash generator for fixed keyword sets
+- "Hash, displace, and compress" (Belazzougui, Botelho & Dietzfelbinger, 2009)
+- "The Structure and Performance of Efficient Interpreters" (Ertl & Gregg, 2003)
+- GCC manual: "Labels as Values"
+- Compiler Explorer (godbolt.org) for checking how a switch is lowered
+
+8. Performance Analysis and Optimization
+========================================
+The benchmark decodes a stream of 1M messages. Each is an opcode plus a 32-bit
+argument, and the handler for opcode c folds the argument into an accumulator
+with opcode-specific constants. 192 of the 256 opcodes are defined, generated by
+an X-macro. There are two streams: uniformly random opcodes, which defeat branch
+predictors, and "patterned", a random sequence of 16 fixed message templates of
+12 opcodes each, closer to a real protocol.
+
+- Dense opcodes: an if-else chain, a switch, the jump table and threaded code.
+- Sparse 32-bit IDs: each opcode is scrambled to a 32-bit ID, dispatched by an
+  if-else chain, by a switch (compiled into a compare tree) and by the perfect
+  hash followed by the jump table.
+- String commands: 64K lookups of the 192 names by a strcmp chain and by the
+  perfect hash.
+
+All variants of a suite must produce the same accumulator. GCC can turn an if-else
+chain on constants into a switch ("if-to-switch" conversion), so the dense
+if-else numbers show what the optimiser rescued, not what the source asked for.
+*/
+
+#define DISPATCH_BENCH_N (1u << 20)
+#define STRING_BENCH_N (1u << 16)
+
+// Opcodes 0x00..0xBF: OP_0x00, handle_0x00, ...
+#define PROTO_OP_(X, c) X(OP_##c, c, handle_##c)
+#define PROTO_ROW_(X, h)                                                                        \
+    PROTO_OP_(X, h##0) PROTO_OP_(X, h##1) PROTO_OP_(X, h##2) PROTO_OP_(X, h##3) PROTO_OP_(X, h##4) \
+    PROTO_OP_(X, h##5) PROTO_OP_(X, h##6) PROTO_OP_(X, h##7) PROTO_OP_(X, h##8) PROTO_OP_(X, h##9) \
+    PROTO_OP_(X, h##A) PROTO_OP_(X, h##B) PROTO_OP_(X, h##C) PROTO_OP_(X, h##D) PROTO_OP_(X, h##E) \
+    PROTO_OP_(X, h##F)
+#define PROTOCOL_OPCODES(X)                                                                     \
+    PROTO_ROW_(X, 0x0) PROTO_ROW_(X, 0x1) PROTO_ROW_(X, 0x2) PROTO_ROW_(X, 0x3) PROTO_ROW_(X, 0x4) \
+    PROTO_ROW_(X, 0x5) PROTO_ROW_(X, 0x6) PROTO_ROW_(X, 0x7) PROTO_ROW_(X, 0x8) PROTO_ROW_(X, 0x9) \
+    PROTO_ROW_(X, 0xA) PROTO_ROW_(X, 0xB)
+
+#define PROTO_DEFINED 0xC0
+#define PROTO_END 0xFF  // Undefined opcode used as the end-of-stream marker
+
+DISPATCH_DEFINE_ENUM(ProtocolOpcode, PROTOCOL_OPCODES)
+
+#define PROTO_STEP(acc, arg, code) ((acc) = ((acc) ^ (arg)) * (2u * (code) + 1u) + (code))
+#define SPARSE_ID(code) ((uint32_t)((code) + 1u) * 2654435761u)
+
+typedef struct {
+    uint64_t acc;
+    uint64_t illegal;
+} DecoderState;
+
+typedef void (*ProtocolHandler)(DecoderState*, uint32_t);
+
+#define DEFINE_PROTO_HANDLER(name, code, handler) \
+    static void handler(DecoderState* s, uint32_t arg) { PROTO_STEP(s->acc, arg, code); }
+PROTOCOL_OPCODES(DEFINE_PROTO_HANDLER)
+
+static void handle_illegal(DecoderState* s, uint32_t arg) {
+    (void)arg;
+    s->illegal++;
+}
+
+DISPATCH_DEFINE_TABLE(proto_handlers, ProtocolHandler, 256, handle_illegal, PROTOCOL_OPCODES)
+
+#define PROTO_NAME_ENTRY(name, code, handler) #name,
+static const char* const proto_names[PROTO_DEFINED] = {PROTOCOL_OPCODES(PROTO_NAME_ENTRY)};
+
+typedef enum {
+    DISPATCH_IF_CHAIN, DISPATCH_SWITCH, DISPATCH_JUMP_TABLE, DISPATCH_THREADED,
+    SPARSE_IF_CHAIN, SPARSE_SWITCH, SPARSE_PERFECT_HASH,
+    STRING_STRCMP_CHAIN, STRING_PERFECT_HASH
+} DispatchKind;
+
+typedef struct {
+    DispatchKind kind;
+    size_t n;
+    const uint8_t* ops;    // n opcodes followed by PROTO_END
+    const uint32_t* args;
+    const uint32_t* ids;   // SPARSE_ID(ops[i])
+    const uint32_t* names; // Index into proto_names, for the string suite
+    const PerfectHash* ph;
+    uint64_t result;
+} DispatchBench;
+
+static uint64_t decode_if_chain(const uint8_t* ops, const uint32_t* args, size_t n) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned op = ops[i];
+        uint32_t arg = args[i];
+#define IF_CHAIN_CASE(name, code, handler) if (op == (code)) PROTO_STEP(acc, arg, code); else
+        PROTOCOL_OPCODES(IF_CHAIN_CASE) acc++;
+#undef IF_CHAIN_CASE
+    }
+    return acc;
+}
+
+static uint64_t decode_switch(const uint8_t* ops, const uint32_t* args) {
+    uint64_t acc = 0;
+    size_t i = 0;
+    for (;;) {
+        switch (ops[i++]) {
+#define SWITCH_CASE(name, code, handler) case (code): PROTO_STEP(acc, args[i - 1], code); break;
+            PROTOCOL_OPCODES(SWITCH_CASE)
+#undef SWITCH_CASE
+            default: return acc;
+        }
+    }
+}
+
+static uint64_t decode_jump_table(const uint8_t* ops, const uint32_t* args, size_t n) {
+    DecoderState s = {0, 0};
+    for (size_t i = 0; i < n; i++) proto_handlers[ops[i]](&s, args[i]);
+    return s.acc;
+}
+
+static uint64_t decode_threaded(const uint8_t* ops, const uint32_t* args) {
+    DISPATCH_THREADED_TABLE(labels, 256, PROTOCOL_OPCODES);
+    uint64_t acc = 0;
+    size_t i = 0;
+    DISPATCH_START(labels, ops[i++])
+#define THREADED_CASE(name, code, handler) \
+    DISPATCH_TARGET(name) PROTO_STEP(acc, args[i - 1], code); DISPATCH_NEXT(labels, ops[i++]);
+    PROTOCOL_OPCODES(THREADED_CASE)
+#undef THREADED_CASE
+    DISPATCH_DEFAULT return acc;
+    DISPATCH_END
+}
+
+static uint64_t decode_sparse_if_chain(const uint32_t* ids, const uint32_t* args, size_t n) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t id = ids[i], arg = args[i];
+#define IF_CHAIN_CASE(name, code, handler) if (id == SPARSE_ID(code)) PROTO_STEP(acc, arg, code); else
+        PROTOCOL_OPCODES(IF_CHAIN_CASE) acc++;
+#undef IF_CHAIN_CASE
+    }
+    return acc;
+}
+
+static uint64_t decode_sparse_switch(const uint32_t* ids, const uint32_t* args, size_t n) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t arg = args[i];
+        switch (ids[i]) {
+#define SWITCH_CASE(name, code, handler) case SPARSE_ID(code): PROTO_STEP(acc, arg, code); break;
+            PROTOCOL_OPCODES(SWITCH_CASE)
+#undef SWITCH_CASE
+            default: acc++; break;
+        }
+    }
+    return acc;
+}
+
+static uint64_t decode_sparse_perfect_hash(const PerfectHash* ph, const uint32_t* ids, const uint32_t* args,
+                                           size_t n) {
+    DecoderState s = {0, 0};
+    for (size_t i = 0; i < n; i++) {
+        size_t index = perfect_hash_find_int(ph, ids[i]);
+        if (index != DISPATCH_NOT_FOUND) {
+            proto_handlers[index](&s, args[i]);
+        } else {
+            s.acc++;
+        }
+    }
+    return s.acc;
+}
+
+static uint64_t decode_strcmp_chain(const uint32_t* names, const uint32_t* args, size_t n) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char* s = proto_names[names[i]];
+        BENCH_HIDE_VALUE(s);  // Otherwise the compiler compares the pointers, not the strings
+        uint32_t arg = args[i];
+#define STRCMP_CASE(name, code, handler) if (strcmp(s, #name) == 0) PROTO_STEP(acc, arg, code); else
+        PROTOCOL_OPCODES(STRCMP_CASE) acc++;
+#undef STRCMP_CASE
+    }
+    return acc;
+}
+
+static uint64_t decode_string_perfect_hash(const PerfectHash* ph, const uint32_t* names, const uint32_t* args,
+                                           size_t n) {
+    DecoderState s = {0, 0};
+    for (size_t i = 0; i < n; i++) {
+        const char* name = proto_names[names[i]];
+        size_t index = perfect_hash_find_str(ph, name, strlen(name));
+        if (index != DISPATCH_NOT_FOUND) {
+            proto_handlers[index](&s, args[i]);
+        } else {
+            s.acc++;
+        }
+    }
+    return s.acc;
+}
+
+void dispatch_bench_run(void* ctx) {
+    DispatchBench* b = (DispatchBench*)ctx;
+    switch (b->kind) {
+        case DISPATCH_IF_CHAIN: b->result = decode_if_chain(b->ops, b->args, b->n); break;
+        case DISPATCH_SWITCH: b->result = decode_switch(b->ops, b->args); break;
+        case DISPATCH_JUMP_TABLE: b->result = decode_jump_table(b->ops, b->args, b->n); break;
+        case DISPATCH_THREADED: b->result = decode_threaded(b->ops, b->args); break;
+        case SPARSE_IF_CHAIN: b->result = decode_sparse_if_chain(b->ids, b->args, b->n); break;
+        case SPARSE_SWITCH: b->result = decode_sparse_switch(b->ids, b->args, b->n); break;
+        case SPARSE_PERFECT_HASH: b->result = decode_sparse_perfect_hash(b->ph, b->ids, b->args, b->n); break;
+        case STRING_STRCMP_CHAIN: b->result = decode_strcmp_chain(b->names, b->args, b->n); break;
+        case STRING_PERFECT_HASH: b->result = decode_string_perfect_hash(b->ph, b->names, b->args, b->n); break;
+    }
+    BENCH_DO_NOT_OPTIMIZE(b->result);
+}
+
+static void fill_stream(uint8_t* ops, uint32_t* args, uint32_t* ids, size_t n, int patterned) {
+    uint32_t x = 12345;
+    uint8_t templates[16][12];
+    for (int t = 0; t < 16; t++) {
+        for (int k = 0; k < 12; k++) {
+            x = x * 1103515245u + 12345u;
+            templates[t][k] = (uint8_t)((x >> 16) % PROTO_DEFINED);
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        x = x * 1103515245u + 12345u;
+        if (!patterned) {
+            ops[i] = (uint8_t)((x >> 16) % PROTO_DEFINED);
+        } else if (i % 12 == 0) {
+            int t = (int)((x >> 16) % 16);
+            for (size_t k = 0; k < 12 && i + k < n; k++) ops[i + k] = templates[t][k];
+        }
+        args[i] = x;
+    }
+    ops[n] = PROTO_END;
+    for (size_t i = 0; i < n; i++) ids[i] = SPARSE_ID(ops[i]);
+}
+
+// Runs every case once, checks they agree, then times them
+static void run_suite(const char* title, DispatchBench* cases, const char* const* names, int count) {
+    BenchSuite suite;
+    bench_suite_init(&suite, title);
+    int agree = 1;
+    for (int i = 0; i < count; i++) {
+        dispatch_bench_run(&cases[i]);
+        if (cases[i].result != cases[0].result) agree = 0;
+    }
+    for (int i = 0; i < count; i++) bench_suite_run(&suite, names[i], dispatch_bench_run, &cases[i], cases[i].n);
+    bench_suite_report(&suite);
+    if (!agree) printf("  (result check FAILED)\n");
+    printf("\n");
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    size_t n = DISPATCH_BENCH_N;
+    uint8_t* ops = (uint8_t*)malloc(n + 1);
+    uint32_t* args = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* ids = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* names = (uint32_t*)malloc(STRING_BENCH_N * sizeof(uint32_t));
+    uint64_t* id_keys = (uint64_t*)malloc(PROTO_DEFINED * sizeof(uint64_t));
+    PerfectHash id_hash, name_hash;
+    memset(&id_hash, 0, sizeof(id_hash));
+    memset(&name_hash, 0, sizeof(name_hash));
+    if (ops == NULL || args == NULL || ids == NULL || names == NULL || id_keys == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        goto cleanup;
+    }
+    for (unsigned c = 0; c < PROTO_DEFINED; c++) id_keys[c] = SPARSE_ID(c);
+    if (perfect_hash_build_int(&id_hash, id_keys, PROTO_DEFINED) != 0 ||
+        perfect_hash_build_str(&name_hash, proto_names, PROTO_DEFINED) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        goto cleanup;
+    }
+    printf("Dispatch: %s, 192 of 256 opcodes defined\n\n", DISPATCH_THREADED_NAME);
+
+    static const char* const dense_names[] = {"if-else chain", "switch", "jump table (dispatch.h)",
+                                              "threaded (" DISPATCH_THREADED_NAME ")"};
+    static const char* const sparse_names[] = {"if-else chain", "switch (compare tree)",
+                                               "perfect hash + jump table"};
+    static const char* const string_names[] = {"strcmp chain", "perfect hash + jump table"};
+    static const char* const dense_titles[] = {"Dense opcodes, 1M messages, random stream",
+                                               "Dense opcodes, 1M messages, patterned stream"};
+    static const char* const sparse_titles[] = {"Sparse 32-bit IDs, 1M messages, random stream",
+                                                "Sparse 32-bit IDs, 1M messages, patterned stream"};
+
+    for (int patterned = 0; patterned < 2; patterned++) {
+        fill_stream(ops, args, ids, n, patterned);
+        DispatchBench dense[4], sparse[3];
+        for (int k = 0; k < 4; k++) {
+            dense[k] = (DispatchBench){(DispatchKind)(DISPATCH_IF_CHAIN + k), n, ops, args, ids, NULL, NULL, 0};
+        }
+        for (int k = 0; k < 3; k++) {
+            sparse[k] = (DispatchBench){(DispatchKind)(SPARSE_IF_CHAIN + k), n, ops, args, ids, NULL, &id_hash, 0};
+        }
+        run_suite(dense_titles[patterned], dense, dense_names, 4);
+        run_suite(sparse_titles[patterned], sparse, sparse_names, 3);
+    }
+
+    uint32_t x = 777;
+    for (size_t i = 0; i < STRING_BENCH_N; i++) {
+        x = x * 1103515245u + 12345u;
+        names[i] = (x >> 16) % PROTO_DEFINED;
+    }
+    DispatchBench strings[2] = {
+        {STRING_STRCMP_CHAIN, STRING_BENCH_N, ops, args, ids, names, NULL, 0},
+        {STRING_PERFECT_HASH, STRING_BENCH_N, ops, args, ids, names, &name_hash, 0},
+    };
+    run_suite("String commands, 64K lookups of 192 names", strings, string_names, 2);
+
+cleanup:
+    perfect_hash_destroy(&id_hash);
+    perfect_hash_destroy(&name_hash);
+    free(ops);
+    free(args);
+    free(ids);
+    free(names);
+    free(id_keys);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o dispatch Dispatch.c -O2
+
+Then execute the resulting binary:
+    ./dispatch
+*/
@@ -0,0 +1,330 @@
+/*
+dispatch.h - Jump Tables, Minimal Perfect Hashing and Threaded Dispatch
+================================================
+
+Three ways to turn a key into "run this code" without a chain of compares. All
+of them are driven by one X-macro list with an entry X(name, code, handler, ...)
+per case. Only DISPATCH_DEFINE_TABLE reads handler; any further fields are
+ignored here.
+
+    #define OPCODES(X)                      \
+        X(OP_PING, 0x01, handle_ping, ...)  \
+        X(OP_SET, 0x02, handle_set, ...)
+
+    DISPATCH_DEFINE_ENUM(Opcode, OPCODES)                        // OP_PING = 0x01, ...
+    DISPATCH_DEFINE_TABLE(handlers, Handler, 256, handle_bad, OPCODES)
+    handlers[op](state, msg);                                    // One indirect call
+
+Sparse keys (32/64-bit integers or strings) go through a minimal perfect hash
+built at startup:
+
+    PerfectHash ph;
+    perfect_hash_build_str(&ph, names, count);      // -1 with errno on failure
+    size_t i = perfect_hash_find_str(&ph, s, len);  // Position in names[], or DISPATCH_NOT_FOUND
+    perfect_hash_destroy(&ph);
+
+Interpreter loops use threaded code (computed goto) where the compiler supports it:
+
+    DISPATCH_THREADED_TABLE(labels, 256, OPCODES);
+    DISPATCH_START(labels, *pc++)
+    DISPATCH_TARGET(OP_PING) ...; DISPATCH_NEXT(labels, *pc++);
+    DISPATCH_DEFAULT ...; return;
+    DISPATCH_END
+
+Design:
+- DISPATCH_DEFINE_TABLE fills every slot at compile time, with the default
+  handler for gaps. That needs GCC/Clang range designators, and the one
+  override-init warning they cause is silenced around the table. Codes outside
+  [0, SIZE) are a compile error. Duplicate codes are also a compile error: the
+  macro expands the list into a switch nobody calls, and a repeated case label
+  does not compile.
+- A dense switch usually compiles into the same jump table. The explicit table
+  also works when handlers are registered per protocol version, when it must be
+  swapped at run time, or when the case list has gaps a compiler would rather
+  turn into compare trees.
+- PerfectHash is "hash, displace and compress" in Hanov's simple form. Keys are
+  hashed into n buckets, and buckets are placed largest first. For a bucket with
+  several keys the builder searches for a seed d that sends all of them to free
+  slots, and stores d. A single-key bucket takes any free slot directly, stored
+  as -(slot + 1). A lookup is two hashes, one table read and one key compare
+  (to reject keys outside the set). There are no probe loops, so the cost is
+  the same for every key, hit or miss.
+- Threaded dispatch ends every handler with its own "goto *labels[next]". Each
+  opcode then has its own indirect branch, and the predictor learns pairs
+  such as "PUSH is usually followed by ADD". With one shared switch jump there
+  is only one branch to predict. Without computed goto
+  (DISPATCH_NO_COMPUTED_GOTO or a non-GNU compiler) the same macros expand to
+  "for (;;) switch".
+*/
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define DISPATCH_NOT_FOUND ((size_t)-1)
+
+// ---------------------------------------------------------------------------
+// Compile-time tables from an X-macro list
+// ---------------------------------------------------------------------------
+
+#define DISPATCH_ENUM_ENTRY_(name, code, ...) name = (code),
+#define DISPATCH_SLOT_ENTRY_(name, code, handler, ...) [(code)] = (handler),
+#define DISPATCH_CASE_ENTRY_(name, code, ...) case (code):
+
+#define DISPATCH_DEFINE_ENUM(EnumType, LIST) typedef enum { LIST(DISPATCH_ENUM_ENTRY_) } EnumType;
+
+#if defined(__clang__)
+#define DISPATCH_IGNORE_OVERRIDE_INIT_ _Pragma("clang diagnostic ignored \"-Winitializer-overrides\"")
+#else
+#define DISPATCH_IGNORE_OVERRIDE_INIT_ _Pragma("GCC diagnostic ignored \"-Woverride-init\"")
+#endif
+
+// static FnType const table[SIZE], with 'fallback' in every slot the list does not name.
+#define DISPATCH_DEFINE_TABLE(table, FnType, SIZE, fallback, LIST)                         \
+    static inline void table##_unique_codes_(int code) {                                   \
+        switch (code) {                                                                    \
+            LIST(DISPATCH_CASE_ENTRY_) /* A duplicate code fails to compile here */       \
+            default: break;                                                                \
+        }                                                                                  \
+    }                                                                                      \
+    _Pragma("GCC diagnostic push") DISPATCH_IGNORE_OVERRIDE_INIT_                          \
+    static FnType const table[(SIZE)] = {[0 ...(SIZE) - 1] = (fallback), LIST(DISPATCH_SLOT_ENTRY_)}; \
+    _Pragma("GCC diagnostic pop")
+
+// ---------------------------------------------------------------------------
+// Threaded (computed goto) dispatch
+// ---------------------------------------------------------------------------
+
+#if defined(__GNUC__) && !defined(DISPATCH_NO_COMPUTED_GOTO)
+#define DISPATCH_COMPUTED_GOTO 1
+#define DISPATCH_THREADED_NAME "computed goto"    // For labels and reports
+#define DISPATCH_LABEL_ENTRY_(name, code, ...) [(code)] = &&dispatch_target_##name,
+// Inside the interpreter function: the label table for LIST, default for gaps
+#define DISPATCH_THREADED_TABLE(table, SIZE, LIST)                                         \
+    _Pragma("GCC diagnostic push") DISPATCH_IGNORE_OVERRIDE_INIT_                          \
+    static void* const table[(SIZE)] = {[0 ...(SIZE) - 1] = &&dispatch_target_default_,    \
+                                        LIST(DISPATCH_LABEL_ENTRY_)};                      \
+    _Pragma("GCC diagnostic pop")
+#define DISPATCH_START(table, next) goto *(table)[(next)];
+#define DISPATCH_TARGET(name) dispatch_target_##name:
+#define DISPATCH_NEXT(table, next) goto *(table)[(next)]
+#define DISPATCH_DEFAULT dispatch_target_default_:
+#define DISPATCH_END
+#else
+#define DISPATCH_COMPUTED_GOTO 0
+#define DISPATCH_THREADED_NAME "switch fallback"
+#define DISPATCH_THREADED_TABLE(table, SIZE, LIST) (void)0
+#define DISPATCH_START(table, next) for (;;) switch (next) {
+#define DISPATCH_TARGET(name) case name:
+#define DISPATCH_NEXT(table, next) continue
+#define DISPATCH_DEFAULT default:
+#define DISPATCH_END }
+#endif
+
+// ---------------------------------------------------------------------------
+// Minimal perfect hashing
+// ---------------------------------------------------------------------------
+
+#define DISPATCH_GOLDEN_ 0x9E3779B97F4A7C15ull
+#define DISPATCH_MAX_SEED_ (1 << 24)
+
+typedef struct {
+    size_t n;                // Keys, also the number of slots and buckets
+    int32_t* disp;           // Per bucket: seed d > 0, or -(slot + 1) for one key, 0 if empty
+    uint32_t* index;         // Slot -> position of the key in the build array
+    uint64_t* int_keys;      // Slot -> key, integer sets
+    const char** str_keys;   // Slot -> key, string sets (not copied)
+    uint32_t* str_lens;
+} PerfectHash;
+
+static inline uint64_t dispatch_mix64_(uint64_t x) {
+    x ^= x >> 32;
+    return x * 0xBF58476D1CE4E5B9ull;
+}
+
+// FNV-1a; the mixer above spreads it before it is reduced to a bucket.
+static inline uint64_t dispatch_hash_bytes_(const char* s, size_t len) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+// Second-level hash of an already mixed key h for seed d: one multiply.
+static inline uint64_t dispatch_seed_hash_(uint64_t h, int32_t d) {
+    return (h ^ ((uint64_t)(uint32_t)d * DISPATCH_GOLDEN_)) * 0xD6E8FEB86659FD93ull;
+}
+
+// Maps a 64-bit hash onto [0, n) with a multiply instead of a division.
+static inline size_t dispatch_range_(uint64_t h, size_t n) {
+    return (size_t)(((h >> 32) * (uint64_t)n) >> 32);
+}
+
+static inline size_t perfect_hash_slot_(const PerfectHash* ph, uint64_t base) {
+    uint64_t h = dispatch_mix64_(base);
+    int32_t d = ph->disp[dispatch_range_(h, ph->n)];
+    // Both candidates are computed so the choice is a conditional move: whether a
+    // key's bucket held one key or several is random and would mispredict.
+    size_t direct = (size_t)(-(int64_t)d - 1);
+    size_t hashed = dispatch_range_(dispatch_seed_hash_(h, d), ph->n);
+    return d < 0 ? direct : hashed;
+}
+
+static inline void perfect_hash_destroy(PerfectHash* ph) {
+    free(ph->disp);
+    free(ph->index);
+    free(ph->int_keys);
+    free(ph->str_lens);
+    free((void*)ph->str_keys);
+    memset(ph, 0, sizeof(*ph));
+}
+
+// Places keys with precomputed base hashes. Returns 0, or -1 with errno = EINVAL
+// (duplicate keys: no seed can separate them) or ENOMEM.
+static inline int perfect_hash_place_(PerfectHash* ph, const uint64_t* base, size_t n) {
+    size_t* bucket_start = (size_t*)calloc(n + 1, sizeof(size_t));
+    size_t* members = (size_t*)malloc(n * sizeof(size_t));
+    size_t* slots = (size_t*)malloc(n * sizeof(size_t));
+    unsigned char* used = (unsigned char*)calloc(n, 1);
+    ph->disp = (int32_t*)calloc(n, sizeof(int32_t));
+    ph->index = (uint32_t*)malloc(n * sizeof(uint32_t));
+    int result = -1;
+    if (bucket_start == NULL || members == NULL || slots == NULL || used == NULL || ph->disp == NULL ||
+        ph->index == NULL) {
+        errno = ENOMEM;
+        goto done;
+    }
+
+    // Group keys by bucket (counting sort), then place the largest buckets first
+    size_t max_size = 0;
+    for (size_t i = 0; i < n; i++) bucket_start[dispatch_range_(dispatch_mix64_(base[i]), n) + 1]++;
+    for (size_t b = 0; b < n; b++) {
+        if (bucket_start[b + 1] > max_size) max_size = bucket_start[b + 1];
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t b = dispatch_range_(dispatch_mix64_(base[i]), n);
+        members[bucket_start[b]++] = i;
+    }
+    for (size_t b = n; b > 0; b--) bucket_start[b] = bucket_start[b - 1];
+    bucket_start[0] = 0;
+
+    for (size_t size = max_size; size > 1; size--) {
+        for (size_t b = 0; b < n; b++) {
+            if (bucket_start[b + 1] - bucket_start[b] != size) continue;
+            const size_t* keys = members + bucket_start[b];
+            int32_t d = 1;
+            for (;; d++) {
+                if (d == DISPATCH_MAX_SEED_) {
+                    errno = EINVAL;
+                    goto done;
+                }
+                size_t k = 0;
+                for (; k < size; k++) {
+                    slots[k] = dispatch_range_(dispatch_seed_hash_(dispatch_mix64_(base[keys[k]]), d), n);
+                    if (used[slots[k]]) break;
+                    size_t j = 0;
+                    while (j < k && slots[j] != slots[k]) j++;
+                    if (j < k) break;
+                }
+                if (k == size) break;
+            }
+            for (size_t k = 0; k < size; k++) {
+                used[slots[k]] = 1;
+                ph->index[slots[k]] = (uint32_t)keys[k];
+            }
+            ph->disp[b] = d;
+        }
+    }
+    size_t free_slot = 0;
+    for (size_t b = 0; b < n; b++) {
+        if (bucket_start[b + 1] - bucket_start[b] != 1) continue;
+        while (used[free_slot]) free_slot++;
+        used[free_slot] = 1;
+        ph->index[free_slot] = (uint32_t)members[bucket_start[b]];
+        ph->disp[b] = -(int32_t)free_slot - 1;
+    }
+    result = 0;
+
+done:
+    free(bucket_start);
+    free(members);
+    free(slots);
+    free(used);
+    return result;
+}
+
+static inline int perfect_hash_check_size_(PerfectHash* ph, size_t n) {
+    memset(ph, 0, sizeof(*ph));
+    if (n == 0 || n > INT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    ph->n = n;
+    return 0;
+}
+
+// keys[0..n) must be distinct. find() returns the position in keys[].
+static inline int perfect_hash_build_int(PerfectHash* ph, const uint64_t* keys, size_t n) {
+    if (perfect_hash_check_size_(ph, n) != 0) return -1;
+    ph->int_keys = (uint64_t*)malloc(n * sizeof(uint64_t));
+    if (ph->int_keys == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (perfect_hash_place_(ph, keys, n) != 0) {
+        perfect_hash_destroy(ph);
+        return -1;
+    }
+    for (size_t s = 0; s < n; s++) ph->int_keys[s] = keys[ph->index[s]];
+    return 0;
+}
+
+static inline size_t perfect_hash_find_int(const PerfectHash* ph, uint64_t key) {
+    if (ph->n == 0) return DISPATCH_NOT_FOUND;
+    size_t slot = perfect_hash_slot_(ph, key);
+    return ph->int_keys[slot] == key ? ph->index[slot] : DISPATCH_NOT_FOUND;
+}
+
+// NUL-terminated, distinct keys. They are not copied and must outlive the hash.
+static inline int perfect_hash_build_str(PerfectHash* ph, const char* const* keys, size_t n) {
+    if (perfect_hash_check_size_(ph, n) != 0) return -1;
+    uint64_t* base = (uint64_t*)malloc(n * sizeof(uint64_t));
+    ph->str_keys = (const char**)malloc(n * sizeof(const char*));
+    ph->str_lens = (uint32_t*)malloc(n * sizeof(uint32_t));
+    if (base == NULL || ph->str_keys == NULL || ph->str_lens == NULL) {
+        free(base);
+        perfect_hash_destroy(ph);
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) base[i] = dispatch_hash_bytes_(keys[i], strlen(keys[i]));
+    int result = perfect_hash_place_(ph, base, n);
+    free(base);
+    if (result != 0) {
+        perfect_hash_destroy(ph);
+        return -1;
+    }
+    for (size_t s = 0; s < n; s++) {
+        ph->str_keys[s] = keys[ph->index[s]];
+        ph->str_lens[s] = (uint32_t)strlen(ph->str_keys[s]);
+    }
+    return 0;
+}
+
+// s need not be NUL-terminated: message buffers can be searched in place.
+static inline size_t perfect_hash_find_str(const PerfectHash* ph, const char* s, size_t len) {
+    if (ph->n == 0) return DISPATCH_NOT_FOUND;
+    size_t slot = perfect_hash_slot_(ph, dispatch_hash_bytes_(s, len));
+    if (ph->str_lens[slot] != len || memcmp(ph->str_keys[slot], s, len) != 0) return DISPATCH_NOT_FOUND;
+    return ph->index[slot];
+}
+
+#endif // DISPATCH_H
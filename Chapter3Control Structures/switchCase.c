@@ -228,7 +228,8 @@ void best_practices() {
     printf("- Use enums with switch statements for improved type safety\n");
     printf("- Keep case statements simple; move complex logic to separate functions\n");
     printf("- Use switch statements instead of long if-else chains when applicable\n");
-    printf("- Consider using lookup tables for large sets of values\n\n");
+    printf("- Consider using lookup tables for large sets of values\n");
+    printf("  (dispatch.h: jump tables, perfect hashing and computed goto; see Dispatch.c)\n\n");
 
     // Example of using enum with switch
     typedef enum {
@@ -2,6 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include "recursion_engine.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
 
 // Function prototypes
 void overview_of_recursion(void);
@@ -23,6 +27,7 @@ void advanced_tips_and_optimizations(void);
 void integration_and_real_world_applications(void);
 void faqs_and_troubleshooting(void);
 void recommended_tools_and_libraries(void);
+void recursion_engines_and_performance(void);
 
 int main() {
     printf("Expert-level Cheat Sheet: Functions - Recursion in C\n\n");
@@ -50,6 +55,7 @@ int main() {
     int x = 10;
     int result = binary_search(arr, 0, n - 1, x);
     printf("Element %d is %s in the array\n", x, (result == -1) ? "not present" : "present at index " + result);
+    printf("(Branchless, Eytzinger and batched searches: Chapter14Algorithms/search.h.)\n");
 
     int arr2[] = {10, 7, 8, 9, 1, 5};
     n = sizeof(arr2) / sizeof(arr2[0]);
@@ -59,6 +65,7 @@ int main() {
         printf("%d ", arr2[i]);
     }
     printf("\n");
+    printf("(Last-element pivot: O(n^2) on sorted input; Chapter14Algorithms/sort.h has an introsort.)\n");
 
     printf("Tower of Hanoi with 3 disks:\n");
     tower_of_hanoi(3, 'A', 'C', 'B');
@@ -84,6 +91,7 @@ int main() {
     integration_and_real_world_applications();
     faqs_and_troubleshooting();
     recommended_tools_and_libraries();
+    recursion_engines_and_performance();
 
     return 0;
 }
@@ -361,4 +369,221 @@ void recommended_tools_and_libraries() {
     printf("- Benchmarking tools:\n");
     printf("  * Google Benchmark: For measuring performance of recursive vs. iterative implementations\n");
     printf("\nRemember to choose tools and libraries based on your specific needs, project constraints, and performance requirements. Always benchmark and profile your recursive implementations to ensure they meet your performance criteria.\n");
-}
\ No newline at end of file
+}
+
+// ---------------------------------------------------------------------------
+// 7. Recursion engines: memoized, iterative and big-result versions
+// ---------------------------------------------------------------------------
+
+// ackermann() again, recording how deep the call stack gets
+static int probe_depth, probe_max_depth;
+static uintptr_t probe_stack_top, probe_stack_low;
+
+int ackermann_probed(int m, int n) {
+    uintptr_t frame = (uintptr_t)__builtin_frame_address(0);
+    if (frame < probe_stack_low) probe_stack_low = frame;
+    if (++probe_depth > probe_max_depth) probe_max_depth = probe_depth;
+    int result;
+    if (m == 0) {
+        result = n + 1;
+    } else if (n == 0) {
+        result = ackermann_probed(m - 1, 1);
+    } else {
+        result = ackermann_probed(m - 1, ackermann_probed(m, n - 1));
+    }
+    probe_depth--;
+    return result;
+}
+
+typedef struct {
+    int n;
+    RecMemoTable* table;
+    RecMemoCache* cache;
+} FibBench;
+
+void fib_naive_run(void* ctx) {
+    FibBench* b = (FibBench*)ctx;
+    int n = b->n;
+    BENCH_HIDE_VALUE(n);
+    int result = fibonacci(n);
+    BENCH_DO_NOT_OPTIMIZE(result);
+}
+
+// The memo runs start from an empty table each time, so they pay for filling it
+void fib_memo_table_run(void* ctx) {
+    FibBench* b = (FibBench*)ctx;
+    uint64_t result = 0;
+    rec_memo_table_clear(b->table);
+    rec_fib_memo_table(b->table, (unsigned)b->n, &result);
+    BENCH_DO_NOT_OPTIMIZE(result);
+}
+
+void fib_memo_cache_run(void* ctx) {
+    FibBench* b = (FibBench*)ctx;
+    uint64_t result = 0;
+    rec_memo_cache_clear(b->cache);
+    rec_fib_memo_cache(b->cache, (unsigned)b->n, &result);
+    BENCH_DO_NOT_OPTIMIZE(result);
+}
+
+void fib_doubling_run(void* ctx) {
+    FibBench* b = (FibBench*)ctx;
+    unsigned n = (unsigned)b->n;
+    BENCH_HIDE_VALUE(n);
+    uint64_t result = 0;
+    rec_fib_u64(n, &result);
+    BENCH_DO_NOT_OPTIMIZE(result);
+}
+
+typedef struct {
+    int m, n;
+    RecMemoCache* cache;
+} AckBench;
+
+void ack_naive_run(void* ctx) {
+    AckBench* b = (AckBench*)ctx;
+    int m = b->m;
+    BENCH_HIDE_VALUE(m);
+    int result = ackermann(m, b->n);
+    BENCH_DO_NOT_OPTIMIZE(result);
+}
+
+void ack_iter_run(void* ctx) {
+    AckBench* b = (AckBench*)ctx;
+    uint64_t result = 0;
+    if (b->cache) rec_memo_cache_clear(b->cache);
+    rec_ackermann_iter((uint64_t)b->m, (uint64_t)b->n, b->cache, &result, NULL);
+    BENCH_DO_NOT_OPTIMIZE(result);
+}
+
+void count_move(void* ctx, unsigned disk, char from, char to) {
+    (void)disk;
+    (void)from;
+    (void)to;
+    (*(uint64_t*)ctx)++;
+}
+
+void recursion_engines_and_performance() {
+    printf("\n7. Recursion Engines and Performance (recursion_engine.h)\n");
+    printf("---------------------------------------------------------\n");
+
+    // Results that do not fit in int
+    char buf[64];
+    uint64_t u64;
+    // factorial(13) itself would overflow int, which is undefined behaviour; unsigned
+    // arithmetic shows the same wraparound with a defined result
+    uint32_t wrapped = 1;
+    for (uint32_t i = 2; i <= 13; i++) wrapped *= i;
+    printf("13! in 32-bit unsigned: %u (wrapped mod 2^32)\n", (unsigned)wrapped);
+    rec_factorial_u64(20, &u64);
+    printf("20! in uint64_t: %llu\n", (unsigned long long)u64);
+#if REC_HAVE_INT128
+    rec_u128 u128;
+    rec_factorial_u128(34, &u128);
+    printf("34! in unsigned __int128: %s\n", rec_u128_to_string(u128, buf));
+    rec_fib_u128(186, &u128);
+    printf("F(186) in unsigned __int128: %s\n", rec_u128_to_string(u128, buf));
+#endif
+    if (rec_factorial_u64(21, &u64) != 0 && errno == ERANGE) {
+        printf("21! in uint64_t: ERANGE instead of a wrapped value\n");
+    }
+
+    BigNat big;
+    bignat_init(&big);
+    if (rec_factorial_big(1000, &big) == 0) {
+        char* digits = bignat_to_string(&big);
+        if (digits) printf("1000! has %zu digits: %.20s...\n", strlen(digits), digits);
+        free(digits);
+    }
+    if (rec_fib_big(100000, &big) == 0) {
+        char* digits = bignat_to_string(&big);
+        if (digits) printf("F(100000) has %zu digits: %.20s...\n", strlen(digits), digits);
+        free(digits);
+    }
+    bignat_destroy(&big);
+
+    // Inputs the recursive versions cannot handle
+    RecMemoCache cache;
+    RecMemoTable table;
+    if (rec_memo_cache_init(&cache, 1 << 16) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    if (rec_memo_table_init(&table, REC_FIB_U64_MAX + 1) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        rec_memo_cache_destroy(&cache);
+        return;
+    }
+    RecStats stats;
+    if (rec_ackermann_iter(3, 60, NULL, &u64, &stats) == 0) {
+        printf("ackermann(3, 60) = %llu in %llu steps, peak explicit stack %zu frames\n",
+               (unsigned long long)u64, (unsigned long long)stats.steps, stats.max_depth);
+    }
+    if (rec_ackermann_iter(4, 1, NULL, &u64, &stats) == 0) {
+        printf("ackermann(4, 1) = %llu in %llu steps, peak explicit stack %zu frames\n",
+               (unsigned long long)u64, (unsigned long long)stats.steps, stats.max_depth);
+    }
+    if (rec_ackermann_iter(4, 2, NULL, &u64, &stats) != 0 && errno == ERANGE) {
+        printf("ackermann(4, 2) = 2^65536 - 3: ERANGE, it needs a BigNat\n");
+    }
+    uint64_t moves = 0, expected;
+    rec_hanoi_iter(24, 'A', 'C', 'B', count_move, &moves, &stats);
+    rec_hanoi_moves(24, &expected);
+    printf("tower_of_hanoi(24) iteratively: %llu moves (expected %llu), peak stack %zu frames\n\n",
+           (unsigned long long)moves, (unsigned long long)expected, stats.max_depth);
+
+    // Call-stack depth of ackermann(3, n) vs the explicit stack
+    struct rlimit limit;
+    size_t stack_limit = getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                             ? (size_t)limit.rlim_cur : 0;
+    printf("%-16s %12s %14s %16s %16s\n", "ackermann(3, n)", "call depth", "call stack", "engine frames", "engine heap");
+    double bytes_per_frame = 0;
+    for (int n = 4; n <= 10; n += 2) {
+        probe_depth = probe_max_depth = 0;
+        probe_stack_top = probe_stack_low = (uintptr_t)__builtin_frame_address(0);
+        ackermann_probed(3, n);
+        size_t used = probe_stack_top - probe_stack_low;
+        bytes_per_frame = (double)used / probe_max_depth;
+        rec_ackermann_iter(3, (uint64_t)n, NULL, &u64, &stats);
+        printf("n = %-12d %12d %11zu KB %16zu %13zu KB\n", n, probe_max_depth, used / 1024,
+               stats.max_depth, stats.max_depth * sizeof(uint64_t) / 1024);
+    }
+    if (stack_limit && bytes_per_frame > 0) {
+        // Depth of ackermann(3, n) is about 2^(n+3), so find the first n past the limit
+        int n = 0;
+        while (n < 40 && (double)((uint64_t)1 << (n + 3)) * bytes_per_frame < (double)stack_limit) n++;
+        printf("With a %zu KB stack the recursive ackermann(3, n) overflows from about n = %d;\n"
+               "the engine's frames live on the heap, so only memory limits it.\n\n", stack_limit / 1024, n);
+    }
+
+    // Fibonacci only ever stores 30 keys; a small cache keeps the per-run clear cheap
+    RecMemoCache fib_cache;
+    if (rec_memo_cache_init(&fib_cache, 64) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        rec_memo_table_destroy(&table);
+        rec_memo_cache_destroy(&cache);
+        return;
+    }
+    BenchSuite suite;
+    FibBench fib = {30, &table, &fib_cache};
+    bench_suite_init(&suite, "fibonacci(30)");
+    bench_suite_run(&suite, "naive recursion", fib_naive_run, &fib, 1);
+    bench_suite_run(&suite, "memo table", fib_memo_table_run, &fib, 1);
+    bench_suite_run(&suite, "memo hash cache", fib_memo_cache_run, &fib, 1);
+    bench_suite_run(&suite, "fast doubling", fib_doubling_run, &fib, 1);
+    bench_suite_report(&suite);
+    printf("\n");
+
+    AckBench naive = {3, 8, NULL};
+    AckBench iter = {3, 8, NULL};
+    AckBench memo = {3, 8, &cache};
+    bench_suite_init(&suite, "ackermann(3, 8)");
+    bench_suite_run(&suite, "naive recursion", ack_naive_run, &naive, 1);
+    bench_suite_run(&suite, "explicit stack", ack_iter_run, &iter, 1);
+    bench_suite_run(&suite, "explicit stack + cache", ack_iter_run, &memo, 1);
+    bench_suite_report(&suite);
+
+    rec_memo_cache_destroy(&fib_cache);
+    rec_memo_table_destroy(&table);
+    rec_memo_cache_destroy(&cache);
+}
@@ -0,0 +1,765 @@
+/*
+recursion_engine.h - Memoized, Iterative and Big-Result Versions of Classic Recursions
+================================================
+
+Drop-in alternatives for the textbook recursions in recursion.c:
+
+    uint64_t f;
+    rec_fib_u64(90, &f);                         // O(log n) fast doubling, ERANGE past F(93)
+
+    BigNat big;
+    bignat_init(&big);
+    rec_fib_big(100000, &big);                   // Exact, any n
+    char* digits = bignat_to_string(&big);       // Caller frees
+    free(digits);
+    bignat_destroy(&big);
+
+    RecMemoCache cache;
+    rec_memo_cache_init(&cache, 1 << 16);        // Bounded: evicts instead of growing
+    rec_ackermann_iter(3, 16, &cache, &f, NULL); // Heap stack, no call-stack overflow
+
+Design:
+- Result types: uint64_t for the fast paths, unsigned __int128 where the compiler
+  has it (REC_HAVE_INT128), and BigNat, a little-endian vector of 32-bit limbs,
+  for results of any size. Fixed-width functions return -1 with errno = ERANGE
+  instead of silently wrapping.
+- Memoization comes in two shapes. RecMemoTable is a dense array indexed by the
+  argument, for small argument ranges. RecMemoCache is a bounded open-addressing
+  hash table keyed by a uint64_t: a lookup probes at most REC_MEMO_PROBE slots, and
+  an insert into a full window evicts the home slot, so memory stays fixed however
+  many distinct arguments a recursion touches.
+- rec_fib_*() use fast doubling, F(2k) = F(k) * (2F(k+1) - F(k)) and
+  F(2k+1) = F(k)^2 + F(k+1)^2, which needs O(log n) steps instead of O(phi^n)
+  calls.
+- rec_ackermann_iter() and rec_hanoi_iter() keep their own frame stack, on the
+  heap for Ackermann (depth has no useful bound) and in a fixed array for Hanoi
+  (depth <= n). Tail calls reuse the current frame instead of pushing one, as an
+  optimising compiler does for the recursive versions. The call stack stays at
+  one frame whatever the input; the RecStats they fill report the peak number of
+  frames.
+- All functions return 0 on success and -1 with errno set (ERANGE, ENOMEM,
+  EINVAL) on failure, like the rest of the repository's headers.
+*/
+
+#ifndef RECURSION_ENGINE_H
+#define RECURSION_ENGINE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__SIZEOF_INT128__)
+#define REC_HAVE_INT128 1
+typedef unsigned __int128 rec_u128;
+#else
+#define REC_HAVE_INT128 0
+#endif
+
+#define REC_FIB_U64_MAX 93         // F(93) is the largest Fibonacci number in 64 bits
+#define REC_FIB_U128_MAX 186
+#define REC_FACTORIAL_U64_MAX 20   // 20! < 2^64 < 21!
+#define REC_FACTORIAL_U128_MAX 34
+#define REC_MEMO_PROBE 8           // Slots a cache lookup may inspect
+#define REC_MEMO_EMPTY UINT64_MAX  // Reserved key: cannot be cached
+
+typedef struct {
+    size_t max_depth;   // Peak frames on the explicit stack
+    uint64_t steps;     // Frames evaluated
+} RecStats;
+
+// ---------------------------------------------------------------------------
+// BigNat: arbitrary-precision natural numbers
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t* limbs;    // Least significant limb first
+    size_t size;        // Limbs in use; 0 is the number zero
+    size_t capacity;
+} BigNat;
+
+static inline void bignat_init(BigNat* a) {
+    a->limbs = NULL;
+    a->size = 0;
+    a->capacity = 0;
+}
+
+static inline void bignat_destroy(BigNat* a) {
+    free(a->limbs);
+    bignat_init(a);
+}
+
+static inline int bignat_reserve_(BigNat* a, size_t limbs) {
+    if (limbs <= a->capacity) return 0;
+    size_t cap = a->capacity ? a->capacity : 4;
+    while (cap < limbs) cap *= 2;
+    uint32_t* grown = (uint32_t*)realloc(a->limbs, cap * sizeof(uint32_t));
+    if (grown == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    a->limbs = grown;
+    a->capacity = cap;
+    return 0;
+}
+
+static inline void bignat_trim_(BigNat* a) {
+    while (a->size > 0 && a->limbs[a->size - 1] == 0) a->size--;
+}
+
+static inline int bignat_set_u64(BigNat* a, uint64_t v) {
+    if (bignat_reserve_(a, 2) != 0) return -1;
+    a->limbs[0] = (uint32_t)v;
+    a->limbs[1] = (uint32_t)(v >> 32);
+    a->size = 2;
+    bignat_trim_(a);
+    return 0;
+}
+
+static inline int bignat_copy(BigNat* dst, const BigNat* src) {
+    if (dst == src) return 0;
+    if (bignat_reserve_(dst, src->size) != 0) return -1;
+    if (src->size) memcpy(dst->limbs, src->limbs, src->size * sizeof(uint32_t));
+    dst->size = src->size;
+    return 0;
+}
+
+static inline int bignat_cmp(const BigNat* a, const BigNat* b) {
+    if (a->size != b->size) return a->size < b->size ? -1 : 1;
+    for (size_t i = a->size; i-- > 0;) {
+        if (a->limbs[i] != b->limbs[i]) return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static inline size_t bignat_bits(const BigNat* a) {
+    if (a->size == 0) return 0;
+    return (a->size - 1) * 32 + (32 - (size_t)__builtin_clz(a->limbs[a->size - 1]));
+}
+
+// r = a + b. r may alias a or b.
+static inline int bignat_add(BigNat* r, const BigNat* a, const BigNat* b) {
+    size_t n = a->size > b->size ? a->size : b->size;
+    if (bignat_reserve_(r, n + 1) != 0) return -1;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t sum = carry;
+        if (i < a->size) sum += a->limbs[i];
+        if (i < b->size) sum += b->limbs[i];
+        r->limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    r->limbs[n] = (uint32_t)carry;
+    r->size = n + 1;
+    bignat_trim_(r);
+    return 0;
+}
+
+// r = a - b, requires a >= b (EINVAL otherwise). r may alias a or b.
+static inline int bignat_sub(BigNat* r, const BigNat* a, const BigNat* b) {
+    if (bignat_cmp(a, b) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t n = a->size;
+    if (bignat_reserve_(r, n) != 0) return -1;
+    int64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        int64_t diff = (int64_t)a->limbs[i] - borrow - (i < b->size ? (int64_t)b->limbs[i] : 0);
+        borrow = diff < 0;
+        r->limbs[i] = (uint32_t)(diff + (borrow ? ((int64_t)1 << 32) : 0));
+    }
+    r->size = n;
+    bignat_trim_(r);
+    return 0;
+}
+
+// r = a * m for a single limb. r may alias a.
+static inline int bignat_mul_u32(BigNat* r, const BigNat* a, uint32_t m) {
+    size_t n = a->size;
+    if (bignat_reserve_(r, n + 1) != 0) return -1;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t p = (uint64_t)a->limbs[i] * m + carry;
+        r->limbs[i] = (uint32_t)p;
+        carry = p >> 32;
+    }
+    r->limbs[n] = (uint32_t)carry;
+    r->size = n + 1;
+    bignat_trim_(r);
+    return 0;
+}
+
+// r = a * b (schoolbook). r may alias a or b: the product is built in a new
+// buffer and swapped in.
+static inline int bignat_mul(BigNat* r, const BigNat* a, const BigNat* b) {
+    if (a->size == 0 || b->size == 0) {
+        r->size = 0;
+        return 0;
+    }
+    size_t n = a->size + b->size;
+    uint32_t* out = (uint32_t*)calloc(n, sizeof(uint32_t));
+    if (out == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0; i < a->size; i++) {
+        uint64_t carry = 0, ai = a->limbs[i];
+        for (size_t j = 0; j < b->size; j++) {
+            uint64_t p = ai * b->limbs[j] + out[i + j] + carry;
+            out[i + j] = (uint32_t)p;
+            carry = p >> 32;
+        }
+        out[i + b->size] = (uint32_t)carry;
+    }
+    free(r->limbs);
+    r->limbs = out;
+    r->size = n;
+    r->capacity = n;
+    bignat_trim_(r);
+    return 0;
+}
+
+// Decimal representation in a malloc'd string, or NULL with errno = ENOMEM.
+static inline char* bignat_to_string(const BigNat* a) {
+    // Each limb is at most 9.64 decimal digits; split into base-10^9 chunks
+    size_t chunks_max = a->size * 10 / 9 + 2;
+    uint32_t* chunks = (uint32_t*)malloc(chunks_max * sizeof(uint32_t));
+    uint32_t* work = (uint32_t*)malloc((a->size ? a->size : 1) * sizeof(uint32_t));
+    char* s = (char*)malloc(chunks_max * 9 + 1);
+    if (chunks == NULL || work == NULL || s == NULL) {
+        free(chunks);
+        free(work);
+        free(s);
+        errno = ENOMEM;
+        return NULL;
+    }
+    size_t n = a->size, count = 0;
+    if (n) memcpy(work, a->limbs, n * sizeof(uint32_t));
+    while (n > 0) {
+        uint64_t rem = 0;
+        for (size_t i = n; i-- > 0;) {
+            uint64_t cur = (rem << 32) | work[i];
+            work[i] = (uint32_t)(cur / 1000000000u);
+            rem = cur % 1000000000u;
+        }
+        chunks[count++] = (uint32_t)rem;
+        while (n > 0 && work[n - 1] == 0) n--;
+    }
+    char* p = s;
+    if (count == 0) {
+        *p++ = '0';
+    } else {
+        p += sprintf(p, "%u", chunks[count - 1]);
+        for (size_t i = count - 1; i-- > 0;) p += sprintf(p, "%09u", chunks[i]);
+    }
+    *p = '\0';
+    free(chunks);
+    free(work);
+    return s;
+}
+
+#if REC_HAVE_INT128
+// Decimal digits of v into buf (at least 40 bytes). Returns buf.
+static inline char* rec_u128_to_string(rec_u128 v, char* buf) {
+    char tmp[40];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + (int)(v % 10));
+        v /= 10;
+    } while (v);
+    for (int i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+    buf[n] = '\0';
+    return buf;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Memoization: a dense table and a bounded hash cache
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t* values;
+    unsigned char* known;
+    size_t size;          // Valid keys are 0 .. size - 1
+} RecMemoTable;
+
+static inline int rec_memo_table_init(RecMemoTable* t, size_t size) {
+    t->values = (uint64_t*)malloc((size ? size : 1) * sizeof(uint64_t));
+    t->known = (unsigned char*)calloc(size ? size : 1, 1);
+    if (t->values == NULL || t->known == NULL) {
+        free(t->values);
+        free(t->known);
+        errno = ENOMEM;
+        return -1;
+    }
+    t->size = size;
+    return 0;
+}
+
+static inline void rec_memo_table_destroy(RecMemoTable* t) {
+    free(t->values);
+    free(t->known);
+    t->values = NULL;
+    t->known = NULL;
+    t->size = 0;
+}
+
+static inline void rec_memo_table_clear(RecMemoTable* t) {
+    memset(t->known, 0, t->size);
+}
+
+static inline int rec_memo_table_get(const RecMemoTable* t, uint64_t key, uint64_t* value) {
+    if (key >= t->size || !t->known[key]) return 0;
+    *value = t->values[key];
+    return 1;
+}
+
+static inline void rec_memo_table_put(RecMemoTable* t, uint64_t key, uint64_t value) {
+    if (key >= t->size) return;
+    t->values[key] = value;
+    t->known[key] = 1;
+}
+
+typedef struct {
+    uint64_t key;
+    uint64_t value;
+} RecMemoEntry_;
+
+typedef struct {
+    RecMemoEntry_* entries;
+    size_t mask;
+    unsigned shift;       // 64 - log2(capacity), for Fibonacci hashing
+    uint64_t hits, misses, evictions;
+} RecMemoCache;
+
+// Capacity is rounded up to a power of two (at least REC_MEMO_PROBE).
+static inline int rec_memo_cache_init(RecMemoCache* c, size_t capacity) {
+    size_t cap = REC_MEMO_PROBE;
+    unsigned bits = 3;
+    while (cap < capacity) {
+        if (cap > SIZE_MAX / (2 * sizeof(RecMemoEntry_))) {
+            errno = EINVAL;
+            return -1;
+        }
+        cap <<= 1;
+        bits++;
+    }
+    c->entries = (RecMemoEntry_*)malloc(cap * sizeof(RecMemoEntry_));
+    if (c->entries == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    c->mask = cap - 1;
+    c->shift = 64 - bits;
+    for (size_t i = 0; i < cap; i++) c->entries[i].key = REC_MEMO_EMPTY;
+    c->hits = c->misses = c->evictions = 0;
+    return 0;
+}
+
+static inline void rec_memo_cache_destroy(RecMemoCache* c) {
+    free(c->entries);
+    c->entries = NULL;
+}
+
+static inline void rec_memo_cache_clear(RecMemoCache* c) {
+    for (size_t i = 0; i <= c->mask; i++) c->entries[i].key = REC_MEMO_EMPTY;
+    c->hits = c->misses = c->evictions = 0;
+}
+
+static inline size_t rec_memo_cache_slot_(const RecMemoCache* c, uint64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> c->shift);
+}
+
+static inline int rec_memo_cache_get(RecMemoCache* c, uint64_t key, uint64_t* value) {
+    if (key == REC_MEMO_EMPTY) return 0;
+    size_t slot = rec_memo_cache_slot_(c, key);
+    for (unsigned p = 0; p < REC_MEMO_PROBE; p++) {
+        const RecMemoEntry_* e = &c->entries[(slot + p) & c->mask];
+        if (e->key == key) {
+            *value = e->value;
+            c->hits++;
+            return 1;
+        }
+        if (e->key == REC_MEMO_EMPTY) break;
+    }
+    c->misses++;
+    return 0;
+}
+
+static inline void rec_memo_cache_put(RecMemoCache* c, uint64_t key, uint64_t value) {
+    if (key == REC_MEMO_EMPTY) return;
+    size_t slot = rec_memo_cache_slot_(c, key);
+    for (unsigned p = 0; p < REC_MEMO_PROBE; p++) {
+        RecMemoEntry_* e = &c->entries[(slot + p) & c->mask];
+        if (e->key == key || e->key == REC_MEMO_EMPTY) {
+            e->key = key;
+            e->value = value;
+            return;
+        }
+    }
+    // Window full: replace the home slot. Later keys in the window stay reachable
+    // because lookups only stop early at an empty slot.
+    c->entries[slot].key = key;
+    c->entries[slot].value = value;
+    c->evictions++;
+}
+
+// ---------------------------------------------------------------------------
+// Fibonacci
+// ---------------------------------------------------------------------------
+
+// Top-down memoized recursion, the direct fix for the exponential fibonacci().
+// Recursion depth is n, which REC_FIB_U64_MAX keeps small.
+static inline uint64_t rec_fib_table_(RecMemoTable* t, unsigned n) {
+    uint64_t v;
+    if (n <= 1) return n;
+    if (rec_memo_table_get(t, n, &v)) return v;
+    v = rec_fib_table_(t, n - 1) + rec_fib_table_(t, n - 2);
+    rec_memo_table_put(t, n, v);
+    return v;
+}
+
+static inline int rec_fib_memo_table(RecMemoTable* t, unsigned n, uint64_t* out) {
+    if (n > REC_FIB_U64_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    *out = rec_fib_table_(t, n);
+    return 0;
+}
+
+static inline uint64_t rec_fib_cache_(RecMemoCache* c, unsigned n) {
+    uint64_t v;
+    if (n <= 1) return n;
+    if (rec_memo_cache_get(c, n, &v)) return v;
+    v = rec_fib_cache_(c, n - 1) + rec_fib_cache_(c, n - 2);
+    rec_memo_cache_put(c, n, v);
+    return v;
+}
+
+static inline int rec_fib_memo_cache(RecMemoCache* c, unsigned n, uint64_t* out) {
+    if (n > REC_FIB_U64_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    *out = rec_fib_cache_(c, n);
+    return 0;
+}
+
+// Fast doubling. Intermediate values may wrap (unsigned arithmetic is modular),
+// but F(n) itself is exact whenever it fits, which the range check guarantees.
+static inline int rec_fib_u64(unsigned n, uint64_t* out) {
+    if (n > REC_FIB_U64_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    uint64_t a = 0, b = 1;  // F(k), F(k + 1)
+    for (int bit = 31; bit >= 0; bit--) {
+        uint64_t c = a * (2 * b - a);
+        uint64_t d = a * a + b * b;
+        if ((n >> bit) & 1) {
+            a = d;
+            b = c + d;
+        } else {
+            a = c;
+            b = d;
+        }
+    }
+    *out = a;
+    return 0;
+}
+
+#if REC_HAVE_INT128
+static inline int rec_fib_u128(unsigned n, rec_u128* out) {
+    if (n > REC_FIB_U128_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    rec_u128 a = 0, b = 1;
+    for (int bit = 31; bit >= 0; bit--) {
+        rec_u128 c = a * (2 * b - a);
+        rec_u128 d = a * a + b * b;
+        if ((n >> bit) & 1) {
+            a = d;
+            b = c + d;
+        } else {
+            a = c;
+            b = d;
+        }
+    }
+    *out = a;
+    return 0;
+}
+#endif
+
+static inline int rec_fib_big(uint64_t n, BigNat* out) {
+    BigNat a, b, t1, t2;
+    bignat_init(&a);
+    bignat_init(&b);
+    bignat_init(&t1);
+    bignat_init(&t2);
+    int rc = -1;
+    if (bignat_set_u64(&a, 0) != 0 || bignat_set_u64(&b, 1) != 0) goto done;
+
+    for (int bit = n ? 63 - __builtin_clzll(n) : -1; bit >= 0; bit--) {
+        // t1 = F(2k) = a * (2b - a), t2 = F(2k + 1) = a^2 + b^2
+        if (bignat_add(&t1, &b, &b) != 0 || bignat_sub(&t1, &t1, &a) != 0 ||
+            bignat_mul(&t1, &t1, &a) != 0) goto done;
+        if (bignat_mul(&t2, &a, &a) != 0 || bignat_mul(&b, &b, &b) != 0 ||
+            bignat_add(&t2, &t2, &b) != 0) goto done;
+        if ((n >> bit) & 1) {
+            if (bignat_add(&b, &t1, &t2) != 0 || bignat_copy(&a, &t2) != 0) goto done;
+        } else {
+            if (bignat_copy(&a, &t1) != 0 || bignat_copy(&b, &t2) != 0) goto done;
+        }
+    }
+    rc = bignat_copy(out, &a);
+done:
+    bignat_destroy(&a);
+    bignat_destroy(&b);
+    bignat_destroy(&t1);
+    bignat_destroy(&t2);
+    return rc;
+}
+
+// ---------------------------------------------------------------------------
+// Factorial
+// ---------------------------------------------------------------------------
+
+static inline int rec_factorial_u64(unsigned n, uint64_t* out) {
+    if (n > REC_FACTORIAL_U64_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    uint64_t f = 1;
+    for (unsigned i = 2; i <= n; i++) f *= i;
+    *out = f;
+    return 0;
+}
+
+#if REC_HAVE_INT128
+static inline int rec_factorial_u128(unsigned n, rec_u128* out) {
+    if (n > REC_FACTORIAL_U128_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    rec_u128 f = 1;
+    for (unsigned i = 2; i <= n; i++) f *= i;
+    *out = f;
+    return 0;
+}
+#endif
+
+static inline int rec_factorial_big(uint32_t n, BigNat* out) {
+    if (bignat_set_u64(out, 1) != 0) return -1;
+    for (uint32_t i = 2; i <= n && i != 0; i++) {
+        if (bignat_mul_u32(out, out, i) != 0) return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Ackermann with an explicit stack
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t m, n;
+    int state;            // 0: new, 1: have A(m, n - 1), 2: have the result
+} RecAckFrame_;
+
+// A(m, n) as a memo key, or REC_MEMO_EMPTY when it does not fit (m < 256, n < 2^56).
+static inline uint64_t rec_ackermann_key_(uint64_t m, uint64_t n) {
+    if (m >= 256 || n >= ((uint64_t)1 << 56)) return REC_MEMO_EMPTY;
+    return (m << 56) | n;
+}
+
+// Without a cache the outer call in A(m - 1, A(m, n - 1)) is a tail call, so only
+// the pending 'm - 1' of each outer call has to be kept: the stack is a plain
+// array of m values. Levels m <= 2 have closed forms and are not expanded, so
+// A(3, n) takes 2n + 2 steps instead of the ~4^n calls of the plain recursion.
+static inline int rec_ackermann_stack_(uint64_t m, uint64_t n, uint64_t* out, RecStats* stats) {
+    size_t cap = 64, depth = 0, max_depth = 0;
+    uint64_t steps = 0;
+    uint64_t* stack = (uint64_t*)malloc(cap * sizeof(uint64_t));
+    if (stack == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    stack[depth++] = m;
+
+    while (depth > 0) {
+        if (depth > max_depth) max_depth = depth;
+        if (depth + 2 > cap) {
+            uint64_t* grown = (uint64_t*)realloc(stack, 2 * cap * sizeof(uint64_t));
+            if (grown == NULL) {
+                free(stack);
+                errno = ENOMEM;
+                return -1;
+            }
+            stack = grown;
+            cap *= 2;
+        }
+        steps++;
+        m = stack[--depth];
+        if (m <= 2) {
+            // Closed forms: A(0, n) = n + 1, A(1, n) = n + 2, A(2, n) = 2n + 3
+            uint64_t limit = m == 2 ? (UINT64_MAX - 3) / 2 : UINT64_MAX - (m + 1);
+            if (n > limit) {
+                free(stack);
+                errno = ERANGE;
+                return -1;
+            }
+            n = m == 2 ? 2 * n + 3 : n + m + 1;
+        } else if (n == 0) {
+            stack[depth++] = m - 1;  // A(m, 0) = A(m - 1, 1)
+            n = 1;
+        } else {
+            stack[depth++] = m - 1;  // A(m - 1, A(m, n - 1)): outer call waits
+            stack[depth++] = m;
+            n--;
+        }
+    }
+    free(stack);
+    *out = n;
+    if (stats) {
+        stats->max_depth = max_depth;
+        stats->steps = steps;
+    }
+    return 0;
+}
+
+// Evaluates A(m, n) with frames on the heap, so the only limit is memory. With a
+// cache, sub-results A(m', n') are remembered and reused; that needs a full frame
+// per call so the result can be stored under the frame's own (m, n). Fails with
+// ERANGE if the result does not fit in 64 bits, ENOMEM if the stack cannot grow.
+static inline int rec_ackermann_iter(uint64_t m, uint64_t n, RecMemoCache* cache,
+                                     uint64_t* out, RecStats* stats) {
+    if (cache == NULL) return rec_ackermann_stack_(m, n, out, stats);
+
+    size_t cap = 64, depth = 0, max_depth = 0;
+    uint64_t steps = 0, ret = 0;
+    RecAckFrame_* stack = (RecAckFrame_*)malloc(cap * sizeof(RecAckFrame_));
+    if (stack == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    stack[depth++] = (RecAckFrame_){m, n, 0};
+
+    while (depth > 0) {
+        if (depth > max_depth) max_depth = depth;
+        if (depth == cap) {
+            RecAckFrame_* grown = (RecAckFrame_*)realloc(stack, 2 * cap * sizeof(RecAckFrame_));
+            if (grown == NULL) {
+                free(stack);
+                errno = ENOMEM;
+                return -1;
+            }
+            stack = grown;
+            cap *= 2;
+        }
+        RecAckFrame_* f = &stack[depth - 1];
+        if (f->state == 0) {
+            steps++;
+            if (f->m == 0) {
+                if (f->n == UINT64_MAX) {
+                    free(stack);
+                    errno = ERANGE;
+                    return -1;
+                }
+                ret = f->n + 1;
+                depth--;
+                continue;
+            }
+            if (rec_memo_cache_get(cache, rec_ackermann_key_(f->m, f->n), &ret)) {
+                depth--;
+                continue;
+            }
+            if (f->n == 0) {
+                f->state = 2;  // A(m, 0) = A(m - 1, 1)
+                stack[depth++] = (RecAckFrame_){f->m - 1, 1, 0};
+            } else {
+                f->state = 1;  // A(m, n) = A(m - 1, A(m, n - 1))
+                stack[depth++] = (RecAckFrame_){f->m, f->n - 1, 0};
+            }
+        } else if (f->state == 1) {
+            f->state = 2;
+            stack[depth++] = (RecAckFrame_){f->m - 1, ret, 0};
+        } else {
+            rec_memo_cache_put(cache, rec_ackermann_key_(f->m, f->n), ret);
+            depth--;
+        }
+    }
+    free(stack);
+    *out = ret;
+    if (stats) {
+        stats->max_depth = max_depth;
+        stats->steps = steps;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Tower of Hanoi with an explicit stack
+// ---------------------------------------------------------------------------
+
+#define REC_HANOI_MAX_DISKS 63     // 2^63 - 1 moves already never finishes
+
+typedef void (*RecHanoiMoveFn)(void* ctx, unsigned disk, char from, char to);
+
+typedef struct {
+    unsigned n;
+    char from, to, aux;
+    int state;            // 0: move n - 1 disks aside first, 1: move disk n
+} RecHanoiFrame_;
+
+// Number of moves for n disks, 2^n - 1 (ERANGE for n > 64).
+static inline int rec_hanoi_moves(unsigned n, uint64_t* out) {
+    if (n > 64) {
+        errno = ERANGE;
+        return -1;
+    }
+    *out = n == 64 ? UINT64_MAX : (((uint64_t)1 << n) - 1);
+    return 0;
+}
+
+// Calls move(ctx, disk, from, to) for every move, in the same order as the
+// recursive tower_of_hanoi(). After moving disk n the frame is reused for the
+// second sub-tower (a tail call), so the stack never holds more than n frames.
+static inline int rec_hanoi_iter(unsigned n, char from, char to, char aux,
+                                 RecHanoiMoveFn move, void* ctx, RecStats* stats) {
+    if (n > REC_HANOI_MAX_DISKS) {
+        errno = EINVAL;
+        return -1;
+    }
+    RecHanoiFrame_ stack[REC_HANOI_MAX_DISKS + 1];
+    size_t depth = 0, max_depth = 0;
+    uint64_t steps = 0;
+    stack[depth++] = (RecHanoiFrame_){n, from, to, aux, 0};
+
+    while (depth > 0) {
+        if (depth > max_depth) max_depth = depth;
+        RecHanoiFrame_* f = &stack[depth - 1];
+        if (f->n == 0) {
+            depth--;
+            continue;
+        }
+        steps++;
+        if (f->state == 0) {
+            f->state = 1;
+            stack[depth++] = (RecHanoiFrame_){f->n - 1, f->from, f->aux, f->to, 0};
+        } else {
+            move(ctx, f->n, f->from, f->to);
+            *f = (RecHanoiFrame_){f->n - 1, f->aux, f->to, f->from, 0};
+        }
+    }
+    if (stats) {
+        stats->max_depth = max_depth;
+        stats->steps = steps;
+    }
+    return 0;
+}
+
+#endif // RECURSION_ENGINE_H
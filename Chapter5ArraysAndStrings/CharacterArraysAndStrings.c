@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "../Chapter15AdvancedMemoryManagement/arena.h"
+#include "string_builder.h"
+#include "config_parser.h"
 
 /*
  * Arrays and Strings - Character arrays and strings in C Programming Language
@@ -133,6 +136,38 @@ void demonstrate_safe_strcpy() {
     printf("Safely copied string: %s\n", dest);
 }
 
+// safe_strcpy() still calls strlen() and truncates to a fixed buffer. When a string is
+// built from many pieces, a StringBuilder (string_builder.h) keeps the length next to
+// the bytes: appends never rescan, the buffer grows as needed, and short results stay
+// inside the struct without touching the heap.
+void demonstrate_string_builder() {
+    StringBuilder sb;
+    string_builder_init(&sb);
+
+    string_builder_append_cstr(&sb, "user=alice");
+    printf("Short string stored inline: '%s' (%zu bytes, capacity %zu)\n",
+           string_builder_cstr(&sb), string_builder_length(&sb), sb.capacity);
+
+    const char* tags[] = {"auth", "login", "web", "eu-west"};
+    for (int i = 0; i < 4; i++) {
+        if (string_builder_append_fmt(&sb, " tag%d=%s", i, tags[i]) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            string_builder_destroy(&sb);
+            return;
+        }
+    }
+    string_builder_append_fmt(&sb, " latency=%.2fms status=%d", 12.5, 200);
+    printf("Log record: '%s'\n", string_builder_cstr(&sb));
+    printf("Length %zu read in O(1), capacity grew to %zu\n", string_builder_length(&sb), sb.capacity);
+
+    string_builder_clear(&sb);
+    string_builder_append_cstr(&sb, "   padded value \t\n");
+    string_builder_trim(&sb);
+    printf("Trimmed: '%s' (capacity kept: %zu)\n", string_builder_cstr(&sb), sb.capacity);
+
+    string_builder_destroy(&sb);
+}
+
 /*
  * 4. Integration and Real-World Applications:
  * -------------------------------------------
@@ -188,6 +223,116 @@ void simulate_config_parser() {
     }
 }
 
+// Arena-backed variant: key and value are sized exactly and live in an arena, so
+// there are no fixed-size buffers to overflow and a whole parsed config (one
+// "request") is released with a single arena_reset() instead of per-item frees.
+typedef struct {
+    char* key;
+    char* value;
+} ArenaConfigItem;
+
+int parse_config_line_arena(Arena* arena, const char* line, ArenaConfigItem* item) {
+    const char* equals_pos = strchr(line, '=');
+    if (equals_pos == NULL) {
+        return 0;
+    }
+
+    const char* key_start = line;
+    const char* key_end = equals_pos;
+    while (key_start < key_end && isspace((unsigned char)*key_start)) key_start++;
+    while (key_end > key_start && isspace((unsigned char)key_end[-1])) key_end--;
+
+    const char* value_start = equals_pos + 1;
+    while (*value_start && isspace((unsigned char)*value_start)) value_start++;
+    const char* value_end = value_start + strlen(value_start);
+    while (value_end > value_start && isspace((unsigned char)value_end[-1])) value_end--;
+
+    item->key = arena_strndup(arena, key_start, key_end - key_start);
+    item->value = arena_strndup(arena, value_start, value_end - value_start);
+    return item->key != NULL && item->value != NULL;
+}
+
+void simulate_config_parser_arena() {
+    const char* config_lines[] = {
+        "database_host = localhost",
+        "database_port = 5432",
+        "max_connections = 100",
+        "connection_string = postgres://user@localhost:5432/a_database_name_longer_than_fifty_chars"
+    };
+    const int line_count = sizeof(config_lines) / sizeof(config_lines[0]);
+    Arena arena;
+    arena_init(&arena, 4096);
+
+    // Simulate three reloads; each one reuses the same arena memory
+    for (int reload = 0; reload < 3; reload++) {
+        ArenaConfigItem* items = (ArenaConfigItem*)arena_alloc(&arena, line_count * sizeof(ArenaConfigItem));
+        int item_count = 0;
+        for (int i = 0; items && i < line_count; i++) {
+            if (parse_config_line_arena(&arena, config_lines[i], &items[item_count])) {
+                item_count++;
+            }
+        }
+
+        if (reload == 0) {
+            printf("Parsed configuration (arena):\n");
+            for (int i = 0; i < item_count; i++) {
+                printf("%s: %s\n", items[i].key, items[i].value);
+            }
+        }
+        printf("Reload %d: %d items, %zu arena bytes, %zu chunk(s)\n",
+               reload, item_count, arena_bytes_used(&arena), arena.chunk_count);
+        arena_reset(&arena);  // Drop the whole parse in O(1)
+    }
+
+    arena_destroy(&arena);
+}
+
+// Zero-copy variant: the file is mapped, each key and value is a span into the
+// mapping, and keys are interned in a hash table once. Lookups by id afterwards
+// are array indexing; nothing is copied or allocated per line.
+void simulate_config_parser_spans() {
+    const char* path = "config_parser_demo.conf";
+    const char* text =
+        "# Demo config\n"
+        "database_host = localhost\n"
+        "database_port = 5432\n"
+        "max_connections = 100\n"
+        "connection_string = postgres://user@localhost:5432/a_database_name_longer_than_fifty_chars\n"
+        "this line has no equals sign\n"
+        "max_connections = 250\n";
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        perror("fopen");
+        return;
+    }
+    fputs(text, file);
+    fclose(file);
+
+    ConfigStore store;
+    if (config_store_load_file(&store, path) != 0) {
+        perror("config_store_load_file");
+        remove(path);
+        return;
+    }
+    printf("Parsed configuration (spans, %zu keys, %zu malformed line(s)):\n", store.count, store.errors);
+    for (size_t i = 0; i < store.count; i++) {
+        const ConfigEntry* e = &store.entries[i];
+        printf("%.*s: %.*s (line %zu)\n", (int)e->key.len, e->key.ptr, (int)e->value.len, e->value.ptr, e->line);
+    }
+
+    // Resolve ids once; a hot path would keep these and index store.entries directly
+    size_t port_id = config_store_find(&store, "database_port", strlen("database_port"));
+    const StringSpan* missing = config_store_get(&store, "timeout", strlen("timeout"));
+    if (port_id != CONFIG_NOT_FOUND) {
+        printf("database_port has id %zu, value %.*s\n", port_id, (int)store.entries[port_id].value.len,
+               store.entries[port_id].value.ptr);
+    }
+    printf("timeout is %s\n", missing ? "set" : "not set");
+
+    config_store_destroy(&store);
+    remove(path);
+}
+
 /*
  * 5. FAQs and Troubleshooting:
  * ----------------------------
@@ -225,9 +370,21 @@ int main() {
     printf("-------------------------------\n");
     demonstrate_safe_strcpy();
 
+    printf("\nString Builder Demonstration:\n");
+    printf("-----------------------------\n");
+    demonstrate_string_builder();
+
     printf("\nConfig Parser Simulation:\n");
     printf("-------------------------\n");
     simulate_config_parser();
 
+    printf("\nArena-Backed Config Parser:\n");
+    printf("---------------------------\n");
+    simulate_config_parser_arena();
+
+    printf("\nZero-Copy Config Store:\n");
+    printf("-----------------------\n");
+    simulate_config_parser_spans();
+
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "matrix.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
 
 // Function prototypes
 void overview();
@@ -10,6 +12,7 @@ void best_practices();
 void integration_and_applications();
 void faqs_and_troubleshooting();
 void recommended_tools();
+void performance_analysis();
 
 // 1. Overview
 void overview() {
@@ -91,6 +94,29 @@ void syntax_and_concepts() {
     free(dynamic_matrix);
 
     printf("\n");
+
+    // Contiguous alternative: one aligned allocation, element (i, j) at i * stride + j
+    printf("2.5 Contiguous Matrix (matrix.h)\n\n");
+
+    Matrix m;
+    if (matrix_init(&m, rows, cols) != 0) {
+        perror("matrix_init");
+        return;
+    }
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            MATRIX_AT(&m, i, j) = i * cols + j;
+            printf("%2.0f ", MATRIX_AT(&m, i, j));
+        }
+        printf("\n");
+    }
+    printf("One allocation, row pitch %zu elements (%zu bytes)\n", m.stride, m.stride * sizeof(double));
+
+    Matrix corner;
+    matrix_view(&corner, &m, 1, 1, 2, 2);  // Shares m's storage, no copy
+    printf("View of rows 1-2, cols 1-2: %.0f %.0f / %.0f %.0f\n\n",
+           MATRIX_AT(&corner, 0, 0), MATRIX_AT(&corner, 0, 1), MATRIX_AT(&corner, 1, 0), MATRIX_AT(&corner, 1, 1));
+    matrix_destroy(&m);  // Views are never destroyed
 }
 
 // 3. Best Practices, Common Pitfalls, and Advanced Tips
@@ -256,7 +282,253 @@ void recommended_tools() {
     printf("- OpenMP: For parallel processing of large multi-dimensional arrays\n");
     printf("- Intel MKL: Math Kernel Library for optimized array and matrix operations\n");
     printf("- GNU Scientific Library (GSL): Scientific computing library with array utilities\n");
-    printf("- Boost.MultiArray: C++ library for multi-dimensional arrays (if using C++)\n");
+    printf("- Boost.MultiArray: C++ library for multi-dimensional arrays (if using C++)\n\n");
+}
+
+/*
+7. Performance Analysis: Contiguous vs Row-of-Pointers Matrices
+The benchmarks below run the same arithmetic on a double** version of the
+int** layout from section 2.4 (one malloc per row, same pointer chase) and on
+the contiguous Matrix from matrix.h:
+
+- Multiply at four sizes whose working sets (three matrices) fit in L1, L2, L3
+  and, on most machines, only in DRAM. "row pointers, i-k-j" is the reference:
+  the same loop order on both layouts isolates the layout; the textbook i-j-k
+  order on rows (strided down B's columns) shows what the blocked kernel fixes,
+  and is skipped at the largest size where one run takes seconds.
+- Transpose and element-wise add at a DRAM-sized 2048 x 2048.
+
+Compile with vectorisation enabled to see the kernels at full speed:
+    gcc -O3 -march=native -o multidim MultiDimensionalArrays.c
+At plain -O2 GCC leaves the inner loops scalar and the gaps shrink to the
+memory-layout effect alone.
+*/
+
+typedef struct {
+    size_t n;
+    double** ra;               // Row-of-pointers operands
+    double** rb;
+    double** rc;
+    Matrix a;                  // Contiguous operands
+    Matrix b;
+    Matrix c;
+    MatrixTiles tiles;
+} MatrixBench;
+
+static double** rows_alloc(size_t n) {
+    double** m = (double**)malloc(n * sizeof(double*));
+    if (m == NULL) return NULL;
+    for (size_t i = 0; i < n; i++) {
+        m[i] = (double*)calloc(n, sizeof(double));  // One allocation per row, as 2.4 does for int
+        if (m[i] == NULL) {
+            while (i > 0) free(m[--i]);
+            free(m);
+            return NULL;
+        }
+    }
+    return m;
+}
+
+static void rows_free(double** m, size_t n) {
+    if (m == NULL) return;
+    for (size_t i = 0; i < n; i++) free(m[i]);
+    free(m);
+}
+
+static void matrix_bench_free(MatrixBench* mb) {
+    rows_free(mb->ra, mb->n);
+    rows_free(mb->rb, mb->n);
+    rows_free(mb->rc, mb->n);
+    matrix_destroy(&mb->a);
+    matrix_destroy(&mb->b);
+    matrix_destroy(&mb->c);
+}
+
+// Both layouts get the same pseudo-random values so results can be compared
+static int matrix_bench_init(MatrixBench* mb, size_t n) {
+    memset(mb, 0, sizeof(*mb));
+    mb->n = n;
+    mb->tiles = matrix_default_tiles();
+    mb->ra = rows_alloc(n);
+    mb->rb = rows_alloc(n);
+    mb->rc = rows_alloc(n);
+    if (!mb->ra || !mb->rb || !mb->rc || matrix_init(&mb->a, n, n) != 0 ||
+        matrix_init(&mb->b, n, n) != 0 || matrix_init(&mb->c, n, n) != 0) {
+        matrix_bench_free(mb);
+        return -1;
+    }
+    unsigned int x = 12345;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            x = x * 1103515245u + 12345u;
+            mb->ra[i][j] = MATRIX_AT(&mb->a, i, j) = (double)((x >> 16) % 100) / 10.0;
+            x = x * 1103515245u + 12345u;
+            mb->rb[i][j] = MATRIX_AT(&mb->b, i, j) = (double)((x >> 16) % 100) / 10.0;
+        }
+    }
+    return 0;
+}
+
+void multiply_rows_ijk_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    for (size_t i = 0; i < mb->n; i++) {
+        for (size_t j = 0; j < mb->n; j++) {
+            double sum = 0.0;
+            for (size_t k = 0; k < mb->n; k++) sum += mb->ra[i][k] * mb->rb[k][j];
+            mb->rc[i][j] = sum;
+        }
+    }
+    BENCH_CLOBBER();
+}
+
+void multiply_rows_ikj_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    for (size_t i = 0; i < mb->n; i++) {
+        double* c = mb->rc[i];
+        memset(c, 0, mb->n * sizeof(double));
+        for (size_t k = 0; k < mb->n; k++) {
+            double aik = mb->ra[i][k];
+            const double* b = mb->rb[k];
+            for (size_t j = 0; j < mb->n; j++) c[j] += aik * b[j];
+        }
+    }
+    BENCH_CLOBBER();
+}
+
+void multiply_contiguous_ikj_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    for (size_t i = 0; i < mb->n; i++) {
+        double* c = matrix_row(&mb->c, i);
+        memset(c, 0, mb->n * sizeof(double));
+        for (size_t k = 0; k < mb->n; k++) {
+            double aik = MATRIX_AT(&mb->a, i, k);
+            const double* b = matrix_row(&mb->b, k);
+            for (size_t j = 0; j < mb->n; j++) c[j] += aik * b[j];
+        }
+    }
+    BENCH_CLOBBER();
+}
+
+void multiply_blocked_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    matrix_multiply(&mb->c, &mb->a, &mb->b, &mb->tiles);
+    BENCH_CLOBBER();
+}
+
+void transpose_rows_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    for (size_t i = 0; i < mb->n; i++) {
+        for (size_t j = 0; j < mb->n; j++) mb->rc[j][i] = mb->ra[i][j];
+    }
+    BENCH_CLOBBER();
+}
+
+void transpose_tiled_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    matrix_transpose(&mb->c, &mb->a, 0);
+    BENCH_CLOBBER();
+}
+
+void add_rows_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    for (size_t i = 0; i < mb->n; i++) {
+        for (size_t j = 0; j < mb->n; j++) mb->rc[i][j] = mb->ra[i][j] + mb->rb[i][j];
+    }
+    BENCH_CLOBBER();
+}
+
+void add_contiguous_run(void* ctx) {
+    MatrixBench* mb = (MatrixBench*)ctx;
+    matrix_add(&mb->c, &mb->a, &mb->b);
+    BENCH_CLOBBER();
+}
+
+// Largest difference between the row-pointer result and the contiguous one
+static double matrix_bench_diff(const MatrixBench* mb) {
+    double worst = 0.0;
+    for (size_t i = 0; i < mb->n; i++) {
+        for (size_t j = 0; j < mb->n; j++) {
+            double d = mb->rc[i][j] - MATRIX_AT(&mb->c, i, j);
+            if (d < 0) d = -d;
+            if (d > worst) worst = d;
+        }
+    }
+    return worst;
+}
+
+void performance_analysis() {
+    printf("7. Performance Analysis: Contiguous vs Row-of-Pointers Matrices\n");
+    printf("----------------------------------------------------------------\n");
+
+    static const size_t sizes[] = {32, 128, 512, 1024};
+    static const char* titles[] = {
+        "Multiply 32x32 (working set 24 KB, L1)",
+        "Multiply 128x128 (working set 384 KB, L2)",
+        "Multiply 512x512 (working set 6 MB, L3)",
+        "Multiply 1024x1024 (working set 24 MB, L3 or DRAM)",
+    };
+
+    for (int s = 0; s < 4; s++) {
+        size_t n = sizes[s];
+        MatrixBench mb;
+        if (matrix_bench_init(&mb, n) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return;
+        }
+        uint64_t macs = (uint64_t)n * n * n;
+        BenchSuite suite;
+        bench_suite_init(&suite, titles[s]);
+        bench_suite_run(&suite, "row pointers, i-k-j", multiply_rows_ikj_run, &mb, macs);
+        if (n <= 512) bench_suite_run(&suite, "row pointers, i-j-k", multiply_rows_ijk_run, &mb, macs);
+        bench_suite_run(&suite, "contiguous, i-k-j", multiply_contiguous_ikj_run, &mb, macs);
+        bench_suite_run(&suite, "contiguous, blocked", multiply_blocked_run, &mb, macs);
+        bench_suite_report(&suite);
+
+        multiply_rows_ikj_run(&mb);
+        multiply_blocked_run(&mb);
+        printf("GFLOP/s:");
+        for (int r = 0; r < suite.count; r++) {
+            printf("  %s %.2f", suite.results[r].name, bench_throughput(&suite.results[r], 2.0 * (double)macs) / 1e9);
+        }
+        printf("\nMax difference blocked vs reference: %g\n\n", matrix_bench_diff(&mb));
+        matrix_bench_free(&mb);
+    }
+
+    // Tile-size sweep for the blocked kernel at the L3 size
+    MatrixBench mb;
+    if (matrix_bench_init(&mb, 512) != 0) return;
+    static const MatrixTiles sweep[] = {{16, 64, 64}, {32, 128, 128}, {64, 128, 256}, {64, 256, 512}, {128, 512, 512}};
+    static char names[5][48];
+    BenchSuite tiles;
+    bench_suite_init(&tiles, "Blocked multiply 512x512, tile sizes (m x k x n)");
+    for (int t = 0; t < 5; t++) {
+        snprintf(names[t], sizeof(names[t]), "%zu x %zu x %zu", sweep[t].m, sweep[t].k, sweep[t].n);
+        mb.tiles = sweep[t];
+        bench_suite_run(&tiles, names[t], multiply_blocked_run, &mb, (uint64_t)512 * 512 * 512);
+    }
+    bench_suite_report(&tiles);
+    printf("\n");
+    matrix_bench_free(&mb);
+
+    if (matrix_bench_init(&mb, 2048) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    uint64_t elements = (uint64_t)2048 * 2048;
+    BenchSuite transpose;
+    bench_suite_init(&transpose, "Transpose 2048x2048 (32 MB per matrix)");
+    bench_suite_run(&transpose, "row pointers, naive", transpose_rows_run, &mb, elements);
+    bench_suite_run(&transpose, "contiguous, tiled", transpose_tiled_run, &mb, elements);
+    bench_suite_report(&transpose);
+    printf("Max difference: %g\n\n", matrix_bench_diff(&mb));
+
+    BenchSuite add;
+    bench_suite_init(&add, "Element-wise add 2048x2048");
+    bench_suite_run(&add, "row pointers", add_rows_run, &mb, elements);
+    bench_suite_run(&add, "contiguous", add_contiguous_run, &mb, elements);
+    bench_suite_report(&add);
+    printf("Max difference: %g\n\n", matrix_bench_diff(&mb));
+    matrix_bench_free(&mb);
 }
 
 int main() {
@@ -266,6 +538,7 @@ int main() {
     integration_and_applications();
     faqs_and_troubleshooting();
     recommended_tools();
+    performance_analysis();
 
     return 0;
 }
\ No newline at end of file
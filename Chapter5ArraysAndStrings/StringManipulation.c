@@ -3,7 +3,10 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <assert.h>
-#include <time.h>
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+#include "string_simd.h"
+#include "string_builder.h"
+#include "config_parser.h"
 
 /*
 Table of Contents:
@@ -106,6 +109,14 @@ void string_searching() {
     if (result) {
         printf("'%c' last found at position: %ld\n", ch, result - haystack);
     }
+
+    // The vectorised versions take lengths and return indices (string_simd.h)
+    size_t len = string_length(haystack);
+    printf("string_find: '%s' at %zu (%s kernels)\n", "hay", string_find(haystack, len, "hay", 3),
+           string_kernels()->name);
+    StringByteSet vowels;
+    string_byte_set_init(&vowels, "aeiou");
+    printf("string_find_any: first vowel at %zu\n", string_find_any(haystack, len, &vowels));
 }
 
 // String tokenization
@@ -122,6 +133,19 @@ void string_tokenization() {
         printf("Token: %s\n", token);
         token = strtok(NULL, delim);
     }
+
+    // strtok wrote '\0' over every comma in str and keeps its position in a hidden
+    // static, so it cannot tokenize two strings at once. The tokenizer from
+    // string_simd.h leaves the input alone and returns (pointer, length) spans.
+    const char* csv = "name,,age,city";
+    StringByteSet comma;
+    string_byte_set_init(&comma, ",");
+    StringTokenizer tok;
+    StringSpan field;
+    string_tokenizer_init(&tok, csv, strlen(csv), &comma, STRING_TOKENS_KEEP_EMPTY);
+    while (string_tokenizer_next(&tok, &field)) {
+        printf("Field: '%.*s' (%zu bytes)\n", (int)field.len, field.ptr, field.len);
+    }
 }
 
 // Advanced string manipulation
@@ -150,7 +174,9 @@ void advanced_string_ops() {
     printf("Number converted back to string: %s\n", str);
 }
 
-// Custom string manipulation functions
+// Custom string manipulation functions.
+// These look at one byte per iteration. string_simd.h has word-at-a-time and
+// SSE2/AVX2 versions that test 8 to 64 bytes per iteration; see section 8.
 size_t custom_strlen(const char *str) {
     const char *s;
     for (s = str; *s; ++s);
@@ -186,6 +212,8 @@ Advanced Tips:
 3. Use strdup for dynamic string duplication (remember to free).
 4. Implement your own string class for more complex projects.
 5. Use static analysis tools to catch potential string-related bugs.
+6. Pass lengths around instead of recomputing strlen, and scan with word- or
+   vector-wide loops (string_simd.h) when parsing large inputs.
 */
 
 // Demonstrating best practices and avoiding pitfalls
@@ -250,6 +278,20 @@ void parse_url(const char *url) {
     printf("Schema: %s\nHost: %s\nPath: %s\n", schema, host, path);
 }
 
+// The same split without sscanf or buffers: url_split() (config_parser.h) returns
+// spans into 'url', so there is nothing to overflow and nothing to copy.
+void parse_url_fast(const char *url) {
+    UrlParts parts;
+    if (url_split(url, strlen(url), &parts) != 0) {
+        printf("Not a URL: %s\n", url);
+        return;
+    }
+    printf("Schema: %.*s\nHost: %.*s\nPort: %.*s\nPath: %.*s\nQuery: %.*s\n",
+           (int)parts.scheme.len, parts.scheme.ptr, (int)parts.host.len, parts.host.ptr,
+           (int)parts.port.len, parts.port.ptr, (int)parts.path.len, parts.path.ptr,
+           (int)parts.query.len, parts.query.ptr);
+}
+
 // 5. Advanced Concepts and Emerging Trends
 
 /*
@@ -292,6 +334,8 @@ A: No, gets() is dangerous and removed from C11. Use fgets() instead.
 */
 
 // Troubleshooting example: Trimming whitespace
+// (String lengths are not stored, so this one needs strlen(); string_builder_trim()
+// in string_builder.h trims from both ends of a StringBuilder without it.)
 char *trim(char *str) {
     char *end;
     // Trim leading space
@@ -328,15 +372,22 @@ Further Reading:
 
 // 8. Performance Analysis and Optimization
 
-// Benchmarking function
-double benchmark(void (*func)(void), int iterations) {
-    clock_t start, end;
-    start = clock();
-    for (int i = 0; i < iterations; i++) {
-        func();
+// Benchmarking function: calls func() 'iterations' times per timed run
+typedef struct {
+    void (*func)(void);
+    int iterations;
+} StringBench;
+
+void string_bench_run(void* ctx) {
+    StringBench* bench = (StringBench*)ctx;
+    for (int i = 0; i < bench->iterations; i++) {
+        bench->func();
     }
-    end = clock();
-    return ((double) (end - start)) / CLOCKS_PER_SEC;
+}
+
+void benchmark(BenchSuite* suite, const char* name, void (*func)(void), int iterations) {
+    StringBench bench = {func, iterations};
+    bench_suite_run(suite, name, string_bench_run, &bench, iterations);
 }
 
 // Example functions to benchmark
@@ -344,18 +395,535 @@ void str_copy_test() {
     char src[] = "This is a test string";
     char dest[100];
     strcpy(dest, src);
+    BENCH_DO_NOT_OPTIMIZE(dest);
 }
 
 void str_cat_test() {
     char str[100] = "Hello";
     strcat(str, " World");
+    BENCH_DO_NOT_OPTIMIZE(str);
+}
+
+// Building strings from many pieces. Every strcat() walks the destination to find
+// its end, so appending k pieces costs O(k * length); a StringBuilder keeps the
+// length and appends in place.
+#define LOG_FIELDS 32
+#define LOG_RECORDS 1000
+#define LOG_RECORD_BYTES 1024
+
+typedef enum { BUILD_STRCAT, BUILD_SNPRINTF_OFFSET, BUILD_STRING_BUILDER } BuildMethod;
+
+typedef struct {
+    BuildMethod method;
+    int words;       // Words per string for the concatenation suite; 0 = log records
+    char* buffer;    // strcat / snprintf destination, large enough for any result
+    StringBuilder* sb;
+    size_t bytes;    // Output bytes per run, filled in by the first run
+} BuildBench;
+
+static const char* const log_keys[8] = {"host", "pid", "user", "path", "status", "bytes", "ms", "trace"};
+static const char* const concat_words[8] = {"alpha ", "beta ", "gamma ", "delta ",
+                                            "epsilon ", "zeta ", "eta ", "theta "};
+
+// One structured log record: LOG_FIELDS "key=value" pairs, half strings, half numbers.
+// Every method formats each field with the same printf format and produces the
+// same bytes; only the way the pieces are joined differs.
+static size_t build_log_record(const BuildBench* b, int record) {
+    char* out = b->buffer;
+    switch (b->method) {
+        case BUILD_STRCAT: {
+            char field[64];
+            out[0] = '\0';
+            for (int f = 0; f < LOG_FIELDS; f++) {
+                if (f & 1) {
+                    sprintf(field, "%s=%d ", log_keys[f & 7], record * 31 + f);
+                } else {
+                    sprintf(field, "%s=%s", log_keys[f & 7], concat_words[(record + f) & 7]);
+                }
+                strcat(out, field);
+            }
+            return strlen(out);
+        }
+        case BUILD_SNPRINTF_OFFSET: {
+            size_t used = 0;
+            for (int f = 0; f < LOG_FIELDS; f++) {
+                if (f & 1) {
+                    used += (size_t)snprintf(out + used, LOG_RECORD_BYTES - used, "%s=%d ", log_keys[f & 7], record * 31 + f);
+                } else {
+                    used += (size_t)snprintf(out + used, LOG_RECORD_BYTES - used, "%s=%s", log_keys[f & 7],
+                                             concat_words[(record + f) & 7]);
+                }
+            }
+            return used;
+        }
+        case BUILD_STRING_BUILDER: {
+            StringBuilder* sb = b->sb;
+            string_builder_clear(sb);
+            for (int f = 0; f < LOG_FIELDS; f++) {
+                if (f & 1) {
+                    string_builder_append_fmt(sb, "%s=%d ", log_keys[f & 7], record * 31 + f);
+                } else {
+                    string_builder_append_fmt(sb, "%s=%s", log_keys[f & 7], concat_words[(record + f) & 7]);
+                }
+            }
+            BENCH_DO_NOT_OPTIMIZE(*string_builder_cstr(sb));
+            return string_builder_length(sb);
+        }
+    }
+    return 0;
+}
+
+static void build_bench_run(void* ctx) {
+    BuildBench* b = (BuildBench*)ctx;
+    size_t bytes = 0;
+    if (b->words == 0) {
+        for (int r = 0; r < LOG_RECORDS; r++) bytes += build_log_record(b, r);
+    } else if (b->method == BUILD_STRCAT) {
+        b->buffer[0] = '\0';
+        for (int w = 0; w < b->words; w++) strcat(b->buffer, concat_words[w & 7]);
+        bytes = strlen(b->buffer);
+    } else {
+        string_builder_clear(b->sb);
+        for (int w = 0; w < b->words; w++) string_builder_append_cstr(b->sb, concat_words[w & 7]);
+        bytes = string_builder_length(b->sb);
+    }
+    BENCH_DO_NOT_OPTIMIZE(bytes);
+    b->bytes = bytes;
+}
+
+static void builder_performance(void) {
+    enum { MAX_WORDS = 10000 };
+    char* buffer = (char*)malloc(MAX_WORDS * 9 + LOG_RECORD_BYTES);
+    StringBuilder sb;
+    if (buffer == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    string_builder_init(&sb);
+
+    BenchSuite suite;
+    BuildBench log_cases[3] = {
+        {BUILD_STRCAT, 0, buffer, &sb, 0},
+        {BUILD_SNPRINTF_OFFSET, 0, buffer, &sb, 0},
+        {BUILD_STRING_BUILDER, 0, buffer, &sb, 0},
+    };
+    bench_suite_init(&suite, "Log records, 32 fields each");
+    bench_suite_run(&suite, "sprintf + strcat", build_bench_run, &log_cases[0], LOG_RECORDS);
+    bench_suite_run(&suite, "snprintf offset", build_bench_run, &log_cases[1], LOG_RECORDS);
+    bench_suite_run(&suite, "StringBuilder", build_bench_run, &log_cases[2], LOG_RECORDS);
+    bench_suite_report(&suite);
+    char expected[LOG_RECORD_BYTES];
+    build_log_record(&log_cases[0], 7);
+    memcpy(expected, buffer, strlen(buffer) + 1);
+    build_log_record(&log_cases[1], 7);
+    int same = strcmp(buffer, expected) == 0;
+    build_log_record(&log_cases[2], 7);
+    same = same && strcmp(string_builder_cstr(&sb), expected) == 0;
+    printf("All three build the same record: %s\n\n", same ? "yes" : "NO");
+
+    static const int word_counts[2] = {1000, MAX_WORDS};
+    static const char* const concat_titles[2] = {"Concatenate 1000 words", "Concatenate 10000 words"};
+    for (int i = 0; i < 2; i++) {
+        BuildBench strcat_case = {BUILD_STRCAT, word_counts[i], buffer, &sb, 0};
+        BuildBench builder_case = {BUILD_STRING_BUILDER, word_counts[i], buffer, &sb, 0};
+        bench_suite_init(&suite, concat_titles[i]);
+        bench_suite_run(&suite, "strcat", build_bench_run, &strcat_case, word_counts[i]);
+        bench_suite_run(&suite, "StringBuilder", build_bench_run, &builder_case, word_counts[i]);
+        bench_suite_report(&suite);
+        for (int j = 0; j < suite.count; j++) {
+            printf("  %-16s %7.2f GB/s\n", suite.results[j].name,
+                   bench_throughput(&suite.results[j], (double)strcat_case.bytes) / 1e9);
+        }
+        printf("\n");
+    }
+
+    string_builder_destroy(&sb);
+    free(buffer);
+}
+
+// Config reload and URL splitting. The copying parser mirrors parse_config_line() in
+// CharacterArraysAndStrings.c: the line is copied out, then key and value are copied
+// into fixed arrays and trimmed with memmove. The span parser reads the text in place.
+#define CONFIG_LINES 100000
+#define CONFIG_LOOKUPS 200
+#define URL_COUNT 4096
+
+typedef struct {
+    char key[50];
+    char value[100];
+} CopiedConfigItem;
+
+typedef enum { CONFIG_COPY, CONFIG_READER, CONFIG_STORE_LOAD, CONFIG_LOOKUP_LINEAR, CONFIG_LOOKUP_STORE,
+               URL_SSCANF, URL_SPLIT } ConfigOp;
+
+typedef struct {
+    ConfigOp op;
+    const char* text;
+    size_t len;
+    CopiedConfigItem* items;   // CONFIG_LINES slots for the copying parser
+    size_t item_count;
+    ConfigStore* store;        // Loaded once, for the lookup cases
+    char (*keys)[32];          // CONFIG_LOOKUPS keys to look up
+    char (*urls)[96];          // URL_COUNT URLs
+} ConfigBench;
+
+static size_t copy_parse_config(const char* text, size_t len, CopiedConfigItem* items) {
+    size_t count = 0;
+    const char* p = text;
+    const char* end = text + len;
+    char line[256];
+    while (p < end && count < CONFIG_LINES) {
+        const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        size_t n = (size_t)((nl ? nl : end) - p);
+        if (n >= sizeof(line)) n = sizeof(line) - 1;
+        memcpy(line, p, n);
+        line[n] = '\0';
+        p = nl ? nl + 1 : end;
+
+        char* equals_pos = strchr(line, '=');
+        if (equals_pos == NULL || line[0] == '#') continue;
+        CopiedConfigItem* item = &items[count++];
+        size_t key_length = (size_t)(equals_pos - line);
+        if (key_length >= sizeof(item->key)) key_length = sizeof(item->key) - 1;
+        strncpy(item->key, line, key_length);
+        item->key[key_length] = '\0';
+        strncpy(item->value, equals_pos + 1, sizeof(item->value) - 1);
+        item->value[sizeof(item->value) - 1] = '\0';
+        char* key_end = item->key + strlen(item->key) - 1;
+        while (key_end > item->key && isspace((unsigned char)*key_end)) *key_end-- = '\0';
+        char* start = item->value;
+        while (*start && isspace((unsigned char)*start)) start++;
+        memmove(item->value, start, strlen(start) + 1);
+    }
+    return count;
+}
+
+static void config_bench_run(void* ctx) {
+    ConfigBench* b = (ConfigBench*)ctx;
+    size_t r = 0;
+    switch (b->op) {
+        case CONFIG_COPY:
+            r = copy_parse_config(b->text, b->len, b->items);
+            BENCH_CLOBBER();
+            break;
+        case CONFIG_READER: {
+            ConfigReader reader;
+            ConfigEntry entry;
+            config_reader_init(&reader, b->text, b->len);
+            while (config_reader_next(&reader, &entry)) r += entry.value.len;
+            break;
+        }
+        case CONFIG_STORE_LOAD: {
+            ConfigStore store;
+            config_store_init(&store);
+            if (config_store_load(&store, b->text, b->len) == 0) r = store.count;
+            config_store_destroy(&store);
+            break;
+        }
+        case CONFIG_LOOKUP_LINEAR:
+            for (int i = 0; i < CONFIG_LOOKUPS; i++) {
+                for (size_t j = 0; j < b->item_count; j++) {
+                    if (strcmp(b->items[j].key, b->keys[i]) == 0) {
+                        r += j;
+                        break;
+                    }
+                }
+            }
+            break;
+        case CONFIG_LOOKUP_STORE:
+            for (int i = 0; i < CONFIG_LOOKUPS; i++) {
+                r += config_store_find(b->store, b->keys[i], strlen(b->keys[i]));
+            }
+            break;
+        case URL_SSCANF:
+            for (int i = 0; i < URL_COUNT; i++) {
+                char schema[10], host[100], path[100];
+                if (sscanf(b->urls[i], "%9[^:]://%99[^/]/%99[^\n]", schema, host, path) == 3) r += strlen(host);
+            }
+            break;
+        case URL_SPLIT:
+            for (int i = 0; i < URL_COUNT; i++) {
+                UrlParts parts;
+                if (url_split(b->urls[i], strlen(b->urls[i]), &parts) == 0) r += parts.host.len;
+            }
+            break;
+    }
+    BENCH_DO_NOT_OPTIMIZE(r);
+}
+
+static void config_performance(void) {
+    char* text = (char*)malloc((size_t)CONFIG_LINES * 80);
+    CopiedConfigItem* items = (CopiedConfigItem*)malloc(CONFIG_LINES * sizeof(CopiedConfigItem));
+    char (*keys)[32] = (char (*)[32])malloc(CONFIG_LOOKUPS * sizeof(*keys));
+    char (*urls)[96] = (char (*)[96])malloc(URL_COUNT * sizeof(*urls));
+    ConfigStore store;
+    config_store_init(&store);
+    if (text == NULL || items == NULL || keys == NULL || urls == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(text);
+        free(items);
+        free(keys);
+        free(urls);
+        return;
+    }
+    static const char* const settings[] = {"host", "port", "timeout_ms", "max_connections", "log_level"};
+    size_t len = 0;
+    unsigned int x = 7;
+    for (int i = 0; i < CONFIG_LINES; i++) {
+        if (i % 50 == 0) len += (size_t)sprintf(text + len, "# section %d\n", i / 50);
+        x = x * 1103515245u + 12345u;
+        len += (size_t)sprintf(text + len, "service%d.%s = value-%u %s\n", i / 5, settings[i % 5], x >> 8,
+                               (x >> 4) % 3 == 0 ? "with a longer tail of words" : "");
+    }
+    for (int i = 0; i < CONFIG_LOOKUPS; i++) {
+        x = x * 1103515245u + 12345u;
+        int line = (int)((x >> 8) % CONFIG_LINES);
+        sprintf(keys[i], "service%d.%s", line / 5, settings[line % 5]);
+    }
+    for (int i = 0; i < URL_COUNT; i++) {
+        x = x * 1103515245u + 12345u;
+        sprintf(urls[i], "https://api%u.example.com/v%u/items/%u?page=%u", (x >> 20) % 64, (x >> 8) % 4, x >> 12,
+                (x >> 4) % 100);
+    }
+    size_t item_count = copy_parse_config(text, len, items);
+    if (config_store_load(&store, text, len) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+    }
+
+    BenchSuite suite;
+    ConfigBench base = {CONFIG_COPY, text, len, items, item_count, &store, keys, urls};
+    ConfigBench cases[3] = {base, base, base};
+    cases[1].op = CONFIG_READER;
+    cases[2].op = CONFIG_STORE_LOAD;
+    bench_suite_init(&suite, "Parse 100000 config lines");
+    bench_suite_run(&suite, "copy + strncpy", config_bench_run, &cases[0], CONFIG_LINES);
+    bench_suite_run(&suite, "ConfigReader", config_bench_run, &cases[1], CONFIG_LINES);
+    bench_suite_run(&suite, "ConfigStore load", config_bench_run, &cases[2], CONFIG_LINES);
+    bench_suite_report(&suite);
+    for (int i = 0; i < suite.count; i++) {
+        printf("  %-16s %7.2f GB/s\n", suite.results[i].name, bench_throughput(&suite.results[i], (double)len) / 1e9);
+    }
+    printf("\n");
+
+    cases[0].op = CONFIG_LOOKUP_LINEAR;
+    cases[1].op = CONFIG_LOOKUP_STORE;
+    bench_suite_init(&suite, "Look up 200 keys among 100000");
+    bench_suite_run(&suite, "linear strcmp", config_bench_run, &cases[0], CONFIG_LOOKUPS);
+    bench_suite_run(&suite, "ConfigStore", config_bench_run, &cases[1], CONFIG_LOOKUPS);
+    bench_suite_report(&suite);
+    printf("\n");
+
+    cases[0].op = URL_SSCANF;
+    cases[1].op = URL_SPLIT;
+    bench_suite_init(&suite, "Split 4096 URLs");
+    bench_suite_run(&suite, "sscanf", config_bench_run, &cases[0], URL_COUNT);
+    bench_suite_run(&suite, "url_split", config_bench_run, &cases[1], URL_COUNT);
+    bench_suite_report(&suite);
+    printf("\n");
+
+    config_store_destroy(&store);
+    free(text);
+    free(items);
+    free(keys);
+    free(urls);
+}
+
+// Scanning benchmarks: the same work over many short strings and over one long
+// one. Short strings measure start-up cost (alignment, tails, the call); long
+// strings measure the steady-state loop. Nothing in the text matches, so every
+// function reads every byte.
+#define SHORT_STRING_COUNT 4096
+#define LONG_STRING_BYTES (1u << 20)
+#define IMPL_CUSTOM (-2)  // custom_strlen / strtok_r
+#define IMPL_LIBC (-1)    // strlen, memchr, strcspn, strstr
+
+typedef enum { SCAN_LENGTH, SCAN_FIND_BYTE, SCAN_FIND_ANY, SCAN_FIND, SCAN_TOKENIZE } ScanOp;
+
+typedef struct {
+    ScanOp op;
+    int impl;                  // IMPL_CUSTOM, IMPL_LIBC or a StringVariant
+    const StringKernels* kernels;
+    char* const* strings;
+    const size_t* lengths;
+    size_t count;
+    const StringByteSet* set;  // The delimiters, also as a string for strcspn/strtok_r
+    const char* set_string;
+    char* scratch;             // strtok_r writes into a copy
+} ScanBench;
+
+static const char scan_needle[] = "zqxj";
+
+void scan_bench_run(void* ctx) {
+    const ScanBench* b = (const ScanBench*)ctx;
+    size_t total = 0;
+    for (size_t i = 0; i < b->count; i++) {
+        const char* s = b->strings[i];
+        size_t n = b->lengths[i], r = 0;
+        switch (b->op) {
+            case SCAN_LENGTH:
+                if (b->impl == IMPL_CUSTOM) r = custom_strlen(s);
+                else if (b->impl == IMPL_LIBC) r = strlen(s);
+                else r = b->kernels->length(s);
+                break;
+            case SCAN_FIND_BYTE:
+                if (b->impl == IMPL_LIBC) r = memchr(s, '\n', n) != NULL;
+                else r = b->kernels->find_byte(s, n, '\n');
+                break;
+            case SCAN_FIND_ANY:
+                if (b->impl == IMPL_LIBC) r = strcspn(s, b->set_string);
+                else r = b->kernels->find_any(s, n, b->set);
+                break;
+            case SCAN_FIND:
+                if (b->impl == IMPL_LIBC) r = strstr(s, scan_needle) != NULL;
+                else r = b->kernels->find(s, n, scan_needle, sizeof(scan_needle) - 1);
+                break;
+            case SCAN_TOKENIZE:
+                if (b->impl == IMPL_CUSTOM) {
+                    char* save = NULL;
+                    memcpy(b->scratch, s, n + 1);
+                    for (char* t = strtok_r(b->scratch, b->set_string, &save); t; t = strtok_r(NULL, b->set_string, &save)) {
+                        r += (size_t)(t[0] == 'a');
+                    }
+                } else {
+                    StringTokenizer tok;
+                    StringSpan word;
+                    string_tokenizer_init(&tok, s, n, b->set, STRING_TOKENS_SKIP_EMPTY);
+                    while (string_tokenizer_next(&tok, &word)) r += (size_t)(word.ptr[0] == 'a');
+                }
+                break;
+        }
+        total += r;
+    }
+    BENCH_DO_NOT_OPTIMIZE(total);
+}
+
+static void scan_suite(const char* title, ScanBench* base, const int* baselines, const char* const* baseline_names,
+                       int baseline_count, double bytes) {
+    BenchSuite suite;
+    ScanBench cases[2 + STRING_VARIANT_COUNT];
+    int count = 0;
+    bench_suite_init(&suite, title);
+    for (int i = 0; i < baseline_count; i++) {
+        cases[count] = *base;
+        cases[count].impl = baselines[i];
+        bench_suite_run(&suite, baseline_names[i], scan_bench_run, &cases[count], base->count);
+        count++;
+    }
+    for (int v = 0; v < STRING_VARIANT_COUNT; v++) {
+        cases[count] = *base;
+        cases[count].impl = v;
+        cases[count].kernels = string_kernels_for((StringVariant)v);
+        if (cases[count].kernels == NULL) continue;
+        bench_suite_run(&suite, cases[count].kernels->name, scan_bench_run, &cases[count], base->count);
+        count++;
+    }
+    bench_suite_report(&suite);
+    for (int i = 0; i < suite.count; i++) {
+        printf("  %-16s %7.2f GB/s\n", suite.results[i].name, bench_throughput(&suite.results[i], bytes) / 1e9);
+    }
+    printf("\n");
+}
+
+static void scan_performance(void) {
+    // Lower-case words separated by spaces: no newline, no ',', ';' or '\t' and no "zqxj"
+    char* pool = (char*)malloc(SHORT_STRING_COUNT * 64 + LONG_STRING_BYTES + 1);
+    char* scratch = (char*)malloc(LONG_STRING_BYTES + 1);
+    char** strings = (char**)malloc((SHORT_STRING_COUNT + 1) * sizeof(char*));
+    size_t* lengths = (size_t*)malloc((SHORT_STRING_COUNT + 1) * sizeof(size_t));
+    if (pool == NULL || scratch == NULL || strings == NULL || lengths == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(pool);
+        free(scratch);
+        free(strings);
+        free(lengths);
+        return;
+    }
+    unsigned int x = 2024;
+    char* p = pool;
+    size_t short_bytes = 0;
+    for (size_t i = 0; i <= SHORT_STRING_COUNT; i++) {
+        x = x * 1103515245u + 12345u;
+        size_t n = i < SHORT_STRING_COUNT ? 8 + (x >> 16) % 56 : LONG_STRING_BYTES;
+        strings[i] = p;
+        lengths[i] = n;
+        for (size_t j = 0; j < n; j++) {
+            x = x * 1103515245u + 12345u;
+            p[j] = (x >> 16) % 6 == 0 ? ' ' : (char)('a' + (x >> 20) % 26);
+            if (p[j] == 'z' && j > 0 && p[j - 1] == 'z') p[j] = 'y';
+        }
+        p[n] = '\0';
+        if (i < SHORT_STRING_COUNT) short_bytes += n;
+        p += n + 1;
+    }
+    // Scrub the needle; its first and last letters still appear, as in real text
+    for (char* q = pool; (q = strstr(q, scan_needle)) != NULL;) q[1] = 'y';
+
+    StringByteSet delims, spaces;
+    string_byte_set_init(&delims, ",;\t\n");
+    string_byte_set_init(&spaces, " ,");
+
+    static const char* const titles[2][4] = {
+        {"strlen, 4096 strings of 8-63 bytes", "memchr, 4096 strings of 8-63 bytes",
+         "strcspn (4 delimiters), 4096 strings of 8-63 bytes", "strstr, 4096 strings of 8-63 bytes"},
+        {"strlen, one 1 MB string", "memchr, one 1 MB string", "strcspn (4 delimiters), one 1 MB string",
+         "strstr, one 1 MB string"},
+    };
+    static const int libc_only[] = {IMPL_LIBC};
+    static const int with_custom[] = {IMPL_CUSTOM, IMPL_LIBC};
+    static const char* const libc_name[] = {"libc"};
+    static const char* const strlen_names[] = {"custom_strlen", "libc strlen"};
+    for (int size = 0; size < 2; size++) {
+        ScanBench base = {SCAN_LENGTH, IMPL_LIBC, NULL, size ? strings + SHORT_STRING_COUNT : strings,
+                          size ? lengths + SHORT_STRING_COUNT : lengths, size ? 1 : SHORT_STRING_COUNT,
+                          &delims, ",;\t\n", scratch};
+        double bytes = size ? (double)LONG_STRING_BYTES : (double)short_bytes;
+        for (int op = SCAN_LENGTH; op <= SCAN_FIND; op++) {
+            base.op = (ScanOp)op;
+            if (op == SCAN_LENGTH) {
+                scan_suite(titles[size][op], &base, with_custom, strlen_names, 2, bytes);
+            } else {
+                scan_suite(titles[size][op], &base, libc_only, libc_name, 1, bytes);
+            }
+        }
+    }
+
+    // Tokenizing the long string on spaces and commas. strtok_r needs a writable copy;
+    // the memcpy is included and costs about 2% of the strtok_r time.
+    BenchSuite suite;
+    ScanBench strtok_case = {SCAN_TOKENIZE, IMPL_CUSTOM, NULL, strings + SHORT_STRING_COUNT,
+                             lengths + SHORT_STRING_COUNT, 1, &spaces, " ,", scratch};
+    ScanBench tokenizer_case = strtok_case;
+    tokenizer_case.impl = IMPL_LIBC;
+    bench_suite_init(&suite, "Tokenize one 1 MB string");
+    bench_suite_run(&suite, "strtok_r (copy)", scan_bench_run, &strtok_case, 1);
+    bench_suite_run(&suite, "StringTokenizer", scan_bench_run, &tokenizer_case, 1);
+    bench_suite_report(&suite);
+    for (int i = 0; i < suite.count; i++) {
+        printf("  %-16s %7.2f GB/s\n", suite.results[i].name,
+               bench_throughput(&suite.results[i], (double)LONG_STRING_BYTES) / 1e9);
+    }
+
+    free(pool);
+    free(scratch);
+    free(strings);
+    free(lengths);
 }
 
 // Performance comparison
 void performance_comparison() {
-    printf("Benchmarking string operations:\n");
-    printf("strcpy: %f seconds\n", benchmark(str_copy_test, 1000000));
-    printf("strcat: %f seconds\n", benchmark(str_cat_test, 1000000));
+    BenchSuite suite;
+
+    bench_suite_init(&suite, "String operations");
+    benchmark(&suite, "strcpy", str_copy_test, 1000000);
+    benchmark(&suite, "strcat", str_cat_test, 1000000);
+    bench_suite_report(&suite);
+    printf("\n");
+
+    builder_performance();
+    config_performance();
+
+    printf("Scanning with string_simd.h (%s kernels active):\n\n", string_kernels()->name);
+    scan_performance();
 }
 
 // 9. How to Contribute
@@ -415,6 +983,8 @@ int main() {
     printf("URL Parsing Example:\n");
     parse_url("https://www.example.com/path/to/resource");
     printf("\n");
+    parse_url_fast("https://user@www.example.com:8443/path/to/resource?lang=en#top");
+    printf("\n");
 
     printf("Unicode Example:\n");
     unicode_example();
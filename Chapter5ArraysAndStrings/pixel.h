@@ -0,0 +1,648 @@
+/*
+pixel.h - Fixed-Point Grayscale Conversion for Interleaved and Planar Images
+================================================
+
+image_processing_demo() in 1DArrays.c converts a 3x3 image with three double
+multiplications per pixel. This header converts images of any size in any of
+three layouts, with integer luma weights and SIMD row kernels:
+
+    PIXEL_RGB24         r g b r g b ...       one buffer, 3 bytes per pixel
+    PIXEL_RGBA32        r g b a r g b a ...   one buffer, 4 bytes per pixel (alpha ignored)
+    PIXEL_PLANAR_RGB    rrr... ggg... bbb...  three buffers, 1 byte per pixel each
+
+Usage:
+    PixelImage src;
+    pixel_image_interleaved(&src, PIXEL_RGB24, rgb, width, height, 0);  // 0: rows are packed
+    GrayImage dst = {gray, width, height, width};
+
+    pixel_to_gray(&src, &dst);                      // 0, or -1 with errno = EINVAL
+    pixel_to_gray_parallel(&pool, &src, &dst);      // Rows split across a ThreadPool
+    pixel_batch_to_gray(&pool, srcs, dsts, count);  // Many small images, one per task
+
+    // A raw RGB24 file of any size, mapped and converted one band of rows at a time
+    pixel_stream_to_gray("in.rgb", "out.gray", PIXEL_RGB24, width, height, 0, &pool);
+
+Design:
+- Luma uses the BT.709 weights (0.2126, 0.7152, 0.0722) in Q8: 54, 183 and 19,
+  which sum to 256, so white stays 255. y = (54r + 183g + 19b + 128) >> 8 is
+  rounded, never exceeds 65535 and so runs in 16-bit SIMD lanes.
+- Row kernels exist in four variants: scalar, ssse3 (16 pixels per step),
+  avx2 (32 pixels per step) and neon (16 pixels per step, AArch64/ARMv7 only).
+  Each SIMD loop finishes the last width % step pixels with the scalar kernel,
+  so any width and any row stride work. Variants are chosen at startup as in
+  string_simd.h; PIXEL_SIMD_VARIANT=<name> in the environment forces one.
+- RGB24 is deinterleaved with three pshufb masks per channel (Intel) or vld3q
+  (NEON). RGBA32 splits each 32-bit pixel into (r, b) and (g, a) 16-bit pairs
+  and weights them with pmaddwd, so no shuffles are needed.
+- Row parallelism uses parallel_for() from thread_pool.h. Rows are handed out
+  in chunks of about 64 KB of source. For thumbnails, one image per task
+  (pixel_batch_to_gray) beats splitting a 100-row image across threads.
+- pixel_stream_to_gray() maps one band of rows of the input and the output at
+  a time (page-aligned windows), converts the band and unmaps it. Address space
+  and resident memory stay at about two bands whatever the image size, and the
+  input's page cache is dropped behind the band with posix_fadvise().
+  Streaming supports the interleaved formats; the file must hold exactly
+  width * height * bytes-per-pixel bytes.
+- Functions return 0, or -1 with errno: EINVAL for mismatched sizes or an
+  unknown format, or the error from open()/mmap().
+
+Compile with: gcc -O2 -pthread file.c   (GCC 8+ or Clang 7+)
+*/
+
+#ifndef PIXEL_H
+#define PIXEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../Chapter16MultithreadingAndConcurrency/thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PIXEL_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define PIXEL_LUMA_R 54
+#define PIXEL_LUMA_G 183
+#define PIXEL_LUMA_B 19
+
+#define PIXEL_CHUNK_BYTES (64 * 1024)        // Source bytes per parallel_for chunk
+#define PIXEL_STREAM_BAND_BYTES (8u << 20)   // Default source bytes per streamed band
+
+typedef enum {
+    PIXEL_RGB24,
+    PIXEL_RGBA32,
+    PIXEL_PLANAR_RGB,
+    PIXEL_FORMAT_COUNT
+} PixelFormat;
+
+typedef struct {
+    PixelFormat format;
+    size_t width;
+    size_t height;
+    const uint8_t* planes[3];   // Interleaved formats use planes[0] only
+    size_t stride;              // Bytes from one row to the next (in every plane)
+} PixelImage;
+
+typedef struct {
+    uint8_t* data;
+    size_t width;
+    size_t height;
+    size_t stride;
+} GrayImage;
+
+typedef enum {
+    PIXEL_SCALAR,
+    PIXEL_SSSE3,
+    PIXEL_AVX2,
+    PIXEL_NEON,
+    PIXEL_VARIANT_COUNT
+} PixelVariant;
+
+typedef void (*PixelInterleavedFn)(const uint8_t* src, uint8_t* dst, size_t n);
+typedef void (*PixelPlanarFn)(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* dst, size_t n);
+
+typedef struct {
+    const char* name;
+    PixelInterleavedFn rgb24;
+    PixelInterleavedFn rgba32;
+    PixelPlanarFn planar;
+} PixelKernels;
+
+// Bytes per pixel in the buffer (per plane for PIXEL_PLANAR_RGB), 0 if unknown.
+static inline size_t pixel_bytes_per_pixel(PixelFormat format) {
+    switch (format) {
+        case PIXEL_RGB24: return 3;
+        case PIXEL_RGBA32: return 4;
+        case PIXEL_PLANAR_RGB: return 1;
+        default: return 0;
+    }
+}
+
+// stride == 0 means rows are packed (width * bytes per pixel).
+static inline void pixel_image_interleaved(PixelImage* img, PixelFormat format, const void* data,
+                                           size_t width, size_t height, size_t stride) {
+    img->format = format;
+    img->width = width;
+    img->height = height;
+    img->planes[0] = (const uint8_t*)data;
+    img->planes[1] = img->planes[2] = NULL;
+    img->stride = stride ? stride : width * pixel_bytes_per_pixel(format);
+}
+
+static inline void pixel_image_planar(PixelImage* img, const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                      size_t width, size_t height, size_t stride) {
+    img->format = PIXEL_PLANAR_RGB;
+    img->width = width;
+    img->height = height;
+    img->planes[0] = r;
+    img->planes[1] = g;
+    img->planes[2] = b;
+    img->stride = stride ? stride : width;
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels
+// ---------------------------------------------------------------------------
+
+static inline uint8_t pixel_luma(unsigned r, unsigned g, unsigned b) {
+    return (uint8_t)((r * PIXEL_LUMA_R + g * PIXEL_LUMA_G + b * PIXEL_LUMA_B + 128) >> 8);
+}
+
+static void pixel_scalar_rgb24_(const uint8_t* src, uint8_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++, src += 3) dst[i] = pixel_luma(src[0], src[1], src[2]);
+}
+
+static void pixel_scalar_rgba32_(const uint8_t* src, uint8_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++, src += 4) dst[i] = pixel_luma(src[0], src[1], src[2]);
+}
+
+static void pixel_scalar_planar_(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = pixel_luma(r[i], g[i], b[i]);
+}
+
+// ---------------------------------------------------------------------------
+// x86 variants
+// ---------------------------------------------------------------------------
+
+#ifdef PIXEL_HAVE_X86
+
+#define PIXEL_TARGET_SSSE3_ __attribute__((target("ssse3")))
+#define PIXEL_TARGET_AVX2_ __attribute__((target("avx2")))
+
+// pshufb masks that gather one channel of 16 RGB24 pixels from the three
+// 16-byte blocks a, b, c holding them. -1 zeroes the byte; the three results
+// are ORed together.
+#define PIXEL_Z_ -1
+#define PIXEL_RGB24_MASKS_(SET)                                                                              \
+    {SET(0, 3, 6, 9, 12, 15, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, \
+         PIXEL_Z_, PIXEL_Z_),                                                                                \
+     SET(PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, 2, 5, 8, 11, 14, PIXEL_Z_, PIXEL_Z_,     \
+         PIXEL_Z_, PIXEL_Z_, PIXEL_Z_),                                                                      \
+     SET(PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, \
+         PIXEL_Z_, 1, 4, 7, 10, 13),                                                                         \
+     SET(1, 4, 7, 10, 13, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_,    \
+         PIXEL_Z_, PIXEL_Z_, PIXEL_Z_),                                                                      \
+     SET(PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, 0, 3, 6, 9, 12, 15, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, \
+         PIXEL_Z_, PIXEL_Z_),                                                                                \
+     SET(PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, \
+         PIXEL_Z_, 2, 5, 8, 11, 14),                                                                         \
+     SET(2, 5, 8, 11, 14, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_,    \
+         PIXEL_Z_, PIXEL_Z_, PIXEL_Z_),                                                                      \
+     SET(PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, 1, 4, 7, 10, 13, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_,    \
+         PIXEL_Z_, PIXEL_Z_, PIXEL_Z_),                                                                      \
+     SET(PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, PIXEL_Z_, \
+         0, 3, 6, 9, 12, 15)}
+
+// ----- SSSE3 -----
+
+static inline PIXEL_TARGET_SSSE3_ __m128i pixel_sse_luma16_(__m128i r, __m128i g, __m128i b) {
+    __m128i y = _mm_mullo_epi16(r, _mm_set1_epi16(PIXEL_LUMA_R));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(g, _mm_set1_epi16(PIXEL_LUMA_G)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(PIXEL_LUMA_B)));
+    return _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);  // Unsigned: the sum can pass 32767
+}
+
+// 16 channel bytes each in r, g, b -> 16 gray bytes
+static inline PIXEL_TARGET_SSSE3_ __m128i pixel_sse_luma8_(__m128i r, __m128i g, __m128i b) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = pixel_sse_luma16_(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(b, zero));
+    __m128i hi = pixel_sse_luma16_(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(b, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+static PIXEL_TARGET_SSSE3_ void pixel_ssse3_rgb24_(const uint8_t* src, uint8_t* dst, size_t n) {
+    const __m128i m[9] = PIXEL_RGB24_MASKS_(_mm_setr_epi8);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8_t* p = src + 3 * i;
+        __m128i a = _mm_loadu_si128((const __m128i*)p);
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(p + 32));
+        __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m[0]), _mm_shuffle_epi8(b, m[1])), _mm_shuffle_epi8(c, m[2]));
+        __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m[3]), _mm_shuffle_epi8(b, m[4])), _mm_shuffle_epi8(c, m[5]));
+        __m128i bl = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m[6]), _mm_shuffle_epi8(b, m[7])), _mm_shuffle_epi8(c, m[8]));
+        _mm_storeu_si128((__m128i*)(dst + i), pixel_sse_luma8_(r, g, bl));
+    }
+    pixel_scalar_rgb24_(src + 3 * i, dst + i, n - i);
+}
+
+// Four RGBA pixels -> four 32-bit luma values
+static inline PIXEL_TARGET_SSSE3_ __m128i pixel_sse_rgba_luma32_(const uint8_t* p) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i rb = _mm_and_si128(v, _mm_set1_epi16(0xFF));   // 16-bit lanes: r, b, r, b, ...
+    __m128i ga = _mm_srli_epi16(v, 8);                      // g, a, g, a, ...
+    __m128i y = _mm_add_epi32(_mm_madd_epi16(rb, _mm_set1_epi32(PIXEL_LUMA_R | PIXEL_LUMA_B << 16)),
+                              _mm_madd_epi16(ga, _mm_set1_epi32(PIXEL_LUMA_G)));
+    return _mm_srli_epi32(_mm_add_epi32(y, _mm_set1_epi32(128)), 8);
+}
+
+static PIXEL_TARGET_SSSE3_ void pixel_ssse3_rgba32_(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8_t* p = src + 4 * i;
+        __m128i lo = _mm_packs_epi32(pixel_sse_rgba_luma32_(p), pixel_sse_rgba_luma32_(p + 16));
+        __m128i hi = _mm_packs_epi32(pixel_sse_rgba_luma32_(p + 32), pixel_sse_rgba_luma32_(p + 48));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    pixel_scalar_rgba32_(src + 4 * i, dst + i, n - i);
+}
+
+static PIXEL_TARGET_SSSE3_ void pixel_ssse3_planar_(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                                    uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i y = pixel_sse_luma8_(_mm_loadu_si128((const __m128i*)(r + i)), _mm_loadu_si128((const __m128i*)(g + i)),
+                                     _mm_loadu_si128((const __m128i*)(b + i)));
+        _mm_storeu_si128((__m128i*)(dst + i), y);
+    }
+    pixel_scalar_planar_(r + i, g + i, b + i, dst + i, n - i);
+}
+
+// ----- AVX2 -----
+// Shuffles, unpacks and packs work within each 128-bit lane. Every step keeps
+// pixels 0-15 in the low lane and 16-31 in the high lane, so the lanes come
+// out of the final pack already in order.
+
+static inline PIXEL_TARGET_AVX2_ __m256i pixel_avx2_luma16_(__m256i r, __m256i g, __m256i b) {
+    __m256i y = _mm256_mullo_epi16(r, _mm256_set1_epi16(PIXEL_LUMA_R));
+    y = _mm256_add_epi16(y, _mm256_mullo_epi16(g, _mm256_set1_epi16(PIXEL_LUMA_G)));
+    y = _mm256_add_epi16(y, _mm256_mullo_epi16(b, _mm256_set1_epi16(PIXEL_LUMA_B)));
+    return _mm256_srli_epi16(_mm256_add_epi16(y, _mm256_set1_epi16(128)), 8);
+}
+
+static inline PIXEL_TARGET_AVX2_ __m256i pixel_avx2_luma8_(__m256i r, __m256i g, __m256i b) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = pixel_avx2_luma16_(_mm256_unpacklo_epi8(r, zero), _mm256_unpacklo_epi8(g, zero),
+                                    _mm256_unpacklo_epi8(b, zero));
+    __m256i hi = pixel_avx2_luma16_(_mm256_unpackhi_epi8(r, zero), _mm256_unpackhi_epi8(g, zero),
+                                    _mm256_unpackhi_epi8(b, zero));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+static inline PIXEL_TARGET_AVX2_ __m256i pixel_avx2_load_lanes_(const uint8_t* lo, const uint8_t* hi) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)lo)),
+                                   _mm_loadu_si128((const __m128i*)hi), 1);
+}
+
+static PIXEL_TARGET_AVX2_ void pixel_avx2_rgb24_(const uint8_t* src, uint8_t* dst, size_t n) {
+    const __m128i m128[9] = PIXEL_RGB24_MASKS_(_mm_setr_epi8);
+    __m256i m[9];
+    for (int k = 0; k < 9; k++) m[k] = _mm256_broadcastsi128_si256(m128[k]);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const uint8_t* p = src + 3 * i;
+        __m256i a = pixel_avx2_load_lanes_(p, p + 48);
+        __m256i b = pixel_avx2_load_lanes_(p + 16, p + 64);
+        __m256i c = pixel_avx2_load_lanes_(p + 32, p + 80);
+        __m256i r = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, m[0]), _mm256_shuffle_epi8(b, m[1])),
+                                    _mm256_shuffle_epi8(c, m[2]));
+        __m256i g = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, m[3]), _mm256_shuffle_epi8(b, m[4])),
+                                    _mm256_shuffle_epi8(c, m[5]));
+        __m256i bl = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, m[6]), _mm256_shuffle_epi8(b, m[7])),
+                                     _mm256_shuffle_epi8(c, m[8]));
+        _mm256_storeu_si256((__m256i*)(dst + i), pixel_avx2_luma8_(r, g, bl));
+    }
+    pixel_scalar_rgb24_(src + 3 * i, dst + i, n - i);
+}
+
+static inline PIXEL_TARGET_AVX2_ __m256i pixel_avx2_rgba_luma32_(const uint8_t* p) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i rb = _mm256_and_si256(v, _mm256_set1_epi16(0xFF));
+    __m256i ga = _mm256_srli_epi16(v, 8);
+    __m256i y = _mm256_add_epi32(_mm256_madd_epi16(rb, _mm256_set1_epi32(PIXEL_LUMA_R | PIXEL_LUMA_B << 16)),
+                                 _mm256_madd_epi16(ga, _mm256_set1_epi32(PIXEL_LUMA_G)));
+    return _mm256_srli_epi32(_mm256_add_epi32(y, _mm256_set1_epi32(128)), 8);
+}
+
+static PIXEL_TARGET_AVX2_ void pixel_avx2_rgba32_(const uint8_t* src, uint8_t* dst, size_t n) {
+    // The two packs leave 4-pixel groups in the order 0 2 4 6 | 1 3 5 7
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const uint8_t* p = src + 4 * i;
+        __m256i lo = _mm256_packs_epi32(pixel_avx2_rgba_luma32_(p), pixel_avx2_rgba_luma32_(p + 32));
+        __m256i hi = _mm256_packs_epi32(pixel_avx2_rgba_luma32_(p + 64), pixel_avx2_rgba_luma32_(p + 96));
+        __m256i y = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+        _mm256_storeu_si256((__m256i*)(dst + i), y);
+    }
+    pixel_scalar_rgba32_(src + 4 * i, dst + i, n - i);
+}
+
+static PIXEL_TARGET_AVX2_ void pixel_avx2_planar_(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                                  uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i y = pixel_avx2_luma8_(_mm256_loadu_si256((const __m256i*)(r + i)),
+                                      _mm256_loadu_si256((const __m256i*)(g + i)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), y);
+    }
+    pixel_scalar_planar_(r + i, g + i, b + i, dst + i, n - i);
+}
+
+#endif // PIXEL_HAVE_X86
+
+// ---------------------------------------------------------------------------
+// NEON variant
+// ---------------------------------------------------------------------------
+
+#ifdef PIXEL_HAVE_NEON
+
+static inline uint8x16_t pixel_neon_luma8_(uint8x16_t r, uint8x16_t g, uint8x16_t b) {
+    const uint8x8_t cr = vdup_n_u8(PIXEL_LUMA_R), cg = vdup_n_u8(PIXEL_LUMA_G), cb = vdup_n_u8(PIXEL_LUMA_B);
+    uint16x8_t lo = vmull_u8(vget_low_u8(r), cr);
+    lo = vmlal_u8(lo, vget_low_u8(g), cg);
+    lo = vmlal_u8(lo, vget_low_u8(b), cb);
+    uint16x8_t hi = vmull_u8(vget_high_u8(r), cr);
+    hi = vmlal_u8(hi, vget_high_u8(g), cg);
+    hi = vmlal_u8(hi, vget_high_u8(b), cb);
+    return vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));  // (x + 128) >> 8
+}
+
+static void pixel_neon_rgb24_(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x3_t px = vld3q_u8(src + 3 * i);
+        vst1q_u8(dst + i, pixel_neon_luma8_(px.val[0], px.val[1], px.val[2]));
+    }
+    pixel_scalar_rgb24_(src + 3 * i, dst + i, n - i);
+}
+
+static void pixel_neon_rgba32_(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t px = vld4q_u8(src + 4 * i);
+        vst1q_u8(dst + i, pixel_neon_luma8_(px.val[0], px.val[1], px.val[2]));
+    }
+    pixel_scalar_rgba32_(src + 4 * i, dst + i, n - i);
+}
+
+static void pixel_neon_planar_(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        vst1q_u8(dst + i, pixel_neon_luma8_(vld1q_u8(r + i), vld1q_u8(g + i), vld1q_u8(b + i)));
+    }
+    pixel_scalar_planar_(r + i, g + i, b + i, dst + i, n - i);
+}
+
+#endif // PIXEL_HAVE_NEON
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+static const PixelKernels pixel_kernel_table_[PIXEL_VARIANT_COUNT] = {
+    [PIXEL_SCALAR] = {"scalar", pixel_scalar_rgb24_, pixel_scalar_rgba32_, pixel_scalar_planar_},
+#ifdef PIXEL_HAVE_X86
+    [PIXEL_SSSE3] = {"ssse3", pixel_ssse3_rgb24_, pixel_ssse3_rgba32_, pixel_ssse3_planar_},
+    [PIXEL_AVX2] = {"avx2", pixel_avx2_rgb24_, pixel_avx2_rgba32_, pixel_avx2_planar_},
+#endif
+#ifdef PIXEL_HAVE_NEON
+    [PIXEL_NEON] = {"neon", pixel_neon_rgb24_, pixel_neon_rgba32_, pixel_neon_planar_},
+#endif
+};
+
+// Returns 1 if the variant is compiled in and the running CPU supports it.
+static inline int pixel_variant_supported(PixelVariant v) {
+    if ((unsigned)v >= PIXEL_VARIANT_COUNT || pixel_kernel_table_[v].name == NULL) return 0;
+#ifdef PIXEL_HAVE_X86
+    __builtin_cpu_init();
+    switch (v) {
+        case PIXEL_SSSE3: return __builtin_cpu_supports("ssse3") != 0;
+        case PIXEL_AVX2: return __builtin_cpu_supports("avx2") != 0;
+        default: break;
+    }
+#endif
+    return 1;  // NEON is part of the baseline wherever it is compiled in
+}
+
+static inline const PixelKernels* pixel_kernels_for(PixelVariant v) {
+    return pixel_variant_supported(v) ? &pixel_kernel_table_[v] : NULL;
+}
+
+static const PixelKernels* pixel_active_ = NULL;
+
+static inline const PixelKernels* pixel_select_(void) {
+    const char* forced = getenv("PIXEL_SIMD_VARIANT");
+    if (forced != NULL) {
+        for (int v = 0; v < PIXEL_VARIANT_COUNT; v++) {
+            if (pixel_variant_supported((PixelVariant)v) && strcmp(pixel_kernel_table_[v].name, forced) == 0) {
+                return &pixel_kernel_table_[v];
+            }
+        }
+    }
+    // Table order is slowest to fastest: take the last one the CPU can run
+    for (int v = PIXEL_VARIANT_COUNT - 1; v > PIXEL_SCALAR; v--) {
+        if (pixel_variant_supported((PixelVariant)v)) return &pixel_kernel_table_[v];
+    }
+    return &pixel_kernel_table_[PIXEL_SCALAR];
+}
+
+__attribute__((constructor)) static void pixel_dispatch_init_(void) {
+    __atomic_store_n(&pixel_active_, pixel_select_(), __ATOMIC_RELEASE);
+}
+
+static inline const PixelKernels* pixel_kernels(void) {
+    const PixelKernels* k = __atomic_load_n(&pixel_active_, __ATOMIC_ACQUIRE);
+    if (k == NULL) {
+        k = pixel_select_();
+        __atomic_store_n(&pixel_active_, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+// ---------------------------------------------------------------------------
+// Whole images
+// ---------------------------------------------------------------------------
+
+static inline int pixel_check_(const PixelImage* src, const GrayImage* dst) {
+    size_t bpp = pixel_bytes_per_pixel(src->format);
+    if (bpp == 0 || src->width != dst->width || src->height != dst->height ||
+        (src->width > 0 && (src->stride / bpp < src->width || dst->stride < dst->width))) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+// Convert rows [y0, y1) with the given kernels. No argument checks: the caller
+// has validated src and dst.
+static inline void pixel_convert_rows(const PixelKernels* k, const PixelImage* src, GrayImage* dst,
+                                      size_t y0, size_t y1) {
+    const size_t w = src->width;
+    for (size_t y = y0; y < y1; y++) {
+        const size_t offset = y * src->stride;
+        uint8_t* out = dst->data + y * dst->stride;
+        switch (src->format) {
+            case PIXEL_RGB24: k->rgb24(src->planes[0] + offset, out, w); break;
+            case PIXEL_RGBA32: k->rgba32(src->planes[0] + offset, out, w); break;
+            default: k->planar(src->planes[0] + offset, src->planes[1] + offset, src->planes[2] + offset, out, w); break;
+        }
+    }
+}
+
+static inline int pixel_to_gray(const PixelImage* src, GrayImage* dst) {
+    if (pixel_check_(src, dst) != 0) return -1;
+    pixel_convert_rows(pixel_kernels(), src, dst, 0, src->height);
+    return 0;
+}
+
+typedef struct {
+    const PixelKernels* kernels;
+    const PixelImage* src;
+    GrayImage* dst;
+} PixelRowsJob_;
+
+static inline void pixel_rows_chunk_(void* ctx, size_t begin, size_t end, unsigned worker) {
+    (void)worker;
+    const PixelRowsJob_* job = (const PixelRowsJob_*)ctx;
+    pixel_convert_rows(job->kernels, job->src, job->dst, begin, end);
+}
+
+static inline size_t pixel_rows_per_chunk_(const PixelImage* src) {
+    size_t row_bytes = src->width * pixel_bytes_per_pixel(src->format);
+    size_t rows = row_bytes ? PIXEL_CHUNK_BYTES / row_bytes : 1;
+    return rows ? rows : 1;
+}
+
+static inline int pixel_to_gray_parallel(ThreadPool* pool, const PixelImage* src, GrayImage* dst) {
+    if (pixel_check_(src, dst) != 0) return -1;
+    PixelRowsJob_ job = {pixel_kernels(), src, dst};
+    parallel_for(pool, 0, src->height, pixel_rows_per_chunk_(src), pixel_rows_chunk_, &job);
+    return 0;
+}
+
+typedef struct {
+    const PixelKernels* kernels;
+    const PixelImage* srcs;
+    GrayImage* dsts;
+} PixelBatchJob_;
+
+static inline void pixel_batch_chunk_(void* ctx, size_t begin, size_t end, unsigned worker) {
+    (void)worker;
+    const PixelBatchJob_* job = (const PixelBatchJob_*)ctx;
+    for (size_t i = begin; i < end; i++) {
+        pixel_convert_rows(job->kernels, &job->srcs[i], &job->dsts[i], 0, job->srcs[i].height);
+    }
+}
+
+// Convert count independent images, whole images per task. Every pair is
+// checked before any is converted.
+static inline int pixel_batch_to_gray(ThreadPool* pool, const PixelImage* srcs, GrayImage* dsts, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (pixel_check_(&srcs[i], &dsts[i]) != 0) return -1;
+    }
+    PixelBatchJob_ job = {pixel_kernels(), srcs, dsts};
+    parallel_for(pool, 0, count, 0, pixel_batch_chunk_, &job);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming from and to mapped files
+// ---------------------------------------------------------------------------
+
+// Map [offset, offset + len) of fd, widened down to a page boundary. *base gets
+// the start of the mapping and *map_len its length, for munmap().
+static inline uint8_t* pixel_map_window_(int fd, size_t offset, size_t len, int prot, void** base, size_t* map_len) {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t start = offset - offset % page;
+    *map_len = len + (offset - start);
+    *base = mmap(NULL, *map_len, prot, MAP_SHARED, fd, (off_t)start);
+    if (*base == MAP_FAILED) return NULL;
+    return (uint8_t*)*base + (offset - start);
+}
+
+// Convert a raw interleaved file of width x height pixels (packed rows, no
+// header) into a raw gray file, band_rows rows at a time (0 picks about 8 MB of
+// source per band). The output is created or truncated. pool may be NULL.
+static inline int pixel_stream_to_gray(const char* src_path, const char* dst_path, PixelFormat format,
+                                       size_t width, size_t height, size_t band_rows, ThreadPool* pool) {
+    if (format != PIXEL_RGB24 && format != PIXEL_RGBA32) {
+        errno = EINVAL;
+        return -1;
+    }
+    const size_t row_bytes = width * pixel_bytes_per_pixel(format);
+    if (width == 0 || height == 0 || row_bytes / width != pixel_bytes_per_pixel(format) ||
+        height > SIZE_MAX / row_bytes) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (band_rows == 0) band_rows = PIXEL_STREAM_BAND_BYTES / row_bytes ? PIXEL_STREAM_BAND_BYTES / row_bytes : 1;
+
+    int in = open(src_path, O_RDONLY);
+    if (in < 0) return -1;
+    off_t in_size = lseek(in, 0, SEEK_END);
+    if (in_size < 0 || (uint64_t)in_size != (uint64_t)row_bytes * height) {
+        if (in_size >= 0) errno = EINVAL;
+        close(in);
+        return -1;
+    }
+    int out = open(dst_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (out < 0 || ftruncate(out, (off_t)(width * height)) != 0) {
+        int saved = errno;
+        if (out >= 0) close(out);
+        close(in);
+        errno = saved;
+        return -1;
+    }
+
+    const PixelKernels* kernels = pixel_kernels();
+    int result = 0;
+    for (size_t y0 = 0; y0 < height && result == 0; y0 += band_rows) {
+        const size_t rows = height - y0 < band_rows ? height - y0 : band_rows;
+        void *in_base, *out_base;
+        size_t in_len, out_len;
+        const uint8_t* band = pixel_map_window_(in, y0 * row_bytes, rows * row_bytes, PROT_READ, &in_base, &in_len);
+        if (band == NULL) {
+            result = -1;
+            break;
+        }
+        uint8_t* gray = pixel_map_window_(out, y0 * width, rows * width, PROT_READ | PROT_WRITE, &out_base, &out_len);
+        if (gray == NULL) {
+            munmap(in_base, in_len);
+            result = -1;
+            break;
+        }
+        madvise(in_base, in_len, MADV_SEQUENTIAL);
+
+        PixelImage src;
+        GrayImage dst = {gray, width, rows, width};
+        pixel_image_interleaved(&src, format, band, width, rows, row_bytes);
+        if (pool != NULL) {
+            PixelRowsJob_ job = {kernels, &src, &dst};
+            parallel_for(pool, 0, rows, pixel_rows_per_chunk_(&src), pixel_rows_chunk_, &job);
+        } else {
+            pixel_convert_rows(kernels, &src, &dst, 0, rows);
+        }
+
+        munmap(out_base, out_len);
+        munmap(in_base, in_len);
+#ifdef POSIX_FADV_DONTNEED
+        // The band is done: let the kernel drop its cached input pages first
+        posix_fadvise(in, (off_t)(y0 * row_bytes), (off_t)(rows * row_bytes), POSIX_FADV_DONTNEED);
+#endif
+    }
+
+    int saved = errno;
+    if (close(out) != 0 && result == 0) {
+        saved = errno;
+        result = -1;
+    }
+    close(in);
+    errno = saved;
+    return result;
+}
+
+#endif // PIXEL_H
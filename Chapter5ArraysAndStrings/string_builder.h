@@ -0,0 +1,223 @@
+/*
+string_builder.h - Length-Prefixed String Builder with Small-String Storage
+================================================
+
+strcat() finds the end of its destination with strlen() on every call, so
+building a string from k pieces rescans it k times: quadratic in the final
+length. A StringBuilder stores the length and the capacity next to the bytes.
+Appends go straight to the end, and the length is a field read.
+
+    StringBuilder sb;
+    string_builder_init(&sb);
+    string_builder_append_cstr(&sb, "user=");
+    string_builder_append(&sb, name, name_len);
+    if (string_builder_append_fmt(&sb, " id=%d latency=%.2fms", id, ms) != 0) ...  // -1, errno
+    puts(string_builder_cstr(&sb));       // Always NUL-terminated
+    size_t len = string_builder_length(&sb);
+    string_builder_destroy(&sb);
+
+Design:
+- Strings of up to STRING_BUILDER_SMALL (23) bytes are stored inside the
+  struct itself, and the heap is never touched. Most keys, names and numbers
+  are that short. Past that, the contents move to a heap buffer whose capacity
+  doubles as it fills, so appends cost amortised O(1).
+- The small buffer shares storage with the heap pointer, and capacity tells
+  which one is in use. There is no pointer into the struct itself, so a
+  StringBuilder can be returned or copied by value like any struct. Only one
+  copy may be destroyed or appended to afterwards, though: both copies share
+  the heap buffer.
+- append_fmt formats straight into the spare capacity with vsnprintf(). If the
+  output does not fit, vsnprintf() reports the exact size needed. The builder
+  grows once and formats again. There is no temporary buffer.
+- Functions that can allocate return 0, or -1 with errno = ENOMEM (EOVERFLOW
+  or EINVAL from vsnprintf() for bad formats) and leave the contents as they
+  were.
+- string_builder_clear() keeps the capacity, so one builder reused per log
+  record stops allocating after the first few records.
+*/
+
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define STRING_BUILDER_SMALL 23
+
+#if defined(__GNUC__)
+#define STRING_BUILDER_PRINTF_(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define STRING_BUILDER_PRINTF_(fmt, args)
+#endif
+
+typedef struct {
+    size_t length;                            // Bytes in use, excluding the terminator
+    size_t capacity;                          // Bytes available, excluding the terminator
+    union {
+        char* heap;                           // capacity > STRING_BUILDER_SMALL
+        char small[STRING_BUILDER_SMALL + 1];
+    } u;
+} StringBuilder;
+
+static inline void string_builder_init(StringBuilder* sb) {
+    sb->length = 0;
+    sb->capacity = STRING_BUILDER_SMALL;
+    sb->u.small[0] = '\0';
+}
+
+static inline int string_builder_is_small_(const StringBuilder* sb) {
+    return sb->capacity <= STRING_BUILDER_SMALL;
+}
+
+static inline void string_builder_destroy(StringBuilder* sb) {
+    if (!string_builder_is_small_(sb)) free(sb->u.heap);
+    string_builder_init(sb);
+}
+
+static inline char* string_builder_data(StringBuilder* sb) {
+    return string_builder_is_small_(sb) ? sb->u.small : sb->u.heap;
+}
+
+static inline const char* string_builder_cstr(const StringBuilder* sb) {
+    return string_builder_is_small_(sb) ? sb->u.small : sb->u.heap;
+}
+
+static inline size_t string_builder_length(const StringBuilder* sb) {
+    return sb->length;
+}
+
+// Makes room for at least 'capacity' bytes (plus the terminator).
+static inline int string_builder_reserve(StringBuilder* sb, size_t capacity) {
+    if (capacity <= sb->capacity) return 0;
+    if (capacity >= SIZE_MAX / 2) {
+        errno = ENOMEM;
+        return -1;
+    }
+    size_t grown = sb->capacity * 2;
+    if (grown < capacity) grown = capacity;
+    char* heap;
+    if (string_builder_is_small_(sb)) {
+        heap = (char*)malloc(grown + 1);
+        if (heap != NULL) memcpy(heap, sb->u.small, sb->length + 1);
+    } else {
+        heap = (char*)realloc(sb->u.heap, grown + 1);
+    }
+    if (heap == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    sb->u.heap = heap;
+    sb->capacity = grown;
+    return 0;
+}
+
+// 's' may point into the builder's own contents (appending a copy of a part of it):
+// growing would free that buffer, so such a pointer is rebased onto the new one.
+static inline int string_builder_append(StringBuilder* sb, const char* s, size_t n) {
+    if (n > sb->capacity - sb->length) {
+        if (n >= SIZE_MAX / 2 - sb->length) {
+            errno = ENOMEM;
+            return -1;
+        }
+        // Integer arithmetic: comparing pointers into different objects is undefined
+        uintptr_t offset = (uintptr_t)s - (uintptr_t)string_builder_data(sb);
+        int inside = offset <= sb->length;
+        if (string_builder_reserve(sb, sb->length + n) != 0) return -1;
+        if (inside) s = string_builder_data(sb) + offset;
+    }
+    char* data = string_builder_data(sb);
+    memcpy(data + sb->length, s, n);
+    sb->length += n;
+    data[sb->length] = '\0';
+    return 0;
+}
+
+static inline int string_builder_append_cstr(StringBuilder* sb, const char* s) {
+    return string_builder_append(sb, s, strlen(s));
+}
+
+static inline int string_builder_append_char(StringBuilder* sb, char c) {
+    if (sb->length == sb->capacity && string_builder_reserve(sb, sb->length + 1) != 0) return -1;
+    char* data = string_builder_data(sb);
+    data[sb->length++] = c;
+    data[sb->length] = '\0';
+    return 0;
+}
+
+static inline int string_builder_append_vfmt(StringBuilder* sb, const char* fmt, va_list args) {
+    va_list retry;
+    va_copy(retry, args);
+    size_t spare = sb->capacity - sb->length;
+    int n = vsnprintf(string_builder_data(sb) + sb->length, spare + 1, fmt, args);
+    if (n >= 0 && (size_t)n > spare) {
+        if (string_builder_reserve(sb, sb->length + (size_t)n) == 0) {
+            n = vsnprintf(string_builder_data(sb) + sb->length, (size_t)n + 1, fmt, retry);
+        } else {
+            n = -2;  // errno is ENOMEM
+        }
+    }
+    va_end(retry);
+    if (n < 0) {
+        string_builder_data(sb)[sb->length] = '\0';  // Drop the truncated output
+        return -1;                                   // errno set by vsnprintf or reserve
+    }
+    sb->length += (size_t)n;
+    return 0;
+}
+
+static inline STRING_BUILDER_PRINTF_(2, 3) int string_builder_append_fmt(StringBuilder* sb, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int result = string_builder_append_vfmt(sb, fmt, args);
+    va_end(args);
+    return result;
+}
+
+// Keeps the capacity, so the next record reuses the buffer.
+static inline void string_builder_clear(StringBuilder* sb) {
+    sb->length = 0;
+    string_builder_data(sb)[0] = '\0';
+}
+
+static inline void string_builder_truncate(StringBuilder* sb, size_t length) {
+    if (length < sb->length) {
+        sb->length = length;
+        string_builder_data(sb)[length] = '\0';
+    }
+}
+
+// Removes leading and trailing ASCII whitespace in one pass over the ends, with no strlen.
+static inline void string_builder_trim(StringBuilder* sb) {
+    char* data = string_builder_data(sb);
+    size_t start = 0, end = sb->length;
+    while (start < end && (data[start] == ' ' || (data[start] >= '\t' && data[start] <= '\r'))) start++;
+    while (end > start && (data[end - 1] == ' ' || (data[end - 1] >= '\t' && data[end - 1] <= '\r'))) end--;
+    if (start > 0) memmove(data, data + start, end - start);
+    sb->length = end - start;
+    data[sb->length] = '\0';
+}
+
+// Hands the contents to the caller as a malloc'd string (free() it) and resets the
+// builder. Returns NULL with errno = ENOMEM if a small string cannot be copied out.
+static inline char* string_builder_detach(StringBuilder* sb) {
+    char* result;
+    if (string_builder_is_small_(sb)) {
+        result = (char*)malloc(sb->length + 1);
+        if (result == NULL) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        memcpy(result, sb->u.small, sb->length + 1);
+    } else {
+        result = sb->u.heap;
+    }
+    string_builder_init(sb);
+    return result;
+}
+
+#endif // STRING_BUILDER_H
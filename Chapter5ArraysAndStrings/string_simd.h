@@ -0,0 +1,672 @@
+/*
+string_simd.h - Vectorised String Scanning and a Zero-Copy Tokenizer
+================================================
+
+Header-only replacements for the byte-at-a-time loops in StringManipulation.c
+(custom_strlen, strtok-based tokenizing):
+
+    string_length(s)                       strlen
+    string_find_byte(s, n, c)              memchr, as an index
+    string_find_any(s, n, &set)            first byte of s[0..n) in the set (strcspn)
+    string_span(s, n, &set)                length of the prefix made of set bytes (strspn)
+    string_find(h, hn, needle, nn)         substring search (strstr with lengths)
+
+The find functions return STRING_NOT_FOUND when there is no match. Every kernel
+exists in three variants:
+
+    swar    eight bytes per step in a uint64_t, no special instructions
+    sse2    16 bytes per step (baseline on x86-64)
+    avx2    32 bytes per step; 64-128 in the strlen, memchr and strstr main loops
+
+Usage:
+    StringByteSet delims;
+    string_byte_set_init(&delims, " ,\t");
+
+    StringTokenizer tok;
+    StringSpan word;
+    string_tokenizer_init(&tok, line, line_len, &delims, STRING_TOKENS_SKIP_EMPTY);
+    while (string_tokenizer_next(&tok, &word)) {
+        printf("%.*s\n", (int)word.len, word.ptr);   // Points into 'line', nothing copied
+    }
+
+Design:
+- Variants are chosen at startup the same way popcount_simd.h chooses them:
+  target attributes, __builtin_cpu_supports() and a function-pointer table.
+  STRING_SIMD_VARIANT=<name> in the environment forces one variant.
+  string_kernels_for() returns a specific variant, for benchmarks and tests.
+- string_length() cannot know where the string ends, so it reads whole aligned
+  words or vectors. An aligned block never crosses a page boundary, so reading
+  it cannot fault, even where it runs past the terminator. The bounded kernels
+  use the same rule when fewer than one vector is left. Those kernels are built
+  without AddressSanitizer instrumentation, since ASan would report the read
+  past the end even though it is safe.
+- A byte set keeps a 256-bit bitmap for the scalar paths and the first 16
+  members for the SSE2 compare-and-OR path. It also keeps two 16-byte nibble
+  tables. With those, AVX2 tests 32 bytes against any set, of any size, with
+  two vpshufb lookups.
+- Substring search uses SIMD first/last-byte filtering (Mula). A position is
+  only a candidate if both the needle's first byte and its last byte match.
+  Candidates are checked with memcmp. This is fast on real text. Inputs like
+  "aaaa...a" with the needle "aa...ab" cost O(n * m), where glibc's Two-Way
+  strstr stays linear.
+- The tokenizer is reentrant: all of its state is in StringTokenizer, and the
+  input is never written to. STRING_TOKENS_SKIP_EMPTY collapses runs of
+  delimiters, as strtok does. STRING_TOKENS_KEEP_EMPTY returns empty fields, as
+  strsep does, which is what CSV needs.
+
+Compile with: gcc -O2 file.c   (GCC 8+ or Clang 7+)
+*/
+
+#ifndef STRING_SIMD_H
+#define STRING_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STRING_SIMD_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define STRING_NO_ASAN_ __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define STRING_NO_ASAN_ __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef STRING_NO_ASAN_
+#define STRING_NO_ASAN_
+#endif
+
+#define STRING_NOT_FOUND ((size_t)-1)
+#define STRING_PAGE_SIZE 4096   // Smallest page on every supported target
+#define STRING_SET_SMALL 16     // Members kept for the compare-and-OR path
+
+typedef struct {
+    uint8_t bitmap[32];         // Bit b set if byte b is a member
+    uint8_t nibble_lo[16];      // [b & 15] bit (b >> 4) for members b < 0x80
+    uint8_t nibble_hi[16];      // [b & 15] bit (b >> 4) - 8 for members b >= 0x80
+    uint8_t small[STRING_SET_SMALL];
+    int count;
+} StringByteSet;
+
+typedef enum {
+    STRING_SWAR,
+    STRING_SSE2,
+    STRING_AVX2,
+    STRING_VARIANT_COUNT
+} StringVariant;
+
+typedef struct {
+    const char* name;
+    size_t (*length)(const char* s);
+    size_t (*find_byte)(const char* s, size_t n, int c);
+    size_t (*find_any)(const char* s, size_t n, const StringByteSet* set);
+    size_t (*span)(const char* s, size_t n, const StringByteSet* set);
+    size_t (*find)(const char* h, size_t hn, const char* needle, size_t nn);
+} StringKernels;
+
+static inline void string_byte_set_add(StringByteSet* set, unsigned char b) {
+    if (set->bitmap[b >> 3] & (1u << (b & 7))) return;
+    set->bitmap[b >> 3] |= (uint8_t)(1u << (b & 7));
+    if (b < 0x80) {
+        set->nibble_lo[b & 15] |= (uint8_t)(1u << (b >> 4));
+    } else {
+        set->nibble_hi[b & 15] |= (uint8_t)(1u << ((b >> 4) - 8));
+    }
+    if (set->count < STRING_SET_SMALL) set->small[set->count] = b;
+    set->count++;
+}
+
+// Members are the bytes of the NUL-terminated 'bytes'; add '\0' with string_byte_set_add().
+static inline void string_byte_set_init(StringByteSet* set, const char* bytes) {
+    memset(set, 0, sizeof(*set));
+    for (const unsigned char* p = (const unsigned char*)bytes; *p; p++) string_byte_set_add(set, *p);
+}
+
+static inline int string_byte_set_contains(const StringByteSet* set, unsigned char b) {
+    return (set->bitmap[b >> 3] >> (b & 7)) & 1;
+}
+
+static inline int string_can_overread_(const void* p, size_t width) {
+    return ((uintptr_t)p & (STRING_PAGE_SIZE - 1)) <= STRING_PAGE_SIZE - width;
+}
+
+// Scalar tails shared by all variants
+static inline size_t string_find_any_scalar_(const char* s, size_t i, size_t n, const StringByteSet* set,
+                                             int want) {
+    for (; i < n; i++) {
+        if (string_byte_set_contains(set, (unsigned char)s[i]) == want) return i;
+    }
+    return STRING_NOT_FOUND;
+}
+
+static inline size_t string_find_scalar_(const char* h, size_t i, size_t hn, const char* needle, size_t nn) {
+    for (; i + nn <= hn; i++) {
+        if (h[i] == needle[0] && h[i + nn - 1] == needle[nn - 1] && memcmp(h + i + 1, needle + 1, nn - 2) == 0) {
+            return i;
+        }
+    }
+    return STRING_NOT_FOUND;
+}
+
+// ---------------------------------------------------------------------------
+// SWAR: eight bytes in a uint64_t
+// ---------------------------------------------------------------------------
+
+#define STRING_ONES_ 0x0101010101010101ull
+#define STRING_LOW7_ 0x7F7F7F7F7F7F7F7Full
+
+typedef uint64_t __attribute__((may_alias)) StringWord_;
+
+// High bit set in exactly the zero bytes of v (no borrow between bytes).
+static inline uint64_t string_swar_zero_(uint64_t v) {
+    return ~(((v & STRING_LOW7_) + STRING_LOW7_) | v | STRING_LOW7_);
+}
+
+// Index of the first flagged byte in memory order
+static inline size_t string_swar_first_(uint64_t mask) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (size_t)__builtin_clzll(mask) / 8;
+#else
+    return (size_t)__builtin_ctzll(mask) / 8;
+#endif
+}
+
+static inline uint64_t string_swar_load_(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static STRING_NO_ASAN_ size_t string_swar_length_(const char* s) {
+    const char* p = s;
+    for (; (uintptr_t)p & 7; p++) {
+        if (*p == '\0') return (size_t)(p - s);
+    }
+    for (;; p += 8) {
+        uint64_t zero = string_swar_zero_(*(const StringWord_*)p);
+        if (zero) return (size_t)(p - s) + string_swar_first_(zero);
+    }
+}
+
+static size_t string_swar_find_byte_(const char* s, size_t n, int c) {
+    uint64_t pattern = STRING_ONES_ * (unsigned char)c;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t hit = string_swar_zero_(string_swar_load_(s + i) ^ pattern);
+        if (hit) return i + string_swar_first_(hit);
+    }
+    for (; i < n; i++) {
+        if (s[i] == (char)c) return i;
+    }
+    return STRING_NOT_FOUND;
+}
+
+// Up to STRING_SWAR_SET_MAX members: compare each word with every member and OR
+// the zero masks. Larger sets use the bitmap, one load and test per byte.
+#define STRING_SWAR_SET_MAX 4
+
+static inline size_t string_swar_scan_(const char* s, size_t n, const StringByteSet* set, int want) {
+    if (set->count > STRING_SWAR_SET_MAX) return string_find_any_scalar_(s, 0, n, set, want);
+    uint64_t patterns[STRING_SWAR_SET_MAX];
+    for (int k = 0; k < STRING_SWAR_SET_MAX; k++) {
+        patterns[k] = STRING_ONES_ * (set->count ? set->small[k < set->count ? k : 0] : 0);
+    }
+    uint64_t flip = want ? 0 : 0x8080808080808080ull;
+    uint64_t none = set->count ? ~0ull : 0;  // An empty set matches nothing
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v = string_swar_load_(s + i);
+        uint64_t hit = (string_swar_zero_(v ^ patterns[0]) | string_swar_zero_(v ^ patterns[1]) |
+                        string_swar_zero_(v ^ patterns[2]) | string_swar_zero_(v ^ patterns[3])) & none;
+        hit ^= flip;
+        if (hit) return i + string_swar_first_(hit);
+    }
+    return string_find_any_scalar_(s, i, n, set, want);
+}
+
+static size_t string_swar_find_any_(const char* s, size_t n, const StringByteSet* set) {
+    return string_swar_scan_(s, n, set, 1);
+}
+
+static size_t string_swar_span_(const char* s, size_t n, const StringByteSet* set) {
+    size_t i = string_swar_scan_(s, n, set, 0);
+    return i == STRING_NOT_FOUND ? n : i;
+}
+
+static size_t string_swar_find_(const char* h, size_t hn, const char* needle, size_t nn) {
+    if (nn == 0) return 0;
+    if (nn > hn) return STRING_NOT_FOUND;
+    if (nn == 1) return string_swar_find_byte_(h, hn, needle[0]);
+    uint64_t first = STRING_ONES_ * (unsigned char)needle[0];
+    uint64_t last = STRING_ONES_ * (unsigned char)needle[nn - 1];
+    size_t i = 0;
+    for (; i + nn - 1 + 8 <= hn; i += 8) {
+        uint64_t hit = string_swar_zero_(string_swar_load_(h + i) ^ first) &
+                       string_swar_zero_(string_swar_load_(h + i + nn - 1) ^ last);
+        while (hit) {
+            size_t k = string_swar_first_(hit);
+            if (memcmp(h + i + k + 1, needle + 1, nn - 2) == 0) return i + k;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            hit &= ~(0x8000000000000000ull >> (8 * k));
+#else
+            hit &= hit - 1;
+#endif
+        }
+    }
+    return string_find_scalar_(h, i, hn, needle, nn);
+}
+
+// ---------------------------------------------------------------------------
+// x86 variants
+// ---------------------------------------------------------------------------
+
+#ifdef STRING_SIMD_HAVE_X86
+
+#define STRING_TARGET_SSE2_ __attribute__((target("sse2")))
+#define STRING_TARGET_AVX2_ __attribute__((target("avx2")))
+
+// ----- SSE2 -----
+
+static inline STRING_TARGET_SSE2_ STRING_NO_ASAN_ unsigned
+string_sse2_eq_(const char* p, __m128i pattern) {
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), pattern));
+}
+
+static STRING_TARGET_SSE2_ STRING_NO_ASAN_ size_t string_sse2_length_(const char* s) {
+    const char* p = (const char*)((uintptr_t)s & ~(uintptr_t)15);
+    const __m128i zero = _mm_setzero_si128();
+    unsigned mask = string_sse2_eq_(p, zero) >> (s - p);
+    if (mask) return (size_t)__builtin_ctz(mask);
+    for (;;) {
+        p += 16;
+        mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)p), zero));
+        if (mask) return (size_t)(p - s) + (size_t)__builtin_ctz(mask);
+    }
+}
+
+static STRING_TARGET_SSE2_ STRING_NO_ASAN_ size_t string_sse2_find_byte_(const char* s, size_t n, int c) {
+    const __m128i pattern = _mm_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = string_sse2_eq_(s + i, pattern);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    if (i == n) return STRING_NOT_FOUND;
+    if (!string_can_overread_(s + i, 16)) {
+        for (; i < n; i++) {
+            if (s[i] == (char)c) return i;
+        }
+        return STRING_NOT_FOUND;
+    }
+    unsigned mask = string_sse2_eq_(s + i, pattern) & ((1u << (n - i)) - 1);
+    return mask ? i + (size_t)__builtin_ctz(mask) : STRING_NOT_FOUND;
+}
+
+// Compare against each member and OR, four members per step. 'patterns' holds
+// the members broadcast and padded to a multiple of four by repeating the first.
+static inline STRING_TARGET_SSE2_ STRING_NO_ASAN_ unsigned
+string_sse2_members_(const char* p, const __m128i* patterns, int count) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i hit = _mm_setzero_si128();
+    for (int k = 0; k < count; k += 4) {
+        __m128i a = _mm_or_si128(_mm_cmpeq_epi8(v, patterns[k]), _mm_cmpeq_epi8(v, patterns[k + 1]));
+        __m128i b = _mm_or_si128(_mm_cmpeq_epi8(v, patterns[k + 2]), _mm_cmpeq_epi8(v, patterns[k + 3]));
+        hit = _mm_or_si128(hit, _mm_or_si128(a, b));
+    }
+    return (unsigned)_mm_movemask_epi8(hit);
+}
+
+// Sets above STRING_SET_SMALL members use the bitmap
+static inline STRING_TARGET_SSE2_ STRING_NO_ASAN_ size_t
+string_sse2_scan_(const char* s, size_t n, const StringByteSet* set, int want) {
+    if (set->count > STRING_SET_SMALL) return string_find_any_scalar_(s, 0, n, set, want);
+    __m128i patterns[STRING_SET_SMALL];
+    int count = (set->count + 3) & ~3;
+    for (int k = 0; k < count; k++) patterns[k] = _mm_set1_epi8((char)set->small[k < set->count ? k : 0]);
+    unsigned flip = want ? 0 : 0xFFFF;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = string_sse2_members_(s + i, patterns, count) ^ flip;
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    if (i == n) return STRING_NOT_FOUND;
+    if (!string_can_overread_(s + i, 16)) return string_find_any_scalar_(s, i, n, set, want);
+    unsigned mask = (string_sse2_members_(s + i, patterns, count) ^ flip) & ((1u << (n - i)) - 1);
+    return mask ? i + (size_t)__builtin_ctz(mask) : STRING_NOT_FOUND;
+}
+
+static STRING_TARGET_SSE2_ size_t string_sse2_find_any_(const char* s, size_t n, const StringByteSet* set) {
+    return string_sse2_scan_(s, n, set, 1);
+}
+
+static STRING_TARGET_SSE2_ size_t string_sse2_span_(const char* s, size_t n, const StringByteSet* set) {
+    size_t i = string_sse2_scan_(s, n, set, 0);
+    return i == STRING_NOT_FOUND ? n : i;
+}
+
+static STRING_TARGET_SSE2_ size_t string_sse2_find_(const char* h, size_t hn, const char* needle, size_t nn) {
+    if (nn == 0) return 0;
+    if (nn > hn) return STRING_NOT_FOUND;
+    if (nn == 1) return string_sse2_find_byte_(h, hn, needle[0]);
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[nn - 1]);
+    size_t i = 0;
+    for (; i + nn - 1 + 16 <= hn; i += 16) {
+        unsigned mask = string_sse2_eq_(h + i, first) & string_sse2_eq_(h + i + nn - 1, last);
+        while (mask) {
+            size_t k = (size_t)__builtin_ctz(mask);
+            if (memcmp(h + i + k + 1, needle + 1, nn - 2) == 0) return i + k;
+            mask &= mask - 1;
+        }
+    }
+    // Fewer than 16 start positions left
+    size_t left = hn - nn + 1 - i;
+    if (left == 0 || !string_can_overread_(h + i, 16) || !string_can_overread_(h + i + nn - 1, 16)) {
+        return string_find_scalar_(h, i, hn, needle, nn);
+    }
+    unsigned mask = string_sse2_eq_(h + i, first) & string_sse2_eq_(h + i + nn - 1, last) & ((1u << left) - 1);
+    while (mask) {
+        size_t k = (size_t)__builtin_ctz(mask);
+        if (memcmp(h + i + k + 1, needle + 1, nn - 2) == 0) return i + k;
+        mask &= mask - 1;
+    }
+    return STRING_NOT_FOUND;
+}
+
+// ----- AVX2 -----
+
+static inline STRING_TARGET_AVX2_ STRING_NO_ASAN_ unsigned
+string_avx2_eq_(const char* p, __m256i pattern) {
+    return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), pattern));
+}
+
+static STRING_TARGET_AVX2_ STRING_NO_ASAN_ size_t string_avx2_length_(const char* s) {
+    const char* p = (const char*)((uintptr_t)s & ~(uintptr_t)31);
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned mask = string_avx2_eq_(p, zero) >> (s - p);
+    if (mask) return (size_t)__builtin_ctz(mask);
+    p += 32;
+    if ((uintptr_t)p & 32) {
+        mask = string_avx2_eq_(p, zero);
+        if (mask) return (size_t)(p - s) + (size_t)__builtin_ctz(mask);
+        p += 32;
+    }
+    // 64-byte aligned from here: both halves are in the same page
+    for (;; p += 64) {
+        __m256i a = _mm256_load_si256((const __m256i*)p);
+        __m256i b = _mm256_load_si256((const __m256i*)(p + 32));
+        __m256i any = _mm256_cmpeq_epi8(_mm256_min_epu8(a, b), zero);
+        if (_mm256_movemask_epi8(any)) {
+            mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero));
+            if (mask) return (size_t)(p - s) + (size_t)__builtin_ctz(mask);
+            mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, zero));
+            return (size_t)(p - s) + 32 + (size_t)__builtin_ctz(mask);
+        }
+    }
+}
+
+static STRING_TARGET_AVX2_ STRING_NO_ASAN_ size_t string_avx2_find_byte_(const char* s, size_t n, int c) {
+    const __m256i pattern = _mm256_set1_epi8((char)c);
+    size_t i = 0;
+    if (n >= 32) {
+        // One unaligned block, then continue from the next 32-byte boundary so
+        // the main loop never splits a load across two cache lines
+        unsigned mask = string_avx2_eq_(s, pattern);
+        if (mask) return (size_t)__builtin_ctz(mask);
+        i = 32 - ((uintptr_t)s & 31);
+    }
+    for (; i + 128 <= n; i += 128) {
+        __m256i m0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i)), pattern);
+        __m256i m1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i + 32)), pattern);
+        __m256i m2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i + 64)), pattern);
+        __m256i m3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i + 96)), pattern);
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(m0, m1), _mm256_or_si256(m2, m3)))) {
+            uint64_t lo = (uint32_t)_mm256_movemask_epi8(m0) | (uint64_t)(uint32_t)_mm256_movemask_epi8(m1) << 32;
+            if (lo) return i + (size_t)__builtin_ctzll(lo);
+            uint64_t hi = (uint32_t)_mm256_movemask_epi8(m2) | (uint64_t)(uint32_t)_mm256_movemask_epi8(m3) << 32;
+            return i + 64 + (size_t)__builtin_ctzll(hi);
+        }
+    }
+    for (; i + 32 <= n; i += 32) {
+        unsigned mask = string_avx2_eq_(s + i, pattern);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    if (i == n) return STRING_NOT_FOUND;
+    if (!string_can_overread_(s + i, 32)) {
+        size_t tail = string_sse2_find_byte_(s + i, n - i, c);
+        return tail == STRING_NOT_FOUND ? tail : i + tail;
+    }
+    unsigned mask = string_avx2_eq_(s + i, pattern) & ((1u << (n - i)) - 1);
+    return mask ? i + (size_t)__builtin_ctz(mask) : STRING_NOT_FOUND;
+}
+
+// Nibble lookup (Mula). The low nibble picks a byte from the table for the
+// byte's half of the range; bit (high nibble & 7) of that byte is membership.
+// vpshufb returns 0 for indices with bit 7 set, which selects the half.
+static inline STRING_TARGET_AVX2_ unsigned string_avx2_members_(__m256i v, __m256i lo_table, __m256i hi_table) {
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m256i row = _mm256_or_si256(_mm256_shuffle_epi8(lo_table, v),
+                                  _mm256_shuffle_epi8(hi_table, _mm256_xor_si256(v, _mm256_set1_epi8(-128))));
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+    __m256i bit = _mm256_shuffle_epi8(bits, high);
+    return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit));
+}
+
+static inline STRING_TARGET_AVX2_ STRING_NO_ASAN_ size_t
+string_avx2_scan_(const char* s, size_t n, const StringByteSet* set, int want) {
+    const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->nibble_lo));
+    const __m256i hi_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->nibble_hi));
+    unsigned flip = want ? 0 : 0xFFFFFFFFu;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        unsigned mask = string_avx2_members_(v, lo_table, hi_table) ^ flip;
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    if (i == n) return STRING_NOT_FOUND;
+    if (!string_can_overread_(s + i, 32)) return string_find_any_scalar_(s, i, n, set, want);
+    __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+    unsigned mask = (string_avx2_members_(v, lo_table, hi_table) ^ flip) & ((1u << (n - i)) - 1);
+    return mask ? i + (size_t)__builtin_ctz(mask) : STRING_NOT_FOUND;
+}
+
+static STRING_TARGET_AVX2_ size_t string_avx2_find_any_(const char* s, size_t n, const StringByteSet* set) {
+    return string_avx2_scan_(s, n, set, 1);
+}
+
+static STRING_TARGET_AVX2_ size_t string_avx2_span_(const char* s, size_t n, const StringByteSet* set) {
+    size_t i = string_avx2_scan_(s, n, set, 0);
+    return i == STRING_NOT_FOUND ? n : i;
+}
+
+static inline STRING_TARGET_AVX2_ STRING_NO_ASAN_ size_t
+string_avx2_verify_(const char* h, size_t i, uint64_t mask, const char* needle, size_t nn) {
+    while (mask) {
+        size_t k = (size_t)__builtin_ctzll(mask);
+        if (memcmp(h + i + k + 1, needle + 1, nn - 2) == 0) return i + k;
+        mask &= mask - 1;
+    }
+    return STRING_NOT_FOUND;
+}
+
+static STRING_TARGET_AVX2_ STRING_NO_ASAN_ size_t
+string_avx2_find_(const char* h, size_t hn, const char* needle, size_t nn) {
+    if (nn == 0) return 0;
+    if (nn > hn) return STRING_NOT_FOUND;
+    if (nn == 1) return string_avx2_find_byte_(h, hn, needle[0]);
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[nn - 1]);
+    const char* tail = h + nn - 1;
+    size_t i = 0, found;
+    for (; i + nn - 1 + 64 <= hn; i += 64) {
+        uint64_t lo = string_avx2_eq_(h + i, first) & string_avx2_eq_(tail + i, last);
+        uint64_t hi = string_avx2_eq_(h + i + 32, first) & string_avx2_eq_(tail + i + 32, last);
+        uint64_t mask = lo | hi << 32;
+        if (mask && (found = string_avx2_verify_(h, i, mask, needle, nn)) != STRING_NOT_FOUND) return found;
+    }
+    for (; i + nn - 1 + 32 <= hn; i += 32) {
+        uint64_t mask = string_avx2_eq_(h + i, first) & string_avx2_eq_(tail + i, last);
+        if (mask && (found = string_avx2_verify_(h, i, mask, needle, nn)) != STRING_NOT_FOUND) return found;
+    }
+    // Fewer than 32 start positions left
+    size_t left = hn - nn + 1 - i;
+    if (left == 0 || !string_can_overread_(h + i, 32) || !string_can_overread_(tail + i, 32)) {
+        return string_find_scalar_(h, i, hn, needle, nn);
+    }
+    uint64_t mask = string_avx2_eq_(h + i, first) & string_avx2_eq_(tail + i, last) & ((1u << left) - 1);
+    return string_avx2_verify_(h, i, mask, needle, nn);
+}
+
+#endif // STRING_SIMD_HAVE_X86
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+static const StringKernels string_kernel_table_[STRING_VARIANT_COUNT] = {
+    [STRING_SWAR] = {"swar", string_swar_length_, string_swar_find_byte_, string_swar_find_any_,
+                     string_swar_span_, string_swar_find_},
+#ifdef STRING_SIMD_HAVE_X86
+    [STRING_SSE2] = {"sse2", string_sse2_length_, string_sse2_find_byte_, string_sse2_find_any_,
+                     string_sse2_span_, string_sse2_find_},
+    [STRING_AVX2] = {"avx2", string_avx2_length_, string_avx2_find_byte_, string_avx2_find_any_,
+                     string_avx2_span_, string_avx2_find_},
+#endif
+};
+
+// Returns 1 if the variant is compiled in and the running CPU supports it.
+static inline int string_variant_supported(StringVariant v) {
+    if ((unsigned)v >= STRING_VARIANT_COUNT || string_kernel_table_[v].name == NULL) return 0;
+#ifdef STRING_SIMD_HAVE_X86
+    __builtin_cpu_init();
+    switch (v) {
+        case STRING_SSE2: return __builtin_cpu_supports("sse2") != 0;
+        case STRING_AVX2: return __builtin_cpu_supports("avx2") != 0;
+        default: break;
+    }
+#endif
+    return 1;
+}
+
+static inline const StringKernels* string_kernels_for(StringVariant v) {
+    return string_variant_supported(v) ? &string_kernel_table_[v] : NULL;
+}
+
+static const StringKernels* string_active_ = NULL;
+
+static inline const StringKernels* string_select_(void) {
+    const char* forced = getenv("STRING_SIMD_VARIANT");
+    if (forced != NULL) {
+        for (int v = 0; v < STRING_VARIANT_COUNT; v++) {
+            if (string_variant_supported((StringVariant)v) && strcmp(string_kernel_table_[v].name, forced) == 0) {
+                return &string_kernel_table_[v];
+            }
+        }
+    }
+    // Table order is slowest to fastest: take the last one the CPU can run
+    for (int v = STRING_VARIANT_COUNT - 1; v > STRING_SWAR; v--) {
+        if (string_variant_supported((StringVariant)v)) return &string_kernel_table_[v];
+    }
+    return &string_kernel_table_[STRING_SWAR];
+}
+
+// Resolve the dispatch table before main() so the hot path is a plain indirect call
+__attribute__((constructor)) static void string_dispatch_init_(void) {
+    __atomic_store_n(&string_active_, string_select_(), __ATOMIC_RELEASE);
+}
+
+static inline const StringKernels* string_kernels(void) {
+    const StringKernels* k = __atomic_load_n(&string_active_, __ATOMIC_ACQUIRE);
+    if (k == NULL) {
+        // Only reachable from another constructor that runs before ours
+        k = string_select_();
+        __atomic_store_n(&string_active_, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+static inline size_t string_length(const char* s) {
+    return string_kernels()->length(s);
+}
+
+static inline size_t string_find_byte(const char* s, size_t n, int c) {
+    return string_kernels()->find_byte(s, n, c);
+}
+
+static inline size_t string_find_any(const char* s, size_t n, const StringByteSet* set) {
+    return string_kernels()->find_any(s, n, set);
+}
+
+static inline size_t string_span(const char* s, size_t n, const StringByteSet* set) {
+    return string_kernels()->span(s, n, set);
+}
+
+static inline size_t string_find(const char* h, size_t hn, const char* needle, size_t nn) {
+    return string_kernels()->find(h, hn, needle, nn);
+}
+
+// ---------------------------------------------------------------------------
+// Zero-copy tokenizer
+// ---------------------------------------------------------------------------
+
+#define STRING_TOKENS_SKIP_EMPTY 0  // strtok: runs of delimiters separate one token
+#define STRING_TOKENS_KEEP_EMPTY 1  // strsep: "a,,b" is "a", "", "b"
+
+// A (pointer, length) view into someone else's buffer. Not NUL-terminated.
+typedef struct {
+    const char* ptr;
+    size_t len;
+} StringSpan;
+
+typedef struct {
+    const char* cur;
+    const char* end;
+    const StringKernels* kernels;
+    StringByteSet delims;
+    int keep_empty;
+    int done;
+} StringTokenizer;
+
+static inline void string_tokenizer_init(StringTokenizer* t, const char* s, size_t n, const StringByteSet* delims,
+                                         int keep_empty) {
+    t->cur = s;
+    t->end = s + n;
+    t->kernels = string_kernels();
+    t->delims = *delims;
+    t->keep_empty = keep_empty;
+    t->done = 0;
+}
+
+// Stores the next token in *token and returns 1, or returns 0 when the input is used up.
+static inline int string_tokenizer_next(StringTokenizer* t, StringSpan* token) {
+    if (t->done) return 0;
+    size_t left = (size_t)(t->end - t->cur);
+    if (!t->keep_empty && left > 0 && string_byte_set_contains(&t->delims, (unsigned char)*t->cur)) {
+        size_t skip = t->kernels->span(t->cur, left, &t->delims);
+        t->cur += skip;
+        left -= skip;
+    }
+    if (!t->keep_empty && left == 0) {
+        t->done = 1;
+        return 0;
+    }
+    size_t len = t->kernels->find_any(t->cur, left, &t->delims);
+    token->ptr = t->cur;
+    if (len == STRING_NOT_FOUND) {
+        token->len = left;
+        t->cur = t->end;
+        t->done = 1;
+    } else {
+        token->len = len;
+        t->cur += len + 1;
+    }
+    return 1;
+}
+
+#endif // STRING_SIMD_H
@@ -343,7 +343,10 @@ void section8_performance_analysis() {
     printf("1. Use inline functions for performance-critical small functions\n");
     printf("2. Consider function inlining when using function pointers in hot paths\n");
     printf("3. Group related function pointers to improve cache locality\n");
-    printf("4. Use Profile-Guided Optimization (PGO) to optimize indirect calls\n\n");
+    printf("4. Use Profile-Guided Optimization (PGO) to optimize indirect calls\n");
+    printf("5. Generate type-specialised code instead of passing callbacks: see\n");
+    printf("   Chapter13DataStructures/generic.h (DEFINE_SORT, DEFINE_FOLD) and MacroTemplates.c,\n");
+    printf("   which benchmarks them against qsort, bsearch and BinaryOperation pointers\n\n");
 }
 
 void section9_how_to_contribute() {
@@ -398,6 +401,8 @@ void greet(const char* name) {
     printf("Hello, %s!\n", name);
 }
 
+// The subtraction overflows for operands far apart (e.g. INT_MAX and -1);
+// (x > y) - (x < y) is the safe form. See Chapter14Algorithms/Sorting.c.
 int compare_int(const void* a, const void* b) {
     return (*(int*)a - *(int*)b);
 }
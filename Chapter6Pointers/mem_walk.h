@@ -0,0 +1,267 @@
+/*
+mem_walk.h - Pointer-Walking and Array Traversal Kernels for Memory Benchmarks
+================================================
+
+The kernels a memory-hierarchy benchmark needs. Each one isolates one access
+pattern:
+
+    MemWalkList list;
+    memwalk_list_init(&list, n, MEMWALK_SHUFFLED, seed);  // One node per cache line
+    memwalk_chase(list.head, steps);                      // Latency: each load waits for the last
+    memwalk_chase_chains(starts, 8, steps);               // 8 independent chases in one loop
+    memwalk_list_sum(&list, steps);                       // Linked-list traversal that uses the data
+    memwalk_list_destroy(&list);
+
+    memwalk_sum(a, n);                                    // Sequential, one accumulator
+    memwalk_sum_unrolled(a, n);                           // Sequential, four accumulators
+    memwalk_sum_prefetch(a, n, distance);                 // Sequential + __builtin_prefetch
+    memwalk_sum_strided(a, n, stride);                    // Every stride-th element
+    memwalk_sum_strided_prefetch(a, n, stride, distance);
+    memwalk_sum_gather(a, idx, m);                        // a[idx[i]]: random but independent
+    memwalk_sum_gather_prefetch(a, idx, m, distance);
+
+Design:
+- MemWalkNode is exactly one 64-byte cache line. A chase over n nodes touches n
+  distinct lines, so the working set is n * 64 bytes whatever the layout.
+- MEMWALK_SHUFFLED links the nodes into one random cycle (Sattolo's algorithm), so
+  a chase visits every node before repeating and the hardware prefetchers cannot
+  guess the next line. MEMWALK_SEQUENTIAL links node i to node i + 1, the layout
+  a pool or arena allocator gives a list built in order. MEMWALK_STRIDED links
+  node i to node (i + stride) mod n, with stride coprime to n so that the cycle
+  still covers every node. All layouts run the same pointer-chasing code, so any
+  difference between them comes from the memory system.
+- A chase is latency-bound because each address comes from the previous load.
+  memwalk_chase_chains interleaves up to MEMWALK_MAX_CHAINS independent chases,
+  which shows how many misses the core overlaps (memory-level parallelism). That
+  is the gain a batched or breadth-first traversal would get.
+- Prefetching needs the address in advance. Arrays and index lists provide it
+  (a[i + distance], a[idx[i + distance]]). A linked list does not: knowing the
+  node after next means loading the next one first. Prefetches ask for all cache
+  levels (locality 3, prefetcht0 on x86); the non-temporal hint made the
+  sequential sum twice as slow on the machines tried. __builtin_prefetch past the
+  end of an array is harmless, but the kernels stop prefetching there anyway.
+- memwalk_list_init returns -1 with errno set to EINVAL (n == 0, or a stride not
+  coprime with n) or ENOMEM. Node memory comes from aligned_alloc().
+*/
+
+#ifndef MEM_WALK_H
+#define MEM_WALK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#define MEMWALK_LINE 64
+#define MEMWALK_MAX_CHAINS 16
+
+typedef struct MemWalkNode {
+    struct MemWalkNode* next;
+    uint64_t value;
+    char pad[MEMWALK_LINE - sizeof(struct MemWalkNode*) - sizeof(uint64_t)];
+} MemWalkNode;
+
+_Static_assert(sizeof(MemWalkNode) == MEMWALK_LINE, "MemWalkNode is one cache line");
+
+typedef enum {
+    MEMWALK_SEQUENTIAL,   // node i -> node i + 1
+    MEMWALK_STRIDED,      // node i -> node i + stride (mod n)
+    MEMWALK_SHUFFLED      // One random cycle through all nodes
+} MemWalkLayout;
+
+typedef struct {
+    MemWalkNode* nodes;   // n nodes, MEMWALK_LINE-aligned
+    MemWalkNode* head;
+    size_t count;
+} MemWalkList;
+
+// xorshift64*, enough to shuffle benchmark data
+static inline uint64_t memwalk_rand_(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline size_t memwalk_gcd_(size_t a, size_t b) {
+    while (b) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// 'param' is the stride for MEMWALK_STRIDED and the seed for MEMWALK_SHUFFLED.
+// Every layout is a single cycle through all n nodes; value[i] = i.
+static inline int memwalk_list_init(MemWalkList* l, size_t n, MemWalkLayout layout, uint64_t param) {
+    l->nodes = NULL;
+    l->head = NULL;
+    l->count = 0;
+    if (n == 0 || n > SIZE_MAX / sizeof(MemWalkNode) ||
+        (layout == MEMWALK_STRIDED && memwalk_gcd_(n, (size_t)(param % n)) != 1)) {
+        errno = EINVAL;
+        return -1;
+    }
+    MemWalkNode* nodes = (MemWalkNode*)aligned_alloc(MEMWALK_LINE, n * sizeof(MemWalkNode));
+    if (nodes == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) nodes[i].value = i;
+
+    if (layout == MEMWALK_SHUFFLED) {
+        // Sattolo: a uniformly random permutation with a single cycle
+        size_t* order = (size_t*)malloc(n * sizeof(size_t));
+        if (order == NULL) {
+            free(nodes);
+            errno = ENOMEM;
+            return -1;
+        }
+        uint64_t state = param | 1;
+        for (size_t i = 0; i < n; i++) order[i] = i;
+        for (size_t i = n - 1; i > 0; i--) {
+            size_t j = (size_t)(memwalk_rand_(&state) % i);
+            size_t t = order[i];
+            order[i] = order[j];
+            order[j] = t;
+        }
+        for (size_t i = 0; i < n; i++) nodes[i].next = &nodes[order[i]];
+        free(order);
+    } else {
+        size_t step = layout == MEMWALK_STRIDED ? (size_t)(param % n) : 1;
+        for (size_t i = 0; i < n; i++) nodes[i].next = &nodes[(i + step) % n];
+    }
+    l->nodes = nodes;
+    l->head = &nodes[0];
+    l->count = n;
+    return 0;
+}
+
+static inline void memwalk_list_destroy(MemWalkList* l) {
+    free(l->nodes);
+    l->nodes = NULL;
+    l->head = NULL;
+    l->count = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Pointer chasing
+// ---------------------------------------------------------------------------
+
+// Follows 'steps' links and returns where it ended, so the loads cannot be dropped
+static inline const MemWalkNode* memwalk_chase(const MemWalkNode* p, size_t steps) {
+    size_t i = 0;
+    for (; i + 4 <= steps; i += 4) p = p->next->next->next->next;
+    for (; i < steps; i++) p = p->next;
+    return p;
+}
+
+// 'chains' independent chases, one step of each per iteration; starts[] is updated
+static inline void memwalk_chase_chains(const MemWalkNode** starts, int chains, size_t steps) {
+    const MemWalkNode* p[MEMWALK_MAX_CHAINS];
+    if (chains > MEMWALK_MAX_CHAINS) chains = MEMWALK_MAX_CHAINS;
+    for (int c = 0; c < chains; c++) p[c] = starts[c];
+    for (size_t i = 0; i < steps; i++) {
+        for (int c = 0; c < chains; c++) p[c] = p[c]->next;
+    }
+    for (int c = 0; c < chains; c++) starts[c] = p[c];
+}
+
+static inline uint64_t memwalk_list_sum(const MemWalkList* l, size_t steps) {
+    uint64_t sum = 0;
+    const MemWalkNode* p = l->head;
+    for (size_t i = 0; i < steps; i++) {
+        sum += p->value;
+        p = p->next;
+    }
+    return sum;
+}
+
+// ---------------------------------------------------------------------------
+// Arrays
+// ---------------------------------------------------------------------------
+
+static inline uint64_t memwalk_sum(const uint64_t* a, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += a[i];
+    return sum;
+}
+
+static inline uint64_t memwalk_sum_unrolled(const uint64_t* a, size_t n) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i];
+        s1 += a[i + 1];
+        s2 += a[i + 2];
+        s3 += a[i + 3];
+    }
+    for (; i < n; i++) s0 += a[i];
+    return s0 + s1 + s2 + s3;
+}
+
+// 'distance' is in elements; one prefetch per cache line
+static inline uint64_t memwalk_sum_prefetch(const uint64_t* a, size_t n, size_t distance) {
+    const size_t per_line = MEMWALK_LINE / sizeof(uint64_t);
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + per_line <= n; i += per_line) {
+        if (i + distance < n) __builtin_prefetch(&a[i + distance], 0, 3);
+        for (size_t j = 0; j < per_line; j += 4) {
+            s0 += a[i + j];
+            s1 += a[i + j + 1];
+            s2 += a[i + j + 2];
+            s3 += a[i + j + 3];
+        }
+    }
+    for (; i < n; i++) s0 += a[i];
+    return s0 + s1 + s2 + s3;
+}
+
+// a[0], a[stride], a[2 * stride], ... then a[1], a[1 + stride], ...: every element
+// once, but consecutive loads are stride * 8 bytes apart
+static inline uint64_t memwalk_sum_strided(const uint64_t* a, size_t n, size_t stride) {
+    uint64_t sum = 0;
+    if (stride == 0) stride = 1;
+    for (size_t start = 0; start < stride && start < n; start++) {
+        for (size_t i = start; i < n; i += stride) sum += a[i];
+    }
+    return sum;
+}
+
+// 'distance' is in accesses ahead, not elements
+static inline uint64_t memwalk_sum_strided_prefetch(const uint64_t* a, size_t n, size_t stride, size_t distance) {
+    uint64_t sum = 0;
+    if (stride == 0) stride = 1;
+    size_t ahead = distance * stride;
+    for (size_t start = 0; start < stride && start < n; start++) {
+        for (size_t i = start; i < n; i += stride) {
+            if (i + ahead < n) __builtin_prefetch(&a[i + ahead], 0, 3);
+            sum += a[i];
+        }
+    }
+    return sum;
+}
+
+static inline uint64_t memwalk_sum_gather(const uint64_t* a, const uint32_t* idx, size_t m) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < m; i++) sum += a[idx[i]];
+    return sum;
+}
+
+static inline uint64_t memwalk_sum_gather_prefetch(const uint64_t* a, const uint32_t* idx, size_t m,
+                                                   size_t distance) {
+    uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + distance < m; i++) {
+        __builtin_prefetch(&a[idx[i + distance]], 0, 3);
+        sum += a[idx[i]];
+    }
+    for (; i < m; i++) sum += a[idx[i]];
+    return sum;
+}
+
+#endif  // MEM_WALK_H
@@ -19,7 +19,10 @@ Table of Contents:
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
-#include <time.h>
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+#include "../Chapter15AdvancedMemoryManagement/pool_alloc.h"
+#include "../Chapter13DataStructures/generic.h"  // After pool_alloc.h: enables vector_pool_allocator()
+#include "safe_alloc.h"
 
 // Function prototypes
 void section1_overview();
@@ -33,13 +36,13 @@ void section8_performance_analysis();
 void section9_how_to_contribute();
 
 // Example functions for demonstration
-void* safe_malloc(size_t size);
-void* safe_calloc(size_t nmemb, size_t size);
-void* safe_realloc(void* ptr, size_t size);
 void demonstrate_malloc();
 void demonstrate_calloc();
 void demonstrate_realloc();
 void demonstrate_free();
+void demonstrate_vector_growth();
+void compare_allocator_mixes();
+void compare_vector_growth();
 
 int main() {
     printf("Cheat Sheet: Dynamic Memory Allocation in C\n");
@@ -95,6 +98,9 @@ void section2_syntax_and_examples() {
     printf("\nrealloc() example:\n");
     demonstrate_realloc();
 
+    printf("\nGrowing through a vector instead of realloc by hand:\n");
+    demonstrate_vector_growth();
+
     printf("\nfree() example:\n");
     demonstrate_free();
 }
@@ -242,7 +248,8 @@ void section5_advanced_concepts() {
     printf("1. Garbage collection techniques in C\n");
     printf("2. Memory-mapped files for large datasets\n");
     printf("3. Custom allocators for specific memory patterns\n");
-    printf("4. Lock-free memory allocation for concurrent programs\n\n");
+    printf("4. Lock-free memory allocation for concurrent programs\n");
+    printf("   (lock-free SPSC/MPMC queues: Chapter16MultithreadingAndConcurrency/lockfree_queue.h)\n\n");
 
     printf("Emerging trends:\n");
     printf("1. Rust's ownership model as an alternative to manual memory management\n");
@@ -367,77 +374,22 @@ void section8_performance_analysis() {
     printf("3. Batch allocations and deallocations to reduce overhead\n");
     printf("4. Consider custom allocators for specific allocation patterns\n\n");
 
-    // Performance comparison example
-    #define TEST_SIZE 1000000
-    #define POOL_BLOCK_SIZE 1024
-
-    clock_t start, end;
-    double cpu_time_used;
-
-    // Standard malloc/free
-    start = clock();
-    for (int i = 0; i < TEST_SIZE; i++) {
-        int* p = (int*)malloc(sizeof(int));
-        if (p) {
-            *p = i;
-            free(p);
-        }
-    }
-    end = clock();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Standard malloc/free time: %f seconds\n", cpu_time_used);
-
-    // Simple memory pool
-    typedef struct MemoryPool {
-        char* memory;
-        size_t used;
-        struct MemoryPool* next;
-    } MemoryPool;
-
-    MemoryPool* create_pool() {
-        MemoryPool* pool = (MemoryPool*)malloc(sizeof(MemoryPool));
-        if (pool) {
-            pool->memory = (char*)malloc(POOL_BLOCK_SIZE);
-            pool->used = 0;
-            pool->next = NULL;
-        }
-        return pool;
-    }
-
-    void* pool_alloc(MemoryPool** pool, size_t size) {
-        if (!*pool || (*pool)->used + size > POOL_BLOCK_SIZE) {
-            MemoryPool* new_pool = create_pool();
-            if (!new_pool) return NULL;
-            new_pool->next = *pool;
-            *pool = new_pool;
-        }
-        void* ptr = &((*pool)->memory[(*pool)->used]);
-        (*pool)->used += size;
-        return ptr;
-    }
+    // Performance comparison example: malloc/free vs a freeable slab pool
+    // (Chapter15AdvancedMemoryManagement/pool_alloc.h) across three alloc/free mixes
+    compare_allocator_mixes();
 
-    void destroy_pool(MemoryPool* pool) {
-        while (pool) {
-            MemoryPool* next = pool->next;
-            free(pool->memory);
-            free(pool);
-            pool = next;
-        }
-    }
+    printf("\nNote: Both allocators are timed with deallocation included. The slab pool\n");
+    printf("serves each object from a per-thread intrusive free list, so alloc and free are\n");
+    printf("O(1) pointer operations that only take a lock once per batch of objects.\n");
 
-    MemoryPool* pool = create_pool();
-    start = clock();
-    for (int i = 0; i < TEST_SIZE; i++) {
-        int* p = (int*)pool_alloc(&pool, sizeof(int));
-        if (p) *p = i;
-    }
-    end = clock();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Memory pool allocation time: %f seconds\n", cpu_time_used);
-    destroy_pool(pool);
+    // Growing one large buffer: realloc, copying growth and mremap growth
+    // (Chapter13DataStructures/vector.h)
+    printf("\n");
+    compare_vector_growth();
 
-    printf("\nNote: The memory pool is faster for allocations but doesn't include deallocation time.\n");
-    printf("In practice, the pool would be reused, amortizing the creation and destruction costs.\n");
+    printf("\nNote: Copying growth stalls one push for as long as the copy takes (tens of ms\n");
+    printf("at 256 MB). An mremap'd buffer keeps its pages and only moves their mappings, so\n");
+    printf("the worst push stays near a page-fault burst whatever the size.\n");
 
     printf("\nOptimization tips based on performance analysis:\n");
     printf("1. Use memory pools for frequent small allocations of fixed size.\n");
@@ -476,32 +428,7 @@ void section9_how_to_contribute() {
 
 // Helper functions used in the examples
 
-void* safe_malloc(size_t size) {
-    void* ptr = malloc(size);
-    if (ptr == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-    return ptr;
-}
-
-void* safe_calloc(size_t nmemb, size_t size) {
-    void* ptr = calloc(nmemb, size);
-    if (ptr == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-    return ptr;
-}
-
-void* safe_realloc(void* ptr, size_t size) {
-    void* new_ptr = realloc(ptr, size);
-    if (new_ptr == NULL && size != 0) {
-        fprintf(stderr, "Memory reallocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-    return new_ptr;
-}
+// safe_malloc, safe_calloc, safe_realloc and safe_free come from safe_alloc.h
 
 void demonstrate_malloc() {
     int* numbers = (int*)safe_malloc(5 * sizeof(int));
@@ -513,7 +440,7 @@ void demonstrate_malloc() {
         printf("%d ", numbers[i]);
     }
     printf("\n");
-    free(numbers);
+    safe_free(numbers);
 }
 
 void demonstrate_calloc() {
@@ -523,7 +450,7 @@ void demonstrate_calloc() {
         printf("%d ", numbers[i]);  // Will print all zeros
     }
     printf("\n");
-    free(numbers);
+    safe_free(numbers);
 }
 
 void demonstrate_realloc() {
@@ -539,13 +466,236 @@ void demonstrate_realloc() {
         printf("%d ", numbers[i]);
     }
     printf("\n");
-    free(numbers);
+    safe_free(numbers);
+}
+
+DEFINE_VECTOR(int)
+
+// demonstrate_realloc() grows by hand; a vector does the same with a growth
+// policy, an allocator of choice and a record of what each resize cost
+void demonstrate_vector_growth() {
+    SizeClassPool pool;
+    if (size_class_pool_init(&pool) != 0) {
+        fprintf(stderr, "Pool initialization failed\n");
+        return;
+    }
+    VectorAllocator from_pool;
+    vector_pool_allocator(&from_pool, &pool);
+    VectorPolicy policy = vector_policy_default();
+    policy.growth_num = 3;  // 1.5x
+    policy.growth_den = 2;
+
+    Vector_int numbers;
+    vector_int_init_with(&numbers, &policy, &from_pool);
+    printf("Capacities:");
+    size_t last = 0;
+    for (int i = 0; i < 100; i++) {
+        if (vector_int_push(&numbers, i * 10) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            break;
+        }
+        if (numbers.capacity != last) printf(" %zu", last = numbers.capacity);
+    }
+    printf("\n");
+    vector_int_shrink_to_fit(&numbers);
+    const VectorStats* st = &numbers.control.stats;
+    printf("size %zu, capacity %zu after shrink_to_fit, last %d\n", numbers.size, numbers.capacity,
+           numbers.data[numbers.size - 1]);
+    printf("%llu resizes, %llu copies, %llu bytes copied (pool allocator)\n", (unsigned long long)st->resizes,
+           (unsigned long long)st->moves, (unsigned long long)st->bytes_copied);
+    vector_int_destroy(&numbers);
+    size_class_pool_destroy(&pool);
 }
 
 void demonstrate_free() {
     int* number = (int*)safe_malloc(sizeof(int));
     *number = 42;
     printf("Free example: %d\n", *number);
-    free(number);
+    safe_free(number);
     // number = NULL;  // Good practice to prevent use after free
 }
+
+// Allocator benchmark support for section 8
+#define MIX_OBJECT_SIZE 32
+#define MIX_OPERATIONS 1000000
+#define MIX_LIVE_SET 4096
+
+typedef struct {
+    SlabPool* pool;          // NULL selects malloc/free
+    void** slots;
+    unsigned int seed;
+} AllocMixBench;
+
+void* mix_alloc(AllocMixBench* bench) {
+    void* p = bench->pool ? slab_pool_alloc(bench->pool) : malloc(MIX_OBJECT_SIZE);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    *(int*)p = 1;
+    return p;
+}
+
+void mix_free(AllocMixBench* bench, void* p) {
+    if (bench->pool) slab_pool_free(bench->pool, p);
+    else free(p);
+}
+
+// Allocate and immediately free: the loop the old benchmark used
+void mix_pairs_run(void* ctx) {
+    AllocMixBench* bench = (AllocMixBench*)ctx;
+    for (int i = 0; i < MIX_OPERATIONS; i++) {
+        void* p = mix_alloc(bench);
+        BENCH_DO_NOT_OPTIMIZE(p);
+        mix_free(bench, p);
+    }
+}
+
+// Allocate a whole live set, then free it in the same order (FIFO)
+void mix_bulk_run(void* ctx) {
+    AllocMixBench* bench = (AllocMixBench*)ctx;
+    for (int round = 0; round < MIX_OPERATIONS / MIX_LIVE_SET; round++) {
+        for (int i = 0; i < MIX_LIVE_SET; i++) bench->slots[i] = mix_alloc(bench);
+        for (int i = 0; i < MIX_LIVE_SET; i++) mix_free(bench, bench->slots[i]);
+    }
+}
+
+// Steady-state churn: replace a random member of a live set on every step
+void mix_churn_run(void* ctx) {
+    AllocMixBench* bench = (AllocMixBench*)ctx;
+    for (int i = 0; i < MIX_LIVE_SET; i++) bench->slots[i] = mix_alloc(bench);
+    unsigned int x = bench->seed;
+    for (int i = 0; i < MIX_OPERATIONS; i++) {
+        x = x * 1103515245u + 12345u;
+        int victim = (x >> 8) % MIX_LIVE_SET;
+        mix_free(bench, bench->slots[victim]);
+        bench->slots[victim] = mix_alloc(bench);
+    }
+    for (int i = 0; i < MIX_LIVE_SET; i++) mix_free(bench, bench->slots[i]);
+}
+
+void compare_allocator_mixes() {
+    void* slots[MIX_LIVE_SET];
+    SlabPool pool;
+    if (slab_pool_init(&pool, MIX_OBJECT_SIZE) != 0) {
+        fprintf(stderr, "Pool initialization failed\n");
+        return;
+    }
+
+    AllocMixBench with_malloc = {NULL, slots, 42};
+    AllocMixBench with_pool = {&pool, slots, 42};
+    BenchSuite suite;
+
+    bench_suite_init(&suite, "32-byte objects: malloc/free vs slab pool");
+    bench_suite_run(&suite, "malloc/free pairs", mix_pairs_run, &with_malloc, MIX_OPERATIONS);
+    bench_suite_run(&suite, "slab pool pairs", mix_pairs_run, &with_pool, MIX_OPERATIONS);
+    bench_suite_run(&suite, "malloc/free bulk", mix_bulk_run, &with_malloc, MIX_OPERATIONS);
+    bench_suite_run(&suite, "slab pool bulk", mix_bulk_run, &with_pool, MIX_OPERATIONS);
+    bench_suite_run(&suite, "malloc/free random churn", mix_churn_run, &with_malloc, MIX_OPERATIONS);
+    bench_suite_run(&suite, "slab pool random churn", mix_churn_run, &with_pool, MIX_OPERATIONS);
+    bench_suite_report(&suite);
+
+    printf("Slab pool used %zu slab(s) of %zu bytes\n", pool.slab_count, pool.slab_size);
+    slab_pool_destroy(&pool);
+}
+
+// Vector growth benchmark support for section 8
+#define GROW_ELEMENTS ((size_t)32 << 20)  // 32M uint64_t: 256 MB
+
+typedef uint64_t u64;
+DEFINE_VECTOR(u64)
+
+// Every resize moves: malloc a new block, copy the live bytes, free the old one.
+// This is hand-written growth code, or any allocator that cannot grow in place.
+static void* copying_resize(void* ctx, void* ptr, size_t old_bytes, size_t used_bytes, size_t new_bytes,
+                            size_t* copied) {
+    (void)ctx;
+    (void)old_bytes;
+    void* p = malloc(new_bytes);
+    if (p == NULL) return NULL;
+    if (used_bytes) memcpy(p, ptr, used_bytes);
+    free(ptr);
+    *copied = used_bytes;
+    return p;
+}
+
+static void copying_release(void* ctx, void* ptr, size_t bytes) {
+    (void)ctx;
+    (void)bytes;
+    free(ptr);
+}
+
+static const VectorAllocator copying_allocator = {"malloc + copy", copying_resize, copying_release, NULL};
+
+typedef struct {
+    VectorPolicy policy;
+    const VectorAllocator* allocator;
+    int reserve_first;
+    double worst_grow_ns;      // Longest single push, from the last run
+    VectorStats stats;         // From the last run
+} GrowBench;
+
+void vector_growth_run(void* ctx) {
+    GrowBench* b = (GrowBench*)ctx;
+    Vector_u64 v;
+    vector_u64_init_with(&v, &b->policy, b->allocator);
+    if (b->reserve_first && vector_u64_reserve(&v, GROW_ELEMENTS) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    double worst = 0;
+    for (size_t i = 0; i < GROW_ELEMENTS; i++) {
+        if (v.size == v.capacity) {
+            // Only pushes that resize are timed; the rest cost a store
+            uint64_t t0 = bench_now_ns();
+            int rc = vector_u64_push(&v, i);
+            double ns = (double)(bench_now_ns() - t0);
+            if (ns > worst) worst = ns;
+            if (rc != 0) {
+                fprintf(stderr, "Memory allocation failed\n");
+                break;
+            }
+        } else {
+            v.data[v.size++] = i;
+        }
+    }
+    BENCH_DO_NOT_OPTIMIZE(v.data[v.size / 2]);
+    b->worst_grow_ns = worst;
+    b->stats = v.control.stats;
+    vector_u64_destroy(&v);
+}
+
+void compare_vector_growth() {
+    VectorPolicy doubling = vector_policy_default();
+    doubling.huge_bytes = 0;  // Heap only: compare realloc and copying growth
+    VectorPolicy one_and_half = doubling;
+    one_and_half.growth_num = 3;
+    one_and_half.growth_den = 2;
+    VectorPolicy mapped = vector_policy_default();
+
+    GrowBench cases[] = {
+        {doubling, NULL, 0, 0, {0}},
+        {doubling, &copying_allocator, 0, 0, {0}},
+        {one_and_half, &copying_allocator, 0, 0, {0}},
+        {mapped, NULL, 0, 0, {0}},
+        {mapped, NULL, 1, 0, {0}},
+    };
+    const char* names[] = {"realloc, 2x", "malloc + copy, 2x", "malloc + copy, 1.5x", "mremap above 1 MB, 2x",
+                           "reserve once"};
+    const int count = (int)(sizeof(cases) / sizeof(cases[0]));
+
+    BenchSuite suite;
+    bench_suite_init(&suite, "Push 32M uint64_t (256 MB) into an empty vector");
+    for (int i = 0; i < count; i++) bench_suite_run(&suite, names[i], vector_growth_run, &cases[i], GROW_ELEMENTS);
+    bench_suite_report(&suite);
+
+    printf("%-24s %9s %7s %12s %7s %14s\n", "case", "resizes", "copies", "MB copied", "remaps", "worst push us");
+    for (int i = 0; i < count; i++) {
+        const VectorStats* st = &cases[i].stats;
+        printf("%-24s %9llu %7llu %12.1f %7llu %14.1f\n", names[i], (unsigned long long)st->resizes,
+               (unsigned long long)st->moves, (double)st->bytes_copied / (1 << 20), (unsigned long long)st->remaps,
+               cases[i].worst_grow_ns / 1e3);
+    }
+    printf("realloc copies are counted whenever the address changes; glibc may have remapped\n");
+    printf("blocks it holds as mmap chunks instead of copying them.\n");
+}
@@ -20,6 +20,8 @@ Table of Contents:
 #include <string.h>
 #include <assert.h>
 #include <time.h>
+#include "../Chapter15AdvancedMemoryManagement/arena.h"
+#include "safe_alloc.h"
 
 // Function prototypes
 void section1_overview();
@@ -33,11 +35,8 @@ void section8_performance_analysis();
 void section9_how_to_contribute();
 
 // Example functions for demonstration
-void* safe_malloc(size_t size);
 void demonstrate_memory_leak();
 void demonstrate_leak_fix();
-void* create_int_array(size_t size);
-void free_int_array(void* ptr);
 
 int main() {
     printf("Cheat Sheet: Memory Leaks and How to Avoid Them in C\n");
@@ -98,9 +97,17 @@ void section2_syntax_and_examples() {
     if (safe_ptr != NULL) {
         *safe_ptr = 100;
         printf("Safely allocated value: %d\n", *safe_ptr);
-        free(safe_ptr);
+        safe_free(safe_ptr);
         safe_ptr = NULL;
     }
+
+    int* values = (int*)create_int_array(16);
+    printf("create_int_array(16) is zeroed: values[15] = %d\n", values[15]);
+    free_int_array(values);
+
+    // Built with -DALLOC_TRACKING this prints per-site counts and the size histogram,
+    // and the leak above is reported with its file and line at exit.
+    alloc_track_report(stdout);
 }
 
 void section3_best_practices() {
@@ -128,28 +135,28 @@ void section3_best_practices() {
     printf("4. Use memory pools for frequent allocations of fixed-size objects.\n");
     printf("5. Employ garbage collection techniques for complex data structures.\n\n");
 
-    // Example: Simple memory pool
-    #define POOL_SIZE 1024
-    static char memory_pool[POOL_SIZE];
-    static size_t pool_index = 0;
+    // Example: Arena allocation (Chapter15AdvancedMemoryManagement/arena.h)
+    // Everything allocated for one unit of work is released together, so there is
+    // no individual free() to forget.
+    Arena arena;
+    arena_init(&arena, 1024);
 
-    void* pool_alloc(size_t size) {
-        if (pool_index + size > POOL_SIZE) return NULL;
-        void* ptr = &memory_pool[pool_index];
-        pool_index += size;
-        return ptr;
+    int* arena_int = (int*)arena_alloc(&arena, sizeof(int));
+    if (arena_int) {
+        *arena_int = 42;
+        printf("Value from arena: %d\n", *arena_int);
     }
 
-    void pool_reset() {
-        pool_index = 0;
-    }
+    // Checkpoint before temporary work, then roll back to discard it
+    ArenaMark mark = arena_mark(&arena);
+    char* scratch = arena_strdup(&arena, "temporary scratch data");
+    printf("Scratch string: %s (arena in use: %zu bytes)\n", scratch, arena_bytes_used(&arena));
+    arena_rollback(&arena, mark);
+    printf("After rollback: %zu bytes in use\n", arena_bytes_used(&arena));
 
-    int* pool_int = (int*)pool_alloc(sizeof(int));
-    if (pool_int) {
-        *pool_int = 42;
-        printf("Value from memory pool: %d\n", *pool_int);
-    }
-    pool_reset();  // Reset the pool instead of individual frees
+    arena_reset(&arena);    // Release everything at once instead of individual frees
+    arena_destroy(&arena);  // Return the chunks to malloc
+    printf("\n");
 }
 
 void section4_real_world_applications() {
@@ -226,7 +233,8 @@ void section5_advanced_concepts() {
     printf("1. Automated memory management techniques in C\n");
     printf("2. Custom allocators for specific memory patterns\n");
     printf("3. Memory tagging and canary values for leak detection\n");
-    printf("4. Thread-safe memory management in concurrent programs\n\n");
+    printf("4. Thread-safe memory management in concurrent programs\n");
+    printf("   (hand objects between threads without locks: Chapter16MultithreadingAndConcurrency/lockfree_queue.h)\n\n");
 
     printf("Emerging trends:\n");
     printf("1. Rust's ownership model as an alternative to manual memory management\n");
@@ -292,7 +300,8 @@ void section6_faqs_and_troubleshooting() {
     printf("1. Use memory profiling tools to identify leaking allocations.\n");
     printf("2. Implement logging for all allocations and deallocations in critical sections.\n");
     printf("3. Use debugger watchpoints to track specific memory addresses.\n");
-    printf("4. Simplify code to isolate leaks, then gradually reintroduce complexity.\n\n");
+    printf("4. Simplify code to isolate leaks, then gradually reintroduce complexity.\n");
+    printf("5. Rebuild with -DALLOC_TRACKING -pthread: safe_alloc.h then reports leaks by call site at exit.\n\n");
 
     // Example: Simple allocation tracker
     #define MAX_ALLOCS 1000
@@ -469,19 +478,10 @@ void section9_how_to_contribute() {
     printf("Thank you for helping to improve this resource for the C programming community!\n");
 }
 
-// Helper functions used in the examples
-
-void* safe_malloc(size_t size) {
-    void* ptr = malloc(size);
-    if (ptr == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-    return ptr;
-}
+// Helper functions used in the examples (safe_malloc and friends live in safe_alloc.h)
 
 void demonstrate_memory_leak() {
-    int* leak = (int*)malloc(sizeof(int));
+    int* leak = (int*)safe_malloc(sizeof(int));
     if (leak != NULL) {
         *leak = 42;
         printf("Leaked value: %d\n", *leak);
@@ -490,19 +490,11 @@ void demonstrate_memory_leak() {
 }
 
 void demonstrate_leak_fix() {
-    int* no_leak = (int*)malloc(sizeof(int));
+    int* no_leak = (int*)safe_malloc(sizeof(int));
     if (no_leak != NULL) {
         *no_leak = 42;
         printf("Non-leaked value: %d\n", *no_leak);
-        free(no_leak);
+        safe_free(no_leak);
         no_leak = NULL;  // Good practice to avoid dangling pointers
     }
 }
-
-void* create_int_array(size_t size) {
-    return calloc(size, sizeof(int));
-}
-
-void free_int_array(void* ptr) {
-    free(ptr);
-}
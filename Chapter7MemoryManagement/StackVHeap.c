@@ -18,8 +18,8 @@ Table of Contents:
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <assert.h>
+#include "../Chapter18DebuggingAndProfiling/bench.h"
 
 // Function prototypes
 void section1_overview();
@@ -381,33 +381,34 @@ void memory_leak_example() {
     // Intentionally not freeing 'leak' to demonstrate a memory leak
 }
 
-void compare_stack_heap_performance() {
-    const int iterations = 1000000;
-    clock_t start, end;
-    double cpu_time_used;
-
-    // Stack allocation
-    start = clock();
+void stack_allocation_run(void* ctx) {
+    int iterations = *(const int*)ctx;
     for (int i = 0; i < iterations; i++) {
         int stack_var = i;
-        (void)stack_var;  // Prevent optimization
+        BENCH_DO_NOT_OPTIMIZE(stack_var);  // Prevent optimization
     }
-    end = clock();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Stack allocation time: %f seconds\n", cpu_time_used);
+}
 
-    // Heap allocation
-    start = clock();
+void heap_allocation_run(void* ctx) {
+    int iterations = *(const int*)ctx;
     for (int i = 0; i < iterations; i++) {
         int* heap_var = (int*)malloc(sizeof(int));
         if (heap_var == NULL) {
             fprintf(stderr, "Memory allocation failed\n");
-            return;
+            exit(EXIT_FAILURE);
         }
         *heap_var = i;
+        BENCH_DO_NOT_OPTIMIZE(heap_var);
         free(heap_var);
     }
-    end = clock();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Heap allocation time: %f seconds\n", cpu_time_used);
+}
+
+void compare_stack_heap_performance() {
+    int iterations = 1000000;
+    BenchSuite suite;
+
+    bench_suite_init(&suite, "Stack vs heap allocation");
+    bench_suite_run(&suite, "stack", stack_allocation_run, &iterations, iterations);
+    bench_suite_run(&suite, "heap (malloc/free)", heap_allocation_run, &iterations, iterations);
+    bench_suite_report(&suite);
 }
@@ -0,0 +1,364 @@
+/*
+safe_alloc.h - Checked Allocation Wrappers with Optional Allocation Tracking
+================================================
+
+One shared home for the safe_malloc / safe_calloc / safe_realloc wrappers and the
+create_int_array / free_int_array helpers that used to be copied into
+DynamicMemoryAllocation.c and MemoryLeaks.c.
+
+Default build:
+    The wrappers are static inline functions that call the C library and exit with an
+    error message on failure. There is no other cost.
+
+Tracking build (-DALLOC_TRACKING, link with -pthread):
+    The wrappers become macros that record __FILE__ and __LINE__ and route through a
+    small instrumented allocator that maintains:
+    - allocation and free counts, total bytes, live bytes and live objects per call site
+    - live bytes and the high-water mark for the whole program
+    - a power-of-two size-class histogram
+    - a list of live blocks, so a leak report with call sites is printed at exit
+    Each block carries a small header in front of the user pointer, so memory from
+    safe_malloc() must be released with safe_free(), never free(). Mismatched or double
+    frees are detected through a magic number in the header and abort the program.
+
+    Environment variables:
+        ALLOC_TRACK_REPORT=1   Print the full report (not only leaks) at exit.
+
+Reports can also be requested at any time with alloc_track_report(stdout). In the
+default build alloc_track_report() and alloc_track_report_leaks() compile to nothing.
+
+State is kept in static variables, so every translation unit that includes this
+header tracks its own allocations; this matches the single-file examples in the repo.
+*/
+
+#ifndef SAFE_ALLOC_H
+#define SAFE_ALLOC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef ALLOC_TRACKING
+
+static inline void* safe_malloc(size_t size) {
+    void* ptr = malloc(size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+static inline void* safe_calloc(size_t nmemb, size_t size) {
+    void* ptr = calloc(nmemb, size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+static inline void* safe_realloc(void* ptr, size_t size) {
+    void* new_ptr = realloc(ptr, size);
+    if (new_ptr == NULL && size != 0) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return new_ptr;
+}
+
+static inline void safe_free(void* ptr) {
+    free(ptr);
+}
+
+static inline void* create_int_array(size_t size) {
+    return safe_calloc(size, sizeof(int));
+}
+
+static inline void free_int_array(void* ptr) {
+    safe_free(ptr);
+}
+
+#define alloc_track_report(out) ((void)(out))
+#define alloc_track_report_leaks(out) ((void)(out))
+
+#else // ALLOC_TRACKING
+
+#include <pthread.h>
+
+#define ALLOC_TRACK_MAX_SITES 1024
+#define ALLOC_TRACK_BUCKETS 49        // Bucket k holds sizes in [2^(k-1), 2^k); 0 holds 0
+#define ALLOC_TRACK_MAGIC_LIVE 0xA110C8EDu
+#define ALLOC_TRACK_MAGIC_FREED 0xDEADF4EEu
+#define ALLOC_TRACK_REPORT_SITES 20
+#define ALLOC_TRACK_REPORT_BLOCKS 20
+
+typedef struct AllocHeader {
+    struct AllocHeader* prev;
+    struct AllocHeader* next;
+    size_t size;
+    uint32_t site;
+    uint32_t magic;
+} AllocHeader;
+
+// Header size rounded up so the user pointer keeps malloc's alignment guarantee.
+#define ALLOC_TRACK_HEADER_SIZE \
+    ((sizeof(AllocHeader) + _Alignof(max_align_t) - 1) & ~(size_t)(_Alignof(max_align_t) - 1))
+
+typedef struct {
+    const char* file;
+    int line;
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t bytes_total;
+    uint64_t live_count;
+    uint64_t live_bytes;
+} AllocSite;
+
+typedef struct {
+    pthread_mutex_t lock;
+    AllocSite sites[ALLOC_TRACK_MAX_SITES];
+    int site_count;
+    AllocHeader* live;
+    uint64_t live_bytes;
+    uint64_t live_count;
+    uint64_t peak_live_bytes;
+    uint64_t total_allocs;
+    uint64_t total_frees;
+    uint64_t total_bytes;
+    uint64_t failed;
+    uint64_t histogram[ALLOC_TRACK_BUCKETS];
+    int exit_hook_installed;
+} AllocTrackState;
+
+static AllocTrackState alloc_track_state_ = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static inline int alloc_track_bucket_(size_t size) {
+    return size == 0 ? 0 : 64 - __builtin_clzll((unsigned long long)size);
+}
+
+static inline void alloc_track_report(FILE* out);
+static inline void alloc_track_report_leaks(FILE* out);
+
+static inline void alloc_track_at_exit_(void) {
+    const char* full = getenv("ALLOC_TRACK_REPORT");
+    if (full && *full && *full != '0') alloc_track_report(stderr);
+    else alloc_track_report_leaks(stderr);
+}
+
+// Find or insert the site for file:line. Called with the lock held.
+static inline uint32_t alloc_track_site_locked_(const char* file, int line) {
+    AllocTrackState* st = &alloc_track_state_;
+    uint32_t h = (uint32_t)(((uintptr_t)file >> 3) ^ ((uint32_t)line * 2654435761u));
+    for (uint32_t probe = 0; probe < ALLOC_TRACK_MAX_SITES; probe++) {
+        uint32_t i = (h + probe) & (ALLOC_TRACK_MAX_SITES - 1);
+        AllocSite* site = &st->sites[i];
+        if (site->file == NULL) {
+            site->file = file;
+            site->line = line;
+            st->site_count++;
+            return i;
+        }
+        if (site->line == line && (site->file == file || strcmp(site->file, file) == 0)) {
+            return i;
+        }
+    }
+    return h & (ALLOC_TRACK_MAX_SITES - 1);  // Table full: share a slot rather than fail
+}
+
+static inline void alloc_track_register_locked_(AllocHeader* h, size_t size, const char* file, int line) {
+    AllocTrackState* st = &alloc_track_state_;
+    if (!st->exit_hook_installed) {
+        st->exit_hook_installed = 1;
+        atexit(alloc_track_at_exit_);
+    }
+    h->size = size;
+    h->site = alloc_track_site_locked_(file, line);
+    h->magic = ALLOC_TRACK_MAGIC_LIVE;
+    h->prev = NULL;
+    h->next = st->live;
+    if (st->live) st->live->prev = h;
+    st->live = h;
+
+    AllocSite* site = &st->sites[h->site];
+    site->allocs++;
+    site->bytes_total += size;
+    site->live_count++;
+    site->live_bytes += size;
+
+    st->total_allocs++;
+    st->total_bytes += size;
+    st->live_count++;
+    st->live_bytes += size;
+    if (st->live_bytes > st->peak_live_bytes) st->peak_live_bytes = st->live_bytes;
+    st->histogram[alloc_track_bucket_(size)]++;
+}
+
+static inline void alloc_track_unregister_locked_(AllocHeader* h) {
+    AllocTrackState* st = &alloc_track_state_;
+    if (h->prev) h->prev->next = h->next;
+    else st->live = h->next;
+    if (h->next) h->next->prev = h->prev;
+
+    AllocSite* site = &st->sites[h->site];
+    site->frees++;
+    site->live_count--;
+    site->live_bytes -= h->size;
+    st->total_frees++;
+    st->live_count--;
+    st->live_bytes -= h->size;
+}
+
+static inline AllocHeader* alloc_track_header_(void* ptr, const char* file, int line) {
+    AllocHeader* h = (AllocHeader*)((char*)ptr - ALLOC_TRACK_HEADER_SIZE);
+    if (h->magic != ALLOC_TRACK_MAGIC_LIVE) {
+        fprintf(stderr, "alloc_track: %s of %p at %s:%d\n",
+                h->magic == ALLOC_TRACK_MAGIC_FREED ? "double free" : "free of a pointer not from safe_malloc",
+                ptr, file, line);
+        abort();
+    }
+    return h;
+}
+
+static inline void* alloc_track_malloc(size_t size, const char* file, int line) {
+    AllocHeader* h = NULL;
+    if (size <= SIZE_MAX - ALLOC_TRACK_HEADER_SIZE) h = (AllocHeader*)malloc(ALLOC_TRACK_HEADER_SIZE + size);
+    if (h == NULL) {
+        fprintf(stderr, "Memory allocation failed (%zu bytes at %s:%d)\n", size, file, line);
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_lock(&alloc_track_state_.lock);
+    alloc_track_register_locked_(h, size, file, line);
+    pthread_mutex_unlock(&alloc_track_state_.lock);
+    return (char*)h + ALLOC_TRACK_HEADER_SIZE;
+}
+
+static inline void* alloc_track_calloc(size_t nmemb, size_t size, const char* file, int line) {
+    if (size && nmemb > SIZE_MAX / size) {
+        fprintf(stderr, "Memory allocation failed (overflow at %s:%d)\n", file, line);
+        exit(EXIT_FAILURE);
+    }
+    void* ptr = alloc_track_malloc(nmemb * size, file, line);
+    memset(ptr, 0, nmemb * size);
+    return ptr;
+}
+
+static inline void alloc_track_free(void* ptr, const char* file, int line) {
+    if (ptr == NULL) return;
+    pthread_mutex_lock(&alloc_track_state_.lock);
+    AllocHeader* h = alloc_track_header_(ptr, file, line);
+    alloc_track_unregister_locked_(h);
+    h->magic = ALLOC_TRACK_MAGIC_FREED;
+    pthread_mutex_unlock(&alloc_track_state_.lock);
+    free(h);
+}
+
+// Like realloc(): the block is re-attributed to the call site of the resize.
+static inline void* alloc_track_realloc(void* ptr, size_t size, const char* file, int line) {
+    if (ptr == NULL) return alloc_track_malloc(size, file, line);
+    if (size == 0) {
+        alloc_track_free(ptr, file, line);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&alloc_track_state_.lock);
+    AllocHeader* h = alloc_track_header_(ptr, file, line);
+    alloc_track_unregister_locked_(h);
+    AllocHeader* moved = NULL;
+    if (size <= SIZE_MAX - ALLOC_TRACK_HEADER_SIZE) {
+        moved = (AllocHeader*)realloc(h, ALLOC_TRACK_HEADER_SIZE + size);
+    }
+    if (moved == NULL) {
+        // realloc() left the old block intact; restore its bookkeeping before exiting
+        alloc_track_state_.failed++;
+        alloc_track_register_locked_(h, h->size, alloc_track_state_.sites[h->site].file,
+                                     alloc_track_state_.sites[h->site].line);
+        pthread_mutex_unlock(&alloc_track_state_.lock);
+        fprintf(stderr, "Memory reallocation failed (%zu bytes at %s:%d)\n", size, file, line);
+        exit(EXIT_FAILURE);
+    }
+    alloc_track_register_locked_(moved, size, file, line);
+    pthread_mutex_unlock(&alloc_track_state_.lock);
+    return (char*)moved + ALLOC_TRACK_HEADER_SIZE;
+}
+
+static inline void alloc_track_report_leaks(FILE* out) {
+    AllocTrackState* st = &alloc_track_state_;
+    pthread_mutex_lock(&st->lock);
+    if (st->live_count == 0) {
+        pthread_mutex_unlock(&st->lock);
+        return;
+    }
+    fprintf(out, "alloc_track: %llu block(s), %llu byte(s) still allocated\n",
+            (unsigned long long)st->live_count, (unsigned long long)st->live_bytes);
+    for (int i = 0; i < ALLOC_TRACK_MAX_SITES; i++) {
+        const AllocSite* site = &st->sites[i];
+        if (site->file && site->live_count) {
+            fprintf(out, "  %s:%d: %llu block(s), %llu byte(s)\n", site->file, site->line,
+                    (unsigned long long)site->live_count, (unsigned long long)site->live_bytes);
+        }
+    }
+    int shown = 0;
+    for (const AllocHeader* h = st->live; h && shown < ALLOC_TRACK_REPORT_BLOCKS; h = h->next, shown++) {
+        const AllocSite* site = &st->sites[h->site];
+        fprintf(out, "  leaked %p: %zu byte(s) from %s:%d\n",
+                (const void*)((const char*)h + ALLOC_TRACK_HEADER_SIZE), h->size, site->file, site->line);
+    }
+    pthread_mutex_unlock(&st->lock);
+}
+
+static inline void alloc_track_report(FILE* out) {
+    AllocTrackState* st = &alloc_track_state_;
+    pthread_mutex_lock(&st->lock);
+
+    fprintf(out, "alloc_track: %llu allocs, %llu frees, %llu bytes requested\n",
+            (unsigned long long)st->total_allocs, (unsigned long long)st->total_frees,
+            (unsigned long long)st->total_bytes);
+    fprintf(out, "alloc_track: live %llu bytes in %llu blocks, high-water mark %llu bytes\n",
+            (unsigned long long)st->live_bytes, (unsigned long long)st->live_count,
+            (unsigned long long)st->peak_live_bytes);
+
+    fprintf(out, "Size histogram:\n");
+    for (int b = 0; b < ALLOC_TRACK_BUCKETS; b++) {
+        if (st->histogram[b] == 0) continue;
+        unsigned long long lo = b == 0 ? 0 : 1ULL << (b - 1);
+        unsigned long long hi = b == 0 ? 0 : (1ULL << (b - 1)) * 2 - 1;
+        fprintf(out, "  %10llu - %-10llu %llu\n", lo, hi, (unsigned long long)st->histogram[b]);
+    }
+
+    // Simple selection of the heaviest sites by total bytes; reports are not hot paths.
+    fprintf(out, "Top call sites by bytes:\n");
+    char printed[ALLOC_TRACK_MAX_SITES] = {0};
+    for (int n = 0; n < ALLOC_TRACK_REPORT_SITES; n++) {
+        int best = -1;
+        for (int i = 0; i < ALLOC_TRACK_MAX_SITES; i++) {
+            if (st->sites[i].file && !printed[i] &&
+                (best < 0 || st->sites[i].bytes_total > st->sites[best].bytes_total)) {
+                best = i;
+            }
+        }
+        if (best < 0) break;
+        printed[best] = 1;
+        const AllocSite* site = &st->sites[best];
+        fprintf(out, "  %s:%d: %llu allocs, %llu frees, %llu bytes, %llu live\n",
+                site->file, site->line, (unsigned long long)site->allocs,
+                (unsigned long long)site->frees, (unsigned long long)site->bytes_total,
+                (unsigned long long)site->live_bytes);
+    }
+    pthread_mutex_unlock(&st->lock);
+
+    alloc_track_report_leaks(out);
+}
+
+#define safe_malloc(size) alloc_track_malloc((size), __FILE__, __LINE__)
+#define safe_calloc(nmemb, size) alloc_track_calloc((nmemb), (size), __FILE__, __LINE__)
+#define safe_realloc(ptr, size) alloc_track_realloc((ptr), (size), __FILE__, __LINE__)
+#define safe_free(ptr) alloc_track_free((ptr), __FILE__, __LINE__)
+#define create_int_array(size) safe_calloc((size), sizeof(int))
+#define free_int_array(ptr) safe_free(ptr)
+
+#endif // ALLOC_TRACKING
+
+#endif // SAFE_ALLOC_H
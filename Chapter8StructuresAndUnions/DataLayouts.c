@@ -0,0 +1,423 @@
+/*
+Cheat Sheet: AoS, SoA and Hot/Cold Record Layouts in C
+================================================
+
+Table of Contents:
+1. Overview and Historical Context
+2. Syntax, Key Concepts, and Code Examples
+3. Best Practices, Common Pitfalls, and Advanced Tips
+4. Integration and Real-World Applications
+5. Advanced Concepts and Emerging Trends
+6. FAQs and Troubleshooting
+7. Recommended Tools, Libraries, and Resources
+8. Performance Analysis and Optimization
+9. How to Contribute
+
+1. Overview and Historical Context
+==================================
+NestedStructures.c (structure_alignment) prints how the compiler pads struct
+AlignmentExample. This cheat sheet acts on layout: the same record stored the
+three ways that matter for loops over many records.
+
+- Array of structures (AoS): Trade trades[n]. Natural to write, and best when
+  code uses most fields of one record at a time.
+- Structure of arrays (SoA): double price[n]; int32_t quantity[n]; ... Best
+  when loops touch a few fields of every record: only those bytes are loaded,
+  and the loop vectorises.
+- Hot/cold split: the frequently used fields in one array of small structs,
+  the rest in another. A middle ground that keeps the hot fields of a record
+  together.
+
+Key points:
+- Memory moves in 64-byte cache lines. Reading 12 bytes from each 64-byte
+  record in AoS still transfers all 64.
+- Field order decides padding: char, int, short takes 12 bytes; int, short,
+  char takes 8.
+- The layout should follow the access pattern of the hottest loop, not the
+  shape of the data.
+
+Historical context:
+- Fortran and vector machines (Cray, 1970s) favoured parallel arrays by default.
+- Column-oriented databases (C-Store 2005, MonetDB, Vertica) apply SoA to
+  tables and dominate analytics workloads today.
+- Game engines moved to data-oriented design and entity-component systems in the
+  2000s for the same reason (Acton, "Data-Oriented Design and C++", 2014).
+
+The implementation lives in layout.h next to this file.
+
+2. Syntax, Key Concepts, and Code Examples
+==========================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "layout.h"
+#include "../Chapter18DebuggingAndProfiling/bench.h"
+
+// A 20-field, 64-byte trade record. The analytics loops read price and quantity.
+#define TRADE_FIELDS(HOT, COLD)     \
+    HOT(double, price)              \
+    COLD(uint64_t, id)              \
+    HOT(int32_t, quantity)          \
+    COLD(uint32_t, account)         \
+    COLD(uint32_t, venue)           \
+    COLD(uint32_t, trader)          \
+    COLD(uint32_t, flags)           \
+    COLD(float, fee)                \
+    COLD(float, tax)                \
+    COLD(uint32_t, sequence)        \
+    COLD(uint16_t, currency)        \
+    COLD(uint16_t, exchange)        \
+    COLD(uint16_t, book)            \
+    COLD(uint16_t, strategy)        \
+    COLD(uint16_t, desk)            \
+    COLD(uint16_t, region)          \
+    COLD(uint8_t, side)             \
+    COLD(uint8_t, status)           \
+    COLD(uint8_t, kind)             \
+    COLD(uint8_t, venue_class)
+
+DEFINE_RECORD_LAYOUT(Trade, trade, TRADE_FIELDS)
+LAYOUT_ASSERT_NO_PADDING(Trade, TRADE_FIELDS)
+
+// struct AlignmentExample from NestedStructures.c, reordered by decreasing alignment.
+// Listing c first again makes LAYOUT_ASSERT_NO_PADDING fail the build.
+#define ALIGNMENT_FIELDS(HOT, COLD) \
+    HOT(int, i)                     \
+    HOT(short, s)                   \
+    COLD(char, c)                   \
+    COLD(char, spare)  // The byte that would otherwise be tail padding
+
+DEFINE_RECORD_LAYOUT(AlignmentReordered, alignment_reordered, ALIGNMENT_FIELDS)
+LAYOUT_ASSERT_NO_PADDING(AlignmentReordered, ALIGNMENT_FIELDS)
+
+// Function prototypes
+void declaring_layouts();
+void converting_layouts();
+void hot_cold_split();
+void padding_and_reordering();
+void performance_comparison();
+
+int main() {
+    printf("AoS, SoA and Hot/Cold Record Layouts Cheat Sheet\n");
+    printf("================================================\n\n");
+
+    declaring_layouts();
+    converting_layouts();
+    hot_cold_split();
+    padding_and_reordering();
+    performance_comparison();
+
+    return 0;
+}
+
+static Trade make_trade(uint64_t i) {
+    Trade t;
+    memset(&t, 0, sizeof(t));
+    t.price = 100.0 + (double)(i % 1000) / 8.0;
+    t.id = i;
+    t.quantity = (int32_t)(1 + i % 500);
+    t.account = (uint32_t)(i % 10007);
+    t.venue = (uint32_t)(i % 13);
+    t.fee = 0.25f;
+    t.side = (uint8_t)(i & 1);
+    return t;
+}
+
+void declaring_layouts() {
+    printf("2.1 Declaring a Record Once\n");
+    printf("---------------------------\n");
+    printf("sizeof(Trade)      = %zu bytes (20 fields, no padding)\n", sizeof(Trade));
+    printf("sizeof(TradeHot)   = %zu bytes (price, quantity, tail padding)\n", sizeof(TradeHot));
+    printf("sizeof(TradeCold)  = %zu bytes (the other 18 fields)\n", sizeof(TradeCold));
+    printf("TradeSoA holds %zu column pointers\n\n", (sizeof(TradeSoA) - 2 * sizeof(size_t)) / sizeof(void*));
+}
+
+void converting_layouts() {
+    printf("2.2 Converting AoS <-> SoA and Column Views\n");
+    printf("-------------------------------------------\n");
+
+    enum { N = 8 };
+    Trade trades[N];
+    for (int i = 0; i < N; i++) trades[i] = make_trade((uint64_t)i);
+
+    TradeSoA soa;
+    if (trade_soa_init(&soa, N) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    trade_soa_from_aos(&soa, trades, N);
+
+    // One loop body, two layouts: only the stride differs
+    LayoutColumn views[2] = {LAYOUT_AOS_COLUMN(trades, N, price), LAYOUT_SOA_COLUMN(&soa, price)};
+    const char* names[2] = {"AoS", "SoA"};
+    for (int v = 0; v < 2; v++) {
+        double total = 0;
+        LAYOUT_FOREACH(views[v], double, price) {
+            total += *price;
+        }
+        printf("%s price column: stride %2zu bytes, sum %.3f\n", names[v], views[v].stride, total);
+    }
+
+    Trade third = trade_soa_get(&soa, 3);
+    printf("Record 3 gathered from the columns: id %llu, price %.3f, quantity %d\n\n",
+           (unsigned long long)third.id, third.price, third.quantity);
+    trade_soa_destroy(&soa);
+}
+
+void hot_cold_split() {
+    printf("2.3 Hot/Cold Splitting\n");
+    printf("----------------------\n");
+
+    enum { N = 4 };
+    Trade trades[N];
+    for (int i = 0; i < N; i++) trades[i] = make_trade((uint64_t)i + 100);
+
+    TradeSplit split;
+    if (trade_split_init(&split, N) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    trade_split_from_aos(&split, trades, N);
+    double notional = 0;
+    for (size_t i = 0; i < split.count; i++) notional += split.hot[i].price * split.hot[i].quantity;
+    Trade joined = trade_split_get(&split, 2);
+    printf("Notional from the hot array only: %.2f\n", notional);
+    printf("Record 2 joined from both arrays: id %llu, account %u\n", (unsigned long long)joined.id,
+           joined.account);
+    printf("A scan of the hot array touches %zu of every %zu bytes\n\n", sizeof(TradeHot), sizeof(Trade));
+    trade_split_destroy(&split);
+}
+
+void padding_and_reordering() {
+    printf("2.4 Padding-Free Field Order\n");
+    printf("----------------------------\n");
+
+    struct AlignmentExample {
+        char c;
+        int i;
+        short s;
+    };
+    printf("char, int, short: %zu bytes (i at offset %zu, s at offset %zu)\n", sizeof(struct AlignmentExample),
+           offsetof(struct AlignmentExample, i), offsetof(struct AlignmentExample, s));
+    printf("int, short, char: %zu bytes (s at offset %zu, c at offset %zu), checked at compile time\n\n",
+           sizeof(AlignmentReordered), offsetof(AlignmentReordered, s), offsetof(AlignmentReordered, c));
+}
+
+/*
+3. Best Practices, Common Pitfalls, and Advanced Tips
+=====================================================
+Best Practices:
+1. Pick the layout from the hottest loop. Use SoA if it reads a few fields of
+   every record, AoS if it reads whole records one at a time.
+2. Declare records with fields ordered by decreasing alignment, and let
+   LAYOUT_ASSERT_NO_PADDING keep them that way as fields are added.
+3. Convert once at a phase boundary (after loading, before analytics), not
+   inside the loop.
+4. In a fixed-layout loop, index the SoA arrays directly (soa.price[i]) so the
+   compiler can vectorise.
+
+Common Pitfalls:
+1. Keeping pointers to records: an SoA "record" is an index, not an address.
+2. Adding a field to the X-macro without thinking about hot/cold: every hot
+   field makes the hot array wider.
+3. Mixing layouts in one loop (AoS input, SoA output) without measuring. The
+   strided side usually dominates.
+4. Assuming SoA is always faster. A loop that needs all 20 fields of a record
+   reads 20 streams instead of one.
+
+Advanced Tips:
+1. AoSoA (blocks of, say, 8 records stored as SoA) gives SIMD-friendly columns
+   while keeping a record's fields within a few cache lines.
+2. Column views are handy for generic code (CSV export, debug printing) that
+   must work on any layout.
+3. Cold fields that are rarely read can be compressed or moved to a slower tier
+   without touching the hot path.
+
+4. Integration and Real-World Applications
+==========================================
+- Analytics and columnar databases: scan, filter and aggregate a few columns of
+  billions of rows.
+- Particle systems and physics engines: positions and velocities as SoA for
+  SIMD integration.
+- Entity-component systems in games: components stored per type.
+- Network flow tables: 5-tuple and counters hot, metadata cold.
+
+5. Advanced Concepts and Emerging Trends
+========================================
+- Apache Arrow defines a standard in-memory columnar format shared across
+  languages without copying.
+- Compilers and languages with layout annotations (ISPC's soa<8>, Jai, Zig's
+  MultiArrayList) generate SoA from an AoS declaration.
+- Hardware prefetchers follow several sequential streams well. SoA loops over
+  more than about 16 columns can run out of prefetch streams.
+
+6. FAQs and Troubleshooting
+===========================
+Q: The build fails with "padding before field ...". What now?
+A: Move the named field (or the one before it) so that the fields are listed
+   by decreasing alignment: 8-byte types, then 4, 2 and 1.
+
+Q: Why is my SoA loop not faster than AoS?
+A: It may be compute bound rather than memory bound, or it may read many
+   columns. Check the generated code for vector instructions, and measure with
+   10M+ records: small data sets fit in cache in any layout.
+
+7. Recommended Tools, Libraries, and Resources
+==============================================
+- pahole (dwarves): prints struct holes and cache-line boundaries from debug info
+- "Data-Oriented Design" (Richard Fabian)
+- "What Every Programmer Should Know About Memory" (Ulrich Drepper)
+- Apache Arrow columnar format specification
+
+8. Performance Analysis and Optimization
+========================================
+Both benchmarks run over 10M trades (640 MB in AoS). The first sums one field
+(price). The second computes the notional (price * quantity), the analytics
+loop that reads two fields out of twenty. Each case in the table below reads
+the same values:
+- AoS loop over Trade[], and AoS through a column view (stride 64).
+- Hot array of the hot/cold split (stride 16).
+- SoA arrays indexed directly, and SoA through a column view (stride 8).
+GB/s counts only the bytes of the fields the loop reads.
+
+Typical results (gcc -O2, x86-64, one core):
+- Sum of price: AoS 50 ms, hot/cold split 15 ms, SoA 8 ms. SoA is 6x faster
+  because it moves 80 MB instead of 640 MB.
+- Sum of price * quantity: AoS 51 ms, split 21 ms, SoA 11-12 ms (4-5x).
+- The column views run at the speed of the loops they replace. The stride,
+  not the indirection, decides the cost.
+- trade_soa_from_aos reads the AoS array once per column, so convert once and
+  scan many times.
+*/
+
+#define LAYOUT_RECORDS 10000000
+
+typedef enum { SCAN_AOS, SCAN_AOS_VIEW, SCAN_SPLIT, SCAN_SOA, SCAN_SOA_VIEW } ScanLayout;
+
+typedef struct {
+    ScanLayout layout;
+    int two_fields;
+    const Trade* aos;
+    const TradeSplit* split;
+    const TradeSoA* soa;
+} LayoutBench;
+
+void layout_scan_run(void* ctx) {
+    LayoutBench* b = (LayoutBench*)ctx;
+    const size_t n = LAYOUT_RECORDS;
+    double total = 0;
+    switch (b->layout) {
+        case SCAN_AOS:
+            if (b->two_fields) {
+                for (size_t i = 0; i < n; i++) total += b->aos[i].price * b->aos[i].quantity;
+            } else {
+                for (size_t i = 0; i < n; i++) total += b->aos[i].price;
+            }
+            break;
+        case SCAN_AOS_VIEW: {
+            LayoutColumn price = LAYOUT_AOS_COLUMN(b->aos, n, price);
+            LayoutColumn quantity = LAYOUT_AOS_COLUMN(b->aos, n, quantity);
+            for (size_t i = 0; i < n; i++) {
+                total += LAYOUT_AT(price, double, i) * (b->two_fields ? LAYOUT_AT(quantity, int32_t, i) : 1);
+            }
+            break;
+        }
+        case SCAN_SPLIT:
+            if (b->two_fields) {
+                for (size_t i = 0; i < n; i++) total += b->split->hot[i].price * b->split->hot[i].quantity;
+            } else {
+                for (size_t i = 0; i < n; i++) total += b->split->hot[i].price;
+            }
+            break;
+        case SCAN_SOA: {
+            const double* price = b->soa->price;
+            const int32_t* quantity = b->soa->quantity;
+            if (b->two_fields) {
+                for (size_t i = 0; i < n; i++) total += price[i] * quantity[i];
+            } else {
+                for (size_t i = 0; i < n; i++) total += price[i];
+            }
+            break;
+        }
+        case SCAN_SOA_VIEW: {
+            LayoutColumn price = LAYOUT_SOA_COLUMN(b->soa, price);
+            LayoutColumn quantity = LAYOUT_SOA_COLUMN(b->soa, quantity);
+            for (size_t i = 0; i < n; i++) {
+                total += LAYOUT_AT(price, double, i) * (b->two_fields ? LAYOUT_AT(quantity, int32_t, i) : 1);
+            }
+            break;
+        }
+    }
+    BENCH_DO_NOT_OPTIMIZE(total);
+}
+
+static void layout_suite(const char* title, int two_fields, const Trade* aos, const TradeSplit* split,
+                         const TradeSoA* soa) {
+    static const char* const names[] = {"AoS loop", "AoS column view", "hot/cold split", "SoA loop",
+                                        "SoA column view"};
+    LayoutBench cases[5];
+    BenchSuite suite;
+    bench_suite_init(&suite, title);
+    for (int l = SCAN_AOS; l <= SCAN_SOA_VIEW; l++) {
+        LayoutBench c = {(ScanLayout)l, two_fields, aos, split, soa};
+        cases[l] = c;
+        bench_suite_run(&suite, names[l], layout_scan_run, &cases[l], LAYOUT_RECORDS);
+    }
+    bench_suite_report(&suite);
+    double bytes = (double)LAYOUT_RECORDS * (double)(sizeof(double) + (two_fields ? sizeof(int32_t) : 0));
+    for (int i = 0; i < suite.count; i++) {
+        printf("  %-16s %7.2f GB/s of field data\n", suite.results[i].name,
+               bench_throughput(&suite.results[i], bytes) / 1e9);
+    }
+    printf("\n");
+}
+
+void performance_comparison() {
+    printf("8. Performance Comparison\n");
+    printf("--------------------------\n");
+
+    Trade* aos = (Trade*)layout_alloc_(layout_round_up_((size_t)LAYOUT_RECORDS * sizeof(Trade)));
+    TradeSplit split;
+    TradeSoA soa;
+    int split_ok = trade_split_init(&split, LAYOUT_RECORDS) == 0;
+    int soa_ok = trade_soa_init(&soa, LAYOUT_RECORDS) == 0;
+    if (aos == NULL || !split_ok || !soa_ok) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(aos);
+        if (split_ok) trade_split_destroy(&split);
+        if (soa_ok) trade_soa_destroy(&soa);
+        return;
+    }
+    for (size_t i = 0; i < LAYOUT_RECORDS; i++) aos[i] = make_trade(i);
+    trade_split_from_aos(&split, aos, LAYOUT_RECORDS);
+    trade_soa_from_aos(&soa, aos, LAYOUT_RECORDS);
+
+    layout_suite("Sum price over 10M trades", 0, aos, &split, &soa);
+    layout_suite("Sum price * quantity over 10M trades", 1, aos, &split, &soa);
+
+    free(aos);
+    trade_split_destroy(&split);
+    trade_soa_destroy(&soa);
+}
+
+/*
+9. How to Contribute
+====================
+To contribute to this cheat sheet:
+1. Fork the repository containing this file.
+2. Make your changes or additions, ensuring they follow the established style and format.
+3. Add your name to the contributors list below.
+4. Submit a pull request with a clear description of your changes.
+
+Contributors:
+- [Your Name Here]
+
+To run the examples in this cheat sheet, compile the file with a C compiler (e.g., GCC):
+    gcc -o data_layouts DataLayouts.c -O2
+
+Then execute the resulting binary:
+    ./data_layouts
+*/
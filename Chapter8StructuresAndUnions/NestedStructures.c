@@ -50,6 +50,7 @@ Comparison to other languages:
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include "layout.h"
 
 // Basic structure definition
 struct Point {
@@ -176,6 +177,17 @@ struct AlignmentExample {
     short s;
 };
 
+// The same fields ordered by decreasing alignment, declared through layout.h.
+// LAYOUT_ASSERT_NO_PADDING fails the build if c is moved back to the front.
+#define ALIGNMENT_FIELDS(HOT, COLD) \
+    HOT(int, i)                     \
+    HOT(short, s)                   \
+    COLD(char, c)                   \
+    COLD(char, spare)  // The byte that would otherwise be tail padding
+
+DEFINE_RECORD_LAYOUT(AlignmentReordered, alignment_reordered, ALIGNMENT_FIELDS)
+LAYOUT_ASSERT_NO_PADDING(AlignmentReordered, ALIGNMENT_FIELDS)
+
 void structure_alignment() {
     printf("2.5 Structure Alignment Example\n");
     printf("-------------------------------\n");
@@ -185,7 +197,10 @@ void structure_alignment() {
     printf("Size of int: %zu\n", sizeof(int));
     printf("Size of short: %zu\n", sizeof(short));
     printf("Size of AlignmentExample: %zu\n", sizeof(struct AlignmentExample));
-    printf("This demonstrates structure padding for alignment.\n\n");
+    printf("This demonstrates structure padding for alignment.\n");
+    printf("Reordered as int, short, char: %zu bytes (c at offset %zu)\n",
+           sizeof(AlignmentReordered), offsetof(AlignmentReordered, c));
+    printf("See DataLayouts.c for SoA and hot/cold layouts.\n\n");
 }
 
 // Example of flexible array member (C99 feature)
@@ -217,7 +232,8 @@ void flexible_array_member() {
     printf("\n");
 
     free(fa);
-    printf("Memory freed\n\n");
+    printf("Memory freed\n");
+    printf("For millions of such records, see FamRecordPool.c in Chapter15AdvancedMemoryManagement.\n\n");
 }
 
 /*
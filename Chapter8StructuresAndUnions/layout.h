@@ -0,0 +1,234 @@
+/*
+layout.h - One Record Declaration, Several Memory Layouts
+================================================
+
+A record is declared once, as an X-macro listing its fields. Each field is
+marked HOT (touched by the inner loops) or COLD (everything else):
+
+    #define TRADE_FIELDS(HOT, COLD)      \
+        HOT(double, price)               \
+        HOT(int32_t, quantity)           \
+        COLD(uint64_t, id)               \
+        COLD(uint32_t, account)
+
+    DEFINE_RECORD_LAYOUT(Trade, trade, TRADE_FIELDS)
+    LAYOUT_ASSERT_NO_PADDING(Trade, TRADE_FIELDS)   // Compile error if a field is padded
+
+DEFINE_RECORD_LAYOUT generates these types from that list:
+
+    Trade          the record as an ordinary struct (array of structures, AoS)
+    TradeSoA       one array per field (structure of arrays), with
+                   trade_soa_init/destroy/get/set/from_aos/to_aos
+    TradeHot/Cold  the HOT and the COLD fields as two structs, and
+    TradeSplit     one array of each, with trade_split_init/destroy/from_aos/get
+
+Column views let one loop run over a field in any of those layouts:
+
+    LayoutColumn price = LAYOUT_SOA_COLUMN(&soa, price);      // or
+    LayoutColumn price = LAYOUT_AOS_COLUMN(trades, n, price); // or
+    LayoutColumn price = LAYOUT_SPLIT_COLUMN(&split, hot, price);
+    LAYOUT_FOREACH(price, double, p) total += *p;
+
+Design:
+- A loop that reads two fields of a 64-byte record in AoS still pulls every
+  64-byte line through the cache, so most of the bandwidth carries fields it
+  never looks at. In SoA the same loop streams two dense arrays, and the
+  compiler can vectorise it. The hot/cold split sits between the two: records
+  whose hot fields are used together stay together, and the cold fields move
+  out of the way.
+- Every SoA column starts on a 64-byte boundary, in one allocation.
+  Conversions copy column by column, so each pass reads one strided stream and
+  writes one sequential stream.
+- A column view is a base pointer, a stride and a count. LAYOUT_FOREACH steps
+  by the stride, so the same loop body works on any layout. Where the layout is
+  fixed, indexing the SoA array directly (soa.price[i]) lets the compiler
+  vectorise.
+- The preprocessor cannot sort the fields, so the declaration order is the
+  layout. LAYOUT_ASSERT_NO_PADDING compares the offsetof of every field with
+  its offset in a packed copy of the struct, and fails the build naming the
+  first field that has padding in front of it. It also requires the record to
+  be exactly as large as the packed copy, so tail padding fails too: when the
+  fields do not add up to a multiple of the alignment, declare the spare bytes
+  as a field of their own.
+- A record needs at least one HOT and one COLD field, since C has no empty
+  structs. Field types must be single declarators (typedef arrays first).
+- Functions that allocate return 0, or -1 with errno = ENOMEM, like generic.h.
+- Needs C11 for aligned_alloc, _Alignof and _Static_assert (gcc's default).
+*/
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define LAYOUT_ALIGN 64
+
+#if defined(__GNUC__)
+#define LAYOUT_PACKED_ __attribute__((packed))
+#else
+#define LAYOUT_PACKED_
+#endif
+
+typedef struct {
+    char* base;
+    size_t stride;
+    size_t count;
+} LayoutColumn;
+
+#define LAYOUT_AOS_COLUMN(array, n, field) \
+    ((LayoutColumn){(char*)&(array)[0].field, sizeof((array)[0]), (n)})
+#define LAYOUT_SOA_COLUMN(soa, field) ((LayoutColumn){(char*)(soa)->field, sizeof(*(soa)->field), (soa)->count})
+#define LAYOUT_SPLIT_COLUMN(split, part, field) \
+    ((LayoutColumn){(char*)&(split)->part[0].field, sizeof((split)->part[0]), (split)->count})
+
+#define LAYOUT_AT(column, T, i) (*(T*)((column).base + (size_t)(i) * (column).stride))
+#define LAYOUT_FOREACH(column, T, ptr)                                                       \
+    for (T *ptr = (T*)(column).base, *ptr##_end_ = (T*)((column).base + (column).count * (column).stride); \
+         ptr != ptr##_end_; ptr = (T*)((char*)ptr + (column).stride))
+
+static inline size_t layout_round_up_(size_t bytes) {
+    return (bytes + LAYOUT_ALIGN - 1) & ~(size_t)(LAYOUT_ALIGN - 1);
+}
+
+// 'bytes' is a multiple of LAYOUT_ALIGN, as aligned_alloc() requires
+static inline void* layout_alloc_(size_t bytes) {
+    void* p = aligned_alloc(LAYOUT_ALIGN, bytes ? bytes : LAYOUT_ALIGN);
+    if (p == NULL) errno = ENOMEM;
+    return p;
+}
+
+// Per-field expansions used by the generators below
+#define LAYOUT_MEMBER_(T, f) T f;
+#define LAYOUT_SKIP_(T, f)
+#define LAYOUT_COLUMN_(T, f) T* f;
+#define LAYOUT_COLUMN_BYTES_(T, f) +layout_round_up_(count * sizeof(T))
+#define LAYOUT_COLUMN_ASSIGN_(T, f) \
+    s->f = (T*)p;                   \
+    p += layout_round_up_(count * sizeof(T));
+#define LAYOUT_GATHER_(T, f) r.f = s->f[i];
+#define LAYOUT_SCATTER_(T, f) s->f[i] = r->f;
+#define LAYOUT_COLUMN_FROM_AOS_(T, f) \
+    for (size_t i = 0; i < n; i++) s->f[i] = a[i].f;
+#define LAYOUT_COLUMN_TO_AOS_(T, f) \
+    for (size_t i = 0; i < n; i++) a[i].f = s->f[i];
+#define LAYOUT_SPLIT_HOT_(T, f) s->hot[i].f = a[i].f;
+#define LAYOUT_SPLIT_COLD_(T, f) s->cold[i].f = a[i].f;
+#define LAYOUT_JOIN_HOT_(T, f) r.f = s->hot[i].f;
+#define LAYOUT_JOIN_COLD_(T, f) r.f = s->cold[i].f;
+#define LAYOUT_CHECK_OFFSET_(T, f)                                        \
+    _Static_assert(offsetof(layout_record_, f) == offsetof(layout_packed_, f), \
+                   "padding before field '" #f "': order fields by decreasing alignment");
+
+// Generates the record type Name, Name##SoA, Name##Hot, Name##Cold, Name##Split
+// and the prefix##_soa_* and prefix##_split_* functions.
+#define DEFINE_RECORD_LAYOUT(Name, prefix, FIELDS)                                          \
+    typedef struct { FIELDS(LAYOUT_MEMBER_, LAYOUT_MEMBER_) } Name;                         \
+    typedef struct { FIELDS(LAYOUT_MEMBER_, LAYOUT_SKIP_) } Name##Hot;                      \
+    typedef struct { FIELDS(LAYOUT_SKIP_, LAYOUT_MEMBER_) } Name##Cold;                     \
+                                                                                            \
+    /* One array per field; all columns share one 64-byte aligned block */                  \
+    typedef struct {                                                                        \
+        FIELDS(LAYOUT_COLUMN_, LAYOUT_COLUMN_)                                              \
+        size_t count;                                                                       \
+        void* block_;                                                                       \
+    } Name##SoA;                                                                            \
+                                                                                            \
+    typedef struct {                                                                        \
+        Name##Hot* hot;                                                                     \
+        Name##Cold* cold;                                                                   \
+        size_t count;                                                                       \
+    } Name##Split;                                                                          \
+                                                                                            \
+    static inline int prefix##_soa_init(Name##SoA* s, size_t count) {                       \
+        memset(s, 0, sizeof(*s));                                                           \
+        if (count > (SIZE_MAX / 2) / sizeof(Name)) {                                        \
+            errno = ENOMEM;                                                                 \
+            return -1;                                                                      \
+        }                                                                                   \
+        size_t total = 0 FIELDS(LAYOUT_COLUMN_BYTES_, LAYOUT_COLUMN_BYTES_);                \
+        char* p = (char*)layout_alloc_(total);                                              \
+        if (p == NULL) return -1;                                                           \
+        s->block_ = p;                                                                      \
+        s->count = count;                                                                   \
+        FIELDS(LAYOUT_COLUMN_ASSIGN_, LAYOUT_COLUMN_ASSIGN_)                                \
+        return 0;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##_soa_destroy(Name##SoA* s) {                                 \
+        free(s->block_);                                                                    \
+        memset(s, 0, sizeof(*s));                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline Name prefix##_soa_get(const Name##SoA* s, size_t i) {                     \
+        Name r;                                                                             \
+        FIELDS(LAYOUT_GATHER_, LAYOUT_GATHER_)                                              \
+        return r;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##_soa_set(Name##SoA* s, size_t i, const Name* r) {            \
+        FIELDS(LAYOUT_SCATTER_, LAYOUT_SCATTER_)                                            \
+    }                                                                                       \
+                                                                                            \
+    /* Column by column, so each pass writes one sequential stream */                       \
+    static inline void prefix##_soa_from_aos(Name##SoA* s, const Name* a, size_t n) {       \
+        FIELDS(LAYOUT_COLUMN_FROM_AOS_, LAYOUT_COLUMN_FROM_AOS_)                            \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##_soa_to_aos(const Name##SoA* s, Name* a, size_t n) {         \
+        FIELDS(LAYOUT_COLUMN_TO_AOS_, LAYOUT_COLUMN_TO_AOS_)                                \
+    }                                                                                       \
+                                                                                            \
+    static inline int prefix##_split_init(Name##Split* s, size_t count) {                   \
+        memset(s, 0, sizeof(*s));                                                           \
+        if (count > (SIZE_MAX / 2) / sizeof(Name)) {                                        \
+            errno = ENOMEM;                                                                 \
+            return -1;                                                                      \
+        }                                                                                   \
+        s->hot = (Name##Hot*)layout_alloc_(layout_round_up_(count * sizeof(Name##Hot)));    \
+        s->cold = (Name##Cold*)layout_alloc_(layout_round_up_(count * sizeof(Name##Cold))); \
+        if (s->hot == NULL || s->cold == NULL) {                                            \
+            free(s->hot);                                                                   \
+            free(s->cold);                                                                  \
+            memset(s, 0, sizeof(*s));                                                       \
+            errno = ENOMEM;                                                                 \
+            return -1;                                                                      \
+        }                                                                                   \
+        s->count = count;                                                                   \
+        return 0;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##_split_destroy(Name##Split* s) {                             \
+        free(s->hot);                                                                       \
+        free(s->cold);                                                                      \
+        memset(s, 0, sizeof(*s));                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##_split_from_aos(Name##Split* s, const Name* a, size_t n) {   \
+        for (size_t i = 0; i < n; i++) {                                                    \
+            FIELDS(LAYOUT_SPLIT_HOT_, LAYOUT_SKIP_)                                         \
+            FIELDS(LAYOUT_SKIP_, LAYOUT_SPLIT_COLD_)                                        \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline Name prefix##_split_get(const Name##Split* s, size_t i) {                 \
+        Name r;                                                                             \
+        FIELDS(LAYOUT_JOIN_HOT_, LAYOUT_JOIN_COLD_)                                         \
+        return r;                                                                           \
+    }
+
+// Fails to compile if any field of Name has padding in front of it, or Name has tail padding.
+#define LAYOUT_ASSERT_NO_PADDING(Name, FIELDS)                                              \
+    typedef struct LAYOUT_PACKED_ { FIELDS(LAYOUT_MEMBER_, LAYOUT_MEMBER_) } Name##Packed_; \
+    static inline void Name##_layout_check_(void) {                                         \
+        typedef Name layout_record_;                                                        \
+        typedef Name##Packed_ layout_packed_;                                               \
+        FIELDS(LAYOUT_CHECK_OFFSET_, LAYOUT_CHECK_OFFSET_)                                  \
+        _Static_assert(sizeof(Name) == sizeof(Name##Packed_),                               \
+                       #Name ": tail padding: declare the spare bytes as a field");         \
+    }
+
+#endif // LAYOUT_H
@@ -0,0 +1,329 @@
+/*
+value.h - Dynamic Values: Tagged Union, NaN-Boxed and Columnar Layouts
+================================================
+
+The tagged union in Unions.c keeps an enum next to a union. Alignment pads that
+to 16 bytes or more per value, and every use goes through a switch. This
+header offers one value model in three layouts:
+
+    Value v = value_double(2.5);                 // Tagged union: 16 bytes
+    BoxedValue b = value_box(v);                 // NaN-boxed: 8 bytes
+    if (boxed_is_double(b)) total += boxed_as_double(b);
+
+    ValueColumns col;                            // Arrays: 1-byte tags + 8-byte payloads
+    value_columns_init(&col);
+    value_columns_push(&col, value_int(7));      // 0, or -1 with errno = ENOMEM
+    double sum = value_columns_sum(&col);
+    size_t hits = value_columns_filter_greater(&col, 3.0, indices);
+    value_columns_destroy(&col);
+
+Design:
+- Value is the standard layout: a one-byte ValueType and an 8-byte payload,
+  16 bytes with padding.
+- BoxedValue packs the same information into 64 bits. Every double except
+  NaN is stored as is. NaNs are folded into one canonical quiet NaN, which
+  frees the bit patterns with the sign bit and the top 13 exponent/quiet bits
+  all set (0xFFF8...). There, bits 48-50 hold the type and the low 48 bits the
+  payload: a bool, a 48-bit signed integer or a pointer. x86-64 and AArch64
+  user-space pointers fit in 48 bits.
+- Integers outside +-2^47 do not fit a NaN box and are stored as doubles,
+  exact up to 2^53, as JavaScript engines do.
+- ValueColumns stores tags and payloads as two arrays (structure of arrays),
+  9 bytes per value. It counts the values of each type, so bulk operations pick
+  a loop once per call. An all-double or all-int column runs a loop with no
+  type tests. A mixed column tests each tag with branch-free masks instead of
+  a switch, so random types cost no mispredictions.
+- Strings are borrowed const char* pointers. The caller keeps them alive.
+- Functions that allocate return 0, or -1 with errno = ENOMEM.
+*/
+
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+typedef enum {
+    VALUE_NIL,
+    VALUE_BOOL,
+    VALUE_INT,
+    VALUE_DOUBLE,
+    VALUE_STRING,
+    VALUE_TYPE_COUNT
+} ValueType;
+
+typedef union {
+    int b;
+    int64_t i;
+    double d;
+    const char* s;
+} ValuePayload;
+
+typedef struct {
+    uint8_t type;                               // ValueType
+    ValuePayload as;
+} Value;
+
+typedef struct {
+    uint64_t bits;
+} BoxedValue;
+
+typedef struct {
+    uint8_t* tags;
+    ValuePayload* payloads;
+    size_t count;
+    size_t capacity;
+    size_t type_counts[VALUE_TYPE_COUNT];
+} ValueColumns;
+
+#define VALUE_BOX_PREFIX 0xFFF8000000000000ull  // Sign, exponent and quiet bits all set
+#define VALUE_BOX_CANONICAL_NAN 0x7FF8000000000000ull
+#define VALUE_BOX_PAYLOAD_MASK 0x0000FFFFFFFFFFFFull
+#define VALUE_BOX_INT_MIN (-((int64_t)1 << 47))
+#define VALUE_BOX_INT_MAX (((int64_t)1 << 47) - 1)
+
+// --- Tagged union ---
+
+static inline Value value_nil(void) {
+    Value v;
+    v.type = VALUE_NIL;
+    v.as.i = 0;
+    return v;
+}
+
+static inline Value value_bool(int b) {
+    Value v;
+    v.type = VALUE_BOOL;
+    v.as.i = 0;
+    v.as.b = b != 0;
+    return v;
+}
+
+static inline Value value_int(int64_t i) {
+    Value v;
+    v.type = VALUE_INT;
+    v.as.i = i;
+    return v;
+}
+
+static inline Value value_double(double d) {
+    Value v;
+    v.type = VALUE_DOUBLE;
+    v.as.d = d;
+    return v;
+}
+
+static inline Value value_string(const char* s) {
+    Value v;
+    v.type = VALUE_STRING;
+    v.as.i = 0;
+    v.as.s = s;
+    return v;
+}
+
+// Numeric value of an INT or DOUBLE, 0 for any other type.
+static inline double value_to_number(Value v) {
+    switch (v.type) {
+        case VALUE_INT: return (double)v.as.i;
+        case VALUE_DOUBLE: return v.as.d;
+        default: return 0.0;
+    }
+}
+
+// --- NaN boxing ---
+
+static inline BoxedValue boxed_make_(ValueType type, uint64_t payload) {
+    BoxedValue b = {VALUE_BOX_PREFIX | (uint64_t)type << 48 | (payload & VALUE_BOX_PAYLOAD_MASK)};
+    return b;
+}
+
+static inline BoxedValue boxed_double(double d) {
+    BoxedValue b;
+    memcpy(&b.bits, &d, sizeof(d));
+    if (d != d) b.bits = VALUE_BOX_CANONICAL_NAN;
+    return b;
+}
+
+static inline BoxedValue boxed_int(int64_t i) {
+    if (i < VALUE_BOX_INT_MIN || i > VALUE_BOX_INT_MAX) return boxed_double((double)i);
+    return boxed_make_(VALUE_INT, (uint64_t)i);
+}
+
+static inline BoxedValue boxed_nil(void) { return boxed_make_(VALUE_NIL, 0); }
+static inline BoxedValue boxed_bool(int b) { return boxed_make_(VALUE_BOOL, b != 0); }
+static inline BoxedValue boxed_string(const char* s) { return boxed_make_(VALUE_STRING, (uint64_t)(uintptr_t)s); }
+
+static inline int boxed_is_double(BoxedValue b) {
+    return (b.bits & VALUE_BOX_PREFIX) != VALUE_BOX_PREFIX;
+}
+
+static inline ValueType boxed_type(BoxedValue b) {
+    return boxed_is_double(b) ? VALUE_DOUBLE : (ValueType)((b.bits >> 48) & 7);
+}
+
+static inline double boxed_as_double(BoxedValue b) {
+    double d;
+    memcpy(&d, &b.bits, sizeof(d));
+    return d;
+}
+
+// Sign-extends the 48-bit payload.
+static inline int64_t boxed_as_int(BoxedValue b) {
+    return (int64_t)(b.bits << 16) >> 16;
+}
+
+static inline int boxed_as_bool(BoxedValue b) { return (int)(b.bits & 1); }
+static inline const char* boxed_as_string(BoxedValue b) { return (const char*)(uintptr_t)(b.bits & VALUE_BOX_PAYLOAD_MASK); }
+
+static inline double boxed_to_number(BoxedValue b) {
+    if (boxed_is_double(b)) return boxed_as_double(b);
+    return boxed_type(b) == VALUE_INT ? (double)boxed_as_int(b) : 0.0;
+}
+
+static inline BoxedValue value_box(Value v) {
+    switch (v.type) {
+        case VALUE_BOOL: return boxed_bool(v.as.b);
+        case VALUE_INT: return boxed_int(v.as.i);
+        case VALUE_DOUBLE: return boxed_double(v.as.d);
+        case VALUE_STRING: return boxed_string(v.as.s);
+        default: return boxed_nil();
+    }
+}
+
+static inline Value value_unbox(BoxedValue b) {
+    switch (boxed_type(b)) {
+        case VALUE_BOOL: return value_bool(boxed_as_bool(b));
+        case VALUE_INT: return value_int(boxed_as_int(b));
+        case VALUE_DOUBLE: return value_double(boxed_as_double(b));
+        case VALUE_STRING: return value_string(boxed_as_string(b));
+        default: return value_nil();
+    }
+}
+
+// --- Tag and payload columns ---
+
+static inline void value_columns_init(ValueColumns* c) {
+    memset(c, 0, sizeof(*c));
+}
+
+static inline void value_columns_destroy(ValueColumns* c) {
+    free(c->tags);
+    free(c->payloads);
+    value_columns_init(c);
+}
+
+static inline int value_columns_reserve(ValueColumns* c, size_t capacity) {
+    if (capacity <= c->capacity) return 0;
+    size_t grown = c->capacity ? c->capacity * 2 : 16;
+    if (grown < capacity) grown = capacity;
+    if (grown > SIZE_MAX / sizeof(ValuePayload)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    uint8_t* tags = (uint8_t*)realloc(c->tags, grown);
+    if (tags == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    c->tags = tags;
+    ValuePayload* payloads = (ValuePayload*)realloc(c->payloads, grown * sizeof(ValuePayload));
+    if (payloads == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    c->payloads = payloads;
+    c->capacity = grown;
+    return 0;
+}
+
+static inline int value_columns_push(ValueColumns* c, Value v) {
+    if (c->count == c->capacity && value_columns_reserve(c, c->count + 1) != 0) return -1;
+    c->tags[c->count] = v.type;
+    c->payloads[c->count] = v.as;
+    c->count++;
+    c->type_counts[v.type]++;
+    return 0;
+}
+
+static inline Value value_columns_get(const ValueColumns* c, size_t i) {
+    Value v;
+    v.type = c->tags[i];
+    v.as = c->payloads[i];
+    return v;
+}
+
+static inline void value_columns_set(ValueColumns* c, size_t i, Value v) {
+    c->type_counts[c->tags[i]]--;
+    c->type_counts[v.type]++;
+    c->tags[i] = v.type;
+    c->payloads[i] = v.as;
+}
+
+static inline int value_columns_uniform_(const ValueColumns* c, ValueType type) {
+    return c->type_counts[type] == c->count;
+}
+
+// Sum of the INT and DOUBLE values; other types count as 0. The INT values are
+// added in uint64_t, which wraps instead of overflowing (undefined for int64_t):
+// the result is exact whenever the INT total fits in int64_t, whatever the order.
+static inline double value_columns_sum(const ValueColumns* c) {
+    const ValuePayload* p = c->payloads;
+    const size_t n = c->count;
+    if (value_columns_uniform_(c, VALUE_DOUBLE)) {
+        double total = 0;
+        for (size_t i = 0; i < n; i++) total += p[i].d;
+        return total;
+    }
+    if (value_columns_uniform_(c, VALUE_INT)) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < n; i++) total += (uint64_t)p[i].i;
+        return (double)(int64_t)total;
+    }
+    // Mixed: the two sums run side by side. Each payload is masked to 0 by its tag
+    // test as an integer, so an int's bits are never added as a (denormal) double.
+    double doubles = 0;
+    uint64_t ints = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t tag = c->tags[i];
+        uint64_t bits = (uint64_t)p[i].i & (0 - (uint64_t)(tag == VALUE_DOUBLE));
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        doubles += d;
+        ints += (uint64_t)p[i].i & (0 - (uint64_t)(tag == VALUE_INT));
+    }
+    return doubles + (double)(int64_t)ints;
+}
+
+// Writes the indices of the INT and DOUBLE values greater than threshold to
+// out[], which must have room for c->count entries. Returns how many.
+static inline size_t value_columns_filter_greater(const ValueColumns* c, double threshold, uint32_t* out) {
+    const ValuePayload* p = c->payloads;
+    const size_t n = c->count;
+    size_t hits = 0;
+    if (value_columns_uniform_(c, VALUE_DOUBLE)) {
+        for (size_t i = 0; i < n; i++) {
+            out[hits] = (uint32_t)i;
+            hits += p[i].d > threshold;
+        }
+        return hits;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint8_t tag = c->tags[i];
+        int is_double = tag == VALUE_DOUBLE;
+        // Both readings computed, then one picked by masking the bits
+        double as_int = (double)p[i].i;
+        uint64_t int_bits, mask = 0 - (uint64_t)is_double;
+        memcpy(&int_bits, &as_int, sizeof(int_bits));
+        uint64_t bits = ((uint64_t)p[i].i & mask) | (int_bits & ~mask);
+        double x;
+        memcpy(&x, &bits, sizeof(x));
+        out[hits] = (uint32_t)i;
+        hits += (size_t)((is_double | (tag == VALUE_INT)) & (x > threshold));
+    }
+    return hits;
+}
+
+#endif // VALUE_H
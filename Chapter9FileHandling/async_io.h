@@ -0,0 +1,509 @@
+/*
+async_io.h - Batched Asynchronous File I/O (io_uring with a POSIX AIO fallback)
+================================================
+
+A header-only engine that keeps up to 'depth' reads and writes in flight and reaps
+their completions in batches. Nothing spins: a caller that needs results blocks in the
+kernel until at least the requested number of operations has finished.
+
+Backends:
+- io_uring (Linux 5.6+), used directly through the raw system calls so no liburing is
+  needed. One io_uring_enter() submits every queued operation, and completions are
+  read from the shared completion ring without a system call when they are ready.
+- POSIX AIO (aio_read/aio_write + aio_suspend) everywhere else, or when the kernel
+  refuses io_uring (old kernel, seccomp policy). Select it explicitly with the
+  ASYNC_IO_POSIX flag, or at compile time with -DASYNC_IO_NO_URING.
+
+Usage:
+    AsyncIo io;
+    if (async_io_init(&io, 32, 0) != 0) { perror("async_io_init"); return; }
+    for (each block) {
+        if (async_io_prep_write(&io, fd, buf, len, offset, tag) != 0) {
+            async_io_submit(&io);                       // queue full: push and drain
+            n = async_io_reap(&io, done, 32, 1);
+            ...
+        }
+    }
+    async_io_submit(&io);
+    while (io.inflight) n = async_io_reap(&io, done, 32, 1);
+    async_io_destroy(&io);
+
+Each AsyncIoCompletion carries the caller's user_data and 'result': the number of bytes
+transferred, or a negative errno value, exactly like the return value of a system call.
+Setup functions return 0 or -1 with errno set.
+
+Registered buffers:
+    async_io_register_buffers() pins a set of buffers once (IORING_REGISTER_BUFFERS) so
+    async_io_prep_read_fixed() / async_io_prep_write_fixed() skip the per-operation
+    page pinning in the kernel. With POSIX AIO they behave like the plain calls.
+
+Compile with -pthread (glibc implements POSIX AIO with helper threads).
+*/
+
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <aio.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && !defined(ASYNC_IO_NO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_HAVE_URING 1
+#endif
+#endif
+
+#ifdef ASYNC_IO_HAVE_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define ASYNC_IO_MAX_DEPTH 4096
+
+// Flags for async_io_init()
+#define ASYNC_IO_POSIX 0x1         // Skip io_uring even when it is available
+
+typedef enum {
+    ASYNC_IO_BACKEND_URING,
+    ASYNC_IO_BACKEND_POSIX
+} AsyncIoBackend;
+
+typedef enum {
+    ASYNC_IO_READ,
+    ASYNC_IO_WRITE
+} AsyncIoOp;
+
+typedef struct {
+    uint64_t user_data;
+    int64_t result;            // Bytes transferred, or -errno
+    AsyncIoOp op;
+} AsyncIoCompletion;
+
+typedef struct {
+    AsyncIoBackend backend;
+    unsigned depth;
+    unsigned queued;           // Prepared but not yet submitted
+    unsigned inflight;         // Submitted (or queued) and not yet reaped
+
+    const struct iovec* buffers;
+    unsigned buffer_count;
+
+#ifdef ASYNC_IO_HAVE_URING
+    int ring_fd;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    unsigned sq_local_tail;
+    unsigned sq_submitted;     // SQ entries the kernel has consumed (our view of sq_head)
+#endif
+
+    // One slot per request in flight; io_uring carries the slot index as its user_data
+    uint64_t* slot_user_data;
+    AsyncIoOp* slot_op;
+    unsigned char* slot_state; // 0 free, 1 queued, 2 submitted, 3 failed at submit
+    int64_t* slot_result;
+    unsigned* free_slots;
+    unsigned free_count;
+
+    // POSIX AIO only
+    struct aiocb* cbs;
+    const struct aiocb** wait_list;
+} AsyncIo;
+
+static inline int async_io_fail_(int err) {
+    errno = err;
+    return -1;
+}
+
+#ifdef ASYNC_IO_HAVE_URING
+
+static inline int async_io_uring_enter_(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline void async_io_uring_unmap_(AsyncIo* io) {
+    if (io->sqes) munmap(io->sqes, io->sqes_size);
+    if (io->cq_ring && io->cq_ring != io->sq_ring) munmap(io->cq_ring, io->cq_ring_size);
+    if (io->sq_ring) munmap(io->sq_ring, io->sq_ring_size);
+    if (io->ring_fd >= 0) close(io->ring_fd);
+    io->sqes = NULL;
+    io->sq_ring = io->cq_ring = NULL;
+    io->ring_fd = -1;
+}
+
+static inline int async_io_uring_init_(AsyncIo* io, unsigned depth) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    io->ring_fd = (int)syscall(__NR_io_uring_setup, depth, &p);
+    if (io->ring_fd < 0) return -1;
+
+    io->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    io->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (io->cq_ring_size > io->sq_ring_size) io->sq_ring_size = io->cq_ring_size;
+        io->cq_ring_size = io->sq_ring_size;
+    }
+
+    io->sq_ring = mmap(NULL, io->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       io->ring_fd, IORING_OFF_SQ_RING);
+    if (io->sq_ring == MAP_FAILED) {
+        io->sq_ring = NULL;
+        goto fail;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        io->cq_ring = io->sq_ring;
+    } else {
+        io->cq_ring = mmap(NULL, io->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           io->ring_fd, IORING_OFF_CQ_RING);
+        if (io->cq_ring == MAP_FAILED) {
+            io->cq_ring = NULL;
+            goto fail;
+        }
+    }
+    io->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    io->sqes = (struct io_uring_sqe*)mmap(NULL, io->sqes_size, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE, io->ring_fd, IORING_OFF_SQES);
+    if (io->sqes == MAP_FAILED) {
+        io->sqes = NULL;
+        goto fail;
+    }
+
+    char* sq = (char*)io->sq_ring;
+    char* cq = (char*)io->cq_ring;
+    io->sq_head = (unsigned*)(sq + p.sq_off.head);
+    io->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    io->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    io->sq_array = (unsigned*)(sq + p.sq_off.array);
+    io->cq_head = (unsigned*)(cq + p.cq_off.head);
+    io->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    io->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    io->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    io->sq_local_tail = *io->sq_tail;
+    io->sq_submitted = io->sq_local_tail;
+    io->backend = ASYNC_IO_BACKEND_URING;
+    return 0;
+
+fail: {
+        int err = errno;
+        async_io_uring_unmap_(io);
+        errno = err;
+        return -1;
+    }
+}
+
+#endif // ASYNC_IO_HAVE_URING
+
+static inline int async_io_slots_init_(AsyncIo* io, unsigned depth) {
+    io->slot_user_data = (uint64_t*)calloc(depth, sizeof(uint64_t));
+    io->slot_op = (AsyncIoOp*)calloc(depth, sizeof(AsyncIoOp));
+    io->slot_state = (unsigned char*)calloc(depth, 1);
+    io->slot_result = (int64_t*)calloc(depth, sizeof(int64_t));
+    io->free_slots = (unsigned*)calloc(depth, sizeof(unsigned));
+    if (!io->slot_user_data || !io->slot_op || !io->slot_state || !io->slot_result || !io->free_slots) {
+        return async_io_fail_(ENOMEM);
+    }
+    for (unsigned i = 0; i < depth; i++) io->free_slots[i] = depth - 1 - i;
+    io->free_count = depth;
+    return 0;
+}
+
+static inline int async_io_posix_init_(AsyncIo* io, unsigned depth) {
+    io->cbs = (struct aiocb*)calloc(depth, sizeof(struct aiocb));
+    io->wait_list = (const struct aiocb**)calloc(depth, sizeof(struct aiocb*));
+    if (!io->cbs || !io->wait_list) return async_io_fail_(ENOMEM);
+    io->backend = ASYNC_IO_BACKEND_POSIX;
+    return 0;
+}
+
+static inline void async_io_destroy(AsyncIo* io);
+
+static inline int async_io_init(AsyncIo* io, unsigned depth, int flags) {
+    memset(io, 0, sizeof(*io));
+#ifdef ASYNC_IO_HAVE_URING
+    io->ring_fd = -1;
+#endif
+    if (depth == 0 || depth > ASYNC_IO_MAX_DEPTH) return async_io_fail_(EINVAL);
+    io->depth = depth;
+    if (async_io_slots_init_(io, depth) != 0) {
+        async_io_destroy(io);
+        return async_io_fail_(ENOMEM);
+    }
+
+#ifdef ASYNC_IO_HAVE_URING
+    if (!(flags & ASYNC_IO_POSIX) && async_io_uring_init_(io, depth) == 0) return 0;
+#else
+    (void)flags;
+#endif
+    if (async_io_posix_init_(io, depth) != 0) {
+        async_io_destroy(io);
+        return async_io_fail_(ENOMEM);
+    }
+    return 0;
+}
+
+// In-flight operations must be reaped first; the engine does not cancel them.
+static inline void async_io_destroy(AsyncIo* io) {
+#ifdef ASYNC_IO_HAVE_URING
+    async_io_uring_unmap_(io);
+#endif
+    free(io->cbs);
+    free(io->slot_user_data);
+    free(io->slot_op);
+    free(io->slot_state);
+    free(io->slot_result);
+    free(io->free_slots);
+    free(io->wait_list);
+    memset(io, 0, sizeof(*io));
+#ifdef ASYNC_IO_HAVE_URING
+    io->ring_fd = -1;
+#endif
+}
+
+static inline const char* async_io_backend_name(const AsyncIo* io) {
+    return io->backend == ASYNC_IO_BACKEND_URING ? "io_uring" : "POSIX AIO";
+}
+
+// The array must stay valid (and the buffers allocated) until async_io_destroy().
+static inline int async_io_register_buffers(AsyncIo* io, const struct iovec* buffers, unsigned count) {
+#ifdef ASYNC_IO_HAVE_URING
+    if (io->backend == ASYNC_IO_BACKEND_URING) {
+        if (syscall(__NR_io_uring_register, io->ring_fd, IORING_REGISTER_BUFFERS, buffers, count) != 0) {
+            return -1;
+        }
+    }
+#endif
+    io->buffers = buffers;
+    io->buffer_count = count;
+    return 0;
+}
+
+static inline int async_io_prep_(AsyncIo* io, AsyncIoOp op, int fd, void* buf, size_t len,
+                                 off_t offset, uint64_t user_data, int buf_index) {
+    if (io->inflight >= io->depth) return async_io_fail_(EBUSY);
+    if (buf_index >= 0) {
+        if ((unsigned)buf_index >= io->buffer_count) return async_io_fail_(EINVAL);
+        const struct iovec* reg = &io->buffers[buf_index];
+        if ((char*)buf < (char*)reg->iov_base || (char*)buf + len > (char*)reg->iov_base + reg->iov_len) {
+            return async_io_fail_(EINVAL);
+        }
+    }
+
+    unsigned slot = io->free_slots[--io->free_count];
+    io->slot_user_data[slot] = user_data;
+    io->slot_op[slot] = op;
+    io->slot_state[slot] = 1;
+    io->queued++;
+    io->inflight++;
+
+#ifdef ASYNC_IO_HAVE_URING
+    if (io->backend == ASYNC_IO_BACKEND_URING) {
+        unsigned index = io->sq_local_tail & *io->sq_mask;
+        struct io_uring_sqe* sqe = &io->sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        if (buf_index >= 0) {
+            sqe->opcode = op == ASYNC_IO_WRITE ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe->buf_index = (uint16_t)buf_index;
+        } else {
+            sqe->opcode = op == ASYNC_IO_WRITE ? IORING_OP_WRITE : IORING_OP_READ;
+        }
+        sqe->fd = fd;
+        sqe->off = (uint64_t)offset;
+        sqe->addr = (uint64_t)(uintptr_t)buf;
+        sqe->len = (uint32_t)len;
+        sqe->user_data = slot;
+        io->sq_array[index] = index;
+        io->sq_local_tail++;
+        return 0;
+    }
+#endif
+
+    struct aiocb* cb = &io->cbs[slot];
+    memset(cb, 0, sizeof(*cb));
+    cb->aio_fildes = fd;
+    cb->aio_buf = buf;
+    cb->aio_nbytes = len;
+    cb->aio_offset = offset;
+    return 0;
+}
+
+static inline int async_io_prep_write(AsyncIo* io, int fd, const void* buf, size_t len,
+                                      off_t offset, uint64_t user_data) {
+    return async_io_prep_(io, ASYNC_IO_WRITE, fd, (void*)buf, len, offset, user_data, -1);
+}
+
+static inline int async_io_prep_read(AsyncIo* io, int fd, void* buf, size_t len,
+                                     off_t offset, uint64_t user_data) {
+    return async_io_prep_(io, ASYNC_IO_READ, fd, buf, len, offset, user_data, -1);
+}
+
+// 'buf' must lie inside registered buffer 'buf_index'.
+static inline int async_io_prep_write_fixed(AsyncIo* io, int fd, unsigned buf_index, const void* buf,
+                                            size_t len, off_t offset, uint64_t user_data) {
+    return async_io_prep_(io, ASYNC_IO_WRITE, fd, (void*)buf, len, offset, user_data, (int)buf_index);
+}
+
+static inline int async_io_prep_read_fixed(AsyncIo* io, int fd, unsigned buf_index, void* buf,
+                                           size_t len, off_t offset, uint64_t user_data) {
+    return async_io_prep_(io, ASYNC_IO_READ, fd, buf, len, offset, user_data, (int)buf_index);
+}
+
+// Hand the prepared operations to the kernel. Returns how many it accepted, or -1 with
+// errno when it accepted none. With io_uring, operations the kernel did not consume
+// stay queued for the next call. With POSIX AIO, an operation that aio_read/aio_write
+// rejects is reported by async_io_reap() as a failed completion.
+static inline int async_io_submit(AsyncIo* io) {
+    unsigned count = io->queued;
+    if (count == 0) return 0;
+
+#ifdef ASYNC_IO_HAVE_URING
+    if (io->backend == ASYNC_IO_BACKEND_URING) {
+        __atomic_store_n(io->sq_tail, io->sq_local_tail, __ATOMIC_RELEASE);
+        unsigned done = 0;
+        int err = 0;
+        while (done < count) {
+            int rc = async_io_uring_enter_(io->ring_fd, count - done, 0, 0);
+            if (rc < 0) {
+                if (errno == EINTR) continue;
+                err = errno;
+                break;
+            }
+            if (rc == 0) {
+                err = EAGAIN;
+                break;
+            }
+            done += (unsigned)rc;
+        }
+        // The kernel consumes SQ entries in order: only the first 'done' left the queue
+        for (unsigned i = 0; i < done; i++) {
+            const struct io_uring_sqe* sqe = &io->sqes[(io->sq_submitted + i) & *io->sq_mask];
+            io->slot_state[sqe->user_data] = 2;
+        }
+        io->sq_submitted += done;
+        io->queued -= done;
+        if (done == 0) return async_io_fail_(err);
+        return (int)done;
+    }
+#endif
+
+    unsigned accepted = 0;
+    int err = 0;
+    for (unsigned slot = 0; slot < io->depth; slot++) {
+        if (io->slot_state[slot] != 1) continue;
+        struct aiocb* cb = &io->cbs[slot];
+        int rc = io->slot_op[slot] == ASYNC_IO_WRITE ? aio_write(cb) : aio_read(cb);
+        if (rc == 0) {
+            io->slot_state[slot] = 2;
+            accepted++;
+        } else {
+            err = errno;
+            io->slot_state[slot] = 3;  // Reported as a failed completion by async_io_reap()
+            io->slot_result[slot] = -err;
+        }
+    }
+    io->queued = 0;
+    if (accepted == 0) return async_io_fail_(err);
+    return (int)accepted;
+}
+
+static inline void async_io_complete_(AsyncIo* io, unsigned slot, int64_t result, AsyncIoCompletion* out) {
+    out->user_data = io->slot_user_data[slot];
+    out->result = result;
+    out->op = io->slot_op[slot];
+    io->slot_state[slot] = 0;
+    io->free_slots[io->free_count++] = slot;
+}
+
+#ifdef ASYNC_IO_HAVE_URING
+static inline unsigned async_io_uring_collect_(AsyncIo* io, AsyncIoCompletion* out, unsigned max) {
+    unsigned head = *io->cq_head;
+    unsigned tail = __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE);
+    unsigned n = 0;
+    while (head != tail && n < max) {
+        const struct io_uring_cqe* cqe = &io->cqes[head & *io->cq_mask];
+        async_io_complete_(io, (unsigned)cqe->user_data, cqe->res, &out[n]);
+        n++;
+        head++;
+    }
+    __atomic_store_n(io->cq_head, head, __ATOMIC_RELEASE);
+    return n;
+}
+#endif
+
+static inline unsigned async_io_posix_collect_(AsyncIo* io, AsyncIoCompletion* out, unsigned max) {
+    unsigned n = 0;
+    for (unsigned slot = 0; slot < io->depth && n < max; slot++) {
+        int64_t result;
+        if (io->slot_state[slot] == 3) {
+            result = io->slot_result[slot];
+        } else if (io->slot_state[slot] == 2) {
+            int err = aio_error(&io->cbs[slot]);
+            if (err == EINPROGRESS) continue;
+            ssize_t ret = aio_return(&io->cbs[slot]);
+            result = err ? -(int64_t)err : (int64_t)ret;
+        } else {
+            continue;
+        }
+        async_io_complete_(io, slot, result, &out[n]);
+        n++;
+    }
+    return n;
+}
+
+// Collect up to 'max' completions, blocking until at least 'min_wait' are available
+// (min_wait 0 never blocks). Returns the number collected, or -1 on error.
+static inline int async_io_reap(AsyncIo* io, AsyncIoCompletion* out, unsigned max, unsigned min_wait) {
+    if (min_wait > io->inflight - io->queued) min_wait = io->inflight - io->queued;
+    if (min_wait > max) min_wait = max;
+    unsigned n = 0;
+
+#ifdef ASYNC_IO_HAVE_URING
+    if (io->backend == ASYNC_IO_BACKEND_URING) {
+        for (;;) {
+            n += async_io_uring_collect_(io, out + n, max - n);
+            if (n >= min_wait) break;
+            int rc = async_io_uring_enter_(io->ring_fd, 0, min_wait - n, IORING_ENTER_GETEVENTS);
+            if (rc < 0 && errno != EINTR) {
+                if (n > 0) break;
+                return -1;
+            }
+        }
+        io->inflight -= n;
+        return (int)n;
+    }
+#endif
+
+    for (;;) {
+        n += async_io_posix_collect_(io, out + n, max - n);
+        if (n >= min_wait) break;
+        unsigned waiting = 0;
+        for (unsigned slot = 0; slot < io->depth; slot++) {
+            if (io->slot_state[slot] == 2) io->wait_list[waiting++] = &io->cbs[slot];
+        }
+        if (aio_suspend(io->wait_list, (int)waiting, NULL) != 0 && errno != EINTR && errno != EAGAIN) {
+            if (n > 0) break;
+            return -1;
+        }
+    }
+    io->inflight -= n;
+    return (int)n;
+}
+
+#endif // ASYNC_IO_H
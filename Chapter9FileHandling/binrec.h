@@ -0,0 +1,520 @@
+/*
+binrec.h - Compact Binary Record Files with Zero-Copy Reads
+================================================
+
+fprintf() and strtod() spend most of their time converting numbers to and from
+decimal. binrec.h stores records in binary, behind a fixed 32-byte header, in
+one of two encodings:
+
+- Table: the records' in-memory layout (a packed struct array) written as is.
+  A reader validates the header and then uses the file, or its mmap, directly
+  as an array of structs. Nothing is decoded.
+- Varint stream: each field written by the caller with binrec_put_*. Integers
+  take 1-10 bytes depending on their magnitude (LEB128, zigzag for signed
+  values), so small ids and deltas shrink to a byte or two.
+
+    static const BinrecField reading_fields[] = {BINREC_FIELD(Reading, timestamp), ...};
+    static const BinrecSchema reading_schema = BINREC_SCHEMA(Reading, 1, reading_fields);
+
+    BinrecBuffer out;
+    binrec_buffer_init(&out);
+    binrec_write_table(&out, &reading_schema, readings, n);        // 0, or -1 with errno
+    fwrite(out.data, 1, out.length, file);
+
+    size_t count;
+    const Reading* r = (const Reading*)binrec_view_table(data, len, &reading_schema, &count);
+    if (r == NULL) ... // errno: EINVAL (malformed), ENOTSUP (other byte order: use binrec_copy_table)
+
+Design:
+- The header fields are always little-endian, assembled byte by byte, so any
+  host can read any header. It holds a magic number, a version, flags (writer
+  byte order, encoding), the schema id and record size, the record count and
+  the payload length.
+- Table payloads keep the writer's byte order, so writing and reading on the
+  same kind of machine never swaps a byte. A reader with the other byte order
+  calls binrec_copy_table(), which swaps each field in place using the schema's
+  field offsets and widths.
+- binrec_view_table() checks the magic, version, schema id, record size,
+  payload length against the buffer and the alignment of the records before
+  it returns a pointer into the buffer. After that the records are read
+  directly, with no bounds or format checks per field.
+- BinrecReader keeps a sticky error flag. Each binrec_get_* returns 0 once the
+  input is exhausted or malformed, so a decoder reads all fields and checks
+  binrec_reader_ok() once per record instead of after every field.
+- binrec_bswap16/32/64_array() swap whole columns with AVX2 byte shuffles when
+  the CPU has them (checked at run time, as in string_simd.h), else with
+  __builtin_bswap.
+- Functions that allocate return 0, or -1 with errno = ENOMEM, like
+  string_builder.h.
+*/
+
+#ifndef BINREC_H
+#define BINREC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BINREC_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#define BINREC_MAGIC 0x31435242u                // "BRC1"
+#define BINREC_VERSION 1
+#define BINREC_HEADER_SIZE 32
+#define BINREC_FLAG_BIG_ENDIAN 0x1              // Table payload written by a big-endian host
+#define BINREC_FLAG_VARINT 0x2                  // Payload is a varint stream, not a table
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BINREC_HOST_FLAGS BINREC_FLAG_BIG_ENDIAN
+#else
+#define BINREC_HOST_FLAGS 0
+#endif
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t schema_id;
+    uint32_t record_size;                       // 0 for varint streams
+    uint64_t record_count;
+    uint64_t payload_bytes;
+} BinrecHeader;
+
+typedef struct {
+    uint16_t offset;
+    uint8_t width;                              // 1, 2, 4 or 8: the scalar swapped on a byte-order change
+} BinrecField;
+
+typedef struct {
+    uint32_t id;
+    uint32_t record_size;
+    size_t align;
+    const BinrecField* fields;
+    size_t field_count;
+} BinrecSchema;
+
+// Fields are 1, 2, 4 or 8-byte scalars at offsets below 64 KB. Anything else (an
+// array, a nested struct) would not fit the narrow BinrecField members or would be
+// swapped as the wrong width, so the negative array size turns it into a compile error.
+#define BINREC_FIELD_SIZE_(T, f) sizeof(((T*)0)->f)
+#define BINREC_FIELD_OK_(T, f)                                                  \
+    ((BINREC_FIELD_SIZE_(T, f) == 1 || BINREC_FIELD_SIZE_(T, f) == 2 ||         \
+      BINREC_FIELD_SIZE_(T, f) == 4 || BINREC_FIELD_SIZE_(T, f) == 8) &&        \
+     offsetof(T, f) <= UINT16_MAX)
+#define BINREC_FIELD(T, f)                                                      \
+    {(uint16_t)offsetof(T, f),                                                  \
+     (uint8_t)(BINREC_FIELD_SIZE_(T, f) + 0 * sizeof(char[BINREC_FIELD_OK_(T, f) ? 1 : -1]))}
+#define BINREC_SCHEMA(T, id, fields) \
+    {(id), (uint32_t)sizeof(T), _Alignof(T), (fields), sizeof(fields) / sizeof((fields)[0])}
+
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+} BinrecBuffer;
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    int error;
+} BinrecReader;
+
+// --- Byte swapping ---
+
+static inline void binrec_bswap16_scalar_(uint16_t* v, size_t n) {
+    for (size_t i = 0; i < n; i++) v[i] = __builtin_bswap16(v[i]);
+}
+
+static inline void binrec_bswap32_scalar_(uint32_t* v, size_t n) {
+    for (size_t i = 0; i < n; i++) v[i] = __builtin_bswap32(v[i]);
+}
+
+static inline void binrec_bswap64_scalar_(uint64_t* v, size_t n) {
+    for (size_t i = 0; i < n; i++) v[i] = __builtin_bswap64(v[i]);
+}
+
+#ifdef BINREC_HAVE_X86
+#define BINREC_TARGET_AVX2_ __attribute__((target("avx2")))
+
+// Reverses the bytes of each 'width'-byte lane, 32 bytes per step.
+static BINREC_TARGET_AVX2_ size_t binrec_avx2_bswap_(uint8_t* p, size_t bytes, int width) {
+    __m256i shuffle;
+    if (width == 2) {
+        shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                   1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    } else if (width == 4) {
+        shuffle = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                   3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    } else {
+        shuffle = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                   7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        _mm256_storeu_si256((__m256i*)(p + i), _mm256_shuffle_epi8(v, shuffle));
+    }
+    return i;
+}
+
+static inline int binrec_have_avx2_(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        __builtin_cpu_init();
+        cached = __builtin_cpu_supports("avx2") != 0;
+    }
+    return cached;
+}
+#endif
+
+static inline void binrec_bswap16_array(uint16_t* v, size_t n) {
+    size_t done = 0;
+#ifdef BINREC_HAVE_X86
+    if (binrec_have_avx2_()) done = binrec_avx2_bswap_((uint8_t*)v, n * 2, 2) / 2;
+#endif
+    binrec_bswap16_scalar_(v + done, n - done);
+}
+
+static inline void binrec_bswap32_array(uint32_t* v, size_t n) {
+    size_t done = 0;
+#ifdef BINREC_HAVE_X86
+    if (binrec_have_avx2_()) done = binrec_avx2_bswap_((uint8_t*)v, n * 4, 4) / 4;
+#endif
+    binrec_bswap32_scalar_(v + done, n - done);
+}
+
+static inline void binrec_bswap64_array(uint64_t* v, size_t n) {
+    size_t done = 0;
+#ifdef BINREC_HAVE_X86
+    if (binrec_have_avx2_()) done = binrec_avx2_bswap_((uint8_t*)v, n * 8, 8) / 8;
+#endif
+    binrec_bswap64_scalar_(v + done, n - done);
+}
+
+// Swaps every field of count records in place, for tables from a host with the other byte order.
+static inline void binrec_swap_records(void* records, size_t count, const BinrecSchema* schema) {
+    uint8_t* base = (uint8_t*)records;
+    for (size_t f = 0; f < schema->field_count; f++) {
+        const BinrecField field = schema->fields[f];
+        uint8_t* p = base + field.offset;
+        for (size_t i = 0; i < count; i++, p += schema->record_size) {
+            if (field.width == 2) {
+                uint16_t x;
+                memcpy(&x, p, 2);
+                x = __builtin_bswap16(x);
+                memcpy(p, &x, 2);
+            } else if (field.width == 4) {
+                uint32_t x;
+                memcpy(&x, p, 4);
+                x = __builtin_bswap32(x);
+                memcpy(p, &x, 4);
+            } else if (field.width == 8) {
+                uint64_t x;
+                memcpy(&x, p, 8);
+                x = __builtin_bswap64(x);
+                memcpy(p, &x, 8);
+            }
+        }
+    }
+}
+
+// --- Output buffer ---
+
+static inline void binrec_buffer_init(BinrecBuffer* b) {
+    b->data = NULL;
+    b->length = 0;
+    b->capacity = 0;
+}
+
+static inline void binrec_buffer_destroy(BinrecBuffer* b) {
+    free(b->data);
+    binrec_buffer_init(b);
+}
+
+static inline int binrec_buffer_reserve(BinrecBuffer* b, size_t capacity) {
+    if (capacity <= b->capacity) return 0;
+    if (capacity >= SIZE_MAX / 2) {
+        errno = ENOMEM;
+        return -1;
+    }
+    size_t grown = b->capacity ? b->capacity * 2 : 256;
+    if (grown < capacity) grown = capacity;
+    uint8_t* data = (uint8_t*)realloc(b->data, grown);
+    if (data == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    b->data = data;
+    b->capacity = grown;
+    return 0;
+}
+
+// Makes room for n more bytes and returns where they go, or NULL with errno = ENOMEM.
+static inline uint8_t* binrec_buffer_extend_(BinrecBuffer* b, size_t n) {
+    if (n > b->capacity - b->length && binrec_buffer_reserve(b, b->length + n) != 0) return NULL;
+    uint8_t* p = b->data + b->length;
+    b->length += n;
+    return p;
+}
+
+static inline void binrec_store_le_(uint8_t* p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint64_t binrec_load_le_(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static inline int binrec_put_fixed_(BinrecBuffer* b, uint64_t v, int bytes) {
+    uint8_t* p = binrec_buffer_extend_(b, (size_t)bytes);
+    if (p == NULL) return -1;
+    binrec_store_le_(p, v, bytes);
+    return 0;
+}
+
+static inline int binrec_put_u8(BinrecBuffer* b, uint8_t v) { return binrec_put_fixed_(b, v, 1); }
+static inline int binrec_put_u16(BinrecBuffer* b, uint16_t v) { return binrec_put_fixed_(b, v, 2); }
+static inline int binrec_put_u32(BinrecBuffer* b, uint32_t v) { return binrec_put_fixed_(b, v, 4); }
+static inline int binrec_put_u64(BinrecBuffer* b, uint64_t v) { return binrec_put_fixed_(b, v, 8); }
+
+static inline int binrec_put_f64(BinrecBuffer* b, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return binrec_put_fixed_(b, bits, 8);
+}
+
+// LEB128: 7 bits per byte, high bit set on every byte but the last.
+static inline int binrec_put_uvarint(BinrecBuffer* b, uint64_t v) {
+    if (b->capacity - b->length < 10 && binrec_buffer_reserve(b, b->length + 10) != 0) return -1;
+    uint8_t* p = b->data + b->length;
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    b->length = (size_t)(p - b->data);
+    return 0;
+}
+
+// Zigzag maps 0, -1, 1, -2 ... to 0, 1, 2, 3 ... so small negative values stay short.
+static inline int binrec_put_svarint(BinrecBuffer* b, int64_t v) {
+    return binrec_put_uvarint(b, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+// A uvarint length followed by the bytes.
+static inline int binrec_put_bytes(BinrecBuffer* b, const void* data, size_t n) {
+    if (binrec_put_uvarint(b, n) != 0) return -1;
+    uint8_t* p = binrec_buffer_extend_(b, n);
+    if (p == NULL) return -1;
+    memcpy(p, data, n);
+    return 0;
+}
+
+// --- Header ---
+
+static inline void binrec_header_store_(uint8_t* p, const BinrecHeader* h) {
+    binrec_store_le_(p, h->magic, 4);
+    binrec_store_le_(p + 4, h->version, 2);
+    binrec_store_le_(p + 6, h->flags, 2);
+    binrec_store_le_(p + 8, h->schema_id, 4);
+    binrec_store_le_(p + 12, h->record_size, 4);
+    binrec_store_le_(p + 16, h->record_count, 8);
+    binrec_store_le_(p + 24, h->payload_bytes, 8);
+}
+
+// Starts a varint stream: appends a header to be completed by binrec_end_stream().
+// Returns the header's offset in the buffer, or -1 with errno = ENOMEM.
+static inline long binrec_begin_stream(BinrecBuffer* b, uint32_t schema_id) {
+    size_t start = b->length;
+    uint8_t* p = binrec_buffer_extend_(b, BINREC_HEADER_SIZE);
+    if (p == NULL) return -1;
+    BinrecHeader h = {BINREC_MAGIC, BINREC_VERSION, BINREC_FLAG_VARINT, schema_id, 0, 0, 0};
+    binrec_header_store_(p, &h);
+    return (long)start;
+}
+
+static inline void binrec_end_stream(BinrecBuffer* b, long header_offset, uint64_t record_count) {
+    uint8_t* p = b->data + header_offset;
+    binrec_store_le_(p + 16, record_count, 8);
+    binrec_store_le_(p + 24, b->length - (size_t)header_offset - BINREC_HEADER_SIZE, 8);
+}
+
+// Appends a header and the records as they sit in memory, in this host's byte order.
+static inline int binrec_write_table(BinrecBuffer* b, const BinrecSchema* schema, const void* records,
+                                     size_t count) {
+    if (count > (SIZE_MAX / 2) / schema->record_size) {
+        errno = ENOMEM;
+        return -1;
+    }
+    size_t payload = count * schema->record_size;
+    uint8_t* p = binrec_buffer_extend_(b, BINREC_HEADER_SIZE + payload);
+    if (p == NULL) return -1;
+    BinrecHeader h = {BINREC_MAGIC, BINREC_VERSION, BINREC_HOST_FLAGS, schema->id, schema->record_size,
+                      count, payload};
+    binrec_header_store_(p, &h);
+    if (payload) memcpy(p + BINREC_HEADER_SIZE, records, payload);
+    return 0;
+}
+
+// Parses and checks the header at the start of data. Returns 0, or -1 with errno =
+// EINVAL if the magic, the version or the payload length is wrong.
+static inline int binrec_read_header(const void* data, size_t len, BinrecHeader* h) {
+    const uint8_t* p = (const uint8_t*)data;
+    if (len < BINREC_HEADER_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    h->magic = (uint32_t)binrec_load_le_(p, 4);
+    h->version = (uint16_t)binrec_load_le_(p + 4, 2);
+    h->flags = (uint16_t)binrec_load_le_(p + 6, 2);
+    h->schema_id = (uint32_t)binrec_load_le_(p + 8, 4);
+    h->record_size = (uint32_t)binrec_load_le_(p + 12, 4);
+    h->record_count = binrec_load_le_(p + 16, 8);
+    h->payload_bytes = binrec_load_le_(p + 24, 8);
+    if (h->magic != BINREC_MAGIC || h->version != BINREC_VERSION ||
+        h->payload_bytes > len - BINREC_HEADER_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+// Checks a table header against the schema. Returns the payload, or NULL with errno set.
+static inline const uint8_t* binrec_check_table_(const void* data, size_t len, const BinrecSchema* schema,
+                                                 BinrecHeader* h) {
+    if (binrec_read_header(data, len, h) != 0) return NULL;
+    if ((h->flags & BINREC_FLAG_VARINT) || h->schema_id != schema->id || h->record_size != schema->record_size ||
+        h->record_count > h->payload_bytes / schema->record_size ||
+        h->record_count * schema->record_size != h->payload_bytes) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return (const uint8_t*)data + BINREC_HEADER_SIZE;
+}
+
+// Validates a table and returns a pointer to its first record inside data, with
+// no copy. Fails with EINVAL for a malformed table or misaligned records, and
+// with ENOTSUP if the table was written in the other byte order.
+static inline const void* binrec_view_table(const void* data, size_t len, const BinrecSchema* schema,
+                                            size_t* count) {
+    BinrecHeader h;
+    const uint8_t* records = binrec_check_table_(data, len, schema, &h);
+    if (records == NULL) return NULL;
+    if ((uintptr_t)records % schema->align != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((h.flags & BINREC_FLAG_BIG_ENDIAN) != BINREC_HOST_FLAGS) {
+        errno = ENOTSUP;
+        return NULL;
+    }
+    *count = (size_t)h.record_count;
+    return records;
+}
+
+// Copies up to max_count records into out[], swapping byte order if needed.
+// Returns the number copied, or -1 with errno = EINVAL.
+static inline long binrec_copy_table(const void* data, size_t len, const BinrecSchema* schema, void* out,
+                                     size_t max_count) {
+    BinrecHeader h;
+    const uint8_t* records = binrec_check_table_(data, len, schema, &h);
+    if (records == NULL) return -1;
+    size_t count = h.record_count < max_count ? (size_t)h.record_count : max_count;
+    memcpy(out, records, count * schema->record_size);
+    if ((h.flags & BINREC_FLAG_BIG_ENDIAN) != BINREC_HOST_FLAGS) binrec_swap_records(out, count, schema);
+    return (long)count;
+}
+
+// --- Stream reader ---
+
+// Validates a varint stream header. Returns 0 and sets *count, or -1 with errno = EINVAL.
+static inline int binrec_reader_open(BinrecReader* r, const void* data, size_t len, uint32_t schema_id,
+                                     size_t* count) {
+    BinrecHeader h;
+    if (binrec_read_header(data, len, &h) != 0) return -1;
+    if (!(h.flags & BINREC_FLAG_VARINT) || h.schema_id != schema_id) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->p = (const uint8_t*)data + BINREC_HEADER_SIZE;
+    r->end = r->p + h.payload_bytes;
+    r->error = 0;
+    *count = (size_t)h.record_count;
+    return 0;
+}
+
+static inline int binrec_reader_ok(const BinrecReader* r) {
+    return !r->error;
+}
+
+static inline uint64_t binrec_get_fixed_(BinrecReader* r, int bytes) {
+    if (r->end - r->p < bytes) {
+        r->error = 1;
+        r->p = r->end;
+        return 0;
+    }
+    uint64_t v = binrec_load_le_(r->p, bytes);
+    r->p += bytes;
+    return v;
+}
+
+static inline uint8_t binrec_get_u8(BinrecReader* r) { return (uint8_t)binrec_get_fixed_(r, 1); }
+static inline uint16_t binrec_get_u16(BinrecReader* r) { return (uint16_t)binrec_get_fixed_(r, 2); }
+static inline uint32_t binrec_get_u32(BinrecReader* r) { return (uint32_t)binrec_get_fixed_(r, 4); }
+static inline uint64_t binrec_get_u64(BinrecReader* r) { return binrec_get_fixed_(r, 8); }
+
+static inline double binrec_get_f64(BinrecReader* r) {
+    uint64_t bits = binrec_get_fixed_(r, 8);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static inline uint64_t binrec_get_uvarint(BinrecReader* r) {
+    const uint8_t* p = r->p;
+    if (p < r->end && *p < 0x80) {  // One-byte values are the common case
+        r->p = p + 1;
+        return *p;
+    }
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && p < r->end; shift += 7) {
+        uint8_t byte = *p++;
+        if (shift == 63 && byte > 1) break;  // The 10th byte carries only bit 63
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            r->p = p;
+            return v;
+        }
+    }
+    r->error = 1;  // Truncated, longer than 10 bytes, or wider than 64 bits
+    r->p = r->end;
+    return 0;
+}
+
+static inline int64_t binrec_get_svarint(BinrecReader* r) {
+    uint64_t z = binrec_get_uvarint(r);
+    return (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+}
+
+// Returns a pointer to the bytes inside the input (no copy) and their length in *n.
+static inline const void* binrec_get_bytes(BinrecReader* r, size_t* n) {
+    uint64_t len = binrec_get_uvarint(r);
+    if (r->error || len > (uint64_t)(r->end - r->p)) {
+        r->error = 1;
+        r->p = r->end;
+        *n = 0;
+        return NULL;
+    }
+    const void* data = r->p;
+    r->p += len;
+    *n = (size_t)len;
+    return data;
+}
+
+#endif // BINREC_H
@@ -0,0 +1,230 @@
+/*
+file_view.h - Zero-Copy File Views Backed by mmap
+================================================
+
+A header-only reader that hands out (pointer, length) spans of a file instead of
+copying bytes into a caller buffer. Regular files are mapped with mmap() and the
+kernel is told how the mapping will be used with madvise(); every span points
+straight into the page cache. Pipes, sockets, terminals and anything else that
+cannot be mapped fall back to a buffered reader with the same interface.
+
+All state lives in the FileView handle, so any number of views can be open at once
+and each thread can use its own view.
+
+Usage:
+    FileView view;
+    if (file_view_open(&view, "input.dat", FILE_VIEW_SEQUENTIAL) != 0) {
+        perror("file_view_open");
+        return;
+    }
+    FileSpan span;
+    while (file_view_next(&view, 0, &span) > 0) {
+        consume(span.data, span.len);      // No copy; valid until the next call
+    }
+    file_view_close(&view);
+
+Error handling follows the POSIX convention: functions return -1 and leave the cause
+in errno (the view's 'error' field keeps it as well).
+
+Spans from a mapped view stay valid until file_view_close(). Spans from a buffered
+view are only valid until the next file_view_next() or file_view_read() call.
+A file that shrinks while it is mapped raises SIGBUS on access; views are meant for
+inputs that are not truncated concurrently.
+
+Tracing: with -DTRACE_ENABLE, the mmap() of a view and each read() of the buffered
+fallback are "io" zones; io.mapped_bytes, io.read_calls and io.read_bytes count them
+(Chapter18DebuggingAndProfiling/trace.h).
+*/
+
+#ifndef FILE_VIEW_H
+#define FILE_VIEW_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "../Chapter18DebuggingAndProfiling/trace.h"
+
+#define FILE_VIEW_BUFFER_SIZE (256 * 1024)   // Read size for the buffered fallback
+#define FILE_VIEW_MAX_SPAN (1024 * 1024)     // Default span length for a buffered view
+
+// Flags for file_view_open() and file_view_from_fd()
+#define FILE_VIEW_SEQUENTIAL 0x1    // madvise(MADV_SEQUENTIAL | MADV_WILLNEED)
+#define FILE_VIEW_RANDOM 0x2        // madvise(MADV_RANDOM)
+#define FILE_VIEW_BUFFERED 0x4      // Never map; always use the buffered reader
+
+typedef struct {
+    const char* data;
+    size_t len;
+} FileSpan;
+
+typedef struct {
+    int fd;
+    int owns_fd;
+    int mapped;                // 1: 'map' covers the file, 0: buffered fallback
+    int error;                 // errno of the last failure, 0 if none
+
+    // Mapped mode
+    const char* map;
+    size_t map_len;
+    size_t start;              // Descriptor position when the view was attached
+    size_t pos;
+
+    // Buffered mode
+    char* buffer;
+    size_t buffer_len;
+    size_t buffer_pos;
+    int eof;
+} FileView;
+
+static inline int file_view_fail_(FileView* view, int err) {
+    view->error = err;
+    errno = err;
+    return -1;
+}
+
+// Attach a view to an open descriptor. The descriptor is not closed by the view.
+static inline int file_view_from_fd(FileView* view, int fd, int flags) {
+    memset(view, 0, sizeof(*view));
+    view->fd = fd;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) return file_view_fail_(view, errno);
+
+    if (!(flags & FILE_VIEW_BUFFERED) && S_ISREG(st.st_mode)) {
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (offset < 0) offset = 0;
+        if (st.st_size <= offset) {
+            view->mapped = 1;  // Empty file (or positioned at EOF): nothing to map
+            return 0;
+        }
+        size_t len = (size_t)st.st_size;
+        TRACE_ZONE_BEGIN(zone, "io", "file_view mmap");
+        void* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        TRACE_ZONE_END(zone);
+        if (map != MAP_FAILED) {
+            TRACE_COUNTER_ADD("io.mapped_bytes", len);
+            if (flags & FILE_VIEW_SEQUENTIAL) {
+                madvise(map, len, MADV_SEQUENTIAL);
+                madvise(map, len, MADV_WILLNEED);
+            } else if (flags & FILE_VIEW_RANDOM) {
+                madvise(map, len, MADV_RANDOM);
+            }
+            view->mapped = 1;
+            view->map = (const char*)map;
+            view->map_len = len;
+            view->start = (size_t)offset;  // Honour the descriptor's current position
+            view->pos = view->start;
+            return 0;
+        }
+        // Some files (procfs, certain FUSE mounts) cannot be mapped: read them instead
+    }
+
+    view->buffer = (char*)malloc(FILE_VIEW_BUFFER_SIZE);
+    if (view->buffer == NULL) return file_view_fail_(view, ENOMEM);
+    return 0;
+}
+
+static inline int file_view_open(FileView* view, const char* path, int flags) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        memset(view, 0, sizeof(*view));
+        view->fd = -1;
+        return file_view_fail_(view, errno);
+    }
+    if (file_view_from_fd(view, fd, flags) != 0) {
+        int err = view->error;
+        free(view->buffer);
+        close(fd);
+        view->buffer = NULL;
+        view->fd = -1;
+        return file_view_fail_(view, err);
+    }
+    view->owns_fd = 1;
+    return 0;
+}
+
+static inline void file_view_close(FileView* view) {
+    if (view->map) munmap((void*)view->map, view->map_len);
+    free(view->buffer);
+    if (view->owns_fd && view->fd >= 0) close(view->fd);
+    memset(view, 0, sizeof(*view));
+    view->fd = -1;
+}
+
+// Refill the fallback buffer. Returns bytes available, 0 at EOF, -1 on error.
+static inline ssize_t file_view_fill_(FileView* view) {
+    if (view->buffer_pos < view->buffer_len) return (ssize_t)(view->buffer_len - view->buffer_pos);
+    if (view->eof) return 0;
+    ssize_t n;
+    TRACE_ZONE_BEGIN(zone, "io", "file_view read");
+    do {
+        n = read(view->fd, view->buffer, FILE_VIEW_BUFFER_SIZE);
+        TRACE_COUNTER_ADD("io.read_calls", 1);
+    } while (n < 0 && errno == EINTR);
+    TRACE_ZONE_END(zone);
+    if (n < 0) return file_view_fail_(view, errno);
+    TRACE_COUNTER_ADD("io.read_bytes", n);
+    if (n == 0) view->eof = 1;
+    view->buffer_len = (size_t)n;
+    view->buffer_pos = 0;
+    return n;
+}
+
+// Return the next span of at most 'max' bytes (0 means "as much as possible").
+// Returns 1 with a span, 0 at end of file, -1 on error.
+static inline int file_view_next(FileView* view, size_t max, FileSpan* out) {
+    out->data = NULL;
+    out->len = 0;
+    if (view->mapped) {
+        size_t left = view->map_len - view->pos;
+        if (left == 0) return 0;
+        size_t len = (max && max < left) ? max : left;
+        out->data = view->map + view->pos;
+        out->len = len;
+        view->pos += len;
+        return 1;
+    }
+
+    ssize_t avail = file_view_fill_(view);
+    if (avail <= 0) return (int)avail;
+    size_t limit = max ? max : FILE_VIEW_MAX_SPAN;
+    size_t len = (size_t)avail < limit ? (size_t)avail : limit;
+    out->data = view->buffer + view->buffer_pos;
+    out->len = len;
+    view->buffer_pos += len;
+    return 1;
+}
+
+// Everything from the view's starting position to the end of the file, for mapped
+// views; NULL for buffered views.
+static inline const char* file_view_data(const FileView* view, size_t* len) {
+    if (!view->mapped) return NULL;
+    if (view->map == NULL) {
+        *len = 0;
+        return "";
+    }
+    *len = view->map_len - view->start;
+    return view->map + view->start;
+}
+
+// Copying read with read(2) semantics, for callers that need their own buffer.
+static inline ssize_t file_view_read(FileView* view, void* buf, size_t count) {
+    size_t total = 0;
+    FileSpan span;
+    while (total < count) {
+        int rc = file_view_next(view, count - total, &span);
+        if (rc < 0) return total > 0 ? (ssize_t)total : -1;
+        if (rc == 0) break;
+        memcpy((char*)buf + total, span.data, span.len);
+        total += span.len;
+    }
+    return (ssize_t)total;
+}
+
+#endif // FILE_VIEW_H
@@ -0,0 +1,394 @@
+/*
+log_writer.h - Batched Append-Only Log Writer with Group Commit
+================================================
+
+A header-only, thread-safe writer for append-only files such as write-ahead logs,
+journals and audit trails. Small records are gathered into batches that are written
+with one writev() call, and concurrent writers that all need their records on disk
+share a single fdatasync() ("group commit").
+
+How group commit works:
+    Appenders add their record to the open batch and wait. The first waiter becomes
+    the leader: it takes the whole batch, writes it and syncs it without holding the
+    lock. Records that arrive meanwhile go into the next batch, and when the leader
+    finishes, one of their waiters leads the next commit. One sync therefore
+    covers every record that arrived during the previous sync, so the number of syncs
+    per second stays bounded while throughput grows with the number of writers.
+
+Flush policies (LogWriterConfig.policy):
+    LOG_FLUSH_PER_RECORD   log_writer_append() returns once the record is durable.
+    LOG_FLUSH_BYTES        The batch is committed when it reaches flush_bytes.
+    LOG_FLUSH_INTERVAL     A background thread commits every flush_interval_ms.
+    With 'sync' = 0 commits only write() the data, without fdatasync().
+    log_writer_flush() commits everything appended so far under any policy.
+
+Records up to LOG_WRITER_COPY_MAX bytes are copied into the batch buffer, so adjacent
+small records become a single iovec. Under LOG_FLUSH_PER_RECORD larger records are not
+copied: the caller waits until they are written anyway, so writev() reads them straight
+from the caller's memory.
+
+Errors follow the POSIX convention: -1 with errno set. A failed write or sync is
+sticky: the writer reports the same errno from every later call, because the file
+contents after the failure are unknown.
+
+Tracing: with -DTRACE_ENABLE, each commit's writev() and fdatasync() are "io" zones,
+and io.write_bytes, io.writev_calls and io.syncs (successful syncs only) count them
+(Chapter18DebuggingAndProfiling/trace.h).
+
+Compile with -pthread.
+*/
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include "../Chapter18DebuggingAndProfiling/trace.h"
+
+#define LOG_WRITER_COPY_MAX 512
+#define LOG_WRITER_INITIAL_BUFFER (64 * 1024)
+#ifdef IOV_MAX
+#define LOG_WRITER_IOV_MAX IOV_MAX
+#else
+#define LOG_WRITER_IOV_MAX 1024
+#endif
+
+typedef enum {
+    LOG_FLUSH_PER_RECORD,
+    LOG_FLUSH_BYTES,
+    LOG_FLUSH_INTERVAL
+} LogFlushPolicy;
+
+typedef struct {
+    LogFlushPolicy policy;
+    size_t flush_bytes;            // LOG_FLUSH_BYTES threshold
+    unsigned flush_interval_ms;    // LOG_FLUSH_INTERVAL period
+    int sync;                      // 1: fdatasync() every commit
+} LogWriterConfig;
+
+typedef struct {
+    const char* ptr;               // Caller's memory, or NULL for an offset into 'data'
+    size_t offset;
+    size_t len;
+} LogSegment;
+
+typedef struct {
+    LogSegment* segments;
+    int segment_count;
+    int segment_capacity;
+    char* data;
+    size_t data_len;
+    size_t data_capacity;
+    uint64_t records;
+} LogBatch;
+
+typedef struct {
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t commits;              // Batches written (one writev() sequence each)
+    uint64_t syncs;                // fdatasync() calls
+    uint64_t max_batch_records;
+} LogWriterStats;
+
+typedef struct {
+    int fd;
+    LogWriterConfig config;
+    pthread_mutex_t lock;
+    pthread_cond_t committed;      // Signalled after every commit
+    pthread_cond_t wake_flusher;
+    LogBatch batches[2];
+    LogBatch* open;                // Batch receiving new records
+    int committing;                // A leader is writing the other batch
+    int error;                     // Sticky errno of a failed write or sync
+    uint64_t appended_lsn;         // Bytes appended (log sequence number)
+    uint64_t durable_lsn;          // Bytes committed
+    struct iovec* iov;             // Leader's scratch array
+    int iov_capacity;
+    pthread_t flusher;
+    int flusher_running;
+    int closing;
+    LogWriterStats stats;
+} LogWriter;
+
+static inline LogWriterConfig log_writer_default_config(void) {
+    LogWriterConfig config;
+    config.policy = LOG_FLUSH_PER_RECORD;
+    config.flush_bytes = 64 * 1024;
+    config.flush_interval_ms = 10;
+    config.sync = 1;
+    return config;
+}
+
+static inline void log_batch_free_(LogBatch* b) {
+    free(b->segments);
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+static inline void log_batch_clear_(LogBatch* b) {
+    b->segment_count = 0;
+    b->data_len = 0;
+    b->records = 0;
+}
+
+static inline int log_batch_reserve_(LogBatch* b, size_t extra_data) {
+    if (b->segment_count == b->segment_capacity) {
+        int cap = b->segment_capacity ? b->segment_capacity * 2 : 64;
+        LogSegment* s = (LogSegment*)realloc(b->segments, (size_t)cap * sizeof(LogSegment));
+        if (s == NULL) return -1;
+        b->segments = s;
+        b->segment_capacity = cap;
+    }
+    if (b->data_len + extra_data > b->data_capacity) {
+        size_t cap = b->data_capacity ? b->data_capacity : LOG_WRITER_INITIAL_BUFFER;
+        while (cap < b->data_len + extra_data) cap *= 2;
+        char* d = (char*)realloc(b->data, cap);
+        if (d == NULL) return -1;
+        b->data = d;
+        b->data_capacity = cap;
+    }
+    return 0;
+}
+
+// Add a record to the batch; copied records that follow each other share one segment.
+static inline int log_batch_add_(LogBatch* b, const void* data, size_t len, int copy) {
+    if (log_batch_reserve_(b, copy ? len : 0) != 0) return -1;
+    if (copy) {
+        LogSegment* last = b->segment_count ? &b->segments[b->segment_count - 1] : NULL;
+        if (last && last->ptr == NULL && last->offset + last->len == b->data_len) {
+            last->len += len;
+        } else {
+            LogSegment* s = &b->segments[b->segment_count++];
+            s->ptr = NULL;
+            s->offset = b->data_len;
+            s->len = len;
+        }
+        memcpy(b->data + b->data_len, data, len);
+        b->data_len += len;
+    } else {
+        LogSegment* s = &b->segments[b->segment_count++];
+        s->ptr = (const char*)data;
+        s->offset = 0;
+        s->len = len;
+    }
+    b->records++;
+    return 0;
+}
+
+// writev() the whole batch in chunks of at most IOV_MAX entries, retrying short writes.
+static inline int log_writer_write_batch_(LogWriter* w, LogBatch* b) {
+    int i = 0;
+    while (i < b->segment_count) {
+        int n = b->segment_count - i;
+        if (n > LOG_WRITER_IOV_MAX) n = LOG_WRITER_IOV_MAX;
+        for (int k = 0; k < n; k++) {
+            const LogSegment* s = &b->segments[i + k];
+            w->iov[k].iov_base = (void*)(s->ptr ? s->ptr : b->data + s->offset);
+            w->iov[k].iov_len = s->len;
+        }
+        struct iovec* iov = w->iov;
+        int left = n;
+        while (left > 0) {
+            ssize_t written = writev(w->fd, iov, left);
+            TRACE_COUNTER_ADD("io.writev_calls", 1);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            TRACE_COUNTER_ADD("io.write_bytes", written);
+            while (left > 0 && (size_t)written >= iov->iov_len) {
+                written -= (ssize_t)iov->iov_len;
+                iov++;
+                left--;
+            }
+            if (left > 0) {
+                iov->iov_base = (char*)iov->iov_base + written;
+                iov->iov_len -= (size_t)written;
+            }
+        }
+        i += n;
+    }
+    return 0;
+}
+
+// Commit everything up to 'target' LSN. Called and returns with the lock held.
+static inline int log_writer_commit_locked_(LogWriter* w, uint64_t target) {
+    while (w->durable_lsn < target && !w->error) {
+        if (w->committing) {
+            pthread_cond_wait(&w->committed, &w->lock);
+            continue;
+        }
+
+        // Become the leader: take the open batch and let others fill the other one
+        LogBatch* batch = w->open;
+        w->open = (batch == &w->batches[0]) ? &w->batches[1] : &w->batches[0];
+        uint64_t batch_end = w->appended_lsn;
+        w->committing = 1;
+        pthread_mutex_unlock(&w->lock);
+
+        TRACE_ZONE_BEGIN(write_zone, "io", "log writev");
+        int rc = log_writer_write_batch_(w, batch);
+        TRACE_ZONE_END(write_zone);
+        int synced = 0;
+        if (rc == 0 && w->config.sync) {
+            TRACE_ZONE_BEGIN(sync_zone, "io", "log fdatasync");
+            rc = fdatasync(w->fd);
+            TRACE_ZONE_END(sync_zone);
+            if (rc == 0) TRACE_COUNTER_ADD("io.syncs", 1);
+            synced = 1;
+        }
+        int err = rc ? errno : 0;
+
+        pthread_mutex_lock(&w->lock);
+        w->stats.commits++;
+        if (synced) w->stats.syncs++;
+        if (batch->records > w->stats.max_batch_records) w->stats.max_batch_records = batch->records;
+        log_batch_clear_(batch);
+        if (err) w->error = err;
+        else w->durable_lsn = batch_end;
+        w->committing = 0;
+        pthread_cond_broadcast(&w->committed);
+    }
+    if (w->error) {
+        errno = w->error;
+        return -1;
+    }
+    return 0;
+}
+
+static inline void* log_writer_flusher_(void* arg) {
+    LogWriter* w = (LogWriter*)arg;
+    pthread_mutex_lock(&w->lock);
+    while (!w->closing) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)w->config.flush_interval_ms * 1000000ull;
+        deadline.tv_sec += (time_t)(ns / 1000000000ull);
+        deadline.tv_nsec = (long)(ns % 1000000000ull);
+        pthread_cond_timedwait(&w->wake_flusher, &w->lock, &deadline);
+        if (w->appended_lsn > w->durable_lsn && !w->error) {
+            log_writer_commit_locked_(w, w->appended_lsn);
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+static inline int log_writer_open(LogWriter* w, const char* path, const LogWriterConfig* config) {
+    memset(w, 0, sizeof(*w));
+    w->config = config ? *config : log_writer_default_config();
+    if (w->config.policy == LOG_FLUSH_INTERVAL && w->config.flush_interval_ms == 0) {
+        w->config.flush_interval_ms = 1;
+    }
+    w->iov_capacity = LOG_WRITER_IOV_MAX;
+    w->iov = (struct iovec*)malloc((size_t)w->iov_capacity * sizeof(struct iovec));
+    if (w->iov == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    w->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (w->fd < 0) {
+        int err = errno;
+        free(w->iov);
+        errno = err;
+        return -1;
+    }
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->committed, NULL);
+    pthread_cond_init(&w->wake_flusher, NULL);
+    w->open = &w->batches[0];
+
+    if (w->config.policy == LOG_FLUSH_INTERVAL) {
+        if (pthread_create(&w->flusher, NULL, log_writer_flusher_, w) != 0) {
+            close(w->fd);
+            free(w->iov);
+            errno = EAGAIN;
+            return -1;
+        }
+        w->flusher_running = 1;
+    }
+    return 0;
+}
+
+static inline int log_writer_append(LogWriter* w, const void* data, size_t len) {
+    pthread_mutex_lock(&w->lock);
+    if (w->error) {
+        int err = w->error;
+        pthread_mutex_unlock(&w->lock);
+        errno = err;
+        return -1;
+    }
+
+    int per_record = w->config.policy == LOG_FLUSH_PER_RECORD;
+    int copy = !per_record || len <= LOG_WRITER_COPY_MAX;
+    if (log_batch_add_(w->open, data, len, copy) != 0) {
+        pthread_mutex_unlock(&w->lock);
+        errno = ENOMEM;
+        return -1;
+    }
+    w->appended_lsn += len;
+    w->stats.records++;
+    w->stats.bytes += len;
+
+    int rc = 0;
+    if (per_record) {
+        rc = log_writer_commit_locked_(w, w->appended_lsn);
+    } else if (w->config.policy == LOG_FLUSH_BYTES &&
+               w->appended_lsn - w->durable_lsn >= w->config.flush_bytes && !w->committing) {
+        rc = log_writer_commit_locked_(w, w->appended_lsn);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return rc;
+}
+
+// Commit every record appended so far, regardless of the policy.
+static inline int log_writer_flush(LogWriter* w) {
+    pthread_mutex_lock(&w->lock);
+    int rc = log_writer_commit_locked_(w, w->appended_lsn);
+    pthread_mutex_unlock(&w->lock);
+    return rc;
+}
+
+static inline LogWriterStats log_writer_stats(LogWriter* w) {
+    pthread_mutex_lock(&w->lock);
+    LogWriterStats stats = w->stats;
+    pthread_mutex_unlock(&w->lock);
+    return stats;
+}
+
+// Flush, stop the background flusher and close the file. Returns -1 if any data was lost.
+static inline int log_writer_close(LogWriter* w) {
+    int rc = log_writer_flush(w);
+    int err = rc ? errno : 0;
+    if (w->flusher_running) {
+        pthread_mutex_lock(&w->lock);
+        w->closing = 1;
+        pthread_cond_signal(&w->wake_flusher);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->flusher, NULL);
+    }
+    if (close(w->fd) != 0 && rc == 0) {
+        rc = -1;
+        err = errno;
+    }
+    log_batch_free_(&w->batches[0]);
+    log_batch_free_(&w->batches[1]);
+    free(w->iov);
+    pthread_cond_destroy(&w->wake_flusher);
+    pthread_cond_destroy(&w->committed);
+    pthread_mutex_destroy(&w->lock);
+    w->fd = -1;
+    if (rc) errno = err;
+    return rc;
+}
+
+#endif // LOG_WRITER_H
@@ -0,0 +1,405 @@
+/*
+range_lock.h - Byte-Range File Lock Manager with Contention Statistics
+================================================
+
+A header-only lock manager for one file that hands out shared (read) and exclusive
+(write) locks on byte ranges, so workers appending to and reading from disjoint regions
+of the same file never wait for each other.
+
+Two layers:
+- An in-process range table, protected by a mutex, arbitrates between threads.
+  fcntl() locks cannot: POSIX record locks belong to the process, and open-file-
+  description (OFD) locks taken through one shared descriptor merge with each other.
+  A thread that meets a conflicting range spins a bounded number of times (the other
+  holder is usually about to release) and then sleeps on a condition variable.
+- With RANGE_LOCK_CROSS_PROCESS the manager also takes the matching kernel lock so
+  other processes are excluded. OFD locks (F_OFD_SETLK, Linux 3.15+, needs _GNU_SOURCE)
+  are used when available, otherwise classic F_SETLK locks. The kernel is tried with
+  F_*SETLK for a bounded number of attempts before blocking in F_*SETLKW.
+  A shared lock whose range is already read-locked by another thread of this process
+  needs no system call at all, and releases only unlock the bytes no other holder
+  still covers, because kernel locks from one process or description are merged.
+
+System calls per acquire/release pair:
+- Without RANGE_LOCK_CROSS_PROCESS: none. Threads of one process are arbitrated by
+  the range table alone; this is the mode with no syscall on the fast path.
+- With RANGE_LOCK_CROSS_PROCESS: one fcntl() to lock and one to unlock, the same as
+  calling fcntl() directly. Only a shared lock on bytes that other threads of this
+  process already hold read-locked, and the release of bytes another holder still
+  covers, skip the kernel. A kernel lock cannot be kept after release to save the
+  next call: other processes would wait on it until this one happened to lock again.
+  What the manager adds here is that threads exclude each other at all, which
+  fcntl() locks alone cannot do.
+
+Usage:
+    RangeLockManager m;
+    range_lock_manager_init(&m, fd, RANGE_LOCK_CROSS_PROCESS);
+    RangeLock* l = range_lock_acquire(&m, offset, 4096, RANGE_LOCK_EXCLUSIVE);
+    pwrite(fd, block, 4096, offset);
+    range_lock_release(&m, l);
+    range_lock_print_stats(&m, stdout);
+    range_lock_manager_destroy(&m);
+
+A length of 0 means "to the end of the file and beyond", as with struct flock.
+Errors return NULL or -1 with errno set; range_lock_try() fails with EAGAIN when the
+range is busy.
+
+Compile with -pthread.
+*/
+
+#ifndef RANGE_LOCK_H
+#define RANGE_LOCK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#define RANGE_LOCK_SPIN_LIMIT 64
+#define RANGE_LOCK_HISTOGRAM_BUCKETS 40   // Bucket k counts waits in [2^k, 2^(k+1)) ns
+
+// Flags for range_lock_manager_init()
+#define RANGE_LOCK_CROSS_PROCESS 0x1      // Also take kernel (fcntl) locks
+
+typedef enum {
+    RANGE_LOCK_SHARED,
+    RANGE_LOCK_EXCLUSIVE
+} RangeLockMode;
+
+typedef struct RangeLock {
+    uint64_t start;
+    uint64_t end;              // Exclusive; UINT64_MAX for "to end of file"
+    RangeLockMode mode;
+    int granted;               // 0 while the kernel lock is still being acquired
+    struct RangeLock* next;
+} RangeLock;
+
+typedef struct {
+    uint64_t acquired;
+    uint64_t contended;            // Had to wait for another thread
+    uint64_t spin_wins;            // Contended, but granted while spinning
+    uint64_t blocked;              // Slept on the condition variable
+    uint64_t kernel_calls;         // fcntl() lock and unlock calls
+    uint64_t kernel_skipped;       // Shared acquisitions already covered in the kernel
+    uint64_t kernel_contended;     // fcntl() refused: another process holds the range
+    uint64_t wait_histogram[RANGE_LOCK_HISTOGRAM_BUCKETS];
+    uint64_t total_wait_ns;
+} RangeLockStats;
+
+typedef struct {
+    int fd;
+    int cross_process;
+    int setlk;                 // F_OFD_SETLK or F_SETLK
+    int setlkw;
+    unsigned spin_limit;
+    pthread_mutex_t lock;
+    pthread_cond_t released;
+    RangeLock* held;           // Granted and pending locks
+    RangeLock* free_list;
+    RangeLockStats stats;
+} RangeLockManager;
+
+static inline uint64_t range_lock_now_ns_(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline int range_lock_manager_init(RangeLockManager* m, int fd, int flags) {
+    memset(m, 0, sizeof(*m));
+    m->fd = fd;
+    m->cross_process = (flags & RANGE_LOCK_CROSS_PROCESS) != 0;
+    m->spin_limit = RANGE_LOCK_SPIN_LIMIT;
+#ifdef F_OFD_SETLK
+    m->setlk = F_OFD_SETLK;
+    m->setlkw = F_OFD_SETLKW;
+#else
+    m->setlk = F_SETLK;
+    m->setlkw = F_SETLKW;
+#endif
+    if (pthread_mutex_init(&m->lock, NULL) != 0) return -1;
+    if (pthread_cond_init(&m->released, NULL) != 0) {
+        pthread_mutex_destroy(&m->lock);
+        return -1;
+    }
+    return 0;
+}
+
+// All locks must have been released.
+static inline void range_lock_manager_destroy(RangeLockManager* m) {
+    RangeLock* l = m->free_list;
+    while (l) {
+        RangeLock* next = l->next;
+        free(l);
+        l = next;
+    }
+    l = m->held;
+    while (l) {
+        RangeLock* next = l->next;
+        free(l);
+        l = next;
+    }
+    pthread_cond_destroy(&m->released);
+    pthread_mutex_destroy(&m->lock);
+    m->held = m->free_list = NULL;
+}
+
+static inline int range_lock_conflicts_(const RangeLockManager* m, uint64_t start, uint64_t end,
+                                        RangeLockMode mode) {
+    for (const RangeLock* l = m->held; l; l = l->next) {
+        if (l->start < end && start < l->end &&
+            (mode == RANGE_LOCK_EXCLUSIVE || l->mode == RANGE_LOCK_EXCLUSIVE)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Is [start, end) completely covered by granted locks other than 'self'?
+// Walks the holders repeatedly, advancing 'start' past each one that overlaps it.
+static inline int range_lock_covered_(const RangeLockManager* m, const RangeLock* self,
+                                      uint64_t start, uint64_t end, int granted_only) {
+    int progress = 1;
+    while (start < end && progress) {
+        progress = 0;
+        for (const RangeLock* l = m->held; l; l = l->next) {
+            if (l == self || (granted_only && !l->granted)) continue;
+            if (l->start <= start && start < l->end) {
+                start = l->end;
+                progress = 1;
+            }
+        }
+    }
+    return start >= end;
+}
+
+static inline int range_lock_fcntl_(RangeLockManager* m, int cmd, short type, uint64_t start, uint64_t end) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = (off_t)start;
+    fl.l_len = end == UINT64_MAX ? 0 : (off_t)(end - start);
+    fl.l_pid = 0;  // Required for OFD locks
+    int rc;
+    do {
+        rc = fcntl(m->fd, cmd, &fl);
+    } while (rc == -1 && errno == EINTR);
+    return rc;
+}
+
+// Unlock the parts of [start, end) that no other in-process holder still needs.
+// Pending holders count too: their fcntl() may have succeeded already, and the
+// kernel merges it with ours. A pending holder that fails unlocks the leftovers.
+// Called with the manager lock held; F_UNLCK never blocks.
+static inline void range_lock_kernel_release_(RangeLockManager* m, const RangeLock* self,
+                                              uint64_t start, uint64_t end) {
+    while (start < end) {
+        // Skip bytes covered by another holder
+        int moved = 1;
+        while (moved && start < end) {
+            moved = 0;
+            for (const RangeLock* l = m->held; l; l = l->next) {
+                if (l != self && l->start <= start && start < l->end) {
+                    start = l->end;
+                    moved = 1;
+                }
+            }
+        }
+        if (start >= end) break;
+        // Find where the next holder begins
+        uint64_t stop = end;
+        for (const RangeLock* l = m->held; l; l = l->next) {
+            if (l != self && l->start > start && l->start < stop) stop = l->start;
+        }
+        range_lock_fcntl_(m, m->setlk, F_UNLCK, start, stop);
+        m->stats.kernel_calls++;
+        start = stop;
+    }
+}
+
+static inline void range_lock_record_wait_(RangeLockManager* m, uint64_t ns) {
+    int bucket = 0;
+    while (bucket < RANGE_LOCK_HISTOGRAM_BUCKETS - 1 && (ns >> (bucket + 1)) != 0) bucket++;
+    m->stats.wait_histogram[bucket]++;
+    m->stats.total_wait_ns += ns;
+}
+
+static inline RangeLock* range_lock_new_(RangeLockManager* m) {
+    RangeLock* l = m->free_list;
+    if (l) {
+        m->free_list = l->next;
+        return l;
+    }
+    return (RangeLock*)malloc(sizeof(RangeLock));
+}
+
+static inline void range_lock_unlink_(RangeLockManager* m, RangeLock* target) {
+    for (RangeLock** p = &m->held; *p; p = &(*p)->next) {
+        if (*p == target) {
+            *p = target->next;
+            break;
+        }
+    }
+    target->next = m->free_list;
+    m->free_list = target;
+}
+
+static inline RangeLock* range_lock_acquire_(RangeLockManager* m, off_t offset, off_t len,
+                                             RangeLockMode mode, int wait) {
+    if (offset < 0 || len < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    uint64_t start = (uint64_t)offset;
+    uint64_t end = len == 0 ? UINT64_MAX : start + (uint64_t)len;
+    uint64_t t0 = 0;
+
+    pthread_mutex_lock(&m->lock);
+    if (range_lock_conflicts_(m, start, end, mode)) {
+        if (!wait) {
+            pthread_mutex_unlock(&m->lock);
+            errno = EAGAIN;
+            return NULL;
+        }
+        m->stats.contended++;
+        t0 = range_lock_now_ns_();
+
+        // Bounded spinning: holders of short critical sections usually release soon
+        unsigned spins = 0;
+        while (spins < m->spin_limit && range_lock_conflicts_(m, start, end, mode)) {
+            pthread_mutex_unlock(&m->lock);
+            sched_yield();
+            spins++;
+            pthread_mutex_lock(&m->lock);
+        }
+        if (spins < m->spin_limit) {
+            m->stats.spin_wins++;
+        } else {
+            m->stats.blocked++;
+            while (range_lock_conflicts_(m, start, end, mode)) {
+                pthread_cond_wait(&m->released, &m->lock);
+            }
+        }
+    }
+
+    RangeLock* l = range_lock_new_(m);
+    if (l == NULL) {
+        pthread_mutex_unlock(&m->lock);
+        errno = ENOMEM;
+        return NULL;
+    }
+    l->start = start;
+    l->end = end;
+    l->mode = mode;
+    l->granted = 0;
+    l->next = m->held;
+    m->held = l;  // Reserved: other threads now see the range as taken
+
+    int need_kernel = m->cross_process;
+    if (need_kernel && mode == RANGE_LOCK_SHARED && range_lock_covered_(m, l, start, end, 1)) {
+        need_kernel = 0;  // Another thread already holds a kernel read lock on every byte
+        m->stats.kernel_skipped++;
+    }
+    pthread_mutex_unlock(&m->lock);
+
+    int rc = 0;
+    int kernel_calls = 0, kernel_contended = 0;
+    if (need_kernel) {
+        short type = mode == RANGE_LOCK_EXCLUSIVE ? F_WRLCK : F_RDLCK;
+        unsigned tries = 0;
+        for (;;) {
+            kernel_calls++;
+            rc = range_lock_fcntl_(m, m->setlk, type, start, end);
+            if (rc == 0 || (errno != EAGAIN && errno != EACCES)) break;
+            kernel_contended++;
+            if (!wait) break;
+            if (++tries >= m->spin_limit) {
+                if (t0 == 0) t0 = range_lock_now_ns_();
+                kernel_calls++;
+                rc = range_lock_fcntl_(m, m->setlkw, type, start, end);
+                break;
+            }
+            if (t0 == 0) t0 = range_lock_now_ns_();
+            sched_yield();
+        }
+    }
+    int err = errno;
+
+    pthread_mutex_lock(&m->lock);
+    m->stats.kernel_calls += (uint64_t)kernel_calls;
+    m->stats.kernel_contended += (uint64_t)kernel_contended;
+    if (rc != 0) {
+        // A release that overlapped this pending lock left its bytes locked in the
+        // kernel for us to take over (it cannot unlock them: our fcntl() may already
+        // have succeeded). We failed, so unlock what no other holder still covers.
+        if (need_kernel) range_lock_kernel_release_(m, l, start, end);
+        range_lock_unlink_(m, l);
+        pthread_cond_broadcast(&m->released);
+        pthread_mutex_unlock(&m->lock);
+        errno = err;
+        return NULL;
+    }
+    l->granted = 1;
+    m->stats.acquired++;
+    if (t0) range_lock_record_wait_(m, range_lock_now_ns_() - t0);
+    pthread_mutex_unlock(&m->lock);
+    return l;
+}
+
+static inline RangeLock* range_lock_acquire(RangeLockManager* m, off_t offset, off_t len, RangeLockMode mode) {
+    return range_lock_acquire_(m, offset, len, mode, 1);
+}
+
+static inline RangeLock* range_lock_try(RangeLockManager* m, off_t offset, off_t len, RangeLockMode mode) {
+    return range_lock_acquire_(m, offset, len, mode, 0);
+}
+
+static inline int range_lock_release(RangeLockManager* m, RangeLock* l) {
+    if (l == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock(&m->lock);
+    if (m->cross_process) range_lock_kernel_release_(m, l, l->start, l->end);
+    range_lock_unlink_(m, l);
+    pthread_cond_broadcast(&m->released);
+    pthread_mutex_unlock(&m->lock);
+    return 0;
+}
+
+static inline RangeLockStats range_lock_stats(RangeLockManager* m) {
+    pthread_mutex_lock(&m->lock);
+    RangeLockStats stats = m->stats;
+    pthread_mutex_unlock(&m->lock);
+    return stats;
+}
+
+static inline void range_lock_print_stats(RangeLockManager* m, FILE* out) {
+    RangeLockStats s = range_lock_stats(m);
+    fprintf(out, "Range locks: %llu acquired, %llu contended (%llu won by spinning, %llu blocked)\n",
+            (unsigned long long)s.acquired, (unsigned long long)s.contended,
+            (unsigned long long)s.spin_wins, (unsigned long long)s.blocked);
+    fprintf(out, "Kernel: %llu fcntl calls, %llu skipped, %llu refused by other processes\n",
+            (unsigned long long)s.kernel_calls, (unsigned long long)s.kernel_skipped,
+            (unsigned long long)s.kernel_contended);
+    uint64_t waits = 0;
+    for (int b = 0; b < RANGE_LOCK_HISTOGRAM_BUCKETS; b++) waits += s.wait_histogram[b];
+    if (waits == 0) return;
+    fprintf(out, "Wait times (%llu waits, mean %.1f us):\n", (unsigned long long)waits,
+            (double)s.total_wait_ns / (double)waits / 1000.0);
+    for (int b = 0; b < RANGE_LOCK_HISTOGRAM_BUCKETS; b++) {
+        if (s.wait_histogram[b] == 0) continue;
+        fprintf(out, "  %10.1f us - %-10.1f us %llu\n", (double)(1ull << b) / 1000.0,
+                (double)(1ull << (b + 1)) / 1000.0, (unsigned long long)s.wait_histogram[b]);
+    }
+}
+
+#endif // RANGE_LOCK_H